@@ -50,6 +50,11 @@ globus_module_descriptor_t       globus_i_callback_module;
  *
  * Note:  You would not normally activate this module directly.  Activating
  * the GLOBUS_COMMON_MODULE will in turn activate this also.
+ *
+ * If the GLOBUS_CALLBACK_TIMER_COALESCE environment variable is set to a
+ * number of milliseconds, the start times of timed and periodic callbacks
+ * are rounded up to a multiple of it, so that callbacks due close together
+ * run after a single wakeup.
  */
 #define GLOBUS_CALLBACK_MODULE (&globus_i_callback_module)
 
@@ -20,8 +20,8 @@
 #include "globus_module.h"
 #include "globus_callback.h"
 #include "globus_i_callback.h"
-#include "globus_priority_q.h"
 #include "globus_handle_table.h"
+#include "globus_memory.h"
 #include "globus_thread_common.h"
 #include "globus_libc.h"
 #include "globus_list.h"
@@ -87,6 +87,7 @@ typedef struct globus_l_callback_info_s
     void *                              unreg_args;
 
     struct globus_l_callback_space_s *  my_space;
+    globus_i_callback_timer_t           timer;
     
     /* used by ready queue macros */
     struct globus_l_callback_info_s *   next;
@@ -101,7 +102,7 @@ typedef struct
 typedef struct globus_l_callback_space_s
 {
     globus_callback_space_t             handle;
-    globus_priority_q_t                 timed_queue;
+    globus_i_callback_wheel_t           timed_queue;
     globus_l_callback_ready_queue_t     ready_queue;
     int                                 depth;
 } globus_l_callback_space_t;
@@ -167,36 +168,28 @@ globus_l_callback_requeue(
 {
     globus_bool_t                       ready;
     globus_l_callback_space_t *         i_space;
-    const globus_abstime_t *            tmp_time;
     globus_abstime_t                    l_time_now;
     
     ready = GLOBUS_TRUE;
     i_space = callback_info->my_space;
     
     /* first check to see if anything in the timed queue is ready */
-    tmp_time = (globus_abstime_t *)
-        globus_priority_q_first_priority(&i_space->timed_queue);
-    if(tmp_time)
+    if(!globus_i_callback_wheel_empty(&i_space->timed_queue))
     {
+        globus_l_callback_info_t *          ready_info;
+        
         if(!time_now)
         {
             GlobusTimeAbstimeGetCurrent(l_time_now);
             time_now = &l_time_now;
         }
         
-        while(tmp_time && globus_abstime_cmp(tmp_time, time_now) <= 0)
+        while((ready_info = (globus_l_callback_info_t *)
+            globus_i_callback_wheel_expire(&i_space->timed_queue, time_now)))
         {
-            globus_l_callback_info_t *          ready_info;
-            
-            ready_info = (globus_l_callback_info_t *)
-                globus_priority_q_dequeue(&i_space->timed_queue);
-            
             ready_info->in_queue = GLOBUS_L_CALLBACK_QUEUE_READY;
             
             GlobusICallbackReadyEnqueue(&i_space->ready_queue, ready_info);
-                    
-            tmp_time = (globus_abstime_t *)
-                globus_priority_q_first_priority(&i_space->timed_queue);
         }
     }
     
@@ -216,8 +209,9 @@ globus_l_callback_requeue(
             ready = GLOBUS_FALSE;
             callback_info->in_queue = GLOBUS_L_CALLBACK_QUEUE_TIMED;
             
-            globus_priority_q_enqueue(
+            globus_i_callback_wheel_enqueue(
                 &i_space->timed_queue,
+                &callback_info->timer,
                 callback_info,
                 &callback_info->start_time);
         }
@@ -310,7 +304,7 @@ globus_l_callback_space_destructor(
     
     space = (globus_l_callback_space_t *) datum;
     
-    globus_priority_q_destroy(&space->timed_queue);
+    globus_i_callback_wheel_destroy(&space->timed_queue);
     
     globus_memory_push_node(
         &globus_l_callback_space_memory, space);
@@ -339,9 +333,8 @@ globus_l_callback_activate()
     /* init global 'space' */
     globus_l_callback_global_space.handle = GLOBUS_CALLBACK_GLOBAL_SPACE;
     GlobusICallbackReadyInit(&globus_l_callback_global_space.ready_queue);
-    globus_priority_q_init(
-        &globus_l_callback_global_space.timed_queue,
-        (globus_priority_q_cmp_func_t) globus_abstime_cmp);
+    globus_i_callback_wheel_init(
+        &globus_l_callback_global_space.timed_queue);
     globus_l_callback_global_space.depth = 0;
     
     globus_memory_init(
@@ -375,7 +368,7 @@ globus_l_callback_deactivate()
 {
     int                                 i;
     
-    globus_priority_q_destroy(&globus_l_callback_global_space.timed_queue);
+    globus_i_callback_wheel_destroy(&globus_l_callback_global_space.timed_queue);
     
     /* any handles left here will be destroyed by destructor.
      * important that globus_l_callback_handle_table be destroyed
@@ -534,8 +527,9 @@ globus_l_callback_register(
             GlobusTimeAbstimeCopy(callback_info->start_time, *start_time);
             callback_info->in_queue = GLOBUS_L_CALLBACK_QUEUE_TIMED;
             
-            globus_priority_q_enqueue(
+            globus_i_callback_wheel_enqueue(
                 &callback_info->my_space->timed_queue,
+                &callback_info->timer,
                 callback_info,
                 &callback_info->start_time);
         }
@@ -749,8 +743,8 @@ globus_callback_unregister_nothreads(
             /* would only be in queue if it was restarted */
             if(callback_info->in_queue == GLOBUS_L_CALLBACK_QUEUE_TIMED)
             {
-                globus_priority_q_remove(
-                    &callback_info->my_space->timed_queue, callback_info);
+                globus_i_callback_wheel_remove(
+                    &callback_info->my_space->timed_queue, &callback_info->timer);
             }
             else if(callback_info->in_queue == GLOBUS_L_CALLBACK_QUEUE_READY)
             {
@@ -787,8 +781,8 @@ globus_callback_unregister_nothreads(
         {
             if(callback_info->in_queue == GLOBUS_L_CALLBACK_QUEUE_TIMED)
             {
-                globus_priority_q_remove(
-                    &callback_info->my_space->timed_queue, callback_info);
+                globus_i_callback_wheel_remove(
+                    &callback_info->my_space->timed_queue, &callback_info->timer);
             }
             else if(callback_info->in_queue == GLOBUS_L_CALLBACK_QUEUE_READY)
             {
@@ -866,9 +860,9 @@ globus_callback_adjust_oneshot_nothreads(
             
             if(callback_info->in_queue == GLOBUS_L_CALLBACK_QUEUE_TIMED)
             {
-                globus_priority_q_modify(
+                globus_i_callback_wheel_modify(
                     &callback_info->my_space->timed_queue,
-                    callback_info,
+                    &callback_info->timer,
                     &callback_info->start_time);
             }
             else
@@ -878,16 +872,17 @@ globus_callback_adjust_oneshot_nothreads(
                 
                 callback_info->in_queue = GLOBUS_L_CALLBACK_QUEUE_TIMED;
                 
-                globus_priority_q_enqueue(
+                globus_i_callback_wheel_enqueue(
                     &callback_info->my_space->timed_queue,
+                    &callback_info->timer,
                     callback_info,
                     &callback_info->start_time);
             }
         }
         else if(callback_info->in_queue == GLOBUS_L_CALLBACK_QUEUE_TIMED)
         {
-            globus_priority_q_remove(
-                &callback_info->my_space->timed_queue, callback_info);
+            globus_i_callback_wheel_remove(
+                &callback_info->my_space->timed_queue, &callback_info->timer);
             
             callback_info->in_queue = GLOBUS_L_CALLBACK_QUEUE_READY;
             
@@ -954,8 +949,8 @@ globus_callback_adjust_period_nothreads(
         {
             if(callback_info->in_queue == GLOBUS_L_CALLBACK_QUEUE_TIMED)
             {
-                globus_priority_q_remove(
-                    &callback_info->my_space->timed_queue, callback_info);
+                globus_i_callback_wheel_remove(
+                    &callback_info->my_space->timed_queue, &callback_info->timer);
             }
             else if(callback_info->in_queue == GLOBUS_L_CALLBACK_QUEUE_READY)
             {
@@ -988,9 +983,9 @@ globus_callback_adjust_period_nothreads(
             */
             if(callback_info->in_queue == GLOBUS_L_CALLBACK_QUEUE_TIMED)
             {
-                globus_priority_q_modify(
+                globus_i_callback_wheel_modify(
                     &callback_info->my_space->timed_queue,
-                    callback_info,
+                    &callback_info->timer,
                     &callback_info->start_time);
             }
             else if(callback_info->in_queue == GLOBUS_L_CALLBACK_QUEUE_READY)
@@ -1000,8 +995,9 @@ globus_callback_adjust_period_nothreads(
                 
                 callback_info->in_queue = GLOBUS_L_CALLBACK_QUEUE_TIMED;
                 
-                globus_priority_q_enqueue(
+                globus_i_callback_wheel_enqueue(
                     &callback_info->my_space->timed_queue,
+                    &callback_info->timer,
                     callback_info,
                     &callback_info->start_time);
             }
@@ -1013,8 +1009,9 @@ globus_callback_adjust_period_nothreads(
                  */
                 callback_info->in_queue = GLOBUS_L_CALLBACK_QUEUE_TIMED;
                 
-                globus_priority_q_enqueue(
+                globus_i_callback_wheel_enqueue(
                     &callback_info->my_space->timed_queue,
+                    &callback_info->timer,
                     callback_info,
                     &callback_info->start_time);
             
@@ -1030,8 +1027,8 @@ globus_callback_adjust_period_nothreads(
              */
             if(callback_info->in_queue == GLOBUS_L_CALLBACK_QUEUE_TIMED)
             {
-                globus_priority_q_remove(
-                    &callback_info->my_space->timed_queue, callback_info);
+                globus_i_callback_wheel_remove(
+                    &callback_info->my_space->timed_queue, &callback_info->timer);
                 
                 callback_info->in_queue = GLOBUS_L_CALLBACK_QUEUE_READY;
                 
@@ -1088,9 +1085,8 @@ globus_callback_space_init_nothreads(
     }
 
     GlobusICallbackReadyInit(&i_space->ready_queue);
-    globus_priority_q_init(
-        &i_space->timed_queue,
-        (globus_priority_q_cmp_func_t) globus_abstime_cmp);
+    globus_i_callback_wheel_init(
+        &i_space->timed_queue);
 
     i_space->handle =
         globus_handle_table_insert(
@@ -1223,22 +1219,18 @@ globus_l_callback_get_next(
     globus_l_callback_info_t *          callback_info;
 
     /* first check to see if anything in the timed queue is ready */
-    tmp_time = (globus_abstime_t *)
-        globus_priority_q_first_priority(&i_space->timed_queue);
-    if(tmp_time)
+    tmp_time = GLOBUS_NULL;
+    if(!globus_i_callback_wheel_empty(&i_space->timed_queue))
     {
-        while(tmp_time && globus_abstime_cmp(tmp_time, time_now) <= 0)
+        while((callback_info = (globus_l_callback_info_t *)
+            globus_i_callback_wheel_expire(&i_space->timed_queue, time_now)))
         {
-            callback_info = (globus_l_callback_info_t *)
-                globus_priority_q_dequeue(&i_space->timed_queue);
-            
             callback_info->in_queue = GLOBUS_L_CALLBACK_QUEUE_READY;
             
             GlobusICallbackReadyEnqueue(&i_space->ready_queue, callback_info);
-                    
-            tmp_time = (globus_abstime_t *)
-                globus_priority_q_first_priority(&i_space->timed_queue);
         }
+        
+        tmp_time = globus_i_callback_wheel_next(&i_space->timed_queue);
     }
 
     GlobusICallbackReadyDequeue(&i_space->ready_queue, callback_info);
@@ -1689,13 +1681,11 @@ globus_callback_get_timeout_nothreads(
         
         global_time = GLOBUS_NULL;
         
-        space_time = (globus_abstime_t *)
-            globus_priority_q_first_priority(&i_space->timed_queue);
+        space_time = globus_i_callback_wheel_next(&i_space->timed_queue);
         if(i_space->handle != GLOBUS_CALLBACK_GLOBAL_SPACE)
         {
-            global_time = (globus_abstime_t *)
-                globus_priority_q_first_priority(
-                    &globus_l_callback_global_space.timed_queue);
+            global_time = globus_i_callback_wheel_next(
+                &globus_l_callback_global_space.timed_queue);
         }
         
         earlier_time = space_time;
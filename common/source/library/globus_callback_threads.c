@@ -21,7 +21,7 @@
 #include "globus_i_callback.h"
 #include "globus_thread_common.h"
 #include "globus_thread_pool.h"
-#include "globus_priority_q.h"
+#include "globus_memory.h"
 #include "globus_callback.h"
 #include "globus_handle_table.h"
 #include "globus_libc.h"
@@ -52,6 +52,26 @@
  */
 #define GLOBUS_L_CALLBACK_POST_STOP_ONESHOTS 10
 
+/* anonymous oneshots that are ready now and registered to the global space
+ * skip the handle table and the space lock.  they go on one of a set of
+ * per poller queues, and pollers with nothing of their own take work from
+ * the others before going to sleep
+ */
+#if defined(__GNUC__) && defined(__ATOMIC_ACQUIRE)
+#define GLOBUS_L_CALLBACK_WORK_STEALING 1
+#define GlobusLCallbackWorkerPending()                                      \
+    __atomic_load_n(&globus_l_callback_worker_pending, __ATOMIC_SEQ_CST)
+/* pushes read a space's idle_count without its lock */
+#define GlobusLCallbackIdleCount(_space)                                    \
+    __atomic_load_n(&(_space)->idle_count, __ATOMIC_SEQ_CST)
+#define GlobusLCallbackIdleCountReset(_space)                               \
+    __atomic_store_n(&(_space)->idle_count, 0, __ATOMIC_SEQ_CST)
+#else
+#define GlobusLCallbackWorkerPending() 0
+#define GlobusLCallbackIdleCount(_space) ((_space)->idle_count)
+#define GlobusLCallbackIdleCountReset(_space) ((_space)->idle_count = 0)
+#endif
+
 #if defined(TARGET_ARCH_LINUX)
 extern pid_t                            globus_l_callback_main_thread;
 #endif
@@ -103,6 +123,7 @@ typedef struct globus_l_callback_info_s
     void *                              unreg_arg;
 
     struct globus_l_callback_space_s *  my_space;
+    globus_i_callback_timer_t           timer;
     
     /* used by ready queue macros */
     struct globus_l_callback_info_s *   next;
@@ -118,7 +139,7 @@ typedef struct globus_l_callback_space_s
 {
     globus_callback_space_t             handle;
     globus_callback_space_behavior_t    behavior;
-    globus_priority_q_t                 timed_queue;
+    globus_i_callback_wheel_t           timed_queue;
     globus_l_callback_ready_queue_t     ready_queue;
     globus_mutex_t                      lock;
     globus_cond_t                       cond;
@@ -128,6 +149,16 @@ typedef struct globus_l_callback_space_s
     int                                 thread_count; 
 } globus_l_callback_space_t;
 
+/* one per global space poller.  the owner and any poller stealing from it
+ * both take from the head, priority oneshots are pushed there too
+ */
+typedef struct globus_l_callback_worker_s
+{
+    globus_mutex_t                      lock;
+    globus_l_callback_ready_queue_t     queue;
+    int                                 count;
+} globus_l_callback_worker_t;
+
 typedef struct globus_l_callback_space_attr_s
 {
     globus_callback_space_behavior_t    behavior;
@@ -141,6 +172,8 @@ typedef struct
     globus_l_callback_info_t *          callback_info;
     globus_bool_t                       create_thread;
     globus_bool_t                       own_thread;
+    /* only for global space pollers */
+    globus_l_callback_worker_t *        worker;
 } globus_l_callback_restart_info_t;
 
 typedef struct
@@ -180,6 +213,11 @@ static int                              globus_l_callback_max_polling_threads;
 static int                              globus_l_callback_thread_count;
 static globus_reltime_t                 globus_l_callback_own_thread_period;
 
+static globus_l_callback_worker_t *     globus_l_callback_workers;
+static int                              globus_l_callback_worker_count;
+static int                              globus_l_callback_worker_next;
+static int                              globus_l_callback_worker_pending;
+
 static globus_l_callback_signal_handler_t ** globus_l_callback_signal_handlers;
 static int                              globus_l_callback_signal_handlers_size;
 static globus_thread_t                  globus_l_callback_signal_thread;
@@ -288,7 +326,7 @@ globus_l_callback_space_destructor(
     
     if(clean_up)
     {
-        globus_priority_q_destroy(&i_space->timed_queue);
+        globus_i_callback_wheel_destroy(&i_space->timed_queue);
         globus_mutex_destroy(&i_space->lock);
         globus_cond_destroy(&i_space->cond);
         
@@ -302,6 +340,11 @@ void *
 globus_l_callback_thread_poll(
     void *                              user_arg);
 
+static
+void *
+globus_l_callback_thread_poll_global(
+    void *                              user_arg);
+
 static
 void *
 globus_l_callback_thread_signal_poll(
@@ -458,12 +501,11 @@ globus_l_callback_activate()
     globus_l_callback_global_space.behavior = 
         GLOBUS_CALLBACK_SPACE_BEHAVIOR_THREADED;
     GlobusICallbackReadyInit(&globus_l_callback_global_space.ready_queue);
-    globus_priority_q_init(
-        &globus_l_callback_global_space.timed_queue,
-        (globus_priority_q_cmp_func_t) globus_abstime_cmp);
+    globus_i_callback_wheel_init(
+        &globus_l_callback_global_space.timed_queue);
     globus_mutex_init(&globus_l_callback_global_space.lock, GLOBUS_NULL);
     globus_cond_init(&globus_l_callback_global_space.cond, GLOBUS_NULL);
-    globus_l_callback_global_space.idle_count = 0;
+    GlobusLCallbackIdleCountReset(&globus_l_callback_global_space);
     globus_l_callback_global_space.shutdown = GLOBUS_FALSE;
     
     globus_list_insert(
@@ -546,12 +588,41 @@ globus_l_callback_activate()
         GLOBUS_NULL);
 #endif
 
+    globus_l_callback_workers = GLOBUS_NULL;
+#ifdef GLOBUS_L_CALLBACK_WORK_STEALING
+    globus_l_callback_worker_count = globus_l_callback_max_polling_threads;
+    globus_l_callback_worker_next = 0;
+    globus_l_callback_worker_pending = 0;
+    globus_l_callback_workers = (globus_l_callback_worker_t *)
+        globus_calloc(
+            globus_l_callback_worker_count,
+            sizeof(globus_l_callback_worker_t));
+    if(globus_l_callback_workers)
+    {
+        for(i = 0; i < globus_l_callback_worker_count; i++)
+        {
+            globus_mutex_init(
+                &globus_l_callback_workers[i].lock, GLOBUS_NULL);
+            GlobusICallbackReadyInit(&globus_l_callback_workers[i].queue);
+        }
+    }
+#endif
+
     /* create pollers for the global space */
     for(i = 0; i < globus_l_callback_max_polling_threads; i++)
     {
-        globus_i_thread_start(
-            globus_l_callback_thread_poll,
-            &globus_l_callback_global_space);
+        if(globus_l_callback_workers)
+        {
+            globus_i_thread_start(
+                globus_l_callback_thread_poll_global,
+                &globus_l_callback_workers[i]);
+        }
+        else
+        {
+            globus_i_thread_start(
+                globus_l_callback_thread_poll,
+                &globus_l_callback_global_space);
+        }
     }
     
     return GLOBUS_SUCCESS;
@@ -620,9 +691,20 @@ globus_l_callback_deactivate()
     
     globus_thread_key_delete(globus_l_callback_restart_info_key);
 
+    /* oneshots still queued are freed with the info memory below */
+    if(globus_l_callback_workers)
+    {
+        for(i = 0; i < globus_l_callback_worker_count; i++)
+        {
+            globus_mutex_destroy(&globus_l_callback_workers[i].lock);
+        }
+        globus_free(globus_l_callback_workers);
+        globus_l_callback_workers = GLOBUS_NULL;
+    }
+
     globus_cond_destroy(&globus_l_callback_global_space.cond);
     globus_mutex_destroy(&globus_l_callback_global_space.lock);
-    globus_priority_q_destroy(&globus_l_callback_global_space.timed_queue);
+    globus_i_callback_wheel_destroy(&globus_l_callback_global_space.timed_queue);
     
     /* any handles left here will be destroyed by destructor.
      * important that globus_l_callback_handle_table be destroyed
@@ -702,6 +784,158 @@ globus_l_callback_deactivate()
     return globus_module_deactivate(GLOBUS_THREAD_MODULE);
 }
 
+#ifdef GLOBUS_L_CALLBACK_WORK_STEALING
+
+/*
+ * queue an anonymous ready oneshot for the global space pollers.  a poller
+ * registering more work keeps it on its own queue, other threads spread
+ * theirs around.  a sleeping poller is only woken if one is idle; the
+ * pending count is raised before idle_count is read here, and idle_count
+ * is raised before the pending count is read in
+ * globus_l_callback_idle_wait(), so either the push is seen there or the
+ * sleeper is signaled
+ */
+static
+void
+globus_l_callback_worker_push(
+    globus_l_callback_info_t *          callback_info,
+    globus_bool_t                       priority)
+{
+    globus_l_callback_restart_info_t *  restart_info;
+    globus_l_callback_worker_t *        worker;
+    unsigned                            next;
+
+    restart_info = (globus_l_callback_restart_info_t *)
+        globus_thread_getspecific(globus_l_callback_restart_info_key);
+    if(restart_info && restart_info->worker)
+    {
+        worker = restart_info->worker;
+    }
+    else
+    {
+        next = (unsigned) __atomic_fetch_add(
+            &globus_l_callback_worker_next, 1, __ATOMIC_RELAXED);
+        worker = &globus_l_callback_workers[
+            next % globus_l_callback_worker_count];
+    }
+
+    globus_mutex_lock(&worker->lock);
+    {
+        if(priority)
+        {
+            GlobusICallbackReadyEnqueueFirst(&worker->queue, callback_info);
+        }
+        else
+        {
+            GlobusICallbackReadyEnqueue(&worker->queue, callback_info);
+        }
+        __atomic_add_fetch(&worker->count, 1, __ATOMIC_RELAXED);
+    }
+    globus_mutex_unlock(&worker->lock);
+
+    __atomic_add_fetch(
+        &globus_l_callback_worker_pending, 1, __ATOMIC_SEQ_CST);
+    if(GlobusLCallbackIdleCount(&globus_l_callback_global_space) > 0)
+    {
+        globus_mutex_lock(&globus_l_callback_global_space.lock);
+        {
+            globus_cond_signal(&globus_l_callback_global_space.cond);
+        }
+        globus_mutex_unlock(&globus_l_callback_global_space.lock);
+    }
+}
+
+/*
+ * take the next oneshot from this poller's queue, or failing that, from
+ * the first other poller's queue that has one
+ */
+static
+globus_l_callback_info_t *
+globus_l_callback_worker_take(
+    globus_l_callback_worker_t *        worker)
+{
+    globus_l_callback_worker_t *        victim;
+    globus_l_callback_info_t *          callback_info;
+    int                                 index;
+    int                                 i;
+
+    callback_info = GLOBUS_NULL;
+    if(__atomic_load_n(
+        &globus_l_callback_worker_pending, __ATOMIC_RELAXED) == 0)
+    {
+        return GLOBUS_NULL;
+    }
+
+    index = worker - globus_l_callback_workers;
+    for(i = 0; i < globus_l_callback_worker_count && !callback_info; i++)
+    {
+        victim = &globus_l_callback_workers[
+            (index + i) % globus_l_callback_worker_count];
+        if(__atomic_load_n(&victim->count, __ATOMIC_RELAXED) == 0)
+        {
+            continue;
+        }
+
+        globus_mutex_lock(&victim->lock);
+        {
+            GlobusICallbackReadyDequeue(&victim->queue, callback_info);
+            if(callback_info)
+            {
+                __atomic_sub_fetch(&victim->count, 1, __ATOMIC_RELAXED);
+            }
+        }
+        globus_mutex_unlock(&victim->lock);
+    }
+
+    if(callback_info)
+    {
+        __atomic_sub_fetch(
+            &globus_l_callback_worker_pending, 1, __ATOMIC_SEQ_CST);
+    }
+
+    return callback_info;
+}
+
+#endif
+
+/*
+ * wait on a space's cond.  called with i_space->lock held.  a global space
+ * poller will not sleep while the poller queues have work
+ */
+static
+void
+globus_l_callback_idle_wait(
+    globus_l_callback_space_t *         i_space,
+    globus_l_callback_worker_t *        worker,
+    globus_abstime_t *                  wake_time)
+{
+#ifdef GLOBUS_L_CALLBACK_WORK_STEALING
+    __atomic_add_fetch(&i_space->idle_count, 1, __ATOMIC_SEQ_CST);
+    if(worker && GlobusLCallbackWorkerPending() > 0)
+    {
+        __atomic_sub_fetch(&i_space->idle_count, 1, __ATOMIC_SEQ_CST);
+        return;
+    }
+#else
+    i_space->idle_count++;
+#endif
+
+    if(wake_time)
+    {
+        globus_cond_timedwait(&i_space->cond, &i_space->lock, wake_time);
+    }
+    else
+    {
+        globus_cond_wait(&i_space->cond, &i_space->lock);
+    }
+
+#ifdef GLOBUS_L_CALLBACK_WORK_STEALING
+    __atomic_sub_fetch(&i_space->idle_count, 1, __ATOMIC_SEQ_CST);
+#else
+    i_space->idle_count--;
+#endif
+}
+
 /**
  * globus_l_callback_register
  *
@@ -731,6 +965,34 @@ globus_l_callback_register(
             "globus_l_callback_register", "callback_func");
     }
 
+#ifdef GLOBUS_L_CALLBACK_WORK_STEALING
+    if(!callback_handle && !start_time && !period &&
+        space == GLOBUS_CALLBACK_GLOBAL_SPACE && globus_l_callback_workers)
+    {
+        /* no one can refer to this, so it needs no handle */
+        callback_info = (globus_l_callback_info_t *)
+            globus_memory_pop_node(&globus_l_callback_info_memory);
+        if(!callback_info)
+        {
+            return GLOBUS_L_CALLBACK_CONSTRUCT_MEMORY_ALLOC(
+                "globus_l_callback_register", "callback_info");
+        }
+
+        callback_info->handle = GLOBUS_NULL_HANDLE;
+        callback_info->my_space = &globus_l_callback_global_space;
+        callback_info->callback_func = callback_func;
+        callback_info->callback_args = callback_user_arg;
+        callback_info->running_count = 0;
+        callback_info->unregister_callback = GLOBUS_NULL;
+        callback_info->is_periodic = GLOBUS_FALSE;
+        callback_info->in_queue = GLOBUS_L_CALLBACK_QUEUE_READY;
+
+        globus_l_callback_worker_push(callback_info, priority);
+
+        return GLOBUS_SUCCESS;
+    }
+#endif
+
     globus_mutex_lock(&globus_l_callback_handle_lock);
     {
         callback_info = (globus_l_callback_info_t *)
@@ -864,8 +1126,9 @@ globus_l_callback_register(
                 GlobusTimeAbstimeCopy(callback_info->start_time, *start_time);
                 callback_info->in_queue = GLOBUS_L_CALLBACK_QUEUE_TIMED;
                 
-                globus_priority_q_enqueue(
+                globus_i_callback_wheel_enqueue(
                     &i_space->timed_queue,
+                    &callback_info->timer,
                     callback_info,
                     &callback_info->start_time);
             }
@@ -886,7 +1149,7 @@ globus_l_callback_register(
             }
         }
         
-        if(i_space->idle_count > 0)
+        if(GlobusLCallbackIdleCount(i_space) > 0)
         {
             do_signal = GLOBUS_TRUE;
         }
@@ -1093,8 +1356,8 @@ globus_callback_unregister_threads(
             /* would only be in queue if it was restarted */
             if(callback_info->in_queue == GLOBUS_L_CALLBACK_QUEUE_TIMED)
             {
-                globus_priority_q_remove(
-                    &callback_info->my_space->timed_queue, callback_info);
+                globus_i_callback_wheel_remove(
+                    &callback_info->my_space->timed_queue, &callback_info->timer);
             }
             else if(callback_info->in_queue == GLOBUS_L_CALLBACK_QUEUE_READY)
             {
@@ -1132,8 +1395,8 @@ globus_callback_unregister_threads(
         {
             if(callback_info->in_queue == GLOBUS_L_CALLBACK_QUEUE_TIMED)
             {
-                globus_priority_q_remove(
-                    &callback_info->my_space->timed_queue, callback_info);
+                globus_i_callback_wheel_remove(
+                    &callback_info->my_space->timed_queue, &callback_info->timer);
             }
             else if(callback_info->in_queue == GLOBUS_L_CALLBACK_QUEUE_READY)
             {
@@ -1224,9 +1487,9 @@ globus_callback_adjust_oneshot_threads(
             
             if(callback_info->in_queue == GLOBUS_L_CALLBACK_QUEUE_TIMED)
             {
-                globus_priority_q_modify(
+                globus_i_callback_wheel_modify(
                     &callback_info->my_space->timed_queue,
-                    callback_info,
+                    &callback_info->timer,
                     &callback_info->start_time);
             }
             else
@@ -1236,16 +1499,17 @@ globus_callback_adjust_oneshot_threads(
                 
                 callback_info->in_queue = GLOBUS_L_CALLBACK_QUEUE_TIMED;
                 
-                globus_priority_q_enqueue(
+                globus_i_callback_wheel_enqueue(
                     &callback_info->my_space->timed_queue,
+                    &callback_info->timer,
                     callback_info,
                     &callback_info->start_time);
             }
         }
         else if(callback_info->in_queue == GLOBUS_L_CALLBACK_QUEUE_TIMED)
         {
-            globus_priority_q_remove(
-                &callback_info->my_space->timed_queue, callback_info);
+            globus_i_callback_wheel_remove(
+                &callback_info->my_space->timed_queue, &callback_info->timer);
             
             callback_info->in_queue = GLOBUS_L_CALLBACK_QUEUE_READY;
             
@@ -1254,7 +1518,7 @@ globus_callback_adjust_oneshot_threads(
         }
         
         /* wake up any sleeping threads to let them know about new work */
-        if(callback_info->my_space->idle_count > 0)
+        if(GlobusLCallbackIdleCount(callback_info->my_space) > 0)
         {
             globus_cond_signal(&callback_info->my_space->cond);
         }
@@ -1329,8 +1593,8 @@ globus_callback_adjust_period_threads(
         {
             if(callback_info->in_queue == GLOBUS_L_CALLBACK_QUEUE_TIMED)
             {
-                globus_priority_q_remove(
-                    &callback_info->my_space->timed_queue, callback_info);
+                globus_i_callback_wheel_remove(
+                    &callback_info->my_space->timed_queue, &callback_info->timer);
             }
             else if(callback_info->in_queue == GLOBUS_L_CALLBACK_QUEUE_READY)
             {
@@ -1369,9 +1633,9 @@ globus_callback_adjust_period_threads(
             */
             if(callback_info->in_queue == GLOBUS_L_CALLBACK_QUEUE_TIMED)
             {
-                globus_priority_q_modify(
+                globus_i_callback_wheel_modify(
                     &callback_info->my_space->timed_queue,
-                    callback_info,
+                    &callback_info->timer,
                     &callback_info->start_time);
             }
             else if(callback_info->in_queue == GLOBUS_L_CALLBACK_QUEUE_READY)
@@ -1381,8 +1645,9 @@ globus_callback_adjust_period_threads(
                 
                 callback_info->in_queue = GLOBUS_L_CALLBACK_QUEUE_TIMED;
                 
-                globus_priority_q_enqueue(
+                globus_i_callback_wheel_enqueue(
                     &callback_info->my_space->timed_queue,
+                    &callback_info->timer,
                     callback_info,
                     &callback_info->start_time);
             }
@@ -1394,8 +1659,9 @@ globus_callback_adjust_period_threads(
                  */
                 callback_info->in_queue = GLOBUS_L_CALLBACK_QUEUE_TIMED;
                 
-                globus_priority_q_enqueue(
+                globus_i_callback_wheel_enqueue(
                     &callback_info->my_space->timed_queue,
+                    &callback_info->timer,
                     callback_info,
                     &callback_info->start_time);
             
@@ -1415,8 +1681,8 @@ globus_callback_adjust_period_threads(
              */
             if(callback_info->in_queue == GLOBUS_L_CALLBACK_QUEUE_TIMED)
             {
-                globus_priority_q_remove(
-                    &callback_info->my_space->timed_queue, callback_info);
+                globus_i_callback_wheel_remove(
+                    &callback_info->my_space->timed_queue, &callback_info->timer);
                 
                 callback_info->in_queue = GLOBUS_L_CALLBACK_QUEUE_READY;
                 
@@ -1444,7 +1710,8 @@ globus_callback_adjust_period_threads(
         }
         
         /* wake up any sleeping threads to let them know about new work */
-        if(callback_info->in_queue && callback_info->my_space->idle_count > 0)
+        if(callback_info->in_queue &&
+            GlobusLCallbackIdleCount(callback_info->my_space) > 0)
         {
             globus_cond_signal(&callback_info->my_space->cond);
         }
@@ -1512,14 +1779,13 @@ globus_callback_space_init_threads(
         }
         
         GlobusICallbackReadyInit(&i_space->ready_queue);
-        globus_priority_q_init(
-            &i_space->timed_queue,
-            (globus_priority_q_cmp_func_t) globus_abstime_cmp);
+        globus_i_callback_wheel_init(
+            &i_space->timed_queue);
         globus_mutex_init(&i_space->lock, GLOBUS_NULL);
         globus_cond_init(&i_space->cond, GLOBUS_NULL);
         i_space->behavior = behavior;
         i_space->shutdown = GLOBUS_FALSE;
-        i_space->idle_count = 0;
+        GlobusLCallbackIdleCountReset(i_space);
         
         if(behavior == GLOBUS_CALLBACK_SPACE_BEHAVIOR_SERIALIZED)
         {
@@ -1741,9 +2007,8 @@ globus_l_callback_get_next(
     globus_l_callback_info_t *          callback_info;
 
     /* first check to see if anything in the timed queue is ready */
-    tmp_time = (globus_abstime_t *)
-        globus_priority_q_first_priority(&i_space->timed_queue);
-    if(tmp_time)
+    tmp_time = GLOBUS_NULL;
+    if(!globus_i_callback_wheel_empty(&i_space->timed_queue))
     {
         globus_abstime_t                    l_time_now;
         
@@ -1753,18 +2018,15 @@ globus_l_callback_get_next(
             time_now = &l_time_now;
         }
         
-        while(tmp_time && globus_abstime_cmp(tmp_time, time_now) <= 0)
+        while((callback_info = (globus_l_callback_info_t *)
+            globus_i_callback_wheel_expire(&i_space->timed_queue, time_now)))
         {
-            callback_info = (globus_l_callback_info_t *)
-                globus_priority_q_dequeue(&i_space->timed_queue);
-            
             callback_info->in_queue = GLOBUS_L_CALLBACK_QUEUE_READY;
             
             GlobusICallbackReadyEnqueue(&i_space->ready_queue, callback_info);
-                    
-            tmp_time = (globus_abstime_t *)
-                globus_priority_q_first_priority(&i_space->timed_queue);
         }
+        
+        tmp_time = globus_i_callback_wheel_next(&i_space->timed_queue);
     }
 
     GlobusICallbackReadyDequeue(&i_space->ready_queue, callback_info);
@@ -1803,36 +2065,28 @@ globus_l_callback_requeue(
 {
     globus_bool_t                       ready;
     globus_l_callback_space_t *         i_space;
-    const globus_abstime_t *            tmp_time;
     globus_abstime_t                    l_time_now;
     
     ready = GLOBUS_TRUE;
     i_space = callback_info->my_space;
     
     /* first check to see if anything in the timed queue is ready */
-    tmp_time = (globus_abstime_t *)
-        globus_priority_q_first_priority(&i_space->timed_queue);
-    if(tmp_time)
+    if(!globus_i_callback_wheel_empty(&i_space->timed_queue))
     {
+        globus_l_callback_info_t *          ready_info;
+        
         if(!time_now)
         {
             GlobusTimeAbstimeGetCurrent(l_time_now);
             time_now = &l_time_now;
         }
         
-        while(tmp_time && globus_abstime_cmp(tmp_time, time_now) <= 0)
+        while((ready_info = (globus_l_callback_info_t *)
+            globus_i_callback_wheel_expire(&i_space->timed_queue, time_now)))
         {
-            globus_l_callback_info_t *          ready_info;
-            
-            ready_info = (globus_l_callback_info_t *)
-                globus_priority_q_dequeue(&i_space->timed_queue);
-            
             ready_info->in_queue = GLOBUS_L_CALLBACK_QUEUE_READY;
             
             GlobusICallbackReadyEnqueue(&i_space->ready_queue, ready_info);
-                    
-            tmp_time = (globus_abstime_t *)
-                globus_priority_q_first_priority(&i_space->timed_queue);
         }
     }
     
@@ -1852,8 +2106,9 @@ globus_l_callback_requeue(
             ready = GLOBUS_FALSE;
             callback_info->in_queue = GLOBUS_L_CALLBACK_QUEUE_TIMED;
             
-            globus_priority_q_enqueue(
+            globus_i_callback_wheel_enqueue(
                 &i_space->timed_queue,
+                &callback_info->timer,
                 callback_info,
                 &callback_info->start_time);
         }
@@ -1866,7 +2121,7 @@ globus_l_callback_requeue(
         GlobusICallbackReadyEnqueue(&i_space->ready_queue, callback_info);
     }
     
-    if(i_space->idle_count > 0)
+    if(GlobusLCallbackIdleCount(i_space) > 0)
     {
         globus_cond_signal(&i_space->cond);
     }
@@ -1923,9 +2178,19 @@ globus_l_callback_blocked_cb(
                         callback_info->my_space->thread_count++;
                         globus_l_callback_thread_count++;
                         
-                        globus_i_thread_start(
-                            globus_l_callback_thread_poll,
-                            callback_info->my_space);
+                        /* a global space poller's queue goes with it */
+                        if(restart_info->worker)
+                        {
+                            globus_i_thread_start(
+                                globus_l_callback_thread_poll_global,
+                                restart_info->worker);
+                        }
+                        else
+                        {
+                            globus_i_thread_start(
+                                globus_l_callback_thread_poll,
+                                callback_info->my_space);
+                        }
                     }
                 } 
                 globus_mutex_unlock(&globus_l_callback_thread_lock);
@@ -2069,6 +2334,7 @@ globus_callback_space_poll_threads(
     restart_info.signaled = GLOBUS_FALSE;
     restart_info.create_thread = GLOBUS_FALSE;
     restart_info.own_thread = GLOBUS_FALSE;
+    restart_info.worker = GLOBUS_NULL;
     restart_info.time_stop = timestop;
 
     GlobusTimeAbstimeGetCurrent(time_now);
@@ -2139,10 +2405,8 @@ globus_callback_space_poll_threads(
                  * the main threadm in which case, he shouldnt be calling
                  * for a shutdown
                  */
-                i_space->idle_count++;
-                globus_cond_timedwait(
-                    &i_space->cond, &i_space->lock, &next_ready_time);
-                i_space->idle_count--;
+                globus_l_callback_idle_wait(
+                    i_space, GLOBUS_NULL, &next_ready_time);
                 yield = GLOBUS_FALSE;
             }
             else if(globus_time_abstime_is_infinity(timestop))
@@ -2150,9 +2414,7 @@ globus_callback_space_poll_threads(
                 /* we can only get here if queue is empty
                  * and we are blocking forever. 
                  */
-                i_space->idle_count++;
-                globus_cond_wait(&i_space->cond, &i_space->lock);
-                i_space->idle_count--;
+                globus_l_callback_idle_wait(i_space, GLOBUS_NULL, GLOBUS_NULL);
                 yield = GLOBUS_FALSE;
             }
             else
@@ -2233,6 +2495,7 @@ globus_l_callback_thread_callback(
     restart_info.restarted = GLOBUS_FALSE;
     restart_info.create_thread = GLOBUS_FALSE;
     restart_info.own_thread = GLOBUS_TRUE;
+    restart_info.worker = GLOBUS_NULL;
     restart_info.time_stop = &globus_i_abstime_infinity;
     restart_info.callback_info = callback_info;
     
@@ -2279,12 +2542,10 @@ globus_l_callback_thread_callback(
                         {
                             do
                             {
-                                i_space->idle_count++;
-                                globus_cond_timedwait(
-                                    &i_space->cond,
-                                    &i_space->lock,
+                                globus_l_callback_idle_wait(
+                                    i_space,
+                                    GLOBUS_NULL,
                                     &callback_info->start_time);
-                                i_space->idle_count--;
                                 
                                 GlobusTimeAbstimeGetCurrent(time_now);
                                 
@@ -2396,7 +2657,7 @@ globus_l_callback_serialized_cleanup(
             }
             globus_mutex_unlock(&i_space->lock);
         
-            globus_priority_q_destroy(&i_space->timed_queue);
+            globus_i_callback_wheel_destroy(&i_space->timed_queue);
             globus_mutex_destroy(&i_space->lock);
             globus_cond_destroy(&i_space->cond);
                 
@@ -2411,28 +2672,31 @@ globus_l_callback_serialized_cleanup(
 }
 
 /* internal polling function 
- * all threads except for dedicated ones start here
+ * all threads except for dedicated ones start here.  worker is only set
+ * for global space pollers
  */
 static
 void *
-globus_l_callback_thread_poll(
-    void *                              user_arg)
+globus_l_callback_thread_poll_worker(
+    globus_l_callback_space_t *         i_space,
+    globus_l_callback_worker_t *        worker)
 {
     globus_bool_t                       done;
+    globus_bool_t                       shutdown;
+    globus_bool_t                       from_worker;
     globus_l_callback_info_t *          callback_info;
     globus_abstime_t                    next_ready_time;
     globus_l_callback_restart_info_t    restart_info;
     globus_thread_callback_index_t      restart_index;
     globus_bool_t                       gets_own_thread;
-    globus_l_callback_space_t *         i_space;
     
-    i_space = (globus_l_callback_space_t *) user_arg;
     /* if this thread is ever restarted, its going to terminate, since
      * it knows a new thread was started as a result of the restart
      */
     restart_info.restarted = GLOBUS_FALSE;
     restart_info.create_thread = GLOBUS_TRUE;
     restart_info.own_thread = GLOBUS_FALSE;
+    restart_info.worker = worker;
     restart_info.time_stop = &globus_i_abstime_infinity;
     globus_thread_setspecific(
         globus_l_callback_restart_info_key, &restart_info);
@@ -2447,61 +2711,90 @@ globus_l_callback_thread_poll(
     do
     {
         callback_info = GLOBUS_NULL;
+        shutdown = GLOBUS_FALSE;
         
         globus_thread_blocking_callback_disable(&restart_index);
         
-        globus_mutex_lock(&i_space->lock);
+#ifdef GLOBUS_L_CALLBACK_WORK_STEALING
+        if(worker &&
+            !__atomic_load_n(&i_space->shutdown, __ATOMIC_RELAXED))
+        {
+            callback_info = globus_l_callback_worker_take(worker);
+        }
+#endif
+        from_worker = (callback_info != GLOBUS_NULL);
+        
+        if(!from_worker)
         {
-            while(!i_space->shutdown && !callback_info)
+            globus_mutex_lock(&i_space->lock);
             {
-                GlobusICallbackReadyPeak(&i_space->ready_queue, callback_info);
-                
-                if(!callback_info &&
-                    globus_priority_q_empty(&i_space->timed_queue))
+                while(!i_space->shutdown && !callback_info)
                 {
-                    i_space->idle_count++;
-                    globus_cond_wait(&i_space->cond, &i_space->lock);
-                    i_space->idle_count--;
-                }
-                else
-                {
-                    callback_info = globus_l_callback_get_next(
-                        i_space, GLOBUS_NULL, &next_ready_time);
-                        
-                    if(callback_info)
+                    if(worker && GlobusLCallbackWorkerPending() > 0)
                     {
-                        callback_info->running_count++;
-                        gets_own_thread = GLOBUS_FALSE;
-                        if(callback_info->is_periodic &&
-                            globus_reltime_cmp(
-                                &callback_info->period,
-                                &globus_l_callback_own_thread_period) <= 0
-                            && i_space->behavior !=
-                                GLOBUS_CALLBACK_SPACE_BEHAVIOR_SERIALIZED)
-                        {
-                            gets_own_thread = GLOBUS_TRUE;
-                        }
+                        break;
+                    }
+                
+                    GlobusICallbackReadyPeak(
+                        &i_space->ready_queue, callback_info);
+                
+                    if(!callback_info &&
+                        globus_i_callback_wheel_empty(&i_space->timed_queue))
+                    {
+                        globus_l_callback_idle_wait(
+                            i_space, worker, GLOBUS_NULL);
                     }
                     else
                     {
-                        i_space->idle_count++;
-                        globus_cond_timedwait(
-                            &i_space->cond,
-                            &i_space->lock,
-                            &next_ready_time);
-                        i_space->idle_count--;
+                        callback_info = globus_l_callback_get_next(
+                            i_space, GLOBUS_NULL, &next_ready_time);
+                        
+                        if(callback_info)
+                        {
+                            callback_info->running_count++;
+                            gets_own_thread = GLOBUS_FALSE;
+                            if(callback_info->is_periodic &&
+                                globus_reltime_cmp(
+                                    &callback_info->period,
+                                    &globus_l_callback_own_thread_period) <= 0
+                                && i_space->behavior !=
+                                    GLOBUS_CALLBACK_SPACE_BEHAVIOR_SERIALIZED)
+                            {
+                                gets_own_thread = GLOBUS_TRUE;
+                            }
+                        }
+                        else
+                        {
+                            globus_l_callback_idle_wait(
+                                i_space, worker, &next_ready_time);
+                        }
                     }
                 }
-            }
             
-            /* logic of loop above insures that it is
-             * impossible to have a callback when shutdown is true.  We
-             * leave it as an exercise for the reader to prove this.
-             */
+                /* logic of loop above insures that it is
+                 * impossible to have a callback when shutdown is true.  We
+                 * leave it as an exercise for the reader to prove this.
+                 */
+                shutdown = i_space->shutdown;
+            }
+            globus_mutex_unlock(&i_space->lock);
         }
-        globus_mutex_unlock(&i_space->lock);
         
-        if(callback_info)
+        if(from_worker)
+        {
+            restart_info.callback_info = callback_info;
+            
+            globus_thread_blocking_callback_enable(&restart_index);
+            
+            callback_info->callback_func(callback_info->callback_args);
+            
+            /* never in the handle table, nothing else refers to it */
+            globus_memory_push_node(
+                &globus_l_callback_info_memory, callback_info);
+            
+            done = restart_info.restarted;
+        }
+        else if(callback_info)
         {
             /* if function does not have its own thread */
             if(!gets_own_thread)
@@ -2539,7 +2832,8 @@ globus_l_callback_thread_poll(
         }
         else
         {
-            done = GLOBUS_TRUE;
+            /* woken for work on the poller queues */
+            done = shutdown;
         }
     } while(!done);
     
@@ -2567,6 +2861,25 @@ globus_l_callback_thread_poll(
     return GLOBUS_NULL;
 }
 
+static
+void *
+globus_l_callback_thread_poll(
+    void *                              user_arg)
+{
+    return globus_l_callback_thread_poll_worker(
+        (globus_l_callback_space_t *) user_arg, GLOBUS_NULL);
+}
+
+static
+void *
+globus_l_callback_thread_poll_global(
+    void *                              user_arg)
+{
+    return globus_l_callback_thread_poll_worker(
+        &globus_l_callback_global_space,
+        (globus_l_callback_worker_t *) user_arg);
+}
+
 /**
  * globus_callback_space_get
  *
@@ -2693,7 +3006,8 @@ globus_callback_get_timeout_threads(
     
     GlobusICallbackReadyPeak(&i_space->ready_queue, peek);
        
-    if(peek)
+    if(peek || (i_space == &globus_l_callback_global_space &&
+        GlobusLCallbackWorkerPending() > 0))
     {
         GlobusTimeReltimeCopy(*time_left, globus_i_reltime_zero);
         
@@ -2704,8 +3018,7 @@ globus_callback_get_timeout_threads(
         globus_abstime_t                time_now;
         const globus_abstime_t *        earlier_time;
         
-        earlier_time = (globus_abstime_t *)
-            globus_priority_q_first_priority(&i_space->timed_queue);
+        earlier_time = globus_i_callback_wheel_next(&i_space->timed_queue);
         
         if(!earlier_time || 
             globus_abstime_cmp(earlier_time, restart_info->time_stop) > 0)
@@ -0,0 +1,473 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLOBUS_DONT_DOCUMENT_INTERNAL
+
+/*
+ * timing wheel for the callback timed queues.
+ *
+ * time is counted in ticks of wheel->resolution microseconds.  a timer is
+ * kept on the lowest level whose digit (6 bits of the tick per level) is
+ * the highest one in which its tick differs from wheel->now, in the slot
+ * given by that digit.  every timer on a level therefore expires after
+ * every timer on the levels below it, and the first occupied slot of the
+ * lowest occupied level holds the next timers to expire.  when now reaches
+ * the start of a slot, the slot's timers are placed again and move down.
+ */
+
+#include "globus_common_include.h"
+#include "globus_time.h"
+#include "globus_libc.h"
+#include "globus_module.h"
+#include "globus_i_callback.h"
+
+#define GLOBUS_L_CALLBACK_WHEEL_BITS 6
+#define GLOBUS_L_CALLBACK_WHEEL_MASK (GLOBUS_I_CALLBACK_WHEEL_SLOTS - 1)
+/* ticks covered by all of the levels */
+#define GLOBUS_L_CALLBACK_WHEEL_SPAN                                        \
+    (GLOBUS_L_CALLBACK_WHEEL_BITS * GLOBUS_I_CALLBACK_WHEEL_LEVELS)
+
+/* exact timers are sorted into millisecond ticks */
+#define GLOBUS_L_CALLBACK_WHEEL_RESOLUTION 1000
+
+/* keeps tick arithmetic clear of overflow for the infinite time */
+#define GLOBUS_L_CALLBACK_WHEEL_MAX_SEC ((uint64_t) 1 << 40)
+
+#define GLOBUS_L_CALLBACK_WHEEL_NONE -3
+#define GLOBUS_L_CALLBACK_WHEEL_FAR -2
+#define GLOBUS_L_CALLBACK_WHEEL_DUE -1
+
+static
+uint64_t
+globus_l_callback_wheel_usec(
+    const globus_abstime_t *            time)
+{
+    if(time->tv_sec < 0)
+    {
+        return 0;
+    }
+    if((uint64_t) time->tv_sec >= GLOBUS_L_CALLBACK_WHEEL_MAX_SEC)
+    {
+        return GLOBUS_L_CALLBACK_WHEEL_MAX_SEC * 1000000;
+    }
+
+    return (uint64_t) time->tv_sec * 1000000 + time->tv_nsec / 1000;
+}
+
+static
+void
+globus_l_callback_wheel_abstime(
+    globus_i_callback_wheel_t *         wheel,
+    uint64_t                            tick,
+    globus_abstime_t *                  time)
+{
+    uint64_t                            usec;
+
+    usec = tick * wheel->resolution;
+    time->tv_sec = usec / 1000000;
+    time->tv_nsec = (usec % 1000000) * 1000;
+}
+
+static
+int
+globus_l_callback_wheel_first_slot(
+    uint64_t                            occupied)
+{
+#ifdef __GNUC__
+    return __builtin_ctzll(occupied);
+#else
+    int                                 slot = 0;
+
+    while(!(occupied & 1))
+    {
+        occupied >>= 1;
+        slot++;
+    }
+
+    return slot;
+#endif
+}
+
+static
+void
+globus_l_callback_wheel_link(
+    globus_i_callback_timer_t **        head,
+    globus_i_callback_timer_t *         timer)
+{
+    timer->next = *head;
+    if(timer->next)
+    {
+        timer->next->pprev = &timer->next;
+    }
+    *head = timer;
+    timer->pprev = head;
+}
+
+static
+void
+globus_l_callback_wheel_unlink(
+    globus_i_callback_wheel_t *         wheel,
+    globus_i_callback_timer_t *         timer)
+{
+    int                                 slot;
+
+    *timer->pprev = timer->next;
+    if(timer->next)
+    {
+        timer->next->pprev = timer->pprev;
+    }
+    else if(timer->level == GLOBUS_L_CALLBACK_WHEEL_DUE)
+    {
+        wheel->due_tail = timer->pprev;
+    }
+
+    if(timer->level >= 0)
+    {
+        slot = (timer->tick >> (timer->level * GLOBUS_L_CALLBACK_WHEEL_BITS))
+            & GLOBUS_L_CALLBACK_WHEEL_MASK;
+        if(!wheel->slots[timer->level][slot])
+        {
+            wheel->occupied[timer->level] &= ~((uint64_t) 1 << slot);
+        }
+    }
+    timer->level = GLOBUS_L_CALLBACK_WHEEL_NONE;
+}
+
+static
+void
+globus_l_callback_wheel_place(
+    globus_i_callback_wheel_t *         wheel,
+    globus_i_callback_timer_t *         timer)
+{
+    globus_i_callback_timer_t **        pprev;
+    uint64_t                            diff;
+    int                                 level;
+    int                                 slot;
+
+    if(timer->tick <= wheel->now)
+    {
+        /* keep the due list sorted by time, since the timers of a slot
+         * cascade in no particular order.  equal times stay in the order
+         * they came due
+         */
+        for(pprev = &wheel->due;
+            *pprev && globus_abstime_cmp(&(*pprev)->time, &timer->time) <= 0;
+            pprev = &(*pprev)->next)
+        {
+            /* find the first later timer */
+        }
+
+        timer->level = GLOBUS_L_CALLBACK_WHEEL_DUE;
+        timer->next = *pprev;
+        timer->pprev = pprev;
+        if(timer->next)
+        {
+            timer->next->pprev = &timer->next;
+        }
+        else
+        {
+            wheel->due_tail = &timer->next;
+        }
+        *pprev = timer;
+        return;
+    }
+
+    diff = timer->tick ^ wheel->now;
+    for(level = 0;
+        level < GLOBUS_I_CALLBACK_WHEEL_LEVELS &&
+            (diff >> ((level + 1) * GLOBUS_L_CALLBACK_WHEEL_BITS)) != 0;
+        level++)
+    {
+        /* find highest digit that differs */
+    }
+
+    if(level == GLOBUS_I_CALLBACK_WHEEL_LEVELS)
+    {
+        timer->level = GLOBUS_L_CALLBACK_WHEEL_FAR;
+        globus_l_callback_wheel_link(&wheel->far, timer);
+    }
+    else
+    {
+        slot = (timer->tick >> (level * GLOBUS_L_CALLBACK_WHEEL_BITS))
+            & GLOBUS_L_CALLBACK_WHEEL_MASK;
+        timer->level = level;
+        globus_l_callback_wheel_link(&wheel->slots[level][slot], timer);
+        wheel->occupied[level] |= (uint64_t) 1 << slot;
+    }
+}
+
+/*
+ * the first tick at which a slot (or the far list) needs to be looked at.
+ * returns GLOBUS_FALSE if there are no timers outside the due list
+ */
+static
+globus_bool_t
+globus_l_callback_wheel_next_tick(
+    globus_i_callback_wheel_t *         wheel,
+    uint64_t *                          tick,
+    int *                               level)
+{
+    int                                 i;
+    int                                 shift;
+
+    for(i = 0; i < GLOBUS_I_CALLBACK_WHEEL_LEVELS; i++)
+    {
+        if(wheel->occupied[i])
+        {
+            shift = i * GLOBUS_L_CALLBACK_WHEEL_BITS;
+            *tick = ((wheel->now >> (shift + GLOBUS_L_CALLBACK_WHEEL_BITS))
+                    << (shift + GLOBUS_L_CALLBACK_WHEEL_BITS)) |
+                ((uint64_t) globus_l_callback_wheel_first_slot(
+                    wheel->occupied[i]) << shift);
+            *level = i;
+            return GLOBUS_TRUE;
+        }
+    }
+
+    if(wheel->far)
+    {
+        *tick = ((wheel->now >> GLOBUS_L_CALLBACK_WHEEL_SPAN) + 1)
+            << GLOBUS_L_CALLBACK_WHEEL_SPAN;
+        *level = GLOBUS_I_CALLBACK_WHEEL_LEVELS;
+        return GLOBUS_TRUE;
+    }
+
+    return GLOBUS_FALSE;
+}
+
+/* place again every timer on a list that now has to move down */
+static
+void
+globus_l_callback_wheel_cascade(
+    globus_i_callback_wheel_t *         wheel,
+    globus_i_callback_timer_t *         list)
+{
+    globus_i_callback_timer_t *         timer;
+
+    while(list)
+    {
+        timer = list;
+        list = list->next;
+        globus_l_callback_wheel_place(wheel, timer);
+    }
+}
+
+/* move now forward to tick, skipping straight over empty slots */
+static
+void
+globus_l_callback_wheel_advance(
+    globus_i_callback_wheel_t *         wheel,
+    uint64_t                            tick)
+{
+    globus_i_callback_timer_t *         list;
+    uint64_t                            next;
+    int                                 level;
+    int                                 slot;
+    int                                 i;
+
+    while(wheel->now < tick)
+    {
+        if(!globus_l_callback_wheel_next_tick(wheel, &next, &level) ||
+            next > tick)
+        {
+            wheel->now = tick;
+            break;
+        }
+
+        wheel->now = next;
+        if(level == GLOBUS_I_CALLBACK_WHEEL_LEVELS)
+        {
+            list = wheel->far;
+            wheel->far = GLOBUS_NULL;
+            globus_l_callback_wheel_cascade(wheel, list);
+        }
+
+        for(i = GLOBUS_I_CALLBACK_WHEEL_LEVELS - 1; i >= 0; i--)
+        {
+            slot = (wheel->now >> (i * GLOBUS_L_CALLBACK_WHEEL_BITS))
+                & GLOBUS_L_CALLBACK_WHEEL_MASK;
+            list = wheel->slots[i][slot];
+            if(list)
+            {
+                wheel->slots[i][slot] = GLOBUS_NULL;
+                wheel->occupied[i] &= ~((uint64_t) 1 << slot);
+                globus_l_callback_wheel_cascade(wheel, list);
+            }
+        }
+    }
+}
+
+void
+globus_i_callback_wheel_init(
+    globus_i_callback_wheel_t *         wheel)
+{
+    globus_abstime_t                    time_now;
+    char *                              tmp_string;
+    int                                 rc;
+
+    memset(wheel, 0, sizeof(globus_i_callback_wheel_t));
+    wheel->due_tail = &wheel->due;
+    wheel->resolution = GLOBUS_L_CALLBACK_WHEEL_RESOLUTION;
+    wheel->coalesce = GLOBUS_FALSE;
+
+    tmp_string = globus_module_getenv("GLOBUS_CALLBACK_TIMER_COALESCE");
+    if(tmp_string)
+    {
+        rc = atoi(tmp_string);
+        if(rc > 0)
+        {
+            wheel->resolution = (uint64_t) rc * 1000;
+            wheel->coalesce = GLOBUS_TRUE;
+        }
+    }
+
+    GlobusTimeAbstimeGetCurrent(time_now);
+    wheel->now = globus_l_callback_wheel_usec(&time_now) / wheel->resolution;
+}
+
+void
+globus_i_callback_wheel_destroy(
+    globus_i_callback_wheel_t *         wheel)
+{
+    /* timers belong to their callbacks */
+    wheel->count = 0;
+}
+
+void
+globus_i_callback_wheel_enqueue(
+    globus_i_callback_wheel_t *         wheel,
+    globus_i_callback_timer_t *         timer,
+    void *                              datum,
+    const globus_abstime_t *            time)
+{
+    uint64_t                            usec;
+
+    GlobusTimeAbstimeCopy(timer->time, *time);
+    timer->datum = datum;
+
+    usec = globus_l_callback_wheel_usec(time);
+    if(wheel->coalesce)
+    {
+        /* round up, so nothing runs early */
+        timer->tick = (usec + wheel->resolution - 1) / wheel->resolution;
+    }
+    else
+    {
+        timer->tick = usec / wheel->resolution;
+    }
+
+    globus_l_callback_wheel_place(wheel, timer);
+    wheel->count++;
+}
+
+void
+globus_i_callback_wheel_remove(
+    globus_i_callback_wheel_t *         wheel,
+    globus_i_callback_timer_t *         timer)
+{
+    globus_l_callback_wheel_unlink(wheel, timer);
+    wheel->count--;
+}
+
+void
+globus_i_callback_wheel_modify(
+    globus_i_callback_wheel_t *         wheel,
+    globus_i_callback_timer_t *         timer,
+    const globus_abstime_t *            time)
+{
+    globus_i_callback_wheel_remove(wheel, timer);
+    globus_i_callback_wheel_enqueue(wheel, timer, timer->datum, time);
+}
+
+void *
+globus_i_callback_wheel_expire(
+    globus_i_callback_wheel_t *         wheel,
+    const globus_abstime_t *            time_now)
+{
+    globus_i_callback_timer_t *         timer;
+
+    if(wheel->count == 0)
+    {
+        return GLOBUS_NULL;
+    }
+
+    globus_l_callback_wheel_advance(
+        wheel, globus_l_callback_wheel_usec(time_now) / wheel->resolution);
+
+    /* with exact timers, the newest tick may hold some not yet due, all
+     * of them after the ones that are
+     */
+    timer = wheel->due;
+    if(timer && globus_abstime_cmp(&timer->time, time_now) <= 0)
+    {
+        globus_i_callback_wheel_remove(wheel, timer);
+
+        return timer->datum;
+    }
+
+    return GLOBUS_NULL;
+}
+
+const globus_abstime_t *
+globus_i_callback_wheel_next(
+    globus_i_callback_wheel_t *         wheel)
+{
+    globus_i_callback_timer_t *         timer;
+    const globus_abstime_t *            earliest;
+    uint64_t                            tick;
+    int                                 level;
+
+    earliest = GLOBUS_NULL;
+    if(wheel->due)
+    {
+        /* everything due is earlier than anything still on the wheel, and
+         * the due list is sorted
+         */
+        GlobusTimeAbstimeCopy(wheel->next_time, wheel->due->time);
+
+        return &wheel->next_time;
+    }
+    else if(!globus_l_callback_wheel_next_tick(wheel, &tick, &level))
+    {
+        return GLOBUS_NULL;
+    }
+    else if(level == 0 && !wheel->coalesce)
+    {
+        timer = wheel->slots[0][tick & GLOBUS_L_CALLBACK_WHEEL_MASK];
+    }
+    else
+    {
+        /* the start of the slot.  on waking there, its timers will have
+         * moved down and this will be more precise
+         */
+        globus_l_callback_wheel_abstime(wheel, tick, &wheel->next_time);
+
+        return &wheel->next_time;
+    }
+
+    for(; timer; timer = timer->next)
+    {
+        if(!earliest || globus_abstime_cmp(&timer->time, earliest) < 0)
+        {
+            earliest = &timer->time;
+        }
+    }
+    GlobusTimeAbstimeCopy(wheel->next_time, *earliest);
+
+    return &wheel->next_time;
+}
+
+#endif /* GLOBUS_DONT_DOCUMENT_INTERNAL */
@@ -18,12 +18,15 @@
 /********************************************************************
  *
  * This file implements the hashtable_t type, a lightweight chaining hashtable
+ * with a fixed number of chains, or optionally an open addressing table that
+ * grows as entries are added.
  *
  ********************************************************************/
 
 #include "globus_hashtable.h"
 #include "globus_libc.h"
 #include "globus_memory.h"
+#include <limits.h>
 
 #define GlobusLInsertNodeBefore(_node, _before)                             \
     do                                                                      \
@@ -52,8 +55,50 @@ typedef struct globus_l_hashtable_bucket_s
     globus_l_hashtable_bucket_entry_t * last;
 } globus_l_hashtable_bucket_t;
 
+/*
+ * the resizable table keeps its entries densely, in insertion order, and
+ * indexes them with a power of two array of slots probed Robin Hood style:
+ * an entry being inserted takes the slot of any entry that is closer to its
+ * home slot, so probe lengths stay short and even, and a lookup can stop as
+ * soon as it passes the distance its key would have been placed at.
+ * removing an entry shifts the following slots back rather than leaving a
+ * tombstone.  the dense array only holds a hole where a removed entry was,
+ * which keeps iteration positions stable until the holes are squeezed out
+ * the next time the array fills.
+ */
+#define GLOBUS_L_HASHTABLE_OPEN_MIN     8
+
+typedef struct
+{
+    void *                              key;
+    /* NULL if the entry was removed */
+    void *                              datum;
+    uint32_t                            hash;
+} globus_l_hashtable_open_entry_t;
+
+typedef struct
+{
+    uint32_t                            hash;
+    /* index into entries + 1, 0 if the slot is empty */
+    int                                 entry;
+} globus_l_hashtable_open_slot_t;
+
+typedef struct
+{
+    globus_l_hashtable_open_slot_t *    slots;
+    int                                 mask;
+    globus_l_hashtable_open_entry_t *   entries;
+    int                                 entries_size;
+    /* entries in use, including removed ones */
+    int                                 entries_used;
+    /* iterator position, -1 if unset or at an end */
+    int                                 current;
+} globus_l_hashtable_open_t;
+
 typedef struct globus_l_hashtable_s
 {
+    /* non-NULL if the table is resizable, and nothing below is used */
+    globus_l_hashtable_open_t *         open;
     int                                 size;
     int                                 load;
     globus_l_hashtable_bucket_t *       buckets;
@@ -65,6 +110,356 @@ typedef struct globus_l_hashtable_s
     globus_memory_t                     memory;
 } globus_l_hashtable_t;
 
+static
+uint32_t
+globus_l_hashtable_open_hash(
+    globus_l_hashtable_t *              itable,
+    void *                              key)
+{
+    uint64_t                            h;
+
+    /* spread whatever the user's function gives over all 32 bits */
+    h = (uint64_t) (unsigned) itable->hash_func(key, INT_MAX);
+    h *= 0x9e3779b97f4a7c15ULL;
+
+    return (uint32_t) (h >> 32);
+}
+
+static
+int
+globus_l_hashtable_open_find(
+    globus_l_hashtable_t *              itable,
+    void *                              key,
+    uint32_t                            hash)
+{
+    globus_l_hashtable_open_t *         open;
+    globus_l_hashtable_open_slot_t *    slot;
+    int                                 pos;
+    int                                 dist;
+
+    open = itable->open;
+    pos = hash & open->mask;
+    for(dist = 0; ; dist++)
+    {
+        slot = &open->slots[pos];
+        if(slot->entry == 0 ||
+            ((pos - (int) (slot->hash & open->mask)) & open->mask) < dist)
+        {
+            return -1;
+        }
+        if(slot->hash == hash &&
+            itable->keyeq_func(open->entries[slot->entry - 1].key, key))
+        {
+            return pos;
+        }
+        pos = (pos + 1) & open->mask;
+    }
+}
+
+static
+void
+globus_l_hashtable_open_place(
+    globus_l_hashtable_open_t *         open,
+    uint32_t                            hash,
+    int                                 entry)
+{
+    globus_l_hashtable_open_slot_t *    slot;
+    globus_l_hashtable_open_slot_t      tmp;
+    globus_l_hashtable_open_slot_t      cur;
+    int                                 pos;
+    int                                 dist;
+    int                                 slot_dist;
+
+    cur.hash = hash;
+    cur.entry = entry + 1;
+    pos = hash & open->mask;
+    for(dist = 0; ; dist++)
+    {
+        slot = &open->slots[pos];
+        if(slot->entry == 0)
+        {
+            *slot = cur;
+            return;
+        }
+        slot_dist = (pos - (int) (slot->hash & open->mask)) & open->mask;
+        if(slot_dist < dist)
+        {
+            tmp = *slot;
+            *slot = cur;
+            cur = tmp;
+            dist = slot_dist;
+        }
+        pos = (pos + 1) & open->mask;
+    }
+}
+
+/*
+ * squeeze removed entries out of the dense array and index the rest into
+ * slot_count slots.
+ */
+static
+int
+globus_l_hashtable_open_rebuild(
+    globus_l_hashtable_t *              itable,
+    int                                 slot_count)
+{
+    globus_l_hashtable_open_t *         open;
+    globus_l_hashtable_open_slot_t *    slots;
+    int                                 i;
+    int                                 used = 0;
+
+    open = itable->open;
+    slots = (globus_l_hashtable_open_slot_t *)
+        globus_calloc(slot_count, sizeof(globus_l_hashtable_open_slot_t));
+    if(!slots)
+    {
+        return GLOBUS_FAILURE;
+    }
+    globus_free(open->slots);
+    open->slots = slots;
+    open->mask = slot_count - 1;
+
+    for(i = 0; i < open->entries_used; i++)
+    {
+        if(open->entries[i].datum)
+        {
+            if(i == open->current)
+            {
+                open->current = used;
+            }
+            open->entries[used] = open->entries[i];
+            globus_l_hashtable_open_place(open, open->entries[used].hash, used);
+            used++;
+        }
+    }
+    open->entries_used = used;
+
+    return GLOBUS_SUCCESS;
+}
+
+static
+int
+globus_l_hashtable_open_init(
+    globus_l_hashtable_t *              itable,
+    int                                 size)
+{
+    globus_l_hashtable_open_t *         open;
+    int                                 slot_count;
+
+    open = (globus_l_hashtable_open_t *)
+        globus_calloc(1, sizeof(globus_l_hashtable_open_t));
+    if(!open)
+    {
+        goto error_open;
+    }
+
+    /* room for size entries below the 80% load the table grows at */
+    slot_count = GLOBUS_L_HASHTABLE_OPEN_MIN;
+    while(slot_count < size + size / 4 + 1 && slot_count < (1 << 30))
+    {
+        slot_count *= 2;
+    }
+    open->slots = (globus_l_hashtable_open_slot_t *)
+        globus_calloc(slot_count, sizeof(globus_l_hashtable_open_slot_t));
+    if(!open->slots)
+    {
+        goto error_slots;
+    }
+    open->mask = slot_count - 1;
+
+    open->entries_size = slot_count * 4 / 5;
+    open->entries = (globus_l_hashtable_open_entry_t *) globus_malloc(
+        open->entries_size * sizeof(globus_l_hashtable_open_entry_t));
+    if(!open->entries)
+    {
+        goto error_entries;
+    }
+    open->entries_used = 0;
+    open->current = -1;
+
+    itable->open = open;
+    return GLOBUS_SUCCESS;
+
+error_entries:
+    globus_free(open->slots);
+error_slots:
+    globus_free(open);
+error_open:
+    return GLOBUS_FAILURE;
+}
+
+static
+void
+globus_l_hashtable_open_destroy(
+    globus_l_hashtable_t *              itable)
+{
+    globus_free(itable->open->entries);
+    globus_free(itable->open->slots);
+    globus_free(itable->open);
+}
+
+static
+int
+globus_l_hashtable_open_insert(
+    globus_l_hashtable_t *              itable,
+    void *                              key,
+    void *                              datum)
+{
+    globus_l_hashtable_open_t *         open;
+    globus_l_hashtable_open_entry_t *   entries;
+    int                                 slot_count;
+    int                                 size;
+    uint32_t                            hash;
+
+    open = itable->open;
+    hash = globus_l_hashtable_open_hash(itable, key);
+    if(globus_l_hashtable_open_find(itable, key, hash) >= 0)
+    {
+        return GLOBUS_FAILURE;
+    }
+
+    if(open->entries_used == open->entries_size)
+    {
+        /* grow unless squeezing out removed entries frees enough room */
+        slot_count = open->mask + 1;
+        if(itable->load + itable->load / 8 + 1 > open->entries_size)
+        {
+            slot_count *= 2;
+        }
+        size = slot_count * 4 / 5;
+        if(size > open->entries_size)
+        {
+            entries = (globus_l_hashtable_open_entry_t *) globus_realloc(
+                open->entries,
+                size * sizeof(globus_l_hashtable_open_entry_t));
+            if(!entries)
+            {
+                return GLOBUS_FAILURE;
+            }
+            open->entries = entries;
+            open->entries_size = size;
+        }
+        if(globus_l_hashtable_open_rebuild(itable, slot_count)
+            != GLOBUS_SUCCESS)
+        {
+            return GLOBUS_FAILURE;
+        }
+    }
+
+    open->entries[open->entries_used].key = key;
+    open->entries[open->entries_used].datum = datum;
+    open->entries[open->entries_used].hash = hash;
+    globus_l_hashtable_open_place(open, hash, open->entries_used);
+    open->entries_used++;
+    itable->load++;
+
+    return GLOBUS_SUCCESS;
+}
+
+static
+globus_l_hashtable_open_entry_t *
+globus_l_hashtable_open_lookup(
+    globus_l_hashtable_t *              itable,
+    void *                              key)
+{
+    int                                 pos;
+
+    pos = globus_l_hashtable_open_find(
+        itable, key, globus_l_hashtable_open_hash(itable, key));
+    if(pos < 0)
+    {
+        return GLOBUS_NULL;
+    }
+
+    return &itable->open->entries[itable->open->slots[pos].entry - 1];
+}
+
+static
+void *
+globus_l_hashtable_open_remove(
+    globus_l_hashtable_t *              itable,
+    void *                              key)
+{
+    globus_l_hashtable_open_t *         open;
+    globus_l_hashtable_open_entry_t *   entry;
+    int                                 pos;
+    int                                 next;
+    int                                 index;
+    void *                              datum;
+
+    open = itable->open;
+    pos = globus_l_hashtable_open_find(
+        itable, key, globus_l_hashtable_open_hash(itable, key));
+    if(pos < 0)
+    {
+        return GLOBUS_NULL;
+    }
+    index = open->slots[pos].entry - 1;
+
+    /* pull the rest of the cluster back one slot over the hole */
+    next = (pos + 1) & open->mask;
+    while(open->slots[next].entry != 0 &&
+        (open->slots[next].hash & open->mask) != (uint32_t) next)
+    {
+        open->slots[pos] = open->slots[next];
+        pos = next;
+        next = (next + 1) & open->mask;
+    }
+    open->slots[pos].entry = 0;
+
+    entry = &open->entries[index];
+    datum = entry->datum;
+    entry->datum = GLOBUS_NULL;
+    entry->key = GLOBUS_NULL;
+    itable->load--;
+
+    if(index == open->current)
+    {
+        do
+        {
+            open->current++;
+        } while(open->current < open->entries_used &&
+            !open->entries[open->current].datum);
+        if(open->current == open->entries_used)
+        {
+            open->current = -1;
+        }
+    }
+    while(open->entries_used > 0 &&
+        !open->entries[open->entries_used - 1].datum)
+    {
+        open->entries_used--;
+    }
+
+    return datum;
+}
+
+/* move the iterator from start by step to the next entry, or off the end */
+static
+void *
+globus_l_hashtable_open_seek(
+    globus_l_hashtable_t *              itable,
+    int                                 start,
+    int                                 step)
+{
+    globus_l_hashtable_open_t *         open;
+
+    open = itable->open;
+    while(start >= 0 && start < open->entries_used &&
+        !open->entries[start].datum)
+    {
+        start += step;
+    }
+    if(start < 0 || start >= open->entries_used)
+    {
+        open->current = -1;
+        return GLOBUS_NULL;
+    }
+    open->current = start;
+
+    return open->entries[start].datum;
+}
+
 /**
  * @brief Initialize a hash table
  * @ingroup globus_hashtable
@@ -116,6 +511,7 @@ globus_hashtable_init(
         goto error_memory_init;
     }
     
+    itable->open = GLOBUS_NULL;
     itable->size = size;
     itable->load = 0;
     itable->first = GLOBUS_NULL;
@@ -149,6 +545,120 @@ error_parm:
     return GLOBUS_FAILURE;
 }
 
+/**
+ * @brief Initialize a resizable hash table
+ * @ingroup globus_hashtable
+ * @details
+ * Initializes an open addressing hashtable to represent an empty mapping and
+ * returns zero, or returns non-zero on failure.  The table behaves like one
+ * created with globus_hashtable_init() and is used with the same functions,
+ * but it grows as mappings are added, so the size parameter is only the
+ * number of mappings to make room for up front.  Lookups in a resizable
+ * table stay fast however large it gets, and inserting and removing mappings
+ * allocates nothing except when the table grows.  Iteration is in insertion
+ * order.
+ *
+ * The hash_func is called with a limit of INT_MAX and should return values
+ * spread over that range; the table mixes the result further itself.
+ */
+int
+globus_hashtable_init_resizable(
+    globus_hashtable_t *                table,
+    int                                 size,
+    globus_hashtable_hash_func_t        hash_func,
+    globus_hashtable_keyeq_func_t       keyeq_func)
+{
+    globus_l_hashtable_t *              itable;
+
+    if(table == GLOBUS_NULL ||
+        hash_func == GLOBUS_NULL ||
+        keyeq_func == GLOBUS_NULL ||
+        size < 0)
+    {
+        goto error_parm;
+    }
+
+    itable = (globus_l_hashtable_t *)
+        globus_calloc(1, sizeof(globus_l_hashtable_t));
+    if(!itable)
+    {
+        goto error_malloc_table;
+    }
+
+    itable->hash_func = hash_func;
+    itable->keyeq_func = keyeq_func;
+    if(globus_l_hashtable_open_init(itable, size) != GLOBUS_SUCCESS)
+    {
+        goto error_open_init;
+    }
+
+    *table = itable;
+    return GLOBUS_SUCCESS;
+
+error_open_init:
+    globus_free(itable);
+
+error_malloc_table:
+error_parm:
+    if(table)
+    {
+        *table = GLOBUS_NULL;
+    }
+    globus_assert(0 && "globus_hashtable_init_resizable failed");
+    return GLOBUS_FAILURE;
+}
+
+static
+int
+globus_l_hashtable_open_copy(
+    globus_hashtable_t *                dest_table,
+    globus_l_hashtable_t *              src_itable,
+    globus_hashtable_copy_func_t        copy_func)
+{
+    globus_l_hashtable_open_entry_t *   src_entry;
+    void *                              key;
+    void *                              datum;
+    int                                 i;
+
+    if(globus_hashtable_init_resizable(
+        dest_table,
+        src_itable->load,
+        src_itable->hash_func,
+        src_itable->keyeq_func) != GLOBUS_SUCCESS)
+    {
+        goto error_init;
+    }
+
+    for(i = 0; i < src_itable->open->entries_used; i++)
+    {
+        src_entry = &src_itable->open->entries[i];
+        if(!src_entry->datum)
+        {
+            continue;
+        }
+        key = src_entry->key;
+        datum = src_entry->datum;
+        if(copy_func)
+        {
+            copy_func(&key, &datum, src_entry->key, src_entry->datum);
+        }
+        if(globus_l_hashtable_open_insert(*dest_table, key, datum)
+            != GLOBUS_SUCCESS)
+        {
+            goto error_insert;
+        }
+    }
+
+    return GLOBUS_SUCCESS;
+
+error_insert:
+    globus_hashtable_destroy(dest_table);
+
+error_init:
+    *dest_table = GLOBUS_NULL;
+    return GLOBUS_FAILURE;
+}
+
 /* XXX if there is a failure mid copy, cant free user's datum */
 int
 globus_hashtable_copy(
@@ -171,6 +681,11 @@ globus_hashtable_copy(
     }
     
     src_itable = *src_table;
+    if(src_itable->open)
+    {
+        return globus_l_hashtable_open_copy(
+            dest_table, src_itable, copy_func);
+    }
     
     if(globus_hashtable_init(
         dest_table,
@@ -310,6 +825,10 @@ globus_hashtable_insert(
     }
     
     itable = *table;
+    if(itable->open)
+    {
+        return globus_l_hashtable_open_insert(itable, key, datum);
+    }
     bucket = &itable->buckets[itable->hash_func(key, itable->size)];
     
     /* make sure it doesn't already exist */
@@ -382,6 +901,7 @@ globus_hashtable_update(
     globus_l_hashtable_t *              itable;
     globus_l_hashtable_bucket_t *       bucket;
     globus_l_hashtable_bucket_entry_t * entry;
+    globus_l_hashtable_open_entry_t *   open_entry;
     void *                              old_datum;
     
     if(!table || !*table || !datum)
@@ -391,6 +911,19 @@ globus_hashtable_update(
     }
     
     itable = *table;
+    if(itable->open)
+    {
+        open_entry = globus_l_hashtable_open_lookup(itable, key);
+        if(!open_entry)
+        {
+            goto error_notfound;
+        }
+        old_datum = open_entry->datum;
+        open_entry->datum = datum;
+        open_entry->key = key;
+
+        return old_datum;
+    }
     bucket = &itable->buckets[itable->hash_func(key, itable->size)];
     
     entry = globus_l_hashtable_search_bucket(bucket, itable->keyeq_func, key);
@@ -435,6 +968,13 @@ globus_hashtable_lookup(
     }
     
     itable = *table;
+    if(itable->open)
+    {
+        globus_l_hashtable_open_entry_t *   open_entry;
+
+        open_entry = globus_l_hashtable_open_lookup(itable, key);
+        return open_entry ? open_entry->datum : GLOBUS_NULL;
+    }
     bucket = &itable->buckets[itable->hash_func(key, itable->size)];
     
     entry = globus_l_hashtable_search_bucket(bucket, itable->keyeq_func, key);
@@ -476,6 +1016,10 @@ globus_hashtable_remove(
     }
     
     itable = *table;
+    if(itable->open)
+    {
+        return globus_l_hashtable_open_remove(itable, key);
+    }
     bucket = &itable->buckets[itable->hash_func(key, itable->size)];
     
     entry = globus_l_hashtable_search_bucket(bucket, itable->keyeq_func, key);
@@ -557,6 +1101,19 @@ globus_hashtable_to_list(
     itable = *table;
     entry = itable->first;
     *list = GLOBUS_NULL;
+
+    if(itable->open)
+    {
+        int                             i;
+
+        for(i = 0; i < itable->open->entries_used; i++)
+        {
+            if(itable->open->entries[i].datum)
+            {
+                globus_list_insert(list, itable->open->entries[i].datum);
+            }
+        }
+    }
     
     while(entry)
     {
@@ -581,7 +1138,7 @@ globus_hashtable_empty(
     globus_hashtable_t *                table)
 {
     return ((!table || !*table || 
-        (*table)->first == GLOBUS_NULL) ? GLOBUS_TRUE : GLOBUS_FALSE);
+        (*table)->load == 0) ? GLOBUS_TRUE : GLOBUS_FALSE);
 }
 
 /**
@@ -621,6 +1178,10 @@ globus_hashtable_first(
     }
     
     itable = *table;
+    if(itable->open)
+    {
+        return globus_l_hashtable_open_seek(itable, 0, 1);
+    }
     itable->current = itable->first;
     
     return (itable->current ? itable->current->datum : GLOBUS_NULL);
@@ -648,6 +1209,15 @@ globus_hashtable_next(
     }
     
     itable = *table;
+    if(itable->open)
+    {
+        if(itable->open->current < 0)
+        {
+            return GLOBUS_NULL;
+        }
+        return globus_l_hashtable_open_seek(
+            itable, itable->open->current + 1, 1);
+    }
     if(itable->current)
     {
         itable->current = itable->current->next;
@@ -678,6 +1248,11 @@ globus_hashtable_last(
     }
     
     itable = *table;
+    if(itable->open)
+    {
+        return globus_l_hashtable_open_seek(
+            itable, itable->open->entries_used - 1, -1);
+    }
     itable->current = itable->last;
     
     return (itable->current ? itable->current->datum : GLOBUS_NULL);
@@ -705,6 +1280,15 @@ globus_hashtable_prev(
     }
     
     itable = *table;
+    if(itable->open)
+    {
+        if(itable->open->current < 0)
+        {
+            return GLOBUS_NULL;
+        }
+        return globus_l_hashtable_open_seek(
+            itable, itable->open->current - 1, -1);
+    }
     if(itable->current)
     {
         itable->current = itable->current->prev;
@@ -741,6 +1325,14 @@ globus_hashtable_destroy(
     }
     
     itable = *table;
+    if(itable->open)
+    {
+        globus_l_hashtable_open_destroy(itable);
+        globus_free(itable);
+        *table = GLOBUS_NULL;
+
+        return GLOBUS_SUCCESS;
+    }
     entry = itable->first;
     
     while(entry)
@@ -780,6 +1372,18 @@ globus_hashtable_destroy_all(
     itable = *table;
     entry = itable->first;
     
+    if(itable->open)
+    {
+        int                             i;
+
+        for(i = 0; i < itable->open->entries_used; i++)
+        {
+            if(itable->open->entries[i].datum)
+            {
+                element_free(itable->open->entries[i].datum);
+            }
+        }
+    }
     while(entry)
     {
         element_free(entry->datum);
@@ -98,6 +98,13 @@ globus_hashtable_init(
     globus_hashtable_hash_func_t        hash_func,
     globus_hashtable_keyeq_func_t       keyeq_func);
 
+int
+globus_hashtable_init_resizable(
+    globus_hashtable_t *                table,
+    int                                 size,
+    globus_hashtable_hash_func_t        hash_func,
+    globus_hashtable_keyeq_func_t       keyeq_func);
+
 int
 globus_hashtable_copy(
     globus_hashtable_t *                dest_table,
@@ -152,6 +159,10 @@ globus_hashtable_size(
  * Once an 'end' has been reached with globus_hashtable_next() or
  * globus_hashtable_prev(), the iterator must again be reset with 
  * globus_hashtable_first() or globus_hashtable_last() before being used.
+ *
+ * Tables created with globus_hashtable_init_resizable() are iterated in
+ * insertion order, and may grow if entries are inserted while iterating;
+ * the iterator keeps its place when they do.
  */
 void *
 globus_hashtable_first(
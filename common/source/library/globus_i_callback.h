@@ -155,5 +155,88 @@ extern globus_module_descriptor_t globus_i_callback_module_threaded;
             *tmp = (*tmp)->next;                                            \
         }                                                                   \
     } while(0)
-    
+
+/* timed callback queue, shared by both callback implementations.  this is
+ * a hierarchical timing wheel: each level has 64 slots, each slot 64 times
+ * longer than one on the level below, so inserting and removing a timer
+ * take constant time.  timers expire at their exact time unless
+ * GLOBUS_CALLBACK_TIMER_COALESCE is set to a number of milliseconds, in
+ * which case they are rounded up to a multiple of that.
+ *
+ * the space lock should be held around any of these calls
+ */
+#define GLOBUS_I_CALLBACK_WHEEL_LEVELS 6
+#define GLOBUS_I_CALLBACK_WHEEL_SLOTS 64
+
+typedef struct globus_i_callback_timer_s
+{
+    struct globus_i_callback_timer_s *  next;
+    struct globus_i_callback_timer_s ** pprev;
+    globus_abstime_t                    time;
+    uint64_t                            tick;
+    void *                              datum;
+    int                                 level;
+} globus_i_callback_timer_t;
+
+typedef struct
+{
+    globus_i_callback_timer_t *         slots[GLOBUS_I_CALLBACK_WHEEL_LEVELS]
+                                            [GLOBUS_I_CALLBACK_WHEEL_SLOTS];
+    uint64_t                            occupied[
+                                            GLOBUS_I_CALLBACK_WHEEL_LEVELS];
+    /* timers whose tick has passed, sorted by time */
+    globus_i_callback_timer_t *         due;
+    globus_i_callback_timer_t **        due_tail;
+    /* timers too far out for the top level */
+    globus_i_callback_timer_t *         far;
+    uint64_t                            now;
+    uint64_t                            resolution;
+    globus_bool_t                       coalesce;
+    int                                 count;
+    globus_abstime_t                    next_time;
+} globus_i_callback_wheel_t;
+
+void
+globus_i_callback_wheel_init(
+    globus_i_callback_wheel_t *         wheel);
+
+void
+globus_i_callback_wheel_destroy(
+    globus_i_callback_wheel_t *         wheel);
+
+void
+globus_i_callback_wheel_enqueue(
+    globus_i_callback_wheel_t *         wheel,
+    globus_i_callback_timer_t *         timer,
+    void *                              datum,
+    const globus_abstime_t *            time);
+
+void
+globus_i_callback_wheel_remove(
+    globus_i_callback_wheel_t *         wheel,
+    globus_i_callback_timer_t *         timer);
+
+void
+globus_i_callback_wheel_modify(
+    globus_i_callback_wheel_t *         wheel,
+    globus_i_callback_timer_t *         timer,
+    const globus_abstime_t *            time);
+
+#define globus_i_callback_wheel_empty(wheel) ((wheel)->count == 0)
+
+/* returns the datum of a timer due at or before time_now, removing it, or
+ * NULL if there is none
+ */
+void *
+globus_i_callback_wheel_expire(
+    globus_i_callback_wheel_t *         wheel,
+    const globus_abstime_t *            time_now);
+
+/* returns a time no later than that of the next timer to expire, or NULL
+ * if there are none.  the result is good until the wheel is next changed
+ */
+const globus_abstime_t *
+globus_i_callback_wheel_next(
+    globus_i_callback_wheel_t *         wheel);
+
 #endif /* GLOBUS_I_CALLBACK_H */
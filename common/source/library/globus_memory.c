@@ -29,6 +29,44 @@
 #include "globus_list.h"
 
 
+#ifndef GLOBUS_MEMORY_DEBUG_LEAKS
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+/*
+ * Nodes are handed out from per-thread magazines: small stacks owned by a
+ * pool, one per thread index, that are popped and pushed without taking the
+ * pool lock.  A magazine that runs empty refills from the depot, a few slots
+ * holding chains of nodes that threads swap in and out with single atomic
+ * operations; a full magazine flushes to the depot the same way.  Only when
+ * the depot is empty (or full) does a thread take the pool lock to use the
+ * free list.  If that is empty too, the nodes left in other threads'
+ * magazines are taken back before the pool grows by another slab.  A
+ * magazine holds at most a quarter of a slab, so small pools aren't spread
+ * thin across threads.
+ *
+ * Magazines are only used when atomics are available and the process is
+ * threaded, otherwise every node comes from the locked free list as before.
+ */
+#if defined(__GNUC__) && defined(__ATOMIC_ACQUIRE)
+#define GLOBUS_L_MEMORY_MAGAZINES       64
+#endif
+/* with the busy flag and count, 15 nodes make a magazine two cache lines */
+#define GLOBUS_L_MEMORY_MAGAZINE_SIZE   15
+#define GLOBUS_L_MEMORY_DEPOT_SIZE      16
+/* slabs at least this big may be backed by huge pages */
+#define GLOBUS_L_MEMORY_HUGE_SIZE       (2 * 1024 * 1024)
+
+typedef struct
+{
+    int                                         busy;
+    int                                         count;
+    globus_byte_t *                             nodes[
+                                        GLOBUS_L_MEMORY_MAGAZINE_SIZE];
+} globus_l_memory_magazine_t;
+#endif
+
 /*
  * data structures hidden from user
  */
@@ -36,7 +74,6 @@ struct globus_memory_s
 {
     int                                         total_size;
     int                                         node_size;
-    int                                         nodes_used;
     int                                         node_count;
     int                                         node_count_per_malloc;
 
@@ -47,6 +84,14 @@ struct globus_memory_s
     globus_byte_t **                            free_ptrs;
     int                                         free_ptrs_size;
     int                                         free_ptrs_offset;
+#ifndef GLOBUS_MEMORY_DEBUG_LEAKS
+    /* slabs were mmap()ed rather than malloc()ed */
+    globus_bool_t                               mapped;
+    globus_l_memory_magazine_t *                magazines;
+    int                                         magazine_size;
+    globus_byte_t *                             depot[
+                                        GLOBUS_L_MEMORY_DEPOT_SIZE];
+#endif
 };
 
 #ifndef GLOBUS_MEMORY_DEBUG_LEAKS 
@@ -57,6 +102,7 @@ typedef struct globus_l_memory_header_s
 } globus_l_memory_header_t;
 
 static globus_mutex_t                      globus_i_memory_mutex;
+static globus_bool_t                       globus_l_memory_hugepages;
 
 #define I_ALIGN_SIZE                8 /* wastes a little memory, but is safe */
 #define DEFAULT_FREE_PTRS_SIZE      16
@@ -64,9 +110,17 @@ static globus_mutex_t                      globus_i_memory_mutex;
 globus_bool_t
 globus_i_memory_pre_activate(void)
 {
+    char *                                      tmp_string;
+
     globus_mutex_init(
         &globus_i_memory_mutex,
         GLOBUS_NULL);
+
+    tmp_string = getenv("GLOBUS_MEMORY_HUGEPAGES");
+    globus_l_memory_hugepages =
+        (tmp_string != GLOBUS_NULL && *tmp_string != '\0' &&
+            strcmp(tmp_string, "0") != 0);
+
     return globus_i_list_pre_activate();
 }
 
@@ -75,6 +129,281 @@ globus_bool_t
 globus_l_memory_create_list(
     globus_memory_t *           mem_info);
 
+#ifdef GLOBUS_L_MEMORY_MAGAZINES
+static globus_thread_once_t             globus_l_memory_key_once =
+                                            GLOBUS_THREAD_ONCE_INIT;
+static globus_thread_key_t              globus_l_memory_key;
+static int                              globus_l_memory_thread_count;
+
+static
+void
+globus_l_memory_key_init(void)
+{
+    globus_thread_key_create(&globus_l_memory_key, NULL);
+}
+
+/*
+ * each thread gets the next index the first time it uses any pool, so up to
+ * GLOBUS_L_MEMORY_MAGAZINES threads each have a magazine to themselves.
+ * past that, threads share and fall back to the lock when they collide.
+ */
+static
+globus_l_memory_magazine_t *
+globus_l_memory_magazine(
+    struct globus_memory_s *                    s_mem_info)
+{
+    globus_l_memory_magazine_t *                magazines;
+    intptr_t                                    index;
+
+    magazines = __atomic_load_n(&s_mem_info->magazines, __ATOMIC_ACQUIRE);
+    if(magazines == GLOBUS_NULL)
+    {
+        if(globus_i_am_only_thread())
+        {
+            return GLOBUS_NULL;
+        }
+        globus_mutex_lock(&s_mem_info->lock);
+        {
+            magazines = s_mem_info->magazines;
+            if(magazines == GLOBUS_NULL)
+            {
+                magazines = globus_calloc(
+                    GLOBUS_L_MEMORY_MAGAZINES,
+                    sizeof(globus_l_memory_magazine_t));
+                __atomic_store_n(
+                    &s_mem_info->magazines, magazines, __ATOMIC_RELEASE);
+            }
+        }
+        globus_mutex_unlock(&s_mem_info->lock);
+        if(magazines == GLOBUS_NULL)
+        {
+            return GLOBUS_NULL;
+        }
+    }
+
+    globus_thread_once(&globus_l_memory_key_once, globus_l_memory_key_init);
+    index = (intptr_t) globus_thread_getspecific(globus_l_memory_key);
+    if(index == 0)
+    {
+        index = __atomic_add_fetch(
+            &globus_l_memory_thread_count, 1, __ATOMIC_RELAXED);
+        globus_thread_setspecific(globus_l_memory_key, (void *) index);
+    }
+
+    return &magazines[(index - 1) % GLOBUS_L_MEMORY_MAGAZINES];
+}
+
+static
+globus_bool_t
+globus_l_memory_magazine_acquire(
+    globus_l_memory_magazine_t *                magazine)
+{
+    return __atomic_exchange_n(&magazine->busy, 1, __ATOMIC_ACQUIRE) == 0;
+}
+
+static
+void
+globus_l_memory_magazine_release(
+    globus_l_memory_magazine_t *                magazine)
+{
+    __atomic_store_n(&magazine->busy, 0, __ATOMIC_RELEASE);
+}
+
+/*
+ * depot slots are only ever swapped with NULL, or filled when NULL, so a
+ * chain can't be taken twice or lost to a slot that was reused meanwhile.
+ */
+static
+globus_byte_t *
+globus_l_memory_depot_take(
+    struct globus_memory_s *                    s_mem_info)
+{
+    globus_byte_t *                             chain;
+    int                                         i;
+
+    for(i = 0; i < GLOBUS_L_MEMORY_DEPOT_SIZE; i++)
+    {
+        if(__atomic_load_n(&s_mem_info->depot[i], __ATOMIC_RELAXED) &&
+            (chain = __atomic_exchange_n(
+                &s_mem_info->depot[i], GLOBUS_NULL, __ATOMIC_ACQUIRE)))
+        {
+            return chain;
+        }
+    }
+
+    return GLOBUS_NULL;
+}
+
+static
+globus_bool_t
+globus_l_memory_depot_put(
+    struct globus_memory_s *                    s_mem_info,
+    globus_byte_t *                             chain)
+{
+    globus_byte_t *                             expected;
+    int                                         i;
+
+    for(i = 0; i < GLOBUS_L_MEMORY_DEPOT_SIZE; i++)
+    {
+        expected = GLOBUS_NULL;
+        if(__atomic_load_n(&s_mem_info->depot[i], __ATOMIC_RELAXED) ==
+                GLOBUS_NULL &&
+            __atomic_compare_exchange_n(
+                &s_mem_info->depot[i], &expected, chain, GLOBUS_FALSE,
+                __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        {
+            return GLOBUS_TRUE;
+        }
+    }
+
+    return GLOBUS_FALSE;
+}
+
+/*
+ * this is called locked, with the free list empty.  moves the nodes in the
+ * depot and in every magazine not in use onto the free list, so that nodes
+ * pushed by other threads, or by threads that have exited, are used before
+ * the pool grows.  a magazine in use is skipped; its owner may be waiting
+ * for the lock.
+ */
+static
+void
+globus_l_memory_magazine_drain(
+    struct globus_memory_s *                    s_mem_info)
+{
+    globus_l_memory_magazine_t *                magazines;
+    globus_l_memory_magazine_t *                magazine;
+    globus_l_memory_header_t *                  header;
+    globus_byte_t *                             chain;
+    int                                         i;
+
+    while((chain = globus_l_memory_depot_take(s_mem_info)) != GLOBUS_NULL)
+    {
+        header = (globus_l_memory_header_t *) chain;
+        while(header->next != GLOBUS_NULL)
+        {
+            header = (globus_l_memory_header_t *) header->next;
+        }
+        header->next = s_mem_info->first;
+        s_mem_info->first = chain;
+    }
+
+    magazines = __atomic_load_n(&s_mem_info->magazines, __ATOMIC_ACQUIRE);
+    if(magazines == GLOBUS_NULL)
+    {
+        return;
+    }
+    for(i = 0; i < GLOBUS_L_MEMORY_MAGAZINES; i++)
+    {
+        magazine = &magazines[i];
+        if(!globus_l_memory_magazine_acquire(magazine))
+        {
+            continue;
+        }
+        while(magazine->count > 0)
+        {
+            header = (globus_l_memory_header_t *)
+                magazine->nodes[--magazine->count];
+            header->next = s_mem_info->first;
+            s_mem_info->first = (globus_byte_t *) header;
+        }
+        globus_l_memory_magazine_release(magazine);
+    }
+}
+
+/*
+ * fill an empty magazine from the depot, or from the free list if the depot
+ * is empty.  nodes are stacked so that they pop in list order.
+ */
+static
+void
+globus_l_memory_magazine_fill(
+    struct globus_memory_s *                    s_mem_info,
+    globus_l_memory_magazine_t *                magazine)
+{
+    globus_l_memory_header_t *                  header;
+    globus_byte_t *                             chain;
+    globus_byte_t *                             nodes[
+                                        GLOBUS_L_MEMORY_MAGAZINE_SIZE];
+    int                                         count = 0;
+
+    chain = globus_l_memory_depot_take(s_mem_info);
+    if(chain != GLOBUS_NULL)
+    {
+        while(chain != GLOBUS_NULL && count < s_mem_info->magazine_size)
+        {
+            header = (globus_l_memory_header_t *) chain;
+            nodes[count++] = chain;
+            chain = header->next;
+        }
+    }
+    else
+    {
+        globus_mutex_lock(&s_mem_info->lock);
+        {
+            if(s_mem_info->first == GLOBUS_NULL &&
+                !s_mem_info->destroyed)
+            {
+                globus_l_memory_magazine_drain(s_mem_info);
+            }
+            if(s_mem_info->first == GLOBUS_NULL &&
+                !s_mem_info->destroyed)
+            {
+                s_mem_info->node_count += s_mem_info->node_count_per_malloc;
+                globus_l_memory_create_list(&s_mem_info);
+            }
+            while(s_mem_info->first != GLOBUS_NULL &&
+                count < s_mem_info->magazine_size)
+            {
+                header = (globus_l_memory_header_t *) s_mem_info->first;
+                nodes[count++] = s_mem_info->first;
+                s_mem_info->first = header->next;
+            }
+        }
+        globus_mutex_unlock(&s_mem_info->lock);
+    }
+
+    while(count > 0)
+    {
+        magazine->nodes[magazine->count++] = nodes[--count];
+    }
+}
+
+/*
+ * hand every node in a full magazine to the depot as one chain, or to the
+ * free list if the depot is full.
+ */
+static
+void
+globus_l_memory_magazine_flush(
+    struct globus_memory_s *                    s_mem_info,
+    globus_l_memory_magazine_t *                magazine)
+{
+    globus_l_memory_header_t *                  header;
+    int                                         i;
+
+    for(i = magazine->count - 1; i > 0; i--)
+    {
+        header = (globus_l_memory_header_t *) magazine->nodes[i];
+        header->next = magazine->nodes[i - 1];
+    }
+    header = (globus_l_memory_header_t *) magazine->nodes[0];
+    header->next = GLOBUS_NULL;
+
+    if(!globus_l_memory_depot_put(
+        s_mem_info, magazine->nodes[magazine->count - 1]))
+    {
+        globus_mutex_lock(&s_mem_info->lock);
+        {
+            header->next = s_mem_info->first;
+            s_mem_info->first = magazine->nodes[magazine->count - 1];
+        }
+        globus_mutex_unlock(&s_mem_info->lock);
+    }
+    magazine->count = 0;
+}
+#endif /* GLOBUS_L_MEMORY_MAGAZINES */
+
 /**
  * @brief Initialize memory pool
  * @ingroup globus_memory
@@ -114,7 +443,6 @@ globus_memory_init(
 
     s_mem_info->node_size = node_size + pad;
     s_mem_info->node_count = node_count;
-    s_mem_info->nodes_used = 0;
     s_mem_info->node_count_per_malloc = node_count;
     s_mem_info->free_ptrs_size = DEFAULT_FREE_PTRS_SIZE;
     s_mem_info->free_ptrs = (globus_byte_t **)malloc(DEFAULT_FREE_PTRS_SIZE * 
@@ -125,11 +453,97 @@ globus_memory_init(
         &s_mem_info->lock,
         (globus_mutexattr_t *) GLOBUS_NULL);
     s_mem_info->destroyed = GLOBUS_FALSE;
+    s_mem_info->magazines = GLOBUS_NULL;
+    s_mem_info->magazine_size = node_count / 4;
+    if(s_mem_info->magazine_size < 1)
+    {
+        s_mem_info->magazine_size = 1;
+    }
+    else if(s_mem_info->magazine_size > GLOBUS_L_MEMORY_MAGAZINE_SIZE)
+    {
+        s_mem_info->magazine_size = GLOBUS_L_MEMORY_MAGAZINE_SIZE;
+    }
+    memset(s_mem_info->depot, 0, sizeof(s_mem_info->depot));
+
+    s_mem_info->mapped = GLOBUS_FALSE;
+#if defined(__linux__)
+    s_mem_info->mapped = globus_l_memory_hugepages &&
+        s_mem_info->total_size >= GLOBUS_L_MEMORY_HUGE_SIZE;
+#endif
 
     return(globus_l_memory_create_list(
 				mem_info)); 
 }
 
+/*
+ * with GLOBUS_MEMORY_HUGEPAGES set, large slabs are mapped from the huge
+ * page pool if the system has one reserved, otherwise transparent huge pages
+ * are requested for them.  either way the pages are placed on the NUMA node
+ * of the thread that grows the pool, which touches every node as it links
+ * the new slab into the free list.
+ */
+static
+globus_byte_t *
+globus_l_memory_slab_alloc(
+    struct globus_memory_s *                    s_mem_info)
+{
+#if defined(__linux__)
+    void *                                      slab;
+    size_t                                      size;
+
+    if(s_mem_info->mapped)
+    {
+        size = (size_t) s_mem_info->total_size;
+        slab = MAP_FAILED;
+#ifdef MAP_HUGETLB
+        if(size % GLOBUS_L_MEMORY_HUGE_SIZE == 0)
+        {
+            slab = mmap(
+                NULL, size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        }
+#endif
+        if(slab == MAP_FAILED)
+        {
+            slab = mmap(
+                NULL, size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if(slab == MAP_FAILED)
+            {
+                return GLOBUS_NULL;
+            }
+#ifdef MADV_HUGEPAGE
+            madvise(slab, size, MADV_HUGEPAGE);
+#endif
+        }
+        return slab;
+    }
+#endif
+
+    return globus_malloc(
+        s_mem_info->node_size * s_mem_info->node_count_per_malloc);
+}
+
+static
+void
+globus_l_memory_slab_free(
+    struct globus_memory_s *                    s_mem_info,
+    globus_byte_t *                             slab)
+{
+    if(slab == GLOBUS_NULL)
+    {
+        return;
+    }
+#if defined(__linux__)
+    if(s_mem_info->mapped)
+    {
+        munmap(slab, (size_t) s_mem_info->total_size);
+        return;
+    }
+#endif
+    free(slab);
+}
+
 /*
  * this is called locked
  */
@@ -147,9 +561,7 @@ globus_l_memory_create_list(
     assert(mem_info != GLOBUS_NULL);
     s_mem_info = *mem_info;
 
-    s_mem_info->first = globus_malloc(
-                            s_mem_info->node_size * 
-                            s_mem_info->node_count_per_malloc);
+    s_mem_info->first = globus_l_memory_slab_alloc(s_mem_info);
 
     s_mem_info->free_ptrs_offset++;
     if(s_mem_info->free_ptrs_offset == s_mem_info->free_ptrs_size)
@@ -194,10 +606,32 @@ globus_memory_pop_node(
     struct globus_memory_s *                    s_mem_info;
     globus_l_memory_header_t *                  header;
     globus_byte_t *                             tmp_byte;
+#ifdef GLOBUS_L_MEMORY_MAGAZINES
+    globus_l_memory_magazine_t *                magazine;
+#endif
    
     assert(mem_info != GLOBUS_NULL);
     s_mem_info = *mem_info;
     assert(s_mem_info != GLOBUS_NULL);
+
+#ifdef GLOBUS_L_MEMORY_MAGAZINES
+    magazine = globus_l_memory_magazine(s_mem_info);
+    if(magazine != GLOBUS_NULL && globus_l_memory_magazine_acquire(magazine))
+    {
+        if(magazine->count == 0)
+        {
+            globus_l_memory_magazine_fill(s_mem_info, magazine);
+        }
+        tmp_byte = GLOBUS_NULL;
+        if(magazine->count > 0)
+        {
+            tmp_byte = magazine->nodes[--magazine->count];
+        }
+        globus_l_memory_magazine_release(magazine);
+
+        return tmp_byte;
+    }
+#endif
     
     globus_mutex_lock(&s_mem_info->lock);
     { 
@@ -209,16 +643,21 @@ globus_memory_pop_node(
         /* 
          *  test to see if there is memory left.
          */
+#ifdef GLOBUS_L_MEMORY_MAGAZINES
+        if(s_mem_info->first == GLOBUS_NULL)
+        {
+            globus_l_memory_magazine_drain(s_mem_info);
+        }
+#endif
         if(s_mem_info->first == GLOBUS_NULL)
         {
 	        s_mem_info->node_count += s_mem_info->node_count_per_malloc;
             globus_l_memory_create_list(mem_info);
         }
-    
+
         header = (globus_l_memory_header_t *) s_mem_info->first;
         tmp_byte = s_mem_info->first;
         s_mem_info->first = header->next;
-        s_mem_info->nodes_used++;
     }
     globus_mutex_unlock(&s_mem_info->lock);
 
@@ -240,12 +679,30 @@ globus_memory_push_node(
     globus_l_memory_header_t *                  header;
     struct globus_memory_s *                    s_mem_info;
 	globus_byte_t *								buf;
+#ifdef GLOBUS_L_MEMORY_MAGAZINES
+    globus_l_memory_magazine_t *                magazine;
+#endif
 
     assert(mem_info != GLOBUS_NULL);
     s_mem_info = *mem_info;
     assert(s_mem_info != GLOBUS_NULL);
 
 	buf = (globus_byte_t *)buffer;
+
+#ifdef GLOBUS_L_MEMORY_MAGAZINES
+    magazine = globus_l_memory_magazine(s_mem_info);
+    if(magazine != GLOBUS_NULL && globus_l_memory_magazine_acquire(magazine))
+    {
+        if(magazine->count == s_mem_info->magazine_size)
+        {
+            globus_l_memory_magazine_flush(s_mem_info, magazine);
+        }
+        magazine->nodes[magazine->count++] = buf;
+        globus_l_memory_magazine_release(magazine);
+
+        return GLOBUS_TRUE;
+    }
+#endif
     
     globus_mutex_lock(&s_mem_info->lock);
     { 
@@ -258,7 +715,6 @@ globus_memory_push_node(
 
         header->next = s_mem_info->first;
         s_mem_info->first = (globus_byte_t *)header;
-        s_mem_info->nodes_used--;
     } 
     globus_mutex_unlock(&s_mem_info->lock);
 
@@ -287,16 +743,18 @@ globus_memory_destroy(
 
     globus_mutex_lock(&s_mem_info->lock);
     {
-        if(s_mem_info->nodes_used > 0)
-        {
-        }
+        s_mem_info->destroyed = GLOBUS_TRUE;
         for(ctr = 0; ctr <= s_mem_info->free_ptrs_offset; ctr++)
         {
-            free(s_mem_info->free_ptrs[ctr]);
+            globus_l_memory_slab_free(s_mem_info, s_mem_info->free_ptrs[ctr]);
         }
     }
     globus_mutex_unlock(&s_mem_info->lock);
     
+    if(s_mem_info->magazines != GLOBUS_NULL)
+    {
+        globus_free(s_mem_info->magazines);
+    }
     globus_free(s_mem_info->free_ptrs);
     globus_mutex_destroy(&s_mem_info->lock);
     globus_free(s_mem_info);
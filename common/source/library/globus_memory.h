@@ -39,6 +39,12 @@ extern "C" {
  * @details
  * The globus_memory abstraction implements a memory management pool for
  * groups of same-sized data items.
+ *
+ * In threaded processes each thread pops and pushes nodes through a small
+ * cache of its own, so threads sharing a pool rarely contend for its lock.
+ * If the GLOBUS_MEMORY_HUGEPAGES environment variable is set to a nonzero
+ * value, pools whose allocations are at least 2MB are backed by huge pages
+ * where the system supports them.
  */
 /******************************************************************************
 			       Type definitions
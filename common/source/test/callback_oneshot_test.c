@@ -0,0 +1,239 @@
+/*
+ * Copyright 1999-2014 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file callback_oneshot_test.c
+ * @brief Test and benchmark oneshots in the threaded global space
+ *
+ * For a growing number of global space polling threads, times a oneshot
+ * from registration to dispatch, one at a time, and then runs many chains
+ * of oneshots, each of which registers the next link from within a
+ * callback, checking that every link runs exactly once.  Results are
+ * reported as TAP comments; pass a chain length to run longer as a
+ * benchmark.
+ */
+
+#include "globus_common.h"
+#include "globus_test_tap.h"
+
+#include "globus_preload.h"
+
+#include <sys/time.h>
+
+#define CALLBACK_ONESHOT_TEST_ROUND_TRIPS       2000
+#define CALLBACK_ONESHOT_TEST_CHAINS            64
+#define CALLBACK_ONESHOT_TEST_CHAIN_LENGTH      2000
+#define CALLBACK_ONESHOT_TEST_MAX_THREADS       8
+
+typedef struct
+{
+    int                                 remaining;
+    int                                 ran;
+} callback_oneshot_test_chain_t;
+
+static globus_mutex_t                   callback_oneshot_test_lock;
+static globus_cond_t                    callback_oneshot_test_cond;
+static int                              callback_oneshot_test_done;
+static int                              callback_oneshot_test_errors;
+static int                              callback_oneshot_test_length =
+                                    CALLBACK_ONESHOT_TEST_CHAIN_LENGTH;
+static callback_oneshot_test_chain_t    callback_oneshot_test_chains[
+                                            CALLBACK_ONESHOT_TEST_CHAINS];
+
+static
+double
+callback_oneshot_test_elapsed(
+    struct timeval *                    start)
+{
+    struct timeval                      end;
+
+    gettimeofday(&end, NULL);
+    return (end.tv_sec - start->tv_sec) +
+        (end.tv_usec - start->tv_usec) / 1000000.0;
+}
+
+static
+void
+callback_oneshot_test_signal_cb(
+    void *                              user_arg)
+{
+    globus_mutex_lock(&callback_oneshot_test_lock);
+    {
+        callback_oneshot_test_done++;
+        globus_cond_signal(&callback_oneshot_test_cond);
+    }
+    globus_mutex_unlock(&callback_oneshot_test_lock);
+}
+
+static
+int
+callback_oneshot_test_latency(
+    int                                 threads)
+{
+    struct timeval                      start;
+    double                              elapsed;
+    int                                 i;
+
+    callback_oneshot_test_done = 0;
+    gettimeofday(&start, NULL);
+    for(i = 0; i < CALLBACK_ONESHOT_TEST_ROUND_TRIPS; i++)
+    {
+        if(globus_callback_register_oneshot(
+            NULL, NULL, callback_oneshot_test_signal_cb, NULL) !=
+                GLOBUS_SUCCESS)
+        {
+            return 1;
+        }
+
+        globus_mutex_lock(&callback_oneshot_test_lock);
+        {
+            while(callback_oneshot_test_done == i)
+            {
+                globus_cond_wait(
+                    &callback_oneshot_test_cond, &callback_oneshot_test_lock);
+            }
+        }
+        globus_mutex_unlock(&callback_oneshot_test_lock);
+    }
+    elapsed = callback_oneshot_test_elapsed(&start);
+
+    printf("# %d polling threads: %.2f us register to dispatch\n",
+        threads, elapsed * 1e6 / CALLBACK_ONESHOT_TEST_ROUND_TRIPS);
+
+    return callback_oneshot_test_done != CALLBACK_ONESHOT_TEST_ROUND_TRIPS;
+}
+
+static
+void
+callback_oneshot_test_chain_cb(
+    void *                              user_arg)
+{
+    callback_oneshot_test_chain_t *     chain;
+
+    chain = (callback_oneshot_test_chain_t *) user_arg;
+    /* only one link of a chain is ever queued or running */
+    chain->ran++;
+    if(--chain->remaining > 0)
+    {
+        if(globus_callback_register_oneshot(
+            NULL, NULL, callback_oneshot_test_chain_cb, chain) ==
+                GLOBUS_SUCCESS)
+        {
+            return;
+        }
+        chain->remaining = -1;
+    }
+
+    callback_oneshot_test_signal_cb(NULL);
+}
+
+static
+int
+callback_oneshot_test_throughput(
+    int                                 threads)
+{
+    struct timeval                      start;
+    double                              elapsed;
+    int                                 errors = 0;
+    int                                 i;
+
+    callback_oneshot_test_done = 0;
+    gettimeofday(&start, NULL);
+    for(i = 0; i < CALLBACK_ONESHOT_TEST_CHAINS; i++)
+    {
+        callback_oneshot_test_chains[i].remaining =
+            callback_oneshot_test_length;
+        callback_oneshot_test_chains[i].ran = 0;
+        if(globus_callback_register_oneshot(
+            NULL,
+            NULL,
+            callback_oneshot_test_chain_cb,
+            &callback_oneshot_test_chains[i]) != GLOBUS_SUCCESS)
+        {
+            callback_oneshot_test_signal_cb(NULL);
+            errors++;
+        }
+    }
+
+    globus_mutex_lock(&callback_oneshot_test_lock);
+    {
+        while(callback_oneshot_test_done < CALLBACK_ONESHOT_TEST_CHAINS)
+        {
+            globus_cond_wait(
+                &callback_oneshot_test_cond, &callback_oneshot_test_lock);
+        }
+    }
+    globus_mutex_unlock(&callback_oneshot_test_lock);
+    elapsed = callback_oneshot_test_elapsed(&start);
+
+    for(i = 0; i < CALLBACK_ONESHOT_TEST_CHAINS; i++)
+    {
+        errors += callback_oneshot_test_chains[i].ran !=
+            callback_oneshot_test_length;
+    }
+
+    printf("# %d polling threads: %.2f M oneshots/s\n",
+        threads,
+        (double) CALLBACK_ONESHOT_TEST_CHAINS * callback_oneshot_test_length /
+            (elapsed > 0 ? elapsed : 1e-6) / 1e6);
+
+    return errors;
+}
+
+int
+main(
+    int                                 argc,
+    char *                              argv[])
+{
+    char                                count[16];
+    int                                 threads;
+
+    if(argc > 1)
+    {
+        callback_oneshot_test_length = atoi(argv[1]);
+    }
+
+    LTDL_SET_PRELOADED_SYMBOLS();
+    globus_thread_set_model("pthread");
+
+    printf("1..8\n");
+    for(threads = 1;
+        threads <= CALLBACK_ONESHOT_TEST_MAX_THREADS;
+        threads *= 2)
+    {
+        /* read when the callback code is activated */
+        sprintf(count, "%d", threads);
+        setenv("GLOBUS_CALLBACK_POLLING_THREADS", count, 1);
+        if(globus_module_activate(GLOBUS_COMMON_MODULE) != GLOBUS_SUCCESS)
+        {
+            printf("Bail out! can't activate common\n");
+            return 99;
+        }
+        globus_mutex_init(&callback_oneshot_test_lock, NULL);
+        globus_cond_init(&callback_oneshot_test_cond, NULL);
+
+        ok(callback_oneshot_test_latency(threads) == 0,
+            "oneshot_latency_%d_threads", threads);
+        ok(callback_oneshot_test_throughput(threads) == 0,
+            "oneshot_throughput_%d_threads", threads);
+
+        globus_mutex_destroy(&callback_oneshot_test_lock);
+        globus_cond_destroy(&callback_oneshot_test_cond);
+        globus_module_deactivate(GLOBUS_COMMON_MODULE);
+    }
+
+    return TEST_EXIT_CODE;
+}
@@ -0,0 +1,460 @@
+/*
+ * Copyright 1999-2014 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file callback_timer_test.c
+ * @brief Test and benchmark timed and periodic callbacks
+ *
+ * Registers many oneshots with random delays and checks that each runs
+ * once and never early, both with exact timers and with
+ * GLOBUS_CALLBACK_TIMER_COALESCE set, and that oneshots due in the same
+ * tick run in the order of their times.  Checks that unregistered oneshots
+ * never run, that a periodic keeps running until it is unregistered, and
+ * reports the cost of registering and unregistering timed callbacks as a
+ * TAP comment; pass a count to run the timing as a benchmark.
+ */
+
+#include "globus_common.h"
+#include "globus_test_tap.h"
+
+#ifdef THREAD_MODEL
+#include "globus_preload.h"
+#endif
+
+#include <sys/time.h>
+
+#define CALLBACK_TIMER_TEST_COUNT       2000
+#define CALLBACK_TIMER_TEST_MAX_DELAY   200000
+#define CALLBACK_TIMER_TEST_BENCH_COUNT 100000
+#define CALLBACK_TIMER_TEST_TICK_COUNT  20
+
+typedef struct
+{
+    globus_abstime_t                    due;
+    globus_callback_handle_t            handle;
+    int                                 ran;
+    int                                 early;
+} callback_timer_test_timer_t;
+
+static globus_mutex_t                   callback_timer_test_lock;
+static globus_cond_t                    callback_timer_test_cond;
+static int                              callback_timer_test_done;
+static unsigned                         callback_timer_test_seed = 7;
+static callback_timer_test_timer_t      callback_timer_test_timers[
+                                            CALLBACK_TIMER_TEST_COUNT];
+/* the timers in the order they ran */
+static callback_timer_test_timer_t *    callback_timer_test_ran[
+                                            CALLBACK_TIMER_TEST_COUNT];
+
+static
+int
+callback_timer_test_random(
+    int                                 limit)
+{
+    callback_timer_test_seed = callback_timer_test_seed * 1103515245 + 12345;
+    return (callback_timer_test_seed >> 8) % limit;
+}
+
+static
+void
+callback_timer_test_cb(
+    void *                              user_arg)
+{
+    callback_timer_test_timer_t *       timer;
+    globus_abstime_t                    now;
+
+    timer = (callback_timer_test_timer_t *) user_arg;
+    GlobusTimeAbstimeGetCurrent(now);
+
+    globus_mutex_lock(&callback_timer_test_lock);
+    {
+        timer->ran++;
+        if(globus_abstime_cmp(&now, &timer->due) < 0)
+        {
+            timer->early++;
+        }
+        if(callback_timer_test_done < CALLBACK_TIMER_TEST_COUNT)
+        {
+            callback_timer_test_ran[callback_timer_test_done] = timer;
+        }
+        callback_timer_test_done++;
+        globus_cond_signal(&callback_timer_test_cond);
+    }
+    globus_mutex_unlock(&callback_timer_test_lock);
+}
+
+static
+void
+callback_timer_test_wait(
+    int                                 count)
+{
+    globus_mutex_lock(&callback_timer_test_lock);
+    {
+        while(callback_timer_test_done < count)
+        {
+            globus_cond_wait(
+                &callback_timer_test_cond, &callback_timer_test_lock);
+        }
+    }
+    globus_mutex_unlock(&callback_timer_test_lock);
+}
+
+/* every oneshot runs once, and not before its time */
+static
+int
+callback_timer_test_order(void)
+{
+    callback_timer_test_timer_t *       timer;
+    globus_reltime_t                    delay;
+    int                                 errors = 0;
+    int                                 usec;
+    int                                 i;
+
+    callback_timer_test_done = 0;
+    for(i = 0; i < CALLBACK_TIMER_TEST_COUNT; i++)
+    {
+        timer = &callback_timer_test_timers[i];
+        /* plenty share a millisecond */
+        usec = callback_timer_test_random(CALLBACK_TIMER_TEST_MAX_DELAY);
+        if(i % 4 == 0)
+        {
+            usec -= usec % 1000;
+        }
+        GlobusTimeReltimeSet(delay, 0, usec);
+        GlobusTimeAbstimeSet(timer->due, 0, usec);
+        timer->ran = 0;
+        timer->early = 0;
+
+        if(globus_callback_register_oneshot(
+            NULL, &delay, callback_timer_test_cb, timer) != GLOBUS_SUCCESS)
+        {
+            return 1;
+        }
+    }
+
+    callback_timer_test_wait(CALLBACK_TIMER_TEST_COUNT);
+
+    for(i = 0; i < CALLBACK_TIMER_TEST_COUNT; i++)
+    {
+        errors += callback_timer_test_timers[i].ran != 1;
+        errors += callback_timer_test_timers[i].early != 0;
+    }
+
+    return errors;
+}
+
+/*
+ * oneshots a fraction of a tick apart, registered latest first, run in the
+ * order of their times.  they are registered to a space only this thread
+ * polls, so they run one at a time
+ */
+static
+int
+callback_timer_test_same_tick(void)
+{
+    callback_timer_test_timer_t *       timer;
+    globus_callback_space_attr_t        attr;
+    globus_callback_space_t             space;
+    globus_reltime_t                    delay;
+    globus_abstime_t                    timestop;
+    int                                 errors = 0;
+    int                                 done;
+    int                                 usec;
+    int                                 i;
+
+    if(globus_callback_space_attr_init(&attr) != GLOBUS_SUCCESS)
+    {
+        return 1;
+    }
+    globus_callback_space_attr_set_behavior(
+        attr, GLOBUS_CALLBACK_SPACE_BEHAVIOR_SINGLE);
+    if(globus_callback_space_init(&space, attr) != GLOBUS_SUCCESS)
+    {
+        globus_callback_space_attr_destroy(attr);
+        return 1;
+    }
+
+    callback_timer_test_done = 0;
+    for(i = 0; i < CALLBACK_TIMER_TEST_TICK_COUNT; i++)
+    {
+        timer = &callback_timer_test_timers[i];
+        usec = 100000 + (CALLBACK_TIMER_TEST_TICK_COUNT - i) * 200;
+        GlobusTimeReltimeSet(delay, 0, usec);
+        GlobusTimeAbstimeSet(timer->due, 0, usec);
+        timer->ran = 0;
+        timer->early = 0;
+
+        errors += globus_callback_space_register_oneshot(
+            NULL,
+            &delay,
+            callback_timer_test_cb,
+            timer,
+            space) != GLOBUS_SUCCESS;
+    }
+
+    do
+    {
+        GlobusTimeAbstimeSet(timestop, 0, 10000);
+        globus_callback_space_poll(&timestop, space);
+
+        globus_mutex_lock(&callback_timer_test_lock);
+        {
+            done = callback_timer_test_done;
+        }
+        globus_mutex_unlock(&callback_timer_test_lock);
+    } while(done < CALLBACK_TIMER_TEST_TICK_COUNT - errors);
+
+    for(i = 0; i < CALLBACK_TIMER_TEST_TICK_COUNT; i++)
+    {
+        errors += callback_timer_test_ran[i] !=
+            &callback_timer_test_timers[CALLBACK_TIMER_TEST_TICK_COUNT - 1 - i];
+    }
+
+    globus_callback_space_destroy(space);
+    globus_callback_space_attr_destroy(attr);
+
+    return errors;
+}
+
+/* unregistered oneshots never run, including one years away */
+static
+int
+callback_timer_test_cancel(void)
+{
+    callback_timer_test_timer_t *       timer;
+    globus_callback_handle_t            far_handle;
+    globus_reltime_t                    delay;
+    globus_bool_t                       active;
+    int                                 errors = 0;
+    int                                 i;
+
+    GlobusTimeReltimeSet(delay, 3 * 366 * 24 * 60 * 60, 0);
+    errors += globus_callback_register_oneshot(
+        &far_handle, &delay, callback_timer_test_cb,
+        &callback_timer_test_timers[0]) != GLOBUS_SUCCESS;
+
+    callback_timer_test_done = 0;
+    for(i = 0; i < CALLBACK_TIMER_TEST_COUNT; i++)
+    {
+        timer = &callback_timer_test_timers[i];
+        GlobusTimeReltimeSet(delay, 0,
+            50000 + callback_timer_test_random(100000));
+        GlobusTimeAbstimeSet(timer->due, 0, 50000);
+        timer->ran = 0;
+        timer->early = 0;
+
+        errors += globus_callback_register_oneshot(
+            &timer->handle,
+            &delay,
+            callback_timer_test_cb,
+            timer) != GLOBUS_SUCCESS;
+    }
+
+    for(i = 0; i < CALLBACK_TIMER_TEST_COUNT; i += 2)
+    {
+        errors += globus_callback_unregister(
+            callback_timer_test_timers[i].handle,
+            NULL,
+            NULL,
+            &active) != GLOBUS_SUCCESS;
+    }
+    errors += globus_callback_unregister(
+        far_handle, NULL, NULL, &active) != GLOBUS_SUCCESS;
+
+    callback_timer_test_wait(CALLBACK_TIMER_TEST_COUNT / 2);
+
+    for(i = 0; i < CALLBACK_TIMER_TEST_COUNT; i++)
+    {
+        timer = &callback_timer_test_timers[i];
+        if(i % 2 == 0)
+        {
+            errors += timer->ran != 0;
+        }
+        else
+        {
+            errors += timer->ran != 1;
+            /* unregistering a finished oneshot drops its handle */
+            globus_callback_unregister(timer->handle, NULL, NULL, &active);
+        }
+    }
+
+    return errors;
+}
+
+/* a periodic keeps running, through a change of period, until unregistered */
+static
+int
+callback_timer_test_periodic(void)
+{
+    callback_timer_test_timer_t *       timer;
+    globus_reltime_t                    period;
+    globus_bool_t                       active;
+    int                                 errors = 0;
+
+    timer = &callback_timer_test_timers[0];
+    GlobusTimeAbstimeSet(timer->due, 0, 0);
+    timer->ran = 0;
+    timer->early = 0;
+    callback_timer_test_done = 0;
+
+    GlobusTimeReltimeSet(period, 0, 10000);
+    errors += globus_callback_register_periodic(
+        &timer->handle,
+        &period,
+        &period,
+        callback_timer_test_cb,
+        timer) != GLOBUS_SUCCESS;
+    callback_timer_test_wait(5);
+
+    GlobusTimeReltimeSet(period, 0, 2000);
+    errors += globus_callback_adjust_period(
+        timer->handle, &period) != GLOBUS_SUCCESS;
+    callback_timer_test_wait(15);
+
+    errors += globus_callback_unregister(
+        timer->handle, NULL, NULL, &active) != GLOBUS_SUCCESS;
+
+    return errors;
+}
+
+static
+double
+callback_timer_test_elapsed(
+    struct timeval *                    start)
+{
+    struct timeval                      end;
+
+    gettimeofday(&end, NULL);
+    return (end.tv_sec - start->tv_sec) +
+        (end.tv_usec - start->tv_usec) / 1000000.0;
+}
+
+/* register and unregister timers spread over the next minute */
+static
+int
+callback_timer_test_bench(
+    int                                 count)
+{
+    globus_callback_handle_t *          handles;
+    globus_reltime_t                    delay;
+    struct timeval                      start;
+    globus_bool_t                       active;
+    double                              insert;
+    double                              cancel;
+    int                                 errors = 0;
+    int                                 i;
+
+    handles = malloc(count * sizeof(globus_callback_handle_t));
+    if(!handles)
+    {
+        return 1;
+    }
+
+    gettimeofday(&start, NULL);
+    for(i = 0; i < count; i++)
+    {
+        GlobusTimeReltimeSet(delay, 1 + callback_timer_test_random(60),
+            callback_timer_test_random(1000000));
+        errors += globus_callback_register_oneshot(
+            &handles[i],
+            &delay,
+            callback_timer_test_cb,
+            &callback_timer_test_timers[0]) != GLOBUS_SUCCESS;
+    }
+    insert = callback_timer_test_elapsed(&start);
+
+    gettimeofday(&start, NULL);
+    for(i = 0; i < count; i++)
+    {
+        errors += globus_callback_unregister(
+            handles[i], NULL, NULL, &active) != GLOBUS_SUCCESS;
+    }
+    cancel = callback_timer_test_elapsed(&start);
+
+    printf("# %d timers: register %.1f ns, unregister %.1f ns\n",
+        count, insert * 1e9 / count, cancel * 1e9 / count);
+    free(handles);
+
+    return errors;
+}
+
+static
+int
+callback_timer_test_activate(void)
+{
+    if(globus_module_activate(GLOBUS_COMMON_MODULE) != GLOBUS_SUCCESS)
+    {
+        return 1;
+    }
+    globus_mutex_init(&callback_timer_test_lock, NULL);
+    globus_cond_init(&callback_timer_test_cond, NULL);
+
+    return 0;
+}
+
+static
+void
+callback_timer_test_deactivate(void)
+{
+    globus_mutex_destroy(&callback_timer_test_lock);
+    globus_cond_destroy(&callback_timer_test_cond);
+    globus_module_deactivate(GLOBUS_COMMON_MODULE);
+}
+
+int
+main(
+    int                                 argc,
+    char *                              argv[])
+{
+    int                                 count = CALLBACK_TIMER_TEST_BENCH_COUNT;
+
+    if(argc > 1)
+    {
+        count = atoi(argv[1]);
+    }
+
+#ifdef THREAD_MODEL
+    LTDL_SET_PRELOADED_SYMBOLS();
+    globus_thread_set_model(THREAD_MODEL);
+#endif
+
+    printf("1..7\n");
+    if(callback_timer_test_activate())
+    {
+        printf("Bail out! can't activate common\n");
+        return 99;
+    }
+    ok(callback_timer_test_order() == 0, "timers_run_once_not_early");
+    ok(callback_timer_test_same_tick() == 0, "same_tick_timers_run_in_order");
+    ok(callback_timer_test_cancel() == 0, "unregistered_timers_do_not_run");
+    ok(callback_timer_test_periodic() == 0, "periodic_runs_until_unregistered");
+    ok(callback_timer_test_bench(count) == 0, "timer_bench");
+    callback_timer_test_deactivate();
+
+    /* read when the callback spaces are created */
+    setenv("GLOBUS_CALLBACK_TIMER_COALESCE", "20", 1);
+    if(callback_timer_test_activate())
+    {
+        printf("Bail out! can't activate common\n");
+        return 99;
+    }
+    ok(callback_timer_test_order() == 0, "coalesced_timers_run_once_not_early");
+    ok(callback_timer_test_same_tick() == 0,
+        "coalesced_same_tick_timers_run_in_order");
+    callback_timer_test_deactivate();
+
+    return TEST_EXIT_CODE;
+}
@@ -0,0 +1,294 @@
+/*
+ * Copyright 1999-2014 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file hash_resizable_test.c
+ * @brief Resizable Hashtable Test Cases
+ *
+ * Checks a table created with globus_hashtable_init_resizable() against a
+ * chained table through a long run of random inserts, updates, lookups and
+ * removals, and checks that iteration survives removal and growth.  Then
+ * times inserts, lookups and removals in both kinds of table, starting
+ * from the small sizes callers typically pass, and reports the results as
+ * TAP comments.  Pass a key count to run the timings as a benchmark.
+ */
+
+#include "globus_common.h"
+#include "globus_test_tap.h"
+
+#include <sys/time.h>
+
+#define HASH_RESIZABLE_TEST_KEYS        4096
+#define HASH_RESIZABLE_TEST_OPS         200000
+#define HASH_RESIZABLE_TEST_BENCH_KEYS  20000
+
+static unsigned                         hash_resizable_test_seed = 42;
+
+static
+int
+hash_resizable_test_random(
+    int                                 limit)
+{
+    hash_resizable_test_seed =
+        hash_resizable_test_seed * 1103515245 + 12345;
+    return (hash_resizable_test_seed >> 8) % limit;
+}
+
+static
+void *
+hash_resizable_test_key(
+    int                                 i)
+{
+    /* never 0, and even so that a datum can be told from its key */
+    return (void *) (intptr_t) (2 * i + 2);
+}
+
+/* random operations on both tables must give the same answers */
+static
+int
+hash_resizable_test_compare(void)
+{
+    globus_hashtable_t                  chained;
+    globus_hashtable_t                  resizable;
+    globus_hashtable_t                  copy;
+    void *                              key;
+    void *                              a;
+    void *                              b;
+    int                                 i;
+    int                                 n;
+    int                                 errors = 0;
+
+    globus_hashtable_init(
+        &chained, 64, globus_hashtable_int_hash, globus_hashtable_int_keyeq);
+    globus_hashtable_init_resizable(
+        &resizable, 0, globus_hashtable_int_hash, globus_hashtable_int_keyeq);
+
+    for(i = 0; i < HASH_RESIZABLE_TEST_OPS; i++)
+    {
+        key = hash_resizable_test_key(
+            hash_resizable_test_random(HASH_RESIZABLE_TEST_KEYS));
+        switch(hash_resizable_test_random(4))
+        {
+          case 0:
+          case 1:
+            a = (void *) (intptr_t) (i * 2 + 1);
+            errors += globus_hashtable_insert(&chained, key, a) !=
+                globus_hashtable_insert(&resizable, key, a);
+            break;
+          case 2:
+            a = (void *) (intptr_t) (i * 2 + 1);
+            errors += globus_hashtable_update(&chained, key, a) !=
+                globus_hashtable_update(&resizable, key, a);
+            break;
+          default:
+            errors += globus_hashtable_remove(&chained, key) !=
+                globus_hashtable_remove(&resizable, key);
+            break;
+        }
+        key = hash_resizable_test_key(
+            hash_resizable_test_random(HASH_RESIZABLE_TEST_KEYS));
+        errors += globus_hashtable_lookup(&chained, key) !=
+            globus_hashtable_lookup(&resizable, key);
+        errors += globus_hashtable_size(&chained) !=
+            globus_hashtable_size(&resizable);
+    }
+
+    /* a copy holds the same mappings */
+    globus_hashtable_copy(&copy, &resizable, NULL);
+    n = 0;
+    for(a = globus_hashtable_first(&resizable);
+        a != NULL;
+        a = globus_hashtable_next(&resizable))
+    {
+        n++;
+    }
+    errors += n != globus_hashtable_size(&resizable);
+    errors += globus_hashtable_size(&copy) != globus_hashtable_size(&chained);
+    for(i = 0; i < HASH_RESIZABLE_TEST_KEYS; i++)
+    {
+        key = hash_resizable_test_key(i);
+        a = globus_hashtable_lookup(&chained, key);
+        b = globus_hashtable_lookup(&copy, key);
+        errors += a != b;
+    }
+
+    globus_hashtable_destroy(&copy);
+    globus_hashtable_destroy(&chained);
+    globus_hashtable_destroy(&resizable);
+
+    return errors;
+}
+
+/*
+ * remove every other entry while iterating, inserting new ones as we go so
+ * the table grows underneath the iterator.  every entry present at the
+ * start must be visited exactly once, in order.
+ */
+static
+int
+hash_resizable_test_iterate(void)
+{
+    globus_hashtable_t                  table;
+    void *                              datum;
+    int                                 expect = 0;
+    int                                 added = 0;
+    int                                 errors = 0;
+    int                                 i;
+
+    globus_hashtable_init_resizable(
+        &table, 4, globus_hashtable_int_hash, globus_hashtable_int_keyeq);
+    for(i = 0; i < 100; i++)
+    {
+        globus_hashtable_insert(
+            &table, hash_resizable_test_key(i), (void *) (intptr_t) (i + 1));
+    }
+
+    datum = globus_hashtable_first(&table);
+    while(datum != NULL && expect < 100)
+    {
+        errors += datum != (void *) (intptr_t) (expect + 1);
+        if(expect % 2 == 0)
+        {
+            /* moves the iterator on to the next entry */
+            globus_hashtable_remove(&table, hash_resizable_test_key(expect));
+            datum = globus_hashtable_next(&table);
+            datum = globus_hashtable_prev(&table);
+        }
+        else
+        {
+            datum = globus_hashtable_next(&table);
+        }
+        globus_hashtable_insert(
+            &table,
+            hash_resizable_test_key(1000 + added),
+            (void *) (intptr_t) (1000 + added + 1));
+        added++;
+        expect++;
+    }
+    errors += expect != 100;
+    errors += globus_hashtable_size(&table) != 50 + added;
+
+    /* and backwards from the end */
+    datum = globus_hashtable_last(&table);
+    errors += datum != (void *) (intptr_t) (1000 + added);
+    i = 0;
+    while(datum != NULL)
+    {
+        i++;
+        datum = globus_hashtable_prev(&table);
+    }
+    errors += i != 50 + added;
+
+    globus_hashtable_destroy(&table);
+
+    return errors;
+}
+
+static
+double
+hash_resizable_test_elapsed(
+    struct timeval *                    start)
+{
+    struct timeval                      end;
+
+    gettimeofday(&end, NULL);
+    return (end.tv_sec - start->tv_sec) +
+        (end.tv_usec - start->tv_usec) / 1000000.0;
+}
+
+static
+int
+hash_resizable_test_bench(
+    const char *                        name,
+    globus_hashtable_t *                table,
+    int                                 keys)
+{
+    struct timeval                      start;
+    double                              insert;
+    double                              lookup;
+    double                              remove;
+    int                                 errors = 0;
+    int                                 i;
+
+    gettimeofday(&start, NULL);
+    for(i = 0; i < keys; i++)
+    {
+        errors += globus_hashtable_insert(
+            table, hash_resizable_test_key(i), table) != 0;
+    }
+    insert = hash_resizable_test_elapsed(&start);
+
+    gettimeofday(&start, NULL);
+    for(i = 0; i < keys * 2; i++)
+    {
+        /* half hits, half misses */
+        errors += (globus_hashtable_lookup(
+            table, hash_resizable_test_key(i)) != NULL) != (i < keys);
+    }
+    lookup = hash_resizable_test_elapsed(&start);
+
+    gettimeofday(&start, NULL);
+    for(i = 0; i < keys; i++)
+    {
+        errors += globus_hashtable_remove(
+            table, hash_resizable_test_key(i)) != table;
+    }
+    remove = hash_resizable_test_elapsed(&start);
+
+    printf("# %-9s %7d keys: insert %8.1f ns, lookup %8.1f ns, "
+        "remove %8.1f ns\n",
+        name,
+        keys,
+        insert * 1e9 / keys,
+        lookup * 1e9 / (keys * 2),
+        remove * 1e9 / keys);
+
+    return errors;
+}
+
+int main(int argc, char **argv)
+{
+    globus_hashtable_t                  table;
+    int                                 keys = HASH_RESIZABLE_TEST_BENCH_KEYS;
+    int                                 errors;
+
+    if(argc > 1)
+    {
+        keys = atoi(argv[1]);
+    }
+
+    printf("1..4\n");
+    globus_module_activate(GLOBUS_COMMON_MODULE);
+
+    ok(hash_resizable_test_compare() == 0, "resizable_matches_chained");
+    ok(hash_resizable_test_iterate() == 0, "resizable_iterate");
+
+    globus_hashtable_init(
+        &table, 256, globus_hashtable_int_hash, globus_hashtable_int_keyeq);
+    errors = hash_resizable_test_bench("chained", &table, keys);
+    globus_hashtable_destroy(&table);
+    ok(errors == 0, "chained_bench");
+
+    globus_hashtable_init_resizable(
+        &table, 256, globus_hashtable_int_hash, globus_hashtable_int_keyeq);
+    errors = hash_resizable_test_bench("resizable", &table, keys);
+    globus_hashtable_destroy(&table);
+    ok(errors == 0, "resizable_bench");
+
+    globus_module_deactivate(GLOBUS_COMMON_MODULE);
+
+    return TEST_EXIT_CODE;
+}
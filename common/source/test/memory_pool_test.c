@@ -0,0 +1,301 @@
+/*
+ * Copyright 1999-2014 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file memory_pool_test.c
+ * @brief Test and benchmark globus_memory_t shared between threads
+ *
+ * Threads share a pool, each popping a burst of nodes, stamping them with
+ * its own id, checking that no other thread has touched them, and pushing
+ * them back.  Each run reports pop/push throughput as a TAP comment; pass
+ * an iteration count to run longer as a benchmark.  Then threads take
+ * turns emptying a small pool and refilling it, to check that the nodes
+ * they leave in their magazines are used before the pool grows.
+ */
+
+#include "globus_common.h"
+#include "globus_test_tap.h"
+
+#include "globus_preload.h"
+
+#include <sys/time.h>
+
+#define MEMORY_POOL_TEST_BURST          8
+#define MEMORY_POOL_TEST_ITERATIONS     20000
+#define MEMORY_POOL_TEST_MAX_THREADS    64
+#define MEMORY_POOL_TEST_SMALL_POOL     4
+
+typedef struct
+{
+    long                                owner;
+    long                                serial;
+    char                                pad[48];
+} memory_pool_test_node_t;
+
+static globus_memory_t                  memory_pool_test_mem;
+static globus_mutex_t                   memory_pool_test_lock;
+static globus_cond_t                    memory_pool_test_cond;
+static int                              memory_pool_test_running;
+static int                              memory_pool_test_errors;
+static int                              memory_pool_test_iterations =
+                                            MEMORY_POOL_TEST_ITERATIONS;
+static void *                           memory_pool_test_seen[
+                                    MEMORY_POOL_TEST_MAX_THREADS *
+                                    MEMORY_POOL_TEST_SMALL_POOL];
+static int                              memory_pool_test_seen_count;
+
+static
+void *
+memory_pool_test_thread(
+    void *                              arg)
+{
+    memory_pool_test_node_t *           nodes[MEMORY_POOL_TEST_BURST];
+    long                                id = (long) arg;
+    int                                 errors = 0;
+    int                                 i;
+    int                                 j;
+
+    for(i = 0; i < memory_pool_test_iterations; i++)
+    {
+        for(j = 0; j < MEMORY_POOL_TEST_BURST; j++)
+        {
+            nodes[j] = globus_memory_pop_node(&memory_pool_test_mem);
+            if(nodes[j] == NULL)
+            {
+                errors++;
+                break;
+            }
+            nodes[j]->owner = id;
+            nodes[j]->serial = i * MEMORY_POOL_TEST_BURST + j;
+        }
+        while(j-- > 0)
+        {
+            if(nodes[j]->owner != id ||
+                nodes[j]->serial != i * MEMORY_POOL_TEST_BURST + j)
+            {
+                errors++;
+            }
+            globus_memory_push_node(&memory_pool_test_mem, nodes[j]);
+        }
+    }
+
+    globus_mutex_lock(&memory_pool_test_lock);
+    {
+        memory_pool_test_errors += errors;
+        memory_pool_test_running--;
+        globus_cond_signal(&memory_pool_test_cond);
+    }
+    globus_mutex_unlock(&memory_pool_test_lock);
+
+    return NULL;
+}
+
+static
+int
+memory_pool_test_run(
+    int                                 threads,
+    int                                 node_count)
+{
+    globus_thread_t                     thread;
+    struct timeval                      start;
+    struct timeval                      end;
+    double                              elapsed;
+    long                                i;
+
+    globus_memory_init(
+        &memory_pool_test_mem, sizeof(memory_pool_test_node_t), node_count);
+
+    memory_pool_test_errors = 0;
+    memory_pool_test_running = threads;
+    gettimeofday(&start, NULL);
+    for(i = 0; i < threads; i++)
+    {
+        if(globus_thread_create(
+            &thread, NULL, memory_pool_test_thread, (void *) i) != 0)
+        {
+            globus_mutex_lock(&memory_pool_test_lock);
+            memory_pool_test_running -= threads - i;
+            memory_pool_test_errors++;
+            globus_mutex_unlock(&memory_pool_test_lock);
+            break;
+        }
+    }
+
+    globus_mutex_lock(&memory_pool_test_lock);
+    {
+        while(memory_pool_test_running > 0)
+        {
+            globus_cond_wait(&memory_pool_test_cond, &memory_pool_test_lock);
+        }
+    }
+    globus_mutex_unlock(&memory_pool_test_lock);
+    gettimeofday(&end, NULL);
+
+    elapsed = (end.tv_sec - start.tv_sec) +
+        (end.tv_usec - start.tv_usec) / 1000000.0;
+    printf("# %2d threads, %d nodes per slab: %.2f M pop+push/s\n",
+        threads,
+        node_count,
+        (double) threads * memory_pool_test_iterations *
+            MEMORY_POOL_TEST_BURST / (elapsed > 0 ? elapsed : 1e-6) / 1e6);
+
+    globus_memory_destroy(&memory_pool_test_mem);
+
+    return memory_pool_test_errors;
+}
+
+/*
+ * pop every node a one slab pool should have, note any not seen before,
+ * and push them all back
+ */
+static
+void *
+memory_pool_test_turn(
+    void *                              arg)
+{
+    void *                              nodes[MEMORY_POOL_TEST_SMALL_POOL];
+    int                                 i;
+    int                                 j;
+
+    for(i = 0; i < MEMORY_POOL_TEST_SMALL_POOL; i++)
+    {
+        nodes[i] = globus_memory_pop_node(&memory_pool_test_mem);
+    }
+    globus_mutex_lock(&memory_pool_test_lock);
+    {
+        for(i = 0; i < MEMORY_POOL_TEST_SMALL_POOL; i++)
+        {
+            for(j = 0; j < memory_pool_test_seen_count; j++)
+            {
+                if(memory_pool_test_seen[j] == nodes[i])
+                {
+                    break;
+                }
+            }
+            if(j == memory_pool_test_seen_count)
+            {
+                memory_pool_test_seen[memory_pool_test_seen_count++] =
+                    nodes[i];
+            }
+        }
+    }
+    globus_mutex_unlock(&memory_pool_test_lock);
+    for(i = 0; i < MEMORY_POOL_TEST_SMALL_POOL; i++)
+    {
+        globus_memory_push_node(&memory_pool_test_mem, nodes[i]);
+    }
+
+    globus_mutex_lock(&memory_pool_test_lock);
+    {
+        memory_pool_test_running--;
+        globus_cond_signal(&memory_pool_test_cond);
+    }
+    globus_mutex_unlock(&memory_pool_test_lock);
+
+    return NULL;
+}
+
+/* returns how many distinct nodes threads taking turns were handed */
+static
+int
+memory_pool_test_turns(
+    int                                 threads)
+{
+    globus_thread_t                     thread;
+    int                                 i;
+
+    globus_memory_init(
+        &memory_pool_test_mem,
+        sizeof(memory_pool_test_node_t),
+        MEMORY_POOL_TEST_SMALL_POOL);
+    memory_pool_test_seen_count = 0;
+
+    for(i = 0; i < threads; i++)
+    {
+        globus_mutex_lock(&memory_pool_test_lock);
+        memory_pool_test_running = 1;
+        globus_mutex_unlock(&memory_pool_test_lock);
+
+        if(globus_thread_create(
+            &thread, NULL, memory_pool_test_turn, NULL) != 0)
+        {
+            break;
+        }
+        globus_mutex_lock(&memory_pool_test_lock);
+        {
+            while(memory_pool_test_running > 0)
+            {
+                globus_cond_wait(
+                    &memory_pool_test_cond, &memory_pool_test_lock);
+            }
+        }
+        globus_mutex_unlock(&memory_pool_test_lock);
+    }
+    printf("# %d threads taking turns on a %d node pool used %d nodes\n",
+        threads, MEMORY_POOL_TEST_SMALL_POOL, memory_pool_test_seen_count);
+
+    globus_memory_destroy(&memory_pool_test_mem);
+
+    return memory_pool_test_seen_count;
+}
+
+int
+main(
+    int                                 argc,
+    char *                              argv[])
+{
+    int                                 threads;
+
+    if(argc > 1)
+    {
+        memory_pool_test_iterations = atoi(argv[1]);
+    }
+
+    LTDL_SET_PRELOADED_SYMBOLS();
+    globus_thread_set_model("pthread");
+    /* read when the pool code is first activated */
+    setenv("GLOBUS_MEMORY_HUGEPAGES", "1", 1);
+
+    printf("1..9\n");
+    if(globus_module_activate(GLOBUS_COMMON_MODULE) != GLOBUS_SUCCESS)
+    {
+        printf("Bail out! can't activate common\n");
+        return 99;
+    }
+    globus_mutex_init(&memory_pool_test_lock, NULL);
+    globus_cond_init(&memory_pool_test_cond, NULL);
+
+    for(threads = 1; threads <= MEMORY_POOL_TEST_MAX_THREADS; threads *= 2)
+    {
+        ok(memory_pool_test_run(threads, 16) == 0,
+            "memory_pool_%d_threads", threads);
+    }
+
+    /* a slab big enough to be backed by huge pages */
+    ok(memory_pool_test_run(
+            8, 2 * 1024 * 1024 / sizeof(memory_pool_test_node_t)) == 0,
+        "memory_pool_hugepage_slabs");
+
+    ok(memory_pool_test_turns(MEMORY_POOL_TEST_MAX_THREADS) ==
+            MEMORY_POOL_TEST_SMALL_POOL,
+        "memory_pool_small_pool_not_grown");
+
+    globus_mutex_destroy(&memory_pool_test_lock);
+    globus_cond_destroy(&memory_pool_test_cond);
+    globus_module_deactivate(GLOBUS_COMMON_MODULE);
+
+    return TEST_EXIT_CODE;
+}
@@ -28,6 +28,7 @@
 #include "globus_gass_copy.h"
 #include "globus_ftp_client_debug_plugin.h"
 #include "globus_ftp_client_restart_plugin.h"
+#include "globus_ftp_client_autotune_plugin.h"
 #include "globus_error_gssapi.h"
 #include "globus_gsi_system_config.h"
 
@@ -144,6 +145,7 @@ int guc_gencert(gss_buffer_desc * buf)
         
         
 #define GUC_URL_ENC_CHAR "#;:=+ ,"
+#define GUC_AUTOTUNE_MAX_PARALLELISM 32
 
 /******************************************************************************
                                Type definitions
@@ -176,6 +178,8 @@ typedef struct
     globus_off_t                        offset;
     globus_off_t                        length;
     globus_l_guc_url_info_t *           src_info;
+    /* destination listing entry, when a sync checksum is still due */
+    globus_l_guc_url_info_t *           sync_dst_info;
 } globus_l_guc_src_dst_pair_t;
 
 typedef struct globus_l_guc_handle_s
@@ -338,6 +342,15 @@ globus_l_gass_copy_performance_cb(
     float                                           instantaneous_throughput,
     float                                           avg_throughput);
 
+static
+void
+globus_l_guc_autotune_cb(
+    void *                                          user_arg,
+    globus_ftp_client_handle_t *                    handle,
+    int                                             parallelism,
+    globus_size_t                                   block_size,
+    float                                           throughput);
+
 static
 void
 globus_l_guc_entry_cb(
@@ -376,6 +389,15 @@ globus_result_t
 globus_l_guc_expand_single_url(
     globus_l_guc_transfer_t *           transfer_info);
 
+static
+globus_result_t
+globus_l_guc_compare_cksm(
+    globus_l_guc_info_t *               guc_info,
+    globus_l_guc_handle_t *             handle,
+    globus_l_guc_url_info_t *           src_urlinfo,
+    globus_l_guc_url_info_t *           dest_urlinfo,
+    globus_bool_t *                     mismatch);
+
 static
 globus_result_t
 globus_l_guc_transfer_files(
@@ -570,6 +592,11 @@ const char * long_usage =
 "       underlying transfer methods\n"
 "  -p <parallelism> | -parallel <parallelism>\n"
 "       specify the number of parallel data connections should be used.\n"
+"  -at | -autotune\n"
+"       adjust the number of parallel data connections while ftp gets and\n"
+"       third party transfers run, starting from -p (default 1).  Later\n"
+"       transfers start from the last setting picked.  With -vb the\n"
+"       settings are printed along with a suggested -bs.\n"
    
 "  -notpt | -no-third-party-transfers\n"
 "       turn third-party transfers off (on by default)\n"
@@ -784,6 +811,7 @@ enum
     arg_v, 
     arg_debugftp, 
     arg_restart,
+    arg_autotune,
     arg_rst_retries, 
     arg_rst_interval, 
     arg_rst_timeout, 
@@ -883,6 +911,7 @@ flagdef(arg_v, "-v", "-verbose");
 flagdef(arg_vb, "-vb", "-verbose-perf");
 flagdef(arg_debugftp, "-dbg", "-debugftp");
 flagdef(arg_restart, "-rst", "-restart");
+flagdef(arg_autotune, "-at", "-autotune");
 flagdef(arg_notpt, "-notpt", "-no-third-party-transfers");
 flagdef(arg_nodcau, "-nodcau", "-no-data-channel-authentication");
 flagdef(arg_data_safe, "-dcsafe", "-data-channel-safe");
@@ -987,6 +1016,7 @@ static globus_args_option_descriptor_t args_options[arg_num];
     setupopt(arg_vb);                   \
     setupopt(arg_debugftp);             \
     setupopt(arg_restart);              \
+    setupopt(arg_autotune);             \
     setupopt(arg_rst_retries);          \
     setupopt(arg_rst_interval);         \
     setupopt(arg_rst_timeout);          \
@@ -1060,9 +1090,12 @@ static int      g_ext_arg_count = 0;
 static int      g_transfer_timeout = 0;
 static globus_bool_t g_use_debug = GLOBUS_FALSE;
 static globus_bool_t g_use_restart = GLOBUS_FALSE;
+static globus_bool_t g_use_autotune = GLOBUS_FALSE;
 static globus_bool_t g_continue = GLOBUS_FALSE;
 static char *        g_err_msg;
 static globus_l_guc_monitor_t           g_monitor = {};
+/* guards guc_info->num_streams once the autotune plugin may change it */
+static globus_mutex_t                   g_autotune_mutex;
 
 /* for multicast stuff */
 static globus_fifo_t                    guc_mc_url_q;
@@ -1179,7 +1212,11 @@ globus_l_guc_ext(
     ext_info.options = guc_info->options;
     ext_info.block_size = guc_info->block_size;
     ext_info.tcp_buffer_size = guc_info->tcp_buffer_size;
-    ext_info.num_streams = guc_info->num_streams;
+    globus_mutex_lock(&g_autotune_mutex);
+    {
+        ext_info.num_streams = guc_info->num_streams;
+    }
+    globus_mutex_unlock(&g_autotune_mutex);
     ext_info.conc = guc_info->conc;
     ext_info.no_3pt = guc_info->no_3pt;
     ext_info.no_dcau = guc_info->no_dcau;
@@ -1701,6 +1738,61 @@ globus_l_guc_dump_urls(
 }
 
 
+/*
+ * finish a sync level 3 check left by globus_l_guc_check_sync(), on the
+ * handle that picked up the pair.  do_transfer is cleared if the
+ * destination already has the same checksum.
+ */
+static
+globus_result_t
+globus_l_guc_sync_cksm(
+    globus_l_guc_transfer_t *           transfer_info,
+    globus_bool_t *                     do_transfer)
+{
+    globus_l_guc_handle_t *             handle;
+    globus_l_guc_info_t *               guc_info;
+    globus_l_guc_src_dst_pair_t *       urls;
+    globus_result_t                     result;
+
+    handle = transfer_info->handle;
+    guc_info = transfer_info->guc_info;
+    urls = transfer_info->urls;
+
+    globus_l_guc_gass_attr_init(
+        &handle->source_gass_copy_attr,
+        &handle->source_gass_attr,
+        &handle->source_ftp_attr,
+        guc_info,
+        urls->src_url,
+        GLOBUS_TRUE,
+        GLOBUS_TRUE);
+    globus_l_guc_gass_attr_init(
+        &handle->dest_gass_copy_attr,
+        &handle->dest_gass_attr,
+        &handle->dest_ftp_attr,
+        guc_info,
+        urls->sync_dst_info->url,
+        GLOBUS_FALSE,
+        GLOBUS_TRUE);
+
+    result = globus_l_guc_compare_cksm(
+        guc_info,
+        handle,
+        urls->src_info,
+        urls->sync_dst_info,
+        do_transfer);
+
+    globus_ftp_client_operationattr_destroy(&handle->source_ftp_attr);
+    handle->source_ftp_attr = NULL;
+    globus_ftp_client_operationattr_destroy(&handle->dest_ftp_attr);
+    handle->dest_ftp_attr = NULL;
+
+    globus_l_guc_url_info_free(urls->sync_dst_info);
+    urls->sync_dst_info = NULL;
+
+    return result;
+}
+
 static
 void
 globus_l_guc_transfer_kickout(
@@ -1764,6 +1856,34 @@ globus_l_guc_transfer_kickout(
     }
     globus_mutex_unlock(&g_monitor.mutex);
     
+    if(expanded && transfer_info->urls->sync_dst_info)
+    {
+        result = globus_l_guc_sync_cksm(transfer_info, &expanded);
+        if(result != GLOBUS_SUCCESS)
+        {
+            if(!g_continue)
+            {
+                err = globus_error_get(result);
+                expanded = GLOBUS_FALSE;
+            }
+            else
+            {
+                globus_object_free(globus_error_get(result));
+            }
+        }
+        if(!expanded)
+        {
+            /* in sync already, or failed to tell */
+            globus_l_url_copy_monitor_callback(
+                transfer_info, &transfer_info->handle->gass_copy_handle, err);
+            if(err)
+            {
+                globus_object_free(err);
+            }
+            return;
+        }
+    }
+
     if(expanded)
     {        
         result = globus_l_guc_transfer(transfer_info);
@@ -1893,6 +2013,7 @@ main(int argc, char **argv)
     globus_fifo_init(&guc_info.user_url_list);
     globus_fifo_init(&guc_info.expanded_url_list);
     globus_fifo_init(&guc_info.dump_url_list);
+    globus_mutex_init(&g_autotune_mutex, NULL);
 
     /* parse user parms */
     if(globus_l_guc_parse_arguments(
@@ -2070,6 +2191,7 @@ main(int argc, char **argv)
     
     globus_mutex_destroy(&g_monitor.mutex);
     globus_cond_destroy(&g_monitor.cond);
+    globus_mutex_destroy(&g_autotune_mutex);
 
     globus_l_guc_info_destroy(&guc_info);
     
@@ -2181,6 +2303,43 @@ globus_l_gass_copy_performance_cb(
     guc_l_newline_exit = GLOBUS_TRUE;
 }
 
+/* remember what the autotune plugin picked for the transfers after this */
+static
+void
+globus_l_guc_autotune_cb(
+    void *                                          user_arg,
+    globus_ftp_client_handle_t *                    handle,
+    int                                             parallelism,
+    globus_size_t                                   block_size,
+    float                                           throughput)
+{
+    globus_l_guc_info_t *                           guc_info;
+
+    guc_info = (globus_l_guc_info_t *) user_arg;
+
+    /*
+     * not under g_monitor: this can be called from the client's completion
+     * path while the transfer callbacks hold it.  g_autotune_mutex is only
+     * held around num_streams itself.
+     */
+    globus_mutex_lock(&g_autotune_mutex);
+    {
+        guc_info->num_streams = parallelism;
+    }
+    globus_mutex_unlock(&g_autotune_mutex);
+
+    if(g_verbose_flag)
+    {
+        globus_libc_fprintf(stdout,
+            "\nautotune: %d streams, suggested block size %lu"
+            " (%.2f MB/sec)\n",
+            parallelism,
+            (unsigned long) block_size,
+            throughput / (1024 * 1024));
+        fflush(stdout);
+    }
+}
+
 void
 globus_guc_copy_performance_update(
     globus_off_t                                    total_bytes,
@@ -2533,6 +2692,7 @@ globus_l_guc_parse_file(
         ent->offset = offset;
         ent->length = length;
         ent->src_info = NULL;
+        ent->sync_dst_info = NULL;
         globus_fifo_enqueue(user_url_list, ent);
     }
 
@@ -2871,6 +3031,7 @@ globus_l_guc_transfer(
                     url_pair->length = transfer_info->urls->length;
                     url_pair->src_info = transfer_info->urls->src_info;
                     transfer_info->urls->src_info = NULL;
+                    url_pair->sync_dst_info = NULL;
                     
                     globus_l_guc_enqueue_pair(
                         &guc_info->dump_url_list, 
@@ -2944,7 +3105,8 @@ globus_l_guc_transfer(
                     url_pair->offset = transfer_info->urls->offset;
                     url_pair->length = transfer_info->urls->length;
                     url_pair->src_info = transfer_info->urls->src_info;
-                    transfer_info->urls->src_info = NULL;                    
+                    transfer_info->urls->src_info = NULL;
+                    url_pair->sync_dst_info = NULL;
                     
                     globus_l_guc_enqueue_pair(
                         &guc_info->dump_url_list, 
@@ -3884,6 +4046,9 @@ globus_l_guc_parse_arguments(
         case arg_restart:
             g_use_restart = GLOBUS_TRUE;
             break;
+        case arg_autotune:
+            g_use_autotune = GLOBUS_TRUE;
+            break;
         case arg_rst_retries:
             guc_info->restart_retries = atoi(instance->values[0]);
             break;
@@ -4331,6 +4496,7 @@ globus_l_guc_parse_arguments(
             ent->offset = guc_info->partial_offset;
             ent->length = guc_info->partial_length;
             ent->src_info = NULL;
+            ent->sync_dst_info = NULL;
  
             globus_fifo_enqueue(&guc_info->user_url_list, ent);
         }
@@ -4431,6 +4597,12 @@ globus_l_guc_parse_arguments(
         guc_info->num_streams = 1;
     }
 
+    /* parallelism is only tunable in mode E */
+    if(g_use_autotune && guc_info->num_streams < 1)
+    {
+        guc_info->num_streams = 1;
+    }
+
     if(guc_info->udt)
     {
         /* need to verify nothing else was set */
@@ -4766,6 +4938,7 @@ globus_l_guc_expand_urls(
             expanded_url_pair->offset = user_url_pair->offset;
             expanded_url_pair->length = user_url_pair->length;
             expanded_url_pair->src_info = NULL;
+            expanded_url_pair->sync_dst_info = NULL;
             
             if(guc_info->create_dest && !guc_info->dump_only_file)
             {
@@ -4952,6 +5125,140 @@ globus_l_guc_cksm_cb(
 }
 
 
+/*
+ * checksum the source and destination at the same time, the destination
+ * over a connection borrowed from the source handle.  sets mismatch unless
+ * both checksums were taken and are the same.
+ */
+static
+globus_result_t
+globus_l_guc_compare_cksm(
+    globus_l_guc_info_t *               guc_info,
+    globus_l_guc_handle_t *             handle,
+    globus_l_guc_url_info_t *           src_urlinfo,
+    globus_l_guc_url_info_t *           dest_urlinfo,
+    globus_bool_t *                     mismatch)
+{
+    globus_result_t                     result = GLOBUS_SUCCESS;
+    globus_l_guc_cksm_info_t            src_cksm_info;
+    globus_l_guc_cksm_info_t            dst_cksm_info;
+    globus_l_guc_monitor_t              cksm_monitor;
+    globus_ftp_client_handle_t          real_ftp_handle;
+    globus_ftp_client_handle_t          cksm_ftp_handle;
+
+    *mismatch = GLOBUS_TRUE;
+
+    globus_mutex_init(&cksm_monitor.mutex, NULL);
+    globus_cond_init(&cksm_monitor.cond, NULL);
+
+    src_urlinfo->checksum = malloc(CKSM_SIZE);
+    src_cksm_info.urlinfo = src_urlinfo;
+    src_cksm_info.done = GLOBUS_FALSE;
+    src_cksm_info.monitor = &cksm_monitor;
+    src_cksm_info.error = NULL;
+
+    result = globus_gass_copy_cksm_async(
+        &handle->gass_copy_handle,
+        src_urlinfo->url,
+        &handle->source_gass_copy_attr,
+        0,
+        -1,
+        guc_info->checksum_algo,
+        src_urlinfo->checksum,
+        globus_l_guc_cksm_cb,
+        &src_cksm_info);
+    if(result != GLOBUS_SUCCESS)
+    {
+        globus_free(src_urlinfo->checksum);
+        src_urlinfo->checksum = NULL;
+        goto error;
+    }
+
+    dest_urlinfo->checksum = malloc(CKSM_SIZE);
+    dst_cksm_info.urlinfo = dest_urlinfo;
+    dst_cksm_info.done = GLOBUS_FALSE;
+    dst_cksm_info.monitor = &cksm_monitor;
+    dst_cksm_info.error = NULL;
+
+    globus_gass_copy_get_ftp_handle(
+        &handle->gass_copy_handle, &real_ftp_handle);
+    globus_gass_copy_get_ftp_handle(
+        &handle->cksm_gass_copy_handle, &cksm_ftp_handle);
+    globus_ftp_client_handle_borrow_connection(
+        &real_ftp_handle, GLOBUS_FALSE, &cksm_ftp_handle, GLOBUS_TRUE);
+
+    result = globus_gass_copy_cksm_async(
+        &handle->cksm_gass_copy_handle,
+        dest_urlinfo->url,
+        &handle->dest_gass_copy_attr,
+        0,
+        -1,
+        guc_info->checksum_algo,
+        dest_urlinfo->checksum,
+        globus_l_guc_cksm_cb,
+        &dst_cksm_info);
+    if(result != GLOBUS_SUCCESS)
+    {
+        globus_free(dest_urlinfo->checksum);
+        dest_urlinfo->checksum = NULL;
+        globus_ftp_client_handle_borrow_connection(
+            &cksm_ftp_handle, GLOBUS_TRUE, &real_ftp_handle, GLOBUS_FALSE);
+
+        /* the source checksum still refers to this stack frame */
+        globus_mutex_lock(&cksm_monitor.mutex);
+        while(!src_cksm_info.done)
+        {
+            globus_cond_wait(
+                &cksm_monitor.cond, &cksm_monitor.mutex);
+        }
+        globus_mutex_unlock(&cksm_monitor.mutex);
+        if(src_cksm_info.error)
+        {
+            globus_object_free(src_cksm_info.error);
+        }
+        goto error;
+    }
+
+    globus_mutex_lock(&cksm_monitor.mutex);
+    while(!src_cksm_info.done || !dst_cksm_info.done)
+    {
+        globus_cond_wait(
+            &cksm_monitor.cond, &cksm_monitor.mutex);
+    }
+    globus_mutex_unlock(&cksm_monitor.mutex);
+
+    if(src_cksm_info.error)
+    {
+        result = globus_error_put(src_cksm_info.error);
+        globus_ftp_client_handle_borrow_connection(
+            &cksm_ftp_handle, GLOBUS_TRUE, &real_ftp_handle, GLOBUS_FALSE);
+
+        goto error;
+    }
+    if(dst_cksm_info.error)
+    {
+        result = globus_error_put(dst_cksm_info.error);
+        globus_ftp_client_handle_borrow_connection(
+            &cksm_ftp_handle, GLOBUS_TRUE, &real_ftp_handle, GLOBUS_FALSE);
+
+        goto error;
+    }
+
+    if(src_urlinfo->checksum && dest_urlinfo->checksum &&
+        strcmp(src_urlinfo->checksum, dest_urlinfo->checksum) == 0)
+    {
+        *mismatch = GLOBUS_FALSE;
+    }
+    globus_ftp_client_handle_borrow_connection(
+        &cksm_ftp_handle, GLOBUS_TRUE, &real_ftp_handle, GLOBUS_FALSE);
+
+error:
+    globus_cond_destroy(&cksm_monitor.cond);
+    globus_mutex_destroy(&cksm_monitor.mutex);
+
+    return result;
+}
+
 static
 globus_result_t
 globus_l_guc_check_sync(
@@ -4959,12 +5266,18 @@ globus_l_guc_check_sync(
     globus_l_guc_handle_t *             handle,
     globus_l_guc_url_info_t *           src_urlinfo,
     char *                              dst_url,
-    globus_bool_t *                     mismatch)
+    globus_bool_t *                     mismatch,
+    globus_l_guc_url_info_t **          cksm_dest_urlinfo)
 {
     globus_bool_t                       retval = GLOBUS_TRUE;
     globus_result_t                     result = GLOBUS_SUCCESS;
     globus_l_guc_url_info_t *           dest_urlinfo;
     
+    if(cksm_dest_urlinfo)
+    {
+        *cksm_dest_urlinfo = NULL;
+    }
+
     globus_mutex_lock(&g_monitor.mutex);
     dest_urlinfo = globus_hashtable_remove(&guc_info->dest_hash, dst_url);
     globus_mutex_unlock(&g_monitor.mutex);
@@ -4976,106 +5289,20 @@ globus_l_guc_check_sync(
             case GLOBUS_L_GUC_CKSM:
                 if(dest_urlinfo->size == src_urlinfo->size)
                 {
-                    globus_l_guc_cksm_info_t    src_cksm_info;
-                    globus_l_guc_cksm_info_t    dst_cksm_info;
-                    globus_l_guc_monitor_t      cksm_monitor;
-
-                    globus_mutex_init(&cksm_monitor.mutex, NULL);
-                    globus_cond_init(&cksm_monitor.cond, NULL);
-                    
-                    src_urlinfo->checksum = malloc(CKSM_SIZE);
-                    src_cksm_info.urlinfo = src_urlinfo;
-                    src_cksm_info.done = GLOBUS_FALSE;
-                    src_cksm_info.monitor = &cksm_monitor;
-                    src_cksm_info.error = NULL;
-                    
-                    result = globus_gass_copy_cksm_async(
-                        &handle->gass_copy_handle,
-                        src_urlinfo->url,
-                        &handle->source_gass_copy_attr,
-                        0,
-                        -1,
-                        guc_info->checksum_algo,
-                        src_urlinfo->checksum,
-                        globus_l_guc_cksm_cb,
-                        &src_cksm_info);
-                    if(result != GLOBUS_SUCCESS)
+                    if(cksm_dest_urlinfo)
                     {
-                        globus_free(src_urlinfo->checksum);
-                        src_urlinfo->checksum = NULL;
-                        goto error;
+                        /* leave the checksums to a free transfer handle */
+                        *cksm_dest_urlinfo = dest_urlinfo;
+                        dest_urlinfo = NULL;
+                        break;
                     }
-                    globus_ftp_client_handle_t      real_ftp_handle;
-                    globus_ftp_client_handle_t      cksm_ftp_handle;
-                    
-                    dest_urlinfo->checksum = malloc(CKSM_SIZE);
-                    dst_cksm_info.urlinfo = dest_urlinfo;
-                    dst_cksm_info.done = GLOBUS_FALSE;
-                    dst_cksm_info.monitor = &cksm_monitor;
-                    dst_cksm_info.error = NULL;
-                    
-                    globus_gass_copy_get_ftp_handle(
-                        &handle->gass_copy_handle, &real_ftp_handle);
-                    globus_gass_copy_get_ftp_handle(
-                        &handle->cksm_gass_copy_handle, &cksm_ftp_handle);
-                    globus_ftp_client_handle_borrow_connection(
-                        &real_ftp_handle, GLOBUS_FALSE, &cksm_ftp_handle, GLOBUS_TRUE);
-                    
-                    result = globus_gass_copy_cksm_async(
-                        &handle->cksm_gass_copy_handle,
-                        dest_urlinfo->url,
-                        &handle->dest_gass_copy_attr,
-                        0,
-                        -1,
-                        guc_info->checksum_algo,
-                        dest_urlinfo->checksum,
-                        globus_l_guc_cksm_cb,
-                        &dst_cksm_info);
+                    result = globus_l_guc_compare_cksm(
+                        guc_info, handle, src_urlinfo, dest_urlinfo, &retval);
                     if(result != GLOBUS_SUCCESS)
                     {
-                        globus_free(dest_urlinfo->checksum);
-                        dest_urlinfo->checksum = NULL;
-                        globus_ftp_client_handle_borrow_connection(
-                            &cksm_ftp_handle, GLOBUS_TRUE, &real_ftp_handle, GLOBUS_FALSE);
-
-                        goto error;
-                    }
-                        
-                    globus_mutex_lock(&cksm_monitor.mutex);
-                    while(!src_cksm_info.done || !dst_cksm_info.done)
-                    {
-                        globus_cond_wait(
-                            &cksm_monitor.cond, &cksm_monitor.mutex);
-                    }
-                    globus_mutex_unlock(&cksm_monitor.mutex);
-                    
-                    if(src_cksm_info.error)
-                    {
-                        result = globus_error_put(src_cksm_info.error);
-                        globus_ftp_client_handle_borrow_connection(
-                            &cksm_ftp_handle, GLOBUS_TRUE, &real_ftp_handle, GLOBUS_FALSE);
-
+                        globus_l_guc_url_info_free(dest_urlinfo);
                         goto error;
                     }
-                    if(dst_cksm_info.error)
-                    {
-                        result = globus_error_put(dst_cksm_info.error);
-                        globus_ftp_client_handle_borrow_connection(
-                            &cksm_ftp_handle, GLOBUS_TRUE, &real_ftp_handle, GLOBUS_FALSE);
-
-                        goto error;
-                    }
-                    
-                    if(src_urlinfo->checksum && dest_urlinfo->checksum &&
-                        strcmp(src_urlinfo->checksum, dest_urlinfo->checksum) == 0)
-                    {
-                        retval = GLOBUS_FALSE;
-                    }
-                    globus_ftp_client_handle_borrow_connection(
-                        &cksm_ftp_handle, GLOBUS_TRUE, &real_ftp_handle, GLOBUS_FALSE);
-
-                    globus_cond_destroy(&cksm_monitor.cond);
-                    globus_mutex_destroy(&cksm_monitor.mutex);
                 }
                 break;
 
@@ -5140,6 +5367,7 @@ globus_l_guc_expand_single_url(
     globus_l_guc_info_t *               guc_info;
     globus_l_guc_handle_t *             handle;
     globus_bool_t                       do_transfer = GLOBUS_TRUE;
+    globus_l_guc_url_info_t *           cksm_dest_urlinfo = NULL;
     int                                 rc; 
     
     src_url = transfer_info->urls->src_url;
@@ -5328,8 +5556,15 @@ globus_l_guc_expand_single_url(
         }
         if(guc_info->sync)
         {
+            /* checksums are compared when a transfer handle picks up the
+             * pair, so the -cc handles work through them in parallel */
             result = globus_l_guc_check_sync(
-                guc_info, handle, matched_src_urlinfo, matched_dest_url, &do_transfer);
+                guc_info,
+                handle,
+                matched_src_urlinfo,
+                matched_dest_url,
+                &do_transfer,
+                guc_info->dump_only_fp ? NULL : &cksm_dest_urlinfo);
             if(result != GLOBUS_SUCCESS && !g_continue)
             {
                 goto error_expand;
@@ -5343,7 +5578,7 @@ globus_l_guc_expand_single_url(
              * See if a post transfer checksum comparison has been requested
              */   
 
-            if(guc_info->comp_checksum) 
+            if(guc_info->comp_checksum && cksm_dest_urlinfo == NULL) 
             {
                 if(matched_src_urlinfo->checksum == GLOBUS_NULL)
                 {
@@ -5425,6 +5660,8 @@ globus_l_guc_expand_single_url(
             expanded_url_pair->offset = transfer_info->urls->offset;
             expanded_url_pair->length = transfer_info->urls->length;
             expanded_url_pair->src_info = matched_src_urlinfo;
+            expanded_url_pair->sync_dst_info = cksm_dest_urlinfo;
+            cksm_dest_urlinfo = NULL;
             
             matched_src_urlinfo->url = NULL;
                 
@@ -5459,6 +5696,7 @@ error_too_many_matches:
 error_mkdir:
 error_expand:
 error_checksum:
+    globus_l_guc_url_info_free(cksm_dest_urlinfo);
     return result;                
 }
 
@@ -5495,6 +5733,11 @@ globus_l_guc_pipeline(
         {
             none = GLOBUS_TRUE;
         }
+        /* sync checksums have to be compared before the transfer */
+        if(pair->sync_dst_info)
+        {
+            none = GLOBUS_TRUE;
+        }
         
         if(strncmp(pair->src_url, "file:/", 5) == 0 || 
             strncmp(pair->src_url, "http", 4) == 0 ||
@@ -5551,6 +5794,7 @@ globus_l_guc_init_gass_copy_handle(
     globus_result_t                                 result;
     globus_ftp_client_plugin_t                      debug_plugin;
     globus_ftp_client_plugin_t                      restart_plugin;
+    globus_ftp_client_plugin_t                      autotune_plugin;
     globus_reltime_t                                interval;
     globus_abstime_t                                timeout;
     globus_abstime_t *                              timeout_p = GLOBUS_NULL;
@@ -5748,6 +5992,35 @@ globus_l_guc_init_gass_copy_handle(
         }
     }        
 
+    if(g_use_autotune)
+    {
+        result = globus_ftp_client_autotune_plugin_init(
+            &autotune_plugin,
+            1,
+            (guc_info->num_streams > GUC_AUTOTUNE_MAX_PARALLELISM)
+                ? guc_info->num_streams : GUC_AUTOTUNE_MAX_PARALLELISM,
+            globus_l_guc_autotune_cb,
+            guc_info);
+        if(result != GLOBUS_SUCCESS)
+        {
+            fprintf(stderr, _GASCSL("Error: Unable to init autotune plugin %s\n"),
+                globus_error_print_friendly(globus_error_peek(result)));
+
+            return -1;
+        }
+
+        result = globus_ftp_client_handleattr_add_plugin(
+            &ftp_handleattr,
+            &autotune_plugin);
+        if(result != GLOBUS_SUCCESS)
+        {
+            fprintf(stderr, _GASCSL("Error: Unable to register autotune plugin %s\n"),
+                globus_error_print_friendly(globus_error_peek(result)));
+
+            return -1;
+        }
+    }
+
     if(guc_info->rfc1738)
     {
         result = globus_ftp_client_handleattr_set_rfc1738_url(
@@ -5784,6 +6057,9 @@ globus_l_guc_init_gass_copy_handle(
 
             return -1;
         }
+        /* don't wait on each transfer parameter command either */
+        globus_ftp_client_handleattr_set_pipeline_params(
+            &ftp_handleattr, GLOBUS_TRUE);
     }        
     
     globus_gass_copy_handleattr_set_ftp_attr(
@@ -5837,6 +6113,13 @@ globus_l_guc_init_gass_copy_handle(
             &restart_plugin);
         globus_ftp_client_restart_plugin_destroy(&restart_plugin);
     }
+    if(g_use_autotune)
+    {
+        globus_ftp_client_handleattr_remove_plugin(
+            &ftp_handleattr,
+            &autotune_plugin);
+        globus_ftp_client_autotune_plugin_destroy(&autotune_plugin);
+    }
     if(g_use_debug)
     {
         globus_ftp_client_handleattr_remove_plugin(
@@ -5885,6 +6168,13 @@ globus_l_guc_gass_attr_init(
     char *                              tmp_disk_str = NULL;
     gss_cred_id_t                       cred = GSS_C_NO_CREDENTIAL;
     char *                              dcau_subj = NULL;
+    int                                 num_streams;
+
+    globus_mutex_lock(&g_autotune_mutex);
+    {
+        num_streams = guc_info->num_streams;
+    }
+    globus_mutex_unlock(&g_autotune_mutex);
 
     if(src)
     {                  
@@ -5933,14 +6223,14 @@ globus_l_guc_gass_attr_init(
                 &tcp_buffer);
         }
 
-        if(guc_info->num_streams >= 1)
+        if(num_streams >= 1)
         {
             globus_ftp_client_operationattr_set_mode(
                 ftp_attr,
                 GLOBUS_FTP_CONTROL_MODE_EXTENDED_BLOCK);
 
             parallelism.mode = GLOBUS_FTP_CONTROL_PARALLELISM_FIXED;
-            parallelism.fixed.size = guc_info->num_streams;
+            parallelism.fixed.size = num_streams;
             globus_ftp_client_operationattr_set_parallelism(
                 ftp_attr,
                 &parallelism); 
@@ -6241,6 +6531,7 @@ globus_l_guc_url_pair_free(
             globus_free(url_pair->dst_url);
         }
         globus_l_guc_url_info_free(url_pair->src_info);
+        globus_l_guc_url_info_free(url_pair->sync_dst_info);
         globus_free(url_pair);
     }
 }   
@@ -152,6 +152,7 @@ globus_gram_job_manager_init(
     manager->expiration_handle = GLOBUS_NULL_HANDLE;
     manager->lockcheck_handle = GLOBUS_NULL_HANDLE;
     manager->idle_script_handle = GLOBUS_NULL_HANDLE;
+    manager->state_journal = NULL;
 
     rc = globus_mutex_init(&manager->mutex, NULL);
     if (rc != GLOBUS_SUCCESS)
@@ -2224,6 +2225,9 @@ globus_gram_job_manager_request_load_all(
             "level=DEBUG "
             "\n");
 
+    /* Bring state files up to date from the journal before reading them */
+    globus_gram_job_manager_state_journal_init(manager);
+
     state_file_pattern = globus_common_create_string(
             "job.%s.%%"PRIu64".%%"PRIu64"%%n",
             manager->config->hostname);
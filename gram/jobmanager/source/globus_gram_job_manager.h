@@ -419,6 +419,36 @@ typedef struct
 }
 globus_gram_job_manager_scripts_t;
 
+/**
+ * Append-only journal of job state file updates.
+ *
+ * Each state file write or removal is logged here before the state file
+ * itself is changed, and many updates share one fsync of the journal.
+ * Compaction syncs the state files and empties the journal.
+ */
+typedef struct
+{
+    /** Lock for thread-safety */
+    globus_mutex_t                      mutex;
+    /** Journal file path */
+    char *                              path;
+    /** Journal file descriptor, opened for append */
+    int                                 fd;
+    /** Journal file length */
+    off_t                               size;
+    /** Directories containing state files, synced during compaction */
+    char *                              state_dirs[2];
+    /** Paths of state files changed since the last compaction */
+    globus_hashtable_t                  dirty_files;
+    /** Group commit oneshot, GLOBUS_NULL_HANDLE when none is pending */
+    globus_callback_handle_t            commit_handle;
+    /** Number of group commits done */
+    unsigned long                       commits;
+    /** Callbacks waiting for a group commit, in the order they came */
+    globus_fifo_t                       waiters;
+}
+globus_gram_job_manager_state_journal_t;
+
 /**
  * Runtime state for a LRM instance. All of these items are
  * computed from the configuration state above and may change during the
@@ -525,6 +555,12 @@ typedef struct globus_gram_job_manager_s
      * Periodic callback handle to clse idle perl script xio handles
      */
     globus_callback_handle_t            idle_script_handle;
+
+    /**
+     * Journal of state file updates, NULL unless this is the job manager
+     * holding the lock.
+     */
+    globus_gram_job_manager_state_journal_t * state_journal;
 }
 globus_gram_job_manager_t;
 
@@ -1338,6 +1374,37 @@ int
 globus_gram_job_manager_state_file_register_update(
     globus_gram_jobmanager_request_t *  request);
 
+void
+globus_gram_job_manager_state_file_remove(
+    globus_gram_jobmanager_request_t *  request);
+
+/* globus_gram_job_manager_state_journal.c */
+int
+globus_gram_job_manager_state_journal_init(
+    globus_gram_job_manager_t *         manager);
+
+void
+globus_gram_job_manager_state_journal_destroy(
+    globus_gram_job_manager_t *         manager);
+
+int
+globus_gram_job_manager_state_journal_write(
+    globus_gram_job_manager_t *         manager,
+    const char *                        state_file,
+    const char *                        tmp_file,
+    FILE *                              fp);
+
+int
+globus_gram_job_manager_state_journal_remove(
+    globus_gram_job_manager_t *         manager,
+    const char *                        state_file);
+
+globus_bool_t
+globus_gram_job_manager_state_journal_wait(
+    globus_gram_job_manager_t *         manager,
+    globus_callback_func_t              callback,
+    void *                              user_arg);
+
 /* globus_gram_job_manager_script.c */
 int 
 globus_gram_job_manager_script_stage_in(
@@ -45,6 +45,11 @@ globus_l_gram_callback_queue(
     globus_gram_job_manager_t *         manager,
     globus_gram_job_callback_context_t *context);
 
+static
+void
+globus_l_gram_callback_committed(
+    void *                              user_arg);
+
 static
 void
 globus_l_gram_callback_reply(
@@ -961,7 +966,20 @@ globus_gram_job_manager_contact_state_callback(
         goto nothing_to_send;
     }
 
-    rc = globus_l_gram_callback_queue(request->manager, context);
+    /* Don't tell anyone about the state change before its state file is
+     * durable; callbacks sharing a journal commit go out after it.
+     */
+    if (globus_gram_job_manager_state_journal_wait(
+            request->manager,
+            globus_l_gram_callback_committed,
+            context))
+    {
+        rc = GLOBUS_SUCCESS;
+    }
+    else
+    {
+        rc = globus_l_gram_callback_queue(request->manager, context);
+    }
     if (rc != GLOBUS_SUCCESS)
     {
         globus_gram_job_manager_request_log(
@@ -1425,6 +1443,66 @@ failed_enqueue:
 }
 /* globus_l_gram_callback_queue() */
 
+/**
+ * Queue a job state callback once the journal commit it waited for is done
+ */
+static
+void
+globus_l_gram_callback_committed(
+    void *                              user_arg)
+{
+    globus_gram_job_callback_context_t *context = user_arg;
+    globus_gram_jobmanager_request_t *  request = context->request;
+    globus_gram_job_manager_t *         manager = request->manager;
+    globus_reltime_t                    delay;
+    int                                 rc;
+
+    rc = globus_l_gram_callback_queue(manager, context);
+    if (rc == GLOBUS_SUCCESS)
+    {
+        return;
+    }
+
+    globus_gram_job_manager_request_log(
+            request,
+            GLOBUS_GRAM_JOB_MANAGER_LOG_WARN,
+            "event=gram.callback.end "
+            "level=WARN "
+            "gramid=%s "
+            "status=%d "
+            "msg=\"%s\" "
+            "reason=\"%s\"\n",
+            request->job_contact_path,
+            -rc,
+            "Error queuing callback messages",
+            globus_gram_protocol_error_string(rc));
+
+    while (!globus_list_empty(context->contacts))
+    {
+        free(globus_list_remove(&context->contacts, context->contacts));
+    }
+    free(context->message);
+
+    GlobusGramJobManagerRequestLock(request);
+    if (context->restart_state_when_done)
+    {
+        GlobusTimeReltimeSet(delay, request->two_phase_commit, 0);
+
+        rc = globus_gram_job_manager_state_machine_register(
+                manager,
+                request,
+                &delay);
+    }
+    globus_gram_job_manager_remove_reference(
+           manager,
+           request->job_contact_path,
+           "Job state callbacks");
+    GlobusGramJobManagerRequestUnlock(request);
+
+    free(context);
+}
+/* globus_l_gram_callback_committed() */
+
 static
 void
 globus_l_gram_callback_reply(
@@ -38,6 +38,28 @@ enum
     GRAM_JOB_MANAGER_COMMIT_TIMEOUT=60
 };
 
+/* Job contact reply waiting for the journal commit of its state file */
+typedef struct
+{
+    globus_gram_jobmanager_request_t *  request;
+    int                                 response_code;
+    int                                 response_fd;
+}
+globus_l_gram_deferred_reply_t;
+
+static
+globus_bool_t
+globus_l_gram_defer_reply(
+    globus_gram_job_manager_t *         manager,
+    globus_gram_jobmanager_request_t *  request,
+    int                                 response_code,
+    int                                 response_fd);
+
+static
+void
+globus_l_gram_reply_committed(
+    void *                              user_arg);
+
 static
 int
 globus_l_gram_symboltable_add(
@@ -1158,6 +1180,19 @@ bad_request:
         break;
     }
 
+    if (rc == GLOBUS_SUCCESS &&
+        request->failure_code == GLOBUS_SUCCESS &&
+        globus_l_gram_defer_reply(
+            manager,
+            request,
+            response_code,
+            response_fd))
+    {
+        /* Replied to and started once its state file is committed */
+        GlobusGramJobManagerRequestUnlock(request);
+        return GLOBUS_SUCCESS;
+    }
+
     rc2 = globus_gram_job_manager_reply(
             request,
             request->manager,
@@ -1186,6 +1221,131 @@ bad_request:
 }
 /* globus_gram_job_manager_request_start() */
 
+/**
+ * Put off the job contact reply until the state file is committed
+ *
+ * The client may act on the job contact as soon as it has it, so it mustn't
+ * get it before the state file naming the job is durable. Called with the
+ * request locked.
+ *
+ * @retval GLOBUS_TRUE
+ *     The reply will be sent and the state machine started after the next
+ *     journal commit.
+ * @retval GLOBUS_FALSE
+ *     The state file is already durable; the caller replies now.
+ */
+static
+globus_bool_t
+globus_l_gram_defer_reply(
+    globus_gram_job_manager_t *         manager,
+    globus_gram_jobmanager_request_t *  request,
+    int                                 response_code,
+    int                                 response_fd)
+{
+    globus_l_gram_deferred_reply_t *    reply;
+    int                                 rc;
+
+    if (manager->state_journal == NULL)
+    {
+        return GLOBUS_FALSE;
+    }
+
+    reply = malloc(sizeof(globus_l_gram_deferred_reply_t));
+    if (reply == NULL)
+    {
+        goto reply_malloc_failed;
+    }
+    reply->response_code = response_code;
+
+    /* The caller closes response_fd as soon as we return */
+    reply->response_fd = dup(response_fd);
+    if (reply->response_fd < 0)
+    {
+        goto dup_failed;
+    }
+    fcntl(reply->response_fd, F_SETFD, FD_CLOEXEC);
+
+    rc = globus_gram_job_manager_add_reference(
+            manager,
+            request->job_contact_path,
+            "deferred reply",
+            &reply->request);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        goto add_reference_failed;
+    }
+
+    if (globus_gram_job_manager_state_journal_wait(
+            manager,
+            globus_l_gram_reply_committed,
+            reply))
+    {
+        return GLOBUS_TRUE;
+    }
+
+    globus_gram_job_manager_remove_reference(
+            manager,
+            request->job_contact_path,
+            "deferred reply");
+add_reference_failed:
+    close(reply->response_fd);
+dup_failed:
+    free(reply);
+reply_malloc_failed:
+    return GLOBUS_FALSE;
+}
+/* globus_l_gram_defer_reply() */
+
+static
+void
+globus_l_gram_reply_committed(
+    void *                              user_arg)
+{
+    globus_l_gram_deferred_reply_t *    reply = user_arg;
+    globus_gram_jobmanager_request_t *  request = reply->request;
+    globus_gram_job_manager_t *         manager = request->manager;
+    globus_reltime_t                    delay;
+    int                                 rc;
+
+    GlobusGramJobManagerRequestLock(request);
+    rc = globus_gram_job_manager_reply(
+            request,
+            manager,
+            reply->response_code,
+            request->job_contact,
+            reply->response_fd,
+            request->response_context,
+            NULL);
+    close(reply->response_fd);
+
+    if (rc != GLOBUS_SUCCESS)
+    {
+        /* The client never got the job contact, so don't run the job */
+        request->failure_code = rc;
+        globus_gram_job_manager_request_set_status(
+                request,
+                GLOBUS_GRAM_PROTOCOL_JOB_STATE_FAILED);
+        request->jobmanager_state = GLOBUS_GRAM_JOB_MANAGER_STATE_FAILED;
+        request->unsent_status_change = GLOBUS_TRUE;
+    }
+
+    GlobusTimeReltimeSet(delay, 0, 0);
+
+    rc = globus_gram_job_manager_state_machine_register(
+            manager,
+            request,
+            &delay);
+
+    globus_gram_job_manager_remove_reference(
+            manager,
+            request->job_contact_path,
+            "deferred reply");
+    GlobusGramJobManagerRequestUnlock(request);
+
+    free(reply);
+}
+/* globus_l_gram_reply_committed() */
+
 /**
  * Deallocate memory related to a request.
  *
@@ -90,64 +90,28 @@ create_state_file_failed:
 }
 /* globus_gram_job_manager_state_file_set() */
 
+/**
+ * Write the state file contents for a job request to a stream
+ *
+ * @param request
+ *     The request to write the state of.
+ * @param fp
+ *     Stream to write to.
+ *
+ * @return
+ *     A negative value if any write fails, GLOBUS_SUCCESS otherwise.
+ */
+static
 int
-globus_gram_job_manager_state_file_write(
-    globus_gram_jobmanager_request_t *  request)
+globus_l_gram_state_file_print(
+    globus_gram_jobmanager_request_t *  request,
+    FILE *                              fp)
 {
-    int                                 rc = GLOBUS_SUCCESS;
-    FILE *                              fp = NULL;
-    char                                tmp_file[1024] = { 0 };
-
-    globus_gram_job_manager_request_log(
-            request,
-            GLOBUS_GRAM_JOB_MANAGER_LOG_TRACE,
-            "event=gram.write_state_file.start "
-            "level=TRACE "
-            "gramid=%s "
-            "path=\"%s\" "
-            "\n",
-            request->job_contact_path,
-            request->job_state_file);
-
-    /*
-     * We want the file update to be atomic, so create a new temp file,
-     * write the new information, close the new file, then rename the new
-     * file on top of the old one. The rename is the atomic update action.
-     */
-    strcpy( tmp_file, request->job_state_file );
-    strcat( tmp_file, ".tmp" );
-
-    fp = fopen( tmp_file, "w" );
-    if ( fp == NULL )
-    {
-        rc = GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
-
-        globus_gram_job_manager_request_log(
-                request,
-                GLOBUS_GRAM_JOB_MANAGER_LOG_ERROR,
-                "event=gram.write_state_file.end "
-                "level=ERROR "
-                "gramid=%s "
-                "path=\"%s\" "
-                "status=%d "
-                "msg=\"%s\" "
-                "errno=%d "
-                "reason=\"%s\"\n",
-                request->job_contact_path,
-                tmp_file,
-                -rc,
-                "Error opening state file",
-                errno,
-                strerror(errno));
-
-        return rc;
-    }
+    int                                 rc;
 
     rc = fprintf(fp, "%s\n", request->job_contact ? request->job_contact : " ");
     if (rc < 0)
     {
-        rc = GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
-
         goto error_exit;
     }
     rc = fprintf(fp, "%4d\n",
@@ -316,22 +280,44 @@ globus_gram_job_manager_state_file_write(
         goto error_exit;
     }
 
+    return GLOBUS_SUCCESS;
+
+error_exit:
+    return rc;
+}
+/* globus_l_gram_state_file_print() */
+
+int
+globus_gram_job_manager_state_file_write(
+    globus_gram_jobmanager_request_t *  request)
+{
+    int                                 rc = GLOBUS_SUCCESS;
+    FILE *                              fp = NULL;
+    char                                tmp_file[1024] = { 0 };
 
+    globus_gram_job_manager_request_log(
+            request,
+            GLOBUS_GRAM_JOB_MANAGER_LOG_TRACE,
+            "event=gram.write_state_file.start "
+            "level=TRACE "
+            "gramid=%s "
+            "path=\"%s\" "
+            "\n",
+            request->job_contact_path,
+            request->job_state_file);
 
     /*
-     * On some filsystems, write + rename is *not* atomic, so we explicitly
-     * flush to disk here. fdatasync might be better, but only on systems with
-     * POSIX realtime extensions
+     * We want the file update to be atomic, so create a new temp file,
+     * write the new information, close the new file, then rename the new
+     * file on top of the old one. The rename is the atomic update action.
      */
-    fflush(fp);
-    fsync(fileno(fp));
-    fclose( fp );
-    fp = NULL;
+    strcpy( tmp_file, request->job_state_file );
+    strcat( tmp_file, ".tmp" );
 
-    rc = rename( tmp_file, request->job_state_file );
-    if (rc != 0)
+    fp = fopen( tmp_file, "w+" );
+    if ( fp == NULL )
     {
-        rc = GLOBUS_FAILURE;
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
 
         globus_gram_job_manager_request_log(
                 request,
@@ -339,18 +325,97 @@ globus_gram_job_manager_state_file_write(
                 "event=gram.write_state_file.end "
                 "level=ERROR "
                 "gramid=%s "
-                "path=%s "
-                "status=-1 "
+                "path=\"%s\" "
+                "status=%d "
                 "msg=\"%s\" "
                 "errno=%d "
-                "reason=\"%s\" "
-                "\n",
+                "reason=\"%s\"\n",
                 request->job_contact_path,
-                request->job_state_file,
-                "Error renaming temporary state file",
+                tmp_file,
+                -rc,
+                "Error opening state file",
                 errno,
                 strerror(errno));
-        goto rename_failed;
+
+        return rc;
+    }
+
+    rc = globus_l_gram_state_file_print(request, fp);
+    if (rc < 0)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
+
+        goto error_exit;
+    }
+
+    if (request->manager != NULL && request->manager->state_journal != NULL)
+    {
+        /*
+         * The journal record is synced with the next group commit, and
+         * rewrites this file if we crash first, so no fsync here.
+         */
+        rc = globus_gram_job_manager_state_journal_write(
+                request->manager,
+                request->job_state_file,
+                tmp_file,
+                fp);
+        fp = NULL;
+
+        if (rc != GLOBUS_SUCCESS)
+        {
+            globus_gram_job_manager_request_log(
+                    request,
+                    GLOBUS_GRAM_JOB_MANAGER_LOG_ERROR,
+                    "event=gram.write_state_file.end "
+                    "level=ERROR "
+                    "gramid=%s "
+                    "path=%s "
+                    "status=%d "
+                    "msg=\"%s\" "
+                    "\n",
+                    request->job_contact_path,
+                    request->job_state_file,
+                    -rc,
+                    "Error journaling state file");
+            goto rename_failed;
+        }
+    }
+    else
+    {
+        /*
+         * On some filsystems, write + rename is *not* atomic, so we
+         * explicitly flush to disk here. fdatasync might be better, but only
+         * on systems with POSIX realtime extensions
+         */
+        fflush(fp);
+        fsync(fileno(fp));
+        fclose( fp );
+        fp = NULL;
+
+        rc = rename( tmp_file, request->job_state_file );
+        if (rc != 0)
+        {
+            rc = GLOBUS_FAILURE;
+
+            globus_gram_job_manager_request_log(
+                    request,
+                    GLOBUS_GRAM_JOB_MANAGER_LOG_ERROR,
+                    "event=gram.write_state_file.end "
+                    "level=ERROR "
+                    "gramid=%s "
+                    "path=%s "
+                    "status=-1 "
+                    "msg=\"%s\" "
+                    "errno=%d "
+                    "reason=\"%s\" "
+                    "\n",
+                    request->job_contact_path,
+                    request->job_state_file,
+                    "Error renaming temporary state file",
+                    errno,
+                    strerror(errno));
+            goto rename_failed;
+        }
     }
 
     globus_gram_job_manager_request_log(
@@ -396,6 +461,37 @@ rename_failed:
 }
 /* globus_gram_job_manager_state_file_write() */
 
+/**
+ * Remove the state file for a job request
+ *
+ * Called when the job is finished with, so that it won't be reloaded
+ * when the job manager restarts.
+ *
+ * @param request
+ *     The request whose state file is removed.
+ */
+void
+globus_gram_job_manager_state_file_remove(
+    globus_gram_jobmanager_request_t *  request)
+{
+    if (request->job_state_file == NULL)
+    {
+        return;
+    }
+
+    if (request->manager != NULL && request->manager->state_journal != NULL)
+    {
+        globus_gram_job_manager_state_journal_remove(
+                request->manager,
+                request->job_state_file);
+    }
+    else
+    {
+        remove(request->job_state_file);
+    }
+}
+/* globus_gram_job_manager_state_file_remove() */
+
 int
 globus_gram_job_manager_state_file_read(
     globus_gram_jobmanager_request_t *  request)
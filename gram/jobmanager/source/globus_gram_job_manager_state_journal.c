@@ -0,0 +1,1195 @@
+/*
+ * Copyright 1999-2009 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file globus_gram_job_manager_state_journal.c
+ * @brief Group-committed journal of job state file updates
+ *
+ * Writing a state file used to cost an fsync per job state change. The
+ * job manager which holds the LRM lock instead appends each new state file
+ * to a journal and writes the state file without syncing it. Updates made
+ * close together are synced by one fsync of the journal, a short time
+ * after the first of them. Replies and job state callbacks which depend
+ * on an update wait for its commit with
+ * globus_gram_job_manager_state_journal_wait(). Once the journal grows past
+ * GLOBUS_L_GRAM_STATE_JOURNAL_MAX_SIZE, the changed state files are synced
+ * and the journal emptied.
+ *
+ * When the job manager starts, before it reloads jobs, each state file
+ * in the journal is rewritten from its last complete record, so the state
+ * file read path sees what it would have had the files been synced.
+ *
+ * Each record is a header line
+ * <pre>
+ * GRAMJ <type> <path length> <data length> <crc32>
+ * </pre>
+ * followed by the state file path and, for type W, its contents. Type R
+ * records a removed state file. A record with a bad header or checksum
+ * ends the journal; it was torn by a crash before its commit.
+ */
+
+#include "globus_common.h"
+#include "globus_gram_job_manager.h"
+
+#include <string.h>
+
+#define GLOBUS_L_GRAM_STATE_JOURNAL_MAGIC "GRAMJ"
+#define GLOBUS_L_GRAM_STATE_JOURNAL_HEADER_MAX 64
+/** Delay before a group commit, in microseconds */
+#define GLOBUS_L_GRAM_STATE_JOURNAL_COMMIT_DELAY 10000
+#define GLOBUS_L_GRAM_STATE_JOURNAL_MAX_SIZE (4 * 1024 * 1024)
+
+typedef struct
+{
+    char                                type;
+    char *                              path;
+    const char *                        data;
+    size_t                              length;
+}
+globus_l_gram_state_journal_record_t;
+
+typedef struct
+{
+    globus_callback_func_t              callback;
+    void *                              user_arg;
+    /** Value of the journal's commits count once this may be called */
+    unsigned long                       commit;
+}
+globus_l_gram_state_journal_waiter_t;
+
+static
+void
+globus_l_gram_state_journal_commit(
+    void *                              user_arg);
+
+static
+uint32_t
+globus_l_gram_state_journal_crc(
+    uint32_t                            crc,
+    const char *                        buffer,
+    size_t                              length)
+{
+    int                                 i;
+
+    crc = ~crc;
+    while (length-- > 0)
+    {
+        crc ^= (unsigned char) *buffer++;
+        for (i = 0; i < 8; i++)
+        {
+            crc = (crc >> 1) ^ (0xedb88320 & (-(crc & 1)));
+        }
+    }
+    return ~crc;
+}
+/* globus_l_gram_state_journal_crc() */
+
+static
+int
+globus_l_gram_state_journal_write_all(
+    int                                 fd,
+    const char *                        buffer,
+    size_t                              length)
+{
+    ssize_t                             written;
+
+    while (length > 0)
+    {
+        written = write(fd, buffer, length);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        buffer += written;
+        length -= written;
+    }
+    return 0;
+}
+/* globus_l_gram_state_journal_write_all() */
+
+static
+void
+globus_l_gram_state_journal_mark_dirty(
+    globus_gram_job_manager_state_journal_t * journal,
+    const char *                        state_file)
+{
+    char *                              path;
+
+    if (globus_hashtable_lookup(
+            &journal->dirty_files, (void *) state_file) != NULL)
+    {
+        return;
+    }
+    path = strdup(state_file);
+    if (path == NULL)
+    {
+        return;
+    }
+    globus_hashtable_insert(&journal->dirty_files, path, path);
+}
+/* globus_l_gram_state_journal_mark_dirty() */
+
+/**
+ * Append a record to the journal and schedule a group commit
+ *
+ * Called with the journal locked. If the record can't be written
+ * completely, the journal is truncated back to where it started so a
+ * partial record doesn't hide the ones after it during recovery.
+ */
+static
+int
+globus_l_gram_state_journal_append(
+    globus_gram_job_manager_t *         manager,
+    char                                type,
+    const char *                        state_file,
+    const char *                        data,
+    size_t                              length)
+{
+    globus_gram_job_manager_state_journal_t * journal;
+    char                                header[
+                                        GLOBUS_L_GRAM_STATE_JOURNAL_HEADER_MAX];
+    size_t                              path_length = strlen(state_file);
+    uint32_t                            crc;
+    int                                 header_length;
+    char *                              record;
+    size_t                              record_length;
+    globus_reltime_t                    delay;
+    globus_result_t                     result;
+    int                                 rc = GLOBUS_SUCCESS;
+
+    journal = manager->state_journal;
+
+    crc = globus_l_gram_state_journal_crc(0, state_file, path_length);
+    crc = globus_l_gram_state_journal_crc(crc, data, length);
+
+    header_length = snprintf(
+            header,
+            sizeof(header),
+            "%s %c %lu %lu %08lx\n",
+            GLOBUS_L_GRAM_STATE_JOURNAL_MAGIC,
+            type,
+            (unsigned long) path_length,
+            (unsigned long) length,
+            (unsigned long) crc);
+
+    record_length = header_length + path_length + length;
+    record = malloc(record_length);
+    if (record == NULL)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+
+        goto malloc_record_failed;
+    }
+    memcpy(record, header, header_length);
+    memcpy(record + header_length, state_file, path_length);
+    if (length > 0)
+    {
+        memcpy(record + header_length + path_length, data, length);
+    }
+
+    if (globus_l_gram_state_journal_write_all(
+            journal->fd, record, record_length) != 0)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
+
+        globus_gram_job_manager_log(
+                manager,
+                GLOBUS_GRAM_JOB_MANAGER_LOG_ERROR,
+                "event=gram.state_journal.append.end "
+                "level=ERROR "
+                "path=\"%s\" "
+                "status=%d "
+                "msg=\"%s\" "
+                "errno=%d "
+                "reason=\"%s\" "
+                "\n",
+                journal->path,
+                -rc,
+                "Error appending to state journal",
+                errno,
+                strerror(errno));
+
+        /* Drop any partial record; the caller compacts the journal */
+        (void) ftruncate(journal->fd, journal->size);
+
+        goto write_failed;
+    }
+    journal->size += record_length;
+
+    if (journal->commit_handle == GLOBUS_NULL_HANDLE)
+    {
+        GlobusTimeReltimeSet(
+                delay, 0, GLOBUS_L_GRAM_STATE_JOURNAL_COMMIT_DELAY);
+
+        result = globus_callback_register_oneshot(
+                &journal->commit_handle,
+                &delay,
+                globus_l_gram_state_journal_commit,
+                manager);
+        if (result != GLOBUS_SUCCESS)
+        {
+            /* Commit this one now */
+            journal->commit_handle = GLOBUS_NULL_HANDLE;
+            fsync(journal->fd);
+        }
+    }
+
+write_failed:
+    free(record);
+malloc_record_failed:
+    return rc;
+}
+/* globus_l_gram_state_journal_append() */
+
+/**
+ * Sync the state files changed since the last compaction, then empty the
+ * journal
+ *
+ * Called with the journal locked. If any state file can't be synced, the
+ * journal is left alone so that recovery can still rewrite it. If the
+ * journal can't be emptied, it is removed and journaling stops, as its
+ * records would be older than the state files written after this.
+ */
+static
+int
+globus_l_gram_state_journal_compact(
+    globus_gram_job_manager_t *         manager)
+{
+    globus_gram_job_manager_state_journal_t * journal;
+    char *                              path;
+    int                                 fd;
+    int                                 i;
+    int                                 synced = 0;
+    int                                 rc = GLOBUS_SUCCESS;
+
+    journal = manager->state_journal;
+
+    for (path = globus_hashtable_first(&journal->dirty_files);
+         path != NULL;
+         path = globus_hashtable_next(&journal->dirty_files))
+    {
+        fd = open(path, O_RDONLY);
+        if (fd < 0)
+        {
+            if (errno != ENOENT)
+            {
+                rc = GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
+            }
+            continue;
+        }
+        if (fsync(fd) != 0)
+        {
+            rc = GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
+        }
+        close(fd);
+        synced++;
+    }
+    /* Renames and removals aren't durable until their directory is synced */
+    for (i = 0; i < 2; i++)
+    {
+        fd = open(journal->state_dirs[i], O_RDONLY);
+        if (fd >= 0)
+        {
+            fsync(fd);
+            close(fd);
+        }
+    }
+
+    if (rc != GLOBUS_SUCCESS)
+    {
+        globus_gram_job_manager_log(
+                manager,
+                GLOBUS_GRAM_JOB_MANAGER_LOG_WARN,
+                "event=gram.state_journal.compact.end "
+                "level=WARN "
+                "path=\"%s\" "
+                "status=%d "
+                "msg=\"%s\" "
+                "\n",
+                journal->path,
+                -rc,
+                "Unable to sync state files, keeping journal");
+
+        return rc;
+    }
+
+    if (ftruncate(journal->fd, 0) != 0 || fsync(journal->fd) != 0)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
+
+        globus_gram_job_manager_log(
+                manager,
+                GLOBUS_GRAM_JOB_MANAGER_LOG_ERROR,
+                "event=gram.state_journal.compact.end "
+                "level=ERROR "
+                "path=\"%s\" "
+                "status=%d "
+                "msg=\"%s\" "
+                "errno=%d "
+                "reason=\"%s\" "
+                "\n",
+                journal->path,
+                -rc,
+                "Unable to truncate state journal, no longer journaling",
+                errno,
+                strerror(errno));
+
+        unlink(journal->path);
+        close(journal->fd);
+        journal->fd = -1;
+
+        return rc;
+    }
+
+    globus_gram_job_manager_log(
+            manager,
+            GLOBUS_GRAM_JOB_MANAGER_LOG_DEBUG,
+            "event=gram.state_journal.compact.end "
+            "level=DEBUG "
+            "path=\"%s\" "
+            "size=%lu "
+            "files=%d "
+            "status=%d "
+            "\n",
+            journal->path,
+            (unsigned long) journal->size,
+            synced,
+            0);
+
+    journal->size = 0;
+    globus_hashtable_destroy_all(&journal->dirty_files, free);
+    globus_hashtable_init(
+            &journal->dirty_files,
+            1024,
+            globus_hashtable_string_hash,
+            globus_hashtable_string_keyeq);
+
+    return rc;
+}
+/* globus_l_gram_state_journal_compact() */
+
+/**
+ * Call the waiters whose updates have been committed
+ *
+ * Called without the journal locked, as the waiters lock their requests.
+ * Waiters queued since the last commit began are left for the next one.
+ */
+static
+void
+globus_l_gram_state_journal_release(
+    globus_gram_job_manager_state_journal_t * journal)
+{
+    globus_l_gram_state_journal_waiter_t * waiter;
+
+    do
+    {
+        waiter = NULL;
+        globus_mutex_lock(&journal->mutex);
+        if (!globus_fifo_empty(&journal->waiters))
+        {
+            waiter = globus_fifo_peek(&journal->waiters);
+            if (waiter->commit <= journal->commits)
+            {
+                (void) globus_fifo_dequeue(&journal->waiters);
+            }
+            else
+            {
+                waiter = NULL;
+            }
+        }
+        globus_mutex_unlock(&journal->mutex);
+
+        if (waiter != NULL)
+        {
+            waiter->callback(waiter->user_arg);
+            free(waiter);
+        }
+    }
+    while (waiter != NULL);
+}
+/* globus_l_gram_state_journal_release() */
+
+static
+void
+globus_l_gram_state_journal_commit(
+    void *                              user_arg)
+{
+    globus_gram_job_manager_t *         manager = user_arg;
+    globus_gram_job_manager_state_journal_t * journal;
+
+    journal = manager->state_journal;
+    if (journal == NULL)
+    {
+        return;
+    }
+
+    globus_mutex_lock(&journal->mutex);
+    journal->commit_handle = GLOBUS_NULL_HANDLE;
+
+    if (journal->fd < 0)
+    {
+        goto out;
+    }
+    if (fsync(journal->fd) != 0)
+    {
+        globus_gram_job_manager_log(
+                manager,
+                GLOBUS_GRAM_JOB_MANAGER_LOG_ERROR,
+                "event=gram.state_journal.commit.end "
+                "level=ERROR "
+                "path=\"%s\" "
+                "status=%d "
+                "errno=%d "
+                "reason=\"%s\" "
+                "\n",
+                journal->path,
+                -GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE,
+                errno,
+                strerror(errno));
+
+        /* Sync the state files themselves before anyone is told */
+        globus_l_gram_state_journal_compact(manager);
+    }
+    else if (journal->size > GLOBUS_L_GRAM_STATE_JOURNAL_MAX_SIZE)
+    {
+        globus_l_gram_state_journal_compact(manager);
+    }
+out:
+    journal->commits++;
+    globus_mutex_unlock(&journal->mutex);
+
+    globus_l_gram_state_journal_release(journal);
+}
+/* globus_l_gram_state_journal_commit() */
+
+static
+void
+globus_l_gram_state_journal_record_free(
+    void *                              datum)
+{
+    globus_l_gram_state_journal_record_t * record = datum;
+
+    free(record->path);
+    free(record);
+}
+/* globus_l_gram_state_journal_record_free() */
+
+/**
+ * Parse the journal and rewrite each state file in it from its last
+ * complete record.
+ *
+ * The rewritten files are marked dirty, so the compaction which follows
+ * syncs them before the journal is emptied.
+ */
+static
+int
+globus_l_gram_state_journal_recover(
+    globus_gram_job_manager_t *         manager)
+{
+    globus_gram_job_manager_state_journal_t * journal;
+    struct stat                         st;
+    char *                              buffer = NULL;
+    size_t                              buffer_length;
+    size_t                              offset = 0;
+    size_t                              record_start = 0;
+    ssize_t                             got;
+    globus_hashtable_t                  latest;
+    globus_l_gram_state_journal_record_t * record;
+    globus_l_gram_state_journal_record_t * old_record;
+    char *                              header_end;
+    char                                type;
+    unsigned long                       path_length;
+    unsigned long                       data_length;
+    unsigned long                       crc;
+    int                                 header_length;
+    int                                 records = 0;
+    globus_bool_t                       torn = GLOBUS_FALSE;
+    char *                              tmp_file;
+    FILE *                              fp;
+    int                                 rc = GLOBUS_SUCCESS;
+
+    journal = manager->state_journal;
+
+    if (fstat(journal->fd, &st) != 0)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_READING_STATE_FILE;
+
+        goto stat_failed;
+    }
+    if (st.st_size == 0)
+    {
+        goto stat_failed;
+    }
+
+    buffer_length = (size_t) st.st_size;
+    buffer = malloc(buffer_length + 1);
+    if (buffer == NULL)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+
+        goto stat_failed;
+    }
+    while (offset < buffer_length)
+    {
+        got = pread(journal->fd, buffer + offset, buffer_length - offset,
+                (off_t) offset);
+        if (got < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        else if (got <= 0)
+        {
+            break;
+        }
+        offset += got;
+    }
+    buffer_length = offset;
+    buffer[buffer_length] = '\0';
+
+    rc = globus_hashtable_init(
+            &latest,
+            1024,
+            globus_hashtable_string_hash,
+            globus_hashtable_string_keyeq);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+
+        goto hashtable_init_failed;
+    }
+
+    for (offset = 0; offset < buffer_length; )
+    {
+        record_start = offset;
+        header_end = memchr(
+                buffer + offset,
+                '\n',
+                buffer_length - offset);
+        if (header_end == NULL ||
+            header_end - (buffer + offset) >=
+                GLOBUS_L_GRAM_STATE_JOURNAL_HEADER_MAX)
+        {
+            torn = GLOBUS_TRUE;
+            break;
+        }
+        header_length = header_end - (buffer + offset) + 1;
+        *header_end = '\0';
+        if (sscanf(buffer + offset,
+                GLOBUS_L_GRAM_STATE_JOURNAL_MAGIC " %c %lu %lu %lx",
+                &type,
+                &path_length,
+                &data_length,
+                &crc) != 4 ||
+            (type != 'W' && type != 'R') ||
+            path_length == 0 ||
+            path_length > buffer_length - offset - header_length ||
+            data_length >
+                buffer_length - offset - header_length - path_length)
+        {
+            torn = GLOBUS_TRUE;
+            break;
+        }
+        offset += header_length;
+
+        if (globus_l_gram_state_journal_crc(
+                globus_l_gram_state_journal_crc(
+                    0, buffer + offset, path_length),
+                buffer + offset + path_length,
+                data_length) != (uint32_t) crc)
+        {
+            torn = GLOBUS_TRUE;
+            break;
+        }
+
+        record = malloc(sizeof(globus_l_gram_state_journal_record_t));
+        if (record == NULL)
+        {
+            rc = GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+            goto record_failed;
+        }
+        record->type = type;
+        record->path = globus_libc_strndup(buffer + offset, path_length);
+        record->data = buffer + offset + path_length;
+        record->length = data_length;
+        if (record->path == NULL)
+        {
+            free(record);
+            rc = GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+            goto record_failed;
+        }
+        offset += path_length + data_length;
+        records++;
+
+        old_record = globus_hashtable_remove(&latest, record->path);
+        if (old_record != NULL)
+        {
+            globus_l_gram_state_journal_record_free(old_record);
+        }
+        globus_hashtable_insert(&latest, record->path, record);
+    }
+    if (torn)
+    {
+        /* Records appended from now on must follow the last good one */
+        if (ftruncate(journal->fd, (off_t) record_start) == 0)
+        {
+            journal->size = (off_t) record_start;
+        }
+    }
+
+    for (record = globus_hashtable_first(&latest);
+         record != NULL;
+         record = globus_hashtable_next(&latest))
+    {
+        if (record->type == 'R')
+        {
+            remove(record->path);
+            globus_l_gram_state_journal_mark_dirty(journal, record->path);
+            continue;
+        }
+        tmp_file = globus_common_create_string("%s.tmp", record->path);
+        if (tmp_file == NULL)
+        {
+            rc = GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+            goto record_failed;
+        }
+        fp = fopen(tmp_file, "w");
+        if (fp == NULL ||
+            fwrite(record->data, 1, record->length, fp) != record->length ||
+            fclose(fp) != 0 ||
+            rename(tmp_file, record->path) != 0)
+        {
+            rc = GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
+
+            globus_gram_job_manager_log(
+                    manager,
+                    GLOBUS_GRAM_JOB_MANAGER_LOG_ERROR,
+                    "event=gram.state_journal.recover.end "
+                    "level=ERROR "
+                    "path=\"%s\" "
+                    "status=%d "
+                    "msg=\"%s\" "
+                    "errno=%d "
+                    "reason=\"%s\" "
+                    "\n",
+                    record->path,
+                    -rc,
+                    "Error rewriting state file",
+                    errno,
+                    strerror(errno));
+            remove(tmp_file);
+            free(tmp_file);
+            goto record_failed;
+        }
+        free(tmp_file);
+        globus_l_gram_state_journal_mark_dirty(journal, record->path);
+    }
+
+    globus_gram_job_manager_log(
+            manager,
+            torn ? GLOBUS_GRAM_JOB_MANAGER_LOG_WARN
+                 : GLOBUS_GRAM_JOB_MANAGER_LOG_INFO,
+            "event=gram.state_journal.recover.end "
+            "level=%s "
+            "path=\"%s\" "
+            "records=%d "
+            "files=%d "
+            "torn=%s "
+            "status=%d "
+            "\n",
+            torn ? "WARN" : "INFO",
+            journal->path,
+            records,
+            (int) globus_hashtable_size(&latest),
+            torn ? "true" : "false",
+            0);
+
+record_failed:
+    globus_hashtable_destroy_all(
+            &latest,
+            globus_l_gram_state_journal_record_free);
+hashtable_init_failed:
+    free(buffer);
+stat_failed:
+    return rc;
+}
+/* globus_l_gram_state_journal_recover() */
+
+/**
+ * Open the state journal and recover from it
+ *
+ * Called by the job manager holding the LRM lock, before it reloads its
+ * jobs. State files left out of date by a crash are rewritten from the
+ * journal, and the journal is then emptied. If the journal can't be used,
+ * state files are synced one at a time as before.
+ *
+ * @param manager
+ *     Job manager state. Its @a state_journal is set on success.
+ *
+ * @retval GLOBUS_SUCCESS
+ *     Success.
+ * @retval GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED
+ *     Malloc failed.
+ * @retval GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE
+ *     The journal couldn't be opened, or a state file in it couldn't be
+ *     rewritten.
+ */
+int
+globus_gram_job_manager_state_journal_init(
+    globus_gram_job_manager_t *         manager)
+{
+    globus_gram_job_manager_state_journal_t * journal;
+    struct stat                         st;
+    int                                 rc = GLOBUS_SUCCESS;
+
+    journal = calloc(1, sizeof(globus_gram_job_manager_state_journal_t));
+    if (journal == NULL)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+
+        goto journal_malloc_failed;
+    }
+    journal->fd = -1;
+    journal->commit_handle = GLOBUS_NULL_HANDLE;
+
+    journal->state_dirs[0] = strdup(manager->config->job_state_file_dir);
+    journal->state_dirs[1] = globus_common_create_string(
+            "%s/%s/%s/%s",
+            manager->config->job_state_file_dir,
+            manager->config->logname,
+            manager->config->service_tag,
+            manager->config->jobmanager_type);
+    if (journal->state_dirs[0] == NULL || journal->state_dirs[1] == NULL)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+
+        goto dirs_malloc_failed;
+    }
+    globus_i_gram_mkdir(journal->state_dirs[1]);
+
+    journal->path = globus_common_create_string(
+            "%s/state.journal",
+            journal->state_dirs[1]);
+    if (journal->path == NULL)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+
+        goto dirs_malloc_failed;
+    }
+
+    rc = globus_hashtable_init(
+            &journal->dirty_files,
+            1024,
+            globus_hashtable_string_hash,
+            globus_hashtable_string_keyeq);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+
+        goto dirs_malloc_failed;
+    }
+    rc = globus_fifo_init(&journal->waiters);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+
+        goto fifo_init_failed;
+    }
+    globus_mutex_init(&journal->mutex, NULL);
+
+    journal->fd = open(
+            journal->path,
+            O_RDWR | O_CREAT | O_APPEND,
+            S_IRUSR | S_IWUSR);
+    if (journal->fd < 0)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
+
+        globus_gram_job_manager_log(
+                manager,
+                GLOBUS_GRAM_JOB_MANAGER_LOG_ERROR,
+                "event=gram.state_journal.init.end "
+                "level=ERROR "
+                "path=\"%s\" "
+                "status=%d "
+                "msg=\"%s\" "
+                "errno=%d "
+                "reason=\"%s\" "
+                "\n",
+                journal->path,
+                -rc,
+                "Error opening state journal",
+                errno,
+                strerror(errno));
+
+        goto open_failed;
+    }
+    fcntl(journal->fd, F_SETFD, FD_CLOEXEC);
+
+    if (fstat(journal->fd, &st) != 0 || st.st_uid != getuid())
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
+
+        globus_gram_job_manager_log(
+                manager,
+                GLOBUS_GRAM_JOB_MANAGER_LOG_ERROR,
+                "event=gram.state_journal.init.end "
+                "level=ERROR "
+                "path=\"%s\" "
+                "status=%d "
+                "msg=\"%s\" "
+                "\n",
+                journal->path,
+                -rc,
+                "State journal not owned by me");
+
+        close(journal->fd);
+        goto open_failed;
+    }
+    journal->size = st.st_size;
+
+    manager->state_journal = journal;
+
+    /* If some state file couldn't be rewritten, keep its record and go on
+     * appending; the order of the records is all recovery relies on.
+     */
+    rc = globus_l_gram_state_journal_recover(manager);
+    if (rc == GLOBUS_SUCCESS)
+    {
+        globus_l_gram_state_journal_compact(manager);
+    }
+
+    return rc;
+
+open_failed:
+    globus_mutex_destroy(&journal->mutex);
+    globus_fifo_destroy(&journal->waiters);
+fifo_init_failed:
+    globus_hashtable_destroy_all(&journal->dirty_files, free);
+dirs_malloc_failed:
+    free(journal->path);
+    free(journal->state_dirs[0]);
+    free(journal->state_dirs[1]);
+    free(journal);
+journal_malloc_failed:
+    return rc;
+}
+/* globus_gram_job_manager_state_journal_init() */
+
+/**
+ * Compact and close the state journal
+ *
+ * Called when the job manager holding the LRM lock exits, before the lock
+ * is released.
+ *
+ * @param manager
+ *     Job manager state.
+ */
+void
+globus_gram_job_manager_state_journal_destroy(
+    globus_gram_job_manager_t *         manager)
+{
+    globus_gram_job_manager_state_journal_t * journal;
+
+    journal = manager->state_journal;
+
+    if (journal == NULL)
+    {
+        return;
+    }
+
+    globus_mutex_lock(&journal->mutex);
+    if (journal->commit_handle != GLOBUS_NULL_HANDLE)
+    {
+        globus_callback_unregister(
+                journal->commit_handle,
+                NULL,
+                NULL,
+                NULL);
+        journal->commit_handle = GLOBUS_NULL_HANDLE;
+    }
+    if (journal->fd >= 0)
+    {
+        if (fsync(journal->fd) == 0)
+        {
+            globus_l_gram_state_journal_compact(manager);
+        }
+        close(journal->fd);
+        journal->fd = -1;
+    }
+    journal->commits++;
+    manager->state_journal = NULL;
+    globus_mutex_unlock(&journal->mutex);
+
+    globus_l_gram_state_journal_release(journal);
+
+    globus_mutex_destroy(&journal->mutex);
+    globus_fifo_destroy(&journal->waiters);
+    globus_hashtable_destroy_all(&journal->dirty_files, free);
+    free(journal->path);
+    free(journal->state_dirs[0]);
+    free(journal->state_dirs[1]);
+    free(journal);
+}
+/* globus_gram_job_manager_state_journal_destroy() */
+
+/**
+ * Journal a state file and put it in place
+ *
+ * Logs the contents of the temporary state file @a fp, then closes it and
+ * renames it to @a state_file. The update is durable once the next group
+ * commit syncs the journal. If the journal can't be written, the state
+ * file is synced directly instead.
+ *
+ * @param manager
+ *     Job manager state.
+ * @param state_file
+ *     Path of the state file to update.
+ * @param tmp_file
+ *     Path of the temporary file the new state was written to.
+ * @param fp
+ *     Open stream for @a tmp_file, readable. This is always closed.
+ *
+ * @retval GLOBUS_SUCCESS
+ *     Success.
+ * @retval GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED
+ *     Malloc failed.
+ * @retval GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE
+ *     The state file couldn't be put in place.
+ */
+int
+globus_gram_job_manager_state_journal_write(
+    globus_gram_job_manager_t *         manager,
+    const char *                        state_file,
+    const char *                        tmp_file,
+    FILE *                              fp)
+{
+    globus_gram_job_manager_state_journal_t * journal;
+    char *                              data = NULL;
+    long                                length;
+    globus_bool_t                       journaled = GLOBUS_FALSE;
+    int                                 rc = GLOBUS_SUCCESS;
+
+    journal = manager->state_journal;
+
+    if (fflush(fp) != 0 || (length = ftell(fp)) < 0)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
+
+        goto read_failed;
+    }
+    data = malloc(length + 1);
+    if (data == NULL)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+
+        goto read_failed;
+    }
+    rewind(fp);
+    if (fread(data, 1, length, fp) != (size_t) length)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
+
+        goto read_failed;
+    }
+
+    globus_mutex_lock(&journal->mutex);
+    /* The record goes in first, so recovery never replaces the state
+     * file with anything older than what was renamed into place.
+     */
+    if (journal->fd >= 0 &&
+        globus_l_gram_state_journal_append(
+            manager, 'W', state_file, data, length) == GLOBUS_SUCCESS)
+    {
+        journaled = GLOBUS_TRUE;
+    }
+    else
+    {
+        fsync(fileno(fp));
+    }
+    fclose(fp);
+    fp = NULL;
+
+    if (rename(tmp_file, state_file) != 0)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
+
+        globus_gram_job_manager_log(
+                manager,
+                GLOBUS_GRAM_JOB_MANAGER_LOG_ERROR,
+                "event=gram.state_journal.write.end "
+                "level=ERROR "
+                "path=\"%s\" "
+                "status=%d "
+                "msg=\"%s\" "
+                "errno=%d "
+                "reason=\"%s\" "
+                "\n",
+                state_file,
+                -rc,
+                "Error renaming temporary state file",
+                errno,
+                strerror(errno));
+    }
+    else if (journal->fd >= 0)
+    {
+        globus_l_gram_state_journal_mark_dirty(journal, state_file);
+    }
+    if (!journaled && journal->fd >= 0)
+    {
+        /* Older records for this file mustn't be replayed over it */
+        globus_l_gram_state_journal_compact(manager);
+    }
+    globus_mutex_unlock(&journal->mutex);
+
+read_failed:
+    if (fp != NULL)
+    {
+        fclose(fp);
+    }
+    free(data);
+
+    return rc;
+}
+/* globus_gram_job_manager_state_journal_write() */
+
+/**
+ * Journal the removal of a state file and remove it
+ *
+ * @param manager
+ *     Job manager state.
+ * @param state_file
+ *     Path of the state file to remove.
+ *
+ * @retval GLOBUS_SUCCESS
+ *     Success.
+ * @retval GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED
+ *     Malloc failed.
+ * @retval GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE
+ *     The removal couldn't be journaled. The file is removed anyway.
+ */
+int
+globus_gram_job_manager_state_journal_remove(
+    globus_gram_job_manager_t *         manager,
+    const char *                        state_file)
+{
+    globus_gram_job_manager_state_journal_t * journal;
+    int                                 rc = GLOBUS_SUCCESS;
+
+    journal = manager->state_journal;
+
+    globus_mutex_lock(&journal->mutex);
+    if (journal->fd >= 0)
+    {
+        rc = globus_l_gram_state_journal_append(
+                manager, 'R', state_file, NULL, 0);
+
+        remove(state_file);
+        globus_l_gram_state_journal_mark_dirty(journal, state_file);
+        if (rc != GLOBUS_SUCCESS)
+        {
+            globus_l_gram_state_journal_compact(manager);
+        }
+    }
+    else
+    {
+        remove(state_file);
+    }
+    globus_mutex_unlock(&journal->mutex);
+
+    return rc;
+}
+/* globus_gram_job_manager_state_journal_remove() */
+
+/**
+ * Wait for the state file updates journaled so far to be committed
+ *
+ * Anything which tells a client about a job state change, such as the job
+ * contact reply or a job state callback, must not do so before the state
+ * file update behind it is durable. If a group commit is pending, @a
+ * callback is called with @a user_arg once it has synced the journal, and
+ * the updates waited for still share its fsync. Waiters are called in the
+ * order they waited, without the journal or any request locked.
+ *
+ * @param manager
+ *     Job manager state.
+ * @param callback
+ *     Function to call after the commit.
+ * @param user_arg
+ *     Argument to @a callback.
+ *
+ * @retval GLOBUS_TRUE
+ *     @a callback will be called after the pending commit.
+ * @retval GLOBUS_FALSE
+ *     Every update is already durable, possibly by syncing the journal now;
+ *     @a callback won't be called.
+ */
+globus_bool_t
+globus_gram_job_manager_state_journal_wait(
+    globus_gram_job_manager_t *         manager,
+    globus_callback_func_t              callback,
+    void *                              user_arg)
+{
+    globus_gram_job_manager_state_journal_t * journal;
+    globus_l_gram_state_journal_waiter_t * waiter;
+    globus_bool_t                       waiting = GLOBUS_FALSE;
+
+    journal = manager->state_journal;
+
+    if (journal == NULL)
+    {
+        return GLOBUS_FALSE;
+    }
+
+    globus_mutex_lock(&journal->mutex);
+    if (journal->fd < 0 || journal->commit_handle == GLOBUS_NULL_HANDLE)
+    {
+        goto out;
+    }
+
+    waiter = malloc(sizeof(globus_l_gram_state_journal_waiter_t));
+    if (waiter != NULL)
+    {
+        waiter->callback = callback;
+        waiter->user_arg = user_arg;
+        waiter->commit = journal->commits + 1;
+
+        if (globus_fifo_enqueue(&journal->waiters, waiter) == GLOBUS_SUCCESS)
+        {
+            waiting = GLOBUS_TRUE;
+        }
+        else
+        {
+            free(waiter);
+        }
+    }
+    if (!waiting)
+    {
+        /* Can't wait, so make it durable now */
+        if (fsync(journal->fd) != 0)
+        {
+            globus_l_gram_state_journal_compact(manager);
+        }
+    }
+out:
+    globus_mutex_unlock(&journal->mutex);
+
+    return waiting;
+}
+/* globus_gram_job_manager_state_journal_wait() */
@@ -664,6 +664,7 @@ main(
     if (manager.socket_fd != -1)
     {
         globus_gram_job_manager_script_close_all(&manager);
+        globus_gram_job_manager_state_journal_destroy(&manager);
         globus_i_gram_usage_end_session_stats(&manager);
         globus_i_gram_usage_stats_destroy(&manager);
         remove(manager.pid_path);
@@ -17,9 +17,16 @@
 #include "globus_common.h"
 #include "globus_scheduler_event_generator.h"
 #include "globus_gram_protocol_constants.h"
+#include "globus_xio.h"
+#include "globus_xio_file_driver.h"
 #include "version.h"
 
 #include <string.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <fcntl.h>
+#include <limits.h>
+#endif
 
 /**
  * @file seg_job_manager_module.c
@@ -31,6 +38,12 @@
 #define JOB_MANAGER_SEG_SCHEDULER "JOB_MANAGER_SEG_SCHEDULER"
 #define JOB_MANAGER_SEG_LOG_PATH  "JOB_MANAGER_SEG_LOG_PATH"
 
+#ifdef __linux__
+/* Room for a batch of events in one read, names included */
+#define SEG_JOB_MANAGER_WATCH_BUFFER_SIZE \
+    (16 * (sizeof(struct inotify_event) + NAME_MAX + 1))
+#endif
+
 /**
  * Debug levels:
  * If the environment variable SEG_JOB_MANAGER_DEBUG is set to a bitwise or
@@ -91,12 +104,33 @@ typedef struct
      * Path to the directory where the JOB_MANAGER server log files are located
      */
     char *                              log_dir;
+
+    /**
+     * XIO handle wrapping an inotify descriptor on log_dir, or NULL if
+     * changes to the log directory are only noticed by polling
+     */
+    globus_xio_handle_t                 watch_handle;
+    /** inotify descriptor, which XIO leaves open when closing the handle */
+    int                                 watch_fd;
+    /** Buffer the inotify events are read into */
+    globus_byte_t *                     watch_buffer;
+    /** Flag indicating that callback is registered and hasn't run yet */
+    globus_bool_t                       callback_registered;
+    /**
+     * Flag indicating that log_dir changed while the poll callback was
+     * running, so it should run again right away
+     */
+    globus_bool_t                       wakeup_pending;
 } globus_l_job_manager_logfile_state_t;
 
 static globus_mutex_t                   globus_l_job_manager_mutex;
 static globus_cond_t                    globus_l_job_manager_cond;
 static globus_bool_t                    shutdown_called;
 static int                              callback_count;
+static globus_l_job_manager_logfile_state_t *
+                                        globus_l_job_manager_logfile_state;
+static globus_xio_driver_t              globus_l_job_manager_file_driver;
+static globus_xio_stack_t               globus_l_job_manager_file_stack;
 
 
 GlobusDebugDefine(SEG_JOB_MANAGER);
@@ -114,6 +148,35 @@ void
 globus_l_job_manager_poll_callback(
     void *                              user_arg);
 
+static
+globus_result_t
+globus_l_job_manager_register_poll(
+    globus_l_job_manager_logfile_state_t *      state,
+    globus_reltime_t *                  delay);
+
+static
+int
+globus_l_job_manager_watch_start(
+    globus_l_job_manager_logfile_state_t *      state);
+
+static
+void
+globus_l_job_manager_watch_callback(
+    globus_xio_handle_t                 handle,
+    globus_result_t                     result,
+    globus_byte_t *                     buffer,
+    globus_size_t                       len,
+    globus_size_t                       nbytes,
+    globus_xio_data_descriptor_t        data_desc,
+    void *                              user_arg);
+
+static
+void
+globus_l_job_manager_watch_close_callback(
+    globus_xio_handle_t                 handle,
+    globus_result_t                     result,
+    void *                              user_arg);
+
 static
 int
 globus_l_job_manager_parse_events(
@@ -167,6 +230,11 @@ globus_l_job_manager_module_activate(void)
     {
         goto activate_common_failed;
     }
+    rc = globus_module_activate(GLOBUS_XIO_MODULE);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        goto activate_xio_failed;
+    }
     rc = globus_mutex_init(&globus_l_job_manager_mutex, NULL);
 
     if (rc != GLOBUS_SUCCESS)
@@ -264,16 +332,19 @@ globus_l_job_manager_module_activate(void)
         goto bad_log_path;
     }
 
-    result = globus_callback_register_oneshot(
-            &logfile_state->callback,
-            &delay,
-            globus_l_job_manager_poll_callback,
-            logfile_state);
+    result = globus_l_job_manager_register_poll(logfile_state, &delay);
     if (result != GLOBUS_SUCCESS)
     {
         goto oneshot_failed;
     }
     callback_count++;
+    globus_l_job_manager_logfile_state = logfile_state;
+
+    /* Polling is the fallback if the log directory can't be watched. The
+     * first poll rechecks for the log file, so one created before the
+     * watch starts isn't missed.
+     */
+    (void) globus_l_job_manager_watch_start(logfile_state);
 
     return 0;
 oneshot_failed:
@@ -298,6 +369,8 @@ calloc_state_failed:
 cond_init_failed:
     globus_mutex_destroy(&globus_l_job_manager_mutex);
 mutex_init_failed:
+    globus_module_deactivate(GLOBUS_XIO_MODULE);
+activate_xio_failed:
     globus_module_deactivate(GLOBUS_COMMON_MODULE);
 activate_common_failed:
     return 1;
@@ -308,17 +381,60 @@ static
 int
 globus_l_job_manager_module_deactivate(void)
 {
+    globus_l_job_manager_logfile_state_t *
+                                        state;
+    globus_xio_handle_t                 watch_handle;
+    globus_result_t                     result;
+
     globus_mutex_lock(&globus_l_job_manager_mutex);
     shutdown_called = GLOBUS_TRUE;
 
+    state = globus_l_job_manager_logfile_state;
+    if (state != NULL)
+    {
+        if (state->callback_registered)
+        {
+            /* Don't wait out the poll delay to notice the shutdown */
+            globus_callback_adjust_oneshot(state->callback, NULL);
+        }
+        if (state->watch_handle != NULL)
+        {
+            watch_handle = state->watch_handle;
+            state->watch_handle = NULL;
+
+            result = globus_xio_register_close(
+                    watch_handle,
+                    NULL,
+                    globus_l_job_manager_watch_close_callback,
+                    state);
+            if (result != GLOBUS_SUCCESS)
+            {
+                callback_count--;
+            }
+        }
+    }
+
     while (callback_count > 0)
     {
         globus_cond_wait(&globus_l_job_manager_cond, &globus_l_job_manager_mutex);
     }
+    globus_l_job_manager_logfile_state = NULL;
     globus_mutex_unlock(&globus_l_job_manager_mutex);
 
+    if (globus_l_job_manager_file_stack != NULL)
+    {
+        globus_xio_stack_destroy(globus_l_job_manager_file_stack);
+        globus_l_job_manager_file_stack = NULL;
+    }
+    if (globus_l_job_manager_file_driver != NULL)
+    {
+        globus_xio_driver_unload(globus_l_job_manager_file_driver);
+        globus_l_job_manager_file_driver = NULL;
+    }
+
     GlobusDebugDestroy(SEG_JOB_MANAGER);
 
+    globus_module_deactivate(GLOBUS_XIO_MODULE);
     globus_module_deactivate(GLOBUS_COMMON_MODULE);
 
     return 0;
@@ -350,6 +466,8 @@ globus_l_job_manager_poll_callback(
             ("globus_l_job_manager_poll_callback()\n"));
 
     globus_mutex_lock(&globus_l_job_manager_mutex);
+    state->callback_registered = GLOBUS_FALSE;
+    state->wakeup_pending = GLOBUS_FALSE;
     if (shutdown_called)
     {
         SEG_JOB_MANAGER_DEBUG(SEG_JOB_MANAGER_DEBUG_INFO,
@@ -455,6 +573,13 @@ globus_l_job_manager_poll_callback(
             goto error;
         }
     }
+    else if(eof_hit && state->watch_handle != NULL)
+    {
+        /* eof on current logfile, the watch will wake us for new data,
+         * but check now and then in case an event was missed
+         */
+        GlobusTimeReltimeSet(delay, 30, 0);
+    }
     else if(eof_hit)
     {
         /* eof on current logfile, wait for new data */
@@ -466,11 +591,7 @@ globus_l_job_manager_poll_callback(
         GlobusTimeReltimeSet(delay, 0, 0);
     }
 
-    result = globus_callback_register_oneshot(
-            &state->callback,
-            &delay,
-            globus_l_job_manager_poll_callback,
-            state);
+    result = globus_l_job_manager_register_poll(state, &delay);
     if (result != GLOBUS_SUCCESS)
     {
         goto error;
@@ -497,6 +618,310 @@ error:
 }
 /* globus_l_job_manager_poll_callback() */
 
+/**
+ * Register the poll callback, or run it right away if the log directory
+ * changed while it was running
+ *
+ * @param state
+ *     Log file parsing state
+ * @param delay
+ *     Delay before the callback runs. Set to 0 if a wakeup is pending.
+ */
+static
+globus_result_t
+globus_l_job_manager_register_poll(
+    globus_l_job_manager_logfile_state_t *      state,
+    globus_reltime_t *                  delay)
+{
+    globus_result_t                     result;
+
+    globus_mutex_lock(&globus_l_job_manager_mutex);
+    if (state->wakeup_pending)
+    {
+        GlobusTimeReltimeSet(*delay, 0, 0);
+        state->wakeup_pending = GLOBUS_FALSE;
+    }
+    result = globus_callback_register_oneshot(
+            &state->callback,
+            delay,
+            globus_l_job_manager_poll_callback,
+            state);
+    if (result == GLOBUS_SUCCESS)
+    {
+        state->callback_registered = GLOBUS_TRUE;
+    }
+    globus_mutex_unlock(&globus_l_job_manager_mutex);
+
+    return result;
+}
+/* globus_l_job_manager_register_poll() */
+
+/**
+ * Watch the log directory so that appends to the log and new daily logs
+ * are parsed when they happen instead of at the next poll
+ *
+ * The inotify descriptor is read through the XIO file driver so that the
+ * wakeups arrive as callbacks in the nonthreaded job manager too. The
+ * events are only used as a signal to run the poll callback, which
+ * parses from where it left off.
+ *
+ * @param state
+ *     Log file parsing state
+ *
+ * @retval GLOBUS_SUCCESS
+ *     The log directory is being watched.
+ * @retval 1
+ *     The log directory can't be watched, changes to it will be found by
+ *     polling.
+ */
+static
+int
+globus_l_job_manager_watch_start(
+    globus_l_job_manager_logfile_state_t *      state)
+{
+#ifdef __linux__
+    int                                 fd;
+    globus_xio_attr_t                   attr;
+    globus_xio_handle_t                 handle;
+    globus_result_t                     result;
+
+    SEG_JOB_MANAGER_DEBUG(SEG_JOB_MANAGER_DEBUG_INFO,
+            ("globus_l_job_manager_watch_start()\n"));
+
+    state->watch_buffer = malloc(SEG_JOB_MANAGER_WATCH_BUFFER_SIZE);
+    if (state->watch_buffer == NULL)
+    {
+        goto malloc_failed;
+    }
+
+    fd = inotify_init();
+    if (fd < 0)
+    {
+        SEG_JOB_MANAGER_DEBUG(SEG_JOB_MANAGER_DEBUG_WARN,
+                ("inotify_init failed: %s\n", strerror(errno)));
+        goto inotify_init_failed;
+    }
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    if (inotify_add_watch(
+                fd,
+                state->log_dir,
+                IN_MODIFY|IN_CLOSE_WRITE|IN_CREATE|IN_MOVED_TO) < 0)
+    {
+        SEG_JOB_MANAGER_DEBUG(SEG_JOB_MANAGER_DEBUG_WARN,
+                ("can't watch %s: %s\n", state->log_dir, strerror(errno)));
+        goto add_watch_failed;
+    }
+
+    if (globus_l_job_manager_file_stack == NULL)
+    {
+        result = globus_xio_driver_load(
+                "file",
+                &globus_l_job_manager_file_driver);
+        if (result != GLOBUS_SUCCESS)
+        {
+            globus_l_job_manager_file_driver = NULL;
+            goto driver_load_failed;
+        }
+        result = globus_xio_stack_init(&globus_l_job_manager_file_stack, NULL);
+        if (result != GLOBUS_SUCCESS)
+        {
+            globus_l_job_manager_file_stack = NULL;
+            goto driver_load_failed;
+        }
+        result = globus_xio_stack_push_driver(
+                globus_l_job_manager_file_stack,
+                globus_l_job_manager_file_driver);
+        if (result != GLOBUS_SUCCESS)
+        {
+            goto driver_load_failed;
+        }
+    }
+
+    result = globus_xio_attr_init(&attr);
+    if (result != GLOBUS_SUCCESS)
+    {
+        goto attr_init_failed;
+    }
+    result = globus_xio_attr_cntl(
+            attr,
+            globus_l_job_manager_file_driver,
+            GLOBUS_XIO_FILE_SET_HANDLE,
+            fd);
+    if (result != GLOBUS_SUCCESS)
+    {
+        goto attr_cntl_failed;
+    }
+    result = globus_xio_handle_create(
+            &handle,
+            globus_l_job_manager_file_stack);
+    if (result != GLOBUS_SUCCESS)
+    {
+        goto attr_cntl_failed;
+    }
+    result = globus_xio_open(handle, NULL, attr);
+    if (result != GLOBUS_SUCCESS)
+    {
+        goto open_failed;
+    }
+    globus_xio_attr_destroy(attr);
+
+    globus_mutex_lock(&globus_l_job_manager_mutex);
+    result = globus_xio_register_read(
+            handle,
+            state->watch_buffer,
+            SEG_JOB_MANAGER_WATCH_BUFFER_SIZE,
+            1,
+            NULL,
+            globus_l_job_manager_watch_callback,
+            state);
+    if (result != GLOBUS_SUCCESS)
+    {
+        globus_mutex_unlock(&globus_l_job_manager_mutex);
+        globus_xio_close(handle, NULL);
+        goto add_watch_failed;
+    }
+    state->watch_handle = handle;
+    state->watch_fd = fd;
+    callback_count++;
+    globus_mutex_unlock(&globus_l_job_manager_mutex);
+
+    SEG_JOB_MANAGER_DEBUG(SEG_JOB_MANAGER_DEBUG_INFO,
+            ("globus_l_job_manager_watch_start() watching %s\n",
+            state->log_dir));
+    return GLOBUS_SUCCESS;
+
+open_failed:
+    globus_xio_close(handle, NULL);
+attr_cntl_failed:
+    globus_xio_attr_destroy(attr);
+attr_init_failed:
+driver_load_failed:
+add_watch_failed:
+    close(fd);
+inotify_init_failed:
+    free(state->watch_buffer);
+    state->watch_buffer = NULL;
+malloc_failed:
+    SEG_JOB_MANAGER_DEBUG(SEG_JOB_MANAGER_DEBUG_WARN,
+            ("globus_l_job_manager_watch_start() exits w/error, "
+             "polling %s\n", state->log_dir));
+#endif /* __linux__ */
+    return 1;
+}
+/* globus_l_job_manager_watch_start() */
+
+/**
+ * Run the poll callback now that something in the log directory changed
+ *
+ * @param user_arg
+ *     Log file parsing state
+ */
+static
+void
+globus_l_job_manager_watch_callback(
+    globus_xio_handle_t                 handle,
+    globus_result_t                     result,
+    globus_byte_t *                     buffer,
+    globus_size_t                       len,
+    globus_size_t                       nbytes,
+    globus_xio_data_descriptor_t        data_desc,
+    void *                              user_arg)
+{
+    globus_l_job_manager_logfile_state_t *
+                                        state = user_arg;
+    globus_reltime_t                    delay;
+
+    SEG_JOB_MANAGER_DEBUG(SEG_JOB_MANAGER_DEBUG_TRACE,
+            ("globus_l_job_manager_watch_callback() %d bytes of events\n",
+            (int) nbytes));
+
+    globus_mutex_lock(&globus_l_job_manager_mutex);
+    if (result != GLOBUS_SUCCESS || shutdown_called)
+    {
+        goto stop_watching;
+    }
+
+    /* One wakeup covers everything read, the poll callback parses all of
+     * the new lines in a single pass
+     */
+    if (state->callback_registered)
+    {
+        GlobusTimeReltimeSet(delay, 0, 0);
+        globus_callback_adjust_oneshot(state->callback, &delay);
+    }
+    else
+    {
+        state->wakeup_pending = GLOBUS_TRUE;
+    }
+
+    result = globus_xio_register_read(
+            handle,
+            buffer,
+            len,
+            1,
+            NULL,
+            globus_l_job_manager_watch_callback,
+            state);
+    if (result != GLOBUS_SUCCESS)
+    {
+        goto stop_watching;
+    }
+    globus_mutex_unlock(&globus_l_job_manager_mutex);
+
+    return;
+
+stop_watching:
+    /* Deactivate may have already closed the handle */
+    if (state->watch_handle != NULL)
+    {
+        SEG_JOB_MANAGER_DEBUG(SEG_JOB_MANAGER_DEBUG_WARN,
+                ("no longer watching %s, polling\n", state->log_dir));
+        state->watch_handle = NULL;
+
+        result = globus_xio_register_close(
+                handle,
+                NULL,
+                globus_l_job_manager_watch_close_callback,
+                state);
+        if (result != GLOBUS_SUCCESS)
+        {
+            callback_count--;
+            if (callback_count == 0)
+            {
+                globus_cond_signal(&globus_l_job_manager_cond);
+            }
+        }
+    }
+    globus_mutex_unlock(&globus_l_job_manager_mutex);
+}
+/* globus_l_job_manager_watch_callback() */
+
+static
+void
+globus_l_job_manager_watch_close_callback(
+    globus_xio_handle_t                 handle,
+    globus_result_t                     result,
+    void *                              user_arg)
+{
+    globus_l_job_manager_logfile_state_t *
+                                        state = user_arg;
+
+    globus_mutex_lock(&globus_l_job_manager_mutex);
+    close(state->watch_fd);
+    state->watch_fd = -1;
+    free(state->watch_buffer);
+    state->watch_buffer = NULL;
+
+    callback_count--;
+    if (callback_count == 0)
+    {
+        globus_cond_signal(&globus_l_job_manager_cond);
+    }
+    globus_mutex_unlock(&globus_l_job_manager_mutex);
+}
+/* globus_l_job_manager_watch_close_callback() */
+
 /**
  * Determine the next available JOB_MANAGER log file name from the 
  * timestamp stored in the logfile state structure.
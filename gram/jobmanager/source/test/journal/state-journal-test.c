@@ -0,0 +1,652 @@
+/*
+ * Copyright 1999-2009 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file state-journal-test.c
+ * @brief Job State Journal Recovery Test
+ *
+ * Builds state journals the way a job manager could have left them when it
+ * crashed, recovers from them as a restarting job manager does, and checks
+ * that each state file is what globus_gram_job_manager_state_file_read()
+ * should then find: the contents of its last good record, owned by us, or
+ * no file at all if it was last removed. Also checks that an append which
+ * fails leaves the state file synced and out of reach of older records,
+ * that nothing is tracked once journaling has stopped, and that the group
+ * commit compacts a journal grown past its limit and only then calls the
+ * callbacks waiting for it.
+ */
+#include "globus_common.h"
+#include "globus_gram_job_manager.h"
+
+#include <string.h>
+
+/* Must match GLOBUS_L_GRAM_STATE_JOURNAL_MAX_SIZE */
+#define JOURNAL_TEST_MAX_SIZE                   (4 * 1024 * 1024)
+#define JOURNAL_TEST_STATE_SIZE                 (64 * 1024)
+#define JOURNAL_TEST_TIMEOUT                    30
+
+static char                             state_dir[] =
+                                        "state-journal-test.XXXXXX";
+static char                             journal_path[512];
+static globus_gram_job_manager_config_t config;
+static globus_gram_job_manager_t        manager;
+
+static
+uint32_t
+journal_crc(
+    uint32_t                            crc,
+    const char *                        buffer,
+    size_t                              length)
+{
+    int                                 i;
+
+    crc = ~crc;
+    while (length-- > 0)
+    {
+        crc ^= (unsigned char) *buffer++;
+        for (i = 0; i < 8; i++)
+        {
+            crc = (crc >> 1) ^ (0xedb88320 & (-(crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+static
+char *
+state_path(
+    const char *                        name)
+{
+    static char                         paths[4][256];
+    static int                          next;
+    char *                              path = paths[next++ % 4];
+
+    snprintf(path, sizeof(paths[0]), "%s/%s", state_dir, name);
+
+    return path;
+}
+
+/*
+ * Append a record to fp, with a bad checksum if corrupt is set. Returns
+ * the record length.
+ */
+static
+long
+journal_append(
+    FILE *                              fp,
+    char                                type,
+    const char *                        path,
+    const char *                        data,
+    globus_bool_t                       corrupt)
+{
+    size_t                              path_length = strlen(path);
+    size_t                              length = data ? strlen(data) : 0;
+    uint32_t                            crc;
+    int                                 header_length;
+
+    crc = journal_crc(journal_crc(0, path, path_length), data, length);
+    if (corrupt)
+    {
+        crc ^= 1;
+    }
+    header_length = fprintf(fp, "GRAMJ %c %lu %lu %08lx\n",
+            type,
+            (unsigned long) path_length,
+            (unsigned long) length,
+            (unsigned long) crc);
+    fwrite(path, 1, path_length, fp);
+    if (length > 0)
+    {
+        fwrite(data, 1, length, fp);
+    }
+
+    return header_length + path_length + length;
+}
+
+static
+void
+write_file(
+    const char *                        path,
+    const char *                        data)
+{
+    FILE *                              fp;
+
+    fp = fopen(path, "w");
+    fputs(data, fp);
+    fclose(fp);
+}
+
+static
+long
+file_size(
+    const char *                        path)
+{
+    struct stat                         st;
+
+    return (stat(path, &st) == 0) ? (long) st.st_size : -1;
+}
+
+/*
+ * Check the state file holds exactly data, as a reloading job manager
+ * would read it; a NULL data means it must not exist
+ */
+static
+int
+state_file_is(
+    const char *                        path,
+    const char *                        data)
+{
+    struct stat                         st;
+    char                                tmp_path[256];
+    char *                              buffer;
+    FILE *                              fp;
+    size_t                              got;
+    int                                 rc = 0;
+
+    if (data == NULL)
+    {
+        if (stat(path, &st) == 0)
+        {
+            printf("# %s should have been removed\n", path);
+            return 1;
+        }
+        return 0;
+    }
+    if (stat(path, &st) != 0 || st.st_uid != getuid())
+    {
+        printf("# %s missing or not owned by me\n", path);
+        return 1;
+    }
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    if (stat(tmp_path, &st) == 0)
+    {
+        printf("# %s left behind\n", tmp_path);
+        return 1;
+    }
+
+    buffer = malloc(strlen(data) + 2);
+    fp = fopen(path, "r");
+    got = fread(buffer, 1, strlen(data) + 1, fp);
+    fclose(fp);
+    if (got != strlen(data) || memcmp(buffer, data, got) != 0)
+    {
+        printf("# %s doesn't hold its last good record\n", path);
+        rc = 1;
+    }
+    free(buffer);
+
+    return rc;
+}
+
+/* Recover from the journal as a restarting job manager does */
+static
+int
+journal_recover(void)
+{
+    memset(&manager, 0, sizeof(manager));
+    manager.config = &config;
+
+    return globus_gram_job_manager_state_journal_init(&manager);
+}
+
+/* Forget the journal without compacting it, as if we had crashed */
+static
+void
+journal_crash(void)
+{
+    globus_gram_job_manager_state_journal_t * journal;
+
+    journal = manager.state_journal;
+    manager.state_journal = NULL;
+    if (journal->commit_handle != GLOBUS_NULL_HANDLE)
+    {
+        globus_callback_unregister(journal->commit_handle, NULL, NULL, NULL);
+    }
+    if (journal->fd >= 0)
+    {
+        close(journal->fd);
+    }
+}
+
+/* Update a state file through the journal */
+static
+int
+journal_write(
+    const char *                        path,
+    const char *                        data)
+{
+    char                                tmp_path[256];
+    FILE *                              fp;
+
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    fp = fopen(tmp_path, "w+");
+    if (fp == NULL)
+    {
+        return GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
+    }
+    fputs(data, fp);
+
+    return globus_gram_job_manager_state_journal_write(
+            &manager, path, tmp_path, fp);
+}
+
+static
+void
+commit_done(
+    void *                              user_arg)
+{
+    globus_bool_t *                     done = user_arg;
+
+    *done = GLOBUS_TRUE;
+}
+
+/* Run callbacks until the pending group commit is done */
+static
+int
+journal_commit(void)
+{
+    globus_bool_t                       done = GLOBUS_FALSE;
+    globus_abstime_t                    timeout;
+    time_t                              start = time(NULL);
+
+    if (!globus_gram_job_manager_state_journal_wait(
+            &manager, commit_done, &done))
+    {
+        printf("# no commit pending\n");
+        return 1;
+    }
+    while (!done && time(NULL) - start < JOURNAL_TEST_TIMEOUT)
+    {
+        GlobusTimeAbstimeSet(timeout, 1, 0);
+        globus_callback_poll(&timeout);
+    }
+    if (!done)
+    {
+        printf("# commit didn't happen\n");
+        return 1;
+    }
+    if (manager.state_journal->commit_handle != GLOBUS_NULL_HANDLE)
+    {
+        printf("# waiter called before the commit\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * A crash while appending leaves a partial record at the end; the records
+ * before it are replayed
+ */
+static
+int
+torn_tail_test(void)
+{
+    FILE *                              fp;
+    long                                length;
+    int                                 rc;
+
+    fp = fopen(journal_path, "w");
+    journal_append(fp, 'W', state_path("a"), "a1\n", GLOBUS_FALSE);
+    journal_append(fp, 'W', state_path("b"), "b1\n", GLOBUS_FALSE);
+    length = journal_append(fp, 'W', state_path("a"), "a2\n", GLOBUS_FALSE);
+    length += journal_append(fp, 'W', state_path("b"), "b2\n", GLOBUS_FALSE);
+    fclose(fp);
+    truncate(journal_path, file_size(journal_path) - length / 4);
+    write_file(state_path("a"), "stale\n");
+
+    rc = journal_recover();
+    if (rc != GLOBUS_SUCCESS)
+    {
+        printf("# recovery failed: %d\n", rc);
+        return 1;
+    }
+    rc = state_file_is(state_path("a"), "a2\n") ||
+         state_file_is(state_path("b"), "b1\n");
+    if (file_size(journal_path) != 0)
+    {
+        printf("# journal not emptied after recovery\n");
+        rc = 1;
+    }
+    globus_gram_job_manager_state_journal_destroy(&manager);
+
+    return rc;
+}
+
+/*
+ * A record with a bad checksum ends the journal, even with good records
+ * after it, and it is cut off there so later appends are replayed
+ */
+static
+int
+bad_crc_test(void)
+{
+    FILE *                              fp;
+    long                                good;
+    int                                 rc;
+
+    fp = fopen(journal_path, "w");
+    journal_append(fp, 'W', state_path("c"), "c1\n", GLOBUS_FALSE);
+    journal_append(fp, 'W', state_path("c"), "c2\n", GLOBUS_TRUE);
+    journal_append(fp, 'W', state_path("c"), "c3\n", GLOBUS_FALSE);
+    journal_append(fp, 'W', state_path("d"), "d1\n", GLOBUS_FALSE);
+    fclose(fp);
+
+    rc = journal_recover();
+    if (rc != GLOBUS_SUCCESS)
+    {
+        printf("# recovery failed: %d\n", rc);
+        return 1;
+    }
+    rc = state_file_is(state_path("c"), "c1\n") ||
+         state_file_is(state_path("d"), NULL);
+    globus_gram_job_manager_state_journal_destroy(&manager);
+    if (rc != 0)
+    {
+        return rc;
+    }
+
+    /* A file that can't be rewritten keeps the journal around, so see
+     * where the next record goes
+     */
+    fp = fopen(journal_path, "w");
+    good = journal_append(
+            fp, 'W', state_path("missing/e"), "e1\n", GLOBUS_FALSE);
+    journal_append(fp, 'W', state_path("c"), "c4\n", GLOBUS_TRUE);
+    journal_append(fp, 'W', state_path("c"), "c5\n", GLOBUS_FALSE);
+    fclose(fp);
+
+    if (journal_recover() == GLOBUS_SUCCESS)
+    {
+        printf("# recovery should have failed to rewrite missing/e\n");
+        globus_gram_job_manager_state_journal_destroy(&manager);
+        return 1;
+    }
+    if (file_size(journal_path) != good)
+    {
+        printf("# journal is %ld bytes, should be cut to %ld\n",
+                file_size(journal_path), good);
+        rc = 1;
+    }
+    if (journal_write(state_path("c"), "c6\n") != GLOBUS_SUCCESS)
+    {
+        printf("# journal write failed\n");
+        rc = 1;
+    }
+    journal_crash();
+    write_file(state_path("c"), "stale\n");
+
+    mkdir(state_path("missing"), S_IRWXU);
+    if (journal_recover() != GLOBUS_SUCCESS)
+    {
+        printf("# second recovery failed\n");
+        return 1;
+    }
+    rc = rc ||
+         state_file_is(state_path("missing/e"), "e1\n") ||
+         state_file_is(state_path("c"), "c6\n");
+    globus_gram_job_manager_state_journal_destroy(&manager);
+
+    return rc;
+}
+
+/* The last record for a file wins, whether it wrote or removed it */
+static
+int
+write_then_remove_test(void)
+{
+    FILE *                              fp;
+    int                                 rc;
+
+    write_file(state_path("f"), "stale\n");
+    fp = fopen(journal_path, "w");
+    journal_append(fp, 'W', state_path("f"), "f1\n", GLOBUS_FALSE);
+    journal_append(fp, 'R', state_path("f"), NULL, GLOBUS_FALSE);
+    journal_append(fp, 'R', state_path("g"), NULL, GLOBUS_FALSE);
+    journal_append(fp, 'W', state_path("g"), "g1\n", GLOBUS_FALSE);
+    fclose(fp);
+
+    rc = journal_recover();
+    if (rc != GLOBUS_SUCCESS)
+    {
+        printf("# recovery failed: %d\n", rc);
+        return 1;
+    }
+    rc = state_file_is(state_path("f"), NULL) ||
+         state_file_is(state_path("g"), "g1\n");
+    globus_gram_job_manager_state_journal_destroy(&manager);
+
+    return rc;
+}
+
+/*
+ * When an append fails, the state file is synced instead and the journal
+ * compacted so its older record can't be replayed over it. Once the
+ * journal can't be used, nothing more is tracked for it.
+ */
+static
+int
+failed_append_test(void)
+{
+    globus_gram_job_manager_state_journal_t * journal;
+    globus_bool_t                       done = GLOBUS_FALSE;
+    int                                 tracked;
+    int                                 rc = 0;
+
+    unlink(journal_path);
+    if (journal_recover() != GLOBUS_SUCCESS)
+    {
+        printf("# journal init failed\n");
+        return 1;
+    }
+    journal = manager.state_journal;
+
+    if (journal_write(state_path("h"), "h1\n") != GLOBUS_SUCCESS ||
+        journal_commit() != 0)
+    {
+        globus_gram_job_manager_state_journal_destroy(&manager);
+        return 1;
+    }
+
+    /* Appends to a read-only descriptor fail, and so does compaction */
+    close(journal->fd);
+    journal->fd = open(journal_path, O_RDONLY);
+
+    journal_write(state_path("h"), "h2\n");
+    rc = state_file_is(state_path("h"), "h2\n");
+    if (journal->fd >= 0 || file_size(journal_path) >= 0)
+    {
+        printf("# journal should have been dropped\n");
+        rc = 1;
+    }
+
+    tracked = globus_hashtable_size(&journal->dirty_files);
+    journal_write(state_path("h"), "h3\n");
+    write_file(state_path("i"), "i1\n");
+    globus_gram_job_manager_state_journal_remove(&manager, state_path("i"));
+    if (globus_hashtable_size(&journal->dirty_files) != tracked)
+    {
+        printf("# %d more files tracked without a journal\n",
+                globus_hashtable_size(&journal->dirty_files) - tracked);
+        rc = 1;
+    }
+    if (globus_gram_job_manager_state_journal_wait(
+            &manager, commit_done, &done))
+    {
+        printf("# waiting for a commit without a journal\n");
+        rc = 1;
+    }
+    rc = rc ||
+         state_file_is(state_path("h"), "h3\n") ||
+         state_file_is(state_path("i"), NULL);
+    globus_gram_job_manager_state_journal_destroy(&manager);
+
+    /* A new journal mustn't bring back h1 */
+    if (journal_recover() != GLOBUS_SUCCESS)
+    {
+        printf("# journal init failed\n");
+        return 1;
+    }
+    rc = rc || state_file_is(state_path("h"), "h3\n");
+    globus_gram_job_manager_state_journal_destroy(&manager);
+
+    return rc;
+}
+
+/*
+ * The group commit after the journal grows past its limit syncs the state
+ * files and empties the journal before calling anything waiting for it
+ */
+static
+int
+compaction_test(void)
+{
+    char *                              data;
+    char *                              last[2];
+    int                                 writes;
+    int                                 i;
+    int                                 rc = 0;
+
+    unlink(journal_path);
+    if (journal_recover() != GLOBUS_SUCCESS)
+    {
+        printf("# journal init failed\n");
+        return 1;
+    }
+
+    data = malloc(2 * (JOURNAL_TEST_STATE_SIZE + 1));
+    last[0] = data;
+    last[1] = data + JOURNAL_TEST_STATE_SIZE + 1;
+
+    writes = JOURNAL_TEST_MAX_SIZE / JOURNAL_TEST_STATE_SIZE + 2;
+    for (i = 0; i < writes && rc == 0; i++)
+    {
+        memset(last[i % 2], 'a' + (i % 26), JOURNAL_TEST_STATE_SIZE - 1);
+        last[i % 2][JOURNAL_TEST_STATE_SIZE - 1] = '\n';
+        last[i % 2][JOURNAL_TEST_STATE_SIZE] = '\0';
+        rc = journal_write(state_path(i % 2 ? "k" : "j"), last[i % 2]);
+    }
+    if (rc != GLOBUS_SUCCESS)
+    {
+        printf("# journal write failed: %d\n", rc);
+        rc = 1;
+    }
+    else if (file_size(journal_path) <= JOURNAL_TEST_MAX_SIZE)
+    {
+        printf("# journal compacted before its commit\n");
+        rc = 1;
+    }
+    else if (journal_commit() != 0)
+    {
+        rc = 1;
+    }
+    else if (file_size(journal_path) != 0 ||
+             manager.state_journal->size != 0 ||
+             globus_hashtable_size(&manager.state_journal->dirty_files) != 0)
+    {
+        printf("# journal not compacted: %ld bytes, %d files\n",
+                file_size(journal_path),
+                globus_hashtable_size(&manager.state_journal->dirty_files));
+        rc = 1;
+    }
+    rc = rc ||
+         state_file_is(state_path("j"), last[0]) ||
+         state_file_is(state_path("k"), last[1]);
+    globus_gram_job_manager_state_journal_destroy(&manager);
+    free(data);
+
+    return rc;
+}
+
+int
+main(
+    int                                 argc,
+    char *                              argv[])
+{
+    char                                state_subdir[256];
+    int                                 failed = 0;
+
+    setbuf(stdout, NULL);
+    printf("1..5\n");
+
+    if (globus_module_activate(GLOBUS_COMMON_MODULE) != GLOBUS_SUCCESS)
+    {
+        printf("Bail out! can't activate globus common\n");
+        return 99;
+    }
+    if (mkdtemp(state_dir) == NULL)
+    {
+        printf("Bail out! can't create state directory\n");
+        return 99;
+    }
+    config.job_state_file_dir = state_dir;
+    config.logname = "test";
+    config.service_tag = "jobmanager";
+    config.jobmanager_type = "fork";
+
+    snprintf(state_subdir, sizeof(state_subdir), "%s/%s/%s/%s",
+            state_dir, config.logname, config.service_tag,
+            config.jobmanager_type);
+    snprintf(journal_path, sizeof(journal_path), "%s/state.journal",
+            state_subdir);
+    globus_i_gram_mkdir(state_subdir);
+
+    if (torn_tail_test() != 0)
+    {
+        printf("not ");
+        failed++;
+    }
+    printf("ok - torn_tail_test\n");
+
+    if (bad_crc_test() != 0)
+    {
+        printf("not ");
+        failed++;
+    }
+    printf("ok - bad_crc_test\n");
+
+    if (write_then_remove_test() != 0)
+    {
+        printf("not ");
+        failed++;
+    }
+    printf("ok - write_then_remove_test\n");
+
+    if (failed_append_test() != 0)
+    {
+        printf("not ");
+        failed++;
+    }
+    printf("ok - failed_append_test\n");
+
+    if (compaction_test() != 0)
+    {
+        printf("not ");
+        failed++;
+    }
+    printf("ok - compaction_test\n");
+
+    if (failed == 0)
+    {
+        char                            command[300];
+
+        snprintf(command, sizeof(command), "rm -rf %s", state_dir);
+        system(command);
+    }
+    globus_module_deactivate(GLOBUS_COMMON_MODULE);
+
+    return failed;
+}
@@ -0,0 +1,497 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file seg-job-manager-replay-test.c
+ * @brief Job Manager SEG Module Replay Test
+ *
+ * Writes the events in the scheduler event generator's test-data.txt to a
+ * job manager SEG log while the job_manager SEG module is following it,
+ * and checks that the module reports the same events in the same order.
+ * The first third of the events is in yesterday's log, which exists
+ * before the module is loaded. The next third is written to a scratch
+ * file which is then renamed to today's log, the way a log rotation moves
+ * a new day's log into place, and the rest is appended to it a few lines
+ * at a time. When inotify is available the module should see each batch
+ * well before its 2 second poll interval would.
+ */
+#include "globus_common.h"
+#include "globus_scheduler_event_generator.h"
+#include "globus_scheduler_event_generator_app.h"
+
+#include <sys/time.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+#define REPLAY_MAX_EVENTS                       1024
+#define REPLAY_CHUNK_LINES                      8
+#define REPLAY_TIMEOUT                          60
+#define REPLAY_POLL_INTERVAL                    2.0
+
+typedef struct
+{
+    time_t                              timestamp;
+    char                                job_id[32];
+    globus_scheduler_event_type_t       event_type;
+    int                                 code;
+}
+replay_event_t;
+
+static
+struct
+{
+    const char *                        name;
+    globus_scheduler_event_type_t       event_type;
+}
+replay_states[] =
+{
+    { "pending", GLOBUS_SCHEDULER_EVENT_PENDING },
+    { "active", GLOBUS_SCHEDULER_EVENT_ACTIVE },
+    { "done", GLOBUS_SCHEDULER_EVENT_DONE },
+    { "failed", GLOBUS_SCHEDULER_EVENT_FAILED }
+};
+
+static globus_mutex_t                   replay_lock;
+static globus_cond_t                    replay_cond;
+static replay_event_t                   expected[REPLAY_MAX_EVENTS];
+static int                              expected_count;
+static int                              received_count;
+static int                              mismatch = -1;
+
+/*
+ * Read the fixture, lines of offset;id;state, into the events the module
+ * should report, offset from start
+ */
+static
+int
+read_test_data(
+    const char *                        path,
+    time_t                              start)
+{
+    FILE *                              fp;
+    char                                line[128];
+    char                                state[16];
+    long                                offset;
+    int                                 id;
+    int                                 i;
+    replay_event_t *                    event;
+
+    fp = fopen(path, "r");
+    if (fp == NULL)
+    {
+        return 1;
+    }
+    while (fgets(line, sizeof(line), fp) != NULL &&
+           expected_count < REPLAY_MAX_EVENTS)
+    {
+        if (sscanf(line, "%ld;%d;%15s", &offset, &id, state) != 3)
+        {
+            continue;
+        }
+        event = &expected[expected_count];
+        event->timestamp = start + offset;
+        sprintf(event->job_id, "replay.%d", id);
+        event->event_type = GLOBUS_SCHEDULER_EVENT_RAW;
+        for (i = 0; i < sizeof(replay_states)/sizeof(replay_states[0]); i++)
+        {
+            if (strcmp(state, replay_states[i].name) == 0)
+            {
+                event->event_type = replay_states[i].event_type;
+            }
+        }
+        if (event->event_type == GLOBUS_SCHEDULER_EVENT_RAW)
+        {
+            continue;
+        }
+        /* give done and failed events codes to compare */
+        event->code = 0;
+        if (event->event_type == GLOBUS_SCHEDULER_EVENT_DONE)
+        {
+            event->code = id % 4;
+        }
+        else if (event->event_type == GLOBUS_SCHEDULER_EVENT_FAILED)
+        {
+            event->code = 1 + id % 3;
+        }
+        expected_count++;
+    }
+    fclose(fp);
+
+    return expected_count == 0;
+}
+/* read_test_data() */
+
+static
+globus_result_t
+replay_event_handler(
+    void *                              user_arg,
+    const globus_scheduler_event_t *    event)
+{
+    replay_event_t *                    want;
+    int                                 code = 0;
+
+    if (event->event_type == GLOBUS_SCHEDULER_EVENT_RAW)
+    {
+        return GLOBUS_SUCCESS;
+    }
+    if (event->event_type == GLOBUS_SCHEDULER_EVENT_DONE)
+    {
+        code = event->exit_code;
+    }
+    else if (event->event_type == GLOBUS_SCHEDULER_EVENT_FAILED)
+    {
+        code = event->failure_code;
+    }
+
+    globus_mutex_lock(&replay_lock);
+    if (received_count >= expected_count)
+    {
+        printf("# unexpected event %s %d\n",
+                event->job_id, (int) event->event_type);
+        if (mismatch < 0)
+        {
+            mismatch = received_count;
+        }
+    }
+    else
+    {
+        want = &expected[received_count];
+        if (mismatch < 0 &&
+            (event->event_type != want->event_type ||
+             event->timestamp != want->timestamp ||
+             strcmp(event->job_id, want->job_id) != 0 ||
+             code != want->code))
+        {
+            printf("# event %d: expected %s %d %ld %d, got %s %d %ld %d\n",
+                    received_count,
+                    want->job_id,
+                    (int) want->event_type,
+                    (long) want->timestamp,
+                    want->code,
+                    event->job_id,
+                    (int) event->event_type,
+                    (long) event->timestamp,
+                    code);
+            mismatch = received_count;
+        }
+    }
+    received_count++;
+    globus_cond_signal(&replay_cond);
+    globus_mutex_unlock(&replay_lock);
+
+    return GLOBUS_SUCCESS;
+}
+/* replay_event_handler() */
+
+/*
+ * Append events [first, last) to the log in the format the job manager
+ * writes
+ */
+static
+void
+replay_write(
+    FILE *                              log,
+    int                                 first,
+    int                                 last)
+{
+    int                                 i;
+
+    for (i = first; i < last; i++)
+    {
+        fprintf(log, "1;%ld;%s;%d;%d\n",
+                (long) expected[i].timestamp,
+                expected[i].job_id,
+                (int) expected[i].event_type,
+                expected[i].code);
+    }
+    fflush(log);
+}
+/* replay_write() */
+
+/*
+ * Append events [first, last) to the log, if there is one, and wait for
+ * the module to report everything up to last. Returns how long that took,
+ * in seconds.
+ */
+static
+double
+replay_events(
+    FILE *                              log,
+    int                                 first,
+    int                                 last)
+{
+    struct timeval                      start;
+    struct timeval                      end;
+    globus_abstime_t                    deadline;
+    int                                 rc = GLOBUS_SUCCESS;
+
+    gettimeofday(&start, NULL);
+    if (log != NULL)
+    {
+        replay_write(log, first, last);
+    }
+
+    GlobusTimeAbstimeSet(deadline, REPLAY_TIMEOUT, 0);
+    globus_mutex_lock(&replay_lock);
+    while (received_count < last && mismatch < 0 && rc != ETIMEDOUT)
+    {
+        rc = globus_cond_timedwait(&replay_cond, &replay_lock, &deadline);
+    }
+    globus_mutex_unlock(&replay_lock);
+    gettimeofday(&end, NULL);
+
+    return (end.tv_sec - start.tv_sec) +
+            (end.tv_usec - start.tv_usec) / 1000000.0;
+}
+/* replay_events() */
+
+/*
+ * Write the log for the UTC day containing when to path
+ */
+static
+void
+replay_log_path(
+    char *                              path,
+    const char *                        log_dir,
+    time_t                              when)
+{
+    struct tm                           when_tm;
+
+    globus_libc_gmtime_r(&when, &when_tm);
+    sprintf(path, "%s/%4d%02d%02d",
+            log_dir,
+            when_tm.tm_year + 1900,
+            when_tm.tm_mon + 1,
+            when_tm.tm_mday);
+}
+/* replay_log_path() */
+
+/*
+ * The module follows the log with inotify on linux if it can get an
+ * inotify descriptor, and falls back to polling otherwise
+ */
+static
+globus_bool_t
+replay_have_inotify(void)
+{
+#ifdef __linux__
+    int                                 fd;
+
+    fd = inotify_init();
+    if (fd >= 0)
+    {
+        close(fd);
+        return GLOBUS_TRUE;
+    }
+#endif
+    return GLOBUS_FALSE;
+}
+/* replay_have_inotify() */
+
+int
+main(
+    int                                 argc,
+    char *                              argv[])
+{
+    const char *                        data_path;
+    char                                log_dir[] =
+                                        "seg-job-manager-replay-test.XXXXXX";
+    char                                old_path[sizeof(log_dir) + 64];
+    char                                log_path[sizeof(log_dir) + 64];
+    char                                new_path[sizeof(log_dir) + 64];
+    time_t                              now;
+    time_t                              midnight;
+    FILE *                              log = NULL;
+    globus_result_t                     result;
+    double                              elapsed;
+    double                              longest = 0.0;
+    int                                 first_batch;
+    int                                 second_batch;
+    int                                 last;
+    int                                 i;
+    int                                 failed = 0;
+
+    setbuf(stdout, NULL);
+    printf("1..4\n");
+
+    data_path = (argc > 1) ? argv[1] : getenv("SEG_TEST_DATA");
+    if (data_path == NULL)
+    {
+        data_path = "test-data.txt";
+    }
+
+    /* The module names logs by UTC day and skips events before the SEG
+     * timestamp, so replay the fixture from the start of yesterday, with
+     * the first third of it in yesterday's log and the rest in today's
+     */
+    now = time(NULL);
+    midnight = now - (now % 86400);
+    if (read_test_data(data_path, midnight) != 0)
+    {
+        printf("Bail out! can't read test data from %s\n", data_path);
+        return 99;
+    }
+    first_batch = expected_count / 3;
+    second_batch = 2 * expected_count / 3;
+    for (i = 0; i < first_batch; i++)
+    {
+        expected[i].timestamp -= 86400;
+    }
+
+    if (mkdtemp(log_dir) == NULL)
+    {
+        printf("Bail out! can't create log directory\n");
+        return 99;
+    }
+    replay_log_path(old_path, log_dir, midnight - 86400);
+    replay_log_path(log_path, log_dir, midnight);
+    sprintf(new_path, "%s/rotate.tmp", log_dir);
+    setenv("JOB_MANAGER_SEG_LOG_PATH", log_dir, 1);
+    setenv("JOB_MANAGER_SEG_SCHEDULER", "replay", 1);
+
+    log = fopen(old_path, "w");
+    if (log == NULL)
+    {
+        printf("Bail out! can't create %s\n", old_path);
+        rmdir(log_dir);
+        return 99;
+    }
+    replay_write(log, 0, first_batch);
+    fclose(log);
+
+    /* nonthreaded, as in the job manager */
+    globus_thread_set_model(GLOBUS_THREAD_MODEL_NONE);
+
+    if (globus_module_activate(GLOBUS_SCHEDULER_EVENT_GENERATOR_MODULE)
+            != GLOBUS_SUCCESS)
+    {
+        printf("Bail out! can't activate the scheduler event generator\n");
+        unlink(old_path);
+        rmdir(log_dir);
+        return 99;
+    }
+    globus_mutex_init(&replay_lock, NULL);
+    globus_cond_init(&replay_cond, NULL);
+
+    globus_scheduler_event_generator_set_event_handler(
+            replay_event_handler,
+            NULL);
+    globus_scheduler_event_generator_set_timestamp(midnight - 86400);
+
+    result = globus_scheduler_event_generator_load_module("job_manager");
+    if (result != GLOBUS_SUCCESS)
+    {
+        printf("Bail out! can't load job_manager module: %s\n",
+                globus_error_print_friendly(globus_error_peek(result)));
+        globus_module_deactivate_all();
+        unlink(old_path);
+        rmdir(log_dir);
+        return 99;
+    }
+
+    /* Yesterday's log is read as soon as the module is loaded */
+    replay_events(NULL, 0, first_batch);
+    if (received_count != first_batch || mismatch >= 0)
+    {
+        printf("# got %d of %d events\n", received_count, first_batch);
+        printf("not ");
+        failed++;
+    }
+    printf("ok 1 - previous day's log\n");
+
+    /* Today's log is written elsewhere and moved into place, so it
+     * appears with all of its first events at once
+     */
+    log = fopen(new_path, "w");
+    if (log == NULL)
+    {
+        printf("Bail out! can't create %s\n", new_path);
+        globus_module_deactivate_all();
+        unlink(old_path);
+        rmdir(log_dir);
+        return 99;
+    }
+    replay_write(log, first_batch, second_batch);
+    if (rename(new_path, log_path) != 0)
+    {
+        printf("Bail out! can't rename %s to %s\n", new_path, log_path);
+        globus_module_deactivate_all();
+        unlink(new_path);
+        unlink(old_path);
+        rmdir(log_dir);
+        return 99;
+    }
+    longest = replay_events(NULL, first_batch, second_batch);
+    if (received_count != second_batch || mismatch >= 0)
+    {
+        printf("# got %d of %d events\n", received_count, second_batch);
+        printf("not ");
+        failed++;
+    }
+    printf("ok 2 - new day's log moved into place\n");
+
+    /* log still refers to the renamed file */
+    if (failed)
+    {
+        printf("not ");
+    }
+    for (i = second_batch; i < expected_count && !failed; i = last)
+    {
+        last = i + REPLAY_CHUNK_LINES;
+        if (last > expected_count)
+        {
+            last = expected_count;
+        }
+        elapsed = replay_events(log, i, last);
+        if (elapsed > longest)
+        {
+            longest = elapsed;
+        }
+        if (received_count != last || mismatch >= 0)
+        {
+            printf("# got %d of %d events\n", received_count, last);
+            printf("not ");
+            failed++;
+        }
+    }
+    printf("ok 3 - appended events\n");
+
+    printf("# longest wait for events: %.3f seconds\n", longest);
+    if (!replay_have_inotify())
+    {
+        printf("ok 4 # SKIP no inotify, events are polled for\n");
+    }
+    else
+    {
+        if (failed || longest >= REPLAY_POLL_INTERVAL / 4)
+        {
+            printf("not ");
+            failed++;
+        }
+        printf("ok 4 - events seen before the poll interval\n");
+    }
+
+    fclose(log);
+    globus_module_deactivate_all();
+
+    unlink(log_path);
+    unlink(old_path);
+    rmdir(log_dir);
+
+    return failed;
+}
+/* main() */
@@ -553,6 +553,16 @@ globus_ftp_client_handleattr_get_pipeline(
     globus_ftp_client_pipeline_callback_t *     pipeline_callback,
     void **                                     pipeline_arg);
 
+globus_result_t
+globus_ftp_client_handleattr_set_pipeline_params(
+    globus_ftp_client_handleattr_t *            attr,
+    globus_bool_t                               pipeline_params);
+
+globus_result_t
+globus_ftp_client_handleattr_get_pipeline_params(
+    const globus_ftp_client_handleattr_t *      attr,
+    globus_bool_t *                             pipeline_params);
+
 globus_result_t
 globus_ftp_client_handleattr_set_gridftp2(
     globus_ftp_client_handleattr_t *		attr,
@@ -267,6 +267,7 @@ globus_ftp_client_handleattr_init(
     i_attr->pipeline_callback = GLOBUS_NULL;
     i_attr->pipeline_arg = GLOBUS_NULL;
     i_attr->pipeline_done = GLOBUS_FALSE;
+    i_attr->pipeline_params = GLOBUS_FALSE;
     i_attr->gridftp2 = GLOBUS_TRUE;
     i_attr->clientinfo_app_name = 
         globus_libc_strdup(GLOBUS_L_FTP_CLIENT_CLIENTINFO_APPNAME);
@@ -847,6 +848,83 @@ globus_ftp_client_handleattr_get_pipeline(
     return globus_error_put(err);
 }
 /* globus_ftp_client_handleattr_set_pipeline() */
+
+/**
+ * Enable/Disable pipelining of session setup commands.
+ * @ingroup globus_ftp_client_handleattr
+ *
+ * When enabled, the TYPE, MODE, DCAU and PROT commands needed to set up
+ * a data transfer, listing or checksum are sent without waiting for each
+ * reply, saving a round trip for each of them. A negative reply to one of
+ * them fails the operation when the reply to the next command arrives,
+ * and the connection is not cached.
+ *
+ * Only these setup commands are pipelined. A handle still runs one
+ * operation at a time, so stat, mkdir, delete and checksum operations
+ * can't be queued on it; use several handles, or
+ * globus_ftp_client_machine_list() to stat all files in a directory at once.
+ *
+ * @param attr
+ *        Attribute to modify
+ * @param pipeline_params
+ *        Set to GLOBUS_TRUE to pipeline session setup commands.
+ *        Disabled by default.
+ */
+globus_result_t
+globus_ftp_client_handleattr_set_pipeline_params(
+    globus_ftp_client_handleattr_t *            attr,
+    globus_bool_t                               pipeline_params)
+{
+    globus_object_t *                           err = GLOBUS_SUCCESS;
+    globus_i_ftp_client_handleattr_t *          i_attr;
+    GlobusFuncName(globus_ftp_client_handleattr_set_pipeline_params);
+
+    if(attr == GLOBUS_NULL)
+    {
+        err = GLOBUS_I_FTP_CLIENT_ERROR_NULL_PARAMETER("attr");
+
+        goto error_exit;
+    }
+    i_attr = *(globus_i_ftp_client_handleattr_t **) attr;
+
+    i_attr->pipeline_params = pipeline_params;
+
+    return GLOBUS_SUCCESS;
+
+ error_exit:
+    return globus_error_put(err);
+}
+/* globus_ftp_client_handleattr_set_pipeline_params() */
+
+globus_result_t
+globus_ftp_client_handleattr_get_pipeline_params(
+    const globus_ftp_client_handleattr_t *      attr,
+    globus_bool_t *                             pipeline_params)
+{
+    const globus_i_ftp_client_handleattr_t *    i_attr;
+    globus_object_t *                           err = GLOBUS_SUCCESS;
+    GlobusFuncName(globus_ftp_client_handleattr_get_pipeline_params);
+
+    if(attr == GLOBUS_NULL)
+    {
+        err = GLOBUS_I_FTP_CLIENT_ERROR_NULL_PARAMETER("attr");
+
+        goto error_exit;
+    }
+    if(pipeline_params == GLOBUS_NULL)
+    {
+        err = GLOBUS_I_FTP_CLIENT_ERROR_NULL_PARAMETER("pipeline_params");
+
+        goto error_exit;
+    }
+    i_attr = *(const globus_i_ftp_client_handleattr_t **) attr;
+    (*pipeline_params) = i_attr->pipeline_params;
+
+    return GLOBUS_SUCCESS;
+ error_exit:
+    return globus_error_put(err);
+}
+/* globus_ftp_client_handleattr_get_pipeline_params() */
 /*@}*/
 
 
@@ -3959,6 +4037,7 @@ globus_i_ftp_client_handleattr_copy(
     dest->pipeline_callback = src->pipeline_callback;
     dest->pipeline_arg = src->pipeline_arg;
     dest->pipeline_done = src->pipeline_done;
+    dest->pipeline_params = src->pipeline_params;
     dest->gridftp2 = src->gridftp2;
     dest->clientinfo_app_name = globus_libc_strdup(src->clientinfo_app_name);
     dest->clientinfo_app_ver = globus_libc_strdup(src->clientinfo_app_ver);
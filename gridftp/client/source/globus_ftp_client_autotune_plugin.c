@@ -0,0 +1,1488 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLOBUS_DONT_DOCUMENT_INTERNAL
+
+/**
+ * @file globus_ftp_client_autotune_plugin.c
+ * @brief GridFTP Auto-tuning Plugin Implementation
+ */
+
+#include "globus_i_ftp_client.h"
+#include "globus_ftp_client_autotune_plugin.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "version.h"
+
+#define GLOBUS_L_FTP_CLIENT_AUTOTUNE_PLUGIN_NAME \
+    "globus_ftp_client_autotune_plugin"
+
+/* default sampling interval, in seconds */
+#define GLOBUS_L_FTP_CLIENT_AUTOTUNE_INTERVAL       5
+/* most parallelism changes made while a single transfer runs */
+#define GLOBUS_L_FTP_CLIENT_AUTOTUNE_MAX_RESTARTS   6
+/* a new level has to beat the last one by this much to be kept */
+#define GLOBUS_L_FTP_CLIENT_AUTOTUNE_GAIN           1.1f
+/* retransmitted segments per MiB transferred that mean congestion */
+#define GLOBUS_L_FTP_CLIENT_AUTOTUNE_LOSS_LIMIT     2.0f
+/* suggested block size is about 1/16th of a second of one stream */
+#define GLOBUS_L_FTP_CLIENT_AUTOTUNE_BLOCK_DIVISOR  16
+#define GLOBUS_L_FTP_CLIENT_AUTOTUNE_MIN_BLOCK      (64 * 1024)
+#define GLOBUS_L_FTP_CLIENT_AUTOTUNE_MAX_BLOCK      (4 * 1024 * 1024)
+/*
+ * suggested TCP buffer holds about 1/4th of a second of one stream, so a
+ * buffer that limits the throughput grows until it covers any round trip
+ * time up to that
+ */
+#define GLOBUS_L_FTP_CLIENT_AUTOTUNE_BUFFER_DIVISOR 4
+#define GLOBUS_L_FTP_CLIENT_AUTOTUNE_MIN_BUFFER     (64 * 1024)
+#define GLOBUS_L_FTP_CLIENT_AUTOTUNE_MAX_BUFFER     (32 * 1024 * 1024)
+
+#define GLOBUS_L_FTP_CLIENT_AUTOTUNE_PLUGIN_RETURN(plugin) \
+    if(plugin == GLOBUS_NULL) \
+    {\
+	return globus_error_put(globus_error_construct_string(\
+		GLOBUS_FTP_CLIENT_MODULE,\
+		GLOBUS_NULL,\
+		"[%s] NULL plugin at %s\n",\
+		GLOBUS_FTP_CLIENT_MODULE->module_name,\
+		_globus_func_name));\
+    }
+
+/**
+ * Plugin specific data for the auto-tuning plugin
+ */
+typedef struct
+{
+    globus_mutex_t                              lock;
+
+    int                                         min_parallelism;
+    int                                         max_parallelism;
+    globus_reltime_t                            interval;
+    globus_ftp_client_autotune_plugin_tune_cb_t tune_cb;
+    void *                                      user_specific;
+    /** TRUE if running transfers may be restarted with a new parallelism */
+    globus_bool_t                               restart;
+
+    /** The transfer being tuned, and what is needed to restart it */
+    globus_ftp_client_handle_t *                handle;
+    globus_i_ftp_client_operation_t             operation;
+    char *                                      source_url;
+    char *                                      dest_url;
+    globus_ftp_client_operationattr_t           source_attr;
+    globus_ftp_client_operationattr_t           dest_attr;
+
+    /** TRUE if the transfer is in extended block mode */
+    globus_bool_t                               tunable;
+    globus_bool_t                               xfer_running;
+    globus_bool_t                               restart_pending;
+    int                                         restarts_left;
+
+    /** Bytes moved so far, and the last perf marker seen per stripe */
+    globus_off_t                                bytes;
+    globus_off_t *                              stripe_bytes;
+    int                                         num_stripes;
+
+    /** State at the start of the current sampling interval */
+    globus_off_t                                sample_bytes;
+    globus_abstime_t                            sample_time;
+    int                                         sample_retransmits;
+    int                                         skip;
+
+    /** Totals over all samples of the current transfer */
+    globus_off_t                                xfer_bytes;
+    double                                      xfer_secs;
+    int                                         xfer_retransmits;
+
+    /**
+     * Search state, and the settings for the next transfer, kept for as
+     * long as the transfers go to the same endpoint
+     */
+    char *                                      endpoint;
+    int                                         parallelism;
+    int                                         prev_parallelism;
+    float                                       prev_throughput;
+    float                                       throughput;
+    int                                         next_parallelism;
+    globus_size_t                               block_size;
+    globus_size_t                               tcp_buffer;
+    globus_bool_t                               settled;
+
+    globus_bool_t                               ticker_set;
+    globus_callback_handle_t                    ticker_handle;
+}
+globus_l_ftp_client_autotune_plugin_t;
+
+static int globus_l_ftp_client_autotune_plugin_activate(void);
+static int globus_l_ftp_client_autotune_plugin_deactivate(void);
+
+/**
+ * Module descriptor static initializer.
+ */
+globus_module_descriptor_t globus_i_ftp_client_autotune_plugin_module =
+{
+    "globus_ftp_client_autotune_plugin",
+    globus_l_ftp_client_autotune_plugin_activate,
+    globus_l_ftp_client_autotune_plugin_deactivate,
+    GLOBUS_NULL,
+    GLOBUS_NULL,
+    &local_version
+};
+
+static
+int
+globus_l_ftp_client_autotune_plugin_activate(void)
+{
+    return globus_module_activate(GLOBUS_FTP_CLIENT_MODULE);
+}
+
+static
+int
+globus_l_ftp_client_autotune_plugin_deactivate(void)
+{
+    return globus_module_deactivate(GLOBUS_FTP_CLIENT_MODULE);
+}
+
+static
+void
+globus_l_ftp_client_autotune_plugin_ticker(
+    void *                                      user_arg);
+
+/* drop everything remembered about the last transfer; called locked */
+static
+void
+globus_l_ftp_client_autotune_plugin_reset(
+    globus_l_ftp_client_autotune_plugin_t *     d)
+{
+    if(d->source_url)
+    {
+        globus_libc_free(d->source_url);
+        d->source_url = GLOBUS_NULL;
+        globus_ftp_client_operationattr_destroy(&d->source_attr);
+    }
+    if(d->dest_url)
+    {
+        globus_libc_free(d->dest_url);
+        d->dest_url = GLOBUS_NULL;
+        globus_ftp_client_operationattr_destroy(&d->dest_attr);
+    }
+    if(d->stripe_bytes)
+    {
+        globus_free(d->stripe_bytes);
+        d->stripe_bytes = GLOBUS_NULL;
+    }
+    d->num_stripes = 0;
+    d->handle = GLOBUS_NULL;
+    d->operation = GLOBUS_FTP_CLIENT_IDLE;
+}
+
+/*
+ * Sum of the TCP retransmits on our end of the data connections, or -1
+ * if the stack can't tell.  Third party transfers have no local data
+ * connections.  Called with d->lock held; plugin hooks run without the
+ * handle lock, so taking it here doesn't invert anything.
+ */
+static
+int
+globus_l_ftp_client_autotune_plugin_retransmits(
+    globus_l_ftp_client_autotune_plugin_t *     d)
+{
+    globus_i_ftp_client_handle_t *              i_handle;
+    struct globus_i_ftp_client_target_s *       target;
+    globus_result_t                             result;
+    char *                                      count_str = GLOBUS_NULL;
+    char *                                      tmp_ptr;
+    char *                                      end_ptr;
+    long                                        count;
+    int                                         total = 0;
+
+    if(d->operation != GLOBUS_FTP_CLIENT_GET &&
+        d->operation != GLOBUS_FTP_CLIENT_PUT)
+    {
+        return -1;
+    }
+
+    i_handle = *d->handle;
+    globus_i_ftp_client_handle_lock(i_handle);
+    {
+        target = (d->operation == GLOBUS_FTP_CLIENT_GET)
+            ? i_handle->source : i_handle->dest;
+        if(target && target->control_handle)
+        {
+            result = globus_ftp_control_data_get_retransmit_count(
+                target->control_handle, &count_str);
+            if(result != GLOBUS_SUCCESS)
+            {
+                count_str = GLOBUS_NULL;
+            }
+        }
+    }
+    globus_i_ftp_client_handle_unlock(i_handle);
+
+    if(count_str == GLOBUS_NULL)
+    {
+        return -1;
+    }
+
+    tmp_ptr = count_str;
+    while(*tmp_ptr != '\0')
+    {
+        count = strtol(tmp_ptr, &end_ptr, 10);
+        if(end_ptr == tmp_ptr || count < 0)
+        {
+            total = -1;
+            break;
+        }
+        total += (int) count;
+        tmp_ptr = end_ptr;
+        if(*tmp_ptr == ',')
+        {
+            tmp_ptr++;
+        }
+    }
+    globus_free(count_str);
+
+    return total;
+}
+
+static
+int
+globus_l_ftp_client_autotune_plugin_clamp(
+    globus_l_ftp_client_autotune_plugin_t *     d,
+    int                                         parallelism)
+{
+    if(parallelism < d->min_parallelism)
+    {
+        parallelism = d->min_parallelism;
+    }
+    if(parallelism > d->max_parallelism)
+    {
+        parallelism = d->max_parallelism;
+    }
+    return parallelism;
+}
+
+/*
+ * "host:port" of the servers a transfer goes to, for telling whether
+ * what was learned from the last transfer applies to this one
+ */
+static
+char *
+globus_l_ftp_client_autotune_plugin_endpoint(
+    const char *                                source_url,
+    const char *                                dest_url)
+{
+    globus_url_t                                url;
+    const char *                                urls[2];
+    char *                                      endpoint = GLOBUS_NULL;
+    char *                                      tmp;
+    int                                         i;
+
+    urls[0] = source_url;
+    urls[1] = dest_url;
+    for(i = 0; i < 2; i++)
+    {
+        if(urls[i] == GLOBUS_NULL)
+        {
+            continue;
+        }
+        if(globus_url_parse(urls[i], &url) != GLOBUS_URL_SUCCESS)
+        {
+            goto error_exit;
+        }
+        tmp = globus_common_create_string(
+            "%s%s%s:%u",
+            endpoint ? endpoint : "",
+            endpoint ? " " : "",
+            url.host ? url.host : "",
+            (unsigned) url.port);
+        globus_url_destroy(&url);
+        if(endpoint)
+        {
+            globus_free(endpoint);
+        }
+        endpoint = tmp;
+        if(endpoint == GLOBUS_NULL)
+        {
+            goto error_exit;
+        }
+    }
+
+    return endpoint;
+
+error_exit:
+    if(endpoint)
+    {
+        globus_free(endpoint);
+    }
+    return GLOBUS_NULL;
+}
+
+/*
+ * One step of the search, given the throughput and loss measured at
+ * d->parallelism.  Returns the parallelism to measure next, or the one
+ * settled on.  Called locked.
+ */
+static
+int
+globus_l_ftp_client_autotune_plugin_step(
+    globus_l_ftp_client_autotune_plugin_t *     d,
+    float                                       throughput,
+    float                                       loss)
+{
+    int                                         next;
+
+    if(loss > GLOBUS_L_FTP_CLIENT_AUTOTUNE_LOSS_LIMIT)
+    {
+        /* the path is dropping packets; back off and stay there */
+        next = d->parallelism / 2;
+        d->settled = GLOBUS_TRUE;
+    }
+    else if(d->prev_parallelism == 0 ||
+        throughput > d->prev_throughput *
+            GLOBUS_L_FTP_CLIENT_AUTOTUNE_GAIN)
+    {
+        d->prev_parallelism = d->parallelism;
+        d->prev_throughput = throughput;
+        next = d->parallelism * 2;
+    }
+    else
+    {
+        /* no real gain from the last doubling; go back to it */
+        next = d->prev_parallelism;
+        throughput = d->prev_throughput;
+        d->settled = GLOBUS_TRUE;
+    }
+    d->throughput = throughput;
+
+    next = globus_l_ftp_client_autotune_plugin_clamp(d, next);
+    if(next == d->parallelism)
+    {
+        d->settled = GLOBUS_TRUE;
+    }
+    return next;
+}
+
+/*
+ * Apply the settings learned from earlier transfers to the same endpoint
+ * to attr.  Only raises a fixed TCP buffer the user asked for, and only
+ * changes the block size of a blocked layout.  Returns GLOBUS_TRUE if
+ * anything changed.  Called locked.
+ */
+static
+globus_bool_t
+globus_l_ftp_client_autotune_plugin_apply(
+    globus_l_ftp_client_autotune_plugin_t *     d,
+    globus_ftp_client_operationattr_t *         attr)
+{
+    globus_ftp_control_parallelism_t            parallelism;
+    globus_ftp_control_tcpbuffer_t              tcp_buffer;
+    globus_ftp_control_layout_t                 layout;
+    globus_bool_t                               changed = GLOBUS_FALSE;
+
+    if(d->tunable && d->next_parallelism != 0 &&
+        d->next_parallelism != d->parallelism)
+    {
+        parallelism.mode = GLOBUS_FTP_CONTROL_PARALLELISM_FIXED;
+        parallelism.fixed.size = d->next_parallelism;
+        if(globus_ftp_client_operationattr_set_parallelism(
+            attr, &parallelism) == GLOBUS_SUCCESS)
+        {
+            changed = GLOBUS_TRUE;
+        }
+    }
+
+    if(d->tcp_buffer != 0 &&
+        globus_ftp_client_operationattr_get_tcp_buffer(
+            attr, &tcp_buffer) == GLOBUS_SUCCESS &&
+        (tcp_buffer.mode == GLOBUS_FTP_CONTROL_TCPBUFFER_DEFAULT ||
+            (tcp_buffer.mode == GLOBUS_FTP_CONTROL_TCPBUFFER_FIXED &&
+                tcp_buffer.fixed.size < (int) d->tcp_buffer)))
+    {
+        tcp_buffer.mode = GLOBUS_FTP_CONTROL_TCPBUFFER_FIXED;
+        tcp_buffer.fixed.size = (int) d->tcp_buffer;
+        if(globus_ftp_client_operationattr_set_tcp_buffer(
+            attr, &tcp_buffer) == GLOBUS_SUCCESS)
+        {
+            changed = GLOBUS_TRUE;
+        }
+    }
+
+    if(d->block_size != 0 &&
+        globus_ftp_client_operationattr_get_layout(
+            attr, &layout) == GLOBUS_SUCCESS &&
+        layout.mode == GLOBUS_FTP_CONTROL_STRIPING_BLOCKED_ROUND_ROBIN &&
+        layout.round_robin.block_size != d->block_size)
+    {
+        layout.round_robin.block_size = d->block_size;
+        if(globus_ftp_client_operationattr_set_layout(
+            attr, &layout) == GLOBUS_SUCCESS)
+        {
+            changed = GLOBUS_TRUE;
+        }
+    }
+
+    return changed;
+}
+
+/* restart the transfer now with new attributes; called unlocked */
+static
+globus_result_t
+globus_l_ftp_client_autotune_plugin_restart(
+    globus_ftp_client_handle_t *                handle,
+    globus_i_ftp_client_operation_t             operation,
+    const char *                                source_url,
+    globus_ftp_client_operationattr_t *         source_attr,
+    const char *                                dest_url,
+    globus_ftp_client_operationattr_t *         dest_attr)
+{
+    globus_abstime_t                            when;
+    globus_result_t                             result;
+
+    GlobusTimeAbstimeGetCurrent(when);
+    switch(operation)
+    {
+        case GLOBUS_FTP_CLIENT_GET:
+            result = globus_ftp_client_plugin_restart_get(
+                handle,
+                source_url,
+                source_attr,
+                GLOBUS_NULL,
+                &when);
+            break;
+        case GLOBUS_FTP_CLIENT_PUT:
+            result = globus_ftp_client_plugin_restart_put(
+                handle,
+                dest_url,
+                dest_attr,
+                GLOBUS_NULL,
+                &when);
+            break;
+        case GLOBUS_FTP_CLIENT_TRANSFER:
+            result = globus_ftp_client_plugin_restart_third_party_transfer(
+                handle,
+                source_url,
+                source_attr,
+                dest_url,
+                dest_attr,
+                GLOBUS_NULL,
+                &when);
+            break;
+        default:
+            globus_assert(0 && "should never happen--memory corruption");
+            result = GLOBUS_FAILURE;
+    }
+
+    return result;
+}
+
+/*
+ * Called from the get, put and third party transfer hooks, both when the
+ * user starts a transfer and when it is restarted (by us or by anybody
+ * else).  A new transfer to the endpoint of the last one is restarted
+ * right away, before it has moved any data, if what was learned from
+ * the last one changes its attributes.
+ */
+static
+void
+globus_l_ftp_client_autotune_plugin_begin(
+    globus_l_ftp_client_autotune_plugin_t *     d,
+    globus_ftp_client_handle_t *                handle,
+    globus_i_ftp_client_operation_t             operation,
+    const char *                                source_url,
+    const globus_ftp_client_operationattr_t *   source_attr,
+    const char *                                dest_url,
+    const globus_ftp_client_operationattr_t *   dest_attr,
+    globus_bool_t                               restart)
+{
+    globus_ftp_control_parallelism_t            parallelism;
+    globus_ftp_control_mode_t                   mode;
+    globus_ftp_client_operationattr_t           new_source_attr;
+    globus_ftp_client_operationattr_t           new_dest_attr;
+    globus_result_t                             result;
+    char *                                      endpoint = GLOBUS_NULL;
+    globus_bool_t                               retune = GLOBUS_FALSE;
+
+    if(!restart)
+    {
+        endpoint = globus_l_ftp_client_autotune_plugin_endpoint(
+            source_url, dest_url);
+    }
+
+    globus_mutex_lock(&d->lock);
+    {
+        globus_l_ftp_client_autotune_plugin_reset(d);
+
+        d->handle = handle;
+        d->operation = operation;
+        if(source_url)
+        {
+            d->source_url = globus_libc_strdup(source_url);
+            globus_ftp_client_operationattr_copy(
+                &d->source_attr, source_attr);
+        }
+        if(dest_url)
+        {
+            d->dest_url = globus_libc_strdup(dest_url);
+            globus_ftp_client_operationattr_copy(&d->dest_attr, dest_attr);
+        }
+
+        /* the parallelism that matters is the one the sender is told */
+        d->tunable = GLOBUS_FALSE;
+        d->parallelism = 1;
+        result = globus_ftp_client_operationattr_get_mode(
+            source_url ? &d->source_attr : &d->dest_attr, &mode);
+        if(result == GLOBUS_SUCCESS &&
+            mode == GLOBUS_FTP_CONTROL_MODE_EXTENDED_BLOCK)
+        {
+            result = globus_ftp_client_operationattr_get_parallelism(
+                source_url ? &d->source_attr : &d->dest_attr, &parallelism);
+            if(result == GLOBUS_SUCCESS &&
+                parallelism.mode == GLOBUS_FTP_CONTROL_PARALLELISM_FIXED)
+            {
+                d->parallelism = parallelism.fixed.size;
+            }
+            d->tunable = GLOBUS_TRUE;
+        }
+
+        if(!restart)
+        {
+            if(endpoint == GLOBUS_NULL || d->endpoint == GLOBUS_NULL ||
+                strcmp(endpoint, d->endpoint) != 0)
+            {
+                /* what we learned about the last endpoint is no use here */
+                if(d->endpoint)
+                {
+                    globus_free(d->endpoint);
+                }
+                d->endpoint = endpoint;
+                endpoint = GLOBUS_NULL;
+                d->prev_parallelism = 0;
+                d->prev_throughput = 0;
+                d->next_parallelism = 0;
+                d->block_size = 0;
+                d->tcp_buffer = 0;
+                d->settled = GLOBUS_FALSE;
+            }
+            d->bytes = 0;
+            d->xfer_bytes = 0;
+            d->xfer_secs = 0;
+            d->xfer_retransmits = 0;
+            d->restarts_left = GLOBUS_L_FTP_CLIENT_AUTOTUNE_MAX_RESTARTS;
+            d->throughput = 0;
+
+            if(d->source_url)
+            {
+                globus_ftp_client_operationattr_copy(
+                    &new_source_attr, &d->source_attr);
+                retune = globus_l_ftp_client_autotune_plugin_apply(
+                    d, &new_source_attr);
+            }
+            if(d->dest_url)
+            {
+                globus_ftp_client_operationattr_copy(
+                    &new_dest_attr, &d->dest_attr);
+                if(globus_l_ftp_client_autotune_plugin_apply(
+                    d, &new_dest_attr))
+                {
+                    retune = GLOBUS_TRUE;
+                }
+            }
+            d->restart_pending = retune;
+        }
+        else
+        {
+            if(!d->restart_pending && d->restart)
+            {
+                /* somebody else restarted us; the sample we had is useless */
+                d->prev_parallelism = 0;
+            }
+            d->restart_pending = GLOBUS_FALSE;
+        }
+
+        /* let the new connections ramp up before the first sample */
+        d->skip = 1;
+        d->sample_bytes = d->bytes;
+        d->sample_retransmits = -1;
+        GlobusTimeAbstimeGetCurrent(d->sample_time);
+        d->xfer_running = GLOBUS_TRUE;
+
+        if(!d->ticker_set)
+        {
+            d->ticker_set = GLOBUS_TRUE;
+            globus_callback_register_periodic(
+                &d->ticker_handle,
+                &d->interval,
+                &d->interval,
+                globus_l_ftp_client_autotune_plugin_ticker,
+                d);
+        }
+    }
+    globus_mutex_unlock(&d->lock);
+
+    if(endpoint)
+    {
+        globus_free(endpoint);
+    }
+    if(restart)
+    {
+        return;
+    }
+
+    if(retune)
+    {
+        result = globus_l_ftp_client_autotune_plugin_restart(
+            handle,
+            operation,
+            source_url,
+            &new_source_attr,
+            dest_url,
+            &new_dest_attr);
+        if(result != GLOBUS_SUCCESS)
+        {
+            globus_mutex_lock(&d->lock);
+            {
+                d->restart_pending = GLOBUS_FALSE;
+            }
+            globus_mutex_unlock(&d->lock);
+        }
+    }
+    if(source_url)
+    {
+        globus_ftp_client_operationattr_destroy(&new_source_attr);
+    }
+    if(dest_url)
+    {
+        globus_ftp_client_operationattr_destroy(&new_dest_attr);
+    }
+}
+
+/*
+ * Periodic sampling.  Works out the throughput since the last tick and
+ * the block size and TCP buffer to suggest.  When restarts are enabled
+ * it also picks the next parallelism to try for gets and third party
+ * transfers, and restarts the transfer with it.
+ */
+static
+void
+globus_l_ftp_client_autotune_plugin_ticker(
+    void *                                      user_arg)
+{
+    globus_l_ftp_client_autotune_plugin_t *     d;
+    globus_ftp_client_handle_t *                handle = GLOBUS_NULL;
+    globus_i_ftp_client_operation_t             operation = GLOBUS_FTP_CLIENT_IDLE;
+    globus_ftp_control_parallelism_t            parallelism;
+    globus_ftp_client_operationattr_t           source_attr;
+    globus_ftp_client_operationattr_t           dest_attr;
+    char *                                      source_url = GLOBUS_NULL;
+    char *                                      dest_url = GLOBUS_NULL;
+    globus_abstime_t                            now;
+    globus_reltime_t                            elapsed;
+    globus_result_t                             result;
+    globus_off_t                                nbytes;
+    globus_size_t                               block_size = 0;
+    globus_size_t                               tcp_buffer;
+    double                                      secs;
+    float                                       throughput = 0;
+    float                                       loss = 0;
+    int                                         retransmits;
+    int                                         next = 0;
+    int                                         per_stream;
+    globus_bool_t                               restart = GLOBUS_FALSE;
+
+    d = (globus_l_ftp_client_autotune_plugin_t *) user_arg;
+
+    globus_mutex_lock(&d->lock);
+    {
+        if(!d->xfer_running || d->restart_pending)
+        {
+            goto unlock_exit;
+        }
+
+        retransmits = globus_l_ftp_client_autotune_plugin_retransmits(d);
+        GlobusTimeAbstimeGetCurrent(now);
+
+        if(d->skip > 0)
+        {
+            d->skip--;
+            d->sample_bytes = d->bytes;
+            d->sample_time = now;
+            d->sample_retransmits = retransmits;
+            goto unlock_exit;
+        }
+
+        GlobusTimeAbstimeDiff(elapsed, now, d->sample_time);
+        secs = elapsed.tv_sec + elapsed.tv_usec / 1000000.0;
+        nbytes = d->bytes - d->sample_bytes;
+        if(secs <= 0 || nbytes <= 0)
+        {
+            /* stalled; leave that to the restart plugin */
+            goto unlock_exit;
+        }
+
+        throughput = (float) (nbytes / secs);
+        if(retransmits >= 0 && d->sample_retransmits >= 0 &&
+            retransmits > d->sample_retransmits)
+        {
+            loss = (float) (retransmits - d->sample_retransmits) /
+                ((float) nbytes / (1024 * 1024));
+            d->xfer_retransmits += retransmits - d->sample_retransmits;
+        }
+        d->xfer_bytes += nbytes;
+        d->xfer_secs += secs;
+
+        d->sample_bytes = d->bytes;
+        d->sample_time = now;
+        d->sample_retransmits = retransmits;
+
+        per_stream = (int) (throughput / d->parallelism);
+        block_size = GLOBUS_L_FTP_CLIENT_AUTOTUNE_MIN_BLOCK;
+        while(block_size < (globus_size_t) (per_stream /
+                GLOBUS_L_FTP_CLIENT_AUTOTUNE_BLOCK_DIVISOR) &&
+            block_size < GLOBUS_L_FTP_CLIENT_AUTOTUNE_MAX_BLOCK)
+        {
+            block_size *= 2;
+        }
+        d->block_size = block_size;
+
+        tcp_buffer = GLOBUS_L_FTP_CLIENT_AUTOTUNE_MIN_BUFFER;
+        while(tcp_buffer < (globus_size_t) (per_stream /
+                GLOBUS_L_FTP_CLIENT_AUTOTUNE_BUFFER_DIVISOR) &&
+            tcp_buffer < GLOBUS_L_FTP_CLIENT_AUTOTUNE_MAX_BUFFER)
+        {
+            tcp_buffer *= 2;
+        }
+        d->tcp_buffer = tcp_buffer;
+
+        if(!d->restart || !d->tunable ||
+            d->operation == GLOBUS_FTP_CLIENT_PUT ||
+            d->settled || d->restarts_left == 0)
+        {
+            if(throughput > d->throughput)
+            {
+                d->throughput = throughput;
+            }
+            goto unlock_exit;
+        }
+
+        next = globus_l_ftp_client_autotune_plugin_step(d, throughput, loss);
+        throughput = d->throughput;
+        if(next == d->parallelism)
+        {
+            goto unlock_exit;
+        }
+
+        /*
+         * restart copies what it is given on entry, but it has to be
+         * called unlocked, so hand it our own copies
+         */
+        operation = d->operation;
+        handle = d->handle;
+        parallelism.mode = GLOBUS_FTP_CONTROL_PARALLELISM_FIXED;
+        parallelism.fixed.size = next;
+        if(d->source_url)
+        {
+            source_url = globus_libc_strdup(d->source_url);
+            globus_ftp_client_operationattr_copy(
+                &source_attr, &d->source_attr);
+            globus_ftp_client_operationattr_set_parallelism(
+                &source_attr, &parallelism);
+        }
+        if(d->dest_url)
+        {
+            dest_url = globus_libc_strdup(d->dest_url);
+            globus_ftp_client_operationattr_copy(&dest_attr, &d->dest_attr);
+            globus_ftp_client_operationattr_set_parallelism(
+                &dest_attr, &parallelism);
+        }
+        d->restarts_left--;
+        d->restart_pending = GLOBUS_TRUE;
+        restart = GLOBUS_TRUE;
+    }
+unlock_exit:
+    globus_mutex_unlock(&d->lock);
+
+    if(!restart)
+    {
+        return;
+    }
+
+    result = globus_l_ftp_client_autotune_plugin_restart(
+        handle,
+        operation,
+        source_url,
+        &source_attr,
+        dest_url,
+        &dest_attr);
+
+    if(source_url)
+    {
+        globus_libc_free(source_url);
+        globus_ftp_client_operationattr_destroy(&source_attr);
+    }
+    if(dest_url)
+    {
+        globus_libc_free(dest_url);
+        globus_ftp_client_operationattr_destroy(&dest_attr);
+    }
+
+    if(result != GLOBUS_SUCCESS)
+    {
+        globus_mutex_lock(&d->lock);
+        {
+            d->restart_pending = GLOBUS_FALSE;
+            d->settled = GLOBUS_TRUE;
+        }
+        globus_mutex_unlock(&d->lock);
+        return;
+    }
+
+    if(d->tune_cb)
+    {
+        d->tune_cb(
+            d->user_specific, handle, next, block_size, throughput);
+    }
+}
+
+static
+void
+globus_l_ftp_client_autotune_plugin_get(
+    globus_ftp_client_plugin_t *                plugin,
+    void *                                      plugin_specific,
+    globus_ftp_client_handle_t *                handle,
+    const char *                                url,
+    const globus_ftp_client_operationattr_t *   attr,
+    globus_bool_t                               restart)
+{
+    globus_l_ftp_client_autotune_plugin_begin(
+        (globus_l_ftp_client_autotune_plugin_t *) plugin_specific,
+        handle,
+        GLOBUS_FTP_CLIENT_GET,
+        url,
+        attr,
+        GLOBUS_NULL,
+        GLOBUS_NULL,
+        restart);
+}
+
+static
+void
+globus_l_ftp_client_autotune_plugin_put(
+    globus_ftp_client_plugin_t *                plugin,
+    void *                                      plugin_specific,
+    globus_ftp_client_handle_t *                handle,
+    const char *                                url,
+    const globus_ftp_client_operationattr_t *   attr,
+    globus_bool_t                               restart)
+{
+    globus_l_ftp_client_autotune_plugin_begin(
+        (globus_l_ftp_client_autotune_plugin_t *) plugin_specific,
+        handle,
+        GLOBUS_FTP_CLIENT_PUT,
+        GLOBUS_NULL,
+        GLOBUS_NULL,
+        url,
+        attr,
+        restart);
+}
+
+static
+void
+globus_l_ftp_client_autotune_plugin_third_party_transfer(
+    globus_ftp_client_plugin_t *                plugin,
+    void *                                      plugin_specific,
+    globus_ftp_client_handle_t *                handle,
+    const char *                                source_url,
+    const globus_ftp_client_operationattr_t *   source_attr,
+    const char *                                dest_url,
+    const globus_ftp_client_operationattr_t *   dest_attr,
+    globus_bool_t                               restart)
+{
+    globus_l_ftp_client_autotune_plugin_begin(
+        (globus_l_ftp_client_autotune_plugin_t *) plugin_specific,
+        handle,
+        GLOBUS_FTP_CLIENT_TRANSFER,
+        source_url,
+        source_attr,
+        dest_url,
+        dest_attr,
+        restart);
+}
+
+static
+void
+globus_l_ftp_client_autotune_plugin_data(
+    globus_ftp_client_plugin_t *                plugin,
+    void *                                      plugin_specific,
+    globus_ftp_client_handle_t *                handle,
+    globus_object_t *                           error,
+    const globus_byte_t *                       buffer,
+    globus_size_t                               length,
+    globus_off_t                                offset,
+    globus_bool_t                               eof)
+{
+    globus_l_ftp_client_autotune_plugin_t *     d;
+
+    d = (globus_l_ftp_client_autotune_plugin_t *) plugin_specific;
+
+    if(error)
+    {
+        return;
+    }
+
+    globus_mutex_lock(&d->lock);
+    {
+        if(d->xfer_running)
+        {
+            d->bytes += length;
+        }
+    }
+    globus_mutex_unlock(&d->lock);
+}
+
+/* third party transfers are measured from the performance markers */
+static
+void
+globus_l_ftp_client_autotune_plugin_response(
+    globus_ftp_client_plugin_t *                plugin,
+    void *                                      plugin_specific,
+    globus_ftp_client_handle_t *                handle,
+    const char *                                url,
+    globus_object_t *                           error,
+    const globus_ftp_control_response_t *       ftp_response)
+{
+    globus_l_ftp_client_autotune_plugin_t *     d;
+    globus_off_t                                nbytes;
+    char *                                      tmp_ptr;
+    char *                                      buffer;
+    int                                         sc;
+    int                                         stripe_ndx;
+    int                                         num_stripes;
+
+    d = (globus_l_ftp_client_autotune_plugin_t *) plugin_specific;
+
+    if(error ||
+        !ftp_response ||
+        !ftp_response->response_buffer ||
+        ftp_response->code != 112)
+    {
+        return;
+    }
+
+    buffer = (char *) ftp_response->response_buffer;
+
+    tmp_ptr = strstr(buffer, "Total Stripe Count:");
+    if(tmp_ptr == GLOBUS_NULL)
+    {
+        return;
+    }
+    sc = sscanf(tmp_ptr + sizeof("Total Stripe Count:"),
+        " %d", &num_stripes);
+    if(sc != 1 || num_stripes <= 0)
+    {
+        return;
+    }
+
+    tmp_ptr = strstr(buffer, "Stripe Index:");
+    if(tmp_ptr == GLOBUS_NULL)
+    {
+        return;
+    }
+    sc = sscanf(tmp_ptr + sizeof("Stripe Index:"), " %d", &stripe_ndx);
+    if(sc != 1 || stripe_ndx < 0 || stripe_ndx >= num_stripes)
+    {
+        return;
+    }
+
+    tmp_ptr = strstr(buffer, "Stripe Bytes Transferred:");
+    if(tmp_ptr == GLOBUS_NULL)
+    {
+        return;
+    }
+    sc = sscanf(tmp_ptr + sizeof("Stripe Bytes Transferred:"),
+        " %" GLOBUS_OFF_T_FORMAT, &nbytes);
+    if(sc != 1)
+    {
+        return;
+    }
+
+    globus_mutex_lock(&d->lock);
+    {
+        if(!d->xfer_running || d->operation != GLOBUS_FTP_CLIENT_TRANSFER)
+        {
+            goto unlock_exit;
+        }
+        if(d->stripe_bytes == GLOBUS_NULL)
+        {
+            d->stripe_bytes = (globus_off_t *)
+                globus_calloc(num_stripes, sizeof(globus_off_t));
+            if(d->stripe_bytes == GLOBUS_NULL)
+            {
+                goto unlock_exit;
+            }
+            d->num_stripes = num_stripes;
+        }
+        if(stripe_ndx < d->num_stripes &&
+            nbytes > d->stripe_bytes[stripe_ndx])
+        {
+            d->bytes += nbytes - d->stripe_bytes[stripe_ndx];
+            d->stripe_bytes[stripe_ndx] = nbytes;
+        }
+    }
+unlock_exit:
+    globus_mutex_unlock(&d->lock);
+}
+
+static
+void
+globus_l_ftp_client_autotune_plugin_complete(
+    globus_ftp_client_plugin_t *                plugin,
+    void *                                      plugin_specific,
+    globus_ftp_client_handle_t *                handle)
+{
+    globus_l_ftp_client_autotune_plugin_t *     d;
+    globus_bool_t                               report = GLOBUS_FALSE;
+    int                                         parallelism = 0;
+    globus_size_t                               block_size = 0;
+    float                                       throughput = 0;
+    float                                       loss;
+
+    d = (globus_l_ftp_client_autotune_plugin_t *) plugin_specific;
+
+    globus_mutex_lock(&d->lock);
+    {
+        if(d->xfer_running && d->xfer_secs > 0)
+        {
+            if(!d->tunable)
+            {
+                d->throughput = (float) (d->xfer_bytes / d->xfer_secs);
+                parallelism = d->parallelism;
+            }
+            else if(d->restart && d->operation != GLOBUS_FTP_CLIENT_PUT)
+            {
+                /* the search ran while the transfer did */
+                d->next_parallelism = d->parallelism;
+                parallelism = d->parallelism;
+            }
+            else
+            {
+                /* this transfer was one step of the search */
+                if(!d->settled)
+                {
+                    loss = (float) d->xfer_retransmits /
+                        ((float) d->xfer_bytes / (1024 * 1024));
+                    d->next_parallelism =
+                        globus_l_ftp_client_autotune_plugin_step(
+                            d,
+                            (float) (d->xfer_bytes / d->xfer_secs),
+                            loss);
+                }
+                else
+                {
+                    d->throughput = (float) (d->xfer_bytes / d->xfer_secs);
+                }
+                parallelism = d->next_parallelism != 0
+                    ? d->next_parallelism : d->parallelism;
+            }
+            report = GLOBUS_TRUE;
+            block_size = d->block_size;
+            throughput = d->throughput;
+        }
+        d->xfer_running = GLOBUS_FALSE;
+        d->restart_pending = GLOBUS_FALSE;
+        globus_l_ftp_client_autotune_plugin_reset(d);
+
+        if(d->ticker_set)
+        {
+            d->ticker_set = GLOBUS_FALSE;
+            globus_callback_unregister(
+                d->ticker_handle, GLOBUS_NULL, GLOBUS_NULL, GLOBUS_NULL);
+        }
+    }
+    globus_mutex_unlock(&d->lock);
+
+    if(report && d->tune_cb)
+    {
+        d->tune_cb(
+            d->user_specific, handle, parallelism, block_size, throughput);
+    }
+}
+
+static
+globus_ftp_client_plugin_t *
+globus_l_ftp_client_autotune_plugin_copy(
+    globus_ftp_client_plugin_t *                plugin_template,
+    void *                                      plugin_specific)
+{
+    globus_ftp_client_plugin_t *                newguy;
+    globus_l_ftp_client_autotune_plugin_t *     d;
+    globus_result_t                             result;
+
+    d = (globus_l_ftp_client_autotune_plugin_t *) plugin_specific;
+
+    newguy = globus_libc_malloc(sizeof(globus_ftp_client_plugin_t));
+    if(newguy == GLOBUS_NULL)
+    {
+        goto error_exit;
+    }
+    result = globus_ftp_client_autotune_plugin_init(
+        newguy,
+        d->min_parallelism,
+        d->max_parallelism,
+        d->tune_cb,
+        d->user_specific);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto free_exit;
+    }
+    globus_ftp_client_autotune_plugin_set_interval(newguy, &d->interval);
+    globus_ftp_client_autotune_plugin_set_restart(newguy, d->restart);
+
+    return newguy;
+
+free_exit:
+    globus_libc_free(newguy);
+error_exit:
+    return GLOBUS_NULL;
+}
+
+static
+void
+globus_l_ftp_client_autotune_plugin_destroy(
+    globus_ftp_client_plugin_t *                plugin,
+    void *                                      plugin_specific)
+{
+    globus_ftp_client_autotune_plugin_destroy(plugin);
+    globus_libc_free(plugin);
+}
+
+static
+void
+globus_l_ftp_client_autotune_plugin_ticker_done(
+    void *                                      user_arg)
+{
+    globus_l_ftp_client_autotune_plugin_t *     d;
+
+    d = (globus_l_ftp_client_autotune_plugin_t *) user_arg;
+
+    if(d->endpoint)
+    {
+        globus_free(d->endpoint);
+    }
+    globus_mutex_destroy(&d->lock);
+    globus_free(d);
+}
+
+#endif /* GLOBUS_DONT_DOCUMENT_INTERNAL */
+
+/**
+ * Initialize an instance of the GridFTP auto-tuning plugin
+ * @ingroup globus_ftp_client_autotune_plugin
+ *
+ * This function will initialize the plugin-specific instance data
+ * for this plugin, and will make the plugin usable for ftp
+ * client handle attribute and handle creation.
+ *
+ * @param plugin
+ *        A pointer to an uninitialized plugin. The plugin will be
+ *        configured as an auto-tuning plugin.
+ * @param min_parallelism
+ *        The fewest parallel streams the plugin will pick.
+ * @param max_parallelism
+ *        The most parallel streams the plugin will pick.
+ * @param tune_cb
+ *        Callback to be called when the plugin picks new transfer
+ *        parameters. May be GLOBUS_NULL.
+ * @param user_specific
+ *        User argument passed to tune_cb.
+ *
+ * @return This function returns an error if
+ * - plugin is null
+ * - min_parallelism is less than 1, or greater than max_parallelism
+ *
+ * @see globus_ftp_client_autotune_plugin_destroy(),
+ *      globus_ftp_client_handleattr_add_plugin(),
+ *      globus_ftp_client_handleattr_remove_plugin(),
+ *      globus_ftp_client_handle_init()
+ */
+globus_result_t
+globus_ftp_client_autotune_plugin_init(
+    globus_ftp_client_plugin_t *                plugin,
+    int                                         min_parallelism,
+    int                                         max_parallelism,
+    globus_ftp_client_autotune_plugin_tune_cb_t tune_cb,
+    void *                                      user_specific)
+{
+    globus_l_ftp_client_autotune_plugin_t *     d;
+    globus_object_t *                           err;
+    globus_result_t                             result;
+    GlobusFuncName(globus_ftp_client_autotune_plugin_init);
+
+    GLOBUS_L_FTP_CLIENT_AUTOTUNE_PLUGIN_RETURN(plugin);
+
+    if(min_parallelism < 1 || max_parallelism < min_parallelism)
+    {
+        return globus_error_put(globus_error_construct_string(
+            GLOBUS_FTP_CLIENT_MODULE,
+            GLOBUS_NULL,
+            "[%s] Invalid parallelism range %d-%d at %s\n",
+            GLOBUS_FTP_CLIENT_MODULE->module_name,
+            min_parallelism,
+            max_parallelism,
+            _globus_func_name));
+    }
+
+    d = globus_libc_calloc(1, sizeof(globus_l_ftp_client_autotune_plugin_t));
+    if(d == GLOBUS_NULL)
+    {
+        return globus_error_put(globus_error_construct_string(
+            GLOBUS_FTP_CLIENT_MODULE,
+            GLOBUS_NULL,
+            "[%s] Out of memory at %s\n",
+            GLOBUS_FTP_CLIENT_MODULE->module_name,
+            _globus_func_name));
+    }
+
+    result = globus_ftp_client_plugin_init(plugin,
+        GLOBUS_L_FTP_CLIENT_AUTOTUNE_PLUGIN_NAME,
+        GLOBUS_FTP_CLIENT_CMD_MASK_ALL,
+        d);
+    if(result != GLOBUS_SUCCESS)
+    {
+        globus_libc_free(d);
+        return result;
+    }
+
+    globus_mutex_init(&d->lock, GLOBUS_NULL);
+    d->min_parallelism = min_parallelism;
+    d->max_parallelism = max_parallelism;
+    d->tune_cb = tune_cb;
+    d->user_specific = user_specific;
+    d->operation = GLOBUS_FTP_CLIENT_IDLE;
+    GlobusTimeReltimeSet(
+        d->interval, GLOBUS_L_FTP_CLIENT_AUTOTUNE_INTERVAL, 0);
+
+    result = globus_ftp_client_plugin_set_copy_func(plugin,
+        globus_l_ftp_client_autotune_plugin_copy);
+    if(result != GLOBUS_SUCCESS) goto result_exit;
+    result = globus_ftp_client_plugin_set_destroy_func(plugin,
+        globus_l_ftp_client_autotune_plugin_destroy);
+    if(result != GLOBUS_SUCCESS) goto result_exit;
+    result = globus_ftp_client_plugin_set_get_func(plugin,
+        globus_l_ftp_client_autotune_plugin_get);
+    if(result != GLOBUS_SUCCESS) goto result_exit;
+    result = globus_ftp_client_plugin_set_put_func(plugin,
+        globus_l_ftp_client_autotune_plugin_put);
+    if(result != GLOBUS_SUCCESS) goto result_exit;
+    result = globus_ftp_client_plugin_set_third_party_transfer_func(plugin,
+        globus_l_ftp_client_autotune_plugin_third_party_transfer);
+    if(result != GLOBUS_SUCCESS) goto result_exit;
+    result = globus_ftp_client_plugin_set_data_func(plugin,
+        globus_l_ftp_client_autotune_plugin_data);
+    if(result != GLOBUS_SUCCESS) goto result_exit;
+    result = globus_ftp_client_plugin_set_response_func(plugin,
+        globus_l_ftp_client_autotune_plugin_response);
+    if(result != GLOBUS_SUCCESS) goto result_exit;
+    result = globus_ftp_client_plugin_set_complete_func(plugin,
+        globus_l_ftp_client_autotune_plugin_complete);
+    if(result != GLOBUS_SUCCESS) goto result_exit;
+
+    return GLOBUS_SUCCESS;
+
+result_exit:
+    err = globus_error_get(result);
+    globus_ftp_client_autotune_plugin_destroy(plugin);
+    return globus_error_put(err);
+}
+/* globus_ftp_client_autotune_plugin_init() */
+
+/**
+ * Set the sampling interval of a GridFTP auto-tuning plugin
+ * @ingroup globus_ftp_client_autotune_plugin
+ *
+ * Each parallelism level is measured over one interval, after one
+ * interval of ramp up, so shorter intervals find a setting sooner but
+ * are more easily fooled by a noisy network.  The default is 5 seconds.
+ *
+ * @param plugin
+ *        A pointer to a GridFTP auto-tuning plugin, previously
+ *        initialized by calling globus_ftp_client_autotune_plugin_init()
+ * @param interval
+ *        The new sampling interval.
+ *
+ * @return This function returns an error if
+ * - plugin or interval is null
+ * - plugin is not an auto-tuning plugin
+ */
+globus_result_t
+globus_ftp_client_autotune_plugin_set_interval(
+    globus_ftp_client_plugin_t *                plugin,
+    const globus_reltime_t *                    interval)
+{
+    globus_l_ftp_client_autotune_plugin_t *     d;
+    globus_result_t                             result;
+    GlobusFuncName(globus_ftp_client_autotune_plugin_set_interval);
+
+    GLOBUS_L_FTP_CLIENT_AUTOTUNE_PLUGIN_RETURN(plugin);
+
+    if(interval == GLOBUS_NULL)
+    {
+        return globus_error_put(globus_error_construct_string(
+            GLOBUS_FTP_CLIENT_MODULE,
+            GLOBUS_NULL,
+            "[%s] NULL interval at %s\n",
+            GLOBUS_FTP_CLIENT_MODULE->module_name,
+            _globus_func_name));
+    }
+
+    result = globus_ftp_client_plugin_get_plugin_specific(plugin,
+        (void **) (void *) &d);
+    if(result != GLOBUS_SUCCESS)
+    {
+        return result;
+    }
+
+    globus_mutex_lock(&d->lock);
+    {
+        GlobusTimeReltimeCopy(d->interval, *interval);
+    }
+    globus_mutex_unlock(&d->lock);
+
+    return GLOBUS_SUCCESS;
+}
+/* globus_ftp_client_autotune_plugin_set_interval() */
+
+/**
+ * Let a GridFTP auto-tuning plugin restart transfers while they run
+ * @ingroup globus_ftp_client_autotune_plugin
+ *
+ * By default the plugin only changes the parallelism between transfers:
+ * each transfer to an endpoint measures one level and the next transfer
+ * to it is started with the level after that.  With restarts enabled
+ * gets and third party transfers move through the levels while they
+ * run, each change costing a restart of the transfer, which suits a few
+ * large files better than many small ones.  Puts are still only tuned
+ * between transfers.
+ *
+ * @param plugin
+ *        A pointer to a GridFTP auto-tuning plugin, previously
+ *        initialized by calling globus_ftp_client_autotune_plugin_init()
+ * @param restart
+ *        GLOBUS_TRUE to restart running transfers with a new
+ *        parallelism.
+ *
+ * @return This function returns an error if
+ * - plugin is null
+ * - plugin is not an auto-tuning plugin
+ */
+globus_result_t
+globus_ftp_client_autotune_plugin_set_restart(
+    globus_ftp_client_plugin_t *                plugin,
+    globus_bool_t                               restart)
+{
+    globus_l_ftp_client_autotune_plugin_t *     d;
+    globus_result_t                             result;
+    GlobusFuncName(globus_ftp_client_autotune_plugin_set_restart);
+
+    GLOBUS_L_FTP_CLIENT_AUTOTUNE_PLUGIN_RETURN(plugin);
+
+    result = globus_ftp_client_plugin_get_plugin_specific(plugin,
+        (void **) (void *) &d);
+    if(result != GLOBUS_SUCCESS)
+    {
+        return result;
+    }
+
+    globus_mutex_lock(&d->lock);
+    {
+        d->restart = restart;
+    }
+    globus_mutex_unlock(&d->lock);
+
+    return GLOBUS_SUCCESS;
+}
+/* globus_ftp_client_autotune_plugin_set_restart() */
+
+/**
+ * Destroy an instance of the GridFTP auto-tuning plugin
+ * @ingroup globus_ftp_client_autotune_plugin
+ *
+ * This function will free all auto-tuning plugin-specific instance data
+ * from this plugin, and will make the plugin unusable for further ftp
+ * handle creation.
+ *
+ * Existing FTP client handles and handle attributes will not be affected by
+ * destroying a plugin associated with them, as a local copy of the plugin
+ * is made upon handle initialization.
+ *
+ * @param plugin
+ *        A pointer to a GridFTP auto-tuning plugin, previously
+ *        initialized by calling globus_ftp_client_autotune_plugin_init()
+ *
+ * @return This function returns an error if
+ * - plugin is null
+ * - plugin is not an auto-tuning plugin
+ *
+ * @see globus_ftp_client_autotune_plugin_init(),
+ *      globus_ftp_client_handleattr_add_plugin(),
+ *      globus_ftp_client_handleattr_remove_plugin(),
+ *      globus_ftp_client_handle_init()
+ */
+globus_result_t
+globus_ftp_client_autotune_plugin_destroy(
+    globus_ftp_client_plugin_t *                plugin)
+{
+    globus_l_ftp_client_autotune_plugin_t *     d;
+    globus_result_t                             result;
+    globus_bool_t                               ticker_set;
+    GlobusFuncName(globus_ftp_client_autotune_plugin_destroy);
+
+    GLOBUS_L_FTP_CLIENT_AUTOTUNE_PLUGIN_RETURN(plugin);
+
+    result = globus_ftp_client_plugin_get_plugin_specific(plugin,
+        (void **) (void *) &d);
+    if(result != GLOBUS_SUCCESS)
+    {
+        return result;
+    }
+
+    globus_mutex_lock(&d->lock);
+    {
+        d->xfer_running = GLOBUS_FALSE;
+        globus_l_ftp_client_autotune_plugin_reset(d);
+        ticker_set = d->ticker_set;
+        d->ticker_set = GLOBUS_FALSE;
+    }
+    globus_mutex_unlock(&d->lock);
+
+    if(ticker_set)
+    {
+        /* d is freed once the ticker can no longer be running */
+        globus_callback_unregister(
+            d->ticker_handle,
+            globus_l_ftp_client_autotune_plugin_ticker_done,
+            d,
+            GLOBUS_NULL);
+    }
+    else
+    {
+        globus_l_ftp_client_autotune_plugin_ticker_done(d);
+    }
+
+    return globus_ftp_client_plugin_destroy(plugin);
+}
+/* globus_ftp_client_autotune_plugin_destroy() */
@@ -0,0 +1,124 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLOBUS_FTP_CLIENT_AUTOTUNE_PLUGIN_H
+#define GLOBUS_FTP_CLIENT_AUTOTUNE_PLUGIN_H
+
+/**
+ * @file globus_ftp_client_autotune_plugin.h
+ * @brief GridFTP Auto-tuning Plugin Implementation
+ */
+
+/**
+ * @defgroup globus_ftp_client_autotune_plugin Auto-tuning Plugin
+ * @ingroup globus_ftp_client_plugins
+ *
+ * The auto-tuning plugin picks the number of parallel data streams,
+ * the TCP buffer size and the block size for the transfers on a handle,
+ * so the user doesn't have to guess them up front.
+ *
+ * Every sampling interval the plugin measures the transfer's throughput,
+ * from the data callbacks for gets and puts and from the performance
+ * markers for third party transfers, along with the TCP retransmits on
+ * the local data connections when there are any.  Starting from the
+ * parallelism in the operation attributes it doubles the number of
+ * streams for as long as that raises the throughput by more than 10%
+ * without a rise in retransmits, then settles on the best level it saw.
+ * Heavy retransmits halve the number of streams instead.  Each transfer
+ * in extended block mode measures one level, and the next transfer to
+ * the same servers is run at the next one.  With
+ * globus_ftp_client_autotune_plugin_set_restart() gets and third party
+ * transfers instead move through the levels while they run, by being
+ * restarted with a new "OPTS RETR Parallelism" setting; data already
+ * transferred is not sent again.  The number of restarts per transfer
+ * is bounded.
+ *
+ * From the per-stream throughput the plugin also works out a TCP buffer
+ * size, which the next transfer to the same servers uses unless the user
+ * asked for a larger one, and a block size, which replaces the block
+ * size of a blocked stripe layout on the next transfer.  The block size
+ * is also passed to the tune callback, since the plugin can't change
+ * the buffers the application registers.
+ *
+ * New settings are applied to a transfer by restarting it as soon as it
+ * starts, before it has moved any data, so puts are tuned as well.
+ */
+
+#include "globus_ftp_client.h"
+#include "globus_ftp_client_plugin.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Module descriptor
+ * @ingroup globus_ftp_client_autotune_plugin
+ */
+#define GLOBUS_FTP_CLIENT_AUTOTUNE_PLUGIN_MODULE \
+        (&globus_i_ftp_client_autotune_plugin_module)
+extern globus_module_descriptor_t globus_i_ftp_client_autotune_plugin_module;
+
+/**
+ * Tune callback
+ * @ingroup globus_ftp_client_autotune_plugin
+ * This callback is called each time the plugin restarts a transfer with
+ * new parameters, and when a transfer completes with the parameters the
+ * next transfer to the same servers will use.
+ * @param user_specific
+ *        User argument passed to globus_ftp_client_autotune_plugin_init
+ * @param handle
+ *        The client handle associated with this transfer
+ * @param parallelism
+ *        The number of parallel streams per stripe
+ * @param block_size
+ *        The suggested size of the buffers registered for the transfer
+ * @param throughput
+ *        The throughput measured at the previous setting (bytes / sec)
+ */
+typedef void (*globus_ftp_client_autotune_plugin_tune_cb_t)(
+    void *                                          user_specific,
+    globus_ftp_client_handle_t *                    handle,
+    int                                             parallelism,
+    globus_size_t                                   block_size,
+    float                                           throughput);
+
+globus_result_t
+globus_ftp_client_autotune_plugin_init(
+    globus_ftp_client_plugin_t *                    plugin,
+    int                                             min_parallelism,
+    int                                             max_parallelism,
+    globus_ftp_client_autotune_plugin_tune_cb_t     tune_cb,
+    void *                                          user_specific);
+
+globus_result_t
+globus_ftp_client_autotune_plugin_set_interval(
+    globus_ftp_client_plugin_t *                    plugin,
+    const globus_reltime_t *                        interval);
+
+globus_result_t
+globus_ftp_client_autotune_plugin_set_restart(
+    globus_ftp_client_plugin_t *                    plugin,
+    globus_bool_t                                   restart);
+
+globus_result_t
+globus_ftp_client_autotune_plugin_destroy(
+    globus_ftp_client_plugin_t *                    plugin);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GLOBUS_FTP_CLIENT_AUTOTUNE_PLUGIN_H */
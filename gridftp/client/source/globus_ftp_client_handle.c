@@ -1287,6 +1287,10 @@ globus_l_ftp_client_target_delete(
     {
         globus_libc_free(target->dcau.subject.subject);
     }
+    if(target->pipelined_error)
+    {
+        globus_object_free(target->pipelined_error);
+    }
     if(target->net_stack_str)
     {
         globus_libc_free(target->net_stack_str);
@@ -1386,8 +1390,11 @@ globus_i_ftp_client_target_release(
     searcher.attr = target->attr;
     searcher.want_empty = GLOBUS_TRUE;
 
-    /* Check to see if we should cache this target */
-    if(target->state == GLOBUS_FTP_CLIENT_TARGET_SETUP_CONNECTION)
+    /* Check to see if we should cache this target. One with a failed
+     * pipelined setup command doesn't know what state the server's in.
+     */
+    if(target->state == GLOBUS_FTP_CLIENT_TARGET_SETUP_CONNECTION &&
+       target->pipelined_error == GLOBUS_NULL)
     {
 	node = globus_list_search_pred(handle->attr.url_cache,
 				       globus_l_ftp_client_compare_canonically,
@@ -167,6 +167,19 @@ globus_l_ftp_client_use_gridftp2_getput(
     globus_i_ftp_client_target_t *		target,
     globus_bool_t *                             getput);
 
+static
+globus_bool_t
+globus_l_ftp_client_can_pipeline(
+    globus_i_ftp_client_handle_t *		client_handle);
+
+static
+void
+globus_l_ftp_client_pipelined_response_callback(
+    void *					user_arg,
+    globus_ftp_control_handle_t *		handle,
+    globus_object_t *				error,
+    globus_ftp_control_response_t *		response);
+
 static
 globus_result_t
 globus_l_ftp_client_send_get(
@@ -278,6 +291,7 @@ globus_i_ftp_client_response_callback(
     int						rc, oldrc, i;
     char *                                      pathname;
     globus_bool_t			        gridftp2_getput;
+    globus_bool_t				pipelined;
     GlobusFuncName(globus_i_ftp_client_response_callback);
     
     target = (globus_i_ftp_client_target_t *) user_arg;
@@ -361,6 +375,22 @@ globus_i_ftp_client_response_callback(
 	goto finish;
     }        
 
+    /* A pipelined setup command sent before this one failed. Its reply
+     * came first, so fail the setup now as if we'd waited for it.
+     */
+    if(target->pipelined_error)
+    {
+        if(error)
+        {
+            globus_object_free(error);
+        }
+        error = target->pipelined_error;
+        target->pipelined_error = GLOBUS_NULL;
+        target->state = GLOBUS_FTP_CLIENT_TARGET_SETUP_CONNECTION;
+
+        goto notify_fault;
+    }
+
     /* The behaviour of several states depends on whether to use the
      * GFD.47 (a.k.a GridFTP 2) GETPUT extension.
      */
@@ -828,10 +858,13 @@ redo:
 	    client_handle->state ==
 	    GLOBUS_FTP_CLIENT_HANDLE_DEST_SETUP_CONNECTION);
 
+	pipelined = globus_l_ftp_client_can_pipeline(client_handle);
 	result = globus_ftp_control_send_command(
 	    target->control_handle,
 	    "TYPE %c" CRLF,
-	    globus_i_ftp_client_response_callback,
+	    pipelined
+		? globus_l_ftp_client_pipelined_response_callback
+		: globus_i_ftp_client_response_callback,
 	    target,
 	    (char) target->attr->type);
 
@@ -839,6 +872,10 @@ redo:
 	{
 	    goto result_fault;
 	}
+	if(pipelined)
+	{
+	    goto pipelined_type;
+	}
 
 	break;
 
@@ -852,6 +889,7 @@ redo:
 	if((!error) &&
 	   response->response_class == GLOBUS_FTP_POSITIVE_COMPLETION_REPLY)
 	{
+	pipelined_type:
 	    target->type = target->attr->type;
 	    result = globus_ftp_control_local_type(target->control_handle,
 						   target->type,
@@ -1181,10 +1219,13 @@ redo:
 	    client_handle->state ==
 	    GLOBUS_FTP_CLIENT_HANDLE_DEST_SETUP_CONNECTION);
 
+	pipelined = globus_l_ftp_client_can_pipeline(client_handle);
 	result = globus_ftp_control_send_command(
 	    target->control_handle,
 	    "MODE %c" CRLF,
-	    globus_i_ftp_client_response_callback,
+	    pipelined
+		? globus_l_ftp_client_pipelined_response_callback
+		: globus_i_ftp_client_response_callback,
 	    target,
 	    (char) target->attr->mode);
 
@@ -1192,6 +1233,10 @@ redo:
 	{
 	    goto result_fault;
 	}
+	if(pipelined)
+	{
+	    goto pipelined_mode;
+	}
 
 	break;
 
@@ -1205,6 +1250,7 @@ redo:
 	if((!error) &&
 	   response->response_class == GLOBUS_FTP_POSITIVE_COMPLETION_REPLY)
 	{
+	pipelined_mode:
 	    target->mode = target->attr->mode;
 	    
 	    /* disable source pasv */
@@ -1914,10 +1960,13 @@ redo:
 	    client_handle->state ==
 	    GLOBUS_FTP_CLIENT_HANDLE_DEST_SETUP_CONNECTION);
 
+	pipelined = globus_l_ftp_client_can_pipeline(client_handle);
 	result = globus_ftp_control_send_command(
 	    target->control_handle,
 	    "DCAU %c%s%s" CRLF,
-	    globus_i_ftp_client_response_callback,
+	    pipelined
+		? globus_l_ftp_client_pipelined_response_callback
+		: globus_i_ftp_client_response_callback,
 	    target,
 	    (char) target->attr->dcau.mode == GLOBUS_FTP_CONTROL_DCAU_DEFAULT
 	        ? GLOBUS_FTP_CONTROL_DCAU_SELF : target->attr->dcau.mode,
@@ -1930,6 +1979,10 @@ redo:
 	{
 	    goto result_fault;
 	}
+	if(pipelined)
+	{
+	    goto pipelined_dcau;
+	}
 
 	break;
 
@@ -1943,7 +1996,7 @@ redo:
 	if((!error) &&
 	   response->response_class == GLOBUS_FTP_POSITIVE_COMPLETION_REPLY)
 	{
-
+	pipelined_dcau:
 	    if(target->attr->dcau.mode == GLOBUS_FTP_CONTROL_DCAU_SUBJECT)
 	    {
 		char * tmp_subj;
@@ -2155,10 +2208,13 @@ redo:
 	    client_handle->state ==
 	    GLOBUS_FTP_CLIENT_HANDLE_DEST_SETUP_CONNECTION);
 
+	pipelined = globus_l_ftp_client_can_pipeline(client_handle);
 	result = globus_ftp_control_send_command(
 	    target->control_handle,
 	    "PROT %c" CRLF,
-	    globus_i_ftp_client_response_callback,
+	    pipelined
+		? globus_l_ftp_client_pipelined_response_callback
+		: globus_i_ftp_client_response_callback,
 	    target,
 	    (char) target->attr->data_prot);
 
@@ -2166,6 +2222,10 @@ redo:
 	{
 	    goto result_fault;
 	}
+	if(pipelined)
+	{
+	    goto pipelined_prot;
+	}
 
 	break;
 
@@ -2179,6 +2239,7 @@ redo:
 	if((!error) &&
 	   response->response_class == GLOBUS_FTP_POSITIVE_COMPLETION_REPLY)
 	{
+	pipelined_prot:
 	    target->data_prot = target->attr->data_prot;
 
 	    result = globus_ftp_control_local_prot(target->control_handle,
@@ -6244,6 +6305,121 @@ globus_l_ftp_client_connection_error(
 }
 /* globus_l_ftp_client_connection_error() */
 
+/**
+ * Decide whether a session setup command may be pipelined.
+ *
+ * TYPE, MODE, DCAU and PROT only change the server's session state, so
+ * when the handle attribute allows it they are sent without waiting for
+ * their replies. That is only done for operations which are sure to send
+ * another command before completing, so that a failure is noticed before
+ * the operation is reported as done.
+ *
+ * @param client_handle
+ *        The client handle which is setting up the target.
+ */
+static
+globus_bool_t
+globus_l_ftp_client_can_pipeline(
+    globus_i_ftp_client_handle_t *		client_handle)
+{
+    if(!client_handle->attr.pipeline_params)
+    {
+	return GLOBUS_FALSE;
+    }
+
+    switch(client_handle->op)
+    {
+      case GLOBUS_FTP_CLIENT_GET:
+      case GLOBUS_FTP_CLIENT_PUT:
+      case GLOBUS_FTP_CLIENT_TRANSFER:
+      case GLOBUS_FTP_CLIENT_LIST:
+      case GLOBUS_FTP_CLIENT_NLST:
+      case GLOBUS_FTP_CLIENT_MLSD:
+      case GLOBUS_FTP_CLIENT_MLSR:
+      case GLOBUS_FTP_CLIENT_CKSM:
+	return GLOBUS_TRUE;
+      default:
+	return GLOBUS_FALSE;
+    }
+}
+/* globus_l_ftp_client_can_pipeline() */
+
+/**
+ * Response callback for pipelined session setup commands.
+ *
+ * The state machine has already gone on as if the command succeeded. The
+ * control library delivers replies in the order the commands were sent,
+ * so this runs before the reply to the next command is processed; a
+ * failure is saved in the target and reported from there.
+ *
+ * @param user_arg
+ *        The target the command was sent on.
+ * @param handle
+ *        The control handle associated with the target.
+ * @param error
+ *        Error object, if the control library couldn't get a reply.
+ * @param response
+ *        The reply to the pipelined command.
+ */
+static
+void
+globus_l_ftp_client_pipelined_response_callback(
+    void *					user_arg,
+    globus_ftp_control_handle_t *		handle,
+    globus_object_t *				error,
+    globus_ftp_control_response_t *		response)
+{
+    globus_i_ftp_client_target_t *		target;
+    globus_i_ftp_client_handle_t *		client_handle;
+    GlobusFuncName(globus_l_ftp_client_pipelined_response_callback);
+
+    target = (globus_i_ftp_client_target_t *) user_arg;
+    client_handle = target->owner;
+
+    if(client_handle == GLOBUS_NULL)
+    {
+	/* target is being closed, nothing is waiting on this */
+	return;
+    }
+
+    globus_i_ftp_client_handle_lock(client_handle);
+
+    if(response)
+    {
+	globus_i_ftp_client_plugin_notify_response(
+	    client_handle,
+	    target->url_string,
+	    GLOBUS_FTP_CLIENT_CMD_MASK_TRANSFER_PARAMETERS,
+	    error,
+	    response);
+    }
+
+    if(target->pipelined_error == GLOBUS_NULL &&
+       client_handle->state != GLOBUS_FTP_CLIENT_HANDLE_ABORT &&
+       client_handle->state != GLOBUS_FTP_CLIENT_HANDLE_RESTART &&
+       client_handle->state != GLOBUS_FTP_CLIENT_HANDLE_FAILURE)
+    {
+	if(error)
+	{
+	    target->pipelined_error = globus_object_copy(error);
+	}
+	else if(response == GLOBUS_NULL)
+	{
+	    target->pipelined_error =
+		GLOBUS_I_FTP_CLIENT_ERROR_PROTOCOL_ERROR();
+	}
+	else if(response->response_class !=
+		GLOBUS_FTP_POSITIVE_COMPLETION_REPLY)
+	{
+	    target->pipelined_error =
+		GLOBUS_I_FTP_CLIENT_ERROR_RESPONSE(response);
+	}
+    }
+
+    globus_i_ftp_client_handle_unlock(client_handle);
+}
+/* globus_l_ftp_client_pipelined_response_callback() */
+
 static
 const char *
 globus_l_ftp_client_guess_buffer_command(
@@ -234,6 +234,8 @@ typedef struct globus_i_ftp_client_handleattr_t
     globus_ftp_client_pipeline_callback_t       pipeline_callback;
     void *                                      pipeline_arg;
     globus_bool_t                               pipeline_done;
+    /** Send session setup commands without waiting for their replies */
+    globus_bool_t                               pipeline_params;
     
     /*
      *  NETLOGGER
@@ -727,6 +729,9 @@ typedef struct globus_i_ftp_client_target_s
     
     globus_bool_t                               src_command_sent;
     globus_bool_t                               dst_command_sent;
+
+    /** First failure of a pipelined setup command, not yet reported */
+    globus_object_t *                           pipelined_error;
     
     globus_list_t *                             net_stack_list;
     
@@ -183,6 +183,40 @@ sub throughput_test
 
 push(@tests, "throughput_test();");
 
+=head2 I<autotune_test> (Test 264)
+
+Do an extended get of $testfile, enabling autotune_plugin. Compare the
+resulting file with the real file, since the plugin may restart the
+transfer with a different parallelism part way through.
+
+On loopback the transfer usually ends before the plugin changes anything;
+shaping the loopback interface first (for example
+C<tc qdisc add dev lo root netem delay 20ms rate 100mbit>) gives it a
+path worth tuning.
+
+=back
+
+=cut
+sub autotune_test
+{
+    my $tmpname = File::Temp::tmpnam();
+    my ($errors,$rc) = ("",0);
+
+    unlink($tmpname);
+
+    my $command = "$test_exec -P 1 -s $proto$source_host$testfile -A";
+    $errors = run_command($command, 0, $tmpname);
+    if($errors eq "" && 0 != &compare_data($test_data, $tmpname))
+    {
+        $errors .= "\n# Differences between $testfile and output.";
+    }
+
+    ok($errors eq "", "autotune_test $command");
+    unlink($tmpname);
+}
+
+push(@tests, "autotune_test();");
+
 if(defined($ENV{FTP_TEST_RANDOMIZE}))
 {
     shuffle(\@tests);
@@ -0,0 +1,95 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "globus_ftp_client_test_autotune_plugin.h"
+#include "globus_ftp_client_autotune_plugin.h"
+
+static globus_bool_t globus_l_ftp_client_test_autotune_plugin_activate(void);
+static globus_bool_t globus_l_ftp_client_test_autotune_plugin_deactivate(void);
+
+globus_module_descriptor_t globus_i_ftp_client_test_autotune_plugin_module =
+{
+    "globus_ftp_client_test_autotune_plugin",
+    globus_l_ftp_client_test_autotune_plugin_activate,
+    globus_l_ftp_client_test_autotune_plugin_deactivate,
+    GLOBUS_NULL
+};
+
+static
+int
+globus_l_ftp_client_test_autotune_plugin_activate(void)
+{
+    int rc;
+
+    rc = globus_module_activate(GLOBUS_FTP_CLIENT_AUTOTUNE_PLUGIN_MODULE);
+    return rc;
+}
+
+static
+int
+globus_l_ftp_client_test_autotune_plugin_deactivate(void)
+{
+    return globus_module_deactivate(GLOBUS_FTP_CLIENT_AUTOTUNE_PLUGIN_MODULE);
+}
+
+static
+void autotune_plugin_tune_cb(
+    void *                                          user_arg,
+    globus_ftp_client_handle_t *                    handle,
+    int                                             parallelism,
+    globus_size_t                                   block_size,
+    float                                           throughput)
+{
+    globus_libc_fprintf(stderr, "autotune_plugin_tune_cb\n");
+    globus_libc_fprintf(stderr, "parallelism               %d\n", parallelism);
+    globus_libc_fprintf(stderr, "block_size                %lu\n", (unsigned long) block_size);
+    globus_libc_fprintf(stderr, "throughput                %.3f\n", throughput);
+}
+
+globus_result_t
+globus_ftp_client_test_autotune_plugin_init(
+    globus_ftp_client_plugin_t *			plugin)
+{
+    globus_result_t                                     result;
+    globus_reltime_t                                    interval;
+
+    result = globus_ftp_client_autotune_plugin_init(
+        plugin,
+        1,
+        16,
+        autotune_plugin_tune_cb,
+        GLOBUS_NULL);
+    if(result != GLOBUS_SUCCESS)
+    {
+        return result;
+    }
+
+    /* the test files are small, so sample often and tune while running */
+    GlobusTimeReltimeSet(interval, 1, 0);
+    result = globus_ftp_client_autotune_plugin_set_interval(plugin, &interval);
+    if(result != GLOBUS_SUCCESS)
+    {
+        return result;
+    }
+    return globus_ftp_client_autotune_plugin_set_restart(plugin, GLOBUS_TRUE);
+}
+
+globus_result_t
+globus_ftp_client_test_autotune_plugin_destroy(
+    globus_ftp_client_plugin_t *			plugin)
+{
+    return globus_ftp_client_autotune_plugin_destroy(plugin);
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * autotune plugin
+ *
+ * Print the parameters the auto-tuning plugin picks.
+ */
+
+#ifndef GLOBUS_INCLUDE_FTP_CLIENT_TEST_AUTOTUNE_PLUGIN_H
+#define GLOBUS_INCLUDE_FTP_CLIENT_TEST_AUTOTUNE_PLUGIN_H
+
+#include "globus_ftp_client.h"
+#include "globus_ftp_client_plugin.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Module descriptor
+ */
+#define GLOBUS_FTP_CLIENT_TEST_AUTOTUNE_PLUGIN_MODULE (&globus_i_ftp_client_test_autotune_plugin_module)
+
+extern
+globus_module_descriptor_t globus_i_ftp_client_test_autotune_plugin_module;
+
+globus_result_t
+globus_ftp_client_test_autotune_plugin_init(
+    globus_ftp_client_plugin_t *			plugin);
+
+globus_result_t
+globus_ftp_client_test_autotune_plugin_destroy(
+    globus_ftp_client_plugin_t *			plugin);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GLOBUS_INCLUDE_FTP_CLIENT_TEST_AUTOTUNE_PLUGIN_H */
@@ -33,6 +33,7 @@
 #include "globus_ftp_client_restart_plugin.h"
 #include "globus_ftp_client_test_perf_plugin.h"
 #include "globus_ftp_client_test_throughput_plugin.h"
+#include "globus_ftp_client_test_autotune_plugin.h"
 #include "globus_ftp_client_test_pause_plugin.h"
 #include "globus_preload.h"
 
@@ -71,7 +72,7 @@ test_parse_args(int argc,
 #endif
 
     opterr = 0;
-    while((c = getopt(argc, argv, "-f:a:ps:d:r:zMTc:t:i")) != -1)
+    while((c = getopt(argc, argv, "-f:a:ps:d:r:zMTAc:t:i")) != -1)
     {
 	switch(c)
 	{
@@ -124,6 +125,15 @@ test_parse_args(int argc,
 
 	    break;
 
+	case 'A':
+	    plugin = globus_libc_malloc(sizeof(globus_ftp_client_plugin_t));
+	    globus_module_activate(GLOBUS_FTP_CLIENT_TEST_AUTOTUNE_PLUGIN_MODULE);
+	    globus_ftp_client_test_autotune_plugin_init(plugin);
+
+	    globus_ftp_client_handleattr_add_plugin(handle_attr, plugin);
+
+	    break;
+
 	case 'z':
 	    globus_module_activate(GLOBUS_FTP_CLIENT_TEST_PAUSE_PLUGIN_MODULE);
 
@@ -0,0 +1,300 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Pipelined session setup test.  Runs two checksum operations on a
+ * caching handle against a fake server which answers MODE with the given
+ * reply, and checks that a failed pipelined MODE fails the operation and
+ * keeps its connection out of the cache.  Needs no GridFTP server.
+ */
+#include "globus_ftp_client.h"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+static globus_mutex_t                   lock;
+static globus_cond_t                    cond;
+static globus_bool_t                    done;
+static char *                           error_string;
+
+/* reply the fake server gives to MODE */
+static const char *                     server_mode_reply;
+static int                              server_connections;
+
+static
+void
+done_cb(
+    void *                              user_arg,
+    globus_ftp_client_handle_t *        handle,
+    globus_object_t *                   err)
+{
+    globus_mutex_lock(&lock);
+    if(err)
+    {
+        error_string = globus_error_print_chain(err);
+    }
+    done = GLOBUS_TRUE;
+    globus_cond_signal(&cond);
+    globus_mutex_unlock(&lock);
+}
+
+static
+void
+server_reply(
+    int                                 fd,
+    const char *                        reply)
+{
+    ssize_t                             rc;
+
+    rc = write(fd, reply, strlen(reply));
+    (void) rc;
+}
+
+/*
+ * Answer one control connection: every command succeeds but MODE, whose
+ * reply is server_mode_reply
+ */
+static
+void *
+server_session(
+    void *                              arg)
+{
+    int                                 fd = (int) (intptr_t) arg;
+    char                                line[256];
+    size_t                              len = 0;
+    char                                c;
+
+    server_reply(fd, "220 Fake FTP server ready.\r\n");
+    while(read(fd, &c, 1) == 1)
+    {
+        if(c != '\n')
+        {
+            if(len < sizeof(line) - 1)
+            {
+                line[len++] = c;
+            }
+            continue;
+        }
+        line[len] = '\0';
+        len = 0;
+
+        if(strncasecmp(line, "USER", 4) == 0)
+        {
+            server_reply(fd, "331 Password required.\r\n");
+        }
+        else if(strncasecmp(line, "PASS", 4) == 0)
+        {
+            server_reply(fd, "230 User logged in.\r\n");
+        }
+        else if(strncasecmp(line, "MODE", 4) == 0)
+        {
+            server_reply(fd, server_mode_reply);
+        }
+        else if(strncasecmp(line, "CKSM", 4) == 0)
+        {
+            server_reply(fd, "213 d41d8cd98f00b204e9800998ecf8427e\r\n");
+        }
+        else if(strncasecmp(line, "QUIT", 4) == 0)
+        {
+            server_reply(fd, "221 Goodbye.\r\n");
+            break;
+        }
+        else
+        {
+            server_reply(fd, "200 Command okay.\r\n");
+        }
+    }
+    close(fd);
+
+    return NULL;
+}
+
+static
+void *
+server_accept(
+    void *                              arg)
+{
+    int                                 listener = (int) (intptr_t) arg;
+    globus_thread_t                     thread;
+    int                                 fd;
+
+    while((fd = accept(listener, NULL, NULL)) >= 0)
+    {
+        globus_mutex_lock(&lock);
+        server_connections++;
+        globus_mutex_unlock(&lock);
+
+        globus_thread_create(
+            &thread, NULL, server_session, (void *) (intptr_t) fd);
+    }
+
+    return NULL;
+}
+
+/* Run a checksum operation; returns whether it failed */
+static
+globus_bool_t
+run_cksm(
+    globus_ftp_client_handle_t *        handle,
+    globus_ftp_client_operationattr_t * attr,
+    const char *                        url)
+{
+    char                                cksm[64];
+    globus_result_t                     result;
+    globus_bool_t                       failed;
+
+    done = GLOBUS_FALSE;
+    error_string = NULL;
+    result = globus_ftp_client_cksm(
+        handle, url, attr, cksm, 0, -1, "MD5", done_cb, NULL);
+    if(result != GLOBUS_SUCCESS)
+    {
+        done_cb(NULL, handle, globus_error_get(result));
+    }
+
+    globus_mutex_lock(&lock);
+    while(!done)
+    {
+        globus_cond_wait(&cond, &lock);
+    }
+    failed = (error_string != NULL);
+    globus_mutex_unlock(&lock);
+
+    return failed;
+}
+
+/*
+ * Two checksums on one caching handle.  Returns true if the first fails
+ * with mode_error in its error, or succeeds if mode_error is NULL, and
+ * the two of them opened the given number of connections.
+ */
+static
+globus_bool_t
+pipelined_setup_test(
+    const char *                        url,
+    const char *                        mode_reply,
+    const char *                        mode_error,
+    int                                 connections)
+{
+    globus_ftp_client_handle_t          handle;
+    globus_ftp_client_handleattr_t      handle_attr;
+    globus_ftp_client_operationattr_t   attr;
+    globus_bool_t                       failed;
+    globus_bool_t                       ok = GLOBUS_TRUE;
+
+    server_mode_reply = mode_reply;
+    server_connections = 0;
+
+    globus_ftp_client_handleattr_init(&handle_attr);
+    globus_ftp_client_handleattr_set_cache_all(&handle_attr, GLOBUS_TRUE);
+    globus_ftp_client_handleattr_set_pipeline_params(
+        &handle_attr, GLOBUS_TRUE);
+    globus_ftp_client_operationattr_init(&attr);
+    globus_ftp_client_operationattr_set_mode(
+        &attr, GLOBUS_FTP_CONTROL_MODE_EXTENDED_BLOCK);
+    globus_ftp_client_handle_init(&handle, &handle_attr);
+
+    failed = run_cksm(&handle, &attr, url);
+    if(failed != (mode_error != NULL) ||
+       (failed && strstr(error_string, mode_error) == NULL))
+    {
+        fprintf(stderr, "# first checksum: %s\n",
+                failed ? error_string : "succeeded");
+        ok = GLOBUS_FALSE;
+    }
+    globus_libc_free(error_string);
+
+    run_cksm(&handle, &attr, url);
+    globus_libc_free(error_string);
+
+    globus_mutex_lock(&lock);
+    if(server_connections != connections)
+    {
+        fprintf(stderr, "# %d connections, expected %d\n",
+                server_connections, connections);
+        ok = GLOBUS_FALSE;
+    }
+    globus_mutex_unlock(&lock);
+
+    globus_ftp_client_handle_destroy(&handle);
+    globus_ftp_client_operationattr_destroy(&attr);
+    globus_ftp_client_handleattr_destroy(&handle_attr);
+
+    return ok;
+}
+
+int main(int argc,
+         char *argv[])
+{
+    struct sockaddr_in                  addr;
+    socklen_t                           addr_len = sizeof(addr);
+    globus_thread_t                     thread;
+    char                                url[64];
+    int                                 listener;
+    int                                 failed = 0;
+
+    globus_thread_set_model("pthread");
+    globus_module_activate(GLOBUS_FTP_CLIENT_MODULE);
+    globus_mutex_init(&lock, NULL);
+    globus_cond_init(&cond, NULL);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    listener = socket(AF_INET, SOCK_STREAM, 0);
+    if(listener < 0 ||
+       bind(listener, (struct sockaddr *) &addr, sizeof(addr)) != 0 ||
+       listen(listener, 4) != 0 ||
+       getsockname(listener, (struct sockaddr *) &addr, &addr_len) != 0)
+    {
+        printf("Bail out! couldn't start the fake server\n");
+        return 99;
+    }
+    sprintf(url, "ftp://127.0.0.1:%d/file", (int) ntohs(addr.sin_port));
+    globus_thread_create(
+        &thread, NULL, server_accept, (void *) (intptr_t) listener);
+
+    printf("1..2\n");
+
+    /* a cached connection is used again */
+    if(!pipelined_setup_test(url, "200 Mode set.\r\n", NULL, 1))
+    {
+        printf("not ");
+        failed++;
+    }
+    printf("ok 1 - pipelined_mode_ok\n");
+
+    /*
+     * the MODE failure is reported to the user once the CKSM reply comes
+     * in, and the connection isn't cached
+     */
+    if(!pipelined_setup_test(
+            url,
+            "504 MODE E not implemented.\r\n",
+            "MODE E not implemented",
+            2))
+    {
+        printf("not ");
+        failed++;
+    }
+    printf("ok 2 - pipelined_mode_5xx\n");
+
+    globus_module_deactivate_all();
+
+    return failed;
+}
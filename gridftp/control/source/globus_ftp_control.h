@@ -1690,6 +1690,16 @@ globus_ftp_control_data_write(
     globus_ftp_control_data_callback_t        	callback,
     void *					callback_arg);
 
+globus_result_t
+globus_ftp_control_data_write_file(
+    globus_ftp_control_handle_t *		handle,
+    int                                         fd,
+    globus_off_t                                file_offset,
+    globus_size_t				length,
+    globus_off_t				offset,
+    globus_ftp_control_data_callback_t        	callback,
+    void *					callback_arg);
+
 globus_result_t
 globus_ftp_control_data_read(
     globus_ftp_control_handle_t *		handle,
@@ -1698,6 +1708,15 @@ globus_ftp_control_data_read(
     globus_ftp_control_data_callback_t     	callback,
     void *					callback_arg);
 
+globus_result_t
+globus_ftp_control_data_read_file(
+    globus_ftp_control_handle_t *		handle,
+    int                                         fd,
+    globus_off_t                                file_delta,
+    globus_size_t				max_length,
+    globus_ftp_control_data_callback_t     	callback,
+    void *					callback_arg);
+
 globus_result_t
 globus_ftp_control_data_read_all(
     globus_ftp_control_handle_t *               handle,
@@ -64,9 +64,23 @@
     data_conn->close = GLOBUS_FALSE;                                  \
     data_conn->free_me = GLOBUS_FALSE;                                \
     data_conn->reusing = GLOBUS_FALSE;                                \
+    data_conn->xio_handle = GLOBUS_NULL;                              \
+    data_conn->ascii_carry = -1;                                      \
+    data_conn->read_buffer.data = GLOBUS_NULL;                        \
+    data_conn->read_buffer.offset = 0;                                \
+    data_conn->read_buffer.length = 0;                                \
                                                                       \
 }
 
+#define DATA_CONN_FREE(data_conn)                                     \
+{                                                                     \
+    if(data_conn->read_buffer.data != GLOBUS_NULL)                    \
+    {                                                                 \
+        globus_free(data_conn->read_buffer.data);                     \
+    }                                                                 \
+    globus_free(data_conn);                                           \
+}
+
 #define CALLBACK_INFO_MALLOC(ci, dh, th, s, dc)                         \
 {                                                                       \
     ci = (globus_l_ftp_data_callback_info_t *)                          \
@@ -94,6 +108,9 @@
     t_e->error = GLOBUS_NULL;                                           \
     t_e->whos_my_daddy = GLOBUS_NULL;                                   \
     t_e->ascii_buffer = GLOBUS_NULL;                                    \
+    t_e->file_fd = -1;                                                  \
+    t_e->file_offset = 0;                                               \
+    t_e->buffered = 0;                                                  \
     t_e->eof = _eof;                                                    \
 }
 
@@ -104,6 +121,20 @@ struct globus_ftp_data_stripe_s;
 struct globus_l_ftp_handle_table_entry_s;
 struct globus_i_ftp_dc_transfer_handle_s;
 
+/*
+ *  bytes read ahead on an extended block mode connection.  headers are
+ *  read with as much room as the buffer has, so the blocks and payload
+ *  that arrived with them are handled without another read.
+ */
+typedef struct globus_l_ftp_eb_buffer_s
+{
+    globus_byte_t *                             data;
+    globus_size_t                               offset;
+    globus_size_t                               length;
+} globus_l_ftp_eb_buffer_t;
+
+#define GLOBUS_L_FTP_EB_READ_BUFFER_SIZE            (64 * 1024)
+
 typedef struct globus_l_ftp_c_data_layout_s
 {
     globus_ftp_control_layout_func_t            layout_func;
@@ -119,6 +150,12 @@ typedef struct globus_l_ftp_c_data_layout_s
 typedef struct globus_ftp_data_connection_s
 {
     globus_io_handle_t                          io_handle;
+    /*
+     *  the xio handle under io_handle.  blocks are read and written on
+     *  it directly; globus_io is only used to set up and close the
+     *  connection.
+     */
+    globus_xio_handle_t                         xio_handle;
     globus_off_t                                offset;
     struct globus_ftp_data_stripe_s *           whos_my_daddy;
     globus_ftp_control_data_connect_callback_t  callback;
@@ -131,6 +168,12 @@ typedef struct globus_ftp_data_connection_s
 
     /* need free_me for globus_io cancel issue */
     globus_bool_t                               free_me;
+
+    /* byte held back between stream mode ascii reads, or -1 */
+    int                                         ascii_carry;
+
+    /* mode E read ahead, see globus_l_ftp_eb_read_header() */
+    globus_l_ftp_eb_buffer_t                    read_buffer;
 } globus_ftp_data_connection_t;
 
 /*
@@ -232,6 +275,13 @@ typedef struct globus_l_ftp_handle_table_entry_s
     globus_byte_t *                             ascii_buffer;
     globus_size_t                               length;
     globus_off_t                                offset;
+    /* globus_ftp_control_data_write_file() payload, sent by the tcp
+       driver, or globus_ftp_control_data_read_file() target, where
+       file_offset is added to the transfer offset */
+    int                                         file_fd;
+    globus_off_t                                file_offset;
+    /* bytes of the read taken from the connection's read_buffer */
+    globus_size_t                               buffered;
     globus_bool_t                               eof;
     globus_ftp_control_data_callback_t          callback;
     void *                                      callback_arg;
@@ -321,19 +371,23 @@ globus_l_ftp_stream_listen_callback(
 
 void
 globus_l_ftp_stream_write_callback(
-    void *                                      arg,
-    globus_io_handle_t *                        handle,
+    globus_xio_handle_t                         handle,
     globus_result_t                             result,
     globus_byte_t *                             buf,
-    globus_size_t                               nbytes);
+    globus_size_t                               len,
+    globus_size_t                               nbytes,
+    globus_xio_data_descriptor_t                data_desc,
+    void *                                      arg);
 
 void
 globus_l_ftp_stream_read_callback(
-    void *                                      arg,
-    globus_io_handle_t *                        handle,
+    globus_xio_handle_t                         handle,
     globus_result_t                             result,
     globus_byte_t *                             buf,
-    globus_size_t                               nbyte);
+    globus_size_t                               len,
+    globus_size_t                               nbyte,
+    globus_xio_data_descriptor_t                data_desc,
+    void *                                      arg);
 
 void
 globus_l_ftp_stream_accept_connect_callback(
@@ -361,20 +415,23 @@ globus_l_ftp_eb_connect_callback(
 
 void
 globus_l_ftp_eb_write_callback(
-    void *                                      arg,
-    globus_io_handle_t *                        handle,
+    globus_xio_handle_t                         handle,
     globus_result_t                             result,
-    struct iovec *                              iov,
-    globus_size_t                               iovcnt,
-    globus_size_t                               nbytes);
+    globus_xio_iovec_t *                        iov,
+    int                                         iovcnt,
+    globus_size_t                               nbytes,
+    globus_xio_data_descriptor_t                data_desc,
+    void *                                      arg);
 
 void
 globus_l_ftp_eb_read_callback(
-    void *                                      arg,
-    globus_io_handle_t *                        handle,
+    globus_xio_handle_t                         handle,
     globus_result_t                             result,
     globus_byte_t *                             buf,
-    globus_size_t                               nbyte);
+    globus_size_t                               len,
+    globus_size_t                               nbyte,
+    globus_xio_data_descriptor_t                data_desc,
+    void *                                      arg);
 
 globus_result_t
 globus_l_ftp_control_data_stream_read_write(
@@ -398,11 +455,13 @@ globus_l_ftp_control_data_eb_write(
 
 void
 globus_l_ftp_eb_send_eof_callback(
-    void *                                      arg,
-    globus_io_handle_t *                        handle,
+    globus_xio_handle_t                         handle,
     globus_result_t                             result,
     globus_byte_t *                             buf,
-    globus_size_t                               nbytes);
+    globus_size_t                               len,
+    globus_size_t                               nbytes,
+    globus_xio_data_descriptor_t                data_desc,
+    void *                                      arg);
 
 void
 globus_l_ftp_control_stripes_destroy(
@@ -425,6 +484,14 @@ globus_l_ftp_control_strip_ascii(
     globus_byte_t *                             in_buf,
     int                                         length);
 
+int
+globus_l_ftp_control_strip_ascii_stream(
+    globus_byte_t *                             buf,
+    int                                         length,
+    int                                         max_length,
+    int *                                       carry,
+    globus_bool_t                               eof);
+
 void
 globus_l_ftp_io_close_callback(
     void *                                      arg,
@@ -488,11 +555,50 @@ globus_l_ftp_control_data_decode(
 
 void
 globus_l_ftp_eb_read_header_callback(
-    void *                                      arg,
-    globus_io_handle_t *                        handle,
+    globus_xio_handle_t                         handle,
     globus_result_t                             result,
     globus_byte_t *                             buf,
-    globus_size_t                               nbyte);
+    globus_size_t                               len,
+    globus_size_t                               nbyte,
+    globus_xio_data_descriptor_t                data_desc,
+    void *                                      arg);
+
+static
+globus_bool_t
+globus_l_ftp_eb_buffer_header(
+    globus_l_ftp_eb_buffer_t *                  buffer,
+    globus_byte_t *                             descriptor,
+    globus_off_t *                              count,
+    globus_off_t *                              offset);
+
+static
+globus_byte_t *
+globus_l_ftp_eb_buffer_take(
+    globus_l_ftp_eb_buffer_t *                  buffer,
+    globus_size_t *                             length);
+
+static
+globus_byte_t *
+globus_l_ftp_eb_buffer_space(
+    globus_l_ftp_eb_buffer_t *                  buffer,
+    globus_size_t *                             space,
+    globus_size_t *                             wait_for);
+
+static
+globus_result_t
+globus_l_ftp_eb_read_header(
+    globus_ftp_data_connection_t *              data_conn);
+
+static
+globus_result_t
+globus_l_ftp_eb_register_read(
+    globus_ftp_data_connection_t *              data_conn,
+    globus_l_ftp_handle_table_entry_t *         entry);
+
+static
+void
+globus_l_ftp_eb_read_kickout(
+    void *                                      user_args);
 
 globus_result_t
 globus_l_ftp_control_data_eb_connect_write(
@@ -522,25 +628,34 @@ globus_l_ftp_control_data_register_eof(
 
 void
 globus_l_ftp_eb_eof_eod_callback(
-    void *                                      arg,
-    globus_io_handle_t *                        handle,
+    globus_xio_handle_t                         handle,
     globus_result_t                             result,
     globus_byte_t *                             buf,
-    globus_size_t                               nbytes);
+    globus_size_t                               len,
+    globus_size_t                               nbytes,
+    globus_xio_data_descriptor_t                data_desc,
+    void *                                      arg);
 
 void
 globus_l_ftp_close_msg_callback(
-    void *                                      arg,
-    globus_io_handle_t *                        handle,
+    globus_xio_handle_t                         handle,
     globus_result_t                             result,
     globus_byte_t *                             buf,
-    globus_size_t                               nbytes);
+    globus_size_t                               len,
+    globus_size_t                               nbytes,
+    globus_xio_data_descriptor_t                data_desc,
+    void *                                      arg);
 
 globus_result_t
 globus_l_ftp_control_register_close_msg(
     globus_i_ftp_dc_handle_t *                   dc_handle,
     globus_ftp_data_connection_t *               data_conn);
 
+static
+globus_xio_handle_t
+globus_l_ftp_data_conn_xio_handle(
+    globus_ftp_data_connection_t *               data_conn);
+
 globus_result_t
 globus_i_ftp_control_data_write_stripe(
     globus_i_ftp_dc_handle_t *                  dc_handle,
@@ -1537,7 +1652,6 @@ globus_l_ftp_control_data_eb_connect_read(
     globus_ftp_data_stripe_t *                  stripe;
     globus_ftp_data_connection_t *              data_conn;
     globus_object_t *                           err;
-    globus_l_ftp_eb_header_t *                  eb_header;
     globus_result_t                             res;
     globus_bool_t                               reusing = GLOBUS_FALSE;
     globus_i_ftp_dc_transfer_handle_t *         transfer_handle;
@@ -1616,21 +1730,16 @@ globus_l_ftp_control_data_eb_connect_read(
                     &stripe->free_cache_list,
                     stripe->free_cache_list);
 
-                eb_header = (globus_l_ftp_eb_header_t *)
-                              globus_malloc(sizeof(globus_l_ftp_eb_header_t));
                 data_conn->bytes_ready = 0;
                 data_conn->eod = GLOBUS_FALSE;
                 data_conn->reusing = GLOBUS_TRUE;
 
                 stripe->connection_count++;
-                /* register a header read */
-                res = globus_io_register_read(
-                          &data_conn->io_handle,
-                          (globus_byte_t *)eb_header,
-                          sizeof(globus_l_ftp_eb_header_t),
-                          sizeof(globus_l_ftp_eb_header_t),
-                          globus_l_ftp_eb_read_header_callback,
-                          (void *)data_conn);
+                /*
+                 *  the sender may have started this transfer before we
+                 *  got here, so use any headers already read first.
+                 */
+                res = globus_l_ftp_eb_read_header(data_conn);
                 globus_assert(res == GLOBUS_SUCCESS);
 
                 if(callback != GLOBUS_NULL && register_onshot)
@@ -1682,7 +1791,7 @@ globus_l_ftp_control_data_eb_connect_read(
                           (void *)data_conn);
             if(result != GLOBUS_SUCCESS)
             {
-                globus_free(data_conn);
+                DATA_CONN_FREE(data_conn);
                 return result;
             }
         }
@@ -2172,10 +2281,12 @@ globus_l_ftp_control_data_send_eof(
 
     stripe->connection_count--;
     transfer_handle->ref++;
-    res = globus_io_register_write(
-              &data_conn->io_handle,
+    res = globus_xio_register_write(
+              globus_l_ftp_data_conn_xio_handle(data_conn),
               (globus_byte_t *)eb_header,
               sizeof(globus_l_ftp_eb_header_t),
+              sizeof(globus_l_ftp_eb_header_t),
+              GLOBUS_NULL,
               globus_l_ftp_eb_send_eof_callback,
               (void *)eof_ent);
 
@@ -4630,6 +4741,182 @@ globus_ftp_control_data_write(
     return result;
 }
 
+/**
+ * Write a range of a file to the data connection.
+ * @ingroup globus_ftp_control_data
+ *
+ * This works like globus_ftp_control_data_write(), but the payload is
+ * @a length bytes of the file open on @a fd starting at @a file_offset,
+ * which the TCP driver sends with sendfile() instead of copying it
+ * through a user buffer.  It is only available for clear, binary
+ * transfers in stream mode or unstriped extended block mode, on a data
+ * channel stack whose bottom driver is TCP, and it can't be used to
+ * signal eof; use globus_ftp_control_data_write() with a zero length
+ * buffer for that.  If it fails the caller should fall back to
+ * globus_ftp_control_data_write().
+ *
+ * The callback is passed a NULL buffer.  @a fd must stay open until it
+ * has been called.
+ *
+ * @param handle
+ *        A pointer to a FTP control handle.
+ * @param fd
+ *        The file to send from.
+ * @param file_offset
+ *        Where in @a fd the range starts.
+ * @param length
+ *        The length of the range.
+ * @param offset
+ *        The offset in the transfer at which the range starts.
+ * @param callback
+ *        The function to be called once the data has been sent
+ * @param callback_arg
+ *        User supplied argument to the callback function
+ */
+globus_result_t
+globus_ftp_control_data_write_file(
+    globus_ftp_control_handle_t *		handle,
+    int                                         fd,
+    globus_off_t                                file_offset,
+    globus_size_t				length,
+    globus_off_t				offset,
+    globus_ftp_control_data_callback_t	        callback,
+    void *					callback_arg)
+{
+    globus_i_ftp_dc_handle_t *                  dc_handle;
+    globus_result_t                             result = GLOBUS_SUCCESS;
+    globus_object_t *                           err;
+    globus_i_ftp_dc_transfer_handle_t *         transfer_handle;
+    globus_ftp_control_data_write_info_t        data_info;
+    globus_l_ftp_handle_table_entry_t *         entry;
+    globus_ftp_data_stripe_t *                  stripe;
+    static char *                               myname=
+                                      "globus_ftp_control_data_write_file";
+
+    /*
+     *  error checking
+     */
+    if(handle == GLOBUS_NULL)
+    {
+        err = globus_io_error_construct_null_parameter(
+                  GLOBUS_FTP_CONTROL_MODULE,
+                  GLOBUS_NULL,
+                  "handle",
+                  1,
+                  myname);
+        return globus_error_put(err);
+    }
+
+    dc_handle = &handle->dc_handle;
+    GlobusFTPControlDataTestMagic(dc_handle);
+    if(!dc_handle->initialized)
+    {
+        err = globus_io_error_construct_not_initialized(
+                  GLOBUS_FTP_CONTROL_MODULE,
+                  GLOBUS_NULL,
+                  "handle",
+                  1,
+                  myname);
+        return globus_error_put(err);
+    }
+    if(fd < 0 || length == 0)
+    {
+        err = globus_io_error_construct_bad_parameter(
+                  GLOBUS_FTP_CONTROL_MODULE,
+                  GLOBUS_NULL,
+                  fd < 0 ? "fd" : "length",
+                  fd < 0 ? 2 : 4,
+                  myname);
+        return globus_error_put(err);
+    }
+    if(callback == GLOBUS_NULL)
+    {
+        err = globus_io_error_construct_null_parameter(
+                  GLOBUS_FTP_CONTROL_MODULE,
+                  GLOBUS_NULL,
+                  "callback",
+                  6,
+                  myname);
+        return globus_error_put(err);
+    }
+
+    globus_mutex_lock(&dc_handle->mutex);
+    {
+        err = GLOBUS_NULL;
+        transfer_handle = dc_handle->transfer_handle;
+        if(transfer_handle == GLOBUS_NULL ||
+           dc_handle->state != GLOBUS_FTP_DATA_STATE_CONNECT_WRITE)
+        {
+            err = globus_error_construct_string(
+                      GLOBUS_FTP_CONTROL_MODULE,
+                      GLOBUS_NULL,
+         _FCSL("globus_ftp_control_data_write_file(): Handle not in proper state."));
+        }
+        else if(dc_handle->type != GLOBUS_FTP_CONTROL_TYPE_IMAGE ||
+                dc_handle->protection != GLOBUS_FTP_CONTROL_PROTECTION_CLEAR ||
+                (dc_handle->mode != GLOBUS_FTP_CONTROL_MODE_STREAM &&
+                 (dc_handle->mode != GLOBUS_FTP_CONTROL_MODE_EXTENDED_BLOCK ||
+                  transfer_handle->stripe_count != 1)))
+        {
+            err = globus_error_construct_string(
+                      GLOBUS_FTP_CONTROL_MODULE,
+                      GLOBUS_NULL,
+         _FCSL("globus_ftp_control_data_write_file(): Not available for this transfer."));
+        }
+        else if(dc_handle->mode == GLOBUS_FTP_CONTROL_MODE_STREAM)
+        {
+            result = globus_l_ftp_control_data_stream_read_write(
+                         dc_handle,
+                         GLOBUS_NULL,
+                         length,
+                         offset,
+                         GLOBUS_FALSE,
+                         callback,
+                         callback_arg);
+        }
+        else
+        {
+            globus_i_ftp_control_create_data_info(
+                dc_handle,
+                &data_info,
+                GLOBUS_NULL,
+                length,
+                offset,
+                GLOBUS_FALSE,
+                callback,
+                callback_arg);
+            result = globus_i_ftp_control_data_write_stripe(
+                dc_handle,
+                GLOBUS_NULL,
+                length,
+                offset,
+                GLOBUS_FALSE,
+                0,
+                &data_info);
+            globus_i_ftp_control_release_data_info(dc_handle, &data_info);
+        }
+
+        if(err)
+        {
+            globus_mutex_unlock(&dc_handle->mutex);
+            return globus_error_put(err);
+        }
+        if(result == GLOBUS_SUCCESS)
+        {
+            /* both paths leave the new entry at the tail of stripe 0 */
+            stripe = &transfer_handle->stripes[0];
+            entry = (globus_l_ftp_handle_table_entry_t *)
+                globus_fifo_tail_peek(&stripe->command_q);
+            entry->file_fd = fd;
+            entry->file_offset = file_offset;
+        }
+        globus_l_ftp_data_stripe_poll(dc_handle);
+    }
+    globus_mutex_unlock(&dc_handle->mutex);
+
+    return result;
+}
+
 globus_result_t
 globus_ftp_control_get_stripe_count(
     globus_ftp_control_handle_t *		handle,
@@ -4832,26 +5119,53 @@ globus_ftp_control_data_read(
     return result;
 }
 
-/*
- *  register a big buffer read
+/**
+ * Read data from the data connection into a file.
+ * @ingroup globus_ftp_control_data
+ *
+ * This works like globus_ftp_control_data_read(), but instead of being
+ * copied into a user buffer the data is moved by the TCP driver from the
+ * socket into the file open on @a fd, with splice() where available.
+ * Data at transfer offset N is written at file offset N + @a file_delta,
+ * so extended block mode blocks land where they belong whatever order
+ * they arrive in.  It is only available for clear, binary transfers in
+ * stream mode or unstriped extended block mode, on a data channel stack
+ * whose bottom driver is TCP.  If it fails the caller should fall back
+ * to globus_ftp_control_data_read().
+ *
+ * The callback is passed a NULL buffer along with the offset and length
+ * of the data that was written.  @a fd must stay open until it has been
+ * called.
+ *
+ * @param handle
+ *        A pointer to a FTP control handle.
+ * @param fd
+ *        The file to write to.
+ * @param file_delta
+ *        Added to the transfer offset to get the file offset.
+ * @param max_length
+ *        The most data to read into the file with this call.
+ * @param callback
+ *        The function to be called once the data has been read
+ * @param callback_arg
+ *        User supplied argument to the callback function
  */
 globus_result_t
-globus_ftp_control_data_read_all(
+globus_ftp_control_data_read_file(
     globus_ftp_control_handle_t *		handle,
-    globus_byte_t *				buffer,
-    globus_size_t				length,
-    globus_ftp_control_data_callback_t          callback,
+    int                                         fd,
+    globus_off_t                                file_delta,
+    globus_size_t				max_length,
+    globus_ftp_control_data_callback_t	        callback,
     void *					callback_arg)
 {
     globus_i_ftp_dc_handle_t *                  dc_handle;
-    globus_ftp_data_stripe_t *                  stripe;
-    globus_ftp_data_connection_t *              data_conn;
-    globus_result_t                             res;
+    globus_result_t                             result = GLOBUS_SUCCESS;
     globus_object_t *                           err;
     globus_i_ftp_dc_transfer_handle_t *         transfer_handle;
-    int                                         ctr;
+    globus_l_ftp_handle_table_entry_t *         entry;
     static char *                               myname=
-                                      "globus_ftp_control_data_read";
+                                      "globus_ftp_control_data_read_file";
 
     /*
      *  error checking
@@ -4866,6 +5180,7 @@ globus_ftp_control_data_read_all(
                   myname);
         return globus_error_put(err);
     }
+
     dc_handle = &handle->dc_handle;
     GlobusFTPControlDataTestMagic(dc_handle);
     if(!dc_handle->initialized)
@@ -4878,13 +5193,13 @@ globus_ftp_control_data_read_all(
                   myname);
         return globus_error_put(err);
     }
-    if(buffer == GLOBUS_NULL)
+    if(fd < 0 || max_length == 0)
     {
-        err = globus_io_error_construct_null_parameter(
+        err = globus_io_error_construct_bad_parameter(
                   GLOBUS_FTP_CONTROL_MODULE,
                   GLOBUS_NULL,
-                  "buffer",
-                  2,
+                  fd < 0 ? "fd" : "max_length",
+                  fd < 0 ? 2 : 4,
                   myname);
         return globus_error_put(err);
     }
@@ -4894,53 +5209,178 @@ globus_ftp_control_data_read_all(
                   GLOBUS_FTP_CONTROL_MODULE,
                   GLOBUS_NULL,
                   "callback",
-                  4,
+                  5,
                   myname);
         return globus_error_put(err);
     }
 
-    transfer_handle = dc_handle->transfer_handle;
-
     globus_mutex_lock(&dc_handle->mutex);
     {
         err = GLOBUS_NULL;
-        
-        if(dc_handle->transfer_handle == GLOBUS_NULL)
-        {
-            err = dc_handle->connect_error
-                ? globus_object_copy(dc_handle->connect_error)
-                : globus_error_construct_string(
-                          GLOBUS_FTP_CONTROL_MODULE,
-                          GLOBUS_NULL,
-                    _FCSL("Handle not in the proper state"));
-        }
-        else if(dc_handle->state != GLOBUS_FTP_DATA_STATE_CONNECT_READ)
+        transfer_handle = dc_handle->transfer_handle;
+        if(transfer_handle == GLOBUS_NULL ||
+           (dc_handle->state != GLOBUS_FTP_DATA_STATE_CONNECT_READ &&
+            (dc_handle->state != GLOBUS_FTP_DATA_STATE_EOF ||
+             transfer_handle->direction != GLOBUS_FTP_DATA_STATE_CONNECT_READ)))
         {
-            err = dc_handle->connect_error
-                ? globus_object_copy(dc_handle->connect_error)
-                : globus_error_construct_string(
+            err = globus_error_construct_string(
                       GLOBUS_FTP_CONTROL_MODULE,
                       GLOBUS_NULL,
-         _FCSL("globus_ftp_control_data_read_all(): Handle not in proper state %s."),
-          globus_l_ftp_control_state_to_string(dc_handle->state));
+         _FCSL("globus_ftp_control_data_read_file(): Handle not in proper state."));
         }
-        else if(transfer_handle->big_buffer != GLOBUS_NULL)
+        else if(dc_handle->type != GLOBUS_FTP_CONTROL_TYPE_IMAGE ||
+                dc_handle->protection != GLOBUS_FTP_CONTROL_PROTECTION_CLEAR ||
+                transfer_handle->big_buffer != GLOBUS_NULL ||
+                (dc_handle->mode != GLOBUS_FTP_CONTROL_MODE_STREAM &&
+                 (dc_handle->mode != GLOBUS_FTP_CONTROL_MODE_EXTENDED_BLOCK ||
+                  transfer_handle->stripe_count != 1)))
         {
             err = globus_error_construct_string(
                       GLOBUS_FTP_CONTROL_MODULE,
                       GLOBUS_NULL,
-         _FCSL("globus_ftp_control_data_read_all(): Only one read_all can be registered at a time.  You must wait for a callback with eof set to GLOBUS_TRUE before calling read all again."));
+         _FCSL("globus_ftp_control_data_read_file(): Not available for this transfer."));
         }
-        
-        if(err)
+        else
         {
-            globus_mutex_unlock(&dc_handle->mutex);
-            return globus_error_put(err);
-        }
-        
-        transfer_handle->big_buffer = buffer;
-        transfer_handle->big_buffer_length = length;
-        transfer_handle->big_buffer_cb = callback;
+            /* both modes queue reads the same way */
+            result = globus_l_ftp_control_data_stream_read_write(
+                         dc_handle,
+                         GLOBUS_NULL,
+                         max_length,
+                         0,
+                         GLOBUS_FALSE,
+                         callback,
+                         callback_arg);
+        }
+
+        if(err)
+        {
+            globus_mutex_unlock(&dc_handle->mutex);
+            return globus_error_put(err);
+        }
+        if(result == GLOBUS_SUCCESS)
+        {
+            entry = (globus_l_ftp_handle_table_entry_t *)
+                globus_fifo_tail_peek(&transfer_handle->stripes[0].command_q);
+            entry->file_fd = fd;
+            entry->file_offset = file_delta;
+        }
+        globus_l_ftp_data_stripe_poll(dc_handle);
+    }
+    globus_mutex_unlock(&dc_handle->mutex);
+
+    return result;
+}
+
+/*
+ *  register a big buffer read
+ */
+globus_result_t
+globus_ftp_control_data_read_all(
+    globus_ftp_control_handle_t *		handle,
+    globus_byte_t *				buffer,
+    globus_size_t				length,
+    globus_ftp_control_data_callback_t          callback,
+    void *					callback_arg)
+{
+    globus_i_ftp_dc_handle_t *                  dc_handle;
+    globus_ftp_data_stripe_t *                  stripe;
+    globus_ftp_data_connection_t *              data_conn;
+    globus_result_t                             res;
+    globus_object_t *                           err;
+    globus_i_ftp_dc_transfer_handle_t *         transfer_handle;
+    int                                         ctr;
+    static char *                               myname=
+                                      "globus_ftp_control_data_read";
+
+    /*
+     *  error checking
+     */
+    if(handle == GLOBUS_NULL)
+    {
+        err = globus_io_error_construct_null_parameter(
+                  GLOBUS_FTP_CONTROL_MODULE,
+                  GLOBUS_NULL,
+                  "handle",
+                  1,
+                  myname);
+        return globus_error_put(err);
+    }
+    dc_handle = &handle->dc_handle;
+    GlobusFTPControlDataTestMagic(dc_handle);
+    if(!dc_handle->initialized)
+    {
+        err = globus_io_error_construct_not_initialized(
+                  GLOBUS_FTP_CONTROL_MODULE,
+                  GLOBUS_NULL,
+                  "handle",
+                  1,
+                  myname);
+        return globus_error_put(err);
+    }
+    if(buffer == GLOBUS_NULL)
+    {
+        err = globus_io_error_construct_null_parameter(
+                  GLOBUS_FTP_CONTROL_MODULE,
+                  GLOBUS_NULL,
+                  "buffer",
+                  2,
+                  myname);
+        return globus_error_put(err);
+    }
+    if(callback == GLOBUS_NULL)
+    {
+        err = globus_io_error_construct_null_parameter(
+                  GLOBUS_FTP_CONTROL_MODULE,
+                  GLOBUS_NULL,
+                  "callback",
+                  4,
+                  myname);
+        return globus_error_put(err);
+    }
+
+    transfer_handle = dc_handle->transfer_handle;
+
+    globus_mutex_lock(&dc_handle->mutex);
+    {
+        err = GLOBUS_NULL;
+        
+        if(dc_handle->transfer_handle == GLOBUS_NULL)
+        {
+            err = dc_handle->connect_error
+                ? globus_object_copy(dc_handle->connect_error)
+                : globus_error_construct_string(
+                          GLOBUS_FTP_CONTROL_MODULE,
+                          GLOBUS_NULL,
+                    _FCSL("Handle not in the proper state"));
+        }
+        else if(dc_handle->state != GLOBUS_FTP_DATA_STATE_CONNECT_READ)
+        {
+            err = dc_handle->connect_error
+                ? globus_object_copy(dc_handle->connect_error)
+                : globus_error_construct_string(
+                      GLOBUS_FTP_CONTROL_MODULE,
+                      GLOBUS_NULL,
+         _FCSL("globus_ftp_control_data_read_all(): Handle not in proper state %s."),
+          globus_l_ftp_control_state_to_string(dc_handle->state));
+        }
+        else if(transfer_handle->big_buffer != GLOBUS_NULL)
+        {
+            err = globus_error_construct_string(
+                      GLOBUS_FTP_CONTROL_MODULE,
+                      GLOBUS_NULL,
+         _FCSL("globus_ftp_control_data_read_all(): Only one read_all can be registered at a time.  You must wait for a callback with eof set to GLOBUS_TRUE before calling read all again."));
+        }
+        
+        if(err)
+        {
+            globus_mutex_unlock(&dc_handle->mutex);
+            return globus_error_put(err);
+        }
+        
+        transfer_handle->big_buffer = buffer;
+        transfer_handle->big_buffer_length = length;
+        transfer_handle->big_buffer_cb = callback;
         transfer_handle->big_buffer_cb_arg = callback_arg;
 
         if(dc_handle->mode == GLOBUS_FTP_CONTROL_MODE_STREAM)
@@ -5009,13 +5449,7 @@ globus_ftp_control_data_read_all(
                          *  register a read into the users buffer at the
                          *  correct offset.
                          */
-                        res = globus_io_register_read(
-                                  &data_conn->io_handle,
-                                  &transfer_handle->big_buffer[data_conn->offset],
-                                  data_conn->bytes_ready,
-                                  data_conn->bytes_ready,
-                                  globus_l_ftp_eb_read_callback,
-                                  (void *)t_e);
+                        res = globus_l_ftp_eb_register_read(data_conn, t_e);
                         globus_assert(res == GLOBUS_SUCCESS);
                     }
                 }
@@ -5051,7 +5485,7 @@ globus_i_ftp_control_data_activate(void)
     /* keep this last */
     globus_l_ftp_control_data_active = GLOBUS_TRUE;
 
-    globus_hashtable_init(
+    globus_hashtable_init_resizable(
         &globus_l_ftp_control_data_layout_table,
         GFTPC_HASH_TABLE_SIZE,
         globus_hashtable_string_hash,
@@ -6365,6 +6799,58 @@ globus_l_ftp_data_stripe_poll(
     return result;
 }
 
+/*
+ *  data descriptor for an entry from globus_ftp_control_data_write_file()
+ *  or globus_ftp_control_data_read_file().
+ *  on writes the tcp driver sends the file range after whatever buffer
+ *  is registered with it, so the entry's length must not be counted in
+ *  the write itself.  on reads the data goes into the file at the
+ *  connection's offset plus the entry's file_offset, and the buffer
+ *  registered is never touched.  this should be called locked
+ */
+static
+globus_result_t
+globus_l_ftp_data_file_dd_init(
+    globus_ftp_data_connection_t *                data_conn,
+    globus_l_ftp_handle_table_entry_t *           entry,
+    globus_xio_data_descriptor_t *                dd)
+{
+    globus_result_t                               result;
+
+    result = globus_xio_data_descriptor_init(
+        dd, globus_l_ftp_data_conn_xio_handle(data_conn));
+    if(result != GLOBUS_SUCCESS)
+    {
+        return result;
+    }
+    if(entry->direction == GLOBUS_FTP_DATA_STATE_CONNECT_READ)
+    {
+        result = globus_xio_data_descriptor_cntl(
+            *dd,
+            globus_io_compat_get_tcp_driver(),
+            GLOBUS_XIO_TCP_SET_SPLICE,
+            entry->file_fd,
+            data_conn->offset + entry->file_offset,
+            (globus_off_t) entry->length);
+    }
+    else
+    {
+        result = globus_xio_data_descriptor_cntl(
+            *dd,
+            globus_io_compat_get_tcp_driver(),
+            GLOBUS_XIO_TCP_SET_SENDFILE,
+            entry->file_fd,
+            entry->file_offset,
+            (globus_off_t) entry->length);
+    }
+    if(result != GLOBUS_SUCCESS)
+    {
+        globus_xio_data_descriptor_destroy(*dd);
+    }
+
+    return result;
+}
+
 /*
  *  poll a specific stripe
  *  ----------------------
@@ -6420,12 +6906,37 @@ globus_l_ftp_data_stream_stripe_poll(
 
                 globus_fifo_dequeue(&stripe->free_conn_q);
 
-                result = globus_io_register_write(
-                             &data_conn->io_handle,
-                             tmp_buf,
-                             tmp_len,
-                             globus_l_ftp_stream_write_callback,
-                             (void *)entry);
+                if(entry->file_fd >= 0)
+                {
+                    globus_xio_data_descriptor_t  dd;
+
+                    result = globus_l_ftp_data_file_dd_init(
+                        data_conn, entry, &dd);
+                    globus_assert(result == GLOBUS_SUCCESS);
+
+                    /* nothing goes ahead of the file, but xio wants a
+                       buffer even for an empty write */
+                    result = globus_xio_register_write(
+                                 globus_l_ftp_data_conn_xio_handle(data_conn),
+                                 (globus_byte_t *) entry,
+                                 0,
+                                 0,
+                                 dd,
+                                 globus_l_ftp_stream_write_callback,
+                                 (void *)entry);
+                    globus_xio_data_descriptor_destroy(dd);
+                }
+                else
+                {
+                    result = globus_xio_register_write(
+                                 globus_l_ftp_data_conn_xio_handle(data_conn),
+                                 tmp_buf,
+                                 tmp_len,
+                                 tmp_len,
+                                 GLOBUS_NULL,
+                                 globus_l_ftp_stream_write_callback,
+                                 (void *)entry);
+                }
                 globus_assert(result == GLOBUS_SUCCESS);
             }
             else if(entry->direction == GLOBUS_FTP_DATA_STATE_CONNECT_READ)
@@ -6434,13 +6945,37 @@ globus_l_ftp_data_stream_stripe_poll(
                 globus_fifo_dequeue(&stripe->command_q);
                 globus_fifo_dequeue(&stripe->free_conn_q);
 
-                result = globus_io_register_read(
-                             &data_conn->io_handle,
-                             entry->buffer,
-                             entry->length,
-                             entry->length,
-                             globus_l_ftp_stream_read_callback,
-                             (void *)entry);
+                if(entry->file_fd >= 0)
+                {
+                    globus_xio_data_descriptor_t  dd;
+
+                    result = globus_l_ftp_data_file_dd_init(
+                        data_conn, entry, &dd);
+                    globus_assert(result == GLOBUS_SUCCESS);
+
+                    /* the data goes straight to the file, but xio wants
+                       a buffer to go with the read */
+                    result = globus_xio_register_read(
+                                 globus_l_ftp_data_conn_xio_handle(data_conn),
+                                 (globus_byte_t *) entry,
+                                 1,
+                                 entry->length,
+                                 dd,
+                                 globus_l_ftp_stream_read_callback,
+                                 (void *)entry);
+                    globus_xio_data_descriptor_destroy(dd);
+                }
+                else
+                {
+                    result = globus_xio_register_read(
+                                 globus_l_ftp_data_conn_xio_handle(data_conn),
+                                 entry->buffer,
+                                 entry->length,
+                                 entry->length,
+                                 GLOBUS_NULL,
+                                 globus_l_ftp_stream_read_callback,
+                                 (void *)entry);
+                }
                 globus_assert(result == GLOBUS_SUCCESS);
             }
         }
@@ -6586,7 +7121,10 @@ globus_l_ftp_data_eb_poll(
                                         entry->buffer,
                                         entry->length,
                                         &tmp_len);
-                                tmp_buf = entry->ascii_buffer;
+                                if(entry->ascii_buffer)
+                                {
+                                    tmp_buf = entry->ascii_buffer;
+                                }
                             }
 
                             globus_l_ftp_control_data_encode(
@@ -6606,12 +7144,14 @@ globus_l_ftp_data_eb_poll(
                             io_vec[1].iov_base = tmp_buf;
                             io_vec[1].iov_len = tmp_len;
 
-                            res = globus_io_register_writev(
-                                         &data_conn->io_handle,
+                            res = globus_xio_register_writev(
+                                         globus_l_ftp_data_conn_xio_handle(data_conn),
                                          io_vec,
                                          2,
+                                         io_vec[0].iov_len + io_vec[1].iov_len,
+                                         GLOBUS_NULL,
                                          globus_l_ftp_eb_write_callback,
-                                        (void *)entry);
+                                         (void *)entry);
                             globus_assert(res == GLOBUS_SUCCESS);
                         }
 
@@ -6652,7 +7192,10 @@ globus_l_ftp_data_eb_poll(
                                     entry->buffer,
                                     entry->length,
                                     &tmp_len);
-                            tmp_buf = entry->ascii_buffer;
+                            if(entry->ascii_buffer)
+                            {
+                                tmp_buf = entry->ascii_buffer;
+                            }
                         }
 
                         globus_l_ftp_control_data_encode(
@@ -6671,12 +7214,37 @@ globus_l_ftp_data_eb_poll(
                         io_vec[1].iov_base = tmp_buf;
                         io_vec[1].iov_len = tmp_len;
 
-                        res = globus_io_register_writev(
-                                  &data_conn->io_handle,
+                        if(entry->file_fd >= 0)
+                        {
+                            globus_xio_data_descriptor_t  dd;
+
+                            /* the tcp driver sends the block after the
+                               header */
+                            res = globus_l_ftp_data_file_dd_init(
+                                data_conn, entry, &dd);
+                            globus_assert(res == GLOBUS_SUCCESS);
+
+                            res = globus_xio_register_writev(
+                                  globus_l_ftp_data_conn_xio_handle(data_conn),
+                                  io_vec,
+                                  1,
+                                  io_vec[0].iov_len,
+                                  dd,
+                                  globus_l_ftp_eb_write_callback,
+                                  (void *)entry);
+                            globus_xio_data_descriptor_destroy(dd);
+                        }
+                        else
+                        {
+                            res = globus_xio_register_writev(
+                                  globus_l_ftp_data_conn_xio_handle(data_conn),
                                   io_vec,
                                   2,
+                                  io_vec[0].iov_len + io_vec[1].iov_len,
+                                  GLOBUS_NULL,
                                   globus_l_ftp_eb_write_callback,
                                   (void *)entry);
+                        }
                         globus_assert(res == GLOBUS_SUCCESS);
                     }
                 }
@@ -6851,13 +7419,7 @@ globus_l_ftp_data_eb_poll(
                         /*
                          *  register a read
                          */
-                        res = globus_io_register_read(
-                                  &data_conn->io_handle,
-                                  entry->buffer,
-                                  entry->length,
-                                  entry->length,
-                                  globus_l_ftp_eb_read_callback,
-                                  (void *)entry);
+                        res = globus_l_ftp_eb_register_read(data_conn, entry);
                         globus_assert(res == GLOBUS_SUCCESS);
                         
                         transfer_handle->order_next_offset += entry->length;
@@ -6956,10 +7518,12 @@ globus_l_ftp_control_data_register_eof(
 
     stripe->connection_count--;
     stripe->whos_my_daddy->ref++;
-    res = globus_io_register_write(
-              &data_conn->io_handle,
+    res = globus_xio_register_write(
+              globus_l_ftp_data_conn_xio_handle(data_conn),
               (globus_byte_t *)eb_header,
               sizeof(globus_l_ftp_eb_header_t),
+              sizeof(globus_l_ftp_eb_header_t),
+              GLOBUS_NULL,
               globus_l_ftp_eb_eof_eod_callback,
               (void *)cb_info);
 
@@ -6996,10 +7560,12 @@ globus_l_ftp_control_data_register_eod(
         stripe->whos_my_daddy,
         stripe,
         data_conn);
-    res = globus_io_register_write(
-              &data_conn->io_handle,
+    res = globus_xio_register_write(
+              globus_l_ftp_data_conn_xio_handle(data_conn),
               (globus_byte_t *)eb_header,
               sizeof(globus_l_ftp_eb_header_t),
+              sizeof(globus_l_ftp_eb_header_t),
+              GLOBUS_NULL,
               globus_l_ftp_eb_eof_eod_callback,
               (void *)cb_info);
     globus_assert(res == GLOBUS_SUCCESS);
@@ -7243,10 +7809,12 @@ globus_l_ftp_control_register_close_msg(
         data_conn->whos_my_daddy,
         data_conn);
 
-    res = globus_io_register_write(
-              &data_conn->io_handle,
+    res = globus_xio_register_write(
+              globus_l_ftp_data_conn_xio_handle(data_conn),
               (globus_byte_t *)eb_header,
               sizeof(globus_l_ftp_eb_header_t),
+              sizeof(globus_l_ftp_eb_header_t),
+              GLOBUS_NULL,
               globus_l_ftp_close_msg_callback,
               (void *)cb_info);
 
@@ -8083,31 +8651,131 @@ globus_i_ftp_control_data_force_close(
     return result;
 }
 
+/*
+ *  ascii conversion
+ *
+ *  both directions look for the next CR or LF with memchr, which libc
+ *  vectorizes, and move whole runs of text at once rather than a byte
+ *  per loop.
+ */
+
+/*
+ *  turn every CRLF in buf into LF, in place.  returns the new length.
+ */
 int
 globus_l_ftp_control_strip_ascii(
     globus_byte_t *                                 buf,
     int                                             length)
 {
-    int                                             ctr;
-    int                                             count = 0;
+    globus_byte_t *                                 end;
+    globus_byte_t *                                 scan;
+    globus_byte_t *                                 cr;
+    globus_byte_t *                                 in_ptr;
+    globus_byte_t *                                 out_ptr;
 
-    if(length < 1)
+    if(length < 2)
     {
         return length;
     }
 
-    for(ctr = 0; ctr < length - 1; ctr++)
+    end = buf + length;
+    scan = buf;
+    in_ptr = buf;
+    out_ptr = buf;
+    /* a CR in the last byte can't start a CRLF, so stop short of it */
+    while(scan < end - 1 &&
+        (cr = memchr(scan, '\r', end - 1 - scan)) != GLOBUS_NULL)
+    {
+        scan = cr + 1;
+        if(*scan != '\n')
+        {
+            continue;
+        }
+        /* nothing moves until the first CRLF */
+        if(out_ptr != in_ptr)
+        {
+            memmove(out_ptr, in_ptr, cr - in_ptr);
+        }
+        out_ptr += cr - in_ptr;
+        /* drop the CR; the LF starts the next run */
+        in_ptr = scan;
+    }
+    if(out_ptr != in_ptr)
+    {
+        memmove(out_ptr, in_ptr, end - in_ptr);
+    }
+    out_ptr += end - in_ptr;
+
+    return out_ptr - buf;
+}
+
+/*
+ *  strip_ascii for a stream that arrives in pieces, where a CRLF may be
+ *  split between two of them.  a CR ending one piece is held back in
+ *  *carry (-1 when nothing is held) until the next piece shows whether
+ *  an LF follows it.  buf has room for max_length bytes; if a held CR
+ *  turns out to be plain data and the piece is full, the piece's last
+ *  byte is held instead.  on eof everything held is put back if the
+ *  piece has room for it.  if it does not, *carry is still set when this
+ *  returns and the caller has to read again, getting eof again with an
+ *  empty piece, to flush it.
+ */
+int
+globus_l_ftp_control_strip_ascii_stream(
+    globus_byte_t *                                 buf,
+    int                                             length,
+    int                                             max_length,
+    int *                                           carry,
+    globus_bool_t                                   eof)
+{
+    int                                             held;
+    int                                             new_carry = -1;
+
+    held = *carry;
+    if(held == '\r' && length > 0 && buf[0] == '\n')
+    {
+        /* the LF in buf finishes the CRLF; the CR is just dropped */
+        held = -1;
+    }
+
+    length = globus_l_ftp_control_strip_ascii(buf, length);
+
+    if(!eof && length > 0 && buf[length - 1] == '\r')
+    {
+        new_carry = '\r';
+        length--;
+    }
+
+    if(held >= 0)
     {
-        if(buf[ctr] == '\r' &&
-           buf[ctr + 1] == '\n')
+        if(length < max_length)
+        {
+            memmove(buf + 1, buf, length);
+            buf[0] = (globus_byte_t) held;
+            length++;
+        }
+        else if(length > 0)
         {
-            memmove(&buf[ctr], &buf[ctr+1], length - (ctr + 1));
-            count++;
+            /* full, so new_carry is unset; holding a CR makes room */
+            new_carry = buf[length - 1];
+            memmove(buf + 1, buf, length - 1);
+            buf[0] = (globus_byte_t) held;
+        }
+        else
+        {
+            new_carry = held;
         }
     }
+    *carry = new_carry;
 
-    return length - count;
+    return length;
 }
+
+/*
+ *  turn every LF in in_buf into CRLF.  returns a new buffer for the
+ *  caller to free, or NULL when in_buf has no LF and can be sent as it
+ *  is.  either way *ascii_len is the number of bytes to send.
+ */
 globus_byte_t *
 globus_l_ftp_control_add_ascii(
     globus_byte_t *                                 in_buf,
@@ -8115,8 +8783,11 @@ globus_l_ftp_control_add_ascii(
     globus_off_t *                                  ascii_len)
 {
     globus_byte_t *                                 out_buf;
-    int                                             ctr;
-    int                                             out_ndx = 0;
+    globus_byte_t *                                 out_ptr;
+    globus_byte_t *                                 in_ptr;
+    globus_byte_t *                                 end;
+    globus_byte_t *                                 nl;
+    int                                             nl_count = 0;
 
     if(length < 1)
     {
@@ -8124,21 +8795,33 @@ globus_l_ftp_control_add_ascii(
         return GLOBUS_NULL;
     }
 
-    /* allocating twice the memory may be a bad idea */
-    out_buf = (globus_byte_t *)globus_malloc(length*2);
+    end = in_buf + length;
+    for(in_ptr = in_buf;
+        (nl = memchr(in_ptr, '\n', end - in_ptr)) != GLOBUS_NULL;
+        in_ptr = nl + 1)
+    {
+        nl_count++;
+    }
 
-    for(ctr = 0; ctr < length; ctr++)
+    *ascii_len = length + nl_count;
+    if(nl_count == 0)
     {
-        if(in_buf[ctr] == '\n')
-        {
-            out_buf[out_ndx] = '\r';
-            out_ndx++;
-        }
-        out_buf[out_ndx] = in_buf[ctr];
-        out_ndx++;
+        return GLOBUS_NULL;
     }
 
-    *ascii_len = out_ndx;
+    out_buf = (globus_byte_t *) globus_malloc(length + nl_count);
+
+    out_ptr = out_buf;
+    for(in_ptr = in_buf;
+        (nl = memchr(in_ptr, '\n', end - in_ptr)) != GLOBUS_NULL;
+        in_ptr = nl + 1)
+    {
+        memcpy(out_ptr, in_ptr, nl - in_ptr);
+        out_ptr += nl - in_ptr;
+        *out_ptr++ = '\r';
+        *out_ptr++ = '\n';
+    }
+    memcpy(out_ptr, in_ptr, end - in_ptr);
 
     return out_buf;
 }
@@ -8300,7 +8983,7 @@ globus_l_ftp_io_close_callback(
          */
         if(data_conn->free_me)
         {
-            globus_free(data_conn);
+            DATA_CONN_FREE(data_conn);
         }
         else
         {
@@ -8407,7 +9090,7 @@ globus_l_ftp_stream_write_eof_callback(
     }
     globus_mutex_unlock(&dc_handle->mutex);
 
-    globus_free(data_conn);
+    DATA_CONN_FREE(data_conn);
 
     if(error)
     {
@@ -8585,7 +9268,7 @@ globus_l_ftp_stream_listen_callback(
 
     if(error)
     {
-        globus_free(data_conn);
+        DATA_CONN_FREE(data_conn);
         globus_object_free(error);
     }
 }
@@ -8692,7 +9375,7 @@ globus_l_ftp_stream_accept_connect_callback(
              */
             if(data_conn->free_me)
             {
-                globus_free(data_conn);
+                DATA_CONN_FREE(data_conn);
             }
             else
             {
@@ -8771,11 +9454,13 @@ globus_l_ftp_stream_accept_connect_callback(
  */
 void
 globus_l_ftp_stream_write_callback(
-    void *                                      arg,
-    globus_io_handle_t *                        handle,
+    globus_xio_handle_t                         handle,
     globus_result_t                             result,
     globus_byte_t *                             buf,
-    globus_size_t                               nbytes)
+    globus_size_t                               len,
+    globus_size_t                               nbytes,
+    globus_xio_data_descriptor_t                data_desc,
+    void *                                      arg)
 {
     globus_l_ftp_handle_table_entry_t *         entry;
     globus_object_t *                           error = GLOBUS_NULL;
@@ -8785,7 +9470,6 @@ globus_l_ftp_stream_write_callback(
     globus_ftp_data_connection_t *              data_conn;
     globus_ftp_data_stripe_t *                  stripe;
     globus_bool_t                               eof = GLOBUS_FALSE;
-    const globus_object_type_t *                type;
     globus_bool_t                               fire_callback = GLOBUS_TRUE;
     globus_i_ftp_dc_transfer_handle_t *         transfer_handle;
     globus_size_t                               nl_nbytes;
@@ -8817,14 +9501,14 @@ globus_l_ftp_stream_write_callback(
         if(result != GLOBUS_SUCCESS)
         {
             error = globus_error_get(result);
-            type = globus_object_get_type(error);
             /*
              *  if not do to canceling the accept, then close
              *  the connection.
              */
-            if(!globus_object_type_match(
-                   type,
-                   GLOBUS_IO_ERROR_TYPE_IO_CANCELLED))
+            if(!globus_error_match(
+                   error,
+                   GLOBUS_XIO_MODULE,
+                   GLOBUS_XIO_ERROR_CANCELED))
             {
                 globus_l_ftp_control_stripes_destroy(dc_handle, error);
             }
@@ -8919,11 +9603,13 @@ globus_l_ftp_stream_write_callback(
  */
 void
 globus_l_ftp_stream_read_callback(
-    void *                                      arg,
-    globus_io_handle_t *                        handle,
+    globus_xio_handle_t                         handle,
     globus_result_t                             result,
     globus_byte_t *                             buf,
-    globus_size_t                               nbyte)
+    globus_size_t                               len,
+    globus_size_t                               nbyte,
+    globus_xio_data_descriptor_t                data_desc,
+    void *                                      arg)
 {
     globus_l_ftp_handle_table_entry_t *         entry;
     globus_object_t *                           error = GLOBUS_NULL;
@@ -8934,7 +9620,6 @@ globus_l_ftp_stream_read_callback(
     globus_ftp_control_handle_t    *            control_handle;
     globus_ftp_data_stripe_t *                  stripe;
     globus_byte_t *                             buffer = GLOBUS_NULL;
-    const globus_object_type_t *                type;
     globus_result_t                             res;
     globus_i_ftp_dc_transfer_handle_t *         transfer_handle;
     globus_bool_t                               fire_callback = GLOBUS_TRUE;
@@ -8947,11 +9632,6 @@ globus_l_ftp_stream_read_callback(
     dc_handle = entry->dc_handle;
     GlobusFTPControlDataTestMagic(dc_handle);
 
-    if(entry->type == GLOBUS_FTP_CONTROL_TYPE_ASCII)
-    {
-        nbyte = globus_l_ftp_control_strip_ascii(buf, nbyte);
-    }
-
     globus_mutex_lock(&dc_handle->mutex);
     {
         globus_assert(dc_handle->mode == GLOBUS_FTP_CONTROL_MODE_STREAM);
@@ -8961,7 +9641,30 @@ globus_l_ftp_stream_read_callback(
         transfer_handle = stripe->whos_my_daddy;
         control_handle = dc_handle->whos_my_daddy;
 
-        buffer = entry->buffer;
+        /* any error ends the stream, so flush what is held back then */
+        if(entry->type == GLOBUS_FTP_CONTROL_TYPE_ASCII)
+        {
+            nbyte = globus_l_ftp_control_strip_ascii_stream(
+                        buf,
+                        nbyte,
+                        len,
+                        &data_conn->ascii_carry,
+                        result != GLOBUS_SUCCESS);
+
+            /*
+             *  a full buffer at eof has no room for the held byte, so
+             *  hand it back as plain data.  the next read gets eof
+             *  again and the held byte with it.
+             */
+            if(data_conn->ascii_carry >= 0 &&
+               globus_xio_error_is_eof(result))
+            {
+                globus_object_free(globus_error_get(result));
+                result = GLOBUS_SUCCESS;
+            }
+        }
+
+        buffer = entry->buffer;
 
         /*
          *  result will not be SUCCESS when the callback is canceled
@@ -8973,10 +9676,10 @@ globus_l_ftp_stream_read_callback(
         else if(result != GLOBUS_SUCCESS)
         {
             error = globus_error_get(result);
-            type = globus_object_get_type(error);
 
             /* if it is EOF do not pass the user back an error */
-            if(globus_io_eof(error))
+            if(globus_error_match(
+                   error, GLOBUS_XIO_MODULE, GLOBUS_XIO_ERROR_EOF))
             {
                 globus_object_free(error);
                 result = GLOBUS_SUCCESS;
@@ -9010,9 +9713,10 @@ globus_l_ftp_stream_read_callback(
                 entry->length = nbyte;
                 entry->offset = data_conn->offset;
             }
-            else if(!globus_object_type_match(
-                     type,
-                     GLOBUS_IO_ERROR_TYPE_IO_CANCELLED))
+            else if(!globus_error_match(
+                     error,
+                     GLOBUS_XIO_MODULE,
+                     GLOBUS_XIO_ERROR_CANCELED))
             {
                 globus_l_ftp_control_stripes_destroy(dc_handle, error);
             }
@@ -9292,7 +9996,7 @@ globus_l_ftp_eb_listen_callback(
 
     if(error !=GLOBUS_NULL)
     {
-        globus_free(data_conn);
+        DATA_CONN_FREE(data_conn);
         globus_object_free(error);
     }
 }
@@ -9316,7 +10020,6 @@ globus_l_ftp_eb_accept_callback(
     void *                                      user_arg;
     unsigned int                                stripe_ndx;
     globus_result_t                             res;
-    globus_l_ftp_eb_header_t *                  eb_header;
     const globus_object_type_t *                type;
     globus_i_ftp_dc_transfer_handle_t *         transfer_handle;
     globus_bool_t                               poll;
@@ -9383,7 +10086,7 @@ globus_l_ftp_eb_accept_callback(
              */
             if(data_conn->free_me)
             {
-                globus_free(data_conn);
+                DATA_CONN_FREE(data_conn);
             }
             else
             {
@@ -9406,19 +10109,10 @@ globus_l_ftp_eb_accept_callback(
                 dc_handle->state == GLOBUS_FTP_DATA_STATE_CONNECT_READ ||
                 dc_handle->state == GLOBUS_FTP_DATA_STATE_EOF);
 
-            eb_header = (globus_l_ftp_eb_header_t *)
-                          globus_malloc(sizeof(globus_l_ftp_eb_header_t));
-
             /* count active connections and total connections */
             data_conn->bytes_ready = 0;
 
-            res = globus_io_register_read(
-                      &data_conn->io_handle,
-                      (globus_byte_t *)eb_header,
-                      sizeof(globus_l_ftp_eb_header_t),
-                      sizeof(globus_l_ftp_eb_header_t),
-                      globus_l_ftp_eb_read_header_callback,
-                      (void *)data_conn);
+            res = globus_l_ftp_eb_read_header(data_conn);
             if(res != GLOBUS_SUCCESS)
             {
                 error = globus_error_get(res);
@@ -9465,38 +10159,388 @@ globus_l_ftp_eb_accept_callback(
     }
 }
 
+/*
+ *  take the next extended block header out of a connection's read
+ *  buffer.  returns GLOBUS_FALSE if a whole header hasn't been read yet.
+ */
+static
+globus_bool_t
+globus_l_ftp_eb_buffer_header(
+    globus_l_ftp_eb_buffer_t *                  buffer,
+    globus_byte_t *                             descriptor,
+    globus_off_t *                              count,
+    globus_off_t *                              offset)
+{
+    globus_l_ftp_eb_header_t *                  eb_header;
+
+    if(buffer->length < sizeof(globus_l_ftp_eb_header_t))
+    {
+        return GLOBUS_FALSE;
+    }
+    eb_header = (globus_l_ftp_eb_header_t *)
+                    &buffer->data[buffer->offset];
+    *descriptor = eb_header->descriptor;
+    globus_l_ftp_control_data_decode(eb_header->count, count);
+    globus_l_ftp_control_data_decode(eb_header->offset, offset);
+
+    buffer->offset += sizeof(globus_l_ftp_eb_header_t);
+    buffer->length -= sizeof(globus_l_ftp_eb_header_t);
+
+    return GLOBUS_TRUE;
+}
+
+/*
+ *  take up to *length bytes of payload out of a connection's read
+ *  buffer.  *length is set to the number taken, and the bytes are only
+ *  good until the next globus_l_ftp_eb_buffer_space().
+ */
+static
+globus_byte_t *
+globus_l_ftp_eb_buffer_take(
+    globus_l_ftp_eb_buffer_t *                  buffer,
+    globus_size_t *                             length)
+{
+    globus_byte_t *                             data;
+
+    if(*length > buffer->length)
+    {
+        *length = buffer->length;
+    }
+    if(*length == 0)
+    {
+        return GLOBUS_NULL;
+    }
+    data = &buffer->data[buffer->offset];
+    buffer->offset += *length;
+    buffer->length -= *length;
+
+    return data;
+}
+
+/*
+ *  get the room left in a connection's read buffer, allocating it the
+ *  first time.  what is left of the last read is moved to the front, and
+ *  *wait_for is what is still needed to make a whole header.
+ */
+static
+globus_byte_t *
+globus_l_ftp_eb_buffer_space(
+    globus_l_ftp_eb_buffer_t *                  buffer,
+    globus_size_t *                             space,
+    globus_size_t *                             wait_for)
+{
+    if(buffer->data == GLOBUS_NULL)
+    {
+        buffer->data = (globus_byte_t *)
+            globus_malloc(GLOBUS_L_FTP_EB_READ_BUFFER_SIZE);
+        if(buffer->data == GLOBUS_NULL)
+        {
+            return GLOBUS_NULL;
+        }
+        buffer->offset = 0;
+        buffer->length = 0;
+    }
+    globus_assert(buffer->length < sizeof(globus_l_ftp_eb_header_t));
+
+    if(buffer->offset > 0)
+    {
+        memmove(buffer->data, &buffer->data[buffer->offset], buffer->length);
+        buffer->offset = 0;
+    }
+    *space = GLOBUS_L_FTP_EB_READ_BUFFER_SIZE - buffer->length;
+    *wait_for = sizeof(globus_l_ftp_eb_header_t) - buffer->length;
+
+    return &buffer->data[buffer->length];
+}
+
+/*
+ *  act on one header.  returns GLOBUS_TRUE if the connection needs
+ *  another header next, GLOBUS_FALSE if it is now waiting on a payload
+ *  read, cached, or closing.  this should be called locked
+ */
+static
+globus_bool_t
+globus_l_ftp_eb_parse_header(
+    globus_ftp_data_connection_t *              data_conn,
+    globus_byte_t                               descriptor,
+    globus_off_t                                count,
+    globus_off_t                                offset)
+{
+    globus_ftp_data_stripe_t *                  stripe;
+    globus_i_ftp_dc_handle_t *                  dc_handle;
+    globus_l_ftp_data_callback_info_t *         cb_info;
+    globus_object_t *                           error;
+    globus_result_t                             res;
+    globus_i_ftp_dc_transfer_handle_t *         transfer_handle;
+    globus_bool_t                               eod = GLOBUS_FALSE;
+    globus_bool_t                               next_header = GLOBUS_FALSE;
+
+    stripe = data_conn->whos_my_daddy;
+    transfer_handle = stripe->whos_my_daddy;
+    dc_handle = transfer_handle->whos_my_daddy;
+
+    if(descriptor & GLOBUS_FTP_CONTROL_DATA_DESCRIPTOR_EOD)
+    {
+        /* set connection state eod and local state eod */
+        data_conn->eod = GLOBUS_TRUE;
+        eod = GLOBUS_TRUE;
+    }
+    if(descriptor & GLOBUS_FTP_CONTROL_DATA_DESCRIPTOR_CLOSE)
+    {
+        data_conn->close = GLOBUS_TRUE;
+    }
+
+    /*
+     *  if EOF get the data connection close count
+     */
+    if(descriptor & GLOBUS_FTP_CONTROL_DATA_DESCRIPTOR_EOF)
+    {
+        data_conn->offset = 0;
+        data_conn->bytes_ready = 0;
+        stripe->eod_count = offset;
+    }
+    else
+    {
+        data_conn->bytes_ready = count;
+        data_conn->offset = offset;
+    }
+
+    /*
+     *  message without payload
+     */
+    if(data_conn->bytes_ready == 0)
+    {
+        /*
+         *  if end of data and close, close the connection.
+         */
+        if(data_conn->close)
+        {
+            /*
+             *  next assertion happens if the writer breaks
+             *  the protocol and sends a CLOSE prior to
+             *  an EOD.  
+             *
+             *  TODO: stop transfer and return error to user 
+             */
+            globus_assert(data_conn->reusing || data_conn->eod);
+
+            /* 
+             * if local eod state is true it means we have not
+             * already preformed the following needed steps so
+             * do them now.
+             */
+            if(eod)
+            {
+                stripe->eods_received++;
+                stripe->connection_count--;
+            }
+            /* 
+             * if not local eod but conn state eod, it means that
+             * that we have added the connection to the free_cache
+             * list and must remove it
+             */
+            else if(data_conn->eod)
+            {
+                globus_list_remove(
+                    &stripe->free_cache_list,
+                    globus_list_search(
+                            stripe->free_cache_list, data_conn));
+            }
+
+            /* 
+             *  remove from all list before closing
+             */
+            globus_list_remove_element(
+                &stripe->all_conn_list,
+                (void *)data_conn);
+
+            CALLBACK_INFO_MALLOC(
+                cb_info,
+                dc_handle,
+                transfer_handle,
+                stripe,
+                data_conn);
+            res = globus_io_register_close(
+                      &data_conn->io_handle,
+                      globus_l_ftp_io_close_callback,
+                      (void *)cb_info);
+            if(res != GLOBUS_SUCCESS)
+            {
+                res = globus_callback_register_oneshot(
+                         GLOBUS_NULL,
+                         GLOBUS_NULL,
+                         globus_l_ftp_control_io_close_kickout,
+                         cb_info);
+                globus_assert(res == GLOBUS_SUCCESS);
+            }
+        }
+        /*
+         *  if we got EOD without a close message
+         *  cache the current connection
+         */
+        else if(data_conn->eod)
+        {
+            stripe->eods_received++;
+            stripe->connection_count--;
+
+            globus_list_insert(
+                &stripe->free_cache_list,
+                (void*) data_conn);
+        }
+        /*
+         *  we end up in this part of the branch if we got an EOF
+         *  without an EOD or if the sender sent a header with
+         *  length equal to zero (which they shouldn't do).
+         */
+        else
+        {
+            next_header = GLOBUS_TRUE;
+        }
+    }
+    else
+    {
+        /*
+         *  if not a big buffer read place connection in
+         *  free connection list
+         */
+        if(transfer_handle->big_buffer == GLOBUS_NULL)
+        {
+            globus_fifo_enqueue(
+                &stripe->free_conn_q,
+                (void *)data_conn);
+        }
+        /*
+         *  if it is a big buffer read, read directly into the
+         *  buffer.
+         */
+        else
+        {
+            globus_off_t end_offset;
+    	    globus_off_t end_buffer;
+
+    	    end_offset = ((globus_off_t) data_conn->bytes_ready) +
+     	        data_conn->offset;
+            end_buffer = ((globus_off_t)
+                                transfer_handle->big_buffer_length);
+
+            /*
+             *  if the sender sent more bytes than the users
+             *  buffer can handle
+             */
+            if(end_offset > end_buffer)
+            {
+                error =  globus_error_construct_string(
+                             GLOBUS_FTP_CONTROL_MODULE,
+                             GLOBUS_NULL,
+                             _FCSL("too much data has been sent."));
+                globus_l_ftp_control_stripes_destroy(dc_handle, error);
+                globus_object_free(error);
+            }
+            else
+            {
+                globus_l_ftp_handle_table_entry_t *    t_e;
+
+                transfer_handle->ref++;
+                TABLE_ENTRY_MALLOC(
+                    t_e,
+                    &transfer_handle->big_buffer[data_conn->offset],
+                    data_conn->bytes_ready,
+                    data_conn->offset,
+                    GLOBUS_FALSE,
+                    transfer_handle->big_buffer_cb,
+                    transfer_handle->big_buffer_cb_arg,
+                    dc_handle);
+                t_e->whos_my_daddy = data_conn;
+
+                /*
+                 *  register a read into the users buffer at the
+                 *  correct offset.
+                 */
+                res = globus_l_ftp_eb_register_read(data_conn, t_e);
+                globus_assert(res == GLOBUS_SUCCESS);
+            }
+        }
+    }
+    data_conn->reusing = GLOBUS_FALSE;
+
+    return next_header;
+}
+
+/*
+ *  handle the headers already in a connection's read buffer, then read
+ *  more unless one of them left the connection waiting on something
+ *  else.  the read asks for as much as the buffer holds but only waits
+ *  for the rest of one header, so a run of small blocks costs one read
+ *  instead of two per block.  this should be called locked
+ */
+static
+globus_result_t
+globus_l_ftp_eb_read_header(
+    globus_ftp_data_connection_t *              data_conn)
+{
+    globus_byte_t                               descriptor;
+    globus_off_t                                count;
+    globus_off_t                                offset;
+    globus_byte_t *                             buf;
+    globus_size_t                               space;
+    globus_size_t                               wait_for;
+
+    while(globus_l_ftp_eb_buffer_header(
+              &data_conn->read_buffer, &descriptor, &count, &offset))
+    {
+        if(!globus_l_ftp_eb_parse_header(
+                data_conn, descriptor, count, offset))
+        {
+            return GLOBUS_SUCCESS;
+        }
+    }
+
+    buf = globus_l_ftp_eb_buffer_space(
+              &data_conn->read_buffer, &space, &wait_for);
+    if(buf == GLOBUS_NULL)
+    {
+        return globus_error_put(globus_error_construct_string(
+                   GLOBUS_FTP_CONTROL_MODULE,
+                   GLOBUS_NULL,
+                   _FCSL("malloc failed")));
+    }
+
+    return globus_xio_register_read(
+               globus_l_ftp_data_conn_xio_handle(data_conn),
+               buf,
+               space,
+               wait_for,
+               GLOBUS_NULL,
+               globus_l_ftp_eb_read_header_callback,
+               (void *)data_conn);
+}
+
 /*
  *  globus_l_ftp_eb_read_header_callback()
  *  --------------------------------------
  */
 void
 globus_l_ftp_eb_read_header_callback(
-    void *                                      arg,
-    globus_io_handle_t *                        handle,
+    globus_xio_handle_t                         handle,
     globus_result_t                             result,
     globus_byte_t *                             buf,
-    globus_size_t                               nbyte)
+    globus_size_t                               len,
+    globus_size_t                               nbyte,
+    globus_xio_data_descriptor_t                data_desc,
+    void *                                      arg)
 {
     globus_ftp_data_connection_t *              data_conn;
     globus_ftp_data_stripe_t *                  stripe;
     globus_i_ftp_dc_handle_t *                  dc_handle;
-    globus_l_ftp_eb_header_t *                  eb_header;
-    globus_l_ftp_eb_header_t *                  eb_header2;
-    globus_l_ftp_data_callback_info_t *         cb_info;
     globus_object_t *                           error = GLOBUS_NULL;
     globus_result_t                             res;
-    const globus_object_type_t *                type;
-    globus_off_t                                offset;
-    globus_off_t                                tmp;
     globus_i_ftp_dc_transfer_handle_t *         transfer_handle;
-    globus_bool_t                               eod = GLOBUS_FALSE;
 
     data_conn = (globus_ftp_data_connection_t *)arg;
     stripe = data_conn->whos_my_daddy;
     transfer_handle = stripe->whos_my_daddy;
     dc_handle = transfer_handle->whos_my_daddy;
     GlobusFTPControlDataTestMagic(dc_handle);
-    eb_header = (globus_l_ftp_eb_header_t *)buf;
 
     globus_mutex_lock(&dc_handle->mutex);
     {
@@ -9508,236 +10552,179 @@ globus_l_ftp_eb_read_header_callback(
         if(result != GLOBUS_SUCCESS)
         {
             error = globus_error_get(result);
-            type = globus_object_get_type(error);
 
-            if(!globus_object_type_match(
-                type,
-                GLOBUS_IO_ERROR_TYPE_IO_CANCELLED))
+            if(!globus_error_match(
+                error,
+                GLOBUS_XIO_MODULE,
+                GLOBUS_XIO_ERROR_CANCELED))
             {
                 globus_l_ftp_control_stripes_destroy(dc_handle, error);
             }
         }
         else
         {
-            if(eb_header->descriptor & GLOBUS_FTP_CONTROL_DATA_DESCRIPTOR_EOD)
-    	    {
-                /* set connection state eod and local state eod */
-                data_conn->eod = GLOBUS_TRUE;
-                eod = GLOBUS_TRUE;
-            }
-            if(eb_header->descriptor & GLOBUS_FTP_CONTROL_DATA_DESCRIPTOR_CLOSE)
-            {
-                data_conn->close = GLOBUS_TRUE;
-            }
+            data_conn->read_buffer.length += nbyte;
 
-            /*
-             *  if EOF get the data connection close count
-             */
-            if(eb_header->descriptor & GLOBUS_FTP_CONTROL_DATA_DESCRIPTOR_EOF)
-            {
-                data_conn->offset = 0;
-                data_conn->bytes_ready = 0;
-                globus_l_ftp_control_data_decode(
-                    eb_header->offset,
-                    &tmp);
-                stripe->eod_count = tmp;
-            }
-            else
+            res = globus_l_ftp_eb_read_header(data_conn);
+            if(res != GLOBUS_SUCCESS)
             {
-                globus_l_ftp_control_data_decode(
-                    eb_header->count,
-                    &tmp);
-                data_conn->bytes_ready = tmp;
-                globus_l_ftp_control_data_decode(
-                    eb_header->offset,
-                    &data_conn->offset);
+                error = globus_error_get(res);
+                globus_l_ftp_control_stripes_destroy(dc_handle, error);
             }
+        }
+        globus_l_ftp_data_stripe_poll(dc_handle);
+    }
+    globus_mutex_unlock(&dc_handle->mutex);
 
-            /*
-             *  message without payload
-             */
-            if(data_conn->bytes_ready == 0)
-            {
-                /*
-                 *  if end of data and close, close the connection.
-                 */
-                if(data_conn->close)
-                {
-                    /*
-                     *  next assertion happens if the writer breaks
-                     *  the protocol and sends a CLOSE prior to
-                     *  an EOD.  
-                     *
-                     *  TODO: stop transfer and return error to user 
-                     */
-                    globus_assert(data_conn->reusing || data_conn->eod);
+    if(error != GLOBUS_NULL)
+    {
+        globus_object_free(error);
+    }
+}
 
-                    /* 
-                     * if local eod state is true it means we have not
-                     * already preformed the following needed steps so
-                     * do them now.
-                     */
-                    if(eod)
-                    {
-                        stripe->eods_received++;
-                        stripe->connection_count--;
-                    }
-                    /* 
-                     * if not local eod but conn state eod, it means that
-                     * that we have added the connection to the free_cache
-                     * list and must remove it
-                     */
-                    else if(data_conn->eod)
-                    {
-                        globus_list_remove(
-                            &stripe->free_cache_list,
-                            globus_list_search(
-                                    stripe->free_cache_list, data_conn));
-                    }
+/*
+ *  register the payload read for an entry.  payload that came in with
+ *  the last header read is used first, and if that covers the read the
+ *  entry is finished from a oneshot instead.  a file read finishes with
+ *  whatever was buffered, the same as a short splice would.  this should
+ *  be called locked
+ */
+static
+globus_result_t
+globus_l_ftp_eb_register_read(
+    globus_ftp_data_connection_t *              data_conn,
+    globus_l_ftp_handle_table_entry_t *         entry)
+{
+    globus_byte_t *                             buffered;
+    globus_size_t                               nbyte;
+    globus_xio_data_descriptor_t                dd;
+    globus_result_t                             res;
 
-                    /* 
-                     *  remove from all list before closing
-                     */
-                    globus_list_remove_element(
-                        &stripe->all_conn_list,
-                        (void *)data_conn);
+    nbyte = entry->length;
+    buffered = globus_l_ftp_eb_buffer_take(&data_conn->read_buffer, &nbyte);
+    if(nbyte > 0)
+    {
+        if(entry->file_fd >= 0)
+        {
+#ifndef TARGET_ARCH_WIN32
+            globus_size_t                       written = 0;
+            ssize_t                             rc;
 
-                    CALLBACK_INFO_MALLOC(
-                        cb_info,
-                        dc_handle,
-                        transfer_handle,
-                        stripe,
-                        data_conn);
-                    res = globus_io_register_close(
-                              &data_conn->io_handle,
-                              globus_l_ftp_io_close_callback,
-                              (void *)cb_info);
-                    if(res != GLOBUS_SUCCESS)
-                    {
-                        res = globus_callback_register_oneshot(
-                                 GLOBUS_NULL,
-                                 GLOBUS_NULL,
-                                 globus_l_ftp_control_io_close_kickout,
-                                 cb_info);
-                        globus_assert(res == GLOBUS_SUCCESS);
-                    }
-                }
-                /*
-                 *  if we got EOD without a close message
-                 *  cache the current connection
-                 */
-                else if(data_conn->eod)
+            while(written < nbyte && entry->error == GLOBUS_NULL)
+            {
+                rc = pwrite(
+                    entry->file_fd,
+                    &buffered[written],
+                    nbyte - written,
+                    data_conn->offset + entry->file_offset + written);
+                if(rc >= 0)
                 {
-                    stripe->eods_received++;
-                    stripe->connection_count--;
-
-                    globus_list_insert(
-                        &stripe->free_cache_list,
-                        (void*) data_conn);
+                    written += rc;
                 }
-                /*
-                 *  we end up in this part of the branch if we got an EOF
-                 *  without an EOD or if the sender sent a header with
-                 *  length equal to zero (which they shouldn't do).
-                 */
-                else
+                else if(errno != EINTR)
                 {
-                    eb_header2 = (globus_l_ftp_eb_header_t *)globus_malloc(
-                                     sizeof(globus_l_ftp_eb_header_t));
-
-                    res = globus_io_register_read(
-                              &data_conn->io_handle,
-                              (globus_byte_t*)eb_header2,
-                              sizeof(globus_l_ftp_eb_header_t),
-                              sizeof(globus_l_ftp_eb_header_t),
-                              globus_l_ftp_eb_read_header_callback,
-                              (void *)data_conn);
-                    globus_assert(res == GLOBUS_SUCCESS);
+                    entry->error = globus_error_construct_errno_error(
+                        GLOBUS_FTP_CONTROL_MODULE, GLOBUS_NULL, errno);
                 }
             }
-            else
-            {
-                /*
-                 *  if not a big buffer read place connection in
-                 *  free connection list
-                 */
-                if(transfer_handle->big_buffer == GLOBUS_NULL)
-                {
-                    globus_fifo_enqueue(
-                        &stripe->free_conn_q,
-                        (void *)data_conn);
-                }
-                /*
-                 *  if it is a big buffer read, read directly into the
-                 *  buffer.
-                 */
-                else
-                {
-                    globus_off_t end_offset;
-            	    globus_off_t end_buffer;
+#else
+            entry->error = globus_error_construct_string(
+                GLOBUS_FTP_CONTROL_MODULE,
+                GLOBUS_NULL,
+                _FCSL("reading into a file is not supported."));
+#endif
+        }
+        else
+        {
+            memcpy(entry->buffer, buffered, nbyte);
+        }
+        entry->buffered = nbyte;
+    }
 
-            	    end_offset = ((globus_off_t) data_conn->bytes_ready) +
-             	        data_conn->offset;
-                    end_buffer = ((globus_off_t)
-                                        transfer_handle->big_buffer_length);
+    if(entry->error != GLOBUS_NULL ||
+       entry->buffered == entry->length ||
+       (entry->buffered > 0 && entry->file_fd >= 0))
+    {
+        res = globus_callback_register_oneshot(
+                  GLOBUS_NULL,
+                  GLOBUS_NULL,
+                  globus_l_ftp_eb_read_kickout,
+                  (void *)entry);
+    }
+    else if(entry->file_fd >= 0)
+    {
+        /* the tcp driver puts the block at its own offset in the file */
+        res = globus_l_ftp_data_file_dd_init(data_conn, entry, &dd);
+        if(res == GLOBUS_SUCCESS)
+        {
+            res = globus_xio_register_read(
+                      globus_l_ftp_data_conn_xio_handle(data_conn),
+                      (globus_byte_t *) entry,
+                      1,
+                      entry->length,
+                      dd,
+                      globus_l_ftp_eb_read_callback,
+                      (void *)entry);
+            globus_xio_data_descriptor_destroy(dd);
+        }
+    }
+    else
+    {
+        res = globus_xio_register_read(
+                  globus_l_ftp_data_conn_xio_handle(data_conn),
+                  &entry->buffer[nbyte],
+                  entry->length - nbyte,
+                  entry->length - nbyte,
+                  GLOBUS_NULL,
+                  globus_l_ftp_eb_read_callback,
+                  (void *)entry);
+    }
 
-                    /*
-                     *  if the sender sent more bytes than the users
-                     *  buffer can handle
-                     */
-                    if(end_offset > end_buffer)
-                    {
-                        error =  globus_error_construct_string(
-                                     GLOBUS_FTP_CONTROL_MODULE,
-                                     GLOBUS_NULL,
-				     _FCSL("too much data has been sent."));
-                        globus_l_ftp_control_stripes_destroy(dc_handle, error);
-                    }
-                    else
-                    {
-                        globus_l_ftp_handle_table_entry_t *    t_e;
+    return res;
+}
 
-                        offset = data_conn->offset;
-                        transfer_handle->ref++;
-                        TABLE_ENTRY_MALLOC(
-                            t_e,
-                            &transfer_handle->big_buffer[data_conn->offset],
-                            data_conn->bytes_ready,
-                            data_conn->offset,
-                            GLOBUS_FALSE,
-                            transfer_handle->big_buffer_cb,
-                            transfer_handle->big_buffer_cb_arg,
-                            dc_handle);
-                        t_e->whos_my_daddy = data_conn;
+/*
+ *  finish a read that globus_l_ftp_eb_register_read() didn't need the
+ *  network for.  the connection may have been torn down since, so let
+ *  the read callback know without it looking at the connection.
+ */
+static
+void
+globus_l_ftp_eb_read_kickout(
+    void *                                      user_args)
+{
+    globus_l_ftp_handle_table_entry_t *         entry;
+    globus_i_ftp_dc_handle_t *                  dc_handle;
+    globus_result_t                             result = GLOBUS_SUCCESS;
 
-                        /*
-                         *  register a read into the users buffer at the
-                         *  correct offset.
-                         */
-                        res = globus_io_register_read(
-                                  &data_conn->io_handle,
-                                  &transfer_handle->big_buffer[offset],
-                                  data_conn->bytes_ready,
-                                  data_conn->bytes_ready,
-                                  globus_l_ftp_eb_read_callback,
-                                  (void *)t_e);
-                        globus_assert(res == GLOBUS_SUCCESS);
-                    }
-                }
-            }
-            data_conn->reusing = GLOBUS_FALSE;
+    entry = (globus_l_ftp_handle_table_entry_t *) user_args;
+    dc_handle = entry->dc_handle;
+
+    globus_mutex_lock(&dc_handle->mutex);
+    {
+        if(entry->error != GLOBUS_NULL)
+        {
+            result = globus_error_put(entry->error);
+            entry->error = GLOBUS_NULL;
+        }
+        else if(dc_handle->transfer_handle != entry->transfer_handle)
+        {
+            result = globus_error_put(globus_error_construct_string(
+                         GLOBUS_FTP_CONTROL_MODULE,
+                         GLOBUS_NULL,
+                         _FCSL("data connection closed.")));
         }
-        globus_l_ftp_data_stripe_poll(dc_handle);
     }
     globus_mutex_unlock(&dc_handle->mutex);
 
-    globus_free(eb_header);
-
-    
-    if(error != GLOBUS_NULL)
-    {
-        globus_object_free(error);
-    }
+    globus_l_ftp_eb_read_callback(
+        GLOBUS_NULL,
+        result,
+        entry->buffer,
+        entry->length,
+        0,
+        GLOBUS_NULL,
+        (void *)entry);
 }
 
 void
@@ -9811,17 +10798,18 @@ globus_l_ftp_data_order_read_cb(
 
 void
 globus_l_ftp_eb_read_callback(
-    void *                                      arg,
-    globus_io_handle_t *                        handle,
+    globus_xio_handle_t                         handle,
     globus_result_t                             result,
     globus_byte_t *                             buf,
-    globus_size_t                               nbyte)
+    globus_size_t                               len,
+    globus_size_t                               nbyte,
+    globus_xio_data_descriptor_t                data_desc,
+    void *                                      arg)
 {
     globus_l_ftp_handle_table_entry_t *         entry;
     globus_ftp_data_connection_t *              data_conn;
     globus_ftp_data_stripe_t *                  stripe;
     globus_i_ftp_dc_handle_t *                  dc_handle;
-    globus_l_ftp_eb_header_t *                  eb_header;
     globus_l_ftp_data_callback_info_t *         cb_info;
     globus_ftp_control_handle_t    *            control_handle;
     globus_object_t *                           error = GLOBUS_NULL;
@@ -9829,25 +10817,21 @@ globus_l_ftp_eb_read_callback(
     globus_bool_t                               eof = GLOBUS_FALSE;
     globus_result_t                             res;
     globus_byte_t *                             buffer = GLOBUS_NULL;
-    const globus_object_type_t *                type;
     globus_i_ftp_dc_transfer_handle_t *         transfer_handle;
     globus_size_t                               nl_bytes;
     globus_bool_t                               poll;
     globus_bool_t                               free_entry = GLOBUS_TRUE;
+    globus_bool_t                               closed;
 
-    nl_bytes = nbyte;
     entry = (globus_l_ftp_handle_table_entry_t *)arg;
+    /* count what globus_l_ftp_eb_register_read() took from the buffer */
+    nbyte += entry->buffered;
+    nl_bytes = nbyte;
 
     dc_handle = entry->dc_handle;
     GlobusFTPControlDataTestMagic(dc_handle);
-    data_conn = entry->whos_my_daddy;
-    stripe = data_conn->whos_my_daddy;
-    transfer_handle = stripe->whos_my_daddy;
+    transfer_handle = entry->transfer_handle;
     control_handle = dc_handle->whos_my_daddy;
-        globus_i_ftp_control_debug_printf(9,
-            (stderr, "readcb: %"GLOBUS_OFF_T_FORMAT", %p\n", 
-                data_conn->offset,
-                (void *) data_conn));
 
     globus_mutex_lock(&dc_handle->mutex);
     {
@@ -9857,25 +10841,39 @@ globus_l_ftp_eb_read_callback(
             buffer = transfer_handle->big_buffer;
         }
 
+        /*
+         *  reads finished from globus_l_ftp_eb_read_kickout() can come
+         *  in after the connection is gone, so don't look at it then
+         */
+        closed = dc_handle->state == GLOBUS_FTP_DATA_STATE_CLOSING ||
+                 dc_handle->transfer_handle != transfer_handle;
+
         if(result != GLOBUS_SUCCESS)
         {
             error = globus_error_get(result);
             eof = GLOBUS_TRUE;
-            type = globus_object_get_type(error);
 
-            if(!globus_object_type_match(
-                type,
-                GLOBUS_IO_ERROR_TYPE_IO_CANCELLED))
+            if(!closed && !globus_error_match(
+                error,
+                GLOBUS_XIO_MODULE,
+                GLOBUS_XIO_ERROR_CANCELED))
             {
                 globus_l_ftp_control_stripes_destroy(dc_handle, error);
             }
         }
-        else if(dc_handle->state == GLOBUS_FTP_DATA_STATE_CLOSING)
+        else if(closed)
         {
             eof = GLOBUS_TRUE;
         }
         else
         {
+            data_conn = entry->whos_my_daddy;
+            stripe = data_conn->whos_my_daddy;
+            globus_i_ftp_control_debug_printf(9,
+                (stderr, "readcb: %"GLOBUS_OFF_T_FORMAT", %p\n", 
+                    data_conn->offset,
+                    (void *) data_conn));
+
             /*
              *  add the number of bytes read to data_conn->offset and
              *  subtract from bytes_ready
@@ -9944,23 +10942,13 @@ globus_l_ftp_eb_read_callback(
                             (void*) data_conn);
                     }
                 }
-                /* register the next header read */
+                /* handle or read the next header */
                 else
                 {
-                    eb_header = (globus_l_ftp_eb_header_t *)
-                                 globus_malloc(
-                                     sizeof(globus_l_ftp_eb_header_t));
-
-                    res = globus_io_register_read(
-                                 &data_conn->io_handle,
-                                 (globus_byte_t *)eb_header,
-                                 sizeof(globus_l_ftp_eb_header_t),
-                                 sizeof(globus_l_ftp_eb_header_t),
-                                 globus_l_ftp_eb_read_header_callback,
-                                 (void *)data_conn);
+                    res = globus_l_ftp_eb_read_header(data_conn);
                     if(res != GLOBUS_SUCCESS)
                     {
-                        error = globus_error_get(result);
+                        error = globus_error_get(res);
                         eof = GLOBUS_TRUE;
                     }
                 }
@@ -10163,7 +11151,7 @@ globus_l_ftp_eb_connect_callback(
              */
             if(data_conn->free_me)
             {
-                globus_free(data_conn);
+                DATA_CONN_FREE(data_conn);
             }
             else
             {
@@ -10265,12 +11253,13 @@ globus_l_ftp_eb_connect_callback(
  */
 void
 globus_l_ftp_eb_write_callback(
-    void *                                      arg,
-    globus_io_handle_t *                        handle,
+    globus_xio_handle_t                         handle,
     globus_result_t                             result,
-    struct iovec *                              iov,
-    globus_size_t                               iovcnt,
-    globus_size_t                               nbytes)
+    globus_xio_iovec_t *                        iov,
+    int                                         iovcnt,
+    globus_size_t                               nbytes,
+    globus_xio_data_descriptor_t                data_desc,
+    void *                                      arg)
 {
     globus_l_ftp_handle_table_entry_t *         entry;
     globus_l_ftp_handle_table_entry_t *         eof_cb_ent;
@@ -10284,7 +11273,6 @@ globus_l_ftp_eb_write_callback(
     globus_object_t *                           error = GLOBUS_NULL;
     globus_l_ftp_eb_header_t *                  eb_header;
     globus_result_t                             res;
-    const globus_object_type_t *                type;
     globus_bool_t                               eof = GLOBUS_FALSE;
     globus_i_ftp_dc_transfer_handle_t *         transfer_handle;
     globus_l_ftp_send_eof_entry_t *             send_eof_ent = GLOBUS_NULL;
@@ -10315,11 +11303,11 @@ globus_l_ftp_eb_write_callback(
         if(result != GLOBUS_SUCCESS)
         {
             error = globus_error_get(result);
-            type = globus_object_get_type(error);
 
-            if(!globus_object_type_match(
-                type,
-                GLOBUS_IO_ERROR_TYPE_IO_CANCELLED))
+            if(!globus_error_match(
+                error,
+                GLOBUS_XIO_MODULE,
+                GLOBUS_XIO_ERROR_CANCELED))
             {
                 globus_l_ftp_control_stripes_destroy(dc_handle, error);
             }
@@ -10564,11 +11552,13 @@ globus_l_ftp_eb_write_callback(
 
 void
 globus_l_ftp_close_msg_callback(
-    void *                                      arg,
-    globus_io_handle_t *                        handle,
+    globus_xio_handle_t                         handle,
     globus_result_t                             result,
     globus_byte_t *                             buf,
-    globus_size_t                               nbytes)
+    globus_size_t                               len,
+    globus_size_t                               nbytes,
+    globus_xio_data_descriptor_t                data_desc,
+    void *                                      arg)
 {
     globus_ftp_data_connection_t *              data_conn;
     globus_i_ftp_dc_handle_t *                  dc_handle;
@@ -10603,11 +11593,13 @@ globus_l_ftp_close_msg_callback(
 
 void
 globus_l_ftp_eb_send_eof_callback(
-    void *                                      arg,
-    globus_io_handle_t *                        handle,
+    globus_xio_handle_t                         handle,
     globus_result_t                             result,
     globus_byte_t *                             buf,
-    globus_size_t                               nbytes)
+    globus_size_t                               len,
+    globus_size_t                               nbytes,
+    globus_xio_data_descriptor_t                data_desc,
+    void *                                      arg)
 {
     globus_ftp_data_connection_t *              data_conn;
     globus_ftp_data_stripe_t *                  stripe;
@@ -10617,7 +11609,6 @@ globus_l_ftp_eb_send_eof_callback(
     globus_object_t *                           error = GLOBUS_NULL;
     globus_bool_t                               fire_cb = GLOBUS_FALSE;
     globus_i_ftp_dc_transfer_handle_t *         transfer_handle;
-    const globus_object_type_t *                type;
     globus_bool_t                               poll;
     globus_ftp_data_connection_state_t          initial_state;
 
@@ -10639,11 +11630,11 @@ globus_l_ftp_eb_send_eof_callback(
         if(result != GLOBUS_SUCCESS)
         {
             error = globus_error_get(result);
-            type = globus_object_get_type(error);
 
-            if(!globus_object_type_match(
-                type,
-                GLOBUS_IO_ERROR_TYPE_IO_CANCELLED))
+            if(!globus_error_match(
+                error,
+                GLOBUS_XIO_MODULE,
+                GLOBUS_XIO_ERROR_CANCELED))
             {
                 globus_l_ftp_control_stripes_destroy(dc_handle, error);
             }
@@ -10731,11 +11722,13 @@ globus_l_ftp_eb_send_eof_callback(
  */
 void
 globus_l_ftp_eb_eof_eod_callback(
-    void *                                      arg,
-    globus_io_handle_t *                        handle,
+    globus_xio_handle_t                         handle,
     globus_result_t                             result,
     globus_byte_t *                             buf,
-    globus_size_t                               nbytes)
+    globus_size_t                               len,
+    globus_size_t                               nbytes,
+    globus_xio_data_descriptor_t                data_desc,
+    void *                                      arg)
 {
     globus_ftp_data_connection_t *              data_conn;
     globus_ftp_data_stripe_t *                  stripe;
@@ -10746,7 +11739,6 @@ globus_l_ftp_eb_eof_eod_callback(
     globus_l_ftp_handle_table_entry_t *         eof_cb_ent;
     globus_l_ftp_data_callback_info_t *         callback_info;
     globus_object_t *                           error = GLOBUS_NULL;
-    const globus_object_type_t *                type;
     globus_i_ftp_dc_transfer_handle_t *         transfer_handle;
     globus_l_ftp_send_eof_entry_t *             send_eof_ent = GLOBUS_NULL;
     globus_bool_t                               poll;
@@ -10773,11 +11765,11 @@ globus_l_ftp_eb_eof_eod_callback(
         else if(result != GLOBUS_SUCCESS)
         {
             error = globus_error_get(result);
-            type = globus_object_get_type(error);
 
-            if(!globus_object_type_match(
-                type,
-                GLOBUS_IO_ERROR_TYPE_IO_CANCELLED))
+            if(!globus_error_match(
+                error,
+                GLOBUS_XIO_MODULE,
+                GLOBUS_XIO_ERROR_CANCELED))
             {
                 globus_l_ftp_control_stripes_destroy(dc_handle, error);
             }
@@ -10906,6 +11898,26 @@ globus_l_ftp_eb_eof_eod_callback(
 /*********************************************************************
 *  other functions
 *********************************************************************/
+/*
+ *  data blocks skip the globus_io compat layer, which would allocate,
+ *  lock and possibly bounce through a oneshot for every read and write.
+ *  closing io_handle closes the xio handle, which cancels anything
+ *  still outstanding on it before the close callback.
+ */
+static
+globus_xio_handle_t
+globus_l_ftp_data_conn_xio_handle(
+    globus_ftp_data_connection_t *               data_conn)
+{
+    if(data_conn->xio_handle == GLOBUS_NULL)
+    {
+        globus_io_handle_get_xio_handle(
+            &data_conn->io_handle, &data_conn->xio_handle);
+    }
+
+    return data_conn->xio_handle;
+}
+
 static
 void
 globus_l_ftp_control_data_encode(
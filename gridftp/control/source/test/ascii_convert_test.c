@@ -0,0 +1,450 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ *  Checks the ASCII type conversion routines against the byte at a time
+ *  versions they replaced, on random buffers heavy in CR and LF, and
+ *  checks that a CRLF split between two stream mode reads is stripped.
+ *  Then reports MB/s for both versions as TAP comments.  Pass a seed to
+ *  repeat a run, and a size in MB to time more data.
+ */
+#include "globus_ftp_control.h"
+#include "globus_common.h"
+#include <string.h>
+#include <sys/time.h>
+
+#define ASCII_FUZZ_ITERATIONS                   20000
+#define ASCII_FUZZ_MAX_LENGTH                   512
+#define ASCII_STREAM_LENGTH                     (256 * 1024)
+#define ASCII_BENCH_DEFAULT_MB                  16
+#define ASCII_BENCH_LINE                        72
+
+/* internal to the library */
+globus_byte_t *
+globus_l_ftp_control_add_ascii(
+    globus_byte_t *                             in_buf,
+    int                                         length,
+    globus_off_t *                              ascii_len);
+
+int
+globus_l_ftp_control_strip_ascii(
+    globus_byte_t *                             in_buf,
+    int                                         length);
+
+int
+globus_l_ftp_control_strip_ascii_stream(
+    globus_byte_t *                             buf,
+    int                                         length,
+    int                                         max_length,
+    int *                                       carry,
+    globus_bool_t                               eof);
+
+/* the original versions, kept as the reference */
+static
+int
+old_strip_ascii(
+    globus_byte_t *                             buf,
+    int                                         length)
+{
+    int                                         ctr;
+    int                                         count = 0;
+
+    if(length < 1)
+    {
+        return length;
+    }
+
+    for(ctr = 0; ctr < length - 1; ctr++)
+    {
+        if(buf[ctr] == '\r' &&
+           buf[ctr + 1] == '\n')
+        {
+            memmove(&buf[ctr], &buf[ctr+1], length - (ctr + 1));
+            count++;
+        }
+    }
+
+    return length - count;
+}
+
+static
+globus_byte_t *
+old_add_ascii(
+    globus_byte_t *                             in_buf,
+    int                                         length,
+    globus_off_t *                              ascii_len)
+{
+    globus_byte_t *                             out_buf;
+    int                                         ctr;
+    int                                         out_ndx = 0;
+
+    if(length < 1)
+    {
+        *ascii_len = 0;
+        return GLOBUS_NULL;
+    }
+
+    out_buf = (globus_byte_t *)globus_malloc(length*2);
+
+    for(ctr = 0; ctr < length; ctr++)
+    {
+        if(in_buf[ctr] == '\n')
+        {
+            out_buf[out_ndx] = '\r';
+            out_ndx++;
+        }
+        out_buf[out_ndx] = in_buf[ctr];
+        out_ndx++;
+    }
+
+    *ascii_len = out_ndx;
+
+    return out_buf;
+}
+
+static
+void
+random_text(
+    globus_byte_t *                             buf,
+    int                                         length)
+{
+    static const char                           alphabet[] = "ab\r\n\r\n ";
+    int                                         ctr;
+
+    for(ctr = 0; ctr < length; ctr++)
+    {
+        buf[ctr] = alphabet[rand() % (sizeof(alphabet) - 1)];
+    }
+}
+
+static
+double
+now_seconds(void)
+{
+    struct timeval                              tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static
+int
+add_ascii_fuzz(void)
+{
+    globus_byte_t                               in[ASCII_FUZZ_MAX_LENGTH];
+    globus_byte_t *                             out;
+    globus_byte_t *                             ref;
+    globus_off_t                                out_len;
+    globus_off_t                                ref_len;
+    int                                         length;
+    int                                         ctr;
+
+    for(ctr = 0; ctr < ASCII_FUZZ_ITERATIONS; ctr++)
+    {
+        length = rand() % ASCII_FUZZ_MAX_LENGTH;
+        random_text(in, length);
+        if(ctr % 4 == 0)
+        {
+            /* some buffers without any LF at all */
+            memset(in, 'x', length);
+        }
+
+        out = globus_l_ftp_control_add_ascii(in, length, &out_len);
+        ref = old_add_ascii(in, length, &ref_len);
+
+        if(out_len != ref_len ||
+            memcmp(out ? out : in, ref ? ref : in, ref_len) != 0)
+        {
+            printf("# add_ascii differs on a %d byte buffer\n", length);
+            return 1;
+        }
+        if(out)
+        {
+            globus_free(out);
+        }
+        if(ref)
+        {
+            globus_free(ref);
+        }
+    }
+
+    return 0;
+}
+
+static
+int
+strip_ascii_fuzz(void)
+{
+    globus_byte_t                               in[ASCII_FUZZ_MAX_LENGTH];
+    globus_byte_t                               ref[ASCII_FUZZ_MAX_LENGTH];
+    int                                         length;
+    int                                         in_len;
+    int                                         ref_len;
+    int                                         ctr;
+
+    for(ctr = 0; ctr < ASCII_FUZZ_ITERATIONS; ctr++)
+    {
+        length = rand() % ASCII_FUZZ_MAX_LENGTH;
+        random_text(in, length);
+        memcpy(ref, in, length);
+
+        in_len = globus_l_ftp_control_strip_ascii(in, length);
+        ref_len = old_strip_ascii(ref, length);
+
+        if(in_len != ref_len || memcmp(in, ref, ref_len) != 0)
+        {
+            printf("# strip_ascii differs on a %d byte buffer\n", length);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ *  cut a converted stream into reads of random sizes, with random room
+ *  left over in each read's buffer, and check the pieces put back
+ *  together match stripping the whole thing at once.  first check that
+ *  a CR held into a read that hits eof with a full buffer is not lost.
+ */
+static
+int
+strip_ascii_stream_test(void)
+{
+    globus_byte_t *                             text;
+    globus_byte_t *                             ref;
+    globus_byte_t *                             out;
+    globus_byte_t                               piece[ASCII_FUZZ_MAX_LENGTH + 2];
+    int                                         ref_len;
+    int                                         out_len = 0;
+    int                                         offset = 0;
+    int                                         length;
+    int                                         room;
+    int                                         carry = -1;
+    globus_bool_t                               eof;
+
+    text = globus_malloc(ASCII_STREAM_LENGTH);
+    ref = globus_malloc(ASCII_STREAM_LENGTH);
+    out = globus_malloc(ASCII_STREAM_LENGTH);
+
+    /* "ab\r" then "c" at eof, in a one byte buffer */
+    memcpy(piece, "ab\r", 3);
+    length = globus_l_ftp_control_strip_ascii_stream(
+        piece, 3, 3, &carry, GLOBUS_FALSE);
+    memcpy(out, piece, length);
+    out_len = length;
+    piece[0] = 'c';
+    length = globus_l_ftp_control_strip_ascii_stream(
+        piece, 1, 1, &carry, GLOBUS_TRUE);
+    memcpy(out + out_len, piece, length);
+    out_len += length;
+    /* the stream callback reads again and gets eof with nothing */
+    length = globus_l_ftp_control_strip_ascii_stream(
+        piece, 0, 1, &carry, GLOBUS_TRUE);
+    memcpy(out + out_len, piece, length);
+    out_len += length;
+    if(out_len != 4 || memcmp(out, "ab\rc", 4) != 0 || carry != -1)
+    {
+        printf("# CR held into a full read at eof was lost\n");
+        return 1;
+    }
+    out_len = 0;
+
+    random_text(text, ASCII_STREAM_LENGTH);
+    memcpy(ref, text, ASCII_STREAM_LENGTH);
+    ref_len = old_strip_ascii(ref, ASCII_STREAM_LENGTH);
+
+    do
+    {
+        length = rand() % ASCII_FUZZ_MAX_LENGTH + 1;
+        if(length > ASCII_STREAM_LENGTH - offset)
+        {
+            length = ASCII_STREAM_LENGTH - offset;
+        }
+        eof = (offset + length == ASCII_STREAM_LENGTH);
+        /* a full buffer half the time.  a byte still held at eof is
+           flushed by an empty read, as the stream callback does */
+        room = (rand() % 2 && length > 0) ? 0 : rand() % 2 + 1;
+
+        memcpy(piece, text + offset, length);
+        offset += length;
+        length = globus_l_ftp_control_strip_ascii_stream(
+            piece, length, length + room, &carry, eof);
+
+        memcpy(out + out_len, piece, length);
+        out_len += length;
+    } while(!eof || carry != -1);
+
+    if(out_len != ref_len || memcmp(out, ref, ref_len) != 0 || carry != -1)
+    {
+        printf("# stream strip_ascii differs from whole buffer strip\n");
+        return 1;
+    }
+
+    globus_free(text);
+    globus_free(ref);
+    globus_free(out);
+
+    return 0;
+}
+
+static
+int
+ascii_bench(
+    int                                         mb)
+{
+    globus_byte_t *                             text;
+    globus_byte_t *                             out;
+    globus_byte_t *                             ref;
+    globus_off_t                                out_len;
+    globus_off_t                                ref_len;
+    int                                         length;
+    int                                         block;
+    int                                         ctr;
+    globus_off_t                                stripped;
+    double                                      start;
+    double                                      new_add;
+    double                                      old_add;
+    double                                      new_strip;
+    double                                      old_strip;
+    int                                         rc = 0;
+
+    length = mb * 1024 * 1024;
+    block = 256 * 1024;
+    text = globus_malloc(length);
+    for(ctr = 0; ctr < length; ctr++)
+    {
+        text[ctr] = (ctr % ASCII_BENCH_LINE == ASCII_BENCH_LINE - 1)
+            ? '\n' : 'a' + ctr % 26;
+    }
+
+    start = now_seconds();
+    for(ctr = 0; ctr < length; ctr += block)
+    {
+        out = globus_l_ftp_control_add_ascii(text + ctr, block, &out_len);
+        globus_free(out);
+    }
+    new_add = now_seconds() - start;
+
+    start = now_seconds();
+    for(ctr = 0; ctr < length; ctr += block)
+    {
+        out = old_add_ascii(text + ctr, block, &out_len);
+        globus_free(out);
+    }
+    old_add = now_seconds() - start;
+
+    /* strip works in place, so strip the converted text block by block */
+    out = globus_l_ftp_control_add_ascii(text, length, &out_len);
+    ref = globus_malloc(out_len);
+    memcpy(ref, out, out_len);
+
+    stripped = 0;
+    start = now_seconds();
+    for(ctr = 0; ctr < out_len; ctr += block)
+    {
+        stripped += globus_l_ftp_control_strip_ascii(
+            out + ctr, (out_len - ctr < block) ? out_len - ctr : block);
+    }
+    new_strip = now_seconds() - start;
+
+    start = now_seconds();
+    for(ctr = 0; ctr < out_len; ctr += block)
+    {
+        stripped -= old_strip_ascii(
+            ref + ctr, (out_len - ctr < block) ? out_len - ctr : block);
+    }
+    old_strip = now_seconds() - start;
+
+    if(stripped != 0)
+    {
+        rc = 1;
+    }
+
+    printf("# add_ascii:   %8.1f MB/s, was %8.1f MB/s\n",
+        mb / (new_add > 0 ? new_add : 1e-6),
+        mb / (old_add > 0 ? old_add : 1e-6));
+    ref_len = out_len / (1024 * 1024);
+    printf("# strip_ascii: %8.1f MB/s, was %8.1f MB/s\n",
+        ref_len / (new_strip > 0 ? new_strip : 1e-6),
+        ref_len / (old_strip > 0 ? old_strip : 1e-6));
+
+    globus_free(text);
+    globus_free(out);
+    globus_free(ref);
+
+    return rc;
+}
+
+int
+main(
+    int                                         argc,
+    char *                                      argv[])
+{
+    unsigned int                                seed;
+    int                                         mb = ASCII_BENCH_DEFAULT_MB;
+    int                                         failed = 0;
+
+    setbuf(stdout, NULL);
+
+    seed = (argc > 1) ? (unsigned int) atoi(argv[1]) : (unsigned int) time(NULL);
+    if(argc > 2)
+    {
+        mb = atoi(argv[2]);
+    }
+    srand(seed);
+
+    printf("1..4\n");
+    printf("# seed %u\n", seed);
+
+    if(globus_module_activate(GLOBUS_COMMON_MODULE) != GLOBUS_SUCCESS)
+    {
+        printf("Bail out! can't activate globus common\n");
+        return 99;
+    }
+
+    if(add_ascii_fuzz() != 0)
+    {
+        printf("not ");
+        failed++;
+    }
+    printf("ok - add_ascii_fuzz\n");
+
+    if(strip_ascii_fuzz() != 0)
+    {
+        printf("not ");
+        failed++;
+    }
+    printf("ok - strip_ascii_fuzz\n");
+
+    if(strip_ascii_stream_test() != 0)
+    {
+        printf("not ");
+        failed++;
+    }
+    printf("ok - strip_ascii_stream_test\n");
+
+    if(ascii_bench(mb) != 0)
+    {
+        printf("not ");
+        failed++;
+    }
+    printf("ok - ascii_bench\n");
+
+    globus_module_deactivate(GLOBUS_COMMON_MODULE);
+
+    return failed;
+}
@@ -0,0 +1,591 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ *  Measures data channel throughput over loopback.  Moves the same
+ *  amount of data in stream mode and in extended block mode with 1 to
+ *  64 parallel streams, checking that every byte arrives, and reports
+ *  MB/s and the CPU seconds both ends spent per GB as TAP comments.
+ *  Then does the same with the data channel authenticated (PROT S) and
+ *  encrypted (PROT P) using the test credential, reporting GB/s, to
+ *  show what the GSI driver costs over clear data channels.  Pass a size
+ *  in MB to move more data per run.
+ */
+#include "globus_ftp_control.h"
+#include "globus_common.h"
+#include <string.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include "test_common.h"
+#include "globus_preload.h"
+
+#define THROUGHPUT_BLOCK_SIZE                   (256 * 1024)
+#define THROUGHPUT_DEFAULT_MB                   64
+#define THROUGHPUT_MAX_PLEVEL                   64
+#define THROUGHPUT_PROT_PLEVEL                  4
+
+typedef void (*set_handle_mode_cb_t)(
+    globus_ftp_control_handle_t *               handle,
+    int                                         plevel);
+
+typedef struct throughput_info_s
+{
+    ftp_test_monitor_t                          monitor;
+    globus_off_t                                length;
+    globus_off_t                                received;
+    int                                         writes;
+    int                                         reads;
+    int                                         read_window;
+    globus_bool_t                               read_eof;
+    globus_bool_t                               failed;
+} throughput_info_t;
+
+static globus_byte_t *                          g_write_buffer;
+static gss_cred_id_t                            g_cred = GSS_C_NO_CREDENTIAL;
+
+void
+binary_eb_mode(
+    globus_ftp_control_handle_t *               handle,
+    int                                         plevel);
+
+void
+binary_stream_mode(
+    globus_ftp_control_handle_t *               handle,
+    int                                         plevel);
+
+static
+void
+throughput_failed(
+    throughput_info_t *                         info,
+    globus_object_t *                           error,
+    const char *                                msg)
+{
+    verbose_printf(1, "%s: %s\n", msg,
+        error ? globus_object_printable_to_string(error) : "");
+
+    globus_mutex_lock(&info->monitor.mutex);
+    {
+        info->failed = GLOBUS_TRUE;
+        info->monitor.done = GLOBUS_TRUE;
+        globus_cond_signal(&info->monitor.cond);
+    }
+    globus_mutex_unlock(&info->monitor.mutex);
+}
+
+static
+void
+throughput_check_done(
+    throughput_info_t *                         info)
+{
+    if(info->writes == 0 && info->reads == 0 && info->read_eof)
+    {
+        info->monitor.done = GLOBUS_TRUE;
+        globus_cond_signal(&info->monitor.cond);
+    }
+}
+
+static
+void
+data_write_callback(
+    void *                                      callback_arg,
+    globus_ftp_control_handle_t *               handle,
+    globus_object_t *                           error,
+    globus_byte_t *                             buffer,
+    globus_size_t                               length,
+    globus_off_t                                offset,
+    globus_bool_t                               eof)
+{
+    throughput_info_t *                         info;
+
+    info = (throughput_info_t *) callback_arg;
+    if(error != GLOBUS_NULL)
+    {
+        throughput_failed(info, error, "data_write_callback");
+        return;
+    }
+
+    globus_mutex_lock(&info->monitor.mutex);
+    {
+        info->writes--;
+        throughput_check_done(info);
+    }
+    globus_mutex_unlock(&info->monitor.mutex);
+}
+
+static
+void
+connect_write_callback(
+    void *                                      callback_arg,
+    globus_ftp_control_handle_t *               handle,
+    unsigned int                                stripe_ndx,
+    globus_bool_t                               reuse,
+    globus_object_t *                           error)
+{
+    throughput_info_t *                         info;
+    globus_off_t                                offset;
+    globus_size_t                               nbytes;
+    globus_result_t                             res;
+
+    info = (throughput_info_t *) callback_arg;
+    if(error != GLOBUS_NULL)
+    {
+        throughput_failed(info, error, "connect_write_callback");
+        return;
+    }
+
+    globus_mutex_lock(&info->monitor.mutex);
+    {
+        /* every block goes out of the same buffer */
+        for(offset = 0; offset < info->length; offset += nbytes)
+        {
+            nbytes = THROUGHPUT_BLOCK_SIZE;
+            if(offset + nbytes > info->length)
+            {
+                nbytes = info->length - offset;
+            }
+            res = globus_ftp_control_data_write(
+                      handle,
+                      g_write_buffer,
+                      nbytes,
+                      offset,
+                      offset + nbytes == info->length,
+                      data_write_callback,
+                      info);
+            if(res != GLOBUS_SUCCESS)
+            {
+                info->failed = GLOBUS_TRUE;
+                info->monitor.done = GLOBUS_TRUE;
+                globus_cond_signal(&info->monitor.cond);
+                break;
+            }
+            info->writes++;
+        }
+    }
+    globus_mutex_unlock(&info->monitor.mutex);
+}
+
+static
+void
+data_read_callback(
+    void *                                      callback_arg,
+    globus_ftp_control_handle_t *               handle,
+    globus_object_t *                           error,
+    globus_byte_t *                             buffer,
+    globus_size_t                               length,
+    globus_off_t                                offset,
+    globus_bool_t                               eof)
+{
+    throughput_info_t *                         info;
+    globus_result_t                             res;
+
+    info = (throughput_info_t *) callback_arg;
+    if(error != GLOBUS_NULL)
+    {
+        throughput_failed(info, error, "data_read_callback");
+        return;
+    }
+
+    globus_mutex_lock(&info->monitor.mutex);
+    {
+        info->received += length;
+        if(eof)
+        {
+            info->read_eof = GLOBUS_TRUE;
+        }
+        else
+        {
+            res = globus_ftp_control_data_read(
+                      handle,
+                      buffer,
+                      THROUGHPUT_BLOCK_SIZE,
+                      data_read_callback,
+                      info);
+            if(res == GLOBUS_SUCCESS)
+            {
+                buffer = GLOBUS_NULL;
+                info->reads++;
+            }
+            else
+            {
+                info->failed = GLOBUS_TRUE;
+                info->read_eof = GLOBUS_TRUE;
+            }
+        }
+        info->reads--;
+        throughput_check_done(info);
+    }
+    globus_mutex_unlock(&info->monitor.mutex);
+
+    if(buffer != GLOBUS_NULL)
+    {
+        globus_free(buffer);
+    }
+}
+
+static
+void
+connect_read_callback(
+    void *                                      callback_arg,
+    globus_ftp_control_handle_t *               handle,
+    unsigned int                                stripe_ndx,
+    globus_bool_t                               reuse,
+    globus_object_t *                           error)
+{
+    throughput_info_t *                         info;
+    globus_result_t                             res;
+    int                                         ctr;
+
+    info = (throughput_info_t *) callback_arg;
+    if(error != GLOBUS_NULL)
+    {
+        throughput_failed(info, error, "connect_read_callback");
+        return;
+    }
+
+    globus_mutex_lock(&info->monitor.mutex);
+    {
+        for(ctr = 0; ctr < info->read_window; ctr++)
+        {
+            res = globus_ftp_control_data_read(
+                      handle,
+                      globus_malloc(THROUGHPUT_BLOCK_SIZE),
+                      THROUGHPUT_BLOCK_SIZE,
+                      data_read_callback,
+                      info);
+            if(res != GLOBUS_SUCCESS)
+            {
+                info->failed = GLOBUS_TRUE;
+                info->monitor.done = GLOBUS_TRUE;
+                globus_cond_signal(&info->monitor.cond);
+                break;
+            }
+            info->reads++;
+        }
+    }
+    globus_mutex_unlock(&info->monitor.mutex);
+}
+
+static
+void
+force_close_cb(
+    void *                                      user_arg,
+    globus_ftp_control_handle_t *               handle,
+    globus_object_t *                           error)
+{
+    ftp_test_monitor_signal((ftp_test_monitor_t *) user_arg);
+}
+
+static
+void
+throughput_close(
+    globus_ftp_control_handle_t *               handle)
+{
+    ftp_test_monitor_t                          monitor;
+
+    ftp_test_monitor_init(&monitor);
+    if(globus_ftp_control_data_force_close(
+        handle, force_close_cb, &monitor) == GLOBUS_SUCCESS)
+    {
+        ftp_test_monitor_done_wait(&monitor);
+    }
+    ftp_test_monitor_destroy(&monitor);
+    globus_i_ftp_control_data_cc_destroy(handle);
+}
+
+static
+double
+throughput_cpu_seconds(void)
+{
+    struct rusage                               usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1000000.0 +
+        usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1000000.0;
+}
+
+static
+globus_result_t
+throughput_protect(
+    globus_ftp_control_handle_t *               handle,
+    globus_ftp_control_protection_t             prot)
+{
+    globus_ftp_control_dcau_t                   dcau;
+    globus_result_t                             res;
+
+    dcau.mode = GLOBUS_FTP_CONTROL_DCAU_SELF;
+    res = globus_ftp_control_local_dcau(handle, &dcau, g_cred);
+    if(res == GLOBUS_SUCCESS)
+    {
+        res = globus_ftp_control_local_prot(handle, prot);
+    }
+
+    return res;
+}
+
+static
+int
+throughput_test(
+    const char *                                mode_name,
+    set_handle_mode_cb_t                        mode_cb,
+    int                                         plevel,
+    globus_ftp_control_protection_t             prot,
+    globus_off_t                                length)
+{
+    globus_ftp_control_handle_t                 port_handle;
+    globus_ftp_control_handle_t                 pasv_handle;
+    globus_ftp_control_host_port_t              host_port;
+    throughput_info_t                           info;
+    struct timeval                              start;
+    struct timeval                              end;
+    double                                      cpu;
+    double                                      elapsed;
+    double                                      mb;
+    globus_result_t                             res;
+
+    memset(&info, 0, sizeof(info));
+    ftp_test_monitor_init(&info.monitor);
+    info.length = length;
+    /*
+     *  reads still queued when a stream mode connection hits EOF are not
+     *  called back until the handle is closed, so keep only one there.
+     */
+    info.read_window =
+        mode_cb == binary_stream_mode ? 1 : plevel * 2;
+
+    if(globus_i_ftp_control_data_cc_init(&pasv_handle) != GLOBUS_SUCCESS ||
+        globus_i_ftp_control_data_cc_init(&port_handle) != GLOBUS_SUCCESS)
+    {
+        return 1;
+    }
+
+    globus_ftp_control_host_port_init(&host_port, "localhost", 0);
+    res = globus_ftp_control_local_pasv(&pasv_handle, &host_port);
+    if(res == GLOBUS_SUCCESS)
+    {
+        res = globus_ftp_control_local_port(&port_handle, &host_port);
+    }
+    if(res != GLOBUS_SUCCESS)
+    {
+        return 1;
+    }
+    mode_cb(&pasv_handle, plevel);
+    mode_cb(&port_handle, plevel);
+    if(prot != GLOBUS_FTP_CONTROL_PROTECTION_CLEAR)
+    {
+        res = throughput_protect(&pasv_handle, prot);
+        if(res == GLOBUS_SUCCESS)
+        {
+            res = throughput_protect(&port_handle, prot);
+        }
+        if(res != GLOBUS_SUCCESS)
+        {
+            verbose_printf(1, "throughput_protect: %s\n",
+                globus_object_printable_to_string(globus_error_peek(res)));
+            return 1;
+        }
+    }
+
+    cpu = throughput_cpu_seconds();
+    gettimeofday(&start, NULL);
+
+    res = globus_ftp_control_data_connect_read(
+              &pasv_handle, connect_read_callback, &info);
+    if(res == GLOBUS_SUCCESS)
+    {
+        res = globus_ftp_control_data_connect_write(
+                  &port_handle, connect_write_callback, &info);
+    }
+    if(res != GLOBUS_SUCCESS)
+    {
+        return 1;
+    }
+
+    ftp_test_monitor_done_wait(&info.monitor);
+
+    gettimeofday(&end, NULL);
+    cpu = throughput_cpu_seconds() - cpu;
+    elapsed = (end.tv_sec - start.tv_sec) +
+        (end.tv_usec - start.tv_usec) / 1000000.0;
+
+    mb = length / (1024.0 * 1024.0) / (elapsed > 0 ? elapsed : 1e-6);
+    if(prot == GLOBUS_FTP_CONTROL_PROTECTION_CLEAR)
+    {
+        printf("# %-6s %2d streams: %8.1f MB/s, %6.2f CPU s/GB\n",
+            mode_name,
+            plevel,
+            mb,
+            cpu / (length / (1024.0 * 1024.0 * 1024.0)));
+    }
+    else
+    {
+        printf("# PROT %c %-6s %2d streams: %6.3f GB/s, %6.2f CPU s/GB\n",
+            (char) prot,
+            mode_name,
+            plevel,
+            mb / 1024.0,
+            cpu / (length / (1024.0 * 1024.0 * 1024.0)));
+    }
+
+    throughput_close(&pasv_handle);
+    throughput_close(&port_handle);
+    ftp_test_monitor_destroy(&info.monitor);
+
+    return info.failed || info.received != length;
+}
+
+int
+main(
+    int                                         argc,
+    char *                                      argv[])
+{
+    globus_off_t                                length;
+    int                                         plevel;
+    int                                         ctr;
+    int                                         mb = THROUGHPUT_DEFAULT_MB;
+    int                                         test_count = 5;
+    int                                         failed = 0;
+    globus_ftp_control_protection_t             prot[] =
+    {
+        GLOBUS_FTP_CONTROL_PROTECTION_SAFE,
+        GLOBUS_FTP_CONTROL_PROTECTION_PRIVATE
+    };
+    OM_uint32                                   maj;
+    OM_uint32                                   min;
+
+    LTDL_SET_PRELOADED_SYMBOLS();
+    setbuf(stdout, NULL);
+
+    for(ctr = 1; ctr < argc; ctr++)
+    {
+        if(strcmp(argv[ctr], "--verbose") == 0 && ctr + 1 < argc)
+        {
+            verbose_print_level = atoi(argv[++ctr]);
+        }
+        else
+        {
+            mb = atoi(argv[ctr]);
+        }
+    }
+    length = (globus_off_t) mb * 1024 * 1024;
+
+    for(plevel = 1; plevel <= THROUGHPUT_MAX_PLEVEL; plevel *= 2)
+    {
+        test_count++;
+    }
+    printf("1..%d\n", test_count);
+
+    if(globus_module_activate(GLOBUS_FTP_CONTROL_MODULE) != GLOBUS_SUCCESS)
+    {
+        printf("Bail out! can't activate ftp control\n");
+        return 99;
+    }
+
+    g_write_buffer = globus_malloc(THROUGHPUT_BLOCK_SIZE);
+    memset(g_write_buffer, 'a', THROUGHPUT_BLOCK_SIZE);
+
+    if(throughput_test("stream", binary_stream_mode, 1,
+        GLOBUS_FTP_CONTROL_PROTECTION_CLEAR, length) != 0)
+    {
+        printf("not ");
+        failed++;
+    }
+    printf("ok - throughput_test(binary_stream_mode, 1)\n");
+
+    for(plevel = 1; plevel <= THROUGHPUT_MAX_PLEVEL; plevel *= 2)
+    {
+        if(throughput_test("eb", binary_eb_mode, plevel,
+            GLOBUS_FTP_CONTROL_PROTECTION_CLEAR, length) != 0)
+        {
+            printf("not ");
+            failed++;
+        }
+        printf("ok - throughput_test(binary_eb_mode, %d)\n", plevel);
+    }
+
+    maj = gss_acquire_cred(
+            &min,
+            GSS_C_NO_NAME,
+            0,
+            GSS_C_NO_OID_SET,
+            GSS_C_BOTH,
+            &g_cred,
+            NULL,
+            NULL);
+
+    for(ctr = 0; ctr < (int) (sizeof(prot) / sizeof(prot[0])); ctr++)
+    {
+        if(GSS_ERROR(maj))
+        {
+            printf("ok # SKIP no credential for PROT %c\n", (char) prot[ctr]);
+            printf("ok # SKIP no credential for PROT %c\n", (char) prot[ctr]);
+            continue;
+        }
+
+        if(throughput_test("stream", binary_stream_mode, 1,
+            prot[ctr], length) != 0)
+        {
+            printf("not ");
+            failed++;
+        }
+        printf("ok - throughput_test(binary_stream_mode, 1, PROT %c)\n",
+            (char) prot[ctr]);
+
+        if(throughput_test("eb", binary_eb_mode, THROUGHPUT_PROT_PLEVEL,
+            prot[ctr], length) != 0)
+        {
+            printf("not ");
+            failed++;
+        }
+        printf("ok - throughput_test(binary_eb_mode, %d, PROT %c)\n",
+            THROUGHPUT_PROT_PLEVEL, (char) prot[ctr]);
+    }
+
+    if(g_cred != GSS_C_NO_CREDENTIAL)
+    {
+        gss_release_cred(&min, &g_cred);
+    }
+
+    globus_free(g_write_buffer);
+    globus_module_deactivate(GLOBUS_FTP_CONTROL_MODULE);
+
+    return failed;
+}
+
+void
+binary_eb_mode(
+    globus_ftp_control_handle_t *               handle,
+    int                                         plevel)
+{
+    globus_ftp_control_parallelism_t            parallelism;
+
+    parallelism.mode = GLOBUS_FTP_CONTROL_PARALLELISM_FIXED;
+    parallelism.fixed.size = plevel;
+
+    globus_ftp_control_local_type(handle, GLOBUS_FTP_CONTROL_TYPE_IMAGE, 0);
+    globus_ftp_control_local_mode(
+        handle, GLOBUS_FTP_CONTROL_MODE_EXTENDED_BLOCK);
+    globus_ftp_control_local_parallelism(handle, &parallelism);
+}
+
+void
+binary_stream_mode(
+    globus_ftp_control_handle_t *               handle,
+    int                                         plevel)
+{
+    globus_ftp_control_local_type(handle, GLOBUS_FTP_CONTROL_TYPE_IMAGE, 0);
+    globus_ftp_control_local_mode(handle, GLOBUS_FTP_CONTROL_MODE_STREAM);
+}
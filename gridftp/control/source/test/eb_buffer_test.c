@@ -0,0 +1,770 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ *  Checks the extended block mode reader through the data channel API.
+ *  Runs of small blocks and of random sized blocks are written in a
+ *  random order over loopback and read back with random sized reads,
+ *  and every byte is checked against its offset.  A transfer is also
+ *  sent behind another on the same handles before the reader has
+ *  started on the first, so the second begins from what was read ahead
+ *  past an EOD on the cached connections, and transfers are read into
+ *  a file with globus_ftp_control_data_read_file().  Pass a seed to
+ *  repeat a run.
+ */
+#include "globus_ftp_control.h"
+#include "globus_common.h"
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include "test_common.h"
+#include "globus_preload.h"
+
+#define EB_SMALL_BLOCKS                         10000
+#define EB_SMALL_BLOCK_LENGTH                   64
+#define EB_BEHIND_BLOCKS                        300
+#define EB_RANDOM_BLOCKS                        200
+#define EB_RANDOM_BLOCK_LENGTH                  (128 * 1024)
+#define EB_MAX_READ_LENGTH                      (96 * 1024)
+#define EB_READ_WINDOW                          8
+#define EB_SALT                                 4099
+#define EB_TIMEOUT                              60
+
+typedef struct eb_transfer_s
+{
+    ftp_test_monitor_t                          monitor;
+    int                                         salt;
+    int                                         block_count;
+    globus_off_t *                              offsets;
+    globus_size_t *                             lengths;
+    globus_off_t                                length;
+    int                                         writes;
+    globus_bool_t                               write_done;
+    /* reads are registered by the caller instead of on connect */
+    globus_bool_t                               hold_reads;
+    int                                         fd;
+    globus_byte_t *                             seen;
+    globus_off_t                                received;
+    int                                         reads;
+    globus_bool_t                               read_eof;
+    globus_bool_t                               read_done;
+    globus_bool_t                               reused;
+    globus_bool_t                               failed;
+} eb_transfer_t;
+
+static globus_byte_t *                          g_data;
+
+void
+binary_eb_mode(
+    globus_ftp_control_handle_t *               handle,
+    int                                         plevel);
+
+static
+globus_byte_t
+eb_expected(
+    eb_transfer_t *                             transfer,
+    globus_off_t                                offset)
+{
+    return g_data[transfer->salt + offset];
+}
+
+static
+void
+eb_transfer_init(
+    eb_transfer_t *                             transfer,
+    int                                         block_count,
+    int                                         max_block_length,
+    int                                         salt)
+{
+    globus_off_t                                offset = 0;
+    globus_off_t                                tmp_offset;
+    globus_size_t                               tmp_length;
+    int                                         ctr;
+    int                                         i;
+
+    memset(transfer, 0, sizeof(eb_transfer_t));
+    ftp_test_monitor_init(&transfer->monitor);
+    transfer->salt = salt;
+    transfer->block_count = block_count;
+    transfer->fd = -1;
+    transfer->offsets = (globus_off_t *)
+        globus_malloc(sizeof(globus_off_t) * block_count);
+    transfer->lengths = (globus_size_t *)
+        globus_malloc(sizeof(globus_size_t) * block_count);
+
+    for(ctr = 0; ctr < block_count; ctr++)
+    {
+        transfer->offsets[ctr] = offset;
+        transfer->lengths[ctr] = 1 + rand() % max_block_length;
+        offset += transfer->lengths[ctr];
+    }
+    transfer->length = offset;
+
+    /* blocks go out in a random order */
+    for(ctr = block_count - 1; ctr > 0; ctr--)
+    {
+        i = rand() % (ctr + 1);
+        tmp_offset = transfer->offsets[ctr];
+        tmp_length = transfer->lengths[ctr];
+        transfer->offsets[ctr] = transfer->offsets[i];
+        transfer->lengths[ctr] = transfer->lengths[i];
+        transfer->offsets[i] = tmp_offset;
+        transfer->lengths[i] = tmp_length;
+    }
+
+    transfer->seen = (globus_byte_t *) globus_calloc(1, transfer->length);
+}
+
+static
+void
+eb_transfer_destroy(
+    eb_transfer_t *                             transfer)
+{
+    ftp_test_monitor_destroy(&transfer->monitor);
+    globus_free(transfer->offsets);
+    globus_free(transfer->lengths);
+    globus_free(transfer->seen);
+}
+
+/* should be called locked */
+static
+void
+eb_failed(
+    eb_transfer_t *                             transfer,
+    globus_object_t *                           error,
+    const char *                                msg)
+{
+    verbose_printf(1, "%s: %s\n", msg,
+        error ? globus_object_printable_to_string(error) : "");
+
+    transfer->failed = GLOBUS_TRUE;
+    globus_cond_broadcast(&transfer->monitor.cond);
+}
+
+/* a transfer that loses data never finishes, so give up after a while */
+static
+void
+eb_wait(
+    eb_transfer_t *                             transfer,
+    globus_bool_t *                             done)
+{
+    globus_abstime_t                            timeout;
+
+    GlobusTimeAbstimeSet(timeout, EB_TIMEOUT, 0);
+    globus_mutex_lock(&transfer->monitor.mutex);
+    {
+        while(!*done && !transfer->failed)
+        {
+            if(globus_cond_timedwait(
+                   &transfer->monitor.cond,
+                   &transfer->monitor.mutex,
+                   &timeout) == ETIMEDOUT)
+            {
+                eb_failed(transfer, GLOBUS_NULL, "timed out");
+            }
+        }
+    }
+    globus_mutex_unlock(&transfer->monitor.mutex);
+}
+
+static
+void
+data_write_callback(
+    void *                                      callback_arg,
+    globus_ftp_control_handle_t *               handle,
+    globus_object_t *                           error,
+    globus_byte_t *                             buffer,
+    globus_size_t                               length,
+    globus_off_t                                offset,
+    globus_bool_t                               eof)
+{
+    eb_transfer_t *                             transfer;
+
+    transfer = (eb_transfer_t *) callback_arg;
+    globus_mutex_lock(&transfer->monitor.mutex);
+    {
+        if(error != GLOBUS_NULL)
+        {
+            eb_failed(transfer, error, "data_write_callback");
+        }
+        transfer->writes--;
+        if(transfer->writes == 0)
+        {
+            transfer->write_done = GLOBUS_TRUE;
+            globus_cond_broadcast(&transfer->monitor.cond);
+        }
+    }
+    globus_mutex_unlock(&transfer->monitor.mutex);
+}
+
+static
+void
+connect_write_callback(
+    void *                                      callback_arg,
+    globus_ftp_control_handle_t *               handle,
+    unsigned int                                stripe_ndx,
+    globus_bool_t                               reuse,
+    globus_object_t *                           error)
+{
+    eb_transfer_t *                             transfer;
+    globus_result_t                             res;
+    int                                         ctr;
+
+    transfer = (eb_transfer_t *) callback_arg;
+    globus_mutex_lock(&transfer->monitor.mutex);
+    {
+        if(error != GLOBUS_NULL)
+        {
+            eb_failed(transfer, error, "connect_write_callback");
+        }
+        for(ctr = 0; ctr < transfer->block_count && !transfer->failed; ctr++)
+        {
+            res = globus_ftp_control_data_write(
+                      handle,
+                      &g_data[transfer->salt + transfer->offsets[ctr]],
+                      transfer->lengths[ctr],
+                      transfer->offsets[ctr],
+                      ctr == transfer->block_count - 1,
+                      data_write_callback,
+                      transfer);
+            if(res != GLOBUS_SUCCESS)
+            {
+                eb_failed(transfer, globus_error_peek(res), "data_write");
+                break;
+            }
+            transfer->writes++;
+        }
+    }
+    globus_mutex_unlock(&transfer->monitor.mutex);
+}
+
+static
+void
+data_read_callback(
+    void *                                      callback_arg,
+    globus_ftp_control_handle_t *               handle,
+    globus_object_t *                           error,
+    globus_byte_t *                             buffer,
+    globus_size_t                               length,
+    globus_off_t                                offset,
+    globus_bool_t                               eof);
+
+/* should be called locked */
+static
+void
+eb_read_more(
+    eb_transfer_t *                             transfer,
+    globus_ftp_control_handle_t *               handle)
+{
+    globus_size_t                               length;
+    globus_result_t                             res;
+
+    while(transfer->reads < EB_READ_WINDOW &&
+          !transfer->read_eof && !transfer->failed)
+    {
+        length = 1 + rand() % EB_MAX_READ_LENGTH;
+        if(transfer->fd >= 0)
+        {
+            res = globus_ftp_control_data_read_file(
+                      handle,
+                      transfer->fd,
+                      0,
+                      length,
+                      data_read_callback,
+                      transfer);
+        }
+        else
+        {
+            res = globus_ftp_control_data_read(
+                      handle,
+                      globus_malloc(length),
+                      length,
+                      data_read_callback,
+                      transfer);
+        }
+        if(res != GLOBUS_SUCCESS)
+        {
+            eb_failed(transfer, globus_error_peek(res), "data_read");
+            break;
+        }
+        transfer->reads++;
+    }
+}
+
+static
+void
+data_read_callback(
+    void *                                      callback_arg,
+    globus_ftp_control_handle_t *               handle,
+    globus_object_t *                           error,
+    globus_byte_t *                             buffer,
+    globus_size_t                               length,
+    globus_off_t                                offset,
+    globus_bool_t                               eof)
+{
+    eb_transfer_t *                             transfer;
+    globus_size_t                               ctr;
+
+    transfer = (eb_transfer_t *) callback_arg;
+    globus_mutex_lock(&transfer->monitor.mutex);
+    {
+        transfer->reads--;
+        if(error != GLOBUS_NULL)
+        {
+            eb_failed(transfer, error, "data_read_callback");
+        }
+        else if(offset < 0 || offset + length > transfer->length)
+        {
+            eb_failed(transfer, GLOBUS_NULL, "data_read_callback: offset");
+        }
+        else
+        {
+            for(ctr = 0; ctr < length; ctr++)
+            {
+                if(transfer->seen[offset + ctr] ||
+                   (buffer != GLOBUS_NULL &&
+                    buffer[ctr] != eb_expected(transfer, offset + ctr)))
+                {
+                    eb_failed(transfer, GLOBUS_NULL,
+                        "data_read_callback: data");
+                    break;
+                }
+                transfer->seen[offset + ctr] = 1;
+            }
+            transfer->received += length;
+        }
+        if(eof)
+        {
+            transfer->read_eof = GLOBUS_TRUE;
+        }
+        eb_read_more(transfer, handle);
+        if(transfer->reads == 0 && transfer->read_eof)
+        {
+            transfer->read_done = GLOBUS_TRUE;
+            globus_cond_broadcast(&transfer->monitor.cond);
+        }
+    }
+    globus_mutex_unlock(&transfer->monitor.mutex);
+
+    if(buffer != GLOBUS_NULL)
+    {
+        globus_free(buffer);
+    }
+}
+
+static
+void
+connect_read_callback(
+    void *                                      callback_arg,
+    globus_ftp_control_handle_t *               handle,
+    unsigned int                                stripe_ndx,
+    globus_bool_t                               reuse,
+    globus_object_t *                           error)
+{
+    eb_transfer_t *                             transfer;
+
+    transfer = (eb_transfer_t *) callback_arg;
+    globus_mutex_lock(&transfer->monitor.mutex);
+    {
+        if(error != GLOBUS_NULL)
+        {
+            eb_failed(transfer, error, "connect_read_callback");
+        }
+        transfer->reused = reuse;
+        if(!transfer->hold_reads)
+        {
+            eb_read_more(transfer, handle);
+        }
+    }
+    globus_mutex_unlock(&transfer->monitor.mutex);
+}
+
+/*
+ *  check what a file read left in the file and mark it seen
+ */
+static
+void
+eb_file_check(
+    eb_transfer_t *                             transfer)
+{
+    globus_byte_t *                             buf;
+    globus_off_t                                ctr;
+
+    buf = globus_malloc(transfer->length);
+    if(pread(transfer->fd, buf, transfer->length, 0) != transfer->length)
+    {
+        transfer->failed = GLOBUS_TRUE;
+    }
+    for(ctr = 0; ctr < transfer->length && !transfer->failed; ctr++)
+    {
+        if(buf[ctr] != eb_expected(transfer, ctr))
+        {
+            verbose_printf(1, "file data wrong at %ld\n", (long) ctr);
+            transfer->failed = GLOBUS_TRUE;
+        }
+    }
+    globus_free(buf);
+}
+
+static
+int
+eb_transfer_result(
+    eb_transfer_t *                             transfer)
+{
+    globus_off_t                                ctr;
+
+    if(transfer->failed || transfer->received != transfer->length)
+    {
+        verbose_printf(1, "received %ld of %ld\n",
+            (long) transfer->received, (long) transfer->length);
+        return 1;
+    }
+    if(transfer->fd >= 0)
+    {
+        eb_file_check(transfer);
+        return transfer->failed;
+    }
+    for(ctr = 0; ctr < transfer->length; ctr++)
+    {
+        if(!transfer->seen[ctr])
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static
+int
+eb_file_open(void)
+{
+    char                                        path[] = "eb_buffer_testXXXXXX";
+    int                                         fd;
+
+    fd = mkstemp(path);
+    if(fd >= 0)
+    {
+        unlink(path);
+    }
+
+    return fd;
+}
+
+static
+void
+force_close_cb(
+    void *                                      user_arg,
+    globus_ftp_control_handle_t *               handle,
+    globus_object_t *                           error)
+{
+    ftp_test_monitor_signal((ftp_test_monitor_t *) user_arg);
+}
+
+static
+void
+eb_close(
+    globus_ftp_control_handle_t *               handle)
+{
+    ftp_test_monitor_t                          monitor;
+
+    ftp_test_monitor_init(&monitor);
+    if(globus_ftp_control_data_force_close(
+        handle, force_close_cb, &monitor) == GLOBUS_SUCCESS)
+    {
+        ftp_test_monitor_done_wait(&monitor);
+    }
+    ftp_test_monitor_destroy(&monitor);
+    globus_i_ftp_control_data_cc_destroy(handle);
+}
+
+static
+int
+eb_open(
+    globus_ftp_control_handle_t *               pasv_handle,
+    globus_ftp_control_handle_t *               port_handle,
+    int                                         plevel)
+{
+    globus_ftp_control_host_port_t              host_port;
+
+    if(globus_i_ftp_control_data_cc_init(pasv_handle) != GLOBUS_SUCCESS ||
+        globus_i_ftp_control_data_cc_init(port_handle) != GLOBUS_SUCCESS)
+    {
+        return 1;
+    }
+    globus_ftp_control_host_port_init(&host_port, "localhost", 0);
+    if(globus_ftp_control_local_pasv(pasv_handle, &host_port) !=
+            GLOBUS_SUCCESS ||
+        globus_ftp_control_local_port(port_handle, &host_port) !=
+            GLOBUS_SUCCESS)
+    {
+        return 1;
+    }
+    binary_eb_mode(pasv_handle, plevel);
+    binary_eb_mode(port_handle, plevel);
+
+    return 0;
+}
+
+/*
+ *  one transfer, read while it is written
+ */
+static
+int
+eb_blocks_test(
+    int                                         plevel,
+    int                                         block_count,
+    int                                         max_block_length,
+    globus_bool_t                               to_file)
+{
+    globus_ftp_control_handle_t                 pasv_handle;
+    globus_ftp_control_handle_t                 port_handle;
+    eb_transfer_t                               transfer;
+    int                                         rc = 1;
+
+    eb_transfer_init(&transfer, block_count, max_block_length, 0);
+    if(to_file)
+    {
+        transfer.fd = eb_file_open();
+    }
+    if(eb_open(&pasv_handle, &port_handle, plevel) != 0)
+    {
+        goto exit;
+    }
+
+    if(globus_ftp_control_data_connect_read(
+           &pasv_handle, connect_read_callback, &transfer) != GLOBUS_SUCCESS ||
+       globus_ftp_control_data_connect_write(
+           &port_handle, connect_write_callback, &transfer) != GLOBUS_SUCCESS)
+    {
+        goto exit;
+    }
+    eb_wait(&transfer, &transfer.write_done);
+    eb_wait(&transfer, &transfer.read_done);
+
+    rc = eb_transfer_result(&transfer);
+
+    eb_close(&pasv_handle);
+    eb_close(&port_handle);
+exit:
+    if(transfer.fd >= 0)
+    {
+        close(transfer.fd);
+    }
+    eb_transfer_destroy(&transfer);
+
+    return rc;
+}
+
+/*
+ *  write two transfers on the same handles before reading either, so the
+ *  reader finds the start of the second behind the EOD of the first and
+ *  has to keep it with the cached connections.
+ */
+static
+int
+eb_behind_test(
+    int                                         plevel,
+    globus_bool_t                               to_file)
+{
+    globus_ftp_control_handle_t                 pasv_handle;
+    globus_ftp_control_handle_t                 port_handle;
+    eb_transfer_t                               first;
+    eb_transfer_t                               second;
+    int                                         rc = 1;
+
+    eb_transfer_init(
+        &first, EB_BEHIND_BLOCKS, EB_SMALL_BLOCK_LENGTH, 0);
+    eb_transfer_init(
+        &second, EB_BEHIND_BLOCKS, EB_SMALL_BLOCK_LENGTH, EB_SALT);
+    first.hold_reads = GLOBUS_TRUE;
+    if(to_file)
+    {
+        first.fd = eb_file_open();
+        second.fd = eb_file_open();
+    }
+    if(eb_open(&pasv_handle, &port_handle, plevel) != 0)
+    {
+        goto exit;
+    }
+
+    if(globus_ftp_control_data_connect_read(
+           &pasv_handle, connect_read_callback, &first) != GLOBUS_SUCCESS ||
+       globus_ftp_control_data_connect_write(
+           &port_handle, connect_write_callback, &first) != GLOBUS_SUCCESS)
+    {
+        goto close;
+    }
+    eb_wait(&first, &first.write_done);
+
+    if(first.failed || globus_ftp_control_data_connect_write(
+           &port_handle, connect_write_callback, &second) != GLOBUS_SUCCESS)
+    {
+        goto close;
+    }
+    eb_wait(&second, &second.write_done);
+
+    globus_mutex_lock(&first.monitor.mutex);
+    {
+        eb_read_more(&first, &pasv_handle);
+    }
+    globus_mutex_unlock(&first.monitor.mutex);
+    eb_wait(&first, &first.read_done);
+
+    if(second.failed || first.failed || globus_ftp_control_data_connect_read(
+           &pasv_handle, connect_read_callback, &second) != GLOBUS_SUCCESS)
+    {
+        goto close;
+    }
+    eb_wait(&second, &second.read_done);
+
+    rc = eb_transfer_result(&first) || eb_transfer_result(&second);
+    if(!second.reused)
+    {
+        verbose_printf(1, "second transfer didn't reuse the connections\n");
+        rc = 1;
+    }
+
+close:
+    eb_close(&pasv_handle);
+    eb_close(&port_handle);
+exit:
+    if(first.fd >= 0)
+    {
+        close(first.fd);
+        close(second.fd);
+    }
+    eb_transfer_destroy(&first);
+    eb_transfer_destroy(&second);
+
+    return rc;
+}
+
+int
+main(
+    int                                         argc,
+    char *                                      argv[])
+{
+    unsigned int                                seed;
+    globus_size_t                               ctr;
+    int                                         failed = 0;
+    int                                         i;
+
+    LTDL_SET_PRELOADED_SYMBOLS();
+    setbuf(stdout, NULL);
+
+    seed = (unsigned int) time(NULL);
+    for(i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--verbose") == 0 && i + 1 < argc)
+        {
+            verbose_print_level = atoi(argv[++i]);
+        }
+        else
+        {
+            seed = (unsigned int) strtoul(argv[i], NULL, 10);
+        }
+    }
+    srand(seed);
+
+    printf("1..8\n");
+    printf("# seed %u\n", seed);
+
+    if(globus_module_activate(GLOBUS_FTP_CONTROL_MODULE) != GLOBUS_SUCCESS)
+    {
+        printf("Bail out! can't activate ftp control\n");
+        return 99;
+    }
+
+    g_data = globus_malloc(
+        EB_RANDOM_BLOCKS * EB_RANDOM_BLOCK_LENGTH + EB_SALT);
+    for(ctr = 0; ctr < EB_RANDOM_BLOCKS * EB_RANDOM_BLOCK_LENGTH + EB_SALT;
+        ctr++)
+    {
+        g_data[ctr] = (globus_byte_t) (ctr * 131 + (ctr >> 11));
+    }
+
+    for(i = 1; i <= 4; i *= 4)
+    {
+        if(eb_blocks_test(i, EB_SMALL_BLOCKS, EB_SMALL_BLOCK_LENGTH,
+            GLOBUS_FALSE) != 0)
+        {
+            printf("not ");
+            failed++;
+        }
+        printf("ok - small_blocks_test(%d)\n", i);
+
+        if(eb_blocks_test(i, EB_RANDOM_BLOCKS, EB_RANDOM_BLOCK_LENGTH,
+            GLOBUS_FALSE) != 0)
+        {
+            printf("not ");
+            failed++;
+        }
+        printf("ok - random_blocks_test(%d)\n", i);
+    }
+
+    if(eb_behind_test(2, GLOBUS_FALSE) != 0)
+    {
+        printf("not ");
+        failed++;
+    }
+    printf("ok - behind_eod_test\n");
+
+    if(eb_blocks_test(2, EB_SMALL_BLOCKS, EB_SMALL_BLOCK_LENGTH,
+        GLOBUS_TRUE) != 0)
+    {
+        printf("not ");
+        failed++;
+    }
+    printf("ok - small_blocks_file_test\n");
+
+    if(eb_blocks_test(1, EB_RANDOM_BLOCKS, EB_RANDOM_BLOCK_LENGTH,
+        GLOBUS_TRUE) != 0)
+    {
+        printf("not ");
+        failed++;
+    }
+    printf("ok - random_blocks_file_test\n");
+
+    if(eb_behind_test(2, GLOBUS_TRUE) != 0)
+    {
+        printf("not ");
+        failed++;
+    }
+    printf("ok - behind_eod_file_test\n");
+
+    globus_free(g_data);
+    globus_module_deactivate(GLOBUS_FTP_CONTROL_MODULE);
+
+    return failed;
+}
+
+void
+binary_eb_mode(
+    globus_ftp_control_handle_t *               handle,
+    int                                         plevel)
+{
+    globus_ftp_control_parallelism_t            parallelism;
+
+    parallelism.mode = GLOBUS_FTP_CONTROL_PARALLELISM_FIXED;
+    parallelism.fixed.size = plevel;
+
+    globus_ftp_control_local_type(handle, GLOBUS_FTP_CONTROL_TYPE_IMAGE, 0);
+    globus_ftp_control_local_mode(
+        handle, GLOBUS_FTP_CONTROL_MODE_EXTENDED_BLOCK);
+    globus_ftp_control_local_parallelism(handle, &parallelism);
+}
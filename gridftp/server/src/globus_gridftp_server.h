@@ -974,6 +974,26 @@ globus_gridftp_server_register_write(
     globus_gridftp_server_write_cb_t    callback,  
     void *                              user_arg);
 
+/*
+ * write_file
+ * 
+ * Register a write of length bytes of the open file fd, starting at
+ * file_offset, without reading them into a buffer first.  The data channel
+ * sends them with sendfile(), so this only works for clear binary transfers
+ * that are not striped and use the default network stack; otherwise it
+ * fails and the data should be sent with globus_gridftp_server_register_write().
+ * The callback gets a NULL buffer, and fd must stay open until it is called.
+ */
+globus_result_t
+globus_gridftp_server_register_write_file(
+    globus_gfs_operation_t              op,
+    int                                 fd,
+    globus_off_t                        file_offset,
+    globus_size_t                       length,
+    globus_off_t                        offset,
+    globus_gridftp_server_write_cb_t    callback,
+    void *                              user_arg);
+
 /*
  * read
  * 
@@ -1001,6 +1021,25 @@ globus_gridftp_server_register_read(
     globus_gridftp_server_read_cb_t     callback,  
     void *                              user_arg);
 
+/*
+ * read_file
+ * 
+ * Register a read of up to length bytes of data straight into the open
+ * file fd, without copying them through a buffer.  Data is written at the
+ * offset the callback reports, which also gets a NULL buffer.  The data
+ * channel moves it with splice(), so this only works for clear binary
+ * transfers that are not striped and use the default network stack;
+ * otherwise it fails and globus_gridftp_server_register_read() should be
+ * used.  fd must stay open until the callback is called.
+ */
+globus_result_t
+globus_gridftp_server_register_read_file(
+    globus_gfs_operation_t              op,
+    int                                 fd,
+    globus_size_t                       length,
+    globus_gridftp_server_read_cb_t     callback,
+    void *                              user_arg);
+
 
 /*
  * register a custom command
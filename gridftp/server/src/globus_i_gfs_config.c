@@ -398,6 +398,25 @@ static const globus_l_gfs_config_option_t option_list[] =
     "resulting files will be created with permissions of 0664. ", NULL, NULL,GLOBUS_FALSE, NULL},
  {"file_timeout", "file_timeout", NULL, "file-timeout", NULL, GLOBUS_L_GFS_CONFIG_INT, 0, NULL,
     "Timeout in seconds for all disk accesses.  A value of 0 disables the timeout.", NULL, NULL,GLOBUS_FALSE, NULL},
+ {"cksm_threads", "cksm_threads", NULL, "cksm-threads", NULL, GLOBUS_L_GFS_CONFIG_INT, 0, NULL,
+    "Number of threads used to compute a checksum of a single file.  Adler32 "
+    "and crc32c checksums are split across this many threads; md5 and sha256 "
+    "use a reader thread and a hashing thread.  A value of 0 uses one thread per "
+    "online cpu, up to 8.", NULL, NULL,GLOBUS_FALSE, NULL},
+ {"inline_cksm", "inline_cksm", NULL, "inline-cksm", NULL, GLOBUS_L_GFS_CONFIG_STRING, 0, NULL,
+    "Checksum algorithm (adler32 or crc32c) to compute from the data of each "
+    "file received, as it arrives.  The result is kept with the size and "
+    "modification time of the file, and a later checksum request with the same "
+    "algorithm is answered without reading the file again while they are unchanged.", NULL, NULL,GLOBUS_FALSE, NULL},
+ {"cksm_cache", "cksm_cache", NULL, "cksm-cache", NULL, GLOBUS_L_GFS_CONFIG_STRING, 0, NULL,
+    "Where to keep checksums so later sessions can reuse them: xattr to store "
+    "them in an extended attribute of each file, or the path of a directory for "
+    "a sidecar file per inode and user.  A sidecar is only used when it is owned "
+    "by the server user or by the owner of the file, and is readable by other "
+    "users only when the file is; a directory shared by several users should be "
+    "sticky and world writable.  Checksums of any range of a file are kept and are "
+    "only used while the size and modification time of the file are unchanged.  "
+    "Hits and misses are logged at the end of each session.", NULL, NULL,GLOBUS_FALSE, NULL},
 {NULL, "Network Options", NULL, NULL, NULL, 0, 0, NULL, NULL, NULL, NULL,GLOBUS_FALSE, NULL},
  {"port", "port", NULL, "port", "p", GLOBUS_L_GFS_CONFIG_INT, 0, NULL,
     "Port on which a frontend will listen for client control channel connections, "
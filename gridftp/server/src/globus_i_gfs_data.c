@@ -320,6 +320,9 @@ typedef struct
     globus_gfs_operation_t              outstanding_op;
     globus_bool_t                       destroy_requested;
     globus_bool_t                       use_interface;
+    /* data channel is the default tcp/gsi stack, so the tcp driver can
+       send straight from a file */
+    globus_bool_t                       default_stack;
     globus_xio_handle_t                 http_handle;
     globus_xio_attr_t                   xio_attr;
     globus_off_t                        http_length;
@@ -7124,6 +7127,9 @@ globus_l_gfs_data_handle_init(
         }
     }
     
+    handle->default_stack = globus_list_empty(net_stack_list) &&
+        !globus_l_gfs_netmgr_driver;
+
     /* create a default stack that we can add the netmgr driver to */
     if(globus_l_gfs_netmgr_driver && globus_list_empty(net_stack_list))
     {
@@ -14063,6 +14069,133 @@ error_alloc:
     return result;
 }
 
+globus_result_t
+globus_gridftp_server_register_write_file(
+    globus_gfs_operation_t              op,
+    int                                 fd,
+    globus_off_t                        file_offset,
+    globus_size_t                       length,
+    globus_off_t                        offset,
+    globus_gridftp_server_write_cb_t    callback,
+    void *                              user_arg)
+{
+    globus_result_t                     result;
+    globus_l_gfs_data_bounce_t *        bounce_info;
+    GlobusGFSName(globus_gridftp_server_register_write_file);
+    GlobusGFSDebugEnter();
+
+    globus_l_gfs_data_alive(op->session_handle);
+
+    /* anything the tcp driver can't send from the file goes through
+       globus_gridftp_server_register_write() */
+    if(op->data_handle->http_handle || !op->data_handle->default_stack ||
+        op->stripe_count > 1)
+    {
+        result = GlobusGFSErrorGeneric("data channel can't send from a file");
+        goto error_alloc;
+    }
+
+    bounce_info = (globus_l_gfs_data_bounce_t *)
+        globus_malloc(sizeof(globus_l_gfs_data_bounce_t));
+    if(!bounce_info)
+    {
+        result = GlobusGFSErrorMemory("bounce_info");
+        goto error_alloc;
+    }
+
+    bounce_info->op = op;
+    bounce_info->callback.write = callback;
+    bounce_info->user_arg = user_arg;
+
+    result = globus_ftp_control_data_write_file(
+        &op->data_handle->data_channel,
+        fd,
+        file_offset,
+        length,
+        offset + op->write_delta,
+        globus_l_gfs_data_write_cb,
+        bounce_info);
+    if(result != GLOBUS_SUCCESS)
+    {
+        result = GlobusGFSErrorWrapFailed(
+            "globus_ftp_control_data_write_file", result);
+        goto error_register;
+    }
+
+    GlobusGFSDebugExit();
+    return GLOBUS_SUCCESS;
+
+error_register:
+    globus_free(bounce_info);
+
+error_alloc:
+    GlobusGFSDebugExitWithError();
+    return result;
+}
+
+globus_result_t
+globus_gridftp_server_register_read_file(
+    globus_gfs_operation_t              op,
+    int                                 fd,
+    globus_size_t                       length,
+    globus_gridftp_server_read_cb_t     callback,
+    void *                              user_arg)
+{
+    globus_result_t                     result;
+    globus_l_gfs_data_bounce_t *        bounce_info;
+    GlobusGFSName(globus_gridftp_server_register_read_file);
+    GlobusGFSDebugEnter();
+
+    globus_l_gfs_data_alive(op->session_handle);
+
+    /* anything the tcp driver can't move into the file goes through
+       globus_gridftp_server_register_read() */
+    if(op->data_handle->http_handle || !op->data_handle->default_stack ||
+        op->stripe_count > 1)
+    {
+        result = GlobusGFSErrorGeneric("data channel can't receive into a file");
+        goto error_alloc;
+    }
+
+    bounce_info = (globus_l_gfs_data_bounce_t *)
+        globus_malloc(sizeof(globus_l_gfs_data_bounce_t));
+    if(!bounce_info)
+    {
+        result = GlobusGFSErrorMemory("bounce_info");
+        goto error_alloc;
+    }
+
+    bounce_info->op = op;
+    bounce_info->callback.read = callback;
+    bounce_info->user_arg = user_arg;
+
+    /* the callback reports offset + write_delta, so the data must land
+       there too */
+    result = globus_ftp_control_data_read_file(
+        &op->data_handle->data_channel,
+        fd,
+        op->write_delta,
+        length,
+        globus_l_gfs_data_read_cb,
+        bounce_info);
+    if(result != GLOBUS_SUCCESS)
+    {
+        result = GlobusGFSErrorWrapFailed(
+            "globus_ftp_control_data_read_file", result);
+        goto error_register;
+    }
+
+    GlobusGFSDebugExit();
+    return GLOBUS_SUCCESS;
+
+error_register:
+    globus_free(bounce_info);
+
+error_alloc:
+    GlobusGFSDebugExitWithError();
+    return result;
+}
+
 void
 globus_gridftp_server_finished_session_start(
     globus_gfs_operation_t              op,
@@ -18,8 +18,7 @@
 #include "globus_gridftp_server.h"
 #include "globus_xio.h"
 #include "globus_xio_file_driver.h"
-#include <openssl/md5.h>
-#include <zlib.h>
+#include "globus_gridftp_server_file_cksm.h"
 #include "version.h"
 
 #include <utime.h>
@@ -74,13 +73,8 @@ typedef void
     char *                              cksm,
     void *                              user_arg);
 
-
-enum
-{
-    GLOBUS_GFS_FILE_CKSM_TYPE_NONE = 0,
-    GLOBUS_GFS_FILE_CKSM_TYPE_ADLER32,
-    GLOBUS_GFS_FILE_CKSM_TYPE_MD5
-};
+/* upper bound for cksm_threads = 0 */
+#define GLOBUS_L_GFS_FILE_CKSM_MAX_THREADS 8
 
 typedef struct globus_l_gfs_file_cksm_monitor_s
 {
@@ -97,10 +91,15 @@ typedef struct globus_l_gfs_file_cksm_monitor_s
     int                                 marker_freq;
     globus_bool_t                       send_marker;
     globus_off_t                        total_bytes;
+    /* protects total_bytes and send_marker from the checksum engine */
+    globus_mutex_t                      lock;
 
-    unsigned char                       cksum_type;
-    MD5_CTX                             mdctx;
-    uint32_t                            adler32ctx;
+    globus_gfs_file_cksm_type_t         cksum_type;
+    globus_gfs_file_cksm_ctx_t          ctx;
+
+    /* the file as it was when we started, for the checksum cache */
+    char *                              pathname;
+    struct stat                         stat_buf;
 
     globus_byte_t                       buffer[];
 } globus_l_gfs_file_cksm_monitor_t;
@@ -122,6 +121,11 @@ typedef struct
     globus_gfs_operation_t              op;
     char *                              pathname;
     globus_xio_handle_t                 file_handle;
+    /* fd the data channel sends from directly, -1 to read into buffers */
+    int                                 send_fd;
+    globus_off_t                        send_size;
+    /* fd the data channel receives into directly, -1 to use buffers */
+    int                                 recv_fd;
     globus_off_t                        file_offset;
     globus_off_t                        read_offset;
     globus_off_t                        read_length;
@@ -138,6 +142,9 @@ typedef struct
     int                                 concurrency_check_interval;
     char *                              expected_cksm;
     char *                              expected_cksm_alg;
+    /* checksum of the received data, kept as it arrives */
+    globus_gfs_file_cksm_type_t         cksm_type;
+    globus_gfs_file_cksm_ranges_t *     cksm_ranges;
     time_t                              utime;
     /* added for multicast stuff, but cold be generally useful */
     gfs_l_file_session_t *              session;
@@ -333,6 +340,9 @@ globus_l_gfs_file_monitor_init(
     monitor->buffer_list = NULL;
     monitor->op = NULL;
     monitor->file_handle = NULL;
+    monitor->send_fd = -1;
+    monitor->send_size = 0;
+    monitor->recv_fd = -1;
     monitor->pending_reads = 0;
     monitor->pending_writes = 0;
     monitor->file_offset = 0;
@@ -345,6 +355,7 @@ globus_l_gfs_file_monitor_init(
     monitor->concurrency_check_interval = 2;
     monitor->expected_cksm = NULL;
     monitor->expected_cksm_alg = NULL;
+    monitor->cksm_ranges = NULL;
     monitor->utime = -1;
     monitor->pathname = NULL;
 
@@ -404,6 +415,10 @@ globus_l_gfs_file_monitor_destroy(
     {
         globus_free(monitor->expected_cksm_alg);
     }
+    if(monitor->cksm_ranges)
+    {
+        globus_gfs_file_cksm_ranges_destroy(monitor->cksm_ranges);
+    }
     
     globus_priority_q_destroy(&monitor->queue);
     globus_list_free(monitor->buffer_list);
@@ -500,6 +515,27 @@ globus_l_gfs_file_close_cb(
             monitor->finish_result = globus_l_gfs_file_utime(
                 NULL, monitor->pathname, monitor->utime);
         }
+
+        if(monitor->finish_result == GLOBUS_SUCCESS &&
+            monitor->cksm_ranges != NULL)
+        {
+            struct stat                 stat_buf;
+            char                        cksm[GLOBUS_GFS_FILE_CKSM_MAX_LEN];
+
+            /* only if we saw every byte of the file as it is now */
+            if(stat(monitor->pathname, &stat_buf) == 0 &&
+                globus_gfs_file_cksm_ranges_final(
+                    monitor->cksm_ranges, 0, stat_buf.st_size, cksm))
+            {
+                globus_gfs_file_cksm_cache_store(
+                    monitor->pathname,
+                    &stat_buf,
+                    monitor->cksm_type,
+                    0,
+                    -1,
+                    cksm);
+            }
+        }
         
         if(monitor->finish_result == GLOBUS_SUCCESS && 
             monitor->expected_cksm != NULL)
@@ -1747,6 +1783,26 @@ error:
     return result;
 }
 
+/* keep checksums for the next time they are asked for */
+static
+void
+globus_l_gfs_file_cksm_remember(
+    globus_l_gfs_file_cksm_monitor_t *  monitor,
+    const char *                        cksm)
+{
+    /* zeroed if stat failed */
+    if(monitor->stat_buf.st_nlink > 0)
+    {
+        globus_gfs_file_cksm_cache_store(
+            monitor->pathname,
+            &monitor->stat_buf,
+            monitor->cksum_type,
+            monitor->offset,
+            monitor->length,
+            cksm);
+    }
+}
+
 static
 void
 globus_l_gfs_file_cksm_read_cb(
@@ -1760,12 +1816,7 @@ globus_l_gfs_file_cksm_read_cb(
 {
     globus_l_gfs_file_cksm_monitor_t *  monitor;
     globus_bool_t                       eof = GLOBUS_FALSE;
-    char *                              cksmptr = NULL;
-    char *                              md5ptr;
-    unsigned char                       md[MD5_DIGEST_LENGTH];
-    char                                md5sum[MD5_DIGEST_LENGTH * 2 + 1] = {0};
-    char                                adler32_human[2*sizeof(uint32_t)+1];
-    int                                 i;    
+    char                                cksm[GLOBUS_GFS_FILE_CKSM_MAX_LEN];
     GlobusGFSName(globus_l_gfs_file_cksm_read_cb);
     GlobusGFSFileDebugEnter();
     
@@ -1796,14 +1847,7 @@ globus_l_gfs_file_cksm_read_cb(
     }
     monitor->total_bytes += nbytes;
 
-    if(monitor->cksum_type == GLOBUS_GFS_FILE_CKSM_TYPE_MD5)
-    {
-        MD5_Update(&monitor->mdctx, buffer, nbytes);
-    }
-    else if (monitor->cksum_type == GLOBUS_GFS_FILE_CKSM_TYPE_ADLER32)
-    {
-        monitor->adler32ctx = adler32(monitor->adler32ctx, buffer, nbytes);
-    }
+    globus_gfs_file_cksm_update(&monitor->ctx, buffer, nbytes);
 
     if(!eof)
     {
@@ -1851,32 +1895,18 @@ globus_l_gfs_file_cksm_read_cb(
             globus_l_gfs_file_close_cb,
             NULL);
 
-        if (monitor->cksum_type == GLOBUS_GFS_FILE_CKSM_TYPE_MD5)
-        {
-            MD5_Final(md, &monitor->mdctx);
-            md5ptr = md5sum;
-            for(i = 0; i < MD5_DIGEST_LENGTH; i++)
-            {
-               md5ptr += sprintf(md5ptr, "%02x", md[i]);
-            }
-            cksmptr = md5sum;
-        }
-        else if (monitor->cksum_type == GLOBUS_GFS_FILE_CKSM_TYPE_ADLER32)
-        {
-            snprintf(adler32_human, sizeof(adler32_human),
-                "%08x", monitor->adler32ctx);
-            cksmptr = adler32_human;
-        }
+        globus_gfs_file_cksm_final(&monitor->ctx, cksm);
+        globus_l_gfs_file_cksm_remember(monitor, cksm);
 
         if(monitor->internal_cb)
         {
             monitor->internal_cb(
-                GLOBUS_SUCCESS, cksmptr, monitor->internal_cb_arg);
+                GLOBUS_SUCCESS, cksm, monitor->internal_cb_arg);
         }
         else
         {
             globus_gridftp_server_finished_command(
-                monitor->op, GLOBUS_SUCCESS, cksmptr);
+                monitor->op, GLOBUS_SUCCESS, cksm);
         }   
         
         globus_free(monitor);
@@ -1909,25 +1939,9 @@ globus_l_gfs_file_marker_cb(
 
 static
 void
-globus_l_gfs_file_open_cksm_cb(
-    globus_xio_handle_t                 handle,
-    globus_result_t                     result,
-    void *                              user_arg)
-{  
-    globus_l_gfs_file_cksm_monitor_t *  monitor;
-    char *                              freq;
-    GlobusGFSName(globus_l_gfs_file_open_cksm_cb);
-    GlobusGFSFileDebugEnter();
-    
-    monitor = (globus_l_gfs_file_cksm_monitor_t *) user_arg;
-
-    if(result != GLOBUS_SUCCESS)
-    {
-        result = GlobusGFSErrorWrapFailed(
-            "open", result);
-        goto error_open;  
-    }  
-    
+globus_l_gfs_file_cksm_start_markers(
+    globus_l_gfs_file_cksm_monitor_t *  monitor)
+{
     if(monitor->op)
     {
         globus_gridftp_server_get_update_interval(
@@ -1951,6 +1965,220 @@ globus_l_gfs_file_open_cksm_cb(
             
         }
     }
+}
+
+static
+void
+globus_l_gfs_file_cksm_engine_free_cb(
+    void *                              user_arg)
+{
+    globus_l_gfs_file_cksm_monitor_t *  monitor;
+
+    monitor = (globus_l_gfs_file_cksm_monitor_t *) user_arg;
+    globus_mutex_destroy(&monitor->lock);
+    globus_free(monitor);
+}
+
+/* called from the checksum engine's threads */
+static
+void
+globus_l_gfs_file_cksm_engine_progress_cb(
+    globus_off_t                        nbytes,
+    void *                              user_arg)
+{
+    globus_l_gfs_file_cksm_monitor_t *  monitor;
+    globus_bool_t                       send_marker = GLOBUS_FALSE;
+    char                                count[128];
+
+    monitor = (globus_l_gfs_file_cksm_monitor_t *) user_arg;
+
+    globus_mutex_lock(&monitor->lock);
+    {
+        monitor->total_bytes += nbytes;
+        if(monitor->send_marker)
+        {
+            monitor->send_marker = GLOBUS_FALSE;
+            send_marker = GLOBUS_TRUE;
+            sprintf(count, "%"GLOBUS_OFF_T_FORMAT, monitor->total_bytes);
+        }
+    }
+    globus_mutex_unlock(&monitor->lock);
+
+    if(send_marker)
+    {
+        globus_gridftp_server_intermediate_command(
+            monitor->op, GLOBUS_SUCCESS, count);
+    }
+}
+
+static
+void
+globus_l_gfs_file_cksm_engine_done_cb(
+    int                                 error,
+    const char *                        cksm,
+    void *                              user_arg)
+{
+    globus_l_gfs_file_cksm_monitor_t *  monitor;
+    globus_result_t                     result = GLOBUS_SUCCESS;
+    GlobusGFSName(globus_l_gfs_file_cksm_engine_done_cb);
+    GlobusGFSFileDebugEnter();
+
+    monitor = (globus_l_gfs_file_cksm_monitor_t *) user_arg;
+
+    if(error != 0)
+    {
+        result = GlobusGFSErrorSystemError("read", error);
+    }
+    else
+    {
+        globus_l_gfs_file_cksm_remember(monitor, cksm);
+    }
+
+    if(monitor->internal_cb)
+    {
+        monitor->internal_cb(
+            result, (char *) cksm, monitor->internal_cb_arg);
+    }
+    else
+    {
+        globus_gridftp_server_finished_command(
+            monitor->op, result, (char *) cksm);
+    }
+
+    /* a marker callback may be running; free once it is gone */
+    if(monitor->marker_handle)
+    {
+        globus_callback_unregister(
+            monitor->marker_handle,
+            globus_l_gfs_file_cksm_engine_free_cb,
+            monitor,
+            NULL);
+    }
+    else
+    {
+        globus_l_gfs_file_cksm_engine_free_cb(monitor);
+    }
+
+    GlobusGFSFileDebugExit();
+}
+
+/*
+ * threaded servers read the file with the checksum engine instead of xio so
+ * a single checksum can use more than one core and keep reads in flight.
+ */
+static
+globus_result_t
+globus_l_gfs_file_cksm_engine(
+    globus_gfs_operation_t              op,
+    const char *                        pathname,
+    const struct stat *                 stat_buf,
+    globus_gfs_file_cksm_type_t         cksum_type,
+    globus_off_t                        offset,
+    globus_off_t                        length,
+    globus_size_t                       block_size,
+    globus_l_gfs_file_cksm_cb_t         internal_cb,
+    void *                              internal_cb_arg)
+{
+    globus_l_gfs_file_cksm_monitor_t *  monitor;
+    globus_result_t                     result;
+    int                                 threads;
+    int                                 rc;
+    GlobusGFSName(globus_l_gfs_file_cksm_engine);
+    GlobusGFSFileDebugEnter();
+
+    monitor = (globus_l_gfs_file_cksm_monitor_t *) globus_calloc(
+        1, sizeof(globus_l_gfs_file_cksm_monitor_t) + strlen(pathname) + 1);
+    if(monitor == NULL)
+    {
+        result = GlobusGFSErrorMemory("checksum monitor");
+        goto error_mem;
+    }
+    globus_mutex_init(&monitor->lock, NULL);
+    monitor->pathname = (char *) monitor->buffer;
+    strcpy(monitor->pathname, pathname);
+    monitor->stat_buf = *stat_buf;
+    monitor->op = op;
+    monitor->offset = offset;
+    monitor->length = length;
+    monitor->block_size = block_size;
+    monitor->internal_cb = internal_cb;
+    monitor->internal_cb_arg = internal_cb_arg;
+    monitor->cksum_type = cksum_type;
+
+    threads = globus_gfs_config_get_int("cksm_threads");
+    if(threads <= 0)
+    {
+        threads = sysconf(_SC_NPROCESSORS_ONLN);
+        if(threads > GLOBUS_L_GFS_FILE_CKSM_MAX_THREADS)
+        {
+            threads = GLOBUS_L_GFS_FILE_CKSM_MAX_THREADS;
+        }
+        if(threads < 1)
+        {
+            threads = 1;
+        }
+    }
+
+    globus_l_gfs_file_cksm_start_markers(monitor);
+
+    rc = globus_gfs_file_cksm_compute(
+        pathname,
+        cksum_type,
+        offset,
+        length,
+        block_size,
+        threads,
+        globus_l_gfs_file_cksm_engine_progress_cb,
+        globus_l_gfs_file_cksm_engine_done_cb,
+        monitor);
+    if(rc != 0)
+    {
+        result = GlobusGFSErrorSystemError("open", rc);
+        goto error_compute;
+    }
+
+    GlobusGFSFileDebugExit();
+    return GLOBUS_SUCCESS;
+
+error_compute:
+    if(monitor->marker_handle)
+    {
+        globus_callback_unregister(
+            monitor->marker_handle,
+            globus_l_gfs_file_cksm_engine_free_cb,
+            monitor,
+            NULL);
+    }
+    else
+    {
+        globus_l_gfs_file_cksm_engine_free_cb(monitor);
+    }
+error_mem:
+    GlobusGFSFileDebugExitWithError();
+    return result;
+}
+
+static
+void
+globus_l_gfs_file_open_cksm_cb(
+    globus_xio_handle_t                 handle,
+    globus_result_t                     result,
+    void *                              user_arg)
+{  
+    globus_l_gfs_file_cksm_monitor_t *  monitor;
+    GlobusGFSName(globus_l_gfs_file_open_cksm_cb);
+    GlobusGFSFileDebugEnter();
+    
+    monitor = (globus_l_gfs_file_cksm_monitor_t *) user_arg;
+
+    if(result != GLOBUS_SUCCESS)
+    {
+        result = GlobusGFSErrorWrapFailed(
+            "open", result);
+        goto error_open;  
+    }  
+    
+    globus_l_gfs_file_cksm_start_markers(monitor);
     
     if(monitor->length >= 0)
     {
@@ -1979,8 +2207,7 @@ globus_l_gfs_file_open_cksm_cb(
         }
     }
     
-    MD5_Init(&monitor->mdctx);
-    monitor->adler32ctx = adler32(0, NULL, 0);
+    globus_gfs_file_cksm_init(&monitor->ctx, monitor->cksum_type);
     
     result = globus_xio_register_read(
         handle,
@@ -2036,6 +2263,9 @@ globus_l_gfs_file_cksm(
     globus_xio_handle_t                 file_handle;
     globus_l_gfs_file_cksm_monitor_t *  monitor;
     globus_size_t                       block_size;
+    globus_gfs_file_cksm_type_t         cksum_type;
+    struct stat                         stat_buf;
+    char                                cksm[GLOBUS_GFS_FILE_CKSM_MAX_LEN];
     int                                 timeout;
     GlobusGFSName(globus_l_gfs_file_cksm);
     GlobusGFSFileDebugEnter();
@@ -2046,12 +2276,59 @@ globus_l_gfs_file_cksm(
         goto param_error;
     }
 
-    if (strcasecmp(algorithm, "md5") && strcasecmp(algorithm, "adler32"))
+    cksum_type = globus_gfs_file_cksm_lookup(algorithm);
+    if(cksum_type == GLOBUS_GFS_FILE_CKSM_TYPE_NONE)
     {
         result = GlobusGFSErrorGeneric("Unknown checksum algorithm requested.");
         goto alg_error;
     }
 
+    /* the file may not have changed since we last checksummed it */
+    memset(&stat_buf, 0, sizeof(struct stat));
+    if(stat(pathname, &stat_buf) == 0 &&
+        globus_gfs_file_cksm_cache_lookup(
+            pathname, &stat_buf, cksum_type, offset, length, cksm))
+    {
+        globus_gfs_log_message(
+            GLOBUS_GFS_LOG_DUMP,
+            "Checksum of %s found in cache.\n", pathname);
+
+        if(internal_cb)
+        {
+            internal_cb(GLOBUS_SUCCESS, cksm, internal_cb_arg);
+        }
+        else
+        {
+            globus_gridftp_server_finished_command(op, GLOBUS_SUCCESS, cksm);
+        }
+
+        GlobusGFSFileDebugExit();
+        return GLOBUS_SUCCESS;
+    }
+
+    globus_gridftp_server_get_block_size(op, &block_size);
+
+    if(!globus_i_am_only_thread())
+    {
+        result = globus_l_gfs_file_cksm_engine(
+            op,
+            pathname,
+            &stat_buf,
+            cksum_type,
+            offset,
+            length,
+            block_size,
+            internal_cb,
+            internal_cb_arg);
+        if(result != GLOBUS_SUCCESS)
+        {
+            goto engine_error;
+        }
+
+        GlobusGFSFileDebugExit();
+        return GLOBUS_SUCCESS;
+    }
+
     result = globus_xio_attr_init(&attr);
     if(result != GLOBUS_SUCCESS)
     {
@@ -2114,15 +2391,17 @@ globus_l_gfs_file_cksm(
         goto error_create;
     }
 
-    globus_gridftp_server_get_block_size(op, &block_size);
-
     monitor = (globus_l_gfs_file_cksm_monitor_t *) globus_calloc(
-        1, sizeof(globus_l_gfs_file_cksm_monitor_t) + block_size);
+        1, sizeof(globus_l_gfs_file_cksm_monitor_t) + block_size + 
+            strlen(pathname) + 1);
     if(monitor == NULL)
     {
         result = GlobusGFSErrorMemory("cheksum buffer");
         goto error_mem;
     }
+    monitor->pathname = (char *) monitor->buffer + block_size;
+    strcpy(monitor->pathname, pathname);
+    monitor->stat_buf = stat_buf;
     
     monitor->op = op;
     monitor->offset = offset;
@@ -2131,15 +2410,7 @@ globus_l_gfs_file_cksm(
     monitor->internal_cb = internal_cb;
     monitor->internal_cb_arg = internal_cb_arg;
 
-    monitor->cksum_type = 0;
-    if(!strcasecmp("md5", algorithm))
-    {
-        monitor->cksum_type = GLOBUS_GFS_FILE_CKSM_TYPE_MD5;
-    }
-    else if(!strcasecmp("adler32", algorithm))
-    {
-        monitor->cksum_type = GLOBUS_GFS_FILE_CKSM_TYPE_ADLER32;
-    }
+    monitor->cksum_type = cksum_type;
 
     result = globus_xio_register_open(
         file_handle,
@@ -2174,6 +2445,7 @@ error_cntl:
     globus_xio_attr_destroy(attr);
     
 error_attr:
+engine_error:
 alg_error:
 param_error:
     GlobusGFSFileDebugExitWithError();
@@ -2280,6 +2552,72 @@ static
 globus_result_t
 globus_l_gfs_file_dispatch_write(
     globus_l_file_monitor_t *           monitor);
+
+static
+void
+globus_l_gfs_file_server_read_file_cb(
+    globus_gfs_operation_t              op,
+    globus_result_t                     result,
+    globus_byte_t *                     buffer,
+    globus_size_t                       nbytes,
+    globus_off_t                        offset,
+    globus_bool_t                       eof,
+    void *                              user_arg);
+
+/* Called LOCKED */
+static
+globus_result_t
+globus_l_gfs_file_register_read(
+    globus_l_file_monitor_t *           monitor)
+{
+    globus_byte_t *                     buffer;
+    globus_result_t                     result;
+    GlobusGFSName(globus_l_gfs_file_register_read);
+    GlobusGFSFileDebugEnter();
+
+    if(monitor->recv_fd != -1)
+    {
+        result = globus_gridftp_server_register_read_file(
+            monitor->op,
+            monitor->recv_fd,
+            monitor->block_size,
+            globus_l_gfs_file_server_read_file_cb,
+            monitor);
+        if(result == GLOBUS_SUCCESS)
+        {
+            monitor->pending_reads++;
+
+            GlobusGFSFileDebugExit();
+            return GLOBUS_SUCCESS;
+        }
+        /* the data channel can't write into the file, use buffers */
+        monitor->recv_fd = -1;
+    }
+
+    buffer = globus_memory_pop_node(&monitor->mem);
+    result = globus_gridftp_server_register_read(
+        monitor->op,
+        buffer,
+        monitor->block_size,
+        globus_l_gfs_file_server_read_cb,
+        monitor);
+    if(result != GLOBUS_SUCCESS)
+    {
+        globus_memory_push_node(&monitor->mem, buffer);
+        result = GlobusGFSErrorWrapFailed(
+            "globus_gridftp_server_register_read", result);
+        goto error_register;
+    }
+
+    monitor->pending_reads++;
+
+    GlobusGFSFileDebugExit();
+    return GLOBUS_SUCCESS;
+
+error_register:
+    GlobusGFSFileDebugExitWithError();
+    return result;
+}
     
 static
 void
@@ -2483,24 +2821,11 @@ globus_l_gfs_file_update_concurrency(
         monitor->optimal_count = optimal_count;
         while(extra-- > 0)
         {
-            globus_byte_t *             buffer;
-            
-            buffer = globus_memory_pop_node(&monitor->mem);
-            result = globus_gridftp_server_register_read(
-                monitor->op,
-                buffer,
-                monitor->block_size,
-                globus_l_gfs_file_server_read_cb,
-                monitor);
+            result = globus_l_gfs_file_register_read(monitor);
             if(result != GLOBUS_SUCCESS)
             {
-                globus_memory_push_node(&monitor->mem, buffer);
-                result = GlobusGFSErrorWrapFailed(
-                    "globus_gridftp_server_register_read", result);
                 goto error_register;
             }
-            
-            monitor->pending_reads++;
         }
     }
     
@@ -2524,11 +2849,19 @@ globus_l_gfs_file_server_read_cb(
 {
     globus_l_file_monitor_t *           monitor;
     globus_l_buffer_info_t *            buf_info;
+    globus_gfs_file_cksm_ctx_t          cksm_ctx;
     int                                 rc;
     GlobusGFSName(globus_l_gfs_file_server_read_cb);
     GlobusGFSFileDebugEnter();
     
     monitor = (globus_l_file_monitor_t *) user_arg;
+
+    /* hash each block as it arrives, in parallel with the other streams */
+    if(monitor->cksm_ranges != NULL && result == GLOBUS_SUCCESS)
+    {
+        globus_gfs_file_cksm_init(&cksm_ctx, monitor->cksm_type);
+        globus_gfs_file_cksm_update(&cksm_ctx, buffer, nbytes);
+    }
     
     globus_mutex_lock(&monitor->lock);
     {
@@ -2561,6 +2894,11 @@ globus_l_gfs_file_server_read_cb(
         buf_info->buffer = buffer;
         buf_info->offset = offset;
         buf_info->length = nbytes;
+        if(monitor->cksm_ranges != NULL)
+        {
+            globus_gfs_file_cksm_ranges_add(
+                monitor->cksm_ranges, offset, &cksm_ctx);
+        }
         monitor->concurrency_check--;
         if(monitor->concurrency_check == 0 && !eof)
         {
@@ -2612,6 +2950,90 @@ error:
     GlobusGFSFileDebugExitWithError();
 }
 
+/* the data channel has already put the data in the file */
+static
+void
+globus_l_gfs_file_server_read_file_cb(
+    globus_gfs_operation_t              op,
+    globus_result_t                     result,
+    globus_byte_t *                     buffer,
+    globus_size_t                       nbytes,
+    globus_off_t                        offset,
+    globus_bool_t                       eof,
+    void *                              user_arg)
+{
+    globus_l_file_monitor_t *           monitor;
+    GlobusGFSName(globus_l_gfs_file_server_read_file_cb);
+    GlobusGFSFileDebugEnter();
+    
+    monitor = (globus_l_file_monitor_t *) user_arg;
+    
+    globus_mutex_lock(&monitor->lock);
+    {
+        monitor->pending_reads--;
+        if(result != GLOBUS_SUCCESS && monitor->error == NULL)
+        {
+            monitor->error = GlobusGFSErrorObjWrapFailed("callback", result);
+        }
+        if(monitor->error != NULL)
+        {
+            goto error;
+        }
+        
+        if(eof)
+        {
+            monitor->eof = GLOBUS_TRUE;
+        }
+        if(nbytes > 0)
+        {
+            globus_gridftp_server_update_bytes_written(
+                monitor->op, offset, nbytes);
+        }
+        
+        monitor->concurrency_check--;
+        if(monitor->concurrency_check == 0 && !eof)
+        {
+            globus_l_gfs_file_update_concurrency(monitor);
+        }
+        
+        if(!monitor->eof && !monitor->aborted)
+        {
+            result = globus_l_gfs_file_register_read(monitor);
+            if(result != GLOBUS_SUCCESS)
+            {
+                monitor->error = GlobusGFSErrorObjWrapFailed(
+                    "globus_l_gfs_file_register_read", result);
+                goto error;
+            }
+        }
+        
+        if(monitor->pending_reads == 0 && monitor->pending_writes == 0)
+        {
+            globus_assert(monitor->eof || monitor->aborted);
+
+            globus_l_gfs_file_close(monitor, GLOBUS_SUCCESS);
+        }
+    }
+    globus_mutex_unlock(&monitor->lock);
+    
+    GlobusGFSFileDebugExit();
+    return;
+    
+error:
+    if(monitor->pending_reads != 0 || monitor->pending_writes != 0)
+    {
+        /* there are still outstanding callbacks, wait for them */
+        globus_mutex_unlock(&monitor->lock);
+
+        GlobusGFSFileDebugExitWithError();
+        return;
+    }
+    globus_l_gfs_file_close(monitor, globus_error_put(monitor->error));
+    globus_mutex_unlock(&monitor->lock);
+
+    GlobusGFSFileDebugExitWithError();
+}
+
 static
 void
 globus_l_gfs_file_open_write_cb(
@@ -2620,6 +3042,9 @@ globus_l_gfs_file_open_write_cb(
     void *                              user_arg)
 {
     globus_l_file_monitor_t *           monitor;
+    globus_list_t *                     driver_list;
+    globus_xio_system_file_t            fd;
+    struct stat                         stat_buf;
     GlobusGFSName(globus_l_gfs_file_open_write_cb);
     GlobusGFSFileDebugEnter();
     
@@ -2634,34 +3059,34 @@ globus_l_gfs_file_open_write_cb(
 
     globus_gridftp_server_begin_transfer(
         monitor->op, GLOBUS_GFS_EVENT_TRANSFER_ABORT, monitor);
+
+    /* a plain file can be written straight from the data channel, unless
+       the data has to pass through our buffers to be checksummed */
+    globus_gfs_data_get_file_stack_list(monitor->op, &driver_list);
+    if(driver_list == NULL && monitor->cksm_ranges == NULL &&
+        globus_xio_handle_cntl(
+            handle,
+            globus_l_gfs_file_driver,
+            GLOBUS_XIO_FILE_GET_HANDLE,
+            &fd) == GLOBUS_SUCCESS &&
+        fstat(fd, &stat_buf) == 0 && S_ISREG(stat_buf.st_mode))
+    {
+        monitor->recv_fd = fd;
+    }
+    globus_list_free(driver_list);
     
     globus_mutex_lock(&monitor->lock);
     {
         int                             optimal_count;
-        globus_size_t                   block_size;
         
         optimal_count = monitor->optimal_count;
-        block_size = monitor->block_size;
         while(optimal_count--)
         {
-            globus_byte_t *             buffer;
-            
-            buffer = globus_memory_pop_node(&monitor->mem);
-            result = globus_gridftp_server_register_read(
-                monitor->op,
-                buffer,
-                block_size,
-                globus_l_gfs_file_server_read_cb,
-                monitor);
+            result = globus_l_gfs_file_register_read(monitor);
             if(result != GLOBUS_SUCCESS)
             {
-                globus_memory_push_node(&monitor->mem, buffer);
-                result = GlobusGFSErrorWrapFailed(
-                    "globus_gridftp_server_register_read", result);
                 goto error_register;
             }
-            
-            monitor->pending_reads++;
         }
     }
     globus_mutex_unlock(&monitor->lock);
@@ -2865,6 +3290,7 @@ globus_l_gfs_file_recv(
     globus_xio_file_flag_t              open_flags;
     globus_off_t                        offset;
     globus_off_t                        length;
+    char *                              inline_cksm;
     GlobusGFSName(globus_l_gfs_file_recv);
     GlobusGFSFileDebugEnter();
 
@@ -2918,6 +3344,24 @@ globus_l_gfs_file_recv(
         monitor->expected_cksm_alg = 
             globus_libc_strdup(transfer_info->expected_checksum_alg);
     }
+
+    inline_cksm = globus_gfs_config_get_string("inline_cksm");
+    if(inline_cksm != NULL)
+    {
+        monitor->cksm_type = globus_gfs_file_cksm_lookup(inline_cksm);
+        if(globus_gfs_file_cksm_mergeable(monitor->cksm_type))
+        {
+            monitor->cksm_ranges =
+                globus_gfs_file_cksm_ranges_create(monitor->cksm_type);
+        }
+        else
+        {
+            globus_gfs_log_message(
+                GLOBUS_GFS_LOG_WARN,
+                "Inline checksums need adler32 or crc32c, not %s.\n",
+                inline_cksm);
+        }
+    }
     
     result = globus_l_gfs_file_open(
         &monitor->file_handle, transfer_info->pathname, open_flags, monitor);
@@ -2954,6 +3398,112 @@ globus_l_gfs_file_read_cb(
     globus_xio_data_descriptor_t        data_desc,
     void *                              user_arg);
     
+static
+void
+globus_l_gfs_file_server_write_cb(
+    globus_gfs_operation_t              op,
+    globus_result_t                     result,
+    globus_byte_t *                     buffer,
+    globus_size_t                       nbytes,
+    void *                              user_arg);
+
+/*
+ * have the data channel send the file itself, keeping optimal_count writes
+ * outstanding.  if it can't, the xio handle is moved to where sending
+ * stopped so the buffered reads can take over.
+ *
+ * called LOCKED
+ */
+static
+globus_result_t
+globus_l_gfs_file_dispatch_send(
+    globus_l_file_monitor_t *           monitor)
+{
+    globus_result_t                     result;
+    globus_off_t                        send_length;
+    GlobusGFSName(globus_l_gfs_file_dispatch_send);
+    GlobusGFSFileDebugEnter();
+
+    while(monitor->pending_writes < monitor->optimal_count &&
+        !monitor->eof && !monitor->aborted)
+    {
+        if(monitor->first_read)
+        {
+            globus_gridftp_server_get_read_range(
+                monitor->op,
+                &monitor->read_offset,
+                &monitor->read_length);
+            if(monitor->read_length == 0)
+            {
+                monitor->eof = GLOBUS_TRUE;
+            }
+            monitor->file_offset = monitor->read_offset;
+            monitor->first_read = GLOBUS_FALSE;
+            continue;
+        }
+
+        send_length = monitor->block_size;
+        if(monitor->read_length != -1 && monitor->read_length < send_length)
+        {
+            send_length = monitor->read_length;
+        }
+        if(monitor->send_size - monitor->file_offset < send_length)
+        {
+            send_length = monitor->send_size - monitor->file_offset;
+        }
+        if(send_length <= 0)
+        {
+            monitor->eof = GLOBUS_TRUE;
+            break;
+        }
+
+        result = globus_gridftp_server_register_write_file(
+            monitor->op,
+            monitor->send_fd,
+            monitor->file_offset,
+            send_length,
+            monitor->file_offset,
+            globus_l_gfs_file_server_write_cb,
+            monitor);
+        if(result != GLOBUS_SUCCESS)
+        {
+            goto error_register;
+        }
+
+        monitor->pending_writes++;
+        monitor->file_offset += send_length;
+        if(monitor->read_length != -1)
+        {
+            monitor->read_length -= send_length;
+            if(monitor->read_length == 0)
+            {
+                monitor->first_read = GLOBUS_TRUE;
+            }
+        }
+    }
+
+    GlobusGFSFileDebugExit();
+    return GLOBUS_SUCCESS;
+
+error_register:
+    monitor->send_fd = -1;
+    result = globus_xio_handle_cntl(
+        monitor->file_handle,
+        GLOBUS_XIO_QUERY,
+        GLOBUS_XIO_SEEK,
+        monitor->file_offset,
+        GLOBUS_XIO_FILE_SEEK_SET);
+    if(result != GLOBUS_SUCCESS)
+    {
+        result = GlobusGFSErrorWrapFailed("globus_xio_handle_cntl", result);
+        GlobusGFSFileDebugExitWithError();
+        return result;
+    }
+
+    GlobusGFSFileDebugExit();
+    return GLOBUS_SUCCESS;
+}
+
 /* called LOCKED */
 static
 globus_result_t
@@ -2966,6 +3516,16 @@ globus_l_gfs_file_dispatch_read(
     GlobusGFSName(globus_l_gfs_file_dispatch_read);
     GlobusGFSFileDebugEnter();
     
+    if(monitor->send_fd != -1)
+    {
+        result = globus_l_gfs_file_dispatch_send(monitor);
+        if(result != GLOBUS_SUCCESS || monitor->send_fd != -1)
+        {
+            GlobusGFSFileDebugExit();
+            return result;
+        }
+    }
+
     if(monitor->first_read && monitor->pending_reads == 0 && 
         !monitor->eof && !globus_list_empty(monitor->buffer_list) &&
         !monitor->aborted)
@@ -3068,7 +3628,11 @@ globus_l_gfs_file_server_write_cb(
     globus_mutex_lock(&monitor->lock);
     { 
         monitor->pending_writes--;
-        globus_list_insert(&monitor->buffer_list, buffer);
+        /* writes sent straight from the file have no buffer */
+        if(buffer != NULL)
+        {
+            globus_list_insert(&monitor->buffer_list, buffer);
+        }
 
         if(result != GLOBUS_SUCCESS && monitor->error == NULL)
         {
@@ -3239,6 +3803,9 @@ globus_l_gfs_file_open_read_cb(
     void *                              user_arg)
 {
     globus_l_file_monitor_t *           monitor;
+    globus_list_t *                     driver_list;
+    globus_xio_system_file_t            fd;
+    struct stat                         stat_buf;
     GlobusGFSName(globus_l_gfs_file_open_read_cb);
     GlobusGFSFileDebugEnter();
     
@@ -3253,6 +3820,21 @@ globus_l_gfs_file_open_read_cb(
     
     globus_gridftp_server_begin_transfer(
         monitor->op, GLOBUS_GFS_EVENT_TRANSFER_ABORT, monitor);
+
+    /* a plain file can go out without being read into our buffers */
+    globus_gfs_data_get_file_stack_list(monitor->op, &driver_list);
+    if(driver_list == NULL &&
+        globus_xio_handle_cntl(
+            handle,
+            globus_l_gfs_file_driver,
+            GLOBUS_XIO_FILE_GET_HANDLE,
+            &fd) == GLOBUS_SUCCESS &&
+        fstat(fd, &stat_buf) == 0 && S_ISREG(stat_buf.st_mode))
+    {
+        monitor->send_fd = fd;
+        monitor->send_size = stat_buf.st_size;
+    }
+    globus_list_free(driver_list);
     
     globus_mutex_lock(&monitor->lock);
     monitor->first_read = GLOBUS_TRUE;
@@ -3392,6 +3974,7 @@ globus_l_gfs_file_init(
     globus_gfs_session_info_t *         session_info)
 {
     gfs_l_file_session_t *              session_h;
+    int                                 rc;
     GlobusGFSName(globus_l_gfs_file_send);
     GlobusGFSFileDebugEnter();
 
@@ -3402,6 +3985,17 @@ globus_l_gfs_file_init(
     session_h->username = globus_libc_strdup(session_info->username);
     session_h->pw = globus_libc_strdup(session_info->password);
 
+    rc = globus_gfs_file_cksm_cache_configure(
+        globus_gfs_config_get_string("cksm_cache"));
+    if(rc != 0)
+    {
+        globus_gfs_log_message(
+            GLOBUS_GFS_LOG_WARN,
+            "Checksum cache %s unavailable: %s\n",
+            globus_gfs_config_get_string("cksm_cache"),
+            strerror(rc));
+    }
+
     /* just make it so we can get the cred. */
     globus_gridftp_server_finished_session_start(
         op,
@@ -3419,8 +4013,18 @@ globus_l_gfs_file_destroy(
     void *                              user_arg)
 {
     gfs_l_file_session_t *              session_h;
+    int                                 hits;
+    int                                 misses;
     session_h = (gfs_l_file_session_t *) user_arg;
 
+    globus_gfs_file_cksm_cache_stats(&hits, &misses);
+    if(hits + misses > 0)
+    {
+        globus_gfs_log_message(
+            GLOBUS_GFS_LOG_INFO,
+            "Checksum cache: %d hits, %d misses.\n", hits, misses);
+    }
+
     if(session_h)
     {
         if(session_h->sbj != NULL)
@@ -0,0 +1,1899 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "globus_gridftp_server_file_cksm.h"
+#include <zlib.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#if defined(HAVE_SYS_XATTR_H) && defined(__linux__)
+#include <sys/xattr.h>
+#define GLOBUS_L_GFS_FILE_CKSM_XATTR    "user.globus.cksm"
+#endif
+
+#ifndef MAXPATHLEN
+#define MAXPATHLEN 4096
+#endif
+
+#ifndef O_NOFOLLOW
+#define O_NOFOLLOW 0
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define GLOBUS_L_GFS_FILE_CKSM_X86 1
+#endif
+
+/* crc32c (Castagnoli), reflected */
+#define GLOBUS_L_GFS_FILE_CRC32C_POLY   0x82F63B78
+
+/* regions handed to separate threads are at least this many blocks */
+#define GLOBUS_L_GFS_FILE_CKSM_MIN_REGION_BLOCKS 16
+
+/* buffers read ahead of the hasher for unmergeable algorithms */
+#define GLOBUS_L_GFS_FILE_CKSM_READ_AHEAD 4
+
+/* files remembered by the checksum cache */
+#define GLOBUS_L_GFS_FILE_CKSM_CACHE_MAX 1024
+
+/* bytes of persistent records kept for one file */
+#define GLOBUS_L_GFS_FILE_CKSM_STORE_MAX 4096
+
+typedef enum
+{
+    GLOBUS_L_GFS_FILE_CKSM_STORE_NONE = 0,
+    GLOBUS_L_GFS_FILE_CKSM_STORE_XATTR,
+    GLOBUS_L_GFS_FILE_CKSM_STORE_DIR
+} globus_l_gfs_file_cksm_store_t;
+
+typedef struct globus_l_gfs_file_cksm_range_s
+{
+    struct globus_l_gfs_file_cksm_range_s * next;
+    globus_off_t                        offset;
+    globus_gfs_file_cksm_ctx_t          ctx;
+} globus_l_gfs_file_cksm_range_t;
+
+struct globus_gfs_file_cksm_ranges_s
+{
+    globus_gfs_file_cksm_type_t         type;
+    /* sorted by offset, never adjacent */
+    globus_l_gfs_file_cksm_range_t *    head;
+    /* set when a byte was added twice */
+    globus_bool_t                       overlap;
+};
+
+typedef struct
+{
+    char *                              pathname;
+    dev_t                               dev;
+    ino_t                               ino;
+    globus_off_t                        size;
+    time_t                              mtime;
+    long                                mtime_nsec;
+    char *                              cksm[GLOBUS_GFS_FILE_CKSM_TYPE_SHA256 + 1];
+} globus_l_gfs_file_cksm_cache_entry_t;
+
+typedef struct globus_l_gfs_file_cksm_job_s globus_l_gfs_file_cksm_job_t;
+
+typedef struct
+{
+    globus_l_gfs_file_cksm_job_t *      job;
+    globus_off_t                        offset;
+    globus_off_t                        length;
+    globus_gfs_file_cksm_ctx_t          ctx;
+} globus_l_gfs_file_cksm_region_t;
+
+struct globus_l_gfs_file_cksm_job_s
+{
+    globus_mutex_t                      lock;
+    globus_cond_t                       cond;
+    int                                 fd;
+    globus_gfs_file_cksm_type_t         type;
+    globus_off_t                        offset;
+    globus_off_t                        length;
+    globus_size_t                       block_size;
+    globus_gfs_file_cksm_progress_cb_t  progress_cb;
+    globus_gfs_file_cksm_done_cb_t      done_cb;
+    void *                              user_arg;
+    int                                 error;
+    int                                 workers;
+
+    /* mergeable algorithms: one region per worker */
+    globus_l_gfs_file_cksm_region_t *   regions;
+    int                                 region_count;
+
+    /* otherwise a reader filling a ring of buffers for a hasher */
+    globus_gfs_file_cksm_ctx_t          ctx;
+    globus_byte_t *                     buffers[GLOBUS_L_GFS_FILE_CKSM_READ_AHEAD];
+    globus_ssize_t                      lengths[GLOBUS_L_GFS_FILE_CKSM_READ_AHEAD];
+    int                                 head;
+    int                                 filled;
+};
+
+typedef uint32_t
+(*globus_l_gfs_file_crc32c_func_t)(
+    uint32_t                            crc,
+    const unsigned char *               buf,
+    globus_size_t                       len);
+
+typedef uint32_t
+(*globus_l_gfs_file_adler32_func_t)(
+    uint32_t                            adler,
+    const unsigned char *               buf,
+    globus_size_t                       len);
+
+static globus_thread_once_t             globus_l_gfs_file_cksm_once =
+    GLOBUS_THREAD_ONCE_INIT;
+static uint32_t                         globus_l_gfs_file_crc32c_table[8][256];
+static globus_l_gfs_file_crc32c_func_t  globus_l_gfs_file_crc32c_func;
+static globus_l_gfs_file_adler32_func_t globus_l_gfs_file_adler32_func;
+static globus_mutex_t                   globus_l_gfs_file_cksm_cache_lock;
+static globus_hashtable_t               globus_l_gfs_file_cksm_cache;
+static int                              globus_l_gfs_file_cksm_cache_hits;
+static int                              globus_l_gfs_file_cksm_cache_misses;
+static globus_l_gfs_file_cksm_store_t   globus_l_gfs_file_cksm_store;
+static char *                           globus_l_gfs_file_cksm_store_dir;
+
+static
+uint32_t
+globus_l_gfs_file_crc32c_sw(
+    uint32_t                            crc,
+    const unsigned char *               buf,
+    globus_size_t                       len)
+{
+    uint32_t                            c;
+    uint32_t                            w1;
+    uint32_t                            w2;
+
+    c = ~crc;
+    while(len && ((uintptr_t) buf & 3))
+    {
+        c = globus_l_gfs_file_crc32c_table[0][(c ^ *buf++) & 0xff] ^ (c >> 8);
+        len--;
+    }
+    /* slicing-by-8 */
+    while(len >= 8)
+    {
+        w1 = buf[0] | buf[1] << 8 | buf[2] << 16 | (uint32_t) buf[3] << 24;
+        w2 = buf[4] | buf[5] << 8 | buf[6] << 16 | (uint32_t) buf[7] << 24;
+        w1 ^= c;
+        c = globus_l_gfs_file_crc32c_table[7][w1 & 0xff] ^
+            globus_l_gfs_file_crc32c_table[6][(w1 >> 8) & 0xff] ^
+            globus_l_gfs_file_crc32c_table[5][(w1 >> 16) & 0xff] ^
+            globus_l_gfs_file_crc32c_table[4][w1 >> 24] ^
+            globus_l_gfs_file_crc32c_table[3][w2 & 0xff] ^
+            globus_l_gfs_file_crc32c_table[2][(w2 >> 8) & 0xff] ^
+            globus_l_gfs_file_crc32c_table[1][(w2 >> 16) & 0xff] ^
+            globus_l_gfs_file_crc32c_table[0][w2 >> 24];
+        buf += 8;
+        len -= 8;
+    }
+    while(len--)
+    {
+        c = globus_l_gfs_file_crc32c_table[0][(c ^ *buf++) & 0xff] ^ (c >> 8);
+    }
+
+    return ~c;
+}
+
+static
+uint32_t
+globus_l_gfs_file_adler32_zlib(
+    uint32_t                            adler,
+    const unsigned char *               buf,
+    globus_size_t                       len)
+{
+    globus_size_t                       n;
+
+    /* zlib takes a uInt length */
+    while(len > 0)
+    {
+        n = len > (1U << 30) ? (1U << 30) : len;
+        adler = adler32(adler, buf, n);
+        buf += n;
+        len -= n;
+    }
+
+    return adler;
+}
+
+#ifdef GLOBUS_L_GFS_FILE_CKSM_X86
+__attribute__((target("sse4.2")))
+static
+uint32_t
+globus_l_gfs_file_crc32c_sse42(
+    uint32_t                            crc,
+    const unsigned char *               buf,
+    globus_size_t                       len)
+{
+    uint32_t                            c;
+
+    c = ~crc;
+    while(len && ((uintptr_t) buf & 7))
+    {
+        c = _mm_crc32_u8(c, *buf++);
+        len--;
+    }
+#ifdef __x86_64__
+    while(len >= 8)
+    {
+        c = (uint32_t) _mm_crc32_u64(c, *(const uint64_t *) buf);
+        buf += 8;
+        len -= 8;
+    }
+#endif
+    while(len >= 4)
+    {
+        c = _mm_crc32_u32(c, *(const uint32_t *) buf);
+        buf += 4;
+        len -= 4;
+    }
+    while(len--)
+    {
+        c = _mm_crc32_u8(c, *buf++);
+    }
+
+    return ~c;
+}
+
+/*
+ * adler32 over 32 byte blocks: s1 gathers byte sums with psadbw and s2 the
+ * position weighted sums with pmaddubsw.  5536 bytes between reductions
+ * keeps every lane below 2^32, as NMAX does for the scalar loop.
+ */
+__attribute__((target("ssse3")))
+static
+uint32_t
+globus_l_gfs_file_adler32_ssse3(
+    uint32_t                            adler,
+    const unsigned char *               buf,
+    globus_size_t                       len)
+{
+    uint32_t                            s1 = adler & 0xffff;
+    uint32_t                            s2 = adler >> 16;
+    globus_size_t                       blocks;
+    unsigned                            n;
+    __m128i                             tap1;
+    __m128i                             tap2;
+    __m128i                             zero;
+    __m128i                             ones;
+    __m128i                             v_ps;
+    __m128i                             v_s1;
+    __m128i                             v_s2;
+    __m128i                             bytes1;
+    __m128i                             bytes2;
+
+    tap1 = _mm_setr_epi8(
+        32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17);
+    tap2 = _mm_setr_epi8(
+        16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+    zero = _mm_setzero_si128();
+    ones = _mm_set1_epi16(1);
+
+    blocks = len / 32;
+    len -= blocks * 32;
+    while(blocks)
+    {
+        n = 5552 / 32;
+        if(n > blocks)
+        {
+            n = blocks;
+        }
+        blocks -= n;
+
+        v_ps = _mm_set_epi32(0, 0, 0, s1 * n);
+        v_s2 = _mm_set_epi32(0, 0, 0, s2);
+        v_s1 = _mm_setzero_si128();
+        do
+        {
+            bytes1 = _mm_loadu_si128((const __m128i *) buf);
+            bytes2 = _mm_loadu_si128((const __m128i *) (buf + 16));
+            v_ps = _mm_add_epi32(v_ps, v_s1);
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes1, zero));
+            v_s2 = _mm_add_epi32(v_s2,
+                _mm_madd_epi16(_mm_maddubs_epi16(bytes1, tap1), ones));
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes2, zero));
+            v_s2 = _mm_add_epi32(v_s2,
+                _mm_madd_epi16(_mm_maddubs_epi16(bytes2, tap2), ones));
+            buf += 32;
+        } while(--n);
+        v_s2 = _mm_add_epi32(v_s2, _mm_slli_epi32(v_ps, 5));
+
+        v_s1 = _mm_add_epi32(v_s1,
+            _mm_shuffle_epi32(v_s1, _MM_SHUFFLE(2, 3, 0, 1)));
+        v_s1 = _mm_add_epi32(v_s1,
+            _mm_shuffle_epi32(v_s1, _MM_SHUFFLE(1, 0, 3, 2)));
+        s1 += (uint32_t) _mm_cvtsi128_si32(v_s1);
+        v_s2 = _mm_add_epi32(v_s2,
+            _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(2, 3, 0, 1)));
+        v_s2 = _mm_add_epi32(v_s2,
+            _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(1, 0, 3, 2)));
+        s2 = (uint32_t) _mm_cvtsi128_si32(v_s2);
+
+        s1 %= 65521;
+        s2 %= 65521;
+    }
+    if(len)
+    {
+        while(len--)
+        {
+            s1 += *buf++;
+            s2 += s1;
+        }
+        s1 %= 65521;
+        s2 %= 65521;
+    }
+
+    return s1 | (s2 << 16);
+}
+#endif
+
+static
+void
+globus_l_gfs_file_cksm_once_init(void)
+{
+    uint32_t                            c;
+    int                                 i;
+    int                                 j;
+
+    for(i = 0; i < 256; i++)
+    {
+        c = i;
+        for(j = 0; j < 8; j++)
+        {
+            c = (c & 1) ? (c >> 1) ^ GLOBUS_L_GFS_FILE_CRC32C_POLY : c >> 1;
+        }
+        globus_l_gfs_file_crc32c_table[0][i] = c;
+    }
+    for(i = 0; i < 256; i++)
+    {
+        c = globus_l_gfs_file_crc32c_table[0][i];
+        for(j = 1; j < 8; j++)
+        {
+            c = globus_l_gfs_file_crc32c_table[0][c & 0xff] ^ (c >> 8);
+            globus_l_gfs_file_crc32c_table[j][i] = c;
+        }
+    }
+
+    globus_mutex_init(&globus_l_gfs_file_cksm_cache_lock, NULL);
+    globus_hashtable_init(
+        &globus_l_gfs_file_cksm_cache,
+        64,
+        globus_hashtable_string_hash,
+        globus_hashtable_string_keyeq);
+
+    globus_l_gfs_file_crc32c_func = globus_l_gfs_file_crc32c_sw;
+    globus_l_gfs_file_adler32_func = globus_l_gfs_file_adler32_zlib;
+#ifdef GLOBUS_L_GFS_FILE_CKSM_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("sse4.2"))
+    {
+        globus_l_gfs_file_crc32c_func = globus_l_gfs_file_crc32c_sse42;
+    }
+    if(__builtin_cpu_supports("ssse3"))
+    {
+        globus_l_gfs_file_adler32_func = globus_l_gfs_file_adler32_ssse3;
+    }
+#endif
+}
+
+/* GF(2) matrix helpers for crc32c_combine, as in zlib's crc32_combine */
+static
+uint32_t
+globus_l_gfs_file_gf2_times(
+    const uint32_t *                    mat,
+    uint32_t                            vec)
+{
+    uint32_t                            sum = 0;
+
+    while(vec)
+    {
+        if(vec & 1)
+        {
+            sum ^= *mat;
+        }
+        vec >>= 1;
+        mat++;
+    }
+
+    return sum;
+}
+
+static
+void
+globus_l_gfs_file_gf2_square(
+    uint32_t *                          square,
+    const uint32_t *                    mat)
+{
+    int                                 n;
+
+    for(n = 0; n < 32; n++)
+    {
+        square[n] = globus_l_gfs_file_gf2_times(mat, mat[n]);
+    }
+}
+
+static
+uint32_t
+globus_l_gfs_file_crc32c_combine(
+    uint32_t                            crc1,
+    uint32_t                            crc2,
+    globus_off_t                        len2)
+{
+    uint32_t                            even[32];
+    uint32_t                            odd[32];
+    uint32_t                            row;
+    int                                 n;
+
+    if(len2 <= 0)
+    {
+        return crc1;
+    }
+
+    /* operator for one zero bit */
+    odd[0] = GLOBUS_L_GFS_FILE_CRC32C_POLY;
+    row = 1;
+    for(n = 1; n < 32; n++)
+    {
+        odd[n] = row;
+        row <<= 1;
+    }
+    globus_l_gfs_file_gf2_square(even, odd);
+    globus_l_gfs_file_gf2_square(odd, even);
+
+    /* apply len2 zero bytes to crc1 */
+    do
+    {
+        globus_l_gfs_file_gf2_square(even, odd);
+        if(len2 & 1)
+        {
+            crc1 = globus_l_gfs_file_gf2_times(even, crc1);
+        }
+        len2 >>= 1;
+        if(len2 == 0)
+        {
+            break;
+        }
+        globus_l_gfs_file_gf2_square(odd, even);
+        if(len2 & 1)
+        {
+            crc1 = globus_l_gfs_file_gf2_times(odd, crc1);
+        }
+        len2 >>= 1;
+    } while(len2 != 0);
+
+    return crc1 ^ crc2;
+}
+
+globus_gfs_file_cksm_type_t
+globus_gfs_file_cksm_lookup(
+    const char *                        algorithm)
+{
+    if(strcasecmp("md5", algorithm) == 0)
+    {
+        return GLOBUS_GFS_FILE_CKSM_TYPE_MD5;
+    }
+    if(strcasecmp("adler32", algorithm) == 0)
+    {
+        return GLOBUS_GFS_FILE_CKSM_TYPE_ADLER32;
+    }
+    if(strcasecmp("crc32c", algorithm) == 0)
+    {
+        return GLOBUS_GFS_FILE_CKSM_TYPE_CRC32C;
+    }
+    if(strcasecmp("sha256", algorithm) == 0 ||
+        strcasecmp("sha-256", algorithm) == 0)
+    {
+        return GLOBUS_GFS_FILE_CKSM_TYPE_SHA256;
+    }
+
+    return GLOBUS_GFS_FILE_CKSM_TYPE_NONE;
+}
+
+globus_bool_t
+globus_gfs_file_cksm_mergeable(
+    globus_gfs_file_cksm_type_t         type)
+{
+    return type == GLOBUS_GFS_FILE_CKSM_TYPE_ADLER32 ||
+        type == GLOBUS_GFS_FILE_CKSM_TYPE_CRC32C;
+}
+
+void
+globus_gfs_file_cksm_init(
+    globus_gfs_file_cksm_ctx_t *        ctx,
+    globus_gfs_file_cksm_type_t         type)
+{
+    globus_thread_once(
+        &globus_l_gfs_file_cksm_once, globus_l_gfs_file_cksm_once_init);
+
+    memset(ctx, 0, sizeof(globus_gfs_file_cksm_ctx_t));
+    ctx->type = type;
+    switch(type)
+    {
+        case GLOBUS_GFS_FILE_CKSM_TYPE_MD5:
+            MD5_Init(&ctx->u.md5);
+            break;
+        case GLOBUS_GFS_FILE_CKSM_TYPE_SHA256:
+            SHA256_Init(&ctx->u.sha256);
+            break;
+        case GLOBUS_GFS_FILE_CKSM_TYPE_ADLER32:
+            ctx->u.adler32 = adler32(0, NULL, 0);
+            break;
+        case GLOBUS_GFS_FILE_CKSM_TYPE_CRC32C:
+            ctx->u.crc32c = 0;
+            break;
+        default:
+            break;
+    }
+}
+
+void
+globus_gfs_file_cksm_update(
+    globus_gfs_file_cksm_ctx_t *        ctx,
+    const void *                        buffer,
+    globus_size_t                       length)
+{
+    switch(ctx->type)
+    {
+        case GLOBUS_GFS_FILE_CKSM_TYPE_MD5:
+            MD5_Update(&ctx->u.md5, buffer, length);
+            break;
+        case GLOBUS_GFS_FILE_CKSM_TYPE_SHA256:
+            /* openssl picks up the sha extensions when the cpu has them */
+            SHA256_Update(&ctx->u.sha256, buffer, length);
+            break;
+        case GLOBUS_GFS_FILE_CKSM_TYPE_ADLER32:
+            ctx->u.adler32 = globus_l_gfs_file_adler32_func(
+                ctx->u.adler32, buffer, length);
+            break;
+        case GLOBUS_GFS_FILE_CKSM_TYPE_CRC32C:
+            ctx->u.crc32c = globus_l_gfs_file_crc32c_func(
+                ctx->u.crc32c, buffer, length);
+            break;
+        default:
+            break;
+    }
+    ctx->length += length;
+}
+
+void
+globus_gfs_file_cksm_merge(
+    globus_gfs_file_cksm_ctx_t *        ctx,
+    const globus_gfs_file_cksm_ctx_t *  next)
+{
+    switch(ctx->type)
+    {
+        case GLOBUS_GFS_FILE_CKSM_TYPE_ADLER32:
+            ctx->u.adler32 = adler32_combine(
+                ctx->u.adler32, next->u.adler32, (z_off_t) next->length);
+            break;
+        case GLOBUS_GFS_FILE_CKSM_TYPE_CRC32C:
+            ctx->u.crc32c = globus_l_gfs_file_crc32c_combine(
+                ctx->u.crc32c, next->u.crc32c, next->length);
+            break;
+        default:
+            globus_assert(0 && "checksum type can not be merged");
+            break;
+    }
+    ctx->length += next->length;
+}
+
+void
+globus_gfs_file_cksm_final(
+    globus_gfs_file_cksm_ctx_t *        ctx,
+    char *                              out)
+{
+    unsigned char                       md[SHA256_DIGEST_LENGTH];
+    int                                 len = 0;
+    int                                 i;
+
+    switch(ctx->type)
+    {
+        case GLOBUS_GFS_FILE_CKSM_TYPE_MD5:
+            MD5_Final(md, &ctx->u.md5);
+            len = MD5_DIGEST_LENGTH;
+            break;
+        case GLOBUS_GFS_FILE_CKSM_TYPE_SHA256:
+            SHA256_Final(md, &ctx->u.sha256);
+            len = SHA256_DIGEST_LENGTH;
+            break;
+        case GLOBUS_GFS_FILE_CKSM_TYPE_ADLER32:
+            sprintf(out, "%08x", ctx->u.adler32);
+            return;
+        case GLOBUS_GFS_FILE_CKSM_TYPE_CRC32C:
+            sprintf(out, "%08x", ctx->u.crc32c);
+            return;
+        default:
+            break;
+    }
+
+    for(i = 0; i < len; i++)
+    {
+        sprintf(&out[i * 2], "%02x", md[i]);
+    }
+    out[len * 2] = '\0';
+}
+
+static
+int
+globus_l_gfs_file_cksm_pread(
+    int                                 fd,
+    globus_byte_t *                     buffer,
+    globus_size_t                       length,
+    globus_off_t                        offset,
+    globus_ssize_t *                    nbytes)
+{
+    globus_ssize_t                      rc;
+
+    do
+    {
+        rc = pread(fd, buffer, length, offset);
+    } while(rc < 0 && errno == EINTR);
+
+    if(rc < 0)
+    {
+        return errno;
+    }
+    *nbytes = rc;
+
+    return 0;
+}
+
+static
+void
+globus_l_gfs_file_cksm_job_finish(
+    globus_l_gfs_file_cksm_job_t *      job)
+{
+    globus_gfs_file_cksm_ctx_t          ctx;
+    char                                cksm[GLOBUS_GFS_FILE_CKSM_MAX_LEN];
+    int                                 i;
+
+    if(job->error == 0)
+    {
+        if(job->regions)
+        {
+            ctx = job->regions[0].ctx;
+            for(i = 1; i < job->region_count; i++)
+            {
+                globus_gfs_file_cksm_merge(&ctx, &job->regions[i].ctx);
+            }
+            globus_gfs_file_cksm_final(&ctx, cksm);
+        }
+        else
+        {
+            globus_gfs_file_cksm_final(&job->ctx, cksm);
+        }
+    }
+
+    close(job->fd);
+    job->done_cb(job->error, job->error ? NULL : cksm, job->user_arg);
+
+    for(i = 0; i < GLOBUS_L_GFS_FILE_CKSM_READ_AHEAD; i++)
+    {
+        if(job->buffers[i])
+        {
+            globus_free(job->buffers[i]);
+        }
+    }
+    if(job->regions)
+    {
+        globus_free(job->regions);
+    }
+    globus_cond_destroy(&job->cond);
+    globus_mutex_destroy(&job->lock);
+    globus_free(job);
+}
+
+static
+void
+globus_l_gfs_file_cksm_worker_exit(
+    globus_l_gfs_file_cksm_job_t *      job)
+{
+    globus_bool_t                       last;
+
+    globus_mutex_lock(&job->lock);
+    {
+        last = --job->workers == 0;
+    }
+    globus_mutex_unlock(&job->lock);
+
+    if(last)
+    {
+        globus_l_gfs_file_cksm_job_finish(job);
+    }
+}
+
+static
+void *
+globus_l_gfs_file_cksm_region_thread(
+    void *                              user_arg)
+{
+    globus_l_gfs_file_cksm_region_t *   region;
+    globus_l_gfs_file_cksm_job_t *      job;
+    globus_byte_t *                     buffer;
+    globus_off_t                        offset;
+    globus_off_t                        left;
+    globus_ssize_t                      nbytes = 0;
+    globus_size_t                       len;
+    int                                 rc = 0;
+
+    region = (globus_l_gfs_file_cksm_region_t *) user_arg;
+    job = region->job;
+
+    buffer = globus_malloc(job->block_size);
+    if(buffer == NULL)
+    {
+        rc = ENOMEM;
+    }
+
+    offset = region->offset;
+    left = region->length;
+    while(rc == 0 && left > 0 && job->error == 0)
+    {
+        len = left > job->block_size ? job->block_size : left;
+        rc = globus_l_gfs_file_cksm_pread(
+            job->fd, buffer, len, offset, &nbytes);
+        if(rc == 0 && nbytes == 0)
+        {
+            /* the file shrank underneath us; the regions no longer line up */
+            rc = EIO;
+        }
+        if(rc == 0)
+        {
+            globus_gfs_file_cksm_update(&region->ctx, buffer, nbytes);
+            if(job->progress_cb)
+            {
+                job->progress_cb(nbytes, job->user_arg);
+            }
+            offset += nbytes;
+            left -= nbytes;
+        }
+    }
+
+    if(buffer)
+    {
+        globus_free(buffer);
+    }
+    if(rc != 0)
+    {
+        globus_mutex_lock(&job->lock);
+        {
+            if(job->error == 0)
+            {
+                job->error = rc;
+            }
+        }
+        globus_mutex_unlock(&job->lock);
+    }
+
+    globus_l_gfs_file_cksm_worker_exit(job);
+
+    return NULL;
+}
+
+static
+void *
+globus_l_gfs_file_cksm_reader_thread(
+    void *                              user_arg)
+{
+    globus_l_gfs_file_cksm_job_t *      job;
+    globus_off_t                        offset;
+    globus_off_t                        left;
+    globus_ssize_t                      nbytes;
+    globus_size_t                       len;
+    int                                 slot;
+    int                                 rc;
+
+    job = (globus_l_gfs_file_cksm_job_t *) user_arg;
+
+    offset = job->offset;
+    left = job->length;
+    do
+    {
+        globus_mutex_lock(&job->lock);
+        {
+            while(job->filled == GLOBUS_L_GFS_FILE_CKSM_READ_AHEAD &&
+                job->error == 0)
+            {
+                globus_cond_wait(&job->cond, &job->lock);
+            }
+            slot = (job->head + job->filled) %
+                GLOBUS_L_GFS_FILE_CKSM_READ_AHEAD;
+        }
+        globus_mutex_unlock(&job->lock);
+        if(job->error != 0)
+        {
+            break;
+        }
+
+        /* a length of 0 tells the hasher we are done, < 0 is -errno */
+        nbytes = 0;
+        if(left > 0)
+        {
+            len = left > job->block_size ? job->block_size : left;
+            rc = globus_l_gfs_file_cksm_pread(
+                job->fd, job->buffers[slot], len, offset, &nbytes);
+            if(rc != 0)
+            {
+                nbytes = -rc;
+            }
+            else if(nbytes > 0)
+            {
+                offset += nbytes;
+                left -= nbytes;
+            }
+        }
+
+        globus_mutex_lock(&job->lock);
+        {
+            job->lengths[slot] = nbytes;
+            job->filled++;
+            globus_cond_broadcast(&job->cond);
+        }
+        globus_mutex_unlock(&job->lock);
+    } while(nbytes > 0);
+
+    globus_l_gfs_file_cksm_worker_exit(job);
+
+    return NULL;
+}
+
+static
+void *
+globus_l_gfs_file_cksm_hasher_thread(
+    void *                              user_arg)
+{
+    globus_l_gfs_file_cksm_job_t *      job;
+    globus_ssize_t                      nbytes;
+    int                                 slot;
+
+    job = (globus_l_gfs_file_cksm_job_t *) user_arg;
+
+    for(;;)
+    {
+        globus_mutex_lock(&job->lock);
+        {
+            while(job->filled == 0)
+            {
+                globus_cond_wait(&job->cond, &job->lock);
+            }
+            slot = job->head;
+            nbytes = job->lengths[slot];
+            if(nbytes < 0)
+            {
+                job->error = -nbytes;
+            }
+        }
+        globus_mutex_unlock(&job->lock);
+        if(nbytes <= 0)
+        {
+            break;
+        }
+
+        globus_gfs_file_cksm_update(&job->ctx, job->buffers[slot], nbytes);
+        if(job->progress_cb)
+        {
+            job->progress_cb(nbytes, job->user_arg);
+        }
+
+        globus_mutex_lock(&job->lock);
+        {
+            job->head = (job->head + 1) % GLOBUS_L_GFS_FILE_CKSM_READ_AHEAD;
+            job->filled--;
+            globus_cond_broadcast(&job->cond);
+        }
+        globus_mutex_unlock(&job->lock);
+    }
+
+    globus_l_gfs_file_cksm_worker_exit(job);
+
+    return NULL;
+}
+
+int
+globus_gfs_file_cksm_compute(
+    const char *                        pathname,
+    globus_gfs_file_cksm_type_t         type,
+    globus_off_t                        offset,
+    globus_off_t                        length,
+    globus_size_t                       block_size,
+    int                                 threads,
+    globus_gfs_file_cksm_progress_cb_t  progress_cb,
+    globus_gfs_file_cksm_done_cb_t      done_cb,
+    void *                              user_arg)
+{
+    globus_l_gfs_file_cksm_job_t *      job;
+    globus_thread_t                     thread;
+    struct stat                         stat_buf;
+    globus_off_t                        region_len;
+    globus_off_t                        min_region;
+    int                                 rc;
+    int                                 i;
+
+    if(globus_i_am_only_thread())
+    {
+        return ENOTSUP;
+    }
+    if(type == GLOBUS_GFS_FILE_CKSM_TYPE_NONE || block_size == 0)
+    {
+        return EINVAL;
+    }
+
+    job = globus_calloc(1, sizeof(globus_l_gfs_file_cksm_job_t));
+    if(job == NULL)
+    {
+        return ENOMEM;
+    }
+
+    job->fd = open(pathname, O_RDONLY);
+    if(job->fd < 0)
+    {
+        rc = errno;
+        goto error_open;
+    }
+    if(fstat(job->fd, &stat_buf) != 0)
+    {
+        rc = errno;
+        goto error_stat;
+    }
+
+    if(offset < 0 || offset > stat_buf.st_size)
+    {
+        offset = stat_buf.st_size;
+    }
+    if(length < 0 || length > stat_buf.st_size - offset)
+    {
+        length = stat_buf.st_size - offset;
+    }
+
+    globus_mutex_init(&job->lock, NULL);
+    globus_cond_init(&job->cond, NULL);
+    job->type = type;
+    job->offset = offset;
+    job->length = length;
+    job->block_size = block_size;
+    job->progress_cb = progress_cb;
+    job->done_cb = done_cb;
+    job->user_arg = user_arg;
+
+    /* regions are whole blocks, and not so small they are all overhead */
+    region_len = 0;
+    if(globus_gfs_file_cksm_mergeable(type) && threads > 1)
+    {
+        min_region = (globus_off_t) block_size *
+            GLOBUS_L_GFS_FILE_CKSM_MIN_REGION_BLOCKS;
+        region_len = (length + threads - 1) / threads;
+        region_len = ((region_len + block_size - 1) / block_size) *
+            block_size;
+        if(region_len < min_region)
+        {
+            region_len = min_region;
+        }
+        job->region_count = (length + region_len - 1) / region_len;
+    }
+
+    if(job->region_count > 1)
+    {
+        job->regions = globus_calloc(
+            job->region_count, sizeof(globus_l_gfs_file_cksm_region_t));
+        if(job->regions == NULL)
+        {
+            rc = ENOMEM;
+            goto error_alloc;
+        }
+        for(i = 0; i < job->region_count; i++)
+        {
+            job->regions[i].job = job;
+            job->regions[i].offset = offset + i * region_len;
+            job->regions[i].length = (i == job->region_count - 1)
+                ? length - i * region_len : region_len;
+            globus_gfs_file_cksm_init(&job->regions[i].ctx, type);
+        }
+
+        job->workers = job->region_count;
+        for(i = 0; i < job->region_count; i++)
+        {
+            rc = globus_thread_create(
+                &thread, NULL,
+                globus_l_gfs_file_cksm_region_thread, &job->regions[i]);
+            if(rc != 0)
+            {
+                goto error_thread;
+            }
+        }
+    }
+    else
+    {
+        job->region_count = 0;
+        globus_gfs_file_cksm_init(&job->ctx, type);
+        for(i = 0; i < GLOBUS_L_GFS_FILE_CKSM_READ_AHEAD; i++)
+        {
+            job->buffers[i] = globus_malloc(block_size);
+            if(job->buffers[i] == NULL)
+            {
+                rc = ENOMEM;
+                goto error_alloc;
+            }
+        }
+
+        job->workers = 2;
+        rc = globus_thread_create(
+            &thread, NULL, globus_l_gfs_file_cksm_hasher_thread, job);
+        if(rc != 0)
+        {
+            i = 0;
+            goto error_thread;
+        }
+        rc = globus_thread_create(
+            &thread, NULL, globus_l_gfs_file_cksm_reader_thread, job);
+        if(rc != 0)
+        {
+            /* the hasher needs an end of data marker to exit */
+            globus_mutex_lock(&job->lock);
+            {
+                job->lengths[job->head] = -rc;
+                job->filled = 1;
+                globus_cond_broadcast(&job->cond);
+            }
+            globus_mutex_unlock(&job->lock);
+            i = 1;
+            goto error_thread;
+        }
+    }
+
+    return 0;
+
+error_thread:
+    /* the threads already running will finish the job with the error */
+    globus_mutex_lock(&job->lock);
+    {
+        job->error = rc;
+        job->workers -= job->regions ? job->region_count - i : 2 - i;
+        i = job->workers;
+    }
+    globus_mutex_unlock(&job->lock);
+    if(i == 0)
+    {
+        globus_l_gfs_file_cksm_job_finish(job);
+    }
+    return 0;
+
+error_alloc:
+    for(i = 0; i < GLOBUS_L_GFS_FILE_CKSM_READ_AHEAD; i++)
+    {
+        if(job->buffers[i])
+        {
+            globus_free(job->buffers[i]);
+        }
+    }
+    if(job->regions)
+    {
+        globus_free(job->regions);
+    }
+    globus_cond_destroy(&job->cond);
+    globus_mutex_destroy(&job->lock);
+error_stat:
+    close(job->fd);
+error_open:
+    globus_free(job);
+    return rc;
+}
+
+globus_gfs_file_cksm_ranges_t *
+globus_gfs_file_cksm_ranges_create(
+    globus_gfs_file_cksm_type_t         type)
+{
+    globus_gfs_file_cksm_ranges_t *     ranges;
+
+    if(!globus_gfs_file_cksm_mergeable(type))
+    {
+        return NULL;
+    }
+
+    ranges = globus_calloc(1, sizeof(globus_gfs_file_cksm_ranges_t));
+    if(ranges != NULL)
+    {
+        ranges->type = type;
+    }
+
+    return ranges;
+}
+
+void
+globus_gfs_file_cksm_ranges_add(
+    globus_gfs_file_cksm_ranges_t *     ranges,
+    globus_off_t                        offset,
+    const globus_gfs_file_cksm_ctx_t *  ctx)
+{
+    globus_l_gfs_file_cksm_range_t *    prev = NULL;
+    globus_l_gfs_file_cksm_range_t *    next;
+    globus_l_gfs_file_cksm_range_t *    range;
+
+    if(ranges->overlap || ctx->length == 0)
+    {
+        return;
+    }
+
+    for(next = ranges->head;
+        next != NULL && next->offset < offset;
+        next = next->next)
+    {
+        prev = next;
+    }
+
+    if((prev && prev->offset + prev->ctx.length > offset) ||
+        (next && offset + ctx->length > next->offset))
+    {
+        ranges->overlap = GLOBUS_TRUE;
+        return;
+    }
+
+    if(prev && prev->offset + prev->ctx.length == offset)
+    {
+        globus_gfs_file_cksm_merge(&prev->ctx, ctx);
+        range = prev;
+    }
+    else
+    {
+        range = globus_malloc(sizeof(globus_l_gfs_file_cksm_range_t));
+        if(range == NULL)
+        {
+            /* can't account for these bytes any more */
+            ranges->overlap = GLOBUS_TRUE;
+            return;
+        }
+        range->offset = offset;
+        range->ctx = *ctx;
+        range->next = next;
+        if(prev)
+        {
+            prev->next = range;
+        }
+        else
+        {
+            ranges->head = range;
+        }
+    }
+
+    if(next && range->offset + range->ctx.length == next->offset)
+    {
+        globus_gfs_file_cksm_merge(&range->ctx, &next->ctx);
+        range->next = next->next;
+        globus_free(next);
+    }
+}
+
+globus_bool_t
+globus_gfs_file_cksm_ranges_final(
+    globus_gfs_file_cksm_ranges_t *     ranges,
+    globus_off_t                        offset,
+    globus_off_t                        length,
+    char *                              out)
+{
+    globus_gfs_file_cksm_ctx_t          ctx;
+
+    if(ranges->overlap)
+    {
+        return GLOBUS_FALSE;
+    }
+    if(ranges->head == NULL)
+    {
+        if(length != 0)
+        {
+            return GLOBUS_FALSE;
+        }
+        globus_gfs_file_cksm_init(&ctx, ranges->type);
+        globus_gfs_file_cksm_final(&ctx, out);
+        return GLOBUS_TRUE;
+    }
+    if(ranges->head->next != NULL ||
+        ranges->head->offset != offset ||
+        ranges->head->ctx.length != length)
+    {
+        return GLOBUS_FALSE;
+    }
+
+    ctx = ranges->head->ctx;
+    globus_gfs_file_cksm_final(&ctx, out);
+
+    return GLOBUS_TRUE;
+}
+
+void
+globus_gfs_file_cksm_ranges_destroy(
+    globus_gfs_file_cksm_ranges_t *     ranges)
+{
+    globus_l_gfs_file_cksm_range_t *    range;
+
+    while(ranges->head != NULL)
+    {
+        range = ranges->head;
+        ranges->head = range->next;
+        globus_free(range);
+    }
+    globus_free(ranges);
+}
+
+const char *
+globus_gfs_file_cksm_name(
+    globus_gfs_file_cksm_type_t         type)
+{
+    switch(type)
+    {
+        case GLOBUS_GFS_FILE_CKSM_TYPE_ADLER32:
+            return "adler32";
+        case GLOBUS_GFS_FILE_CKSM_TYPE_MD5:
+            return "md5";
+        case GLOBUS_GFS_FILE_CKSM_TYPE_CRC32C:
+            return "crc32c";
+        case GLOBUS_GFS_FILE_CKSM_TYPE_SHA256:
+            return "sha256";
+        default:
+            return NULL;
+    }
+}
+
+static
+long
+globus_l_gfs_file_cksm_mtime_nsec(
+    const struct stat *                 stat_buf)
+{
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    return stat_buf->st_mtim.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+static
+globus_bool_t
+globus_l_gfs_file_cksm_stat_equal(
+    const struct stat *                 a,
+    const struct stat *                 b)
+{
+    return a->st_dev == b->st_dev &&
+        a->st_ino == b->st_ino &&
+        a->st_size == b->st_size &&
+        a->st_mtime == b->st_mtime &&
+        globus_l_gfs_file_cksm_mtime_nsec(a) ==
+            globus_l_gfs_file_cksm_mtime_nsec(b);
+}
+
+/*
+ * persistent store: lines of
+ *     <algorithm> <offset> <length> <size> <mtime> <mtime nsec> <checksum>
+ * kept in an extended attribute of the file, or in a file named for the
+ * device, inode and writer's uid in the sidecar directory.  lines for
+ * another size or mtime are stale and dropped on the next store.
+ *
+ * the sidecar directory may be shared by servers running as different
+ * users, so a sidecar file is only believed if it is a plain file owned by
+ * the uid in its name, and that uid is ours or the data file owner's.
+ * sidecars are readable by others only when the data file is.
+ */
+static
+int
+globus_l_gfs_file_cksm_store_read(
+    globus_l_gfs_file_cksm_store_t      store,
+    const char *                        store_dir,
+    const char *                        pathname,
+    const struct stat *                 stat_buf,
+    uid_t                               uid,
+    char *                              buffer,
+    globus_size_t                       size)
+{
+    char                                path[MAXPATHLEN];
+    struct stat                         record_stat;
+    globus_ssize_t                      len = -1;
+    int                                 fd;
+
+    switch(store)
+    {
+#ifdef GLOBUS_L_GFS_FILE_CKSM_XATTR
+      case GLOBUS_L_GFS_FILE_CKSM_STORE_XATTR:
+        len = getxattr(
+            pathname, GLOBUS_L_GFS_FILE_CKSM_XATTR, buffer, size - 1);
+        break;
+#endif
+      case GLOBUS_L_GFS_FILE_CKSM_STORE_DIR:
+        snprintf(path, sizeof(path), "%s/%lu.%lu.%lu",
+            store_dir,
+            (unsigned long) stat_buf->st_dev,
+            (unsigned long) stat_buf->st_ino,
+            (unsigned long) uid);
+        fd = open(path, O_RDONLY | O_NOFOLLOW | O_NONBLOCK);
+        if(fd < 0)
+        {
+            break;
+        }
+        /* a link here could pass off another file's records */
+        if(fstat(fd, &record_stat) == 0 &&
+            S_ISREG(record_stat.st_mode) &&
+            record_stat.st_nlink == 1 &&
+            record_stat.st_uid == uid)
+        {
+            len = read(fd, buffer, size - 1);
+        }
+        close(fd);
+        break;
+      default:
+        break;
+    }
+
+    if(len < 0)
+    {
+        len = 0;
+    }
+    buffer[len] = '\0';
+
+    return len;
+}
+
+static
+void
+globus_l_gfs_file_cksm_store_write(
+    globus_l_gfs_file_cksm_store_t      store,
+    const char *                        store_dir,
+    const char *                        pathname,
+    const struct stat *                 stat_buf,
+    const char *                        buffer,
+    globus_size_t                       len)
+{
+    char                                path[MAXPATHLEN];
+    char                                tmp_path[MAXPATHLEN];
+    mode_t                              mode;
+    int                                 fd;
+
+    switch(store)
+    {
+#ifdef GLOBUS_L_GFS_FILE_CKSM_XATTR
+      case GLOBUS_L_GFS_FILE_CKSM_STORE_XATTR:
+        /* best effort, we may not own the file */
+        setxattr(pathname, GLOBUS_L_GFS_FILE_CKSM_XATTR, buffer, len, 0);
+        break;
+#endif
+      case GLOBUS_L_GFS_FILE_CKSM_STORE_DIR:
+        snprintf(path, sizeof(path), "%s/%lu.%lu.%lu",
+            store_dir,
+            (unsigned long) stat_buf->st_dev,
+            (unsigned long) stat_buf->st_ino,
+            (unsigned long) geteuid());
+        /* other users may create files in the directory, never open a
+         * name they could have guessed */
+        snprintf(tmp_path, sizeof(tmp_path), "%s/.%lu.%lu.%lu.XXXXXX",
+            store_dir,
+            (unsigned long) stat_buf->st_dev,
+            (unsigned long) stat_buf->st_ino,
+            (unsigned long) geteuid());
+        fd = mkstemp(tmp_path);
+        if(fd < 0)
+        {
+            break;
+        }
+        mode = S_IRUSR | S_IWUSR;
+        if(stat_buf->st_mode & S_IROTH)
+        {
+            mode |= S_IRGRP | S_IROTH;
+        }
+        if(fchmod(fd, mode) != 0 ||
+            write(fd, buffer, len) != (globus_ssize_t) len)
+        {
+            close(fd);
+            unlink(tmp_path);
+        }
+        else if(close(fd) != 0 || rename(tmp_path, path) != 0)
+        {
+            unlink(tmp_path);
+        }
+        break;
+      default:
+        break;
+    }
+}
+
+/* returns the start of the checksum in line if it is a current record of
+ * type over [offset, offset + length), NULL otherwise; line is split.
+ */
+static
+char *
+globus_l_gfs_file_cksm_record_match(
+    char *                              line,
+    const struct stat *                 stat_buf,
+    globus_gfs_file_cksm_type_t         type,
+    globus_off_t                        offset,
+    globus_off_t                        length,
+    globus_bool_t *                     current)
+{
+    char                                alg[16];
+    char                                cksm[GLOBUS_GFS_FILE_CKSM_MAX_LEN];
+    globus_off_t                        rec_offset;
+    globus_off_t                        rec_length;
+    globus_off_t                        rec_size;
+    long long                           rec_mtime;
+    long                                rec_nsec;
+    int                                 rc;
+
+    *current = GLOBUS_FALSE;
+    rc = sscanf(line,
+        "%15s %"GLOBUS_OFF_T_FORMAT" %"GLOBUS_OFF_T_FORMAT
+        " %"GLOBUS_OFF_T_FORMAT" %lld %ld %64s",
+        alg, &rec_offset, &rec_length, &rec_size,
+        &rec_mtime, &rec_nsec, cksm);
+    if(rc != 7 ||
+        rec_size != stat_buf->st_size ||
+        rec_mtime != (long long) stat_buf->st_mtime ||
+        rec_nsec != globus_l_gfs_file_cksm_mtime_nsec(stat_buf))
+    {
+        return NULL;
+    }
+    *current = GLOBUS_TRUE;
+
+    if(globus_gfs_file_cksm_lookup(alg) != type ||
+        rec_offset != offset ||
+        rec_length != length)
+    {
+        return NULL;
+    }
+
+    /* the checksum is the last field */
+    return strrchr(line, ' ') + 1;
+}
+
+static
+globus_bool_t
+globus_l_gfs_file_cksm_store_lookup(
+    globus_l_gfs_file_cksm_store_t      store,
+    const char *                        store_dir,
+    const char *                        pathname,
+    const struct stat *                 stat_buf,
+    globus_gfs_file_cksm_type_t         type,
+    globus_off_t                        offset,
+    globus_off_t                        length,
+    char *                              out)
+{
+    char                                buffer[GLOBUS_L_GFS_FILE_CKSM_STORE_MAX];
+    char *                              line;
+    char *                              next;
+    char *                              cksm;
+    globus_bool_t                       current;
+    uid_t                               uids[2];
+    int                                 nuids = 1;
+    int                                 i;
+
+    /* our own records, then those of the file's owner */
+    uids[0] = geteuid();
+    if(store == GLOBUS_L_GFS_FILE_CKSM_STORE_DIR &&
+        stat_buf->st_uid != uids[0])
+    {
+        uids[nuids++] = stat_buf->st_uid;
+    }
+
+    for(i = 0; i < nuids; i++)
+    {
+        globus_l_gfs_file_cksm_store_read(
+            store, store_dir, pathname, stat_buf, uids[i],
+            buffer, sizeof(buffer));
+
+        for(line = buffer; *line != '\0'; line = next)
+        {
+            next = strchr(line, '\n');
+            if(next == NULL)
+            {
+                break;
+            }
+            *next++ = '\0';
+
+            cksm = globus_l_gfs_file_cksm_record_match(
+                line, stat_buf, type, offset, length, &current);
+            if(cksm != NULL)
+            {
+                strcpy(out, cksm);
+                return GLOBUS_TRUE;
+            }
+        }
+    }
+
+    return GLOBUS_FALSE;
+}
+
+static
+void
+globus_l_gfs_file_cksm_store_add(
+    globus_l_gfs_file_cksm_store_t      store,
+    const char *                        store_dir,
+    const char *                        pathname,
+    const struct stat *                 stat_buf,
+    globus_gfs_file_cksm_type_t         type,
+    globus_off_t                        offset,
+    globus_off_t                        length,
+    const char *                        cksm)
+{
+    char                                buffer[GLOBUS_L_GFS_FILE_CKSM_STORE_MAX];
+    char                                record[128];
+    char *                              out;
+    char *                              line;
+    char *                              next;
+    char *                              match;
+    globus_size_t                       len;
+    globus_size_t                       out_len = 0;
+    globus_bool_t                       current;
+
+    len = snprintf(record, sizeof(record),
+        "%s %"GLOBUS_OFF_T_FORMAT" %"GLOBUS_OFF_T_FORMAT
+        " %"GLOBUS_OFF_T_FORMAT" %lld %ld %s\n",
+        globus_gfs_file_cksm_name(type), offset, length,
+        (globus_off_t) stat_buf->st_size,
+        (long long) stat_buf->st_mtime,
+        globus_l_gfs_file_cksm_mtime_nsec(stat_buf),
+        cksm);
+    if(len >= sizeof(record))
+    {
+        return;
+    }
+
+    out = globus_malloc(sizeof(buffer));
+    if(out == NULL)
+    {
+        return;
+    }
+
+    /* newest record first; keep the current ones that still fit */
+    memcpy(out, record, len);
+    out_len = len;
+
+    globus_l_gfs_file_cksm_store_read(
+        store, store_dir, pathname, stat_buf, geteuid(),
+        buffer, sizeof(buffer));
+    for(line = buffer; *line != '\0'; line = next)
+    {
+        next = strchr(line, '\n');
+        if(next == NULL)
+        {
+            break;
+        }
+        *next++ = '\0';
+        len = next - line;
+
+        match = globus_l_gfs_file_cksm_record_match(
+            line, stat_buf, type, offset, length, &current);
+        if(match == NULL && current && out_len + len < sizeof(buffer))
+        {
+            memcpy(out + out_len, line, len - 1);
+            out[out_len + len - 1] = '\n';
+            out_len += len;
+        }
+    }
+
+    globus_l_gfs_file_cksm_store_write(
+        store, store_dir, pathname, stat_buf, out, out_len);
+    globus_free(out);
+}
+
+int
+globus_gfs_file_cksm_cache_configure(
+    const char *                        store)
+{
+    struct stat                         stat_buf;
+    int                                 rc = 0;
+
+    globus_thread_once(
+        &globus_l_gfs_file_cksm_once, globus_l_gfs_file_cksm_once_init);
+
+    globus_mutex_lock(&globus_l_gfs_file_cksm_cache_lock);
+    {
+        globus_l_gfs_file_cksm_store = GLOBUS_L_GFS_FILE_CKSM_STORE_NONE;
+        if(globus_l_gfs_file_cksm_store_dir)
+        {
+            globus_free(globus_l_gfs_file_cksm_store_dir);
+            globus_l_gfs_file_cksm_store_dir = NULL;
+        }
+
+        if(store == NULL || *store == '\0')
+        {
+        }
+        else if(strcmp(store, "xattr") == 0)
+        {
+#ifdef GLOBUS_L_GFS_FILE_CKSM_XATTR
+            globus_l_gfs_file_cksm_store = GLOBUS_L_GFS_FILE_CKSM_STORE_XATTR;
+#else
+            rc = ENOTSUP;
+#endif
+        }
+        else if(stat(store, &stat_buf) != 0)
+        {
+            rc = errno;
+        }
+        else if(!S_ISDIR(stat_buf.st_mode))
+        {
+            rc = ENOTDIR;
+        }
+        else
+        {
+            globus_l_gfs_file_cksm_store_dir = globus_libc_strdup(store);
+            globus_l_gfs_file_cksm_store = GLOBUS_L_GFS_FILE_CKSM_STORE_DIR;
+        }
+    }
+    globus_mutex_unlock(&globus_l_gfs_file_cksm_cache_lock);
+
+    return rc;
+}
+
+void
+globus_gfs_file_cksm_cache_stats(
+    int *                               hits,
+    int *                               misses)
+{
+    globus_thread_once(
+        &globus_l_gfs_file_cksm_once, globus_l_gfs_file_cksm_once_init);
+
+    globus_mutex_lock(&globus_l_gfs_file_cksm_cache_lock);
+    {
+        *hits = globus_l_gfs_file_cksm_cache_hits;
+        *misses = globus_l_gfs_file_cksm_cache_misses;
+    }
+    globus_mutex_unlock(&globus_l_gfs_file_cksm_cache_lock);
+}
+
+/* called locked; the store is used unlocked from a copy of its settings */
+static
+globus_l_gfs_file_cksm_store_t
+globus_l_gfs_file_cksm_store_snapshot(
+    char *                              store_dir,
+    globus_size_t                       size)
+{
+    store_dir[0] = '\0';
+    if(globus_l_gfs_file_cksm_store == GLOBUS_L_GFS_FILE_CKSM_STORE_DIR)
+    {
+        if(strlen(globus_l_gfs_file_cksm_store_dir) >= size)
+        {
+            return GLOBUS_L_GFS_FILE_CKSM_STORE_NONE;
+        }
+        strcpy(store_dir, globus_l_gfs_file_cksm_store_dir);
+    }
+
+    return globus_l_gfs_file_cksm_store;
+}
+
+static
+void
+globus_l_gfs_file_cksm_cache_entry_free(
+    void *                              datum)
+{
+    globus_l_gfs_file_cksm_cache_entry_t * entry;
+    int                                 i;
+
+    entry = (globus_l_gfs_file_cksm_cache_entry_t *) datum;
+    for(i = 0; i <= GLOBUS_GFS_FILE_CKSM_TYPE_SHA256; i++)
+    {
+        if(entry->cksm[i])
+        {
+            globus_free(entry->cksm[i]);
+        }
+    }
+    globus_free(entry->pathname);
+    globus_free(entry);
+}
+
+static
+globus_bool_t
+globus_l_gfs_file_cksm_cache_entry_current(
+    globus_l_gfs_file_cksm_cache_entry_t * entry,
+    const struct stat *                 stat_buf)
+{
+    return entry->dev == stat_buf->st_dev &&
+        entry->ino == stat_buf->st_ino &&
+        entry->size == stat_buf->st_size &&
+        entry->mtime == stat_buf->st_mtime &&
+        entry->mtime_nsec == globus_l_gfs_file_cksm_mtime_nsec(stat_buf);
+}
+
+/* called locked */
+static
+void
+globus_l_gfs_file_cksm_cache_remember(
+    const char *                        pathname,
+    const struct stat *                 stat_buf,
+    globus_gfs_file_cksm_type_t         type,
+    const char *                        cksm)
+{
+    globus_l_gfs_file_cksm_cache_entry_t * entry;
+    int                                 i;
+
+    entry = globus_hashtable_lookup(
+        &globus_l_gfs_file_cksm_cache, (void *) pathname);
+    if(entry == NULL)
+    {
+        if(globus_hashtable_size(&globus_l_gfs_file_cksm_cache) >=
+            GLOBUS_L_GFS_FILE_CKSM_CACHE_MAX)
+        {
+            entry = globus_hashtable_first(&globus_l_gfs_file_cksm_cache);
+            globus_hashtable_remove(
+                &globus_l_gfs_file_cksm_cache, entry->pathname);
+            globus_l_gfs_file_cksm_cache_entry_free(entry);
+        }
+
+        entry = globus_calloc(
+            1, sizeof(globus_l_gfs_file_cksm_cache_entry_t));
+        if(entry == NULL)
+        {
+            return;
+        }
+        entry->pathname = globus_libc_strdup(pathname);
+        if(entry->pathname == NULL)
+        {
+            globus_free(entry);
+            return;
+        }
+        globus_hashtable_insert(
+            &globus_l_gfs_file_cksm_cache, entry->pathname, entry);
+    }
+    else if(!globus_l_gfs_file_cksm_cache_entry_current(entry, stat_buf))
+    {
+        /* a different file now; what we knew no longer applies */
+        for(i = 0; i <= GLOBUS_GFS_FILE_CKSM_TYPE_SHA256; i++)
+        {
+            if(entry->cksm[i])
+            {
+                globus_free(entry->cksm[i]);
+                entry->cksm[i] = NULL;
+            }
+        }
+    }
+
+    entry->dev = stat_buf->st_dev;
+    entry->ino = stat_buf->st_ino;
+    entry->size = stat_buf->st_size;
+    entry->mtime = stat_buf->st_mtime;
+    entry->mtime_nsec = globus_l_gfs_file_cksm_mtime_nsec(stat_buf);
+    if(entry->cksm[type])
+    {
+        globus_free(entry->cksm[type]);
+    }
+    entry->cksm[type] = globus_libc_strdup(cksm);
+}
+
+void
+globus_gfs_file_cksm_cache_store(
+    const char *                        pathname,
+    const struct stat *                 stat_buf,
+    globus_gfs_file_cksm_type_t         type,
+    globus_off_t                        offset,
+    globus_off_t                        length,
+    const char *                        cksm)
+{
+    struct stat                         now;
+    globus_l_gfs_file_cksm_store_t      store;
+    char                                store_dir[MAXPATHLEN];
+
+    globus_thread_once(
+        &globus_l_gfs_file_cksm_once, globus_l_gfs_file_cksm_once_init);
+
+    if(offset < 0 || offset > stat_buf->st_size)
+    {
+        return;
+    }
+    if(length < 0 || length > stat_buf->st_size - offset)
+    {
+        length = stat_buf->st_size - offset;
+    }
+
+    if(stat(pathname, &now) != 0 ||
+        !globus_l_gfs_file_cksm_stat_equal(&now, stat_buf))
+    {
+        return;
+    }
+
+    globus_mutex_lock(&globus_l_gfs_file_cksm_cache_lock);
+    {
+        /* only whole files are kept in memory */
+        if(offset == 0 && length == stat_buf->st_size)
+        {
+            globus_l_gfs_file_cksm_cache_remember(
+                pathname, stat_buf, type, cksm);
+        }
+        store = globus_l_gfs_file_cksm_store_snapshot(
+            store_dir, sizeof(store_dir));
+    }
+    globus_mutex_unlock(&globus_l_gfs_file_cksm_cache_lock);
+
+    /* other checksums needn't wait for the disk */
+    if(store != GLOBUS_L_GFS_FILE_CKSM_STORE_NONE)
+    {
+        globus_l_gfs_file_cksm_store_add(
+            store, store_dir, pathname, stat_buf, type, offset, length, cksm);
+    }
+}
+
+globus_bool_t
+globus_gfs_file_cksm_cache_lookup(
+    const char *                        pathname,
+    const struct stat *                 stat_buf,
+    globus_gfs_file_cksm_type_t         type,
+    globus_off_t                        offset,
+    globus_off_t                        length,
+    char *                              out)
+{
+    globus_l_gfs_file_cksm_cache_entry_t * entry;
+    globus_l_gfs_file_cksm_store_t      store;
+    char                                store_dir[MAXPATHLEN];
+    globus_bool_t                       found = GLOBUS_FALSE;
+    globus_bool_t                       stored = GLOBUS_FALSE;
+
+    globus_thread_once(
+        &globus_l_gfs_file_cksm_once, globus_l_gfs_file_cksm_once_init);
+
+    if(offset < 0 || offset > stat_buf->st_size)
+    {
+        return GLOBUS_FALSE;
+    }
+    if(length < 0 || length > stat_buf->st_size - offset)
+    {
+        length = stat_buf->st_size - offset;
+    }
+
+    globus_mutex_lock(&globus_l_gfs_file_cksm_cache_lock);
+    {
+        if(offset == 0 && length == stat_buf->st_size)
+        {
+            entry = globus_hashtable_lookup(
+                &globus_l_gfs_file_cksm_cache, (void *) pathname);
+            if(entry != NULL &&
+                !globus_l_gfs_file_cksm_cache_entry_current(entry, stat_buf))
+            {
+                globus_hashtable_remove(
+                    &globus_l_gfs_file_cksm_cache, (void *) pathname);
+                globus_l_gfs_file_cksm_cache_entry_free(entry);
+                entry = NULL;
+            }
+            if(entry != NULL && entry->cksm[type] != NULL)
+            {
+                strcpy(out, entry->cksm[type]);
+                found = GLOBUS_TRUE;
+            }
+        }
+        store = globus_l_gfs_file_cksm_store_snapshot(
+            store_dir, sizeof(store_dir));
+    }
+    globus_mutex_unlock(&globus_l_gfs_file_cksm_cache_lock);
+
+    if(!found && store != GLOBUS_L_GFS_FILE_CKSM_STORE_NONE)
+    {
+        stored = globus_l_gfs_file_cksm_store_lookup(
+            store, store_dir, pathname, stat_buf, type, offset, length, out);
+        found = stored;
+    }
+
+    globus_mutex_lock(&globus_l_gfs_file_cksm_cache_lock);
+    {
+        if(stored && offset == 0 && length == stat_buf->st_size)
+        {
+            globus_l_gfs_file_cksm_cache_remember(
+                pathname, stat_buf, type, out);
+        }
+
+        if(found)
+        {
+            globus_l_gfs_file_cksm_cache_hits++;
+        }
+        else
+        {
+            globus_l_gfs_file_cksm_cache_misses++;
+        }
+    }
+    globus_mutex_unlock(&globus_l_gfs_file_cksm_cache_lock);
+
+    return found;
+}
@@ -0,0 +1,199 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLOBUS_GRIDFTP_SERVER_FILE_CKSM_H
+#define GLOBUS_GRIDFTP_SERVER_FILE_CKSM_H
+
+#include "globus_common.h"
+#include <sys/stat.h>
+#include <openssl/md5.h>
+#include <openssl/sha.h>
+
+/*
+ * checksum algorithms and the engine the file DSI uses to compute them.
+ *
+ * mergeable algorithms (adler32, crc32c) can hash separate ranges of a file
+ * independently and merge the results in order, so the engine splits them
+ * across threads.  md5 and sha256 are hashed in one pass with reads
+ * pipelined ahead of the hashing.
+ */
+
+typedef enum
+{
+    GLOBUS_GFS_FILE_CKSM_TYPE_NONE = 0,
+    GLOBUS_GFS_FILE_CKSM_TYPE_ADLER32,
+    GLOBUS_GFS_FILE_CKSM_TYPE_MD5,
+    GLOBUS_GFS_FILE_CKSM_TYPE_CRC32C,
+    GLOBUS_GFS_FILE_CKSM_TYPE_SHA256
+} globus_gfs_file_cksm_type_t;
+
+/* big enough for the hex form of any supported checksum */
+#define GLOBUS_GFS_FILE_CKSM_MAX_LEN    (SHA256_DIGEST_LENGTH * 2 + 1)
+
+typedef struct
+{
+    globus_gfs_file_cksm_type_t         type;
+    /* number of bytes hashed so far */
+    globus_off_t                        length;
+    union
+    {
+        MD5_CTX                         md5;
+        SHA256_CTX                      sha256;
+        uint32_t                        adler32;
+        uint32_t                        crc32c;
+    } u;
+} globus_gfs_file_cksm_ctx_t;
+
+typedef void
+(*globus_gfs_file_cksm_progress_cb_t)(
+    globus_off_t                        nbytes,
+    void *                              user_arg);
+
+/* error is 0 or an errno value; cksm is NULL on error */
+typedef void
+(*globus_gfs_file_cksm_done_cb_t)(
+    int                                 error,
+    const char *                        cksm,
+    void *                              user_arg);
+
+globus_gfs_file_cksm_type_t
+globus_gfs_file_cksm_lookup(
+    const char *                        algorithm);
+
+globus_bool_t
+globus_gfs_file_cksm_mergeable(
+    globus_gfs_file_cksm_type_t         type);
+
+void
+globus_gfs_file_cksm_init(
+    globus_gfs_file_cksm_ctx_t *        ctx,
+    globus_gfs_file_cksm_type_t         type);
+
+void
+globus_gfs_file_cksm_update(
+    globus_gfs_file_cksm_ctx_t *        ctx,
+    const void *                        buffer,
+    globus_size_t                       length);
+
+/* append the bytes hashed in next (which must directly follow the ones
+ * hashed in ctx) to ctx.  mergeable algorithms only.
+ */
+void
+globus_gfs_file_cksm_merge(
+    globus_gfs_file_cksm_ctx_t *        ctx,
+    const globus_gfs_file_cksm_ctx_t *  next);
+
+/* out must hold GLOBUS_GFS_FILE_CKSM_MAX_LEN bytes */
+void
+globus_gfs_file_cksm_final(
+    globus_gfs_file_cksm_ctx_t *        ctx,
+    char *                              out);
+
+/*
+ * checksum length bytes (-1 for all) of pathname starting at offset, using
+ * up to threads threads.  progress and done are called from the engine's
+ * threads.  returns 0 if the checksum was started, otherwise an errno
+ * value (ENOTSUP if threads are unavailable) and no callbacks will be made.
+ */
+int
+globus_gfs_file_cksm_compute(
+    const char *                        pathname,
+    globus_gfs_file_cksm_type_t         type,
+    globus_off_t                        offset,
+    globus_off_t                        length,
+    globus_size_t                       block_size,
+    int                                 threads,
+    globus_gfs_file_cksm_progress_cb_t  progress_cb,
+    globus_gfs_file_cksm_done_cb_t      done_cb,
+    void *                              user_arg);
+
+/*
+ * ranges of a file hashed out of order, e.g. blocks of a mode E transfer
+ * as they arrive.  adjacent ranges are merged as they meet, so a complete
+ * transfer ends up as a single range.  mergeable algorithms only.
+ */
+typedef struct globus_gfs_file_cksm_ranges_s globus_gfs_file_cksm_ranges_t;
+
+globus_gfs_file_cksm_ranges_t *
+globus_gfs_file_cksm_ranges_create(
+    globus_gfs_file_cksm_type_t         type);
+
+/* ctx holds the checksum of the bytes starting at offset */
+void
+globus_gfs_file_cksm_ranges_add(
+    globus_gfs_file_cksm_ranges_t *     ranges,
+    globus_off_t                        offset,
+    const globus_gfs_file_cksm_ctx_t *  ctx);
+
+/* true (and the checksum in out) if exactly [offset, offset + length) was
+ * added, each byte once.
+ */
+globus_bool_t
+globus_gfs_file_cksm_ranges_final(
+    globus_gfs_file_cksm_ranges_t *     ranges,
+    globus_off_t                        offset,
+    globus_off_t                        length,
+    char *                              out);
+
+void
+globus_gfs_file_cksm_ranges_destroy(
+    globus_gfs_file_cksm_ranges_t *     ranges);
+
+const char *
+globus_gfs_file_cksm_name(
+    globus_gfs_file_cksm_type_t         type);
+
+/*
+ * checksums of files and ranges of files, remembered with the identity,
+ * size and modification time the file had, so they are only reused while
+ * the file is unchanged.  whole files are kept in memory; store, if
+ * configured, also keeps every range on disk for other server processes.
+ * stat_buf passed to store is how the file looked when the checksum was
+ * started; nothing is stored if it has changed since.  a length of -1
+ * means to the end of the file.
+ */
+
+/* store is NULL, "xattr", or a directory for sidecar files.  returns 0 or
+ * an errno value.
+ */
+int
+globus_gfs_file_cksm_cache_configure(
+    const char *                        store);
+
+void
+globus_gfs_file_cksm_cache_store(
+    const char *                        pathname,
+    const struct stat *                 stat_buf,
+    globus_gfs_file_cksm_type_t         type,
+    globus_off_t                        offset,
+    globus_off_t                        length,
+    const char *                        cksm);
+
+globus_bool_t
+globus_gfs_file_cksm_cache_lookup(
+    const char *                        pathname,
+    const struct stat *                 stat_buf,
+    globus_gfs_file_cksm_type_t         type,
+    globus_off_t                        offset,
+    globus_off_t                        length,
+    char *                              out);
+
+void
+globus_gfs_file_cksm_cache_stats(
+    int *                               hits,
+    int *                               misses);
+
+#endif
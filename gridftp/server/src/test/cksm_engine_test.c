@@ -0,0 +1,716 @@
+/*
+ * Copyright 1999-2014 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "globus_common.h"
+#include "globus_preload.h"
+#include "globus_gridftp_server_file_cksm.h"
+#include <zlib.h>
+#include <fcntl.h>
+
+/*
+ * This test program checks the file DSI checksum engine:
+ *
+ * known vectors:
+ *     each algorithm against published test vectors
+ * adler32 vs zlib:
+ *     the vectorized adler32 against zlib at many lengths and alignments
+ * merge:
+ *     crc32c and adler32 of two halves merged equal the whole
+ * engine:
+ *     every algorithm, thread count and range of a file compared with a
+ *     single pass over the same bytes in memory
+ * ranges:
+ *     blocks hashed in a scrambled order add up to the whole, and a block
+ *     added twice spoils the result
+ * cache:
+ *     a stored checksum is found until the file changes
+ * sidecar store / xattr store:
+ *     checksums of parts of a file are kept on disk and found again, and
+ *     are not found once the file changes.  sidecars reached through a
+ *     symlink or a hard link, or owned by someone else than the uid they
+ *     are named for, are not believed.
+ */
+#define CKSM_ENGINE_TEST_SIZE   (1024 * 1024 + 4099)
+#define CKSM_ENGINE_TEST_BLOCK  4096
+
+typedef struct
+{
+    globus_mutex_t                      lock;
+    globus_cond_t                       cond;
+    globus_bool_t                       done;
+    int                                 error;
+    globus_off_t                        progress;
+    char                                cksm[GLOBUS_GFS_FILE_CKSM_MAX_LEN];
+} cksm_engine_test_monitor_t;
+
+static globus_byte_t *                  cksm_engine_test_data;
+
+static
+void
+cksm_engine_test_string(
+    globus_gfs_file_cksm_type_t         type,
+    const void *                        data,
+    globus_size_t                       len,
+    char *                              out)
+{
+    globus_gfs_file_cksm_ctx_t          ctx;
+
+    globus_gfs_file_cksm_init(&ctx, type);
+    globus_gfs_file_cksm_update(&ctx, data, len);
+    globus_gfs_file_cksm_final(&ctx, out);
+}
+
+static
+int
+cksm_engine_test_vectors(void)
+{
+    struct
+    {
+        const char *                    alg;
+        const char *                    input;
+        const char *                    expected;
+    } vectors[] =
+    {
+        { "crc32c", "123456789", "e3069283" },
+        { "crc32c", "", "00000000" },
+        { "adler32", "Wikipedia", "11e60398" },
+        { "adler32", "", "00000001" },
+        { "md5", "", "d41d8cd98f00b204e9800998ecf8427e" },
+        { "md5", "abc", "900150983cd24fb0d6963f7d28e17f72" },
+        { "SHA256", "abc",
+          "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" }
+    };
+    char                                cksm[GLOBUS_GFS_FILE_CKSM_MAX_LEN];
+    int                                 failed = 0;
+    int                                 i;
+
+    for(i = 0; i < sizeof(vectors) / sizeof(*vectors); i++)
+    {
+        cksm_engine_test_string(
+            globus_gfs_file_cksm_lookup(vectors[i].alg),
+            vectors[i].input, strlen(vectors[i].input), cksm);
+        if(strcmp(cksm, vectors[i].expected) != 0)
+        {
+            printf("# %s(\"%s\") = %s, expected %s\n",
+                vectors[i].alg, vectors[i].input, cksm, vectors[i].expected);
+            failed = 1;
+        }
+    }
+
+    return failed;
+}
+
+static
+int
+cksm_engine_test_adler32(void)
+{
+    globus_gfs_file_cksm_ctx_t          ctx;
+    globus_size_t                       lens[] = { 1, 31, 32, 33, 5535, 5536,
+                                                   5537, 65536, 1000003 };
+    uint32_t                            expected;
+    int                                 i;
+    int                                 skew;
+
+    for(i = 0; i < sizeof(lens) / sizeof(*lens); i++)
+    {
+        for(skew = 0; skew < 3; skew++)
+        {
+            globus_gfs_file_cksm_init(&ctx, GLOBUS_GFS_FILE_CKSM_TYPE_ADLER32);
+            globus_gfs_file_cksm_update(
+                &ctx, cksm_engine_test_data + skew, lens[i]);
+            expected = adler32(
+                adler32(0, NULL, 0), cksm_engine_test_data + skew, lens[i]);
+            if(ctx.u.adler32 != expected)
+            {
+                printf("# adler32 of %lu bytes at %d: %08x, expected %08x\n",
+                    (unsigned long) lens[i], skew, ctx.u.adler32, expected);
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static
+int
+cksm_engine_test_merge(void)
+{
+    globus_gfs_file_cksm_type_t         types[] =
+    {
+        GLOBUS_GFS_FILE_CKSM_TYPE_ADLER32,
+        GLOBUS_GFS_FILE_CKSM_TYPE_CRC32C
+    };
+    globus_gfs_file_cksm_ctx_t          a;
+    globus_gfs_file_cksm_ctx_t          b;
+    char                                merged[GLOBUS_GFS_FILE_CKSM_MAX_LEN];
+    char                                whole[GLOBUS_GFS_FILE_CKSM_MAX_LEN];
+    globus_size_t                       splits[] = { 0, 1, 4097, 777777 };
+    int                                 i;
+    int                                 j;
+
+    for(i = 0; i < sizeof(types) / sizeof(*types); i++)
+    {
+        cksm_engine_test_string(
+            types[i], cksm_engine_test_data, CKSM_ENGINE_TEST_SIZE, whole);
+        for(j = 0; j < sizeof(splits) / sizeof(*splits); j++)
+        {
+            globus_gfs_file_cksm_init(&a, types[i]);
+            globus_gfs_file_cksm_init(&b, types[i]);
+            globus_gfs_file_cksm_update(&a, cksm_engine_test_data, splits[j]);
+            globus_gfs_file_cksm_update(
+                &b, cksm_engine_test_data + splits[j],
+                CKSM_ENGINE_TEST_SIZE - splits[j]);
+            globus_gfs_file_cksm_merge(&a, &b);
+            globus_gfs_file_cksm_final(&a, merged);
+            if(strcmp(merged, whole) != 0)
+            {
+                printf("# merge at %lu: %s, expected %s\n",
+                    (unsigned long) splits[j], merged, whole);
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static
+void
+cksm_engine_test_progress_cb(
+    globus_off_t                        nbytes,
+    void *                              user_arg)
+{
+    cksm_engine_test_monitor_t *        monitor = user_arg;
+
+    globus_mutex_lock(&monitor->lock);
+    monitor->progress += nbytes;
+    globus_mutex_unlock(&monitor->lock);
+}
+
+static
+void
+cksm_engine_test_done_cb(
+    int                                 error,
+    const char *                        cksm,
+    void *                              user_arg)
+{
+    cksm_engine_test_monitor_t *        monitor = user_arg;
+
+    globus_mutex_lock(&monitor->lock);
+    {
+        monitor->error = error;
+        if(cksm)
+        {
+            strcpy(monitor->cksm, cksm);
+        }
+        monitor->done = GLOBUS_TRUE;
+        globus_cond_signal(&monitor->cond);
+    }
+    globus_mutex_unlock(&monitor->lock);
+}
+
+static
+int
+cksm_engine_test_engine(
+    const char *                        filename)
+{
+    globus_gfs_file_cksm_type_t         types[] =
+    {
+        GLOBUS_GFS_FILE_CKSM_TYPE_ADLER32,
+        GLOBUS_GFS_FILE_CKSM_TYPE_MD5,
+        GLOBUS_GFS_FILE_CKSM_TYPE_CRC32C,
+        GLOBUS_GFS_FILE_CKSM_TYPE_SHA256
+    };
+    struct
+    {
+        globus_off_t                    offset;
+        globus_off_t                    length;
+    } ranges[] =
+    {
+        { 0, -1 },
+        { 0, 0 },
+        { 12345, 700001 },
+        { 100, CKSM_ENGINE_TEST_SIZE },
+        { CKSM_ENGINE_TEST_SIZE, -1 }
+    };
+    int                                 threads[] = { 1, 3, 8 };
+    cksm_engine_test_monitor_t          monitor;
+    char                                expected[GLOBUS_GFS_FILE_CKSM_MAX_LEN];
+    globus_off_t                        len;
+    int                                 failed = 0;
+    int                                 rc;
+    int                                 t;
+    int                                 r;
+    int                                 n;
+
+    globus_mutex_init(&monitor.lock, NULL);
+    globus_cond_init(&monitor.cond, NULL);
+    for(t = 0; t < sizeof(types) / sizeof(*types); t++)
+    {
+        for(r = 0; r < sizeof(ranges) / sizeof(*ranges); r++)
+        {
+            len = CKSM_ENGINE_TEST_SIZE - ranges[r].offset;
+            if(ranges[r].length >= 0 && ranges[r].length < len)
+            {
+                len = ranges[r].length;
+            }
+            cksm_engine_test_string(
+                types[t], cksm_engine_test_data + ranges[r].offset, len,
+                expected);
+
+            for(n = 0; n < sizeof(threads) / sizeof(*threads); n++)
+            {
+                monitor.done = GLOBUS_FALSE;
+                monitor.error = 0;
+                monitor.progress = 0;
+                monitor.cksm[0] = '\0';
+
+                rc = globus_gfs_file_cksm_compute(
+                    filename,
+                    types[t],
+                    ranges[r].offset,
+                    ranges[r].length,
+                    CKSM_ENGINE_TEST_BLOCK,
+                    threads[n],
+                    cksm_engine_test_progress_cb,
+                    cksm_engine_test_done_cb,
+                    &monitor);
+                if(rc == 0)
+                {
+                    globus_mutex_lock(&monitor.lock);
+                    while(!monitor.done)
+                    {
+                        globus_cond_wait(&monitor.cond, &monitor.lock);
+                    }
+                    globus_mutex_unlock(&monitor.lock);
+                }
+                if(rc != 0 || monitor.error != 0 ||
+                    monitor.progress != len ||
+                    strcmp(monitor.cksm, expected) != 0)
+                {
+                    printf("# type %d range %d threads %d: rc %d error %d "
+                        "progress %"GLOBUS_OFF_T_FORMAT" %s, expected %s\n",
+                        (int) types[t], r, threads[n], rc, monitor.error,
+                        monitor.progress, monitor.cksm, expected);
+                    failed = 1;
+                }
+            }
+        }
+    }
+
+    /* a missing file fails before any callback */
+    rc = globus_gfs_file_cksm_compute(
+        "/nonexistent/cksm_engine_test", GLOBUS_GFS_FILE_CKSM_TYPE_MD5, 0, -1,
+        CKSM_ENGINE_TEST_BLOCK, 2, NULL, cksm_engine_test_done_cb, &monitor);
+    if(rc != ENOENT)
+    {
+        printf("# missing file: rc %d\n", rc);
+        failed = 1;
+    }
+    globus_cond_destroy(&monitor.cond);
+    globus_mutex_destroy(&monitor.lock);
+
+    return failed;
+}
+
+static
+int
+cksm_engine_test_ranges(void)
+{
+    globus_gfs_file_cksm_ranges_t *     ranges;
+    globus_gfs_file_cksm_ctx_t          ctx;
+    char                                expected[GLOBUS_GFS_FILE_CKSM_MAX_LEN];
+    char                                cksm[GLOBUS_GFS_FILE_CKSM_MAX_LEN];
+    int                                 nblocks;
+    int                                 i;
+    int                                 b;
+    int                                 failed = 0;
+
+    cksm_engine_test_string(
+        GLOBUS_GFS_FILE_CKSM_TYPE_CRC32C,
+        cksm_engine_test_data, CKSM_ENGINE_TEST_SIZE, expected);
+
+    nblocks = (CKSM_ENGINE_TEST_SIZE + CKSM_ENGINE_TEST_BLOCK - 1) /
+        CKSM_ENGINE_TEST_BLOCK;
+    ranges = globus_gfs_file_cksm_ranges_create(
+        GLOBUS_GFS_FILE_CKSM_TYPE_CRC32C);
+    for(i = 0; i < nblocks; i++)
+    {
+        /* 97 is prime to nblocks, so this visits every block once */
+        b = (int) (((long) i * 97) % nblocks);
+        globus_gfs_file_cksm_init(&ctx, GLOBUS_GFS_FILE_CKSM_TYPE_CRC32C);
+        globus_gfs_file_cksm_update(
+            &ctx,
+            cksm_engine_test_data + (globus_off_t) b * CKSM_ENGINE_TEST_BLOCK,
+            b == nblocks - 1
+                ? CKSM_ENGINE_TEST_SIZE - b * CKSM_ENGINE_TEST_BLOCK
+                : CKSM_ENGINE_TEST_BLOCK);
+        globus_gfs_file_cksm_ranges_add(
+            ranges, (globus_off_t) b * CKSM_ENGINE_TEST_BLOCK, &ctx);
+
+        if(i == nblocks / 2 && globus_gfs_file_cksm_ranges_final(
+            ranges, 0, CKSM_ENGINE_TEST_SIZE, cksm))
+        {
+            printf("# incomplete ranges gave a checksum\n");
+            failed = 1;
+        }
+    }
+    if(!globus_gfs_file_cksm_ranges_final(
+            ranges, 0, CKSM_ENGINE_TEST_SIZE, cksm) ||
+        strcmp(cksm, expected) != 0)
+    {
+        printf("# scrambled ranges: %s, expected %s\n", cksm, expected);
+        failed = 1;
+    }
+
+    /* a retransmitted block must not be counted twice */
+    globus_gfs_file_cksm_ranges_add(ranges, CKSM_ENGINE_TEST_BLOCK, &ctx);
+    if(globus_gfs_file_cksm_ranges_final(
+        ranges, 0, CKSM_ENGINE_TEST_SIZE, cksm))
+    {
+        printf("# overlapping ranges gave a checksum\n");
+        failed = 1;
+    }
+    globus_gfs_file_cksm_ranges_destroy(ranges);
+
+    if(globus_gfs_file_cksm_ranges_create(
+        GLOBUS_GFS_FILE_CKSM_TYPE_MD5) != NULL)
+    {
+        printf("# md5 ranges created\n");
+        failed = 1;
+    }
+
+    return failed;
+}
+
+static
+int
+cksm_engine_test_cache(
+    const char *                        filename)
+{
+    struct stat                         stat_buf;
+    char                                cksm[GLOBUS_GFS_FILE_CKSM_MAX_LEN];
+    FILE *                              fp;
+    int                                 failed = 0;
+
+    if(stat(filename, &stat_buf) != 0)
+    {
+        return 1;
+    }
+    globus_gfs_file_cksm_cache_store(
+        filename, &stat_buf, GLOBUS_GFS_FILE_CKSM_TYPE_ADLER32,
+        0, -1, "0badc0de");
+
+    if(!globus_gfs_file_cksm_cache_lookup(
+            filename, &stat_buf, GLOBUS_GFS_FILE_CKSM_TYPE_ADLER32,
+            0, -1, cksm) ||
+        strcmp(cksm, "0badc0de") != 0)
+    {
+        printf("# stored checksum not found\n");
+        failed = 1;
+    }
+    if(globus_gfs_file_cksm_cache_lookup(
+        filename, &stat_buf, GLOBUS_GFS_FILE_CKSM_TYPE_MD5, 0, -1, cksm))
+    {
+        printf("# found a checksum of another type\n");
+        failed = 1;
+    }
+    if(globus_gfs_file_cksm_cache_lookup(
+        filename, &stat_buf, GLOBUS_GFS_FILE_CKSM_TYPE_ADLER32, 1, -1, cksm))
+    {
+        printf("# whole file checksum used for a part\n");
+        failed = 1;
+    }
+
+    fp = fopen(filename, "a");
+    if(fp)
+    {
+        fputc('x', fp);
+        fclose(fp);
+    }
+    if(stat(filename, &stat_buf) != 0 ||
+        globus_gfs_file_cksm_cache_lookup(
+            filename, &stat_buf, GLOBUS_GFS_FILE_CKSM_TYPE_ADLER32,
+            0, -1, cksm))
+    {
+        printf("# checksum of a changed file found\n");
+        failed = 1;
+    }
+
+    return failed;
+}
+
+/* a sidecar store's records must be our own plain file to be found */
+static
+int
+cksm_engine_test_sidecar_trust(
+    const char *                        filename,
+    const char *                        dir,
+    const struct stat *                 stat_buf)
+{
+    char                                sidecar[256];
+    char                                aside[256];
+    char                                cksm[GLOBUS_GFS_FILE_CKSM_MAX_LEN];
+    int                                 failed = 0;
+    int                                 fd;
+
+    sprintf(sidecar, "%s/%lu.%lu.%lu", dir,
+        (unsigned long) stat_buf->st_dev,
+        (unsigned long) stat_buf->st_ino,
+        (unsigned long) geteuid());
+    sprintf(aside, "%s/aside", dir);
+    if(rename(sidecar, aside) != 0)
+    {
+        printf("# no sidecar at %s\n", sidecar);
+        return 1;
+    }
+
+    if(symlink("aside", sidecar) == 0)
+    {
+        if(globus_gfs_file_cksm_cache_lookup(
+            filename, stat_buf, GLOBUS_GFS_FILE_CKSM_TYPE_MD5,
+            100, 200, cksm))
+        {
+            printf("# sidecar found through a symlink\n");
+            failed = 1;
+        }
+        unlink(sidecar);
+    }
+    if(link(aside, sidecar) == 0)
+    {
+        if(globus_gfs_file_cksm_cache_lookup(
+            filename, stat_buf, GLOBUS_GFS_FILE_CKSM_TYPE_MD5,
+            100, 200, cksm))
+        {
+            printf("# sidecar found through a hard link\n");
+            failed = 1;
+        }
+        unlink(sidecar);
+    }
+    /* only root can give a file away */
+    fd = open(aside, O_RDONLY);
+    if(geteuid() == 0 && fd >= 0)
+    {
+        char                            buffer[4096];
+        globus_ssize_t                  len;
+        int                             out;
+
+        len = read(fd, buffer, sizeof(buffer));
+        out = open(sidecar, O_WRONLY | O_CREAT | O_EXCL, 0644);
+        if(out >= 0 &&
+            write(out, buffer, len) == len &&
+            fchown(out, 65534, -1) == 0)
+        {
+            if(globus_gfs_file_cksm_cache_lookup(
+                filename, stat_buf, GLOBUS_GFS_FILE_CKSM_TYPE_MD5,
+                100, 200, cksm))
+            {
+                printf("# sidecar owned by another user found\n");
+                failed = 1;
+            }
+        }
+        if(out >= 0)
+        {
+            close(out);
+        }
+        unlink(sidecar);
+    }
+    if(fd >= 0)
+    {
+        close(fd);
+    }
+
+    if(rename(aside, sidecar) != 0 ||
+        !globus_gfs_file_cksm_cache_lookup(
+            filename, stat_buf, GLOBUS_GFS_FILE_CKSM_TYPE_MD5, 100, 200, cksm))
+    {
+        printf("# sidecar not found once put back\n");
+        failed = 1;
+    }
+
+    return failed;
+}
+
+/* returns -1 if the store is not supported here */
+static
+int
+cksm_engine_test_store(
+    const char *                        filename,
+    const char *                        store)
+{
+    struct stat                         stat_buf;
+    char                                cksm[GLOBUS_GFS_FILE_CKSM_MAX_LEN];
+    FILE *                              fp;
+    int                                 failed = 0;
+
+    if(globus_gfs_file_cksm_cache_configure(store) != 0 ||
+        stat(filename, &stat_buf) != 0)
+    {
+        return -1;
+    }
+
+    /* parts of files are only kept in the store */
+    globus_gfs_file_cksm_cache_store(
+        filename, &stat_buf, GLOBUS_GFS_FILE_CKSM_TYPE_MD5,
+        100, 200, "0123456789abcdef0123456789abcdef");
+    globus_gfs_file_cksm_cache_store(
+        filename, &stat_buf, GLOBUS_GFS_FILE_CKSM_TYPE_CRC32C,
+        100, -1, "12345678");
+    if(!globus_gfs_file_cksm_cache_lookup(
+        filename, &stat_buf, GLOBUS_GFS_FILE_CKSM_TYPE_MD5, 100, 200, cksm))
+    {
+        globus_gfs_file_cksm_cache_configure(NULL);
+        /* e.g. no user xattrs on this file system */
+        return -1;
+    }
+    if(strcmp(cksm, "0123456789abcdef0123456789abcdef") != 0)
+    {
+        printf("# %s: md5 range %s\n", store, cksm);
+        failed = 1;
+    }
+    if(!globus_gfs_file_cksm_cache_lookup(
+            filename, &stat_buf, GLOBUS_GFS_FILE_CKSM_TYPE_CRC32C,
+            100, stat_buf.st_size - 100, cksm) ||
+        strcmp(cksm, "12345678") != 0)
+    {
+        printf("# %s: crc32c range not found\n", store);
+        failed = 1;
+    }
+    if(globus_gfs_file_cksm_cache_lookup(
+        filename, &stat_buf, GLOBUS_GFS_FILE_CKSM_TYPE_MD5, 100, 201, cksm))
+    {
+        printf("# %s: found a checksum of another range\n", store);
+        failed = 1;
+    }
+    if(strcmp(store, "xattr") != 0 &&
+        cksm_engine_test_sidecar_trust(filename, store, &stat_buf) != 0)
+    {
+        failed = 1;
+    }
+
+    fp = fopen(filename, "a");
+    if(fp)
+    {
+        fputc('y', fp);
+        fclose(fp);
+    }
+    if(stat(filename, &stat_buf) != 0 ||
+        globus_gfs_file_cksm_cache_lookup(
+            filename, &stat_buf, GLOBUS_GFS_FILE_CKSM_TYPE_MD5,
+            100, 200, cksm))
+    {
+        printf("# %s: checksum of a changed file found\n", store);
+        failed = 1;
+    }
+    globus_gfs_file_cksm_cache_configure(NULL);
+
+    return failed;
+}
+
+int main()
+{
+    char                                filename[] = "cksm_engine_test.XXXXXX";
+    int                                 failed = 0;
+    int                                 fd;
+    int                                 i;
+    unsigned                            seed = 42;
+
+    LTDL_SET_PRELOADED_SYMBOLS();
+    printf("1..8\n");
+
+    globus_thread_set_model("pthread");
+    globus_module_activate(GLOBUS_COMMON_MODULE);
+
+    cksm_engine_test_data = malloc(CKSM_ENGINE_TEST_SIZE);
+    for(i = 0; i < CKSM_ENGINE_TEST_SIZE; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        cksm_engine_test_data[i] = (globus_byte_t) (seed >> 16);
+    }
+
+    fd = mkstemp(filename);
+    if(fd < 0 ||
+        write(fd, cksm_engine_test_data, CKSM_ENGINE_TEST_SIZE)
+            != CKSM_ENGINE_TEST_SIZE)
+    {
+        printf("Bail out! can't create %s\n", filename);
+        return 99;
+    }
+    close(fd);
+
+    i = cksm_engine_test_vectors();
+    printf("%s 1 - known_vectors_test\n", i ? "not ok" : "ok");
+    failed += i;
+
+    i = cksm_engine_test_adler32();
+    printf("%s 2 - adler32_zlib_test\n", i ? "not ok" : "ok");
+    failed += i;
+
+    i = cksm_engine_test_merge();
+    printf("%s 3 - merge_test\n", i ? "not ok" : "ok");
+    failed += i;
+
+    i = cksm_engine_test_engine(filename);
+    printf("%s 4 - engine_test\n", i ? "not ok" : "ok");
+    failed += i;
+
+    i = cksm_engine_test_ranges();
+    printf("%s 5 - ranges_test\n", i ? "not ok" : "ok");
+    failed += i;
+
+    /* last, it changes the file */
+    i = cksm_engine_test_cache(filename);
+    printf("%s 6 - cache_test\n", i ? "not ok" : "ok");
+    failed += i;
+
+    {
+        char                            dir[] = "cksm_engine_test.XXXXXX";
+        char                            sidecar[128];
+        struct stat                     stat_buf;
+
+        i = mkdtemp(dir) ? cksm_engine_test_store(filename, dir) : 1;
+        printf("%s 7 - sidecar_store_test\n", i ? "not ok" : "ok");
+        failed += i != 0;
+
+        if(stat(filename, &stat_buf) == 0)
+        {
+            sprintf(sidecar, "%s/%lu.%lu.%lu", dir,
+                (unsigned long) stat_buf.st_dev,
+                (unsigned long) stat_buf.st_ino,
+                (unsigned long) geteuid());
+            remove(sidecar);
+        }
+        remove(dir);
+    }
+
+    i = cksm_engine_test_store(filename, "xattr");
+    if(i < 0)
+    {
+        printf("ok 8 - xattr_store_test # SKIP no user xattrs\n");
+    }
+    else
+    {
+        printf("%s 8 - xattr_store_test\n", i ? "not ok" : "ok");
+        failed += i;
+    }
+
+    remove(filename);
+    free(cksm_engine_test_data);
+    globus_module_deactivate_all();
+
+    return failed;
+}
@@ -33,6 +33,7 @@
 #include "openssl/rand.h"
 #include "openssl/x509v3.h"
 #include "version.h"
+#include <sys/stat.h>
 
 #ifndef BUILD_FOR_K5CERT_ONLY
 #include "globus_oldgaa.h"
@@ -87,6 +88,49 @@ globus_module_descriptor_t globus_i_gsi_callback_module =
 static int globus_i_gsi_callback_SSL_callback_data_index = -1;
 static int globus_i_gsi_callback_X509_STORE_callback_data_index = -1;
 
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+/*
+ * Chains verified during SSL handshakes, so that a peer opening many
+ * connections does not have the CRLs and signing policies of its issuers
+ * read and evaluated each time.  The chain itself is still verified, and
+ * the verify callback still run, on every handshake; only those file
+ * based checks are skipped for a chain found here.  Entries are keyed by
+ * a digest of the chain and the verification settings, expire with the
+ * first certificate in the chain or after
+ * globus_l_gsi_callback_chain_cache_timeout seconds, and are dropped when
+ * the trusted certificates directory or the CRL or signing policy files
+ * of an issuer in the chain change.
+ */
+
+/* default lifetime of a cached verification, in seconds */
+#define GLOBUS_L_GSI_CALLBACK_CHAIN_CACHE_TIMEOUT 300
+/* number of cached verifications */
+#define GLOBUS_L_GSI_CALLBACK_CHAIN_CACHE_SIZE 128
+/* longest verified chain that is cached */
+#define GLOBUS_L_GSI_CALLBACK_CHAIN_CACHE_DEPTH 16
+
+typedef struct
+{
+    unsigned char                       key[EVP_MAX_MD_SIZE];
+    unsigned int                        key_length;
+    time_t                              expires;
+    time_t                              cert_dir_mtime;
+    unsigned long                       issuer_hashes[
+                                    GLOBUS_L_GSI_CALLBACK_CHAIN_CACHE_DEPTH];
+    int                                 issuer_count;
+    unsigned char                       files_stamp[EVP_MAX_MD_SIZE];
+    unsigned int                        files_stamp_length;
+    unsigned long                       last_used;
+}
+globus_l_gsi_callback_chain_entry_t;
+
+static globus_mutex_t                   globus_l_gsi_callback_chain_mutex;
+static int                              globus_l_gsi_callback_chain_cache_timeout;
+static unsigned long                    globus_l_gsi_callback_chain_cache_clock;
+static globus_l_gsi_callback_chain_entry_t
+    globus_l_gsi_callback_chain_cache[GLOBUS_L_GSI_CALLBACK_CHAIN_CACHE_SIZE];
+#endif
+
 static int
 globus_l_gsi_callback_openssl_new(
     void *                              parent, 
@@ -215,6 +259,21 @@ globus_l_gsi_callback_activate(void)
 
     globus_mutex_init(&globus_l_gsi_callback_oldgaa_mutex, NULL);
     globus_mutex_init(&globus_l_gsi_callback_verify_mutex, NULL);
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+    globus_mutex_init(&globus_l_gsi_callback_chain_mutex, NULL);
+
+    tmp_string = globus_module_getenv(
+        "GLOBUS_GSI_CALLBACK_CHAIN_CACHE_TIMEOUT");
+    if(tmp_string != GLOBUS_NULL)
+    {
+        globus_l_gsi_callback_chain_cache_timeout = atoi(tmp_string);
+    }
+    else
+    {
+        globus_l_gsi_callback_chain_cache_timeout =
+            GLOBUS_L_GSI_CALLBACK_CHAIN_CACHE_TIMEOUT;
+    }
+#endif
     
     OpenSSL_add_all_algorithms();
 
@@ -277,6 +336,11 @@ globus_l_gsi_callback_deactivate(void)
 
     globus_mutex_destroy(&globus_l_gsi_callback_oldgaa_mutex);
     globus_mutex_destroy(&globus_l_gsi_callback_verify_mutex);
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+    memset(globus_l_gsi_callback_chain_cache, 0,
+           sizeof(globus_l_gsi_callback_chain_cache));
+    globus_mutex_destroy(&globus_l_gsi_callback_chain_mutex);
+#endif
     globus_module_deactivate(GLOBUS_GSI_OPENSSL_ERROR_MODULE);
     globus_module_deactivate(GLOBUS_GSI_SYSCONFIG_MODULE);
     globus_module_deactivate(GLOBUS_COMMON_MODULE);
@@ -354,6 +418,374 @@ globus_gsi_callback_get_SSL_callback_data_index(
     return result;
 }
 
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+/*
+ * Return the callback data for a handshake whose result may be cached, or
+ * NULL.
+ */
+static
+globus_gsi_callback_data_t
+globus_l_gsi_callback_chain_cache_data(
+    X509_STORE_CTX *                    context)
+{
+    SSL *                               ssl;
+    globus_gsi_callback_data_t *        callback_data;
+
+    if(globus_l_gsi_callback_chain_cache_timeout <= 0 ||
+       X509_STORE_CTX_get0_cert(context) == NULL)
+    {
+        return NULL;
+    }
+
+    ssl = (SSL *) X509_STORE_CTX_get_ex_data(
+        context,
+        SSL_get_ex_data_X509_STORE_CTX_idx());
+    if(!ssl)
+    {
+        return NULL;
+    }
+
+    callback_data = (globus_gsi_callback_data_t *) SSL_get_ex_data(
+        ssl,
+        globus_i_gsi_callback_SSL_callback_data_index);
+    if(!callback_data || !*callback_data ||
+       (*callback_data)->cert_dir == NULL ||
+       (*callback_data)->cert_depth != 0)
+    {
+        return NULL;
+    }
+
+    return *callback_data;
+}
+/* globus_l_gsi_callback_chain_cache_data() */
+
+/*
+ * Hash the certificates presented by the peer together with the settings
+ * that affect their verification.  Returns 1 and sets key_length on
+ * success.
+ */
+static
+int
+globus_l_gsi_callback_chain_cache_key(
+    X509_STORE_CTX *                    context,
+    globus_gsi_callback_data_t          callback_data,
+    unsigned char *                     key,
+    unsigned int *                      key_length)
+{
+    STACK_OF(X509) *                    untrusted;
+    EVP_MD_CTX *                        md_ctx;
+    unsigned char                       digest[EVP_MAX_MD_SIZE];
+    unsigned int                        digest_length;
+    int                                 settings[3];
+    int                                 ok;
+
+    settings[0] = callback_data->max_proxy_depth;
+    settings[1] = callback_data->check_self_signed_policy;
+    settings[2] = callback_data->allow_missing_signing_policy;
+
+    md_ctx = EVP_MD_CTX_new();
+    ok = md_ctx != NULL &&
+         EVP_DigestInit_ex(md_ctx, EVP_sha256(), NULL) &&
+         EVP_DigestUpdate(md_ctx, settings, sizeof(settings)) &&
+         EVP_DigestUpdate(md_ctx, callback_data->cert_dir,
+                          strlen(callback_data->cert_dir) + 1) &&
+         X509_digest(X509_STORE_CTX_get0_cert(context),
+                     EVP_sha256(), digest, &digest_length) &&
+         EVP_DigestUpdate(md_ctx, digest, digest_length);
+
+    untrusted = X509_STORE_CTX_get0_untrusted(context);
+    for(int i = 0; ok && i < sk_X509_num(untrusted); i++)
+    {
+        ok = X509_digest(sk_X509_value(untrusted, i),
+                         EVP_sha256(), digest, &digest_length) &&
+             EVP_DigestUpdate(md_ctx, digest, digest_length);
+    }
+
+    ok = ok && EVP_DigestFinal_ex(md_ctx, key, key_length);
+    EVP_MD_CTX_free(md_ctx);
+
+    return ok;
+}
+/* globus_l_gsi_callback_chain_cache_key() */
+
+/*
+ * Hash the modification time, size and inode of the signing policy file
+ * and the CRL files of each issuer, recording the ones that are missing
+ * too, so that adding, replacing or touching any of them changes the
+ * stamp.  Sets newest_mtime to the latest modification time seen.
+ * Returns 1 and sets stamp_length on success.
+ */
+static
+int
+globus_l_gsi_callback_chain_cache_stamp(
+    const char *                        cert_dir,
+    const unsigned long *               issuer_hashes,
+    int                                 issuer_count,
+    unsigned char *                     stamp,
+    unsigned int *                      stamp_length,
+    time_t *                            newest_mtime)
+{
+    EVP_MD_CTX *                        md_ctx;
+    struct stat                         file_stat;
+    char *                              path;
+    struct
+    {
+        unsigned long                   hash;
+        int                             crl_index;
+        int                             exists;
+        time_t                          mtime;
+        off_t                           size;
+        ino_t                           ino;
+    }                                   record;
+    int                                 ok;
+
+    *newest_mtime = 0;
+
+    md_ctx = EVP_MD_CTX_new();
+    ok = md_ctx != NULL &&
+         EVP_DigestInit_ex(md_ctx, EVP_sha256(), NULL);
+
+    for(int i = 0; ok && i < issuer_count; i++)
+    {
+        /* crl_index -1 is the signing policy, then .r0, .r1, ... */
+        for(int crl_index = -1; ok; crl_index++)
+        {
+            if(crl_index < 0)
+            {
+                path = globus_common_create_string(
+                    "%s/%08lx.signing_policy", cert_dir, issuer_hashes[i]);
+            }
+            else
+            {
+                path = globus_common_create_string(
+                    "%s/%08lx.r%d", cert_dir, issuer_hashes[i], crl_index);
+            }
+            if(path == NULL)
+            {
+                ok = 0;
+                break;
+            }
+
+            memset(&record, 0, sizeof(record));
+            record.hash = issuer_hashes[i];
+            record.crl_index = crl_index;
+            if(stat(path, &file_stat) == 0)
+            {
+                record.exists = 1;
+                record.mtime = file_stat.st_mtime;
+                record.size = file_stat.st_size;
+                record.ino = file_stat.st_ino;
+                if(file_stat.st_mtime > *newest_mtime)
+                {
+                    *newest_mtime = file_stat.st_mtime;
+                }
+            }
+            free(path);
+
+            ok = EVP_DigestUpdate(md_ctx, &record, sizeof(record));
+
+            /* the CRL lookup stops at the first missing .rN file */
+            if(crl_index >= 0 && !record.exists)
+            {
+                break;
+            }
+        }
+    }
+
+    ok = ok && EVP_DigestFinal_ex(md_ctx, stamp, stamp_length);
+    EVP_MD_CTX_free(md_ctx);
+
+    return ok;
+}
+/* globus_l_gsi_callback_chain_cache_stamp() */
+
+/*
+ * Look for an unexpired verification of this chain, made while the
+ * trusted certificates directory had the modification time cert_dir_mtime
+ * and the CRL and signing policy files of its issuers were unchanged.
+ * Returns 1 on a hit.
+ */
+static
+int
+globus_l_gsi_callback_chain_cache_lookup(
+    const unsigned char *               key,
+    unsigned int                        key_length,
+    time_t                              cert_dir_mtime,
+    const char *                        cert_dir)
+{
+    globus_l_gsi_callback_chain_entry_t *
+                                        entry;
+    unsigned long                       issuer_hashes[
+                                    GLOBUS_L_GSI_CALLBACK_CHAIN_CACHE_DEPTH];
+    int                                 issuer_count = 0;
+    unsigned char                       files_stamp[EVP_MAX_MD_SIZE];
+    unsigned int                        files_stamp_length = 0;
+    unsigned char                       stamp[EVP_MAX_MD_SIZE];
+    unsigned int                        stamp_length;
+    time_t                              newest_mtime;
+    int                                 found = 0;
+
+    globus_mutex_lock(&globus_l_gsi_callback_chain_mutex);
+    for(int i = 0; i < GLOBUS_L_GSI_CALLBACK_CHAIN_CACHE_SIZE; i++)
+    {
+        entry = &globus_l_gsi_callback_chain_cache[i];
+        if(entry->key_length != key_length ||
+           memcmp(entry->key, key, key_length) != 0)
+        {
+            continue;
+        }
+
+        if(entry->expires > time(NULL) &&
+           entry->cert_dir_mtime == cert_dir_mtime)
+        {
+            entry->last_used = ++globus_l_gsi_callback_chain_cache_clock;
+            issuer_count = entry->issuer_count;
+            memcpy(issuer_hashes, entry->issuer_hashes,
+                   issuer_count * sizeof(unsigned long));
+            files_stamp_length = entry->files_stamp_length;
+            memcpy(files_stamp, entry->files_stamp, files_stamp_length);
+            found = 1;
+        }
+        else
+        {
+            entry->key_length = 0;
+        }
+        break;
+    }
+    globus_mutex_unlock(&globus_l_gsi_callback_chain_mutex);
+
+    /* stat the issuers' files without holding up other handshakes */
+    if(found)
+    {
+        found = globus_l_gsi_callback_chain_cache_stamp(
+                    cert_dir, issuer_hashes, issuer_count,
+                    stamp, &stamp_length, &newest_mtime) &&
+                stamp_length == files_stamp_length &&
+                memcmp(stamp, files_stamp, stamp_length) == 0;
+    }
+
+    return found;
+}
+/* globus_l_gsi_callback_chain_cache_lookup() */
+
+/*
+ * Remember a successful verification until the first certificate in the
+ * verified chain expires, or for the cache timeout if that is sooner.
+ * An existing entry for the chain is replaced, then an empty or expired
+ * one, then the least recently used.
+ */
+static
+void
+globus_l_gsi_callback_chain_cache_store(
+    const unsigned char *               key,
+    unsigned int                        key_length,
+    time_t                              cert_dir_mtime,
+    X509_STORE_CTX *                    context,
+    globus_gsi_callback_data_t          callback_data)
+{
+    globus_l_gsi_callback_chain_entry_t *
+                                        entry;
+    globus_l_gsi_callback_chain_entry_t *
+                                        victim = NULL;
+    STACK_OF(X509) *                    verified_chain;
+    unsigned long                       issuer_hashes[
+                                    GLOBUS_L_GSI_CALLBACK_CHAIN_CACHE_DEPTH];
+    int                                 issuer_count;
+    unsigned char                       stamp[EVP_MAX_MD_SIZE];
+    unsigned int                        stamp_length;
+    time_t                              newest_mtime;
+    time_t                              now;
+    time_t                              expires;
+    int                                 day;
+    int                                 sec;
+
+    now = time(NULL);
+    expires = now + globus_l_gsi_callback_chain_cache_timeout;
+    verified_chain = X509_STORE_CTX_get0_chain(context);
+    issuer_count = sk_X509_num(verified_chain);
+    if(issuer_count <= 0 ||
+       issuer_count > GLOBUS_L_GSI_CALLBACK_CHAIN_CACHE_DEPTH)
+    {
+        return;
+    }
+
+    for(int i = 0; i < issuer_count; i++)
+    {
+        X509 *                          cert;
+
+        cert = sk_X509_value(verified_chain, i);
+        if(!ASN1_TIME_diff(&day, &sec, NULL, X509_get0_notAfter(cert)))
+        {
+            return;
+        }
+        if(now + (time_t) day * 86400 + sec < expires)
+        {
+            expires = now + (time_t) day * 86400 + sec;
+        }
+        issuer_hashes[i] = X509_NAME_hash(X509_get_issuer_name(cert));
+    }
+    if(expires <= now)
+    {
+        return;
+    }
+
+    if(!globus_l_gsi_callback_chain_cache_stamp(
+            callback_data->cert_dir, issuer_hashes, issuer_count,
+            stamp, &stamp_length, &newest_mtime))
+    {
+        return;
+    }
+
+    /*
+     * A file or directory modified within the last second may change again
+     * without its modification time changing.
+     */
+    if(cert_dir_mtime >= now - 1 || newest_mtime >= now - 1)
+    {
+        return;
+    }
+
+    globus_mutex_lock(&globus_l_gsi_callback_chain_mutex);
+    for(int i = 0; i < GLOBUS_L_GSI_CALLBACK_CHAIN_CACHE_SIZE; i++)
+    {
+        entry = &globus_l_gsi_callback_chain_cache[i];
+        if(entry->key_length == key_length &&
+           memcmp(entry->key, key, key_length) == 0)
+        {
+            victim = entry;
+            break;
+        }
+        if(entry->key_length == 0 || entry->expires <= now)
+        {
+            if(victim == NULL ||
+               (victim->key_length != 0 && victim->expires > now))
+            {
+                victim = entry;
+            }
+        }
+        else if(victim == NULL ||
+                (victim->key_length != 0 && victim->expires > now &&
+                 entry->last_used < victim->last_used))
+        {
+            victim = entry;
+        }
+    }
+
+    memcpy(victim->key, key, key_length);
+    victim->key_length = key_length;
+    victim->expires = expires;
+    victim->cert_dir_mtime = cert_dir_mtime;
+    memcpy(victim->issuer_hashes, issuer_hashes,
+           issuer_count * sizeof(unsigned long));
+    victim->issuer_count = issuer_count;
+    memcpy(victim->files_stamp, stamp, stamp_length);
+    victim->files_stamp_length = stamp_length;
+    victim->last_used = ++globus_l_gsi_callback_chain_cache_clock;
+    globus_mutex_unlock(&globus_l_gsi_callback_chain_mutex);
+}
+/* globus_l_gsi_callback_chain_cache_store() */
+#endif
+
 /**
  * @brief Certificate verify wrapper
  * @ingroup globus_gsi_callback_functions
@@ -362,6 +794,16 @@ globus_gsi_callback_get_SSL_callback_data_index(
  * purpose of a replacing the standard issuer check with one that deals with
  * proxy certificates. Should be used with SSL_CTX_set_cert_verify_callback()
  *
+ * Successful verifications of chains presented in SSL handshakes are
+ * cached, so that a peer which opens many connections has the CRLs and
+ * signing policies of its issuers checked once.  The chain is verified on
+ * every handshake; a cached result only skips those checks, until the
+ * first certificate in the chain expires, the trusted certificates
+ * directory or an issuer's CRL or signing policy file is modified, or
+ * the number of seconds in the GLOBUS_GSI_CALLBACK_CHAIN_CACHE_TIMEOUT
+ * environment variable (default 300) passes.  Setting it to 0 disables
+ * the cache.
+ *
  * @param context
  *        The X509_STORE_CTX for which to register the callback.
  * @param arg
@@ -376,6 +818,12 @@ globus_gsi_callback_X509_verify_cert(
     void *                              arg)
 {
     int                                 result;
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+    globus_gsi_callback_data_t          callback_data;
+    unsigned char                       key[EVP_MAX_MD_SIZE];
+    unsigned int                        key_length = 0;
+    struct stat                         cert_dir_stat;
+#endif
     static char *                       _function_name_ =
         "globus_gsi_callback_X509_verify_cert";
 
@@ -406,10 +854,44 @@ globus_gsi_callback_X509_verify_cert(
     X509_STORE_CTX_set_flags(
                    context, X509_V_FLAG_ALLOW_PROXY_CERTS);
     #endif
+
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+    callback_data = globus_l_gsi_callback_chain_cache_data(context);
+    if(callback_data != NULL &&
+       stat(callback_data->cert_dir, &cert_dir_stat) == 0 &&
+       globus_l_gsi_callback_chain_cache_key(
+            context, callback_data, key, &key_length))
+    {
+        callback_data->chain_cache_hit =
+            globus_l_gsi_callback_chain_cache_lookup(
+                key, key_length, cert_dir_stat.st_mtime,
+                callback_data->cert_dir);
+        if(callback_data->chain_cache_hit)
+        {
+            GLOBUS_I_GSI_CALLBACK_DEBUG_PRINT(
+                2, "Using cached CRL and signing policy checks of the "
+                   "peer's chain\n");
+        }
+    }
+#endif
+
     globus_mutex_lock(&globus_l_gsi_callback_verify_mutex);
     result = X509_verify_cert(context);
     globus_mutex_unlock(&globus_l_gsi_callback_verify_mutex);
 
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+    if(key_length > 0)
+    {
+        if(result == 1 && !callback_data->chain_cache_hit &&
+           callback_data->error == GLOBUS_SUCCESS)
+        {
+            globus_l_gsi_callback_chain_cache_store(
+                key, key_length, cert_dir_stat.st_mtime,
+                context, callback_data);
+        }
+        callback_data->chain_cache_hit = GLOBUS_FALSE;
+    }
+#endif
     GLOBUS_I_GSI_CALLBACK_DEBUG_EXIT;
     return result;
 }
@@ -830,8 +1312,12 @@ globus_i_gsi_callback_cred_verify(
         goto exit;
     }
 
-    if(callback_data->cert_type == GLOBUS_GSI_CERT_UTILS_TYPE_EEC ||
-       callback_data->cert_type == GLOBUS_GSI_CERT_UTILS_TYPE_CA)
+    /* a chain found in the verification cache has had these checked
+     * against the same CRL and signing policy files already
+     */
+    if((callback_data->cert_type == GLOBUS_GSI_CERT_UTILS_TYPE_EEC ||
+        callback_data->cert_type == GLOBUS_GSI_CERT_UTILS_TYPE_CA) &&
+       !callback_data->chain_cache_hit)
     {
         /* only want to check that the cert isn't revoked if its not
          * a proxy, since proxies don't ever get revoked
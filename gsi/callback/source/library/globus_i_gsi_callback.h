@@ -203,6 +203,9 @@ typedef struct globus_l_gsi_callback_data_s {
     globus_bool_t                       check_self_signed_policy;
     globus_bool_t                       allow_missing_signing_policy;
     globus_result_t                     error;
+    /* set while verifying a chain whose CRL and signing policy checks
+     * are cached */
+    globus_bool_t                       chain_cache_hit;
 
 } globus_i_gsi_callback_data_t;
 
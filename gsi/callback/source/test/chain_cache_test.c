@@ -0,0 +1,402 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Tests for the cache of chains verified in SSL handshakes.  A CA, its
+ * signing policy and some end entity certificates are made in a scratch
+ * trusted certificates directory.  Whether a verification used the cache
+ * is seen by rewriting the signing policy to refuse the end entity
+ * certificates while keeping its size, inode and modification time: a
+ * cached chain still verifies, an uncached one does not.
+ */
+
+#include "globus_common.h"
+#include "globus_gsi_callback.h"
+#include "openssl/ssl.h"
+#include "openssl/x509v3.h"
+#include "openssl/pem.h"
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+int
+main(int argc, char * argv[])
+{
+    /* chains are only cached with OpenSSL 1.1.0 or newer */
+    printf("1..0 # SKIP no chain cache\n");
+
+    return 0;
+}
+#else
+
+#define POLICY_FORMAT \
+    "access_id_CA      X509         '/CN=ca'\n" \
+    "pos_rights        globus        CA:sign\n" \
+    "cond_subjects     globus       '\"/%s\"'\n"
+
+static char                             cert_dir[] = "chain-cache-test.XXXXXX";
+static char *                           policy_path;
+static char *                           crl_path;
+static EVP_PKEY *                       ca_key;
+static X509 *                           ca_cert;
+static X509_STORE *                     store;
+static SSL_CTX *                        ssl_ctx;
+
+static
+EVP_PKEY *
+make_key(void)
+{
+    EVP_PKEY_CTX *                      pctx;
+    EVP_PKEY *                          key = NULL;
+
+    pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, NULL);
+    if(pctx == NULL ||
+       EVP_PKEY_keygen_init(pctx) <= 0 ||
+       EVP_PKEY_CTX_set_ec_paramgen_curve_nid(
+            pctx, NID_X9_62_prime256v1) <= 0 ||
+       EVP_PKEY_keygen(pctx, &key) <= 0)
+    {
+        key = NULL;
+    }
+    EVP_PKEY_CTX_free(pctx);
+
+    return key;
+}
+
+static
+X509 *
+make_cert(
+    const char *                        subject,
+    long                                lifetime,
+    EVP_PKEY *                          key)
+{
+    static long                         serial = 1;
+    X509 *                              cert;
+    X509_NAME *                         name;
+    X509_EXTENSION *                    ext;
+    X509V3_CTX                          v3_ctx;
+    X509 *                              issuer;
+
+    cert = X509_new();
+    name = X509_NAME_new();
+    X509_NAME_add_entry_by_txt(
+        name, "CN", MBSTRING_ASC, (const unsigned char *) subject, -1, -1, 0);
+    X509_set_version(cert, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), serial++);
+    X509_set_subject_name(cert, name);
+    X509_NAME_free(name);
+    X509_gmtime_adj(X509_getm_notBefore(cert), -3600);
+    X509_gmtime_adj(X509_getm_notAfter(cert), lifetime);
+    X509_set_pubkey(cert, key);
+
+    issuer = ca_cert ? ca_cert : cert;
+    X509_set_issuer_name(cert, X509_get_subject_name(issuer));
+    X509V3_set_ctx(&v3_ctx, issuer, cert, NULL, NULL, 0);
+    ext = X509V3_EXT_conf_nid(
+        NULL, &v3_ctx, NID_basic_constraints,
+        ca_cert ? "critical,CA:FALSE" : "critical,CA:TRUE");
+    X509_add_ext(cert, ext, -1);
+    X509_EXTENSION_free(ext);
+
+    if(!X509_sign(cert, ca_key, EVP_sha256()))
+    {
+        X509_free(cert);
+        cert = NULL;
+    }
+
+    return cert;
+}
+
+/* write the signing policy, keeping its inode and setting its mtime */
+static
+int
+write_policy(
+    const char *                        subjects,
+    time_t                              mtime)
+{
+    char                                policy[256];
+    struct timeval                      times[2];
+    int                                 fd;
+    int                                 len;
+
+    len = snprintf(policy, sizeof(policy), POLICY_FORMAT, subjects);
+    fd = open(policy_path, O_WRONLY|O_CREAT, 0644);
+    if(fd < 0 || write(fd, policy, len) != len)
+    {
+        return 0;
+    }
+    close(fd);
+
+    times[0].tv_sec = times[1].tv_sec = mtime;
+    times[0].tv_usec = times[1].tv_usec = 0;
+
+    return utimes(policy_path, times) == 0;
+}
+
+static
+int
+set_mtime(
+    const char *                        path,
+    time_t                              mtime)
+{
+    struct timeval                      times[2];
+
+    times[0].tv_sec = times[1].tv_sec = mtime;
+    times[0].tv_usec = times[1].tv_usec = 0;
+
+    return utimes(path, times) == 0;
+}
+
+/*
+ * Verify a chain the way an SSL handshake does; returns 1 if it was
+ * accepted and the verify callback recorded both certificates.
+ */
+static
+int
+verify(
+    X509 *                              cert,
+    unsigned long                       flags)
+{
+    X509_STORE_CTX *                    ctx;
+    SSL *                               ssl;
+    globus_gsi_callback_data_t          callback_data;
+    globus_result_t                     error;
+    int                                 index;
+    int                                 cert_depth = 0;
+    int                                 ok;
+
+    globus_gsi_callback_get_SSL_callback_data_index(&index);
+    globus_gsi_callback_data_init(&callback_data);
+    globus_gsi_callback_set_cert_dir(callback_data, cert_dir);
+
+    ssl = SSL_new(ssl_ctx);
+    SSL_set_ex_data(ssl, index, &callback_data);
+
+    ctx = X509_STORE_CTX_new();
+    X509_STORE_CTX_init(ctx, store, cert, NULL);
+    X509_STORE_CTX_set_ex_data(ctx, SSL_get_ex_data_X509_STORE_CTX_idx(), ssl);
+    X509_STORE_CTX_set_verify_cb(ctx, globus_gsi_callback_handshake_callback);
+    X509_STORE_CTX_set_flags(ctx, flags);
+
+    ok = globus_gsi_callback_X509_verify_cert(ctx, NULL);
+
+    globus_gsi_callback_get_error(callback_data, &error);
+    globus_gsi_callback_get_cert_depth(callback_data, &cert_depth);
+    ok = ok == 1 && error == GLOBUS_SUCCESS && cert_depth == 2;
+
+    X509_STORE_CTX_free(ctx);
+    SSL_free(ssl);
+    globus_gsi_callback_data_destroy(callback_data);
+
+    return ok;
+}
+
+static
+int
+setup(void)
+{
+    X509_LOOKUP *                       lookup;
+    char *                              path;
+    FILE *                              fp;
+    unsigned long                       hash;
+
+    if(mkdtemp(cert_dir) == NULL)
+    {
+        return 0;
+    }
+
+    ca_key = make_key();
+    if(ca_key == NULL || (ca_cert = make_cert("ca", 86400, ca_key)) == NULL)
+    {
+        return 0;
+    }
+
+    hash = X509_NAME_hash(X509_get_subject_name(ca_cert));
+    path = globus_common_create_string("%s/%08lx.0", cert_dir, hash);
+    policy_path = globus_common_create_string(
+        "%s/%08lx.signing_policy", cert_dir, hash);
+    crl_path = globus_common_create_string("%s/%08lx.r0", cert_dir, hash);
+
+    fp = fopen(path, "w");
+    if(fp == NULL || !PEM_write_X509(fp, ca_cert))
+    {
+        return 0;
+    }
+    fclose(fp);
+    set_mtime(path, time(NULL) - 60);
+    free(path);
+
+    if(!write_policy("*", time(NULL) - 60) ||
+       !set_mtime(cert_dir, time(NULL) - 60))
+    {
+        return 0;
+    }
+
+    store = X509_STORE_new();
+    lookup = X509_STORE_add_lookup(store, X509_LOOKUP_hash_dir());
+    X509_LOOKUP_add_dir(lookup, cert_dir, X509_FILETYPE_PEM);
+    ssl_ctx = SSL_CTX_new(SSLv23_method());
+
+    return store != NULL && ssl_ctx != NULL;
+}
+
+static
+void
+cleanup(void)
+{
+    char *                              path;
+
+    path = globus_common_create_string(
+        "%s/%08lx.0", cert_dir, X509_NAME_hash(X509_get_subject_name(ca_cert)));
+    remove(path);
+    free(path);
+    remove(policy_path);
+    remove(crl_path);
+    rmdir(cert_dir);
+}
+
+/* a CRL from the CA revoking nothing */
+static
+int
+write_crl(void)
+{
+    X509_CRL *                          crl;
+    ASN1_TIME *                         update;
+    FILE *                              fp;
+    int                                 ok;
+
+    crl = X509_CRL_new();
+    X509_CRL_set_version(crl, 1);
+    X509_CRL_set_issuer_name(crl, X509_get_subject_name(ca_cert));
+    update = X509_gmtime_adj(NULL, -3600);
+    X509_CRL_set1_lastUpdate(crl, update);
+    X509_gmtime_adj(update, 86400);
+    X509_CRL_set1_nextUpdate(crl, update);
+    ASN1_TIME_free(update);
+    ok = X509_CRL_sign(crl, ca_key, EVP_sha256()) &&
+         (fp = fopen(crl_path, "w")) != NULL;
+    if(ok)
+    {
+        ok = PEM_write_X509_CRL(fp, crl);
+        fclose(fp);
+    }
+    X509_CRL_free(crl);
+
+    return ok;
+}
+
+int
+main(int argc, char * argv[])
+{
+    EVP_PKEY *                          key;
+    X509 *                              cert;
+    X509 *                              other_cert;
+    X509 *                              short_cert;
+    struct stat                         st;
+    time_t                              policy_mtime;
+    int                                 failed = 0;
+    int                                 ok;
+
+    globus_libc_setenv("GLOBUS_GSI_CALLBACK_CHAIN_CACHE_TIMEOUT", "300", 1);
+    if(globus_module_activate(GLOBUS_GSI_CALLBACK_MODULE) != GLOBUS_SUCCESS)
+    {
+        exit(99);
+    }
+    SSL_library_init();
+
+    if(!setup() || (key = make_key()) == NULL)
+    {
+        cleanup();
+        exit(99);
+    }
+    cert = make_cert("test", 86400, key);
+    other_cert = make_cert("other", 86400, key);
+
+    printf("1..7\n");
+
+    policy_mtime = time(NULL) - 50;
+
+    /* a chain not seen before is checked against the policy */
+    ok = write_policy("*", policy_mtime) && verify(cert, 0);
+    printf("%s - miss_test\n", ok ? "ok" : "not ok");
+    failed += !ok;
+
+    /* the same chain again uses the cached policy check */
+    ok = write_policy("X", policy_mtime) && verify(cert, 0);
+    printf("%s - hit_test\n", ok ? "ok" : "not ok");
+    failed += !ok;
+
+    /* another chain from the same CA does not */
+    ok = !verify(other_cert, 0);
+    printf("%s - other_chain_miss_test\n", ok ? "ok" : "not ok");
+    failed += !ok;
+
+    /* touching the signing policy drops the entry */
+    ok = set_mtime(policy_path, policy_mtime - 1) && !verify(cert, 0);
+    printf("%s - signing_policy_change_test\n", ok ? "ok" : "not ok");
+    failed += !ok;
+
+    /* as does touching the trusted certificates directory */
+    policy_mtime -= 2;
+    ok = write_policy("*", policy_mtime) && verify(cert, 0) &&
+         write_policy("X", policy_mtime) && verify(cert, 0) &&
+         set_mtime(cert_dir, time(NULL) - 40) && !verify(cert, 0);
+    printf("%s - cert_dir_change_test\n", ok ? "ok" : "not ok");
+    failed += !ok;
+
+    /*
+     * and adding a CRL for the CA, even with the directory's modification
+     * time put back
+     */
+    policy_mtime -= 2;
+    ok = write_policy("*", policy_mtime) && verify(cert, 0) &&
+         write_policy("X", policy_mtime) && verify(cert, 0) &&
+         stat(cert_dir, &st) == 0 && write_crl() &&
+         set_mtime(crl_path, time(NULL) - 30) &&
+         set_mtime(cert_dir, st.st_mtime) && !verify(cert, 0);
+    printf("%s - crl_change_test\n", ok ? "ok" : "not ok");
+    failed += !ok;
+
+    /*
+     * an entry lasts only until the first certificate in the chain expires;
+     * time checks are turned off so that only the cache sees the expiry
+     */
+    policy_mtime -= 2;
+    short_cert = make_cert("short", 4, key);
+    ok = short_cert != NULL && write_policy("*", policy_mtime) &&
+         verify(short_cert, X509_V_FLAG_NO_CHECK_TIME) &&
+         write_policy("X", policy_mtime) &&
+         verify(short_cert, X509_V_FLAG_NO_CHECK_TIME);
+    if(ok)
+    {
+        sleep(5);
+        ok = !verify(short_cert, X509_V_FLAG_NO_CHECK_TIME);
+    }
+    printf("%s - not_after_expiry_test\n", ok ? "ok" : "not ok");
+    failed += !ok;
+
+    X509_free(cert);
+    X509_free(other_cert);
+    X509_free(short_cert);
+    EVP_PKEY_free(key);
+    cleanup();
+    globus_module_deactivate(GLOBUS_GSI_CALLBACK_MODULE);
+
+    return failed;
+}
+#endif
@@ -112,6 +112,7 @@ globus_l_gsi_gss_assist_deactivate(void)
     
     GLOBUS_I_GSI_GSS_ASSIST_DEBUG_ENTER;
     
+    globus_i_gss_assist_gridmap_index_destroy();
     globus_mutex_destroy(&globus_i_gsi_gss_assist_mutex);
 
     globus_module_deactivate(GLOBUS_GSI_GSSAPI_MODULE);
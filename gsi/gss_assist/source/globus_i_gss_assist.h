@@ -166,6 +166,9 @@ globus_i_gsi_gss_assist_error_chain_result(
     const char *                        short_desc,
     const char *                        long_desc);
 
+void
+globus_i_gss_assist_gridmap_index_destroy(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -29,6 +29,8 @@
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
+#include <time.h>
+#include <sys/stat.h>
 
 typedef struct _gridmap_line_s {
   char *dn;
@@ -956,35 +958,426 @@ globus_gss_assist_map_local_user(
  * @see globus_error_get
  * @see globus_object_free
  */
+/*
+ * Parsed copy of the default gridmap file.  Entries are indexed by DN and
+ * by local user name, so that a lookup doesn't have to read the whole
+ * file.  The index is read again when the GRIDMAP setting changes or the
+ * file is replaced or modified.
+ */
+typedef struct
+{
+    unsigned long                       hash;
+    const char *                        dn;
+}
+globus_l_gss_assist_gridmap_dn_t;
+
+typedef struct
+{
+    /* Lines naming the user, in file order */
+    globus_i_gss_assist_gridmap_line_t **
+                                        lines;
+    int                                 num_lines;
+    int                                 line_slots;
+    /* First of those where the user is the default, or -1 */
+    int                                 default_line;
+}
+globus_l_gss_assist_gridmap_user_t;
+
+typedef struct
+{
+    char *                              filename;
+    struct stat                         stat;
+    globus_bool_t                       settled;
+    globus_i_gss_assist_gridmap_line_t **
+                                        lines;
+    globus_l_gss_assist_gridmap_dn_t *  dns;
+    int                                 num_lines;
+    globus_hashtable_t                  dn_index;
+    globus_hashtable_t                  user_index;
+}
+globus_l_gss_assist_gridmap_index_t;
+
+/* Protected by globus_i_gsi_gss_assist_mutex */
+static globus_l_gss_assist_gridmap_index_t *
+                                        globus_l_gss_assist_gridmap_index;
+
+/*
+ * Hash a DN so that DNs which globus_i_gsi_cert_utils_dn_cmp() considers
+ * equal hash alike: case is ignored, and so are attribute names, since
+ * some of them have aliases (E, Email and emailAddress for example).
+ */
+static
+unsigned long
+globus_l_gss_assist_gridmap_dn_hash_value(
+    const char *                        dn)
+{
+    unsigned long                       h = 0;
+    const char *                        name_end;
+
+    while (*dn != NUL)
+    {
+        if (*dn == '/')
+        {
+            name_end = dn + 1 + strcspn(dn + 1, "=/");
+            if (*name_end == '=')
+            {
+                dn = name_end;
+            }
+        }
+        h = 131 * h + tolower((unsigned char) *dn++);
+    }
+
+    return h;
+}
+/* globus_l_gss_assist_gridmap_dn_hash_value() */
+
+static
+int
+globus_l_gss_assist_gridmap_dn_hash(
+    void *                              key,
+    int                                 limit)
+{
+    return ((globus_l_gss_assist_gridmap_dn_t *) key)->hash % limit;
+}
+/* globus_l_gss_assist_gridmap_dn_hash() */
+
+static
+int
+globus_l_gss_assist_gridmap_dn_keyeq(
+    void *                              key1,
+    void *                              key2)
+{
+    globus_l_gss_assist_gridmap_dn_t *  dn1 = key1;
+    globus_l_gss_assist_gridmap_dn_t *  dn2 = key2;
+
+    return dn1->hash == dn2->hash &&
+           globus_i_gsi_cert_utils_dn_cmp(dn1->dn, dn2->dn) == 0;
+}
+/* globus_l_gss_assist_gridmap_dn_keyeq() */
+
+static
+void
+globus_l_gss_assist_gridmap_user_free(
+    void *                              datum)
+{
+    globus_l_gss_assist_gridmap_user_t *
+                                        user = datum;
+
+    free(user->lines);
+    free(user);
+}
+/* globus_l_gss_assist_gridmap_user_free() */
+
+static
+void
+globus_l_gss_assist_gridmap_index_free(
+    globus_l_gss_assist_gridmap_index_t *
+                                        index)
+{
+    int                                 i;
+
+    if (index == NULL)
+    {
+        return;
+    }
+    if (index->dn_index != NULL)
+    {
+        globus_hashtable_destroy(&index->dn_index);
+    }
+    if (index->user_index != NULL)
+    {
+        globus_hashtable_destroy_all(
+            &index->user_index,
+            globus_l_gss_assist_gridmap_user_free);
+    }
+    for (i = 0; i < index->num_lines; i++)
+    {
+        globus_i_gss_assist_gridmap_line_free(index->lines[i]);
+    }
+    free(index->lines);
+    free(index->dns);
+    free(index->filename);
+    free(index);
+}
+/* globus_l_gss_assist_gridmap_index_free() */
+
+/*
+ * Add a line to the index entry of each user it names
+ */
 static
 globus_result_t
-globus_i_gss_assist_gridmap_find_dn(
-    const char * const 		        dn,
-    globus_i_gss_assist_gridmap_line_t **		        
+globus_l_gss_assist_gridmap_index_users(
+    globus_l_gss_assist_gridmap_index_t *
+                                        index,
+    globus_i_gss_assist_gridmap_line_t *
                                         gline)
 {
-    char *                              gridmap_filename = NULL;
+    globus_l_gss_assist_gridmap_user_t *
+                                        user;
+    char **                             useridp;
+    globus_i_gss_assist_gridmap_line_t **
+                                        lines_tmp;
     globus_result_t                     result = GLOBUS_SUCCESS;
-    char *				open_mode = "r";
-    FILE *				gmap_stream = NULL;
-    int					found = 0;
-    globus_i_gss_assist_gridmap_line_t *			
-                                        gline_tmp = NULL;
     static char *                       _function_name_ =
-        "globus_i_gss_assist_gridmap_find_dn";
-    GLOBUS_I_GSI_GSS_ASSIST_DEBUG_ENTER;
+        "globus_l_gss_assist_gridmap_index_users";
+
+    for (useridp = gline->user_ids;
+         useridp != NULL && *useridp != NULL;
+         useridp++)
+    {
+        user = globus_hashtable_lookup(&index->user_index, *useridp);
+        if (user == NULL)
+        {
+            user = calloc(1, sizeof(globus_l_gss_assist_gridmap_user_t));
+            if (user == NULL ||
+                globus_hashtable_insert(
+                    &index->user_index, *useridp, user) != GLOBUS_SUCCESS)
+            {
+                free(user);
+                goto alloc_error;
+            }
+            user->default_line = -1;
+        }
+
+        /* A user named twice on one line is indexed once */
+        if (user->num_lines > 0 &&
+            user->lines[user->num_lines - 1] == gline)
+        {
+            continue;
+        }
+        if (user->num_lines == user->line_slots)
+        {
+            user->line_slots += USERID_CHUNK_SIZE;
+            lines_tmp = realloc(
+                user->lines,
+                user->line_slots * sizeof(globus_i_gss_assist_gridmap_line_t *));
+            if (lines_tmp == NULL)
+            {
+                goto alloc_error;
+            }
+            user->lines = lines_tmp;
+        }
+        if (useridp == gline->user_ids && user->default_line == -1)
+        {
+            user->default_line = user->num_lines;
+        }
+        user->lines[user->num_lines++] = gline;
+    }
 
+    return result;
 
-    /* Check arguments */
-    if (dn == NULL)
+ alloc_error:
+    result = globus_error_put(globus_error_wrap_errno_error(
+        GLOBUS_GSI_GSS_ASSIST_MODULE,
+        errno,
+        GLOBUS_GSI_GSS_ASSIST_ERROR_ERRNO,
+        __FILE__,
+        _function_name_,
+        __LINE__,
+        _GASL("Could not allocate enough memory")));
+    return result;
+}
+/* globus_l_gss_assist_gridmap_index_users() */
+
+/*
+ * Read and index a gridmap file.  Lines that can't be parsed are skipped,
+ * as they are when the file is searched line by line.
+ */
+static
+globus_result_t
+globus_l_gss_assist_gridmap_index_read(
+    const char *                        gridmap_filename,
+    globus_l_gss_assist_gridmap_index_t **
+                                        index)
+{
+    globus_l_gss_assist_gridmap_index_t *
+                                        index_tmp = NULL;
+    globus_i_gss_assist_gridmap_line_t *
+                                        gline;
+    globus_i_gss_assist_gridmap_line_t **
+                                        lines_tmp;
+    FILE *                              gmap_stream = NULL;
+    char *                              line;
+    int                                 line_slots = 0;
+    int                                 table_size;
+    int                                 i;
+    globus_result_t                     result = GLOBUS_SUCCESS;
+    static char *                       _function_name_ =
+        "globus_l_gss_assist_gridmap_index_read";
+    GLOBUS_I_GSI_GSS_ASSIST_DEBUG_ENTER;
+
+    gmap_stream = fopen(gridmap_filename, "r");
+    if (gmap_stream == NULL)
     {
         GLOBUS_GSI_GSS_ASSIST_ERROR_RESULT(
             result,
-            GLOBUS_GSI_GSS_ASSIST_ERROR_WITH_ARGUMENTS,
-            (_GASL("The DN passed to function is NULL.")));
-	goto exit;
+            GLOBUS_GSI_GSS_ASSIST_ERROR_WITH_GRIDMAP,
+            (_GASL("Couldn't open gridmap file: %s for reading."),
+             gridmap_filename));
+        goto exit;
     }
 
+    index_tmp = calloc(1, sizeof(globus_l_gss_assist_gridmap_index_t));
+    if (index_tmp == NULL ||
+        (index_tmp->filename = strdup(gridmap_filename)) == NULL)
+    {
+        goto alloc_error;
+    }
+    if (fstat(fileno(gmap_stream), &index_tmp->stat) != 0)
+    {
+        result = globus_error_put(globus_error_wrap_errno_error(
+            GLOBUS_GSI_GSS_ASSIST_MODULE,
+            errno,
+            GLOBUS_GSI_GSS_ASSIST_ERROR_ERRNO,
+            __FILE__,
+            _function_name_,
+            __LINE__,
+            _GASL("Couldn't stat gridmap file: %s"),
+            gridmap_filename));
+        goto error;
+    }
+    /*
+     * A file modified within the last second may be modified again without
+     * its modification time changing, so it is read again on each lookup
+     * until it has been left alone for a while.
+     */
+    index_tmp->settled = (index_tmp->stat.st_mtime < time(NULL) - 1);
+
+    for (;;)
+    {
+        result = globus_l_gss_assist_read_line(gmap_stream, &line);
+        if (result != GLOBUS_SUCCESS)
+        {
+            goto error;
+        }
+        if (line == NULL)
+        {
+            break;
+        }
+
+        gline = NULL;
+        result = globus_i_gss_assist_gridmap_parse_line(line, &gline);
+        free(line);
+        if (result != GLOBUS_SUCCESS)
+        {
+            globus_object_free(globus_error_get(result));
+            result = GLOBUS_SUCCESS;
+            continue;		/* Parse error */
+        }
+        if (gline == NULL)
+        {
+            continue;		/* Empty line or comment */
+        }
+
+        if (index_tmp->num_lines == line_slots)
+        {
+            line_slots = line_slots ? line_slots * 2 : 64;
+            lines_tmp = realloc(
+                index_tmp->lines,
+                line_slots * sizeof(globus_i_gss_assist_gridmap_line_t *));
+            if (lines_tmp == NULL)
+            {
+                globus_i_gss_assist_gridmap_line_free(gline);
+                goto alloc_error;
+            }
+            index_tmp->lines = lines_tmp;
+        }
+        index_tmp->lines[index_tmp->num_lines++] = gline;
+    }
+    fclose(gmap_stream);
+    gmap_stream = NULL;
+
+    table_size = index_tmp->num_lines > 16 ? index_tmp->num_lines : 16;
+    index_tmp->dns = malloc(
+        table_size * sizeof(globus_l_gss_assist_gridmap_dn_t));
+    if (index_tmp->dns == NULL ||
+        globus_hashtable_init(
+            &index_tmp->dn_index,
+            table_size,
+            globus_l_gss_assist_gridmap_dn_hash,
+            globus_l_gss_assist_gridmap_dn_keyeq) != GLOBUS_SUCCESS ||
+        globus_hashtable_init(
+            &index_tmp->user_index,
+            table_size,
+            globus_hashtable_string_hash,
+            globus_hashtable_string_keyeq) != GLOBUS_SUCCESS)
+    {
+        goto alloc_error;
+    }
+
+    for (i = 0; i < index_tmp->num_lines; i++)
+    {
+        gline = index_tmp->lines[i];
+        index_tmp->dns[i].hash =
+            globus_l_gss_assist_gridmap_dn_hash_value(gline->dn);
+        index_tmp->dns[i].dn = gline->dn;
+
+        /* The first line for a DN is the one used */
+        if (globus_hashtable_lookup(
+                &index_tmp->dn_index, &index_tmp->dns[i]) == NULL &&
+            globus_hashtable_insert(
+                &index_tmp->dn_index,
+                &index_tmp->dns[i],
+                gline) != GLOBUS_SUCCESS)
+        {
+            goto alloc_error;
+        }
+
+        result = globus_l_gss_assist_gridmap_index_users(index_tmp, gline);
+        if (result != GLOBUS_SUCCESS)
+        {
+            goto error;
+        }
+    }
+
+    GLOBUS_I_GSI_GSS_ASSIST_DEBUG_FPRINTF(
+        2, (globus_i_gsi_gss_assist_debug_fstream,
+            "Indexed %d entries of gridmap file %s\n",
+            index_tmp->num_lines, gridmap_filename));
+
+    *index = index_tmp;
+    goto exit;
+
+ alloc_error:
+    result = globus_error_put(globus_error_wrap_errno_error(
+        GLOBUS_GSI_GSS_ASSIST_MODULE,
+        errno,
+        GLOBUS_GSI_GSS_ASSIST_ERROR_ERRNO,
+        __FILE__,
+        _function_name_,
+        __LINE__,
+        _GASL("Could not allocate enough memory")));
+ error:
+    globus_l_gss_assist_gridmap_index_free(index_tmp);
+    if (gmap_stream != NULL)
+    {
+        fclose(gmap_stream);
+    }
+ exit:
+    GLOBUS_I_GSI_GSS_ASSIST_DEBUG_EXIT;
+    return result;
+}
+/* globus_l_gss_assist_gridmap_index_read() */
+
+/*
+ * Make sure globus_l_gss_assist_gridmap_index holds the current contents of
+ * the default gridmap file.  Must be called with
+ * globus_i_gsi_gss_assist_mutex locked.
+ */
+static
+globus_result_t
+globus_l_gss_assist_gridmap_index_update(void)
+{
+    globus_l_gss_assist_gridmap_index_t *
+                                        index;
+    globus_l_gss_assist_gridmap_index_t *
+                                        new_index = NULL;
+    char *                              gridmap_filename = NULL;
+    struct stat                         st;
+    globus_result_t                     result = GLOBUS_SUCCESS;
+    static char *                       _function_name_ =
+        "globus_l_gss_assist_gridmap_index_update";
+
     result = GLOBUS_GSI_SYSCONFIG_GET_GRIDMAP_FILENAME(&gridmap_filename);
     if(result != GLOBUS_SUCCESS)
     {
@@ -995,71 +1388,159 @@ globus_i_gss_assist_gridmap_find_dn(
         goto exit;
     }
 
-    gmap_stream = fopen(gridmap_filename, open_mode);
+    index = globus_l_gss_assist_gridmap_index;
+    if (index != NULL &&
+        index->settled &&
+        strcmp(index->filename, gridmap_filename) == 0 &&
+        stat(gridmap_filename, &st) == 0 &&
+        st.st_dev == index->stat.st_dev &&
+        st.st_ino == index->stat.st_ino &&
+        st.st_size == index->stat.st_size &&
+        st.st_mtime == index->stat.st_mtime)
+    {
+        goto exit;
+    }
 
-    if (gmap_stream == NULL)
+    result = globus_l_gss_assist_gridmap_index_read(
+        gridmap_filename, &new_index);
+    if (result != GLOBUS_SUCCESS)
     {
-        GLOBUS_GSI_GSS_ASSIST_ERROR_RESULT(
-            result,
-            GLOBUS_GSI_GSS_ASSIST_ERROR_WITH_GRIDMAP,
-            (_GASL("Couldn't open gridmap file: %s for reading."),
-             gridmap_filename));
         goto exit;
     }
 
+    globus_l_gss_assist_gridmap_index_free(index);
+    globus_l_gss_assist_gridmap_index = new_index;
+
+ exit:
     free(gridmap_filename);
-    gridmap_filename = NULL;
+    return result;
+}
+/* globus_l_gss_assist_gridmap_index_update() */
 
-    do
+/*
+ * Copy an indexed gridmap line, to be freed by the caller with
+ * globus_i_gss_assist_gridmap_line_free()
+ */
+static
+globus_result_t
+globus_l_gss_assist_gridmap_line_copy(
+    const globus_i_gss_assist_gridmap_line_t *
+                                        source,
+    globus_i_gss_assist_gridmap_line_t **
+                                        gline)
+{
+    globus_i_gss_assist_gridmap_line_t *
+                                        gline_tmp;
+    int                                 num_userids = 0;
+    int                                 i;
+    globus_result_t                     result = GLOBUS_SUCCESS;
+    static char *                       _function_name_ =
+        "globus_l_gss_assist_gridmap_line_copy";
+
+    gline_tmp = calloc(1, sizeof(globus_i_gss_assist_gridmap_line_t));
+    if (gline_tmp == NULL ||
+        (gline_tmp->dn = strdup(source->dn)) == NULL)
     {
-        char *                          line;
+        goto alloc_error;
+    }
 
-	result = globus_l_gss_assist_read_line(gmap_stream, &line);
-        if (result != GLOBUS_SUCCESS || line == NULL)
+    if (source->user_ids != NULL)
+    {
+        while (source->user_ids[num_userids] != NULL)
         {
-            break;
+            num_userids++;
         }
-
-        result = globus_i_gss_assist_gridmap_parse_line(line, &gline_tmp);
-	if (result != GLOBUS_SUCCESS)
-	{
-            GLOBUS_GSI_GSS_ASSIST_ERROR_CHAIN_RESULT(
-                result,
-                GLOBUS_GSI_GSS_ASSIST_ERROR_WITH_GRIDMAP);
-            free(line);
-            continue;		/* Parse error */
+        gline_tmp->user_ids = calloc(num_userids + 1, sizeof(char *));
+        if (gline_tmp->user_ids == NULL)
+        {
+            goto alloc_error;
+        }
+        for (i = 0; i < num_userids; i++)
+        {
+            gline_tmp->user_ids[i] = strdup(source->user_ids[i]);
+            if (gline_tmp->user_ids[i] == NULL)
+            {
+                goto alloc_error;
+            }
         }
+    }
 
-	if ((gline_tmp != NULL) &&
-            (globus_i_gsi_cert_utils_dn_cmp(dn, gline_tmp->dn) == 0))
-	{
-            found = 1;
-	}
-	else
-	{
-	    globus_i_gss_assist_gridmap_line_free(gline_tmp);
-	}
-        free(line);
-    } while (!found);
+    *gline = gline_tmp;
+    return result;
 
-    fclose(gmap_stream);
-    gmap_stream = NULL;
+ alloc_error:
+    result = globus_error_put(globus_error_wrap_errno_error(
+        GLOBUS_GSI_GSS_ASSIST_MODULE,
+        errno,
+        GLOBUS_GSI_GSS_ASSIST_ERROR_ERRNO,
+        __FILE__,
+        _function_name_,
+        __LINE__,
+        _GASL("Could not allocate enough memory")));
+    globus_i_gss_assist_gridmap_line_free(gline_tmp);
+    return result;
+}
+/* globus_l_gss_assist_gridmap_line_copy() */
 
-    if (found)
-    {
-        *gline = gline_tmp;
-    }
-    else
+/**
+ * @ingroup globus_i_gsi_gss_assist
+ * Free the gridmap file index.  Called when the module is deactivated.
+ */
+void
+globus_i_gss_assist_gridmap_index_destroy(void)
+{
+    globus_mutex_lock(&globus_i_gsi_gss_assist_mutex);
+    globus_l_gss_assist_gridmap_index_free(globus_l_gss_assist_gridmap_index);
+    globus_l_gss_assist_gridmap_index = NULL;
+    globus_mutex_unlock(&globus_i_gsi_gss_assist_mutex);
+}
+/* globus_i_gss_assist_gridmap_index_destroy() */
+
+static
+globus_result_t
+globus_i_gss_assist_gridmap_find_dn(
+    const char * const 		        dn,
+    globus_i_gss_assist_gridmap_line_t **		        
+                                        gline)
+{
+    globus_result_t                     result = GLOBUS_SUCCESS;
+    globus_l_gss_assist_gridmap_dn_t    key;
+    globus_i_gss_assist_gridmap_line_t *			
+                                        gline_tmp = NULL;
+    static char *                       _function_name_ =
+        "globus_i_gss_assist_gridmap_find_dn";
+    GLOBUS_I_GSI_GSS_ASSIST_DEBUG_ENTER;
+
+
+    /* Check arguments */
+    if (dn == NULL)
     {
-        *gline = NULL;
+        GLOBUS_GSI_GSS_ASSIST_ERROR_RESULT(
+            result,
+            GLOBUS_GSI_GSS_ASSIST_ERROR_WITH_ARGUMENTS,
+            (_GASL("The DN passed to function is NULL.")));
+	goto exit;
     }
 
- exit:
+    *gline = NULL;
 
-    if (gridmap_filename != NULL)
+    key.hash = globus_l_gss_assist_gridmap_dn_hash_value(dn);
+    key.dn = dn;
+
+    globus_mutex_lock(&globus_i_gsi_gss_assist_mutex);
+    result = globus_l_gss_assist_gridmap_index_update();
+    if (result == GLOBUS_SUCCESS)
     {
-	free(gridmap_filename);
+        gline_tmp = globus_hashtable_lookup(
+            &globus_l_gss_assist_gridmap_index->dn_index, &key);
+        if (gline_tmp != NULL)
+        {
+            result = globus_l_gss_assist_gridmap_line_copy(gline_tmp, gline);
+        }
     }
+    globus_mutex_unlock(&globus_i_gsi_gss_assist_mutex);
+
+ exit:
 
     GLOBUS_I_GSI_GSS_ASSIST_DEBUG_EXIT;
     return result;
@@ -1093,14 +1574,8 @@ globus_i_gss_assist_gridmap_find_local_user(
     globus_i_gss_assist_gridmap_line_t **	                
                                         gline)
 {
-    char *				gridmap_filename = NULL;
-    char *				open_mode = "r";
-    FILE *				gmap_stream = NULL;
-    int					found = 0;
-    globus_i_gss_assist_gridmap_line_t *			
-                                        gline_tmp;
-    char ** 	                        useridp;
-    char *                              nondefault_line = NULL;
+    globus_l_gss_assist_gridmap_user_t *
+                                        user;
     globus_result_t                     result = GLOBUS_SUCCESS;
     static char *                       _function_name_ =
         "globus_i_gss_assist_gridmap_find_local_user";
@@ -1116,112 +1591,27 @@ globus_i_gss_assist_gridmap_find_local_user(
         goto exit;
     }
 
-    result = GLOBUS_GSI_SYSCONFIG_GET_GRIDMAP_FILENAME(&gridmap_filename);
-    if(result != GLOBUS_SUCCESS)
-    {
-        gridmap_filename = NULL;
-        GLOBUS_GSI_GSS_ASSIST_ERROR_CHAIN_RESULT(
-            result,
-            GLOBUS_GSI_GSS_ASSIST_ERROR_WITH_GRIDMAP);
-        goto exit;
-    }
-            
-    gmap_stream = fopen(gridmap_filename, open_mode);
+    *gline = NULL;
 
-    if (gmap_stream == NULL)
-    {
-        GLOBUS_GSI_GSS_ASSIST_ERROR_RESULT(
-            result,
-            GLOBUS_GSI_GSS_ASSIST_ERROR_WITH_GRIDMAP,
-            (_GASL("Can't open the file: %s"), gridmap_filename));
-        goto exit;
-    }
-
-    do
-    {
-        char *                          line;
-        char *                          save_line;
-
-        result = globus_l_gss_assist_read_line(gmap_stream, &line);
-        if (result != GLOBUS_SUCCESS || line == NULL)
-        {
-            break;
-        }
-        
-        save_line = strdup(line);
-        
-	result = globus_i_gss_assist_gridmap_parse_line(line, &gline_tmp);
-        if(result != GLOBUS_SUCCESS)
-        {
-            free(line);
-            free(save_line);
-	    continue;		/* Parse error */
-        }
-
-	if (gline_tmp == NULL)
-	{
-	    /* Empty line */
-            free(line);
-            free(save_line);
-	    continue;
-	}
-
-        for(useridp = gline_tmp->user_ids; 
-            useridp != NULL && *useridp != NULL && !found; 
-            useridp++)
-        {
-            if(strcmp(local_user, *useridp) == 0)
-            {
-                /* check all names, but only stop looking if we match a 
-                 * default name.  Save the first non-default match until 
-                 * we've checked all the defaults */
-                if(*useridp == gline_tmp->user_ids[0])
-                {
-                    found = 1;
-                }
-                else if(nondefault_line == NULL)
-                {
-                    nondefault_line = strdup(save_line);
-                }
-            }
-        }
-        if(!found)
-	{
-	    globus_i_gss_assist_gridmap_line_free(gline_tmp);
-	}
-        free(line);
-        free(save_line);
-    } while (!found);
-    
-    if(nondefault_line != NULL)
+    globus_mutex_lock(&globus_i_gsi_gss_assist_mutex);
+    result = globus_l_gss_assist_gridmap_index_update();
+    if (result == GLOBUS_SUCCESS)
     {
-	result = globus_i_gss_assist_gridmap_parse_line(
-	    nondefault_line, &gline_tmp);
-        free(nondefault_line);
-        if(result != GLOBUS_SUCCESS)
+        user = globus_hashtable_lookup(
+            &globus_l_gss_assist_gridmap_index->user_index,
+            (void *) local_user);
+        if (user != NULL)
         {
-	    goto exit;
+            /* Prefer a line where the user is the default */
+            result = globus_l_gss_assist_gridmap_line_copy(
+                user->lines[user->default_line != -1
+                            ? user->default_line : 0],
+                gline);
         }
-        found = 1;
-    }        
-
-    fclose(gmap_stream);
-    gmap_stream = NULL;
-
-    if (found)
-	*gline = gline_tmp;
-    else
-	*gline = NULL;
-
- exit:
-
-    if (gridmap_filename)
-    {
-	free(gridmap_filename);
     }
+    globus_mutex_unlock(&globus_i_gsi_gss_assist_mutex);
 
-    if (gmap_stream)
-	fclose(gmap_stream);
+ exit:
 
     GLOBUS_I_GSI_GSS_ASSIST_DEBUG_EXIT;
     return result;
@@ -1771,15 +2161,11 @@ globus_gss_assist_lookup_all_globusid(
     char **                                     dns[],
     int *                                       dn_count)
 {
-    char *                                      line;
-    int                                         i;
-    int                                         max_ndx = 512;
-    int                                         ndx = 0;
+    int                                         ndx;
+    int                                         num_dns = 0;
     char **                                     l_dns;
-    globus_i_gss_assist_gridmap_line_t *        gline = NULL;
-    char *                                      gridmap_filename = NULL;
+    globus_l_gss_assist_gridmap_user_t *        user;
     globus_result_t                             res = GLOBUS_SUCCESS;
-    FILE *                                      gmap_stream = NULL;
     static char *                       _function_name_ =
         "globus_gss_assist_lookup_all_globusid";
 
@@ -1798,84 +2184,46 @@ globus_gss_assist_lookup_all_globusid(
         goto exit;
     }
 
-    res = GLOBUS_GSI_SYSCONFIG_GET_GRIDMAP_FILENAME(&gridmap_filename);
+    globus_mutex_lock(&globus_i_gsi_gss_assist_mutex);
+    res = globus_l_gss_assist_gridmap_index_update();
     if(res != GLOBUS_SUCCESS)
     {
-        gridmap_filename = NULL;
-        GLOBUS_GSI_GSS_ASSIST_ERROR_CHAIN_RESULT(
-            res,
-            GLOBUS_GSI_GSS_ASSIST_ERROR_WITH_GRIDMAP);
-
+        globus_mutex_unlock(&globus_i_gsi_gss_assist_mutex);
         goto exit;
     }
 
-    gmap_stream = fopen(gridmap_filename, "r");
-
-    if (gmap_stream == NULL)
+    user = globus_hashtable_lookup(
+        &globus_l_gss_assist_gridmap_index->user_index, username);
+    if(user != NULL)
     {
-        GLOBUS_GSI_GSS_ASSIST_ERROR_RESULT(
-            res,
-            GLOBUS_GSI_GSS_ASSIST_ERROR_WITH_GRIDMAP,
-            (_GASL("Couldn't open gridmap file: %s for reading."),
-             gridmap_filename));
-
-        goto exit;
+        num_dns = user->num_lines;
     }
 
-    ndx = 0;
-    l_dns = (char **)globus_malloc(sizeof(char *) * max_ndx);
-
-    while (!feof(gmap_stream))
+    l_dns = (char **)globus_malloc(sizeof(char *) * (num_dns + 1));
+    for (ndx = 0; l_dns != NULL && ndx < num_dns; ndx++)
     {
-        res = globus_l_gss_assist_read_line(gmap_stream, &line);
-        if (res != GLOBUS_SUCCESS || line == NULL)
-        {
-            break;
-        }
-
-        res = globus_i_gss_assist_gridmap_parse_line(line, &gline);
+        l_dns[ndx] = strdup(user->lines[ndx]->dn);
+    }
+    globus_mutex_unlock(&globus_i_gsi_gss_assist_mutex);
 
-        if(res == GLOBUS_SUCCESS &&
-           gline != NULL &&
-           gline->user_ids != NULL)
-        {
-            for (i = 0; gline->user_ids[i] != NULL; i++)
-            {
-                if(strcmp(gline->user_ids[i], username) == 0)
-                {
-                    l_dns[ndx] = strdup(gline->dn);
-                    ndx++;
-                    if(ndx >= max_ndx)
-                    {
-                        max_ndx *= 2;
-                        l_dns = (char **)globus_libc_realloc(l_dns,
-                                             sizeof(char *) * max_ndx);
-                    }
-                    break;
-                }
-            }
-        }
-        if (gline != NULL)
-        {
-            globus_i_gss_assist_gridmap_line_free(gline);
-            gline = NULL;
-        }
-        free(line);
+    if(l_dns == NULL)
+    {
+        res = globus_error_put(globus_error_wrap_errno_error(
+            GLOBUS_GSI_GSS_ASSIST_MODULE,
+            errno,
+            GLOBUS_GSI_GSS_ASSIST_ERROR_ERRNO,
+            __FILE__,
+            _function_name_,
+            __LINE__,
+            _GASL("Could not allocate enough memory")));
+        goto exit;
     }
-    l_dns[ndx] = NULL;
+    l_dns[num_dns] = NULL;
     *dns = l_dns;
-    *dn_count = ndx;
-
-    fclose(gmap_stream);
-    gmap_stream = NULL;
+    *dn_count = num_dns;
 
  exit:
 
-    if(gridmap_filename != NULL)
-    {
-        free(gridmap_filename);
-    }
-
     GLOBUS_I_GSI_GSS_ASSIST_DEBUG_EXIT;
 
     return res;
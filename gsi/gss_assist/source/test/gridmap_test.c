@@ -792,6 +792,209 @@ setenv_failed:
 }
 /* blank_line_test() */
 
+static
+int
+write_gridmap(
+    const char *                        filename,
+    const char *                        contents)
+{
+    FILE *                              fp;
+
+    fp = fopen(filename, "w");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "# Error creating %s\n", filename);
+        return 1;
+    }
+    fputs(contents, fp);
+    fclose(fp);
+
+    return 0;
+}
+/* write_gridmap() */
+
+/* Modifying the gridmap file is noticed by the next lookup */
+int
+reload_test(void)
+{
+    int                                 failed = 0;
+    int                                 rc;
+    char *                              userid = NULL;
+    char *                              gridmap = "gridmap.reload-test";
+
+    rc = globus_libc_setenv("GRIDMAP", gridmap, 1);
+    if (rc != 0)
+    {
+        fprintf(stderr, "# Error setting GRIDMAP location\n");
+        return 1;
+    }
+
+    if (write_gridmap(gridmap, "\"/CN=reload\" first\n") != 0)
+    {
+        return 1;
+    }
+    rc = globus_gss_assist_gridmap("/CN=reload", &userid);
+    if (rc != 0 || strcmp(userid, "first") != 0)
+    {
+        fprintf(stderr, "# globus_gss_assist_gridmap mapped /CN=reload to %s [expected first]\n", rc == 0 ? userid : "(error)");
+        failed++;
+    }
+    free(userid);
+    userid = NULL;
+
+    if (write_gridmap(gridmap, "\"/CN=reload\" second\n\"/CN=added\" third\n") != 0)
+    {
+        return failed + 1;
+    }
+    rc = globus_gss_assist_gridmap("/CN=reload", &userid);
+    if (rc != 0 || strcmp(userid, "second") != 0)
+    {
+        fprintf(stderr, "# globus_gss_assist_gridmap mapped /CN=reload to %s after change [expected second]\n", rc == 0 ? userid : "(error)");
+        failed++;
+    }
+    free(userid);
+    userid = NULL;
+
+    rc = globus_gss_assist_userok("/CN=added", "third");
+    if (rc != 0)
+    {
+        fprintf(stderr, "# globus_gss_assist_userok unexpectedly failed for an added line\n");
+        failed++;
+    }
+
+    remove(gridmap);
+    rc = globus_gss_assist_userok("/CN=added", "third");
+    if (rc == 0)
+    {
+        fprintf(stderr, "# globus_gss_assist_userok unexpectedly succeeded after the gridmap was removed\n");
+        failed++;
+    }
+
+    return failed;
+}
+/* reload_test() */
+
+/*
+ * Time lookups in a large gridmap file.  The number of entries can be set
+ * with GRIDMAP_BENCHMARK_ENTRIES; the timings are printed as TAP comments.
+ */
+int
+lookup_benchmark_test(void)
+{
+    int                                 failed = 0;
+    int                                 rc;
+    int                                 i;
+    int                                 n;
+    int                                 entries = 20000;
+    int                                 lookups = 10000;
+    char *                              gridmap = "gridmap.benchmark-test";
+    char *                              entries_string;
+    char                                dn[64];
+    char                                expected[32];
+    char *                              userid;
+    FILE *                              fp;
+    globus_abstime_t                    start;
+    globus_abstime_t                    end;
+    globus_reltime_t                    elapsed;
+    long                                first_usec;
+    long                                usec;
+
+    entries_string = getenv("GRIDMAP_BENCHMARK_ENTRIES");
+    if (entries_string != NULL && atoi(entries_string) > 0)
+    {
+        entries = atoi(entries_string);
+    }
+
+    fp = fopen(gridmap, "w");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "# Error creating %s\n", gridmap);
+        return 1;
+    }
+    for (i = 0; i < entries; i++)
+    {
+        fprintf(fp, "\"/DC=org/DC=example/OU=People/CN=User %d\" user%d,group%d\n",
+                i, i, i % 100);
+    }
+    fclose(fp);
+
+    rc = globus_libc_setenv("GRIDMAP", gridmap, 1);
+    if (rc != 0)
+    {
+        fprintf(stderr, "# Error setting GRIDMAP location\n");
+        failed++;
+        goto out;
+    }
+
+    /* The first lookup reads the file */
+    GlobusTimeAbstimeGetCurrent(start);
+    userid = NULL;
+    rc = globus_gss_assist_gridmap(
+            "/DC=org/DC=example/OU=People/CN=User 0", &userid);
+    GlobusTimeAbstimeGetCurrent(end);
+    GlobusTimeAbstimeDiff(elapsed, start, end);
+    GlobusTimeReltimeToUSec(first_usec, elapsed);
+    if (rc != 0)
+    {
+        fprintf(stderr, "# globus_gss_assist_gridmap unexpectedly failed\n");
+        failed++;
+        goto out;
+    }
+    free(userid);
+
+    GlobusTimeAbstimeGetCurrent(start);
+    for (i = 0; i < lookups; i++)
+    {
+        n = (i * 7919) % entries;
+        sprintf(dn, "/DC=org/DC=example/OU=People/CN=User %d", n);
+        sprintf(expected, "user%d", n);
+
+        userid = NULL;
+        rc = globus_gss_assist_gridmap(dn, &userid);
+        if (rc != 0 || strcmp(userid, expected) != 0)
+        {
+            fprintf(stderr, "# globus_gss_assist_gridmap mapped %s to %s [expected %s]\n", dn, rc == 0 ? userid : "(error)", expected);
+            failed++;
+        }
+        free(userid);
+    }
+    GlobusTimeAbstimeGetCurrent(end);
+    GlobusTimeAbstimeDiff(elapsed, start, end);
+    GlobusTimeReltimeToUSec(usec, elapsed);
+
+    printf("# %d entry gridmap: first lookup %ld us, then %.1f us per DN lookup\n",
+            entries, first_usec, (double) usec / lookups);
+
+    GlobusTimeAbstimeGetCurrent(start);
+    for (i = 0; i < lookups; i++)
+    {
+        n = (i * 7919) % entries;
+        sprintf(dn, "/DC=org/DC=example/OU=People/CN=User %d", n);
+        sprintf(expected, "user%d", n);
+
+        rc = globus_gss_assist_map_local_user(expected, &userid);
+        if (rc != 0 || strcmp(userid, dn) != 0)
+        {
+            fprintf(stderr, "# globus_gss_assist_map_local_user mapped %s to %s [expected %s]\n", expected, rc == 0 ? userid : "(error)", dn);
+            failed++;
+        }
+        if (rc == 0)
+        {
+            free(userid);
+        }
+    }
+    GlobusTimeAbstimeGetCurrent(end);
+    GlobusTimeAbstimeDiff(elapsed, start, end);
+    GlobusTimeReltimeToUSec(usec, elapsed);
+
+    printf("# %d entry gridmap: %.1f us per local user lookup\n",
+            entries, (double) usec / lookups);
+out:
+    remove(gridmap);
+    return failed;
+}
+/* lookup_benchmark_test() */
+
 
 int main(int argc, char * argv[])
 {
@@ -807,7 +1010,9 @@ int main(int argc, char * argv[])
         TEST_CASE(map_local_user_test),
         TEST_CASE(lookup_all_globusid_test),
         TEST_CASE(long_line_test),
-        TEST_CASE(blank_line_test)
+        TEST_CASE(blank_line_test),
+        TEST_CASE(reload_test),
+        TEST_CASE(lookup_benchmark_test)
     };
     int                                 i;
     int                                 failed = 0;
@@ -301,12 +301,24 @@ GSS_CALLCONV gss_accept_sec_context(
              * the last token but don't have a token to send
              * we need to send a null So peek at what we might send
              */
-            if (BIO_pending(context->gss_wbio) == 0)
+            context->gss_state = GSS_CON_ST_FLAGS;
+            if (BIO_pending(context->gss_wbio) != 0)
+            {
+                break;
+            }
+
+            /*
+             * A resumed handshake ends on the client's Finished, which
+             * arrives with the delegation flag behind it, so read the
+             * flag now rather than asking for another token
+             */
+            if (BIO_pending(context->gss_rbio) == 0 &&
+                SSL_pending(context->gss_ssl) == 0)
             {
                 BIO_write(context->gss_sslbio, "\0", 1);
+                break;
             }
-            context->gss_state = GSS_CON_ST_FLAGS;
-            break;
+            /* fall through */
 
         case(GSS_CON_ST_FLAGS):
         
@@ -160,6 +160,18 @@ GSS_CALLCONV gss_delete_sec_context(
 
     if ((*context_handle)->gss_ssl)
     {
+        /*
+         * Contexts are usually deleted without a close_notify; without
+         * this SSL_free() would mark the session, which may be in the TLS
+         * session cache, as not resumable
+         */
+        if ((*context_handle)->gss_state == GSS_CON_ST_DONE)
+        {
+            SSL_set_shutdown(
+                (*context_handle)->gss_ssl,
+                SSL_get_shutdown((*context_handle)->gss_ssl)
+                    | SSL_SENT_SHUTDOWN);
+        }
         SSL_free((*context_handle)->gss_ssl);
         (*context_handle)->gss_ssl = NULL;
     } 
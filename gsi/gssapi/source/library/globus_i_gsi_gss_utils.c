@@ -28,6 +28,7 @@
 #include "globus_gsi_callback_constants.h"
 #include "globus_gsi_system_config.h"
 #include "openssl/ssl3.h"
+#include "openssl/rand.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -62,6 +63,41 @@ globus_l_gsi_gss_alpn_select_callback(
     const unsigned char                *in,
     unsigned int                        inlen,
     void                               *arg);
+
+static
+void
+globus_l_gsi_gss_session_setup(
+    gss_ctx_id_desc *                   context,
+    const gss_name_t                    target_name);
+
+static
+OM_uint32
+globus_l_gsi_gss_session_finish(
+    OM_uint32 *                         minor_status,
+    gss_ctx_id_desc *                   context);
+
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+static
+SSL_SESSION *
+globus_l_gsi_gss_session_get_callback(
+    SSL *                               ssl,
+    const unsigned char *               id,
+    int                                 id_length,
+    int *                               copy);
+
+static
+int
+globus_l_gsi_gss_session_id_callback(
+    SSL *                               ssl,
+    unsigned char *                     id,
+    unsigned int *                      id_length);
+
+static
+int
+globus_l_gsi_gss_session_new_callback(
+    SSL *                               ssl,
+    SSL_SESSION *                       session);
+#endif
 /**
  * @defgroup globus_i_gsi_gss_utils Globus GSSAPI Internals
  *
@@ -604,6 +640,8 @@ globus_i_gsi_gss_create_and_fill_context(
         goto free_cert_dir;
     }
 
+    globus_l_gsi_gss_session_setup(context, target_name);
+
     /* enable ECDH */
 #if OPENSSL_VERSION_NUMBER < 0x10100000L
     /* 1.1.0 does ecdh and auto curve selection by default */
@@ -1149,6 +1187,15 @@ globus_i_gsi_gss_handshake(
             size_t                      keying_material_len = 0;
             #endif
 
+            major_status = globus_l_gsi_gss_session_finish(
+                    minor_status,
+                    context_handle);
+
+            if (GSS_ERROR(major_status))
+            {
+                goto exit;
+            }
+
             major_status = globus_i_gss_get_hash(
                     minor_status,
                     context_handle,
@@ -1263,6 +1310,10 @@ globus_i_gsi_gss_handshake(
                 char                    cipher_description[256];
                 GLOBUS_I_GSI_GSSAPI_DEBUG_PRINT(
                     2, "SSL handshake finished\n");
+                GLOBUS_I_GSI_GSSAPI_DEBUG_PRINT(
+                    2, context_handle->session_resumed
+                        ? "Resumed cached TLS session.\n"
+                        : "Full handshake.\n");
                 GLOBUS_I_GSI_GSSAPI_DEBUG_FNPRINTF(
                     2, (20, "Using %s.\n",
                         SSL_get_version(context_handle->gss_ssl)));
@@ -2368,7 +2419,43 @@ globus_i_gsi_gssapi_init_ssl_context(
                                      globus_gsi_callback_X509_verify_cert,
                                      NULL);
 
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+    /*
+     * Sessions are kept in a process wide cache instead of the SSL_CTX, so
+     * contexts that acquire the same credential again can resume them.
+     * Tickets would carry the session outside the cache without the peer
+     * chain it verified, so only session ids, and the TLS 1.3 tickets that
+     * just name one, are used.  Sessions are cached as OpenSSL creates
+     * them, as a TLS 1.3 client only gets its session after the handshake.
+     */
+    if (globus_i_gsi_gssapi_session_cache_timeout > 0)
+    {
+        SSL_CTX_set_session_cache_mode(
+            cred_handle->ssl_context,
+            SSL_SESS_CACHE_BOTH | SSL_SESS_CACHE_NO_INTERNAL);
+        SSL_CTX_sess_set_get_cb(
+            cred_handle->ssl_context,
+            globus_l_gsi_gss_session_get_callback);
+        SSL_CTX_sess_set_new_cb(
+            cred_handle->ssl_context,
+            globus_l_gsi_gss_session_new_callback);
+        SSL_CTX_set_generate_session_id(
+            cred_handle->ssl_context,
+            globus_l_gsi_gss_session_id_callback);
+        SSL_CTX_set_timeout(
+            cred_handle->ssl_context,
+            globus_i_gsi_gssapi_session_cache_timeout);
+        SSL_CTX_set_options(cred_handle->ssl_context, SSL_OP_NO_TICKET);
+    }
+    else
+    {
+        SSL_CTX_set_session_cache_mode(
+            cred_handle->ssl_context,
+            SSL_SESS_CACHE_OFF);
+    }
+#else
     SSL_CTX_sess_set_cache_size(cred_handle->ssl_context, 5);
+#endif
 
     local_result = GLOBUS_GSI_SYSCONFIG_GET_CERT_DIR(&ca_cert_dir);
     
@@ -3113,4 +3200,682 @@ globus_l_gsi_gss_alpn_select_callback(
 }
 #endif
 
+
+/*
+ * TLS session cache
+ *
+ * Full handshakes leave their TLS sessions in one of two process wide
+ * tables: servers key theirs by session id, clients by a digest of the
+ * session id context and the target name.  Each session carries a copy of
+ * the callback data from the handshake that created it, which is restored
+ * into contexts that resume it, so that the peer chain, proxy depth and
+ * certificate type seen by authorization are those that were verified.
+ */
+
+/* number of TLS sessions kept for each side of the handshake */
+#define GLOBUS_L_GSI_GSS_SESSION_CACHE_SIZE 256
+
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+/*
+ * Prefix of the session ids handed out by servers with the cache enabled.
+ * Clients only keep sessions from such servers, as older servers resume
+ * sessions without restoring the verified peer chain.
+ */
+static const unsigned char              globus_l_gsi_gss_session_id_tag[] =
+    { 'G', 'S', 'I', '-', 'S', 'I', 'D', '1' };
+
+typedef struct
+{
+    unsigned char                       key[SSL_MAX_SSL_SESSION_ID_LENGTH];
+    unsigned int                        key_length;
+    SSL_SESSION *                       session;
+}
+globus_l_gsi_gss_session_entry_t;
+
+static globus_l_gsi_gss_session_entry_t
+    globus_l_gsi_gss_server_sessions[GLOBUS_L_GSI_GSS_SESSION_CACHE_SIZE];
+static globus_l_gsi_gss_session_entry_t
+    globus_l_gsi_gss_client_sessions[GLOBUS_L_GSI_GSS_SESSION_CACHE_SIZE];
+static int                              globus_l_gsi_gss_session_index = -1;
+/* SSL ex data index of the context owning an SSL */
+static int                              globus_l_gsi_gss_context_index = -1;
+#endif
+
+static globus_thread_once_t             globus_l_gsi_gss_session_once =
+    GLOBUS_THREAD_ONCE_INIT;
+static globus_mutex_t                   globus_l_gsi_gss_session_mutex;
+static unsigned long                    globus_l_gsi_gss_sessions_resumed;
+static unsigned long                    globus_l_gsi_gss_sessions_full;
+
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+static
+int
+globus_l_gsi_gss_session_data_dup(
+    CRYPTO_EX_DATA *                    to,
+    const CRYPTO_EX_DATA *              from,
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    void **                             from_d,
+#else
+    void *                              from_d,
+#endif
+    int                                 idx,
+    long                                argl,
+    void *                              argp)
+{
+    /* from_d points at the pointer which is stored in the duplicate */
+    void **                             data = (void **) from_d;
+    globus_gsi_callback_data_t          copy = NULL;
+
+    if (*data != NULL)
+    {
+        if (globus_gsi_callback_data_copy(*data, &copy) != GLOBUS_SUCCESS)
+        {
+            globus_gsi_callback_data_destroy(copy);
+            *data = NULL;
+            return 0;
+        }
+    }
+    *data = copy;
+
+    return 1;
+}
+/* globus_l_gsi_gss_session_data_dup() */
+
+static
+void
+globus_l_gsi_gss_session_data_free(
+    void *                              parent,
+    void *                              ptr,
+    CRYPTO_EX_DATA *                    ad,
+    int                                 idx,
+    long                                argl,
+    void *                              argp)
+{
+    if (ptr != NULL)
+    {
+        globus_gsi_callback_data_destroy(ptr);
+    }
+}
+/* globus_l_gsi_gss_session_data_free() */
+#endif
+
+static
+void
+globus_l_gsi_gss_session_cache_init_once(void)
+{
+    globus_mutex_init(&globus_l_gsi_gss_session_mutex, NULL);
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+    globus_l_gsi_gss_session_index = SSL_SESSION_get_ex_new_index(
+        0,
+        NULL,
+        NULL,
+        globus_l_gsi_gss_session_data_dup,
+        globus_l_gsi_gss_session_data_free);
+    globus_l_gsi_gss_context_index = SSL_get_ex_new_index(
+        0,
+        NULL,
+        NULL,
+        NULL,
+        NULL);
+#endif
+}
+/* globus_l_gsi_gss_session_cache_init_once() */
+
+/**
+ * @brief Initialize the TLS session cache
+ * @ingroup globus_i_gsi_gss_utils
+ * @details
+ * Called from module activation; only the first call does anything.
+ */
+void
+globus_i_gsi_gss_session_cache_init(void)
+{
+    globus_thread_once(
+        &globus_l_gsi_gss_session_once,
+        globus_l_gsi_gss_session_cache_init_once);
+}
+/* globus_i_gsi_gss_session_cache_init() */
+
+/**
+ * @brief Empty the TLS session cache
+ * @ingroup globus_i_gsi_gss_utils
+ * @details
+ * Drops every cached session, so that no contexts created after this
+ * call resume a handshake done before it.
+ */
+void
+globus_i_gsi_gss_session_cache_flush(void)
+{
+    globus_mutex_lock(&globus_l_gsi_gss_session_mutex);
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+    for (int i = 0; i < GLOBUS_L_GSI_GSS_SESSION_CACHE_SIZE; i++)
+    {
+        SSL_SESSION_free(globus_l_gsi_gss_server_sessions[i].session);
+        globus_l_gsi_gss_server_sessions[i].session = NULL;
+        SSL_SESSION_free(globus_l_gsi_gss_client_sessions[i].session);
+        globus_l_gsi_gss_client_sessions[i].session = NULL;
+    }
+#endif
+    globus_mutex_unlock(&globus_l_gsi_gss_session_mutex);
+}
+/* globus_i_gsi_gss_session_cache_flush() */
+
+/**
+ * @brief Count resumed and full handshakes
+ * @ingroup globus_i_gsi_gss_utils
+ *
+ * @param resumed
+ *        Set to the number of handshakes that resumed a cached session
+ * @param full
+ *        Set to the number of handshakes that verified the peer's chain
+ */
+void
+globus_i_gsi_gss_session_cache_stats(
+    unsigned long *                     resumed,
+    unsigned long *                     full)
+{
+    globus_mutex_lock(&globus_l_gsi_gss_session_mutex);
+    *resumed = globus_l_gsi_gss_sessions_resumed;
+    *full = globus_l_gsi_gss_sessions_full;
+    globus_mutex_unlock(&globus_l_gsi_gss_session_mutex);
+}
+/* globus_i_gsi_gss_session_cache_stats() */
+
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+static
+globus_l_gsi_gss_session_entry_t *
+globus_l_gsi_gss_session_slot(
+    globus_l_gsi_gss_session_entry_t *  table,
+    const unsigned char *               key,
+    unsigned int                        key_length)
+{
+    unsigned int                        hash = 0;
+
+    /* keys are digests or random session ids, so their tail will do */
+    for (unsigned int i = 0; i < key_length; i++)
+    {
+        hash = (hash << 8) | key[i];
+    }
+
+    return &table[hash % GLOBUS_L_GSI_GSS_SESSION_CACHE_SIZE];
+}
+/* globus_l_gsi_gss_session_slot() */
+
+/*
+ * Returns a new reference to the cached session for key, or NULL if there
+ * is none or it has expired
+ */
+static
+SSL_SESSION *
+globus_l_gsi_gss_session_lookup(
+    globus_l_gsi_gss_session_entry_t *  table,
+    const unsigned char *               key,
+    unsigned int                        key_length)
+{
+    globus_l_gsi_gss_session_entry_t *  entry;
+    SSL_SESSION *                       session = NULL;
+
+    globus_mutex_lock(&globus_l_gsi_gss_session_mutex);
+    entry = globus_l_gsi_gss_session_slot(table, key, key_length);
+    if (entry->session != NULL
+        && entry->key_length == key_length
+        && memcmp(entry->key, key, key_length) == 0)
+    {
+        if (SSL_SESSION_get_time(entry->session)
+            + SSL_SESSION_get_timeout(entry->session) <= time(NULL))
+        {
+            SSL_SESSION_free(entry->session);
+            entry->session = NULL;
+        }
+        else
+        {
+            session = entry->session;
+            SSL_SESSION_up_ref(session);
+        }
+    }
+    globus_mutex_unlock(&globus_l_gsi_gss_session_mutex);
+
+    return session;
+}
+/* globus_l_gsi_gss_session_lookup() */
+
+/* Takes over the caller's reference to session */
+static
+void
+globus_l_gsi_gss_session_store(
+    globus_l_gsi_gss_session_entry_t *  table,
+    const unsigned char *               key,
+    unsigned int                        key_length,
+    SSL_SESSION *                       session)
+{
+    globus_l_gsi_gss_session_entry_t *  entry;
+    SSL_SESSION *                       old_session;
+
+    globus_mutex_lock(&globus_l_gsi_gss_session_mutex);
+    entry = globus_l_gsi_gss_session_slot(table, key, key_length);
+    old_session = entry->session;
+    memcpy(entry->key, key, key_length);
+    entry->key_length = key_length;
+    entry->session = session;
+    globus_mutex_unlock(&globus_l_gsi_gss_session_mutex);
+
+    SSL_SESSION_free(old_session);
+}
+/* globus_l_gsi_gss_session_store() */
+
+static
+SSL_SESSION *
+globus_l_gsi_gss_session_get_callback(
+    SSL *                               ssl,
+    const unsigned char *               id,
+    int                                 id_length,
+    int *                               copy)
+{
+    /* the lookup's reference is handed to OpenSSL */
+    *copy = 0;
+
+    if (id_length <= 0 || id_length > SSL_MAX_SSL_SESSION_ID_LENGTH)
+    {
+        return NULL;
+    }
+
+    return globus_l_gsi_gss_session_lookup(
+        globus_l_gsi_gss_server_sessions, id, id_length);
+}
+/* globus_l_gsi_gss_session_get_callback() */
+
+static
+int
+globus_l_gsi_gss_session_id_callback(
+    SSL *                               ssl,
+    unsigned char *                     id,
+    unsigned int *                      id_length)
+{
+    size_t                              tag_length;
+
+    tag_length = sizeof(globus_l_gsi_gss_session_id_tag);
+    if (*id_length < tag_length + 16)
+    {
+        return 0;
+    }
+    memcpy(id, globus_l_gsi_gss_session_id_tag, tag_length);
+
+    return RAND_bytes(id + tag_length, *id_length - tag_length) == 1;
+}
+/* globus_l_gsi_gss_session_id_callback() */
+
+/*
+ * Called with each session OpenSSL makes for a cacheable context: at the
+ * end of a TLS 1.2 handshake, and for each session ticket sent or received
+ * after a TLS 1.3 one, which for the client is after the handshake has
+ * completed.  Sessions of full handshakes are cached with a copy of the
+ * callback data that verified the peer.  Returns 1 if the cache took the
+ * reference to session.
+ */
+static
+int
+globus_l_gsi_gss_session_new_callback(
+    SSL *                               ssl,
+    SSL_SESSION *                       session)
+{
+    gss_ctx_id_desc *                   context;
+    globus_gsi_callback_data_t          peer_data;
+    STACK_OF(X509) *                    chain = NULL;
+    X509 *                              cert;
+    const unsigned char *               id;
+    unsigned int                        id_length;
+    long                                timeout;
+    int                                 day;
+    int                                 sec;
+    int                                 kept = 0;
+
+    context = SSL_get_ex_data(ssl, globus_l_gsi_gss_context_index);
+
+    /*
+     * A resumed handshake's sessions would extend the verification it
+     * skipped past the cache timeout
+     */
+    if (context == NULL
+        || !context->session_cacheable
+        || SSL_session_reused(ssl))
+    {
+        goto exit;
+    }
+
+    /*
+     * Servers that don't tag their session ids may resume them without
+     * restoring the peer chain, so clients only keep tagged sessions.  A
+     * TLS 1.3 client's session id is a digest of its ticket, which when
+     * the server keeps its sessions is the server's session id.
+     */
+    id = SSL_SESSION_get_id(session, &id_length);
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+    if (context->locally_initiated && SSL_SESSION_has_ticket(session))
+    {
+        size_t                          ticket_length;
+
+        SSL_SESSION_get0_ticket(session, &id, &ticket_length);
+        id_length = ticket_length;
+    }
+#endif
+    if (id_length == 0
+        || id_length > SSL_MAX_SSL_SESSION_ID_LENGTH
+        || (context->locally_initiated
+            && (id_length < sizeof(globus_l_gsi_gss_session_id_tag)
+                || memcmp(id,
+                          globus_l_gsi_gss_session_id_tag,
+                          sizeof(globus_l_gsi_gss_session_id_tag)) != 0)))
+    {
+        goto exit;
+    }
+
+    /* each TLS 1.3 ticket after the first copies the last one's data */
+    peer_data = SSL_SESSION_get_ex_data(
+        session, globus_l_gsi_gss_session_index);
+    if (peer_data == NULL)
+    {
+        if (globus_gsi_callback_data_copy(
+                context->callback_data, &peer_data) != GLOBUS_SUCCESS)
+        {
+            globus_gsi_callback_data_destroy(peer_data);
+            goto exit;
+        }
+        /* the context's extension oids don't outlive it */
+        globus_gsi_callback_set_extension_oids(peer_data, NULL);
+        if (!SSL_SESSION_set_ex_data(
+                session, globus_l_gsi_gss_session_index, peer_data))
+        {
+            globus_gsi_callback_data_destroy(peer_data);
+            goto exit;
+        }
+    }
+
+    /* sessions never outlive the certificates either side presented */
+    if (globus_gsi_callback_get_cert_chain(
+            peer_data, &chain) != GLOBUS_SUCCESS)
+    {
+        chain = NULL;
+        goto exit;
+    }
+    timeout = globus_i_gsi_gssapi_session_cache_timeout;
+    for (int i = -1; i < sk_X509_num(chain); i++)
+    {
+        cert = (i < 0)
+            ? SSL_CTX_get0_certificate(SSL_get_SSL_CTX(ssl))
+            : sk_X509_value(chain, i);
+        if (cert != NULL
+            && ASN1_TIME_diff(&day, &sec, NULL, X509_get0_notAfter(cert))
+            && (long) day * 86400 + sec < timeout)
+        {
+            timeout = (long) day * 86400 + sec;
+        }
+    }
+    if (timeout <= 0)
+    {
+        goto exit;
+    }
+    SSL_SESSION_set_timeout(session, timeout);
+
+    if (context->locally_initiated)
+    {
+        globus_l_gsi_gss_session_store(
+            globus_l_gsi_gss_client_sessions,
+            context->session_key,
+            sizeof(context->session_key),
+            session);
+    }
+    else
+    {
+        globus_l_gsi_gss_session_store(
+            globus_l_gsi_gss_server_sessions, id, id_length, session);
+    }
+    kept = 1;
+
+exit:
+    if (chain != NULL)
+    {
+        sk_X509_pop_free(chain, X509_free);
+    }
+
+    return kept;
+}
+/* globus_l_gsi_gss_session_new_callback() */
+#endif
+
+/*
+ * Set the session id context of a new context's SSL, and offer a cached
+ * session to the server if this is the initiator.  Contexts whose
+ * handshake can't be skipped get no session id context, which keeps
+ * OpenSSL from resuming any of the cached sessions for them.
+ */
+static
+void
+globus_l_gsi_gss_session_setup(
+    gss_ctx_id_desc *                   context,
+    const gss_name_t                    target_name)
+{
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+    X509 *                              cert;
+    unsigned char                       cert_digest[EVP_MAX_MD_SIZE];
+    unsigned int                        cert_digest_length = 0;
+    unsigned char                       sid_ctx[EVP_MAX_MD_SIZE];
+    unsigned int                        sid_ctx_length = 0;
+    unsigned int                        key_length = 0;
+    unsigned char                       flags[4];
+    const char *                        target = "";
+    EVP_MD_CTX *                        md_ctx = NULL;
+    SSL_SESSION *                       session = NULL;
+    OM_uint32                           req_flags;
+    int                                 ok;
+#endif
+
+    context->session_cacheable = false;
+    context->session_resumed = false;
+
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+    /*
+     * Anonymous contexts have nothing to cache, extension checks made by
+     * the application and credentials picked by server name would be
+     * skipped by a resumed handshake
+     */
+    if (globus_i_gsi_gssapi_session_cache_timeout <= 0
+        || (context->req_flags & GSS_C_ANON_FLAG)
+        || (context->extension_oids != NULL
+            && context->extension_oids->count > 0)
+        || context->sni_credentials_count > 0)
+    {
+        return;
+    }
+
+    cert = SSL_CTX_get0_certificate(context->cred_handle->ssl_context);
+    if (cert == NULL
+        || !X509_digest(cert, EVP_sha256(), cert_digest, &cert_digest_length))
+    {
+        return;
+    }
+
+    /* delegation follows the handshake, so it doesn't split the cache */
+    req_flags = context->req_flags
+        & ~(GSS_C_DELEG_FLAG | GSS_C_GLOBUS_DELEGATE_LIMITED_PROXY_FLAG);
+    flags[0] = (unsigned char) ((req_flags >> 24) & 0xff);
+    flags[1] = (unsigned char) ((req_flags >> 16) & 0xff);
+    flags[2] = (unsigned char) ((req_flags >> 8) & 0xff);
+    flags[3] = (unsigned char) (req_flags & 0xff);
+
+    md_ctx = EVP_MD_CTX_new();
+    ok = md_ctx != NULL
+        && EVP_DigestInit_ex(md_ctx, EVP_sha256(), NULL)
+        && EVP_DigestUpdate(md_ctx, cert_digest, cert_digest_length)
+        && EVP_DigestUpdate(md_ctx, flags, sizeof(flags))
+        && EVP_DigestFinal_ex(md_ctx, sid_ctx, &sid_ctx_length)
+        && SSL_set_session_id_context(
+                context->gss_ssl, sid_ctx, sid_ctx_length)
+        && SSL_set_ex_data(
+                context->gss_ssl, globus_l_gsi_gss_context_index, context);
+
+    if (ok && context->locally_initiated)
+    {
+        if (target_name != GSS_C_NO_NAME)
+        {
+            if (target_name->x509n_oneline != NULL)
+            {
+                target = target_name->x509n_oneline;
+            }
+            else if (target_name->host_name != NULL)
+            {
+                target = target_name->host_name;
+            }
+            else if (target_name->ip_address != NULL)
+            {
+                target = target_name->ip_address;
+            }
+        }
+        ok = EVP_DigestInit_ex(md_ctx, EVP_sha256(), NULL)
+            && EVP_DigestUpdate(md_ctx, sid_ctx, sid_ctx_length)
+            && EVP_DigestUpdate(md_ctx, target, strlen(target) + 1)
+            && EVP_DigestFinal_ex(md_ctx, context->session_key, &key_length);
+
+        if (ok)
+        {
+            session = globus_l_gsi_gss_session_lookup(
+                globus_l_gsi_gss_client_sessions,
+                context->session_key,
+                key_length);
+        }
+        if (session != NULL)
+        {
+            SSL_set_session(context->gss_ssl, session);
+            SSL_SESSION_free(session);
+        }
+    }
+    context->session_cacheable = ok;
+
+    EVP_MD_CTX_free(md_ctx);
+#endif
+}
+/* globus_l_gsi_gss_session_setup() */
+
+/*
+ * Called when a context's handshake completes.  A resumed session gets
+ * the callback data of the handshake that verified the peer restored;
+ * full handshakes cache their sessions from
+ * globus_l_gsi_gss_session_new_callback().
+ */
+static
+OM_uint32
+globus_l_gsi_gss_session_finish(
+    OM_uint32 *                         minor_status,
+    gss_ctx_id_desc *                   context)
+{
+    OM_uint32                           major_status = GSS_S_COMPLETE;
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+    globus_result_t                     local_result = GLOBUS_SUCCESS;
+    SSL_SESSION *                       session;
+    globus_gsi_callback_data_t          peer_data = NULL;
+    STACK_OF(X509) *                    chain = NULL;
+    int                                 depth;
+    globus_gsi_cert_utils_cert_type_t   cert_type;
+
+    context->session_resumed = context->session_cacheable
+        && SSL_session_reused(context->gss_ssl);
+#endif
+
+    globus_mutex_lock(&globus_l_gsi_gss_session_mutex);
+    if (context->session_resumed)
+    {
+        globus_l_gsi_gss_sessions_resumed++;
+    }
+    else
+    {
+        globus_l_gsi_gss_sessions_full++;
+    }
+    globus_mutex_unlock(&globus_l_gsi_gss_session_mutex);
+
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+    if (!context->session_resumed)
+    {
+        goto exit;
+    }
+    session = SSL_get_session(context->gss_ssl);
+
+    peer_data = SSL_SESSION_get_ex_data(
+        session, globus_l_gsi_gss_session_index);
+    if (peer_data == NULL)
+    {
+        GLOBUS_GSI_GSSAPI_ERROR_RESULT(
+            minor_status,
+            GLOBUS_GSI_GSSAPI_ERROR_HANDSHAKE,
+            (_GGSL("Resumed a TLS session without a verified peer")));
+        major_status = GSS_S_FAILURE;
+        goto exit;
+    }
+
+    local_result = globus_gsi_callback_get_cert_chain(peer_data, &chain);
+    if (local_result != GLOBUS_SUCCESS)
+    {
+        goto callback_data_error;
+    }
+    local_result = globus_gsi_callback_set_cert_chain(
+        context->callback_data, chain);
+    if (local_result != GLOBUS_SUCCESS)
+    {
+        goto callback_data_error;
+    }
+    local_result = globus_gsi_callback_get_cert_depth(peer_data, &depth);
+    if (local_result != GLOBUS_SUCCESS)
+    {
+        goto callback_data_error;
+    }
+    local_result = globus_gsi_callback_set_cert_depth(
+        context->callback_data, depth);
+    if (local_result != GLOBUS_SUCCESS)
+    {
+        goto callback_data_error;
+    }
+    local_result = globus_gsi_callback_get_proxy_depth(peer_data, &depth);
+    if (local_result != GLOBUS_SUCCESS)
+    {
+        goto callback_data_error;
+    }
+    local_result = globus_gsi_callback_set_proxy_depth(
+        context->callback_data, depth);
+    if (local_result != GLOBUS_SUCCESS)
+    {
+        goto callback_data_error;
+    }
+    local_result = globus_gsi_callback_get_cert_type(
+        peer_data, &cert_type);
+    if (local_result != GLOBUS_SUCCESS)
+    {
+        goto callback_data_error;
+    }
+    local_result = globus_gsi_callback_set_cert_type(
+        context->callback_data, cert_type);
+    if (local_result != GLOBUS_SUCCESS)
+    {
+        goto callback_data_error;
+    }
+    goto exit;
+
+callback_data_error:
+    GLOBUS_GSI_GSSAPI_ERROR_CHAIN_RESULT(
+        minor_status, local_result,
+        GLOBUS_GSI_GSSAPI_ERROR_WITH_CALLBACK_DATA);
+    major_status = GSS_S_FAILURE;
+
+exit:
+    if (chain != NULL)
+    {
+        sk_X509_pop_free(chain, X509_free);
+    }
+#endif
+    GLOBUS_I_GSI_GSSAPI_DEBUG_FPRINTF(
+        3, (globus_i_gsi_gssapi_debug_fstream,
+            "TLS session %s\n",
+            context->session_resumed ? "resumed" : "not resumed"));
+
+    return major_status;
+}
+/* globus_l_gsi_gss_session_finish() */
+
 #endif /* GLOBUS_DONT_DOCUMENT_INTERNAL */
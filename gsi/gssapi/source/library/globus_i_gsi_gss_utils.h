@@ -194,6 +194,10 @@ extern int                              globus_i_gsi_gssapi_max_tls_protocol;
 extern const char *                     globus_i_gsi_gssapi_cipher_list;
 extern globus_bool_t                    globus_i_gsi_gssapi_server_cipher_order;
 extern uid_t                            globus_i_gsi_gssapi_vhost_cred_owner;
+extern int                              globus_i_gsi_gssapi_session_cache_timeout;
+
+/* default lifetime of resumable TLS sessions, in seconds */
+#define GLOBUS_I_GSI_GSSAPI_SESSION_CACHE_TIMEOUT 300
 
 typedef enum
 {
@@ -339,6 +343,17 @@ globus_i_gsi_gssapi_get_hostname(
     OM_uint32 *                         minor_status,
     gss_name_desc *                     name);
 
+void
+globus_i_gsi_gss_session_cache_init(void);
+
+void
+globus_i_gsi_gss_session_cache_flush(void);
+
+void
+globus_i_gsi_gss_session_cache_stats(
+    unsigned long *                     resumed,
+    unsigned long *                     full);
+
 OM_uint32
 globus_i_gss_read_vhost_cred_dir(
     OM_uint32                          *minor_status,
@@ -207,6 +207,12 @@ typedef struct gss_ctx_id_desc_struct{
     char                               *sni_servername;
     unsigned char                      *alpn;
     size_t                              alpn_length;
+    /** Key of this context's TLS session in the session cache */
+    unsigned char                       session_key[SSL_MAX_SID_CTX_LENGTH];
+    /** True if the TLS session may be cached and resumed */
+    bool                                session_cacheable;
+    /** True if the handshake resumed a cached TLS session */
+    bool                                session_resumed;
 } gss_ctx_id_desc;
 
 extern
@@ -236,6 +242,9 @@ const gss_OID_desc * const gss_ext_tls_version_oid;
 extern
 const gss_OID_desc * const gss_ext_tls_cipher_oid;
 
+extern
+const gss_OID_desc * const gss_ext_tls_session_resumed_oid;
+
 extern
 globus_bool_t                           globus_i_backward_compatible_mic;
 extern
@@ -255,6 +255,41 @@ GSS_CALLCONV gss_inquire_sec_context_by_oid(
             }
         }
     }
+    else if (g_OID_equal(desired_object, gss_ext_tls_session_resumed_oid))
+    {
+        /*
+         * Whether this context resumed a cached TLS session, followed by
+         * the number of resumed and full handshakes done by this process
+         */
+        unsigned long                   counts[2];
+        char                            value[3][24];
+
+        globus_i_gsi_gss_session_cache_stats(&counts[0], &counts[1]);
+        snprintf(value[0], sizeof(value[0]), "%d",
+                 context->session_resumed ? 1 : 0);
+        snprintf(value[1], sizeof(value[1]), "%lu", counts[0]);
+        snprintf(value[2], sizeof(value[2]), "%lu", counts[1]);
+
+        for (int i = 0; i < 3; i++)
+        {
+            major_status = gss_add_buffer_set_member(
+                &local_minor_status,
+                &(gss_buffer_desc)
+                {
+                    .value = value[i],
+                    .length = strlen(value[i]) + 1,
+                },
+                data_set);
+
+            if(GSS_ERROR(major_status))
+            {
+                GLOBUS_GSI_GSSAPI_ERROR_CHAIN_RESULT(
+                    minor_status, local_minor_status,
+                    GLOBUS_GSI_GSSAPI_ERROR_WITH_BUFFER);
+                goto unlock_exit;
+            }
+        }
+    }
     else if(((gss_OID_desc *)desired_object)->length !=
        gss_ext_x509_cert_chain_oid->length ||
        memcmp(((gss_OID_desc *)desired_object)->elements,
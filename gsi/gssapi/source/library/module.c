@@ -90,6 +90,15 @@ uid_t                                   globus_i_gsi_gssapi_vhost_cred_owner;
  */
 globus_bool_t                           globus_i_gsi_gssapi_server_cipher_order ;
 
+/**
+ * @brief TLS session cache timeout
+ * @details
+ * Number of seconds a TLS session may be resumed by later security
+ * contexts using the same credential and flags, or 0 to always do a full
+ * handshake.
+ */
+int                                     globus_i_gsi_gssapi_session_cache_timeout;
+
 globus_bool_t                           globus_i_backward_compatible_mic = GLOBUS_TRUE;
 
 globus_bool_t                           globus_i_accept_backward_compatible_mic = GLOBUS_TRUE;
@@ -258,6 +267,7 @@ globus_l_gsi_gssapi_parse_config(
         "GLOBUS_GSSAPI_SERVER_CIPHER_ORDER",
         "GLOBUS_GSSAPI_BACKWARD_COMPATIBLE_MIC",
         "GLOBUS_GSSAPI_VHOST_CRED_OWNER",
+        "GLOBUS_GSSAPI_SESSION_CACHE_TIMEOUT",
         NULL
     };
 
@@ -506,6 +516,21 @@ globus_l_gsi_gssapi_activate(void)
             globus_i_gsi_gssapi_server_cipher_order = GLOBUS_TRUE;
         }
     }
+
+    tmp_string = globus_module_getenv("GLOBUS_GSSAPI_SESSION_CACHE_TIMEOUT");
+    if (tmp_string != NULL)
+    {
+        globus_i_gsi_gssapi_session_cache_timeout = atoi(tmp_string);
+        if (globus_i_gsi_gssapi_session_cache_timeout < 0)
+        {
+            globus_i_gsi_gssapi_session_cache_timeout = 0;
+        }
+    }
+    else
+    {
+        globus_i_gsi_gssapi_session_cache_timeout =
+            GLOBUS_I_GSI_GSSAPI_SESSION_CACHE_TIMEOUT;
+    }
 #ifndef WIN32
     tmp_string = globus_module_getenv("GLOBUS_GSSAPI_VHOST_CRED_OWNER");
     if(tmp_string != GLOBUS_NULL)
@@ -590,6 +615,7 @@ getpwnam:
     {
         goto activate_gsi_callback_fail;
     }
+    globus_i_gsi_gss_session_cache_init();
 
     GLOBUS_I_GSI_GSSAPI_INTERNAL_DEBUG_EXIT;
 
@@ -635,6 +661,8 @@ globus_l_gsi_gssapi_deactivate(void)
 {
     GLOBUS_I_GSI_GSSAPI_DEBUG_ENTER;
 
+    globus_i_gsi_gss_session_cache_flush();
+
     globus_module_deactivate(GLOBUS_GSI_CALLBACK_MODULE);
     globus_module_deactivate(GLOBUS_GSI_PROXY_MODULE);
     globus_module_deactivate(GLOBUS_OPENSSL_MODULE);
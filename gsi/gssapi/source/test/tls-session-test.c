@@ -0,0 +1,292 @@
+/*
+ * Copyright 1999-2017 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gssapi_test_utils.h"
+#include <stdbool.h>
+
+static gss_OID_desc tls_session_resumed_oid_desc =
+     {11, "\x2b\x06\x01\x04\x01\x9b\x50\x01\x01\x01\x0d"};
+static gss_OID_desc * tls_session_resumed_oid = &tls_session_resumed_oid_desc;
+
+struct test_case
+{
+    const char *                        name;
+    const char *                        cache_timeout;
+    bool                                resume;
+};
+
+/*
+ * Returns whether the context resumed a session, or -1 if the extension
+ * didn't answer as expected
+ */
+static
+int
+session_resumed(
+    gss_ctx_id_t                        context,
+    unsigned long *                     resumed_count)
+{
+    OM_uint32                           major_status;
+    OM_uint32                           minor_status;
+    gss_buffer_set_desc                *data = NULL;
+    int                                 result = -1;
+
+    major_status = gss_inquire_sec_context_by_oid(
+        &minor_status,
+        context,
+        tls_session_resumed_oid,
+        &data);
+
+    if (major_status == GSS_S_COMPLETE && data->count == 3)
+    {
+        result = (strcmp(data->elements[0].value, "1") == 0);
+        *resumed_count = strtoul(data->elements[1].value, NULL, 10);
+    }
+    gss_release_buffer_set(&minor_status, &data);
+
+    return result;
+}
+/* session_resumed() */
+
+/*
+ * Establish a pair of contexts, and check whether both ends resumed the
+ * session and agree on the peer names.  Sets resumed_count to the
+ * acceptor's count of resumed handshakes.
+ */
+static
+bool
+establish(
+    bool                                resume,
+    unsigned long *                     resumed_count,
+    const char                        **why)
+{
+    OM_uint32                           major_status = GSS_S_COMPLETE;
+    OM_uint32                           minor_status = GLOBUS_SUCCESS;
+    OM_uint32                           ignore_minor_status = 0;
+    gss_ctx_id_t                        init_context = GSS_C_NO_CONTEXT;
+    gss_ctx_id_t                        accept_context = GSS_C_NO_CONTEXT;
+    gss_buffer_desc                     init_generated_token = {0};
+    gss_buffer_desc                     accept_generated_token = {0};
+    gss_name_t                          init_source = GSS_C_NO_NAME;
+    gss_name_t                          accept_source = GSS_C_NO_NAME;
+    unsigned long                       init_count = 0;
+    unsigned long                       accept_count = 0;
+    int                                 name_equal = 0;
+    bool                                result = true;
+
+    do
+    {
+        major_status = gss_init_sec_context(
+                &minor_status,
+                GSS_C_NO_CREDENTIAL,
+                &init_context,
+                GSS_C_NO_NAME,
+                GSS_C_NO_OID,
+                GSS_C_CONF_FLAG|GSS_C_MUTUAL_FLAG,
+                0,
+                GSS_C_NO_CHANNEL_BINDINGS,
+                &accept_generated_token,
+                NULL,
+                &init_generated_token,
+                NULL,
+                NULL);
+
+        gss_release_buffer(
+                &ignore_minor_status,
+                &accept_generated_token);
+
+        if (GSS_ERROR(major_status))
+        {
+            *why = "gss_init_sec_context";
+            result = false;
+            goto fail;
+        }
+
+        if (init_generated_token.length > 0)
+        {
+            major_status = gss_accept_sec_context(
+                    &minor_status,
+                    &accept_context,
+                    GSS_C_NO_CREDENTIAL,
+                    &init_generated_token,
+                    GSS_C_NO_CHANNEL_BINDINGS,
+                    &init_source,
+                    NULL,
+                    &accept_generated_token,
+                    NULL,
+                    NULL,
+                    NULL);
+            gss_release_buffer(
+                    &ignore_minor_status,
+                    &init_generated_token);
+
+            if (GSS_ERROR(major_status))
+            {
+                *why = "gss_accept_sec_context";
+                result = false;
+                goto fail;
+            }
+        }
+    }
+    while (major_status == GSS_S_CONTINUE_NEEDED);
+
+    if (session_resumed(init_context, &init_count) != resume)
+    {
+        *why = resume ? "initiator didn't resume" : "initiator resumed";
+        result = false;
+        goto fail;
+    }
+    if (session_resumed(accept_context, &accept_count) != resume)
+    {
+        *why = resume ? "acceptor didn't resume" : "acceptor resumed";
+        result = false;
+        goto fail;
+    }
+    *resumed_count = accept_count;
+
+    /* the acceptor must still know who the initiator is */
+    major_status = gss_inquire_context(
+            &minor_status,
+            init_context,
+            &accept_source,
+            NULL,
+            NULL,
+            NULL,
+            NULL,
+            NULL,
+            NULL);
+    if (GSS_ERROR(major_status))
+    {
+        *why = "gss_inquire_context";
+        result = false;
+        goto fail;
+    }
+    major_status = gss_compare_name(
+            &minor_status,
+            init_source,
+            accept_source,
+            &name_equal);
+    if (GSS_ERROR(major_status) || !name_equal)
+    {
+        *why = "peer name";
+        result = false;
+        goto fail;
+    }
+
+fail:
+    if (major_status != GSS_S_COMPLETE)
+    {
+        globus_gsi_gssapi_test_print_error(
+                stderr,
+                major_status,
+                minor_status);
+    }
+    gss_release_name(&ignore_minor_status, &init_source);
+    gss_release_name(&ignore_minor_status, &accept_source);
+    if (init_context != GSS_C_NO_CONTEXT)
+    {
+        gss_delete_sec_context(
+                &ignore_minor_status,
+                &init_context,
+                NULL);
+    }
+    if (accept_context != GSS_C_NO_CONTEXT)
+    {
+        gss_delete_sec_context(
+                &ignore_minor_status,
+                &accept_context,
+                NULL);
+    }
+    gss_release_buffer(&ignore_minor_status, &init_generated_token);
+    gss_release_buffer(&ignore_minor_status, &accept_generated_token);
+
+    return result;
+}
+/* establish() */
+
+/**
+ * @brief Test case for TLS session resumption
+ * @details
+ *     In this test case, establish two security contexts in a row and
+ *     check that the first does a full handshake and the second resumes
+ *     its session if the cache is enabled, with the same peer names.  The
+ *     count of resumed handshakes must go up by one for each end of the
+ *     second pair of contexts, and not at all otherwise.
+ */
+static
+bool
+session_test(
+    const char *                        cache_timeout,
+    bool                                resume)
+{
+    const char                         *why = "";
+    unsigned long                       first_count = 0;
+    unsigned long                       second_count = 0;
+    bool                                ok;
+
+    globus_libc_setenv(
+        "GLOBUS_GSSAPI_SESSION_CACHE_TIMEOUT", cache_timeout, 1);
+    globus_module_activate(GLOBUS_GSI_GSSAPI_MODULE);
+
+    ok = establish(false, &first_count, &why)
+        && establish(resume, &second_count, &why);
+    if (ok && second_count != first_count + (resume ? 2 : 0))
+    {
+        why = "resumed handshakes miscounted";
+        ok = false;
+    }
+    if (!ok)
+    {
+        fprintf(stderr, "Failed because %s\n", why);
+    }
+
+    globus_module_deactivate(GLOBUS_GSI_GSSAPI_MODULE);
+
+    return ok;
+}
+/* session_test() */
+
+#define TEST_CASE_INITIALIZER(n, t, r) {n, t, r}
+
+int
+main(int argc, char *argv[])
+{
+    int                                 failed = 0;
+    struct test_case                    test_cases[] =
+    {
+        TEST_CASE_INITIALIZER("resumed", "300", true),
+        TEST_CASE_INITIALIZER("cache_disabled", "0", false),
+    };
+    size_t num_test_cases = sizeof(test_cases)/sizeof(test_cases[0]);
+    printf("1..%zu\n", num_test_cases);
+
+    for (size_t i = 0; i < num_test_cases; i++)
+    {
+        bool                            ok = false;
+
+        ok = session_test(
+            test_cases[i].cache_timeout,
+            test_cases[i].resume);
+        if (!ok)
+        {
+            printf("not ");
+            failed++;
+        }
+        printf("ok %zu - %s\n",
+                i+1,
+                test_cases[i].name);
+    }
+    exit(failed);
+}
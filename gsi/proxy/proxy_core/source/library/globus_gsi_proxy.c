@@ -35,10 +35,6 @@
 #define X509_get_signature_nid(c) \
             OBJ_obj2nid((c)->sig_alg->algorithm)
 #endif
-#if OPENSSL_VERSION_NUMBER < 0x10100000L
-#define BN_GENCB_new() malloc(sizeof(BN_GENCB))
-#define BN_GENCB_free(g) free(g)
-#endif
 
 #ifndef GLOBUS_DONT_DOCUMENT_INTERNAL
 
@@ -151,6 +147,8 @@ globus_l_gsi_proxy_activate(void)
         goto exit;
     }
 
+    globus_i_gsi_proxy_key_pool_init();
+
     GLOBUS_I_GSI_PROXY_DEBUG_EXIT;
 
  exit:
@@ -169,6 +167,8 @@ globus_l_gsi_proxy_deactivate(void)
 
     GLOBUS_I_GSI_PROXY_DEBUG_ENTER;
 
+    globus_i_gsi_proxy_key_pool_destroy();
+
     globus_module_deactivate(GLOBUS_OPENSSL_MODULE);
 
     globus_module_deactivate(GLOBUS_GSI_CREDENTIAL_MODULE);
@@ -216,12 +216,8 @@ globus_gsi_proxy_create_req(
 {
     X509_NAME *                         req_name = NULL;
     X509_NAME_ENTRY *                   req_name_entry = NULL;
-    RSA *                               rsa_key = NULL;
     globus_result_t                     result = GLOBUS_SUCCESS;
     int                                 pci_NID = NID_undef;
-    BIGNUM *                            e = NULL;
-    BN_GENCB *                          gencbp = NULL;
-    int                                 rc = 0;
 
     GLOBUS_I_GSI_PROXY_DEBUG_ENTER;
         
@@ -252,78 +248,15 @@ globus_gsi_proxy_create_req(
         goto exit;
     }
 
-    /* initialize the private key */
-    if((handle->proxy_key = EVP_PKEY_new()) == NULL)
-    {
-        GLOBUS_GSI_PROXY_OPENSSL_ERROR_RESULT(
-            result,
-            GLOBUS_GSI_PROXY_ERROR_WITH_PRIVATE_KEY,
-            (_PCSL("Couldn't create new private key structure for handle")));
-        goto exit;
-    }
-
-    /* First, generate and setup private/public key pair */
-    rsa_key = RSA_new();
-    if(rsa_key == NULL)
-    {
-        GLOBUS_GSI_PROXY_OPENSSL_ERROR_RESULT(
-            result,
-            GLOBUS_GSI_PROXY_ERROR_WITH_PRIVATE_KEY, 
-            (_PCSL("Couldn't generate RSA key pair for proxy handle")));
-        goto exit;
-    }
-
-    e = BN_new();
-    if (e == NULL)
-    {
-        GLOBUS_GSI_PROXY_OPENSSL_ERROR_RESULT(
-            result,
-            GLOBUS_GSI_PROXY_ERROR_WITH_PRIVATE_KEY, 
-            (_PCSL("Couldn't generate RSA key pair for proxy handle")));
-        goto exit;
-    }
-    rc = BN_add_word(e, (BN_ULONG) handle->attrs->init_prime);
-    if (rc != 1)
-    {
-        GLOBUS_GSI_PROXY_OPENSSL_ERROR_RESULT(
-            result,
-            GLOBUS_GSI_PROXY_ERROR_WITH_PRIVATE_KEY, 
-            (_PCSL("Couldn't generate RSA key pair for proxy handle")));
-        goto exit;
-    }
-    gencbp = BN_GENCB_new();
-    if (gencbp == NULL)
-    {
-        GLOBUS_GSI_PROXY_OPENSSL_ERROR_RESULT(
-            result,
-            GLOBUS_GSI_PROXY_ERROR_WITH_PRIVATE_KEY, 
-            (_PCSL("Couldn't generate RSA key pair for proxy handle")));
-        goto exit;
-    }
-    BN_GENCB_set_old(gencbp, handle->attrs->key_gen_callback, NULL);
-
-    rc = RSA_generate_key_ex(rsa_key, handle->attrs->key_bits, e, gencbp);
-
-    BN_GENCB_free(gencbp);
-
-    if(rc != 1)
+    /* Get a private/public key pair, ready made if the key pool has one */
+    result = globus_i_gsi_proxy_key_pool_get(
+        handle->attrs, &handle->proxy_key);
+    if(result != GLOBUS_SUCCESS)
     {
-        GLOBUS_GSI_PROXY_OPENSSL_ERROR_RESULT(
-            result,
-            GLOBUS_GSI_PROXY_ERROR_WITH_PRIVATE_KEY, 
-            (_PCSL("Couldn't generate RSA key pair for proxy handle")));
+        handle->proxy_key = NULL;
         goto exit;
     }
 
-    if(!EVP_PKEY_assign_RSA(handle->proxy_key, rsa_key))
-    {
-        GLOBUS_GSI_PROXY_OPENSSL_ERROR_RESULT(
-            result,
-            GLOBUS_GSI_PROXY_ERROR_WITH_PRIVATE_KEY,
-            (_PCSL("Could not set private key in proxy handle")));
-        goto error_exit;
-    }
-
     if(!X509_REQ_set_version(handle->req, 0L))
     {
         GLOBUS_GSI_PROXY_ERROR_RESULT(
@@ -618,17 +551,8 @@ globus_gsi_proxy_create_req(
     goto exit;
 
  error_exit:
-    if(rsa_key)
-    {
-        RSA_free(rsa_key);
-    }
-
  exit:
 
-    if (e != NULL)
-    {
-        BN_free(e);
-    }
     if(req_name)
     {
         X509_NAME_free(req_name);
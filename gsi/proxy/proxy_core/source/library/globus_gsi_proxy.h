@@ -452,6 +452,20 @@ globus_gsi_proxy_handle_attrs_set_key_gen_callback(
     globus_gsi_proxy_handle_attrs_t     handle,
     void                                (*callback)(int,  int, void *));
 
+globus_result_t
+globus_gsi_proxy_handle_attrs_set_key_type(
+    globus_gsi_proxy_handle_attrs_t     handle_attrs,
+    int                                 key_type);
+
+globus_result_t
+globus_gsi_proxy_handle_attrs_get_key_type(
+    globus_gsi_proxy_handle_attrs_t     handle_attrs,
+    int *                               key_type);
+
+globus_result_t
+globus_gsi_proxy_key_pool_set_size(
+    int                                 pool_size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -96,6 +96,7 @@ globus_gsi_proxy_handle_attrs_init(
     attrs->signing_algorithm = DEFAULT_SIGNING_ALGORITHM;
     attrs->clock_skew = DEFAULT_CLOCK_SKEW;
     attrs->key_gen_callback = NULL;
+    attrs->key_type = EVP_PKEY_RSA;
     
     result = GLOBUS_SUCCESS;
    
@@ -599,6 +600,108 @@ exit:
     return result;
 }
 
+/**
+ * @brief Set Key Type
+ * @ingroup globus_gsi_proxy_handle_attrs
+ * @details
+ * Set the type of public/private key pair to generate for the
+ * certificate request.  For EVP_PKEY_EC keys, the key bits select the
+ * curve: 256, 384 or 521, or an RSA key size which is mapped to the curve
+ * of comparable strength.
+ *
+ * @param handle_attrs
+ *        The handle_attrs to set the key type of
+ * @param key_type
+ *        EVP_PKEY_RSA (the default) or EVP_PKEY_EC
+ *
+ * @return
+ *        GLOBUS_SUCCESS if the handle_attrs is valid, otherwise an error
+ *        is returned
+ */
+globus_result_t
+globus_gsi_proxy_handle_attrs_set_key_type(
+    globus_gsi_proxy_handle_attrs_t     handle_attrs,
+    int                                 key_type)
+{
+    globus_result_t                     result = GLOBUS_SUCCESS;
+
+    GLOBUS_I_GSI_PROXY_DEBUG_ENTER;
+
+    if (handle_attrs == NULL)
+    {
+        GLOBUS_GSI_PROXY_ERROR_RESULT(
+            result,
+            GLOBUS_GSI_PROXY_ERROR_WITH_HANDLE_ATTRS,
+            (_PCSL("NULL handle attributes passed to function: %s"),
+             __func__));
+        goto exit;
+    }
+    if (key_type != EVP_PKEY_RSA && key_type != EVP_PKEY_EC)
+    {
+        GLOBUS_GSI_PROXY_ERROR_RESULT(
+            result,
+            GLOBUS_GSI_PROXY_INVALID_PARAMETER,
+            (_PCSL("Unsupported key type passed to function: %s"),
+             __func__));
+        goto exit;
+    }
+    handle_attrs->key_type = key_type;
+
+exit:
+    GLOBUS_I_GSI_PROXY_DEBUG_EXIT;
+    return result;
+}
+
+/**
+ * @brief Get Key Type
+ * @ingroup globus_gsi_proxy_handle_attrs
+ * @details
+ * Get the type of public/private key pair to generate for the
+ * certificate request
+ *
+ * @param handle_attrs
+ *        The handle_attrs to get the key type from
+ * @param key_type
+ *        EVP_PKEY_RSA or EVP_PKEY_EC
+ *
+ * @return
+ *        GLOBUS_SUCCESS if the handle_attrs is valid, otherwise an error
+ *        is returned
+ */
+globus_result_t
+globus_gsi_proxy_handle_attrs_get_key_type(
+    globus_gsi_proxy_handle_attrs_t     handle_attrs,
+    int *                               key_type)
+{
+    globus_result_t                     result = GLOBUS_SUCCESS;
+
+    GLOBUS_I_GSI_PROXY_DEBUG_ENTER;
+
+    if (handle_attrs == NULL)
+    {
+        GLOBUS_GSI_PROXY_ERROR_RESULT(
+            result,
+            GLOBUS_GSI_PROXY_ERROR_WITH_HANDLE_ATTRS,
+            (_PCSL("NULL handle attributes passed to function: %s"),
+             __func__));
+        goto exit;
+    }
+    if (key_type == NULL)
+    {
+        GLOBUS_GSI_PROXY_ERROR_RESULT(
+            result,
+            GLOBUS_GSI_PROXY_INVALID_PARAMETER,
+            (_PCSL("NULL key type passed to function: %s"),
+             __func__));
+        goto exit;
+    }
+    *key_type = handle_attrs->key_type;
+
+exit:
+    GLOBUS_I_GSI_PROXY_DEBUG_EXIT;
+    return result;
+}
+
 /**
  * @brief Copy Attributes
  * @ingroup globus_gsi_proxy_handle_attrs
@@ -654,6 +757,7 @@ globus_gsi_proxy_handle_attrs_copy(
     (*b)->signing_algorithm = a->signing_algorithm;
     (*b)->clock_skew = a->clock_skew;
     (*b)->key_gen_callback = a->key_gen_callback;
+    (*b)->key_type = a->key_type;
 
     result = GLOBUS_SUCCESS;
     goto exit;
@@ -0,0 +1,589 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLOBUS_DONT_DOCUMENT_INTERNAL
+/**
+ * @file globus_gsi_proxy_key_pool.c
+ * @brief GSI Proxy Key Generation and Key Pool
+ */
+#endif
+
+#include "globus_i_gsi_proxy.h"
+#include "openssl/rsa.h"
+#include "openssl/ec.h"
+#include <errno.h>
+#include <unistd.h>
+
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+#define BN_GENCB_new() malloc(sizeof(BN_GENCB))
+#define BN_GENCB_free(g) free(g)
+#endif
+
+#ifndef GLOBUS_DONT_DOCUMENT_INTERNAL
+
+/* Number of different key types and sizes kept in the pool */
+#define GLOBUS_L_GSI_PROXY_KEY_POOL_KINDS 8
+
+/* Keys of one type, size and public exponent */
+typedef struct
+{
+    int                                 key_type;
+    int                                 key_bits;
+    int                                 init_prime;
+    EVP_PKEY **                         keys;
+    int                                 num_keys;
+}
+globus_l_gsi_proxy_key_kind_t;
+
+static globus_mutex_t                   globus_l_gsi_proxy_key_pool_mutex;
+static globus_cond_t                    globus_l_gsi_proxy_key_pool_cond;
+/* Number of keys of each kind to keep ready; 0 disables the pool */
+static int                              globus_l_gsi_proxy_key_pool_size;
+static globus_l_gsi_proxy_key_kind_t    globus_l_gsi_proxy_key_pool_kinds[
+                                            GLOBUS_L_GSI_PROXY_KEY_POOL_KINDS];
+static int                              globus_l_gsi_proxy_key_pool_num_kinds;
+static globus_bool_t                    globus_l_gsi_proxy_key_pool_running;
+static globus_bool_t                    globus_l_gsi_proxy_key_pool_shutdown;
+/* Process the pooled keys were generated in */
+static pid_t                            globus_l_gsi_proxy_key_pool_pid;
+
+/*
+ * Map a key size to an elliptic curve.  Sizes up to 521 bits name the
+ * curve size directly; larger sizes are taken as an RSA key size and
+ * mapped to the curve of comparable strength.
+ */
+static
+int
+globus_l_gsi_proxy_ec_curve(
+    int                                 key_bits)
+{
+    if (key_bits <= 256 || (key_bits > 521 && key_bits <= 3072))
+    {
+        return NID_X9_62_prime256v1;
+    }
+    else if (key_bits <= 384 || (key_bits > 521 && key_bits <= 7680))
+    {
+        return NID_secp384r1;
+    }
+    else
+    {
+        return NID_secp521r1;
+    }
+}
+/* globus_l_gsi_proxy_ec_curve() */
+
+#endif /* GLOBUS_DONT_DOCUMENT_INTERNAL */
+
+/**
+ * Generate a new key pair
+ *
+ * @param key_type
+ *        EVP_PKEY_RSA or EVP_PKEY_EC
+ * @param key_bits
+ *        The RSA modulus size, or the EC curve size
+ * @param init_prime
+ *        The RSA public exponent
+ * @param key_gen_callback
+ *        RSA key generation progress callback, or NULL
+ * @param key
+ *        The new key pair
+ */
+globus_result_t
+globus_i_gsi_proxy_generate_key(
+    int                                 key_type,
+    int                                 key_bits,
+    int                                 init_prime,
+    void                                (*key_gen_callback)(int, int, void *),
+    EVP_PKEY **                         key)
+{
+    EVP_PKEY *                          pkey = NULL;
+    RSA *                               rsa_key = NULL;
+    EC_KEY *                            ec_key = NULL;
+    BIGNUM *                            e = NULL;
+    BN_GENCB *                          gencbp = NULL;
+    globus_result_t                     result = GLOBUS_SUCCESS;
+    int                                 rc;
+
+    GLOBUS_I_GSI_PROXY_DEBUG_ENTER;
+
+    if((pkey = EVP_PKEY_new()) == NULL)
+    {
+        GLOBUS_GSI_PROXY_OPENSSL_ERROR_RESULT(
+            result,
+            GLOBUS_GSI_PROXY_ERROR_WITH_PRIVATE_KEY,
+            (_PCSL("Couldn't create new private key structure for handle")));
+        goto exit;
+    }
+
+    if (key_type == EVP_PKEY_EC)
+    {
+        ec_key = EC_KEY_new_by_curve_name(
+            globus_l_gsi_proxy_ec_curve(key_bits));
+        if (ec_key == NULL)
+        {
+            GLOBUS_GSI_PROXY_OPENSSL_ERROR_RESULT(
+                result,
+                GLOBUS_GSI_PROXY_ERROR_WITH_PRIVATE_KEY,
+                (_PCSL("Couldn't generate EC key pair for proxy handle")));
+            goto error_exit;
+        }
+        EC_KEY_set_asn1_flag(ec_key, OPENSSL_EC_NAMED_CURVE);
+
+        if (!EC_KEY_generate_key(ec_key) ||
+            !EVP_PKEY_assign_EC_KEY(pkey, ec_key))
+        {
+            EC_KEY_free(ec_key);
+            GLOBUS_GSI_PROXY_OPENSSL_ERROR_RESULT(
+                result,
+                GLOBUS_GSI_PROXY_ERROR_WITH_PRIVATE_KEY,
+                (_PCSL("Couldn't generate EC key pair for proxy handle")));
+            goto error_exit;
+        }
+        goto done;
+    }
+    else if (key_type != EVP_PKEY_RSA)
+    {
+        GLOBUS_GSI_PROXY_ERROR_RESULT(
+            result,
+            GLOBUS_GSI_PROXY_INVALID_PARAMETER,
+            (_PCSL("Unsupported key type: %d"), key_type));
+        goto error_exit;
+    }
+
+    rsa_key = RSA_new();
+    e = BN_new();
+    gencbp = BN_GENCB_new();
+    if (rsa_key == NULL || e == NULL || gencbp == NULL ||
+        BN_add_word(e, (BN_ULONG) init_prime) != 1)
+    {
+        RSA_free(rsa_key);
+        GLOBUS_GSI_PROXY_OPENSSL_ERROR_RESULT(
+            result,
+            GLOBUS_GSI_PROXY_ERROR_WITH_PRIVATE_KEY,
+            (_PCSL("Couldn't generate RSA key pair for proxy handle")));
+        goto error_exit;
+    }
+    BN_GENCB_set_old(gencbp, key_gen_callback, NULL);
+
+    rc = RSA_generate_key_ex(rsa_key, key_bits, e, gencbp);
+
+    if (rc != 1 || !EVP_PKEY_assign_RSA(pkey, rsa_key))
+    {
+        RSA_free(rsa_key);
+        GLOBUS_GSI_PROXY_OPENSSL_ERROR_RESULT(
+            result,
+            GLOBUS_GSI_PROXY_ERROR_WITH_PRIVATE_KEY,
+            (_PCSL("Couldn't generate RSA key pair for proxy handle")));
+        goto error_exit;
+    }
+
+ done:
+    *key = pkey;
+    goto exit;
+
+ error_exit:
+    EVP_PKEY_free(pkey);
+
+ exit:
+    if (gencbp != NULL)
+    {
+        BN_GENCB_free(gencbp);
+    }
+    if (e != NULL)
+    {
+        BN_free(e);
+    }
+
+    GLOBUS_I_GSI_PROXY_DEBUG_EXIT;
+    return result;
+}
+/* globus_i_gsi_proxy_generate_key() */
+
+#ifndef GLOBUS_DONT_DOCUMENT_INTERNAL
+
+/*
+ * Drop all pooled keys.  Called with the pool mutex locked.
+ */
+static
+void
+globus_l_gsi_proxy_key_pool_flush(void)
+{
+    globus_l_gsi_proxy_key_kind_t *     kind;
+    int                                 i;
+    int                                 j;
+
+    for (i = 0; i < globus_l_gsi_proxy_key_pool_num_kinds; i++)
+    {
+        kind = &globus_l_gsi_proxy_key_pool_kinds[i];
+        for (j = 0; j < kind->num_keys; j++)
+        {
+            EVP_PKEY_free(kind->keys[j]);
+        }
+        free(kind->keys);
+    }
+    globus_l_gsi_proxy_key_pool_num_kinds = 0;
+}
+/* globus_l_gsi_proxy_key_pool_flush() */
+
+/*
+ * Return the pool kind with the fewest keys, or NULL if every kind is
+ * full.  Called with the pool mutex locked.
+ */
+static
+globus_l_gsi_proxy_key_kind_t *
+globus_l_gsi_proxy_key_pool_emptiest(void)
+{
+    globus_l_gsi_proxy_key_kind_t *     emptiest = NULL;
+    globus_l_gsi_proxy_key_kind_t *     kind;
+    int                                 i;
+
+    for (i = 0; i < globus_l_gsi_proxy_key_pool_num_kinds; i++)
+    {
+        kind = &globus_l_gsi_proxy_key_pool_kinds[i];
+        if (kind->num_keys < globus_l_gsi_proxy_key_pool_size &&
+            (emptiest == NULL || kind->num_keys < emptiest->num_keys))
+        {
+            emptiest = kind;
+        }
+    }
+
+    return emptiest;
+}
+/* globus_l_gsi_proxy_key_pool_emptiest() */
+
+/*
+ * Key factory thread: keeps every kind of key that has been asked for
+ * topped up to the pool size, generating one key at a time without the
+ * pool mutex held.
+ */
+static
+void *
+globus_l_gsi_proxy_key_pool_thread(
+    void *                              arg)
+{
+    globus_l_gsi_proxy_key_kind_t *     kind;
+    int                                 key_type;
+    int                                 key_bits;
+    int                                 init_prime;
+    EVP_PKEY *                          key;
+    globus_result_t                     result;
+    int                                 i;
+
+    globus_mutex_lock(&globus_l_gsi_proxy_key_pool_mutex);
+    while (!globus_l_gsi_proxy_key_pool_shutdown)
+    {
+        kind = globus_l_gsi_proxy_key_pool_emptiest();
+        if (kind == NULL)
+        {
+            globus_cond_wait(
+                &globus_l_gsi_proxy_key_pool_cond,
+                &globus_l_gsi_proxy_key_pool_mutex);
+            continue;
+        }
+        key_type = kind->key_type;
+        key_bits = kind->key_bits;
+        init_prime = kind->init_prime;
+        globus_mutex_unlock(&globus_l_gsi_proxy_key_pool_mutex);
+
+        key = NULL;
+        result = globus_i_gsi_proxy_generate_key(
+            key_type, key_bits, init_prime, NULL, &key);
+        if (result != GLOBUS_SUCCESS)
+        {
+            globus_object_free(globus_error_get(result));
+        }
+
+        globus_mutex_lock(&globus_l_gsi_proxy_key_pool_mutex);
+        if (key == NULL)
+        {
+            /* Leave the rest to globus_gsi_proxy_create_req() */
+            break;
+        }
+
+        /* The pool may have been flushed or resized meanwhile */
+        for (i = 0; i < globus_l_gsi_proxy_key_pool_num_kinds; i++)
+        {
+            kind = &globus_l_gsi_proxy_key_pool_kinds[i];
+            if (kind->key_type == key_type &&
+                kind->key_bits == key_bits &&
+                kind->init_prime == init_prime &&
+                kind->num_keys < globus_l_gsi_proxy_key_pool_size)
+            {
+                kind->keys[kind->num_keys++] = key;
+                key = NULL;
+                break;
+            }
+        }
+        EVP_PKEY_free(key);
+    }
+    globus_l_gsi_proxy_key_pool_running = GLOBUS_FALSE;
+    globus_cond_broadcast(&globus_l_gsi_proxy_key_pool_cond);
+    globus_mutex_unlock(&globus_l_gsi_proxy_key_pool_mutex);
+
+    return NULL;
+}
+/* globus_l_gsi_proxy_key_pool_thread() */
+
+/*
+ * Take a key of the given kind from the pool, and register the kind with
+ * the key factory if it is new.  Returns NULL if there is no key ready.
+ * Called with the pool mutex locked.
+ */
+static
+EVP_PKEY *
+globus_l_gsi_proxy_key_pool_take(
+    int                                 key_type,
+    int                                 key_bits,
+    int                                 init_prime)
+{
+    globus_l_gsi_proxy_key_kind_t *     kind = NULL;
+    globus_thread_t                     thread;
+    EVP_PKEY *                          key = NULL;
+    int                                 i;
+
+    /* Keys generated before a fork must not be used by both processes */
+    if (globus_l_gsi_proxy_key_pool_pid != getpid())
+    {
+        globus_l_gsi_proxy_key_pool_flush();
+        globus_l_gsi_proxy_key_pool_running = GLOBUS_FALSE;
+        globus_l_gsi_proxy_key_pool_pid = getpid();
+    }
+
+    for (i = 0; i < globus_l_gsi_proxy_key_pool_num_kinds; i++)
+    {
+        if (globus_l_gsi_proxy_key_pool_kinds[i].key_type == key_type &&
+            globus_l_gsi_proxy_key_pool_kinds[i].key_bits == key_bits &&
+            globus_l_gsi_proxy_key_pool_kinds[i].init_prime == init_prime)
+        {
+            kind = &globus_l_gsi_proxy_key_pool_kinds[i];
+            break;
+        }
+    }
+
+    if (kind == NULL &&
+        globus_l_gsi_proxy_key_pool_num_kinds <
+            GLOBUS_L_GSI_PROXY_KEY_POOL_KINDS)
+    {
+        kind = &globus_l_gsi_proxy_key_pool_kinds[
+            globus_l_gsi_proxy_key_pool_num_kinds];
+        kind->keys = calloc(
+            globus_l_gsi_proxy_key_pool_size, sizeof(EVP_PKEY *));
+        if (kind->keys == NULL)
+        {
+            return NULL;
+        }
+        kind->key_type = key_type;
+        kind->key_bits = key_bits;
+        kind->init_prime = init_prime;
+        kind->num_keys = 0;
+        globus_l_gsi_proxy_key_pool_num_kinds++;
+    }
+    if (kind == NULL)
+    {
+        return NULL;
+    }
+
+    if (kind->num_keys > 0)
+    {
+        key = kind->keys[--kind->num_keys];
+        kind->keys[kind->num_keys] = NULL;
+    }
+
+    if (!globus_l_gsi_proxy_key_pool_running &&
+        !globus_l_gsi_proxy_key_pool_shutdown)
+    {
+        if (globus_thread_create(
+                &thread, NULL, globus_l_gsi_proxy_key_pool_thread, NULL) == 0)
+        {
+            globus_l_gsi_proxy_key_pool_running = GLOBUS_TRUE;
+        }
+    }
+    globus_cond_signal(&globus_l_gsi_proxy_key_pool_cond);
+
+    return key;
+}
+/* globus_l_gsi_proxy_key_pool_take() */
+
+/**
+ * Initialize the key pool.  The pool size is read from the
+ * GLOBUS_GSI_PROXY_KEY_POOL_SIZE environment variable.
+ */
+void
+globus_i_gsi_proxy_key_pool_init(void)
+{
+    char *                              tmpstring;
+
+    globus_mutex_init(&globus_l_gsi_proxy_key_pool_mutex, NULL);
+    globus_cond_init(&globus_l_gsi_proxy_key_pool_cond, NULL);
+    globus_l_gsi_proxy_key_pool_num_kinds = 0;
+    globus_l_gsi_proxy_key_pool_running = GLOBUS_FALSE;
+    globus_l_gsi_proxy_key_pool_shutdown = GLOBUS_FALSE;
+    globus_l_gsi_proxy_key_pool_pid = getpid();
+    globus_l_gsi_proxy_key_pool_size = 0;
+
+    tmpstring = globus_module_getenv("GLOBUS_GSI_PROXY_KEY_POOL_SIZE");
+    if (tmpstring != NULL && atoi(tmpstring) > 0)
+    {
+        globus_l_gsi_proxy_key_pool_size = atoi(tmpstring);
+    }
+}
+/* globus_i_gsi_proxy_key_pool_init() */
+
+/**
+ * Stop the key factory and free the pooled keys
+ */
+void
+globus_i_gsi_proxy_key_pool_destroy(void)
+{
+    globus_mutex_lock(&globus_l_gsi_proxy_key_pool_mutex);
+    globus_l_gsi_proxy_key_pool_shutdown = GLOBUS_TRUE;
+    if (globus_l_gsi_proxy_key_pool_pid != getpid())
+    {
+        globus_l_gsi_proxy_key_pool_running = GLOBUS_FALSE;
+    }
+    while (globus_l_gsi_proxy_key_pool_running)
+    {
+        globus_cond_broadcast(&globus_l_gsi_proxy_key_pool_cond);
+        globus_cond_wait(
+            &globus_l_gsi_proxy_key_pool_cond,
+            &globus_l_gsi_proxy_key_pool_mutex);
+    }
+    globus_l_gsi_proxy_key_pool_flush();
+    globus_mutex_unlock(&globus_l_gsi_proxy_key_pool_mutex);
+
+    globus_cond_destroy(&globus_l_gsi_proxy_key_pool_cond);
+    globus_mutex_destroy(&globus_l_gsi_proxy_key_pool_mutex);
+}
+/* globus_i_gsi_proxy_key_pool_destroy() */
+
+/**
+ * Get a key pair for a proxy request, from the pool if one is ready and
+ * otherwise by generating one.
+ */
+globus_result_t
+globus_i_gsi_proxy_key_pool_get(
+    globus_gsi_proxy_handle_attrs_t     attrs,
+    EVP_PKEY **                         key)
+{
+    EVP_PKEY *                          pooled_key = NULL;
+
+    GLOBUS_I_GSI_PROXY_DEBUG_ENTER;
+
+    globus_mutex_lock(&globus_l_gsi_proxy_key_pool_mutex);
+    if (globus_l_gsi_proxy_key_pool_size > 0)
+    {
+        pooled_key = globus_l_gsi_proxy_key_pool_take(
+            attrs->key_type, attrs->key_bits, attrs->init_prime);
+    }
+    globus_mutex_unlock(&globus_l_gsi_proxy_key_pool_mutex);
+
+    GLOBUS_I_GSI_PROXY_DEBUG_EXIT;
+
+    if (pooled_key != NULL)
+    {
+        GLOBUS_I_GSI_PROXY_DEBUG_PRINT(2, "Using a pooled key pair\n");
+        *key = pooled_key;
+        return GLOBUS_SUCCESS;
+    }
+
+    return globus_i_gsi_proxy_generate_key(
+        attrs->key_type,
+        attrs->key_bits,
+        attrs->init_prime,
+        attrs->key_gen_callback,
+        key);
+}
+/* globus_i_gsi_proxy_key_pool_get() */
+
+#endif /* GLOBUS_DONT_DOCUMENT_INTERNAL */
+
+/**
+ * @brief Set the key pool size
+ * @ingroup globus_gsi_proxy_operations
+ * @details
+ * Set the number of key pairs of each type and size that a background
+ * thread keeps ready for globus_gsi_proxy_create_req(), so that
+ * requests don't wait for key generation.  The pool is filled with keys
+ * of each type and size that globus_gsi_proxy_create_req() has been asked
+ * for.  Pooled keys are discarded in a child process after a fork.  A size
+ * of 0, the default unless the GLOBUS_GSI_PROXY_KEY_POOL_SIZE environment
+ * variable is set, disables the pool.  The pool needs a threaded build;
+ * without one, keys are always generated when requested.
+ *
+ * @param pool_size
+ *        The number of keys of each kind to keep ready
+ * @return
+ *        GLOBUS_SUCCESS unless an error occurred, in which case,
+ *        a globus error object ID is returned
+ */
+globus_result_t
+globus_gsi_proxy_key_pool_set_size(
+    int                                 pool_size)
+{
+    globus_l_gsi_proxy_key_kind_t *     kind;
+    EVP_PKEY **                         keys;
+    globus_result_t                     result = GLOBUS_SUCCESS;
+    int                                 i;
+
+    GLOBUS_I_GSI_PROXY_DEBUG_ENTER;
+
+    if (pool_size < 0)
+    {
+        GLOBUS_GSI_PROXY_ERROR_RESULT(
+            result,
+            GLOBUS_GSI_PROXY_INVALID_PARAMETER,
+            (_PCSL("Invalid key pool size passed to function: %s"),
+             __func__));
+        goto exit;
+    }
+
+    globus_mutex_lock(&globus_l_gsi_proxy_key_pool_mutex);
+    for (i = 0; i < globus_l_gsi_proxy_key_pool_num_kinds; i++)
+    {
+        kind = &globus_l_gsi_proxy_key_pool_kinds[i];
+        while (kind->num_keys > pool_size)
+        {
+            EVP_PKEY_free(kind->keys[--kind->num_keys]);
+        }
+        keys = realloc(kind->keys, (pool_size + 1) * sizeof(EVP_PKEY *));
+        if (keys != NULL)
+        {
+            kind->keys = keys;
+        }
+        else if (pool_size > globus_l_gsi_proxy_key_pool_size)
+        {
+            globus_mutex_unlock(&globus_l_gsi_proxy_key_pool_mutex);
+            result = globus_error_put(globus_error_wrap_errno_error(
+                GLOBUS_GSI_PROXY_MODULE,
+                errno,
+                GLOBUS_GSI_PROXY_ERROR_ERRNO,
+                __FILE__,
+                __func__,
+                __LINE__,
+                "Could not allocate enough memory: %d bytes",
+                (int) ((pool_size + 1) * sizeof(EVP_PKEY *))));
+            goto exit;
+        }
+    }
+    globus_l_gsi_proxy_key_pool_size = pool_size;
+    globus_cond_signal(&globus_l_gsi_proxy_key_pool_cond);
+    globus_mutex_unlock(&globus_l_gsi_proxy_key_pool_mutex);
+
+ exit:
+    GLOBUS_I_GSI_PROXY_DEBUG_EXIT;
+    return result;
+}
+/* globus_gsi_proxy_key_pool_set_size() */
@@ -235,6 +235,10 @@ typedef struct globus_l_gsi_proxy_handle_attrs_s
      * pair.
      */
     void (*key_gen_callback)(int, int, void *);
+    /**
+     * The type of key pair to generate, EVP_PKEY_RSA or EVP_PKEY_EC
+     */
+    int                                 key_type;
 
 } globus_i_gsi_proxy_handle_attrs_t;
 
@@ -290,6 +294,25 @@ globus_i_gsi_proxy_set_subject(
     X509 *                              issuer_cert,
     char *                              common_name);
 
+globus_result_t
+globus_i_gsi_proxy_generate_key(
+    int                                 key_type,
+    int                                 key_bits,
+    int                                 init_prime,
+    void                                (*key_gen_callback)(int, int, void *),
+    EVP_PKEY **                         key);
+
+void
+globus_i_gsi_proxy_key_pool_init(void);
+
+void
+globus_i_gsi_proxy_key_pool_destroy(void);
+
+globus_result_t
+globus_i_gsi_proxy_key_pool_get(
+    globus_gsi_proxy_handle_attrs_t     attrs,
+    EVP_PKEY **                         key);
+
 globus_result_t
 globus_i_gsi_proxy_openssl_error_result(
     int                                 error_type,
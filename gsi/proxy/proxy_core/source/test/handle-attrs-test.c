@@ -676,6 +676,63 @@ no_attrs:
     return ok;
 }
 
+static
+bool
+attrs_set_get_key_type_test(void)
+{
+    bool                                ok = true;
+    globus_result_t                     result = GLOBUS_SUCCESS;
+    globus_gsi_proxy_handle_attrs_t     attrs = NULL;
+    int                                 test_key_types[] =
+    {
+        EVP_PKEY_EC,
+        EVP_PKEY_RSA
+    };
+    size_t                              num_tests = ARRAY_SIZE(test_key_types);
+    int                                 key_type = 0;
+
+    result = globus_gsi_proxy_handle_attrs_init(&attrs);
+    if (result != GLOBUS_SUCCESS)
+    {
+        ok = false;
+        goto no_attrs;
+    }
+    result = globus_gsi_proxy_handle_attrs_get_key_type(attrs, &key_type);
+    if (result != GLOBUS_SUCCESS || key_type != EVP_PKEY_RSA)
+    {
+        ok = false;
+    }
+    for (size_t i = 0; i < num_tests; i++)
+    {
+        key_type = 0;
+        result = globus_gsi_proxy_handle_attrs_set_key_type(
+                attrs, test_key_types[i]);
+        if (result != GLOBUS_SUCCESS)
+        {
+            ok = false;
+        }
+        result = globus_gsi_proxy_handle_attrs_get_key_type(
+                attrs, &key_type);
+        if (result != GLOBUS_SUCCESS)
+        {
+            ok = false;
+        }
+        if (key_type != test_key_types[i])
+        {
+            ok = false;
+        }
+    }
+    result = globus_gsi_proxy_handle_attrs_set_key_type(attrs, -1);
+    if (result == GLOBUS_SUCCESS)
+    {
+        ok = false;
+    }
+
+    globus_gsi_proxy_handle_attrs_destroy(attrs);
+no_attrs:
+    return ok;
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -701,6 +758,7 @@ main(int argc, char *argv[])
         TEST_CASE_INITIALIZER(attrs_set_key_gen_callback_null_test),
         TEST_CASE_INITIALIZER(attrs_get_key_gen_callback_null_test),
         TEST_CASE_INITIALIZER(attrs_set_get_key_gen_callback_test),
+        TEST_CASE_INITIALIZER(attrs_set_get_key_type_test),
     };
     size_t                              num_test_cases = sizeof(test_cases)/sizeof(test_cases[0]);
     int                                 failed = 0;
@@ -0,0 +1,432 @@
+/*
+ * Copyright 1999-2016 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "globus_common.h"
+#include "globus_gsi_proxy.h"
+
+#include <stdbool.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+struct test_case
+{
+    const char                         *test_name;
+    bool                              (*test_func)(void);
+};
+
+#define TEST_CASE_INITIALIZER(c) { #c, c }
+
+/* Small RSA keys keep the factory quick */
+#define KEY_POOL_TEST_KEY_BITS 1024
+/* Attempts, 100 ms apart, to wait for the factory to fill the pool */
+#define KEY_POOL_TEST_TRIES 100
+
+/*
+ * Bumped by RSA key generation done for the request itself.  The key
+ * factory generates without the caller's callback, so a request that
+ * doesn't bump this got a pooled key.
+ */
+static int                              key_pool_test_generated;
+
+static
+void
+key_pool_test_key_gen_callback(
+    int                                 p,
+    int                                 n,
+    void *                              arg)
+{
+    if (p == 3)
+    {
+        key_pool_test_generated++;
+    }
+}
+
+static
+globus_gsi_proxy_handle_attrs_t
+key_pool_test_attrs(
+    int                                 key_type,
+    int                                 key_bits)
+{
+    globus_gsi_proxy_handle_attrs_t     attrs = NULL;
+    globus_result_t                     result = GLOBUS_SUCCESS;
+
+    result = globus_gsi_proxy_handle_attrs_init(&attrs);
+    if (result == GLOBUS_SUCCESS)
+    {
+        result = globus_gsi_proxy_handle_attrs_set_key_type(attrs, key_type);
+    }
+    if (result == GLOBUS_SUCCESS)
+    {
+        result = globus_gsi_proxy_handle_attrs_set_keybits(attrs, key_bits);
+    }
+    if (result == GLOBUS_SUCCESS)
+    {
+        result = globus_gsi_proxy_handle_attrs_set_key_gen_callback(
+            attrs, key_pool_test_key_gen_callback);
+    }
+    if (result != GLOBUS_SUCCESS)
+    {
+        globus_gsi_proxy_handle_attrs_destroy(attrs);
+        attrs = NULL;
+    }
+
+    return attrs;
+}
+/* key_pool_test_attrs() */
+
+/*
+ * Create a request with the given attributes.  Sets pooled to whether its
+ * key came from the pool, and key to the request's key if it isn't NULL.
+ */
+static
+bool
+key_pool_test_req(
+    globus_gsi_proxy_handle_attrs_t     attrs,
+    bool *                              pooled,
+    EVP_PKEY **                         key)
+{
+    globus_gsi_proxy_handle_t           handle = NULL;
+    globus_result_t                     result = GLOBUS_SUCCESS;
+    BIO *                               bio = NULL;
+    X509_REQ *                          req = NULL;
+    EVP_PKEY *                          req_key = NULL;
+    EVP_PKEY *                          private_key = NULL;
+    int                                 generated = key_pool_test_generated;
+    bool                                ok = false;
+
+    bio = BIO_new(BIO_s_mem());
+    if (bio == NULL)
+    {
+        goto out;
+    }
+    result = globus_gsi_proxy_handle_init(&handle, attrs);
+    if (result != GLOBUS_SUCCESS)
+    {
+        goto out;
+    }
+    result = globus_gsi_proxy_create_req(handle, bio);
+    if (result != GLOBUS_SUCCESS)
+    {
+        goto out;
+    }
+    *pooled = (key_pool_test_generated == generated);
+
+    /* the request carries the public half of the handle's key */
+    req = d2i_X509_REQ_bio(bio, NULL);
+    if (req == NULL || (req_key = X509_REQ_get_pubkey(req)) == NULL)
+    {
+        goto out;
+    }
+    result = globus_gsi_proxy_handle_get_private_key(handle, &private_key);
+    if (result != GLOBUS_SUCCESS || EVP_PKEY_cmp(req_key, private_key) != 1)
+    {
+        goto out;
+    }
+    if (key != NULL)
+    {
+        *key = req_key;
+        req_key = NULL;
+    }
+    ok = true;
+
+out:
+    EVP_PKEY_free(private_key);
+    EVP_PKEY_free(req_key);
+    X509_REQ_free(req);
+    globus_gsi_proxy_handle_destroy(handle);
+    BIO_free(bio);
+
+    return ok;
+}
+/* key_pool_test_req() */
+
+/*
+ * Make requests until one gets a pooled key.  Requests that miss generate
+ * their own, and give the factory time to catch up.
+ */
+static
+bool
+key_pool_test_wait_pooled(
+    globus_gsi_proxy_handle_attrs_t     attrs)
+{
+    bool                                pooled = false;
+
+    for (int i = 0; i < KEY_POOL_TEST_TRIES; i++)
+    {
+        if (!key_pool_test_req(attrs, &pooled, NULL))
+        {
+            return false;
+        }
+        if (pooled)
+        {
+            return true;
+        }
+        usleep(100000);
+    }
+
+    return false;
+}
+/* key_pool_test_wait_pooled() */
+
+/*
+ * The first request for a kind of key generates its own and starts the
+ * factory; later ones take keys from the pool
+ */
+static
+bool
+key_pool_take_test(void)
+{
+    globus_gsi_proxy_handle_attrs_t     attrs = NULL;
+    bool                                pooled = true;
+    bool                                ok = false;
+
+    attrs = key_pool_test_attrs(EVP_PKEY_RSA, KEY_POOL_TEST_KEY_BITS);
+    if (attrs == NULL
+        || globus_gsi_proxy_key_pool_set_size(2) != GLOBUS_SUCCESS)
+    {
+        goto out;
+    }
+    if (!key_pool_test_req(attrs, &pooled, NULL) || pooled)
+    {
+        goto out;
+    }
+    ok = key_pool_test_wait_pooled(attrs);
+
+out:
+    globus_gsi_proxy_handle_attrs_destroy(attrs);
+
+    return ok;
+}
+/* key_pool_take_test() */
+
+/*
+ * Once requests have taken every pooled key they generate their own,
+ * until the factory has refilled the pool
+ */
+static
+bool
+key_pool_refill_test(void)
+{
+    globus_gsi_proxy_handle_attrs_t     attrs = NULL;
+    bool                                pooled = true;
+    bool                                ok = false;
+
+    attrs = key_pool_test_attrs(EVP_PKEY_RSA, KEY_POOL_TEST_KEY_BITS);
+    if (attrs == NULL
+        || globus_gsi_proxy_key_pool_set_size(1) != GLOBUS_SUCCESS
+        || !key_pool_test_wait_pooled(attrs))
+    {
+        goto out;
+    }
+    for (int i = 0; pooled && i < KEY_POOL_TEST_TRIES; i++)
+    {
+        if (!key_pool_test_req(attrs, &pooled, NULL))
+        {
+            goto out;
+        }
+    }
+    if (pooled)
+    {
+        goto out;
+    }
+    ok = key_pool_test_wait_pooled(attrs);
+
+out:
+    globus_gsi_proxy_handle_attrs_destroy(attrs);
+
+    return ok;
+}
+/* key_pool_refill_test() */
+
+/*
+ * A child process must not use the keys its parent pooled before the
+ * fork, which the parent may hand out as well
+ */
+static
+bool
+key_pool_fork_test(void)
+{
+    globus_gsi_proxy_handle_attrs_t     attrs = NULL;
+    bool                                pooled = true;
+    pid_t                               pid;
+    int                                 status;
+    bool                                ok = false;
+
+    attrs = key_pool_test_attrs(EVP_PKEY_RSA, KEY_POOL_TEST_KEY_BITS);
+    if (attrs == NULL
+        || globus_gsi_proxy_key_pool_set_size(4) != GLOBUS_SUCCESS
+        || !key_pool_test_wait_pooled(attrs))
+    {
+        goto out;
+    }
+    /* let the factory top the pool back up */
+    sleep(1);
+
+    fflush(stdout);
+    pid = fork();
+    if (pid < 0)
+    {
+        goto out;
+    }
+    else if (pid == 0)
+    {
+        _exit(!key_pool_test_req(attrs, &pooled, NULL) || pooled);
+    }
+    if (waitpid(pid, &status, 0) != pid
+        || !WIFEXITED(status)
+        || WEXITSTATUS(status) != 0)
+    {
+        goto out;
+    }
+
+    /* the parent still has its pool */
+    ok = key_pool_test_req(attrs, &pooled, NULL) && pooled;
+
+out:
+    globus_gsi_proxy_handle_attrs_destroy(attrs);
+
+    return ok;
+}
+/* key_pool_fork_test() */
+
+/*
+ * Deactivating the module while the factory is generating a key waits for
+ * it to finish, and the pool starts over when the module is activated again
+ */
+static
+bool
+key_pool_destroy_test(void)
+{
+    globus_gsi_proxy_handle_attrs_t     attrs = NULL;
+    bool                                pooled = true;
+    bool                                ok = false;
+
+    /* larger keys so deactivation lands while one is being generated */
+    attrs = key_pool_test_attrs(EVP_PKEY_RSA, 4096);
+    if (attrs == NULL
+        || globus_gsi_proxy_key_pool_set_size(4) != GLOBUS_SUCCESS
+        || !key_pool_test_req(attrs, &pooled, NULL)
+        || pooled)
+    {
+        goto out;
+    }
+
+    /* a hung deactivation kills the test */
+    alarm(120);
+    globus_module_deactivate(GLOBUS_GSI_PROXY_MODULE);
+    alarm(0);
+    if (globus_module_activate(GLOBUS_GSI_PROXY_MODULE) != GLOBUS_SUCCESS)
+    {
+        goto out;
+    }
+    globus_gsi_proxy_handle_attrs_destroy(attrs);
+
+    attrs = key_pool_test_attrs(EVP_PKEY_RSA, KEY_POOL_TEST_KEY_BITS);
+    ok = attrs != NULL
+        && globus_gsi_proxy_key_pool_set_size(1) == GLOBUS_SUCCESS
+        && key_pool_test_req(attrs, &pooled, NULL)
+        && !pooled
+        && key_pool_test_wait_pooled(attrs);
+
+out:
+    globus_gsi_proxy_handle_attrs_destroy(attrs);
+
+    return ok;
+}
+/* key_pool_destroy_test() */
+
+/*
+ * EC requests carry a key on the curve the key bits select, whether it
+ * was generated for the request or taken from the pool
+ */
+static
+bool
+key_pool_ec_req_test(void)
+{
+    globus_gsi_proxy_handle_attrs_t     attrs = NULL;
+    EVP_PKEY *                          keys[2] = {NULL, NULL};
+    bool                                pooled;
+    bool                                ok = false;
+
+    attrs = key_pool_test_attrs(EVP_PKEY_EC, 384);
+    if (attrs == NULL
+        || globus_gsi_proxy_key_pool_set_size(2) != GLOBUS_SUCCESS)
+    {
+        goto out;
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        if (!key_pool_test_req(attrs, &pooled, &keys[i]))
+        {
+            goto out;
+        }
+        if (EVP_PKEY_base_id(keys[i]) != EVP_PKEY_EC
+            || EC_GROUP_get_curve_name(EC_KEY_get0_group(
+                    EVP_PKEY_get0_EC_KEY(keys[i]))) != NID_secp384r1)
+        {
+            goto out;
+        }
+        /* the factory makes EC keys in no time */
+        usleep(100000);
+    }
+    ok = EVP_PKEY_cmp(keys[0], keys[1]) != 1;
+
+out:
+    EVP_PKEY_free(keys[0]);
+    EVP_PKEY_free(keys[1]);
+    globus_gsi_proxy_handle_attrs_destroy(attrs);
+
+    return ok;
+}
+/* key_pool_ec_req_test() */
+
+int
+main(int argc, char *argv[])
+{
+    struct test_case                    test_cases[] =
+    {
+        TEST_CASE_INITIALIZER(key_pool_take_test),
+        TEST_CASE_INITIALIZER(key_pool_refill_test),
+        TEST_CASE_INITIALIZER(key_pool_fork_test),
+        TEST_CASE_INITIALIZER(key_pool_destroy_test),
+        TEST_CASE_INITIALIZER(key_pool_ec_req_test),
+    };
+    size_t                              num_test_cases = sizeof(test_cases)/sizeof(test_cases[0]);
+    int                                 failed = 0;
+
+    /* the key factory is a thread */
+    globus_thread_set_model("pthread");
+    globus_module_activate(GLOBUS_GSI_PROXY_MODULE);
+
+    printf("1..%zu\n", num_test_cases);
+
+    for (size_t i = 0; i < num_test_cases; i++)
+    {
+        if (test_cases[i].test_func())
+        {
+            printf("ok %zu - %s\n", i+1, test_cases[i].test_name);
+        }
+        else
+        {
+            failed++;
+            printf("not ok %zu - %s\n", i+1, test_cases[i].test_name);
+        }
+    }
+    globus_module_deactivate(GLOBUS_GSI_PROXY_MODULE);
+
+    return failed;
+}
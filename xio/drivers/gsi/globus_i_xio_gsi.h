@@ -210,6 +210,7 @@ typedef struct
     globus_bool_t                       frame_writes;
     size_t                              write_header_count;
     unsigned char *                     write_headers;
+    unsigned char *                     write_record;
     globus_size_t                       bytes_written;
     globus_xio_iovec_t                  read_iovec[2];
     unsigned char                       header[4];
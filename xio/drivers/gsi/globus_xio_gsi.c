@@ -21,6 +21,9 @@
 /* 32 MB */
 #define MAX_TOKEN_LENGTH 2<<24
 
+/* largest plaintext a single SSL/TLS record carries */
+#define GLOBUS_L_XIO_GSI_RECORD_SIZE 16384
+
 static gss_OID_desc gss_l_openssl_mech_oid =
         {9, "\x2b\x06\x01\x04\x01\x9b\x50\x01\x01"};
 static gss_OID_desc * gss_l_openssl_mech = &gss_l_openssl_mech_oid;
@@ -804,6 +807,11 @@ globus_l_xio_gsi_handle_destroy(
         free(handle->write_headers);
     }
 
+    if(handle->write_record != NULL)
+    {
+        free(handle->write_record);
+    }
+
     if(handle->unwrapped_buffer != NULL)
     {
         free(handle->unwrapped_buffer);
@@ -2734,64 +2742,107 @@ typedef struct gsi_l_write_bounce_s
     globus_xio_iovec_t                  iovec[1];
 } gsi_l_write_bounce_t;
 
+/*
+ * Wrap the next run of plaintext from the user iovecs into one token and
+ * advance the iovec position past it - internal only
+ *
+ * Data is wrapped in whole records straight out of the user's iovecs.
+ * When less than a record is left in the current iovec and more data
+ * follows, the remainder is gathered with the start of the following
+ * iovecs into the handle's record buffer, so small iovecs (e.g. mode E
+ * headers) don't each end up in a short record of their own.
+ */
 static
-void
-globus_l_xio_gsi_write_bounce(
-    void *                              user_arg)
+globus_result_t
+globus_l_xio_gsi_wrap_next(
+    globus_l_handle_t *                 handle,
+    const globus_xio_iovec_t *          iovec,
+    int                                 iovec_count,
+    int *                               iovec_index,
+    globus_size_t *                     iovec_offset,
+    gss_buffer_t                        wrapped_buffer)
 {
-    globus_l_handle_t *                 handle;
-    globus_result_t                     result = GLOBUS_SUCCESS;
-    globus_size_t                       wait_for;
+    globus_result_t                     result;
     gss_buffer_desc                     plaintext_buffer;
-    gss_buffer_desc                     wrapped_buffer;
     OM_uint32                           major_status;
     OM_uint32                           minor_status;
-    globus_size_t                       frame_length;
-    int                                 i;
-    int                                 j;
+    globus_size_t                       record_size;
+    globus_size_t                       remaining;
+    globus_size_t                       length;
     int                                 conf_state;
-    globus_size_t                       iovec_offset;
-    size_t                              write_iovec_count = 0;
-    /* for bounce */
-    void *                              driver_specific_handle;
-    int                                 iovec_count;
-    globus_xio_operation_t              op;
-    globus_xio_iovec_t *                iovec;
-    gsi_l_write_bounce_t *              bounce;
-
-    GlobusXIOName(globus_l_xio_gsi_write_bounce);
-    GlobusXIOGSIDebugEnter();
-
-    bounce = (gsi_l_write_bounce_t *) user_arg;
-    driver_specific_handle = bounce->driver_specific_handle;
-    op = bounce->op;
-    iovec_count = bounce->iovec_count;
-    iovec = bounce->iovec;
+    int                                 i;
+    GlobusXIOName(globus_l_xio_gsi_wrap_next);
+    GlobusXIOGSIDebugInternalEnter();
 
-    handle = (globus_l_handle_t *) driver_specific_handle;
+    record_size = handle->max_wrap_size < GLOBUS_L_XIO_GSI_RECORD_SIZE
+        ? handle->max_wrap_size : GLOBUS_L_XIO_GSI_RECORD_SIZE;
 
-    j = 0;
-    while(j < iovec_count && iovec[j].iov_len == 0)
+    while(iovec[*iovec_index].iov_len == *iovec_offset)
     {
-        j++;
+        (*iovec_index)++;
+        *iovec_offset = 0;
     }
 
-    /* wrap first iovec up to max wrap size */
-    /* need this info to detect if we are dealing with SSL based GSSAPI */
-    
-    plaintext_buffer.value = iovec[j].iov_base;
+    remaining = iovec[*iovec_index].iov_len - *iovec_offset;
+
+    /* check if anything follows the current iovec */
+    for(i = *iovec_index + 1; i < iovec_count && iovec[i].iov_len == 0; i++);
 
-    if(iovec[j].iov_len > handle->max_wrap_size)
+    if(remaining >= record_size || i == iovec_count)
     {
-        plaintext_buffer.length = handle->max_wrap_size;
-        iovec_offset = handle->max_wrap_size;
+        plaintext_buffer.value =
+            (globus_byte_t *) iovec[*iovec_index].iov_base + *iovec_offset;
+        plaintext_buffer.length = remaining;
+        if(remaining > handle->max_wrap_size)
+        {
+            plaintext_buffer.length = handle->max_wrap_size;
+        }
+        if(i < iovec_count)
+        {
+            /* leave a partial record for the gather below */
+            plaintext_buffer.length -= plaintext_buffer.length % record_size;
+        }
+        *iovec_offset += plaintext_buffer.length;
     }
     else
-    { 
-        plaintext_buffer.length = iovec[j].iov_len;
-        iovec_offset = 0;
+    {
+        if(handle->write_record == NULL)
+        {
+            handle->write_record = malloc(record_size);
+            if(handle->write_record == NULL)
+            {
+                result = GlobusXIOErrorMemory("handle->write_record");
+                goto error;
+            }
+        }
+
+        plaintext_buffer.value = handle->write_record;
+        plaintext_buffer.length = 0;
+
+        while(*iovec_index < iovec_count &&
+              plaintext_buffer.length < record_size)
+        {
+            length = iovec[*iovec_index].iov_len - *iovec_offset;
+            if(length > record_size - plaintext_buffer.length)
+            {
+                length = record_size - plaintext_buffer.length;
+            }
+
+            memcpy(handle->write_record + plaintext_buffer.length,
+                   (globus_byte_t *) iovec[*iovec_index].iov_base +
+                   *iovec_offset,
+                   length);
+            plaintext_buffer.length += length;
+            *iovec_offset += length;
+
+            if(*iovec_offset == iovec[*iovec_index].iov_len)
+            {
+                (*iovec_index)++;
+                *iovec_offset = 0;
+            }
+        }
     }
-    
+
     major_status = gss_wrap(&minor_status,
                             handle->context,
                             handle->attr->prot_level
@@ -2799,7 +2850,7 @@ globus_l_xio_gsi_write_bounce(
                             GSS_C_QOP_DEFAULT,
                             &plaintext_buffer,
                             &conf_state,
-                            &wrapped_buffer);
+                            wrapped_buffer);
 
     if(GSS_ERROR(major_status))
     {
@@ -2809,54 +2860,87 @@ globus_l_xio_gsi_write_bounce(
         goto error;
     }
 
-    /* figure out how many iovecs I need */
+    GlobusXIOGSIDebugInternalExit();
+    return GLOBUS_SUCCESS;
+
+ error:
+    GlobusXIOGSIDebugInternalExitWithError();
+    return result;
+}
+
+static
+void
+globus_l_xio_gsi_write_bounce(
+    void *                              user_arg)
+{
+    globus_l_handle_t *                 handle;
+    globus_result_t                     result = GLOBUS_SUCCESS;
+    globus_size_t                       wait_for;
+    gss_buffer_desc                     wrapped_buffer;
+    globus_size_t                       frame_length;
+    globus_size_t                       record_size;
+    int                                 i;
+    int                                 j;
+    int                                 iovec_index;
+    globus_size_t                       iovec_offset;
+    size_t                              write_iovec_count;
+    /* for bounce */
+    void *                              driver_specific_handle;
+    int                                 iovec_count;
+    globus_xio_operation_t              op;
+    globus_xio_iovec_t *                iovec;
+    gsi_l_write_bounce_t *              bounce;
+
+    GlobusXIOName(globus_l_xio_gsi_write_bounce);
+    GlobusXIOGSIDebugEnter();
+
+    bounce = (gsi_l_write_bounce_t *) user_arg;
+    driver_specific_handle = bounce->driver_specific_handle;
+    op = bounce->op;
+    iovec_count = bounce->iovec_count;
+    iovec = bounce->iovec;
+
+    handle = (globus_l_handle_t *) driver_specific_handle;
+
+    /* figure out how many tokens we can end up with: every token but the
+     * last carries at least a full record
+     */
+
+    record_size = handle->max_wrap_size < GLOBUS_L_XIO_GSI_RECORD_SIZE
+        ? handle->max_wrap_size : GLOBUS_L_XIO_GSI_RECORD_SIZE;
 
     for(i = 0;i < iovec_count; i++)
     {
-        write_iovec_count += iovec[i].iov_len / handle->max_wrap_size;
-        if(iovec[i].iov_len % handle->max_wrap_size != 0)
-        {
-            write_iovec_count++;
-        }
         handle->bytes_written += iovec[i].iov_len;
     }
 
-    /* frame any non SSL writes */
-    
-    if(globus_l_xio_gsi_is_ssl_token(wrapped_buffer.value, &frame_length)
-       != GLOBUS_TRUE)
-    {
-        if(write_iovec_count > handle->write_header_count)
-        {
-            void *                      tmp_ptr;
+    write_iovec_count = handle->bytes_written / record_size + 1;
 
-            tmp_ptr = realloc(handle->write_headers,
-                                     4 * write_iovec_count);
-
-            if(tmp_ptr == NULL)
-            {
-                result = GlobusXIOErrorMemory("handle->write_headers");
-                goto error;
-            }
+    /* room for a header in front of every token in case the mechanism
+     * doesn't produce SSL records
+     */
 
-            handle->write_headers = tmp_ptr;
+    if(write_iovec_count > handle->write_header_count)
+    {
+        void *                          tmp_ptr;
 
-            handle->write_header_count = write_iovec_count;
-        }   
+        tmp_ptr = realloc(handle->write_headers, 4 * write_iovec_count);
+        if(tmp_ptr == NULL)
+        {
+            result = GlobusXIOErrorMemory("handle->write_headers");
+            goto error;
+        }
 
-        handle->frame_writes = GLOBUS_TRUE;
-        
-        write_iovec_count *= 2;
+        handle->write_headers = tmp_ptr;
+        handle->write_header_count = write_iovec_count;
     }
 
-    /* allocate enough write iovecs */
-    
-    if(write_iovec_count > handle->write_iovec_count)
+    if(2 * write_iovec_count > handle->write_iovec_count)
     {
         void *                          tmp_ptr;
 
         tmp_ptr = realloc(handle->write_iovec,
-                          sizeof(globus_xio_iovec_t)*write_iovec_count);
+                          sizeof(globus_xio_iovec_t) * 2 * write_iovec_count);
         if(tmp_ptr == NULL)
         {
             result = GlobusXIOErrorMemory("handle->write_iovec");
@@ -2864,104 +2948,64 @@ globus_l_xio_gsi_write_bounce(
         }
 
         handle->write_iovec = tmp_ptr;
-        handle->write_iovec_count = write_iovec_count;
+        handle->write_iovec_count = 2 * write_iovec_count;
         memset(handle->write_iovec, 0,
-               sizeof(globus_xio_iovec_t)*write_iovec_count);
+               sizeof(globus_xio_iovec_t) * handle->write_iovec_count);
     }
 
-    /* if we didn't wrap complete iovec start with first iovec found, otherwise
-     * start with next.
+    /* wrap the plaintext, one token per write iovec (preceded by a header
+     * for framed writes)
      */
-    
-    if(iovec_offset)
-    {
-        i = j;
-    }
-    else
-    {
-        i = j + 1;
-    }
 
-    /* initialize 1st write iovec (&header) */
-    
-    if(handle->frame_writes == GLOBUS_TRUE)
-    {
-        handle->write_iovec[j].iov_base = handle->write_headers;
-        handle->write_iovec[j].iov_len = 4;
-        GlobusLXIOGSICreateHeader(handle->write_iovec[j],
-                                  wrapped_buffer.length);
-        j++;
-        wait_for = 4;
-    }
-    else
-    {
-        wait_for = 0;    
-    }
-    
-    handle->write_iovec[j].iov_base = wrapped_buffer.value;
-    handle->write_iovec[j].iov_len = wrapped_buffer.length;
-    wait_for +=  wrapped_buffer.length;
-    j++;
+    iovec_index = 0;
+    iovec_offset = 0;
+    wait_for = 0;
+    j = 0;
 
-    /* wrap and initialize the rest */
-    
-    for(;i < iovec_count;i++)
+    do
     {
-        if(iovec[i].iov_len == 0)
+        result = globus_l_xio_gsi_wrap_next(handle, iovec, iovec_count,
+                                            &iovec_index, &iovec_offset,
+                                            &wrapped_buffer);
+        if(result != GLOBUS_SUCCESS)
         {
-            continue;
+            goto free_wrapped;
         }
-        
-        do
-        { 
-            plaintext_buffer.value = (globus_byte_t *) 
-                iovec[i].iov_base + iovec_offset;
-            
-            if(iovec[i].iov_len - iovec_offset > handle->max_wrap_size)
-            {
-                plaintext_buffer.length = handle->max_wrap_size;
-                iovec_offset += handle->max_wrap_size;
-            }
-            else
-            { 
-                plaintext_buffer.length = iovec[i].iov_len - iovec_offset;
-                iovec_offset = 0;
-            }
-            
-            major_status = gss_wrap(&minor_status,
-                                    handle->context,
-                                    handle->attr->prot_level
-                                    == GLOBUS_XIO_GSI_PROTECTION_LEVEL_PRIVACY,
-                                    GSS_C_QOP_DEFAULT,
-                                    &plaintext_buffer,
-                                    &conf_state,
-                                    &wrapped_buffer);
-            
-            if(GSS_ERROR(major_status))
-            {
-                result = GlobusXIOErrorWrapGSSFailed("gss_wrap",
-                                                     major_status,
-                                                     minor_status);
-                goto free_wrapped;
-            }
 
-            if(handle->frame_writes == GLOBUS_TRUE)
-            { 
-                handle->write_iovec[j].iov_base = handle->write_headers + 2*j;
-                handle->write_iovec[j].iov_len = 4;
-                GlobusLXIOGSICreateHeader(handle->write_iovec[j],
-                                          wrapped_buffer.length);
-                j++;
-                wait_for += 4;
-            }
+        /* frame any non SSL writes */
 
-            handle->write_iovec[j].iov_base = wrapped_buffer.value;
-            handle->write_iovec[j].iov_len = wrapped_buffer.length;
+        if(j == 0 &&
+           globus_l_xio_gsi_is_ssl_token(wrapped_buffer.value, &frame_length)
+           != GLOBUS_TRUE)
+        {
+            handle->frame_writes = GLOBUS_TRUE;
+        }
+
+        if(handle->frame_writes == GLOBUS_TRUE)
+        {
+            handle->write_iovec[j].iov_base = handle->write_headers + 2*j;
+            handle->write_iovec[j].iov_len = 4;
+            GlobusLXIOGSICreateHeader(handle->write_iovec[j],
+                                      wrapped_buffer.length);
             j++;
-            wait_for += wrapped_buffer.length;
+            wait_for += 4;
+        }
+
+        handle->write_iovec[j].iov_base = wrapped_buffer.value;
+        handle->write_iovec[j].iov_len = wrapped_buffer.length;
+        j++;
+        wait_for += wrapped_buffer.length;
+
+        while(iovec_index < iovec_count &&
+              iovec[iovec_index].iov_len == iovec_offset)
+        {
+            iovec_index++;
+            iovec_offset = 0;
         }
-        while(iovec_offset);
     }
+    while(iovec_index < iovec_count);
+
+    write_iovec_count = j;
 
     GlobusXIOGSIDebugPrintf(
         GLOBUS_XIO_GSI_DEBUG_INTERNAL_TRACE,
@@ -2976,7 +3020,7 @@ globus_l_xio_gsi_write_bounce(
                              globus_l_xio_gsi_write_cb, handle);
     if(result != GLOBUS_SUCCESS)
     {
-        goto error;
+        goto free_wrapped;
     }
     globus_free(bounce);
     GlobusXIOGSIDebugExit();
@@ -898,6 +898,7 @@ globus_l_xio_file_cntl(
     globus_off_t                        in_offset;
     int                                 whence;
     globus_bool_t *                     out_bool;
+    globus_size_t *                     out_size;
     GlobusXIOName(globus_l_xio_file_cntl);
     
     GlobusXIOFileDebugEnter();
@@ -935,6 +936,12 @@ globus_l_xio_file_cntl(
         out_bool = va_arg(ap, globus_bool_t *);
         *out_bool = handle->use_blocking_io;
         break;
+
+      /* globus_size_t *                uring_ops_out */
+      case GLOBUS_XIO_FILE_GET_URING_OPS:
+        out_size = va_arg(ap, globus_size_t *);
+        *out_size = globus_xio_system_file_get_uring_ops(handle->system);
+        break;
         
       default:
         result = GlobusXIOErrorInvalidCommand(cmd);
@@ -292,7 +292,20 @@ typedef enum
      */
     /* globus_off_t *                   in_out_offset,
      * globus_xio_file_whence_t         whence */
-    GLOBUS_XIO_FILE_SEEK
+    GLOBUS_XIO_FILE_SEEK,
+
+    /** GlobusVarArgEnum(handle)
+     * Get the number of reads and writes on the handle that were completed
+     * by io_uring.
+     * @ingroup globus_xio_file_driver_cntls
+     *
+     * @param uring_ops_out
+     *      The count will be stored here.  It stays 0 when the handle uses
+     *      the poll data path, including when io_uring was requested with
+     *      GLOBUS_XIO_SYSTEM_FILE_IO=uring but isn't available.
+     */
+    /* globus_size_t *                  uring_ops_out */
+    GLOBUS_XIO_FILE_GET_URING_OPS
 } globus_xio_file_attr_cmd_t;
 
 /**
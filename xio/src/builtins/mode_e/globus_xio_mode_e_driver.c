@@ -49,6 +49,7 @@ enum globus_l_xio_error_levels
 #define GLOBUS_XIO_MODE_E_HEADER_COUNT 8
 #define GLOBUS_XIO_MODE_E_MAX_OFFSET_SIZE 8
 #define GLOBUS_XIO_MODE_E_OFFSET_HT_SIZE 8
+#define GLOBUS_XIO_MODE_E_READ_BUFFER_SIZE 65536
 
 #define GLOBUS_XIO_MODE_E_DATA_DESCRIPTOR_CLOSE 0x04
 #define GLOBUS_XIO_MODE_E_DATA_DESCRIPTOR_EOD 0x08
@@ -69,6 +70,17 @@ typedef enum globus_i_xio_mode_e_state_s
 
 } globus_i_xio_mode_e_state_t;
 
+/*
+ * what a receiving connection found already sitting in its read buffer
+ * when it went to register its next read
+ */
+typedef enum globus_l_xio_mode_e_buffered_s
+{
+    GLOBUS_L_XIO_MODE_E_BUFFERED_NONE,
+    GLOBUS_L_XIO_MODE_E_BUFFERED_HEADER,
+    GLOBUS_L_XIO_MODE_E_BUFFERED_DATA
+} globus_l_xio_mode_e_buffered_t;
+
 typedef globus_result_t
 (*globus_xio_mode_e_handle_cntl_callback_t)(
     globus_xio_handle_t                 xio_handle);
@@ -152,12 +164,25 @@ typedef struct
     globus_xio_handle_t                 xio_handle;
     globus_l_xio_mode_e_handle_t *      mode_e_handle;
     globus_i_xio_mode_e_requestor_t *   requestor;
-    int                                 iovec_index;
-    globus_size_t                       iovec_index_len;
     globus_off_t                        outstanding_data_len;    
     globus_off_t                        outstanding_data_offset;    
     globus_bool_t                       eod;
     globus_bool_t                       close;
+    /* 
+     * receiving side only. reads from the connection land in buffer and 
+     * headers and small blocks are taken out of it between buffer_start 
+     * and buffer_end. a read that takes the rest of a block straight into
+     * the user's iovec gets the buffer tacked on the end (in iovec) to 
+     * catch whatever follows the block
+     */
+    globus_byte_t *                     buffer;
+    globus_size_t                       buffer_start;
+    globus_size_t                       buffer_end;
+    globus_xio_iovec_t *                iovec;
+    int                                 iovec_size;
+    globus_size_t                       iovec_len;
+    globus_l_xio_mode_e_buffered_t      buffered;
+    globus_size_t                       buffered_nbytes;
 } globus_l_xio_mode_e_connection_handle_t; 
 
 static
@@ -205,6 +230,21 @@ globus_i_xio_mode_e_register_read(
     globus_l_xio_mode_e_connection_handle_t *
                                         connection_handle);
 
+static
+globus_l_xio_mode_e_buffered_t
+globus_l_xio_mode_e_data_ready(
+    globus_l_xio_mode_e_connection_handle_t *
+                                        connection_handle,
+    globus_result_t                     result,
+    globus_size_t                       nbytes);
+
+static
+void
+globus_l_xio_mode_e_read_buffered(
+    globus_l_xio_mode_e_connection_handle_t *
+                                        connection_handle,
+    globus_l_xio_mode_e_buffered_t      buffered);
+
 static
 globus_result_t
 globus_i_xio_mode_e_register_write(
@@ -330,27 +370,16 @@ globus_l_xio_mode_e_hashtable_offset_hash(
     void *                              offsetp,
     int                                 limit)
 {
-    unsigned long                       h = 0;
-    unsigned long                       g;
-    char *                              key;
-    int                                 i;
-    globus_size_t                       size;
+    globus_off_t                        offset;
     GlobusXIOName(globus_l_xio_mode_e_hashtable_offset_hash);
-    
+
     GlobusXIOModeEDebugEnter();
-    key = (char *) offsetp;
-    size = sizeof(globus_off_t);
-    for (i = 0; i < size; i++)
-    {
-        h = (h << 4) + *key++;
-        if ((g = (h & 0xF0UL)))
-        {
-            h ^= g >> 24;
-            h ^= g;
-        }   
-    }   
+    offset = *(globus_off_t *) offsetp;
+    /* offsets are usually multiples of the block size, so fold in the
+     * high bits rather than letting the low zero bits pick the slot */
+    offset ^= offset >> 17;
     GlobusXIOModeEDebugExit();
-    return h % limit;
+    return (int) ((unsigned long) offset % limit);
 }
 
 
@@ -359,14 +388,13 @@ globus_l_xio_mode_e_hashtable_offset_keyeq(
     void *                              offsetp1,
     void *                              offsetp2)
 {
-    globus_size_t                       size;
     int                                 rc = 0;
     GlobusXIOName(globus_l_xio_mode_e_hashtable_offset_keyeq);
 
     GlobusXIOModeEDebugEnter();
-    size = sizeof(globus_off_t);
     if(offsetp1 == offsetp2 ||
-        (offsetp1 && offsetp2 && strncmp(offsetp1, offsetp2, size) == 0))
+        (offsetp1 && offsetp2 &&
+            *(globus_off_t *) offsetp1 == *(globus_off_t *) offsetp2))
     {
         rc = 1;
     }
@@ -385,6 +413,14 @@ globus_l_xio_mode_e_handle_destroy(
     GlobusXIOName(globus_l_xio_mode_e_handle_destroy);
 
     GlobusXIOModeEDebugEnter();
+    /* 
+     * closing the server cancels the accept that is always outstanding on 
+     * it and that callback still needs the mutex 
+     */
+    if (handle->server)
+    {
+        globus_xio_server_close(handle->server);
+    }
     if (!handle->attr->stack)
     {
         stack = GLOBUS_TRUE;
@@ -406,10 +442,6 @@ globus_l_xio_mode_e_handle_destroy(
     globus_list_free(handle->eod_list);
     globus_list_free(handle->close_list);
     globus_mutex_destroy(&handle->mutex);
-    if (handle->server)
-    {
-        globus_xio_server_close(handle->server);
-    }
     if (stack)
     {
         globus_xio_stack_destroy(handle->stack);
@@ -1138,7 +1170,24 @@ globus_l_xio_mode_e_server_connection_handle_init(
     connection_handle->eod = GLOBUS_FALSE;
     connection_handle->close = GLOBUS_FALSE;
     connection_handle->outstanding_data_len = 0;
-    connection_handle->iovec_index = -1;
+    GlobusXIOModeEDebugExit();
+}
+
+
+static
+void
+globus_l_xio_mode_e_server_connection_handle_destroy(
+    globus_l_xio_mode_e_connection_handle_t *
+                                        connection_handle)
+{
+    GlobusXIOName(globus_l_xio_mode_e_server_connection_handle_destroy);
+    GlobusXIOModeEDebugEnter();
+    if (connection_handle->iovec)
+    {
+        globus_free(connection_handle->iovec);
+    }
+    globus_free(connection_handle->buffer);
+    globus_free(connection_handle);
     GlobusXIOModeEDebugExit();
 }
 
@@ -1267,7 +1316,8 @@ globus_l_xio_mode_e_process_eod(
                 handle);
         globus_list_remove(&handle->connection_list, 
             globus_list_search(handle->connection_list, connection_handle));
-        globus_free(connection_handle);
+        globus_l_xio_mode_e_server_connection_handle_destroy(
+                                                        connection_handle);
     }
     else
     {
@@ -1288,50 +1338,55 @@ globus_l_xio_mode_e_process_eod(
 }
 
 
+/*
+ * handles the header at the front of the connection's buffer, whether it
+ * just came in or was already there. returns what the connection found
+ * buffered if it went on to the next read (the caller must then go on 
+ * with that, see read_buffered)
+ */
 static
-void
-globus_l_xio_mode_e_read_header_cb(
-    globus_xio_handle_t                 xio_handle,
-    globus_result_t                     result,
-    globus_byte_t *                     buffer,
-    globus_size_t                       len,
-    globus_size_t                       nbytes,
-    globus_xio_data_descriptor_t        data_desc,
-    void *                              user_arg)
+globus_l_xio_mode_e_buffered_t
+globus_l_xio_mode_e_header_ready(
+    globus_l_xio_mode_e_connection_handle_t *
+                                        connection_handle,
+    globus_result_t                     result)
 {
     globus_l_xio_mode_e_handle_t *      handle;
     globus_l_xio_mode_e_header_t *      header;
-    globus_l_xio_mode_e_connection_handle_t *
-                                        connection_handle;
     globus_i_xio_mode_e_requestor_t *   requestor = GLOBUS_NULL;
     globus_xio_operation_t              op;
     globus_fifo_t                       requestor_q;
+    globus_l_xio_mode_e_buffered_t      buffered = 
+                                        GLOBUS_L_XIO_MODE_E_BUFFERED_NONE;
     globus_bool_t                       eof;
     globus_bool_t                       finish = GLOBUS_FALSE;
     globus_bool_t                       finish_close = GLOBUS_FALSE;
     globus_result_t                     res;
     globus_off_t                        offset;
-    GlobusXIOName(globus_l_xio_mode_e_read_header_cb);
+    GlobusXIOName(globus_l_xio_mode_e_header_ready);
 
     GlobusXIOModeEDebugEnter();
     globus_fifo_init(&requestor_q);
-    connection_handle = (globus_l_xio_mode_e_connection_handle_t *) user_arg;
     handle = connection_handle->mode_e_handle;
     offset = connection_handle->outstanding_data_offset;
     globus_mutex_lock(&handle->mutex);
     if (result == GLOBUS_SUCCESS)
     {   
-        header = (globus_l_xio_mode_e_header_t *) buffer;
+        header = (globus_l_xio_mode_e_header_t *) 
+                (connection_handle->buffer + connection_handle->buffer_start);
+        connection_handle->buffer_start += 
+                                    sizeof(globus_l_xio_mode_e_header_t);
         result = globus_l_xio_mode_e_process_header(header, connection_handle);
         if (result != GLOBUS_SUCCESS)
         {
             goto error;
         }
-        globus_memory_push_node(&handle->header_memory, (void*)buffer);
         if (connection_handle->outstanding_data_len > 0)
         {
             requestor = globus_l_xio_mode_e_process_outstanding_data(
                                                         connection_handle);
+            buffered = connection_handle->buffered;
+            connection_handle->buffered = GLOBUS_L_XIO_MODE_E_BUFFERED_NONE;
         }
         /*
          * If EOF is set in header, data len will be zero. If EOD alone is
@@ -1385,6 +1440,8 @@ globus_l_xio_mode_e_read_header_cb(
             {
                 goto error;
             }
+            buffered = connection_handle->buffered;
+            connection_handle->buffered = GLOBUS_L_XIO_MODE_E_BUFFERED_NONE;
         }
     }
     else if(globus_error_match(
@@ -1415,7 +1472,8 @@ globus_l_xio_mode_e_read_header_cb(
                 op = handle->outstanding_op;
             }
         }
-        globus_free(connection_handle);
+        globus_l_xio_mode_e_server_connection_handle_destroy(
+                                                        connection_handle);
     }
     else
     {
@@ -1471,7 +1529,7 @@ globus_l_xio_mode_e_read_header_cb(
         globus_xio_driver_finished_close(op, result);
     }
     GlobusXIOModeEDebugExit();
-    return;
+    return buffered;
 
 error:
     globus_l_xio_mode_e_save_error(handle, result);
@@ -1485,8 +1543,70 @@ error:
         globus_memory_push_node(&handle->requestor_memory, (void*)requestor);
         globus_xio_driver_finished_read(op, result, 0);
     }
+    globus_fifo_destroy(&requestor_q);
     GlobusXIOModeEDebugExitWithError();
-    return;
+    return GLOBUS_L_XIO_MODE_E_BUFFERED_NONE;
+}
+
+
+/*
+ * keeps a connection going for as long as its next header or data is
+ * already in its buffer. this is a loop rather than having header_ready
+ * and data_ready call each other so a buffer full of small blocks does
+ * not build up the stack
+ */
+static
+void
+globus_l_xio_mode_e_read_buffered(
+    globus_l_xio_mode_e_connection_handle_t *
+                                        connection_handle,
+    globus_l_xio_mode_e_buffered_t      buffered)
+{
+    GlobusXIOName(globus_l_xio_mode_e_read_buffered);
+
+    GlobusXIOModeEDebugEnter();
+    while (buffered != GLOBUS_L_XIO_MODE_E_BUFFERED_NONE)
+    {
+        if (buffered == GLOBUS_L_XIO_MODE_E_BUFFERED_HEADER)
+        {
+            buffered = globus_l_xio_mode_e_header_ready(
+                                        connection_handle, GLOBUS_SUCCESS);
+        }
+        else
+        {
+            buffered = globus_l_xio_mode_e_data_ready(
+                                    connection_handle, 
+                                    GLOBUS_SUCCESS, 
+                                    connection_handle->buffered_nbytes);
+        }
+    }
+    GlobusXIOModeEDebugExit();
+}
+
+
+static
+void
+globus_l_xio_mode_e_read_header_cb(
+    globus_xio_handle_t                 xio_handle,
+    globus_result_t                     result,
+    globus_byte_t *                     buffer,
+    globus_size_t                       len,
+    globus_size_t                       nbytes,
+    globus_xio_data_descriptor_t        data_desc,
+    void *                              user_arg)
+{
+    globus_l_xio_mode_e_connection_handle_t *
+                                        connection_handle;
+    globus_l_xio_mode_e_buffered_t      buffered;
+    GlobusXIOName(globus_l_xio_mode_e_read_header_cb);
+
+    GlobusXIOModeEDebugEnter();
+    connection_handle = (globus_l_xio_mode_e_connection_handle_t *) user_arg;
+    /* nothing else touches the buffer while this read is outstanding */
+    connection_handle->buffer_end += nbytes;
+    buffered = globus_l_xio_mode_e_header_ready(connection_handle, result);
+    globus_l_xio_mode_e_read_buffered(connection_handle, buffered);
+    GlobusXIOModeEDebugExit();
 }
 
 
@@ -1658,8 +1778,21 @@ globus_i_xio_mode_e_server_open_cb(
                                         connection_handle;
 
         connection_handle = (globus_l_xio_mode_e_connection_handle_t *)
-                                globus_malloc(sizeof(
+                                globus_calloc(1, sizeof(
                                     globus_l_xio_mode_e_connection_handle_t));
+        if (!connection_handle)
+        {
+            res = GlobusXIOErrorMemory("connection_handle");
+            goto error;
+        }
+        connection_handle->buffer = (globus_byte_t *)
+                        globus_malloc(GLOBUS_XIO_MODE_E_READ_BUFFER_SIZE);
+        if (!connection_handle->buffer)
+        {
+            globus_free(connection_handle);
+            res = GlobusXIOErrorMemory("buffer");
+            goto error;
+        }
         connection_handle->mode_e_handle = handle;
         connection_handle->xio_handle = xio_handle;
         globus_list_insert(&handle->connection_list, connection_handle);
@@ -1835,7 +1968,7 @@ globus_l_xio_mode_e_server_open(
     handle->outstanding_op = op;
     if (handle->attr->offset_reads) 
     {
-        result = globus_hashtable_init(
+        result = globus_hashtable_init_resizable(
                     &handle->offset_ht, 
                     GLOBUS_XIO_MODE_E_OFFSET_HT_SIZE,
                     globus_l_xio_mode_e_hashtable_offset_hash,
@@ -1969,28 +2102,48 @@ error_server_open:
 }
 
 
+/* 
+ * called locked. if a whole header is already in the buffer nothing is
+ * registered, connection_handle->buffered says so instead
+ */
 static
 globus_result_t
 globus_i_xio_mode_e_register_read_header(
     globus_l_xio_mode_e_connection_handle_t *
                                         connection_handle)
 {
-    globus_l_xio_mode_e_header_t *      header;
     globus_size_t                       header_size;
+    globus_size_t                       buffered;
     globus_result_t                     result;
     GlobusXIOName(globus_i_xio_mode_e_register_read_header);
 
     GlobusXIOModeEDebugEnter();
     globus_l_xio_mode_e_server_connection_handle_init(connection_handle);
-    header = (globus_l_xio_mode_e_header_t *)
-                    globus_memory_pop_node(
-                        &connection_handle->mode_e_handle->header_memory);
     header_size = sizeof(globus_l_xio_mode_e_header_t);
+    buffered = connection_handle->buffer_end - connection_handle->buffer_start;
+    if (buffered >= header_size)
+    {
+        connection_handle->buffered = GLOBUS_L_XIO_MODE_E_BUFFERED_HEADER;
+        GlobusXIOModeEDebugExit();
+        return GLOBUS_SUCCESS;
+    }
+    if (connection_handle->buffer_start > 0)
+    {
+        memmove(connection_handle->buffer, 
+                connection_handle->buffer + connection_handle->buffer_start,
+                buffered);
+        connection_handle->buffer_start = 0;
+        connection_handle->buffer_end = buffered;
+    }
+    /* 
+     * wait only for the rest of the header but take whatever else has 
+     * arrived; if the blocks are small that can be a good many of them
+     */
     result = globus_xio_register_read(
         connection_handle->xio_handle,
-        (globus_byte_t*)header,
-        header_size,
-        header_size,
+        connection_handle->buffer + connection_handle->buffer_end,
+        GLOBUS_XIO_MODE_E_READ_BUFFER_SIZE - connection_handle->buffer_end,
+        header_size - buffered,
         NULL,               /* data_desc */
         globus_l_xio_mode_e_read_header_cb,
         connection_handle);
@@ -1999,41 +2152,36 @@ globus_i_xio_mode_e_register_read_header(
 }
 
 
+/*
+ * handles nbytes of the block having gone to the requestor's iovec, 
+ * whether read or copied from the buffer. returns what the connection 
+ * found buffered if it went on to the next read
+ */
 static
-void
-globus_l_xio_mode_e_read_cb(
-    globus_xio_handle_t                 xio_handle,
+globus_l_xio_mode_e_buffered_t
+globus_l_xio_mode_e_data_ready(
+    globus_l_xio_mode_e_connection_handle_t *
+                                        connection_handle,
     globus_result_t                     result,
-    globus_xio_iovec_t *                iovec,
-    int                                 iovec_count,
-    globus_size_t                       nbytes,
-    globus_xio_data_descriptor_t        data_desc,
-    void *                              user_arg)
+    globus_size_t                       nbytes)
 {
     globus_result_t                     res = result;
-    globus_l_xio_mode_e_connection_handle_t *      
-                                        connection_handle;
     globus_l_xio_mode_e_handle_t *      handle;
     globus_bool_t                       eof;
     globus_xio_operation_t              op;
     globus_off_t                        offset;
     globus_fifo_t                       requestor_q;
     globus_i_xio_mode_e_requestor_t *   requestor = GLOBUS_NULL;
-    GlobusXIOName(globus_l_xio_mode_e_read_cb);
+    globus_l_xio_mode_e_buffered_t      buffered = 
+                                        GLOBUS_L_XIO_MODE_E_BUFFERED_NONE;
+    GlobusXIOName(globus_l_xio_mode_e_data_ready);
 
     GlobusXIOModeEDebugEnter();
-    connection_handle = (globus_l_xio_mode_e_connection_handle_t *) user_arg;
     op = connection_handle->requestor->op;
     globus_xio_operation_disable_cancel(op);
     handle = connection_handle->mode_e_handle; 
     globus_fifo_init(&requestor_q);
     offset = connection_handle->outstanding_data_offset;
-    if (connection_handle->iovec_index != -1)
-    {
-        iovec[connection_handle->iovec_index].iov_len = 
-                                        connection_handle->iovec_index_len;
-        connection_handle->iovec_index = -1;
-    }
     globus_mutex_lock(&handle->mutex); 
     globus_memory_push_node(
         &handle->requestor_memory, (void*)connection_handle->requestor);
@@ -2045,6 +2193,8 @@ globus_l_xio_mode_e_read_cb(
             connection_handle->outstanding_data_offset += nbytes;
             requestor = globus_l_xio_mode_e_process_outstanding_data(
                                                         connection_handle);
+            buffered = connection_handle->buffered;
+            connection_handle->buffered = GLOBUS_L_XIO_MODE_E_BUFFERED_NONE;
         }
         else if (connection_handle->eod) 
         {
@@ -2068,6 +2218,8 @@ globus_l_xio_mode_e_read_cb(
             {
                 goto error;
             }
+            buffered = connection_handle->buffered;
+            connection_handle->buffered = GLOBUS_L_XIO_MODE_E_BUFFERED_NONE;
         }
     }
     else
@@ -2105,7 +2257,7 @@ globus_l_xio_mode_e_read_cb(
     }
     globus_fifo_destroy(&requestor_q);
     GlobusXIOModeEDebugExit();
-    return;
+    return buffered;
 
 error:
     globus_l_xio_mode_e_save_error(handle, result);
@@ -2119,12 +2271,48 @@ error:
         globus_memory_push_node(&handle->requestor_memory, (void*)requestor);
         globus_xio_driver_finished_read(op, result, 0);
     }
+    globus_fifo_destroy(&requestor_q);
     GlobusXIOModeEDebugExitWithError();
-    return;
+    return GLOBUS_L_XIO_MODE_E_BUFFERED_NONE;
 }
 
 
-/* called locked */
+static
+void
+globus_l_xio_mode_e_read_cb(
+    globus_xio_handle_t                 xio_handle,
+    globus_result_t                     result,
+    globus_xio_iovec_t *                iovec,
+    int                                 iovec_count,
+    globus_size_t                       nbytes,
+    globus_xio_data_descriptor_t        data_desc,
+    void *                              user_arg)
+{
+    globus_l_xio_mode_e_connection_handle_t *      
+                                        connection_handle;
+    globus_l_xio_mode_e_buffered_t      buffered;
+    GlobusXIOName(globus_l_xio_mode_e_read_cb);
+
+    GlobusXIOModeEDebugEnter();
+    connection_handle = (globus_l_xio_mode_e_connection_handle_t *) user_arg;
+    /* anything past the requestor's iovec went into the buffer */
+    if (nbytes > connection_handle->iovec_len)
+    {
+        connection_handle->buffer_end += nbytes - connection_handle->iovec_len;
+        nbytes = connection_handle->iovec_len;
+    }
+    buffered = globus_l_xio_mode_e_data_ready(
+                                        connection_handle, result, nbytes);
+    globus_l_xio_mode_e_read_buffered(connection_handle, buffered);
+    GlobusXIOModeEDebugExit();
+}
+
+
+/* 
+ * called locked. if some of the block is already in the buffer, it is 
+ * copied to the requestor and nothing is registered; 
+ * connection_handle->buffered says so instead
+ */
 static
 globus_result_t
 globus_i_xio_mode_e_register_read(
@@ -2132,43 +2320,102 @@ globus_i_xio_mode_e_register_read(
                                         connection_handle)
 {
     globus_size_t                       iovec_len;    
+    globus_size_t                       buffered;
     globus_result_t                     result;
     globus_xio_iovec_t *                iovec;
     int                                 iovec_count;
+    int                                 i;
     GlobusXIOName(globus_i_xio_mode_e_register_read);
 
     GlobusXIOModeEDebugEnter();
     iovec = connection_handle->requestor->iovec;
     iovec_count = connection_handle->requestor->iovec_count;
     GlobusXIOUtilIovTotalLength(iovec_len, iovec, iovec_count);
+    if (connection_handle->outstanding_data_len < iovec_len) 
+    {
+        iovec_len = connection_handle->outstanding_data_len;
+    }
+    buffered = connection_handle->buffer_end - connection_handle->buffer_start;
+    if (buffered > 0)
+    {
+        globus_byte_t *                 buffer;
+        globus_size_t                   size;
+
+        if (buffered < iovec_len)
+        {
+            iovec_len = buffered;
+        }
+        buffer = connection_handle->buffer + connection_handle->buffer_start;
+        for (i = 0, size = iovec_len; size > 0; i++)
+        {
+            globus_size_t               len = iovec[i].iov_len;
+
+            if (len > size)
+            {
+                len = size;
+            }
+            memcpy(iovec[i].iov_base, buffer, len);
+            buffer += len;
+            size -= len;
+        }
+        connection_handle->buffer_start += iovec_len;
+        if (connection_handle->buffer_start == connection_handle->buffer_end)
+        {
+            connection_handle->buffer_start = 0;
+            connection_handle->buffer_end = 0;
+        }
+        connection_handle->buffered = GLOBUS_L_XIO_MODE_E_BUFFERED_DATA;
+        connection_handle->buffered_nbytes = iovec_len;
+        GlobusXIOModeEDebugExit();
+        return GLOBUS_SUCCESS;
+    }
+    connection_handle->buffer_start = 0;
+    connection_handle->buffer_end = 0;
+    connection_handle->iovec_len = iovec_len;
     /* 
-     * Upto iovec_len amount of data would be read from the channel. If 
-     * iovec_len > outstanding_data_len, this read might possibly get the next
-     * header that has arrived on this channel. So I modify iovec (and later
-     * restore in the read_cb) such that the amount of data read would be
-     * min(outstanding_data_len, iovec_len)
+     * If the iovec takes the rest of the block, read it with the buffer on 
+     * the end so the next header (and maybe more) comes in with the same 
+     * read. The iovec is cut down to outstanding_data_len if it is longer
+     * so nothing past the block lands in it. Otherwise read into the iovec
+     * as it is; it can't take anything past the block.
      */
-    if (connection_handle->outstanding_data_len < iovec_len) 
+    if (iovec_len == connection_handle->outstanding_data_len)
     {
         globus_size_t                   size = 0;
-        int                             i;
-        iovec_len = connection_handle->outstanding_data_len;
-        for (i = 0; i < iovec_count; i++)
+
+        if (connection_handle->iovec_size < iovec_count + 1)
         {
-            size += iovec[i].iov_len;
-            if (size > iovec_len)
+            globus_xio_iovec_t *        tmp_iovec;
+
+            tmp_iovec = (globus_xio_iovec_t *) globus_realloc(
+                connection_handle->iovec, 
+                (iovec_count + 1) * sizeof(globus_xio_iovec_t));
+            if (!tmp_iovec)
             {
-                connection_handle->iovec_index = i;
-                iovec_count = i + 1;
-                connection_handle->iovec_index_len = iovec[i].iov_len;
-                iovec[i].iov_len -= (size - iovec_len);
-                break;
+                result = GlobusXIOErrorMemory("iovec");
+                goto error;
             }
+            connection_handle->iovec = tmp_iovec;
+            connection_handle->iovec_size = iovec_count + 1;
+        }
+        for (i = 0; size < iovec_len; i++)
+        {
+            connection_handle->iovec[i] = iovec[i];
+            size += iovec[i].iov_len;
+        }
+        if (size > iovec_len)
+        {
+            connection_handle->iovec[i - 1].iov_len -= size - iovec_len;
         }
+        connection_handle->iovec[i].iov_base = connection_handle->buffer;
+        connection_handle->iovec[i].iov_len = 
+                                        GLOBUS_XIO_MODE_E_READ_BUFFER_SIZE;
+        iovec = connection_handle->iovec;
+        iovec_count = i + 1;
     }
     result = globus_xio_register_readv(
                 connection_handle->xio_handle,
-                (globus_xio_iovec_t*)iovec, 
+                iovec, 
                 iovec_count,
                 iovec_len,
                 NULL,
@@ -2176,6 +2423,10 @@ globus_i_xio_mode_e_register_read(
                 connection_handle);
     GlobusXIOModeEDebugExit();
     return result;
+
+error:
+    GlobusXIOModeEDebugExitWithError();
+    return result;
 }                        
 
 
@@ -2183,7 +2434,8 @@ globus_i_xio_mode_e_register_read(
 static
 void
 globus_l_xio_mode_e_reset_connections(
-    globus_l_xio_mode_e_handle_t *      handle)
+    globus_l_xio_mode_e_handle_t *      handle,
+    globus_fifo_t *                     buffered_q)
 {
     globus_l_xio_mode_e_connection_handle_t *
                                         connection_handle;
@@ -2201,6 +2453,12 @@ globus_l_xio_mode_e_reset_connections(
         {
             goto error;
         }
+        /* the next transfer may have started coming in with the last one */
+        if (connection_handle->buffered != GLOBUS_L_XIO_MODE_E_BUFFERED_NONE)
+        {
+            connection_handle->buffered = GLOBUS_L_XIO_MODE_E_BUFFERED_NONE;
+            globus_fifo_enqueue(buffered_q, connection_handle);
+        }
     }
     handle->state = GLOBUS_XIO_MODE_E_OPEN;
     GlobusXIOModeEDebugExit();
@@ -2224,6 +2482,11 @@ globus_l_xio_mode_e_read(
     globus_l_xio_mode_e_handle_t *      handle;
     globus_i_xio_mode_e_requestor_t *   requestor;
     globus_l_xio_mode_e_attr_t *        dd = GLOBUS_NULL;
+    globus_l_xio_mode_e_connection_handle_t *
+                                        connection_handle = GLOBUS_NULL;
+    globus_l_xio_mode_e_buffered_t      buffered = 
+                                        GLOBUS_L_XIO_MODE_E_BUFFERED_NONE;
+    globus_fifo_t                       buffered_q;
     globus_result_t                     result;
     globus_size_t                       wait_for;
     globus_bool_t                       finish = GLOBUS_FALSE;
@@ -2267,6 +2530,7 @@ globus_l_xio_mode_e_read(
         result = GlobusXIOErrorCanceled();
         goto error_cancel_enable;
     }
+    globus_fifo_init(&buffered_q);
     globus_mutex_lock(&handle->mutex);
     if (globus_xio_operation_is_canceled(op))
     {
@@ -2295,7 +2559,7 @@ globus_l_xio_mode_e_read(
             }
             else
             {
-                globus_l_xio_mode_e_reset_connections(handle);
+                globus_l_xio_mode_e_reset_connections(handle, &buffered_q);
                 /* 
                  * connection_q will be empty at this point. I let this
                  * fall through to enqueue the request in the io_q
@@ -2309,8 +2573,6 @@ globus_l_xio_mode_e_read(
             }
             else
             {
-                globus_l_xio_mode_e_connection_handle_t *      
-                                                connection_handle;
                 if (wait_for == 0)
                 {
                     globus_memory_push_node(
@@ -2349,6 +2611,9 @@ globus_l_xio_mode_e_read(
                     connection_handle->requestor = requestor;
                     requestor->xio_handle = connection_handle->xio_handle;
                     globus_i_xio_mode_e_register_read(connection_handle);
+                    buffered = connection_handle->buffered;
+                    connection_handle->buffered = 
+                                        GLOBUS_L_XIO_MODE_E_BUFFERED_NONE;
                 }
             }
             break;
@@ -2365,6 +2630,16 @@ globus_l_xio_mode_e_read(
         globus_xio_operation_disable_cancel(op);
         globus_xio_driver_finished_read(op, result, 0);
     }
+    /* finishing from here is fine, xio knows it is still in the register */
+    globus_l_xio_mode_e_read_buffered(connection_handle, buffered);
+    while (!globus_fifo_empty(&buffered_q))
+    {
+        connection_handle = (globus_l_xio_mode_e_connection_handle_t *)
+                                        globus_fifo_dequeue(&buffered_q);
+        globus_l_xio_mode_e_read_buffered(
+                    connection_handle, GLOBUS_L_XIO_MODE_E_BUFFERED_HEADER);
+    }
+    globus_fifo_destroy(&buffered_q);
     GlobusXIOModeEDebugExit();
     return GLOBUS_SUCCESS;
 
@@ -2372,6 +2647,7 @@ error_invalid_state:
 error_offset:
 error_operation_canceled:
     globus_mutex_unlock(&handle->mutex);
+    globus_fifo_destroy(&buffered_q);
     globus_xio_operation_disable_cancel(op);
 error_cancel_enable:
     globus_memory_push_node(&handle->requestor_memory, (void*)requestor);
@@ -3188,7 +3464,8 @@ globus_l_xio_mode_e_close_connections(
                 connection_handle->mode_e_handle);
             globus_list_insert(
                         &handle->close_list, connection_handle->xio_handle);
-            globus_free(connection_handle);
+            globus_l_xio_mode_e_server_connection_handle_destroy(
+                                                        connection_handle);
         }
         else
         {
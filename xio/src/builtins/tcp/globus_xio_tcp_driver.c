@@ -116,6 +116,12 @@ typedef struct
     
     /* data descriptor */
     int                                 send_flags;
+    globus_xio_system_file_t            sendfile_fd;
+    globus_off_t                        sendfile_offset;
+    globus_off_t                        sendfile_length;
+    globus_xio_system_file_t            splice_fd;
+    globus_off_t                        splice_offset;
+    globus_off_t                        splice_length;
     
     globus_bool_t                       global;
     globus_bool_t                       use_blocking_io;
@@ -149,6 +155,12 @@ static globus_l_attr_t                  globus_l_xio_tcp_attr_default =
     0,                                  /* connector_max_port */
     
     0,                                  /* send_flags */
+    GLOBUS_XIO_SYSTEM_INVALID_FILE,     /* sendfile_fd */
+    0,                                  /* sendfile_offset */
+    0,                                  /* sendfile_length */
+    GLOBUS_XIO_SYSTEM_INVALID_FILE,     /* splice_fd */
+    0,                                  /* splice_offset */
+    0,                                  /* splice_length */
     GLOBUS_FALSE,                       /* global */
     GLOBUS_FALSE                        /* use_blocking_io */
 };
@@ -755,6 +767,24 @@ globus_l_xio_tcp_attr_cntl(
         *out_int = attr->send_flags;
         break;
 
+      /* globus_xio_system_file_t       fd */
+      /* globus_off_t                   offset */
+      /* globus_off_t                   length */
+      case GLOBUS_XIO_TCP_SET_SENDFILE:
+        attr->sendfile_fd = va_arg(ap, globus_xio_system_file_t);
+        attr->sendfile_offset = va_arg(ap, globus_off_t);
+        attr->sendfile_length = va_arg(ap, globus_off_t);
+        break;
+
+      /* globus_xio_system_file_t       fd */
+      /* globus_off_t                   offset */
+      /* globus_off_t                   length */
+      case GLOBUS_XIO_TCP_SET_SPLICE:
+        attr->splice_fd = va_arg(ap, globus_xio_system_file_t);
+        attr->splice_offset = va_arg(ap, globus_off_t);
+        attr->splice_length = va_arg(ap, globus_off_t);
+        break;
+
       /* globus_bool_t                  use_blocking_io */
       case GLOBUS_XIO_TCP_SET_BLOCKING_IO:
         attr->use_blocking_io = va_arg(ap, globus_bool_t);
@@ -2466,7 +2496,9 @@ globus_l_xio_tcp_read(
     globus_xio_operation_t              op)
 {
     globus_l_handle_t *                 handle;
+    globus_l_attr_t *                   attr;
     globus_size_t                       nbytes;
+    globus_size_t                       wait_for;
     globus_result_t                     result = GLOBUS_SUCCESS;
     GlobusXIOName(globus_l_xio_tcp_read);
     
@@ -2496,8 +2528,35 @@ globus_l_xio_tcp_read(
         goto error_already;
     }
     
+    attr = (globus_l_attr_t *)
+        globus_xio_operation_get_data_descriptor(op, GLOBUS_FALSE);
+    
+    if(attr && attr->splice_length > 0)
+    {
+        /* the data goes to the file range; the iovec is left alone */
+        wait_for = globus_xio_operation_get_wait_for(op);
+        if(wait_for > attr->splice_length)
+        {
+            wait_for = attr->splice_length;
+        }
+        result = globus_xio_system_socket_register_splice(
+            op,
+            handle->system,
+            attr->splice_fd,
+            attr->splice_offset,
+            attr->splice_length,
+            wait_for,
+            globus_l_xio_tcp_system_read_cb,
+            handle);
+        if(result != GLOBUS_SUCCESS)
+        {
+            result = GlobusXIOErrorWrapFailed(
+                "globus_xio_system_socket_register_splice", result);
+            goto error_register;
+        }
+    }
     /* if buflen and waitfor are both 0, we behave like register select */
-    if((globus_xio_operation_get_wait_for(op) == 0 &&
+    else if((globus_xio_operation_get_wait_for(op) == 0 &&
         (iovec_count > 1 || iovec[0].iov_len > 0)) ||
         (handle->use_blocking_io &&
         globus_xio_driver_operation_is_blocking(op)))
@@ -2657,8 +2716,28 @@ globus_l_xio_tcp_write(
     attr = (globus_l_attr_t *)
         globus_xio_operation_get_data_descriptor(op, GLOBUS_FALSE);
     
+    if(attr && attr->sendfile_length > 0)
+    {
+        /* the iovec is a header for the file range; both are sent in full */
+        result = globus_xio_system_socket_register_sendfile(
+            op,
+            handle->system,
+            iovec,
+            iovec_count,
+            attr->sendfile_fd,
+            attr->sendfile_offset,
+            attr->sendfile_length,
+            globus_l_xio_tcp_system_write_cb,
+            handle);
+        if(result != GLOBUS_SUCCESS)
+        {
+            result = GlobusXIOErrorWrapFailed(
+                "globus_xio_system_socket_register_sendfile", result);
+            goto error_register;
+        }
+    }
     /* if buflen and waitfor are both 0, we behave like register select */
-    if((globus_xio_operation_get_wait_for(op) == 0 &&
+    else if((globus_xio_operation_get_wait_for(op) == 0 &&
         (iovec_count > 1 || iovec[0].iov_len > 0)) ||
         (handle->use_blocking_io &&
         globus_xio_driver_operation_is_blocking(op)))
@@ -760,7 +760,54 @@ typedef enum
      *      The flag will be set here.  GLOBUS_TRUE for enabled.
      */
     /* globus_bool_t *                  use_blocking_io_out */
-    GLOBUS_XIO_TCP_GET_BLOCKING_IO
+    GLOBUS_XIO_TCP_GET_BLOCKING_IO,
+    
+    /**GlobusVarArgEnum(dd)
+     * Send part of a file after the write buffer.
+     * @ingroup globus_xio_tcp_driver_cntls
+     * Used only for data descriptors to write calls.  After the buffer
+     * passed to the write, length bytes of fd starting at offset are sent
+     * with sendfile() where available, so the file data is never copied
+     * into user space.  The buffer (typically a protocol header) may be
+     * empty.  The write completes once all of it and the file range have
+     * been sent, and the nbytes reported includes the file range.  Only
+     * meaningful when no driver above tcp transforms the data.
+     *
+     * @param fd
+     *      An open file descriptor to send from.  Not closed by the driver.
+     * @param offset
+     *      The file offset to start from.  The fd's own position is not
+     *      used or changed.
+     * @param length
+     *      The number of bytes to send from the file.
+     */
+    /* globus_xio_system_file_t         fd,
+     * globus_off_t                     offset,
+     * globus_off_t                     length */
+    GLOBUS_XIO_TCP_SET_SENDFILE,
+    
+    /**GlobusVarArgEnum(dd)
+     * Receive into part of a file instead of the read buffer.
+     * @ingroup globus_xio_tcp_driver_cntls
+     * Used only for data descriptors to read calls.  Up to length bytes
+     * are moved from the socket into fd starting at offset, with splice()
+     * where available, and the read buffer is not touched.  The read
+     * completes once its waitforbytes have been moved (at most length),
+     * and the nbytes reported is the number moved.  Only meaningful when
+     * no driver above tcp transforms the data.
+     *
+     * @param fd
+     *      An open file descriptor to write to.  Not closed by the driver.
+     * @param offset
+     *      The file offset to start at.  The fd's own position is not
+     *      used or changed.
+     * @param length
+     *      The most bytes to move into the file.
+     */
+    /* globus_xio_system_file_t         fd,
+     * globus_off_t                     offset,
+     * globus_off_t                     length */
+    GLOBUS_XIO_TCP_SET_SPLICE
     
 } globus_xio_tcp_cmd_t;
 
@@ -14,9 +14,18 @@
  * limitations under the License.
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+/* splice() */
+#define _GNU_SOURCE
+#endif
+
 #include "globus_i_xio_system_common.h"
 #include <unistd.h>
 #include <limits.h>
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
+#include <fcntl.h>
 
 #ifndef WIN32
 #define GlobusLXIOSystemWouldBlock(err)                                     \
@@ -824,6 +833,207 @@ error_errno:
 
 #ifndef WIN32
 
+/*
+ * send up to length bytes of file_fd starting at offset.  without
+ * sendfile() the data is bounced through a small buffer; only what the
+ * socket took is counted, the rest is read again next time
+ */
+globus_result_t
+globus_i_xio_system_try_sendfile(
+    globus_xio_system_socket_t          fd,
+    globus_xio_system_file_t            file_fd,
+    globus_off_t                        offset,
+    globus_off_t                        length,
+    globus_size_t *                     nbytes)
+{
+    globus_ssize_t                      rc;
+    globus_result_t                     result;
+    globus_size_t                       count;
+    GlobusXIOName(globus_i_xio_system_try_sendfile);
+
+    GlobusXIOSystemDebugEnterFD(fd);
+
+    count = length > SSIZE_MAX ? SSIZE_MAX : (globus_size_t) length;
+
+#ifdef HAVE_SENDFILE
+    {
+        off_t                           file_offset = offset;
+
+        do
+        {
+            rc = sendfile(fd, file_fd, &file_offset, count);
+        } while(rc < 0 && errno == EINTR);
+    }
+#else
+    {
+        char                            buf[GLOBUS_I_XIO_SYSTEM_SENDFILE_BOUNCE];
+
+        if(count > sizeof(buf))
+        {
+            count = sizeof(buf);
+        }
+
+        do
+        {
+            rc = pread(file_fd, buf, count, offset);
+        } while(rc < 0 && errno == EINTR);
+
+        if(rc > 0)
+        {
+            count = rc;
+            do
+            {
+                rc = send(fd, buf, count, 0);
+            } while(rc < 0 && errno == EINTR);
+        }
+    }
+#endif
+
+    if(rc < 0)
+    {
+        if(GlobusLXIOSystemWouldBlock(errno))
+        {
+            rc = 0;
+        }
+        else
+        {
+            result = GlobusXIOErrorSystemError("sendfile", errno);
+            goto error_errno;
+        }
+    }
+    else if(rc == 0 && count > 0)
+    {
+        /* file is shorter than the range we were asked to send */
+        result = GlobusXIOErrorSystemError("sendfile", EIO);
+        goto error_errno;
+    }
+
+    *nbytes = rc;
+
+    GlobusXIOSystemDebugPrintf(
+        GLOBUS_I_XIO_SYSTEM_DEBUG_DATA,
+        ("[%s] Sent %d bytes from file\n", _xio_name, (int) rc));
+
+    GlobusXIOSystemDebugExitFD(fd);
+    return GLOBUS_SUCCESS;
+
+error_errno:
+    *nbytes = 0;
+    GlobusXIOSystemDebugExitWithErrorFD(fd);
+    return result;
+}
+
+/*
+ * move up to length bytes waiting on the socket into file_fd at offset.
+ * with splice() the data goes through pipe_fds without entering user space;
+ * otherwise it is bounced through a small buffer.  everything taken from
+ * the socket is written out before returning
+ */
+globus_result_t
+globus_i_xio_system_try_splice(
+    globus_xio_system_socket_t          fd,
+    int *                               pipe_fds,
+    globus_xio_system_file_t            file_fd,
+    globus_off_t                        offset,
+    globus_off_t                        length,
+    globus_size_t *                     nbytes)
+{
+    globus_ssize_t                      rc;
+    globus_ssize_t                      written;
+    globus_result_t                     result;
+    globus_size_t                       count;
+    globus_size_t                       done = 0;
+#ifndef HAVE_SPLICE
+    char                                buf[GLOBUS_I_XIO_SYSTEM_SENDFILE_BOUNCE];
+#endif
+    GlobusXIOName(globus_i_xio_system_try_splice);
+
+    GlobusXIOSystemDebugEnterFD(fd);
+
+    while(done < length)
+    {
+        count = length - done > SSIZE_MAX ? SSIZE_MAX : length - done;
+#ifdef HAVE_SPLICE
+        if(count > GLOBUS_I_XIO_SYSTEM_SPLICE_PIPE_SIZE)
+        {
+            count = GLOBUS_I_XIO_SYSTEM_SPLICE_PIPE_SIZE;
+        }
+        do
+        {
+            rc = splice(fd, NULL, pipe_fds[1], NULL, count,
+                SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        } while(rc < 0 && errno == EINTR);
+#else
+        if(count > sizeof(buf))
+        {
+            count = sizeof(buf);
+        }
+        do
+        {
+            rc = recv(fd, buf, count, 0);
+        } while(rc < 0 && errno == EINTR);
+#endif
+
+        if(rc < 0)
+        {
+            if(GlobusLXIOSystemWouldBlock(errno))
+            {
+                break;
+            }
+            result = GlobusXIOErrorSystemError("splice", errno);
+            goto error_errno;
+        }
+        else if(rc == 0)
+        {
+            /* report what we have; eof shows up on the next try */
+            if(done == 0)
+            {
+                result = GlobusXIOErrorEOF();
+                goto error_errno;
+            }
+            break;
+        }
+
+        count = rc;
+        while(count > 0)
+        {
+#ifdef HAVE_SPLICE
+            loff_t                      file_offset = offset + done;
+
+            written = splice(pipe_fds[0], NULL, file_fd, &file_offset, count,
+                SPLICE_F_MOVE);
+#else
+            written = pwrite(file_fd, buf + (rc - count), count, offset + done);
+#endif
+            if(written < 0)
+            {
+                if(errno == EINTR)
+                {
+                    continue;
+                }
+                result = GlobusXIOErrorSystemError("splice", errno);
+                goto error_errno;
+            }
+            count -= written;
+            done += written;
+        }
+    }
+
+    *nbytes = done;
+
+    GlobusXIOSystemDebugPrintf(
+        GLOBUS_I_XIO_SYSTEM_DEBUG_DATA,
+        ("[%s] Moved %d bytes to file\n", _xio_name, (int) done));
+
+    GlobusXIOSystemDebugExitFD(fd);
+    return GLOBUS_SUCCESS;
+
+error_errno:
+    *nbytes = done;
+    GlobusXIOSystemDebugExitWithErrorFD(fd);
+    return result;
+}
+
 globus_result_t
 globus_i_xio_system_file_try_read(
     globus_xio_system_file_t            handle,
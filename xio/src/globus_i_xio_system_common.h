@@ -249,6 +249,12 @@ typedef struct
             int                         iovc;
             globus_sockaddr_t *         addr;
             int                         flags;
+
+            /* file range sent after iov, see register_sendfile, or
+             * received into, see register_splice */
+            globus_xio_system_file_t    file_fd;
+            globus_off_t                file_offset;
+            globus_off_t                file_length;
         } data;
     } sop;
 } globus_i_xio_system_op_info_t;
@@ -329,6 +335,29 @@ globus_i_xio_system_try_sendmsg(
     int                                 flags,
     globus_size_t *                     nbytes);
 
+/* bytes bounced per call when the platform has no sendfile() */
+#define GLOBUS_I_XIO_SYSTEM_SENDFILE_BOUNCE 32768
+
+globus_result_t
+globus_i_xio_system_try_sendfile(
+    globus_xio_system_socket_t          fd,
+    globus_xio_system_file_t            file_fd,
+    globus_off_t                        offset,
+    globus_off_t                        length,
+    globus_size_t *                     nbytes);
+
+/* pipe capacity asked for on the pipe used by splice() */
+#define GLOBUS_I_XIO_SYSTEM_SPLICE_PIPE_SIZE (1024 * 1024)
+
+globus_result_t
+globus_i_xio_system_try_splice(
+    globus_xio_system_socket_t          fd,
+    int *                               pipe_fds,
+    globus_xio_system_file_t            file_fd,
+    globus_off_t                        offset,
+    globus_off_t                        length,
+    globus_size_t *                     nbytes);
+
 globus_result_t
 globus_i_xio_system_file_try_read(
     globus_xio_system_file_t            handle,
@@ -361,6 +390,32 @@ globus_i_xio_system_socket_try_write(
     globus_sockaddr_t *                 to,
     globus_size_t *                     nbytes);
 
+/*
+ * io_uring file data path (globus_i_xio_system_uring.c).  res is the number
+ * of bytes transferred or -errno.  callbacks are made from the reaper thread.
+ */
+typedef void
+(*globus_i_xio_system_uring_callback_t)(
+    globus_ssize_t                      res,
+    void *                              user_arg);
+
+globus_bool_t
+globus_i_xio_system_uring_activate(
+    globus_i_xio_system_uring_callback_t callback);
+
+void
+globus_i_xio_system_uring_deactivate(void);
+
+/* waits for room on the ring; returns 0 or -errno */
+int
+globus_i_xio_system_uring_submit(
+    int                                 fd,
+    globus_bool_t                       is_write,
+    const globus_xio_iovec_t *          iov,
+    int                                 iovc,
+    globus_off_t                        offset,
+    void *                              user_arg);
+
 int
 globus_i_xio_system_common_activate(void);
 
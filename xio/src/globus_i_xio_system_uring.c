@@ -0,0 +1,582 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * io_uring submission path for file data operations.
+ *
+ * Requests are queued on a single ring shared by all handles.  Whoever
+ * queues a request while nobody else is inside io_uring_enter() becomes the
+ * submitter and pushes everything queued up to that point (including what
+ * other threads queue while it is in the kernel) in as few calls as
+ * possible.  A reaper thread waits for completions and hands each one to the
+ * callback given to globus_i_xio_system_uring_activate().
+ *
+ * This talks to the kernel directly (no liburing); the ring is only used if
+ * the headers were present at build time, the kernel accepts
+ * io_uring_setup() and we have threads to reap with.
+ */
+
+#include "globus_i_xio_system_common.h"
+
+#if defined(HAVE_LINUX_IO_URING_H) && !defined(TARGET_ARCH_WIN32)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define GLOBUS_L_XIO_SYSTEM_HAVE_URING 1
+#endif
+#endif
+
+#ifdef GLOBUS_L_XIO_SYSTEM_HAVE_URING
+
+#define GLOBUS_L_XIO_SYSTEM_URING_DEFAULT_ENTRIES 256
+
+typedef struct
+{
+    int                                 ring_fd;
+    globus_mutex_t                      lock;
+    globus_cond_t                       cond;
+
+    void *                              sq_ring;
+    globus_size_t                       sq_ring_size;
+    unsigned *                          sq_tail;
+    unsigned *                          sq_mask;
+    unsigned *                          sq_array;
+    unsigned                            sq_entries;
+    struct io_uring_sqe *               sqes;
+    globus_size_t                       sqes_size;
+
+    void *                              cq_ring;
+    globus_size_t                       cq_ring_size;
+    unsigned *                          cq_head;
+    unsigned *                          cq_tail;
+    unsigned *                          cq_mask;
+    struct io_uring_cqe *               cqes;
+
+    /* queued on the ring, but not yet passed to io_uring_enter() */
+    unsigned                            pending;
+    /* submitted requests we have not reaped yet */
+    unsigned                            inflight;
+    /* threads waiting in submit for the ring to drain */
+    int                                 waiters;
+    globus_bool_t                       submitting;
+    globus_bool_t                       shutdown;
+    globus_bool_t                       reaper_running;
+    globus_thread_t                     reaper;
+    globus_i_xio_system_uring_callback_t callback;
+} globus_l_xio_system_uring_t;
+
+static globus_l_xio_system_uring_t      globus_l_xio_system_uring;
+static globus_bool_t                    globus_l_xio_system_uring_active;
+
+static
+int
+globus_l_xio_system_uring_enter(
+    int                                 ring_fd,
+    unsigned                            to_submit,
+    unsigned                            min_complete,
+    unsigned                            flags)
+{
+    return syscall(
+        __NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+/*
+ * push everything queued to the kernel.  called locked, drops the lock
+ * while in the kernel so other threads can keep queueing behind us
+ */
+static
+void
+globus_l_xio_system_uring_flush(
+    globus_l_xio_system_uring_t *       ring)
+{
+    unsigned                            count;
+    int                                 rc;
+
+    if(ring->submitting)
+    {
+        /* the thread that is submitting will pick ours up */
+        return;
+    }
+
+    ring->submitting = GLOBUS_TRUE;
+    while(ring->pending > 0)
+    {
+        count = ring->pending;
+        ring->pending = 0;
+
+        globus_mutex_unlock(&ring->lock);
+        do
+        {
+            rc = globus_l_xio_system_uring_enter(ring->ring_fd, count, 0, 0);
+        } while(rc < 0 && errno == EINTR);
+        globus_mutex_lock(&ring->lock);
+
+        if(rc < 0 || (unsigned) rc < count)
+        {
+            /* the kernel is backed up (EAGAIN/EBUSY); whatever it didn't
+             * take stays on the ring and goes with the next flush, which
+             * the reaper does after every batch of completions
+             */
+            ring->pending += rc < 0 ? count : count - rc;
+            break;
+        }
+    }
+    ring->submitting = GLOBUS_FALSE;
+}
+
+/* called locked */
+static
+int
+globus_l_xio_system_uring_queue(
+    globus_l_xio_system_uring_t *       ring,
+    int                                 opcode,
+    int                                 fd,
+    const globus_xio_iovec_t *          iov,
+    int                                 iovc,
+    globus_off_t                        offset,
+    void *                              user_arg)
+{
+    struct io_uring_sqe *               sqe;
+    unsigned                            tail;
+    unsigned                            index;
+
+    /* the completion ring holds twice the submission ring, so keeping
+     * inflight below sq_entries means it can never overflow
+     */
+    if(ring->pending >= ring->sq_entries || ring->inflight >= ring->sq_entries)
+    {
+        return -EBUSY;
+    }
+
+    /* we are the only producer, the kernel only reads the tail */
+    tail = *ring->sq_tail;
+    index = tail & *ring->sq_mask;
+    sqe = &ring->sqes[index];
+
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->off = offset;
+    sqe->addr = (unsigned long) iov;
+    sqe->len = iovc;
+    sqe->user_data = (unsigned long) user_arg;
+
+    ring->sq_array[index] = index;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    ring->pending++;
+    if(user_arg)
+    {
+        ring->inflight++;
+    }
+
+    return 0;
+}
+
+static
+void *
+globus_l_xio_system_uring_reaper(
+    void *                              user_arg)
+{
+    globus_l_xio_system_uring_t *       ring;
+    struct io_uring_cqe *               cqe;
+    unsigned                            head;
+    void *                              cqe_arg;
+    globus_ssize_t                      cqe_res;
+    globus_bool_t                       stopping = GLOBUS_FALSE;
+    int                                 rc;
+    GlobusXIOName(globus_l_xio_system_uring_reaper);
+
+    GlobusXIOSystemDebugEnter();
+
+    ring = (globus_l_xio_system_uring_t *) user_arg;
+
+    while(!stopping || ring->inflight > 0)
+    {
+        rc = globus_l_xio_system_uring_enter(
+            ring->ring_fd, 0, 1, IORING_ENTER_GETEVENTS);
+        if(rc < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+        {
+            GlobusXIOSystemDebugPrintf(
+                GLOBUS_I_XIO_SYSTEM_DEBUG_INFO,
+                ("[%s] io_uring_enter failed, errno=%d\n", _xio_name, errno));
+            break;
+        }
+
+        head = *ring->cq_head;
+        while(head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE))
+        {
+            cqe = &ring->cqes[head & *ring->cq_mask];
+            cqe_arg = (void *) (unsigned long) cqe->user_data;
+            cqe_res = cqe->res;
+            head++;
+            __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+
+            if(!cqe_arg)
+            {
+                /* nop queued by deactivate */
+                stopping = GLOBUS_TRUE;
+                continue;
+            }
+
+            globus_mutex_lock(&ring->lock);
+            {
+                ring->inflight--;
+                if(ring->waiters > 0)
+                {
+                    globus_cond_broadcast(&ring->cond);
+                }
+            }
+            globus_mutex_unlock(&ring->lock);
+
+            ring->callback(cqe_res, cqe_arg);
+        }
+
+        globus_mutex_lock(&ring->lock);
+        {
+            if(ring->pending > 0)
+            {
+                globus_l_xio_system_uring_flush(ring);
+            }
+        }
+        globus_mutex_unlock(&ring->lock);
+    }
+
+    globus_mutex_lock(&ring->lock);
+    {
+        ring->reaper_running = GLOBUS_FALSE;
+        globus_cond_broadcast(&ring->cond);
+    }
+    globus_mutex_unlock(&ring->lock);
+
+    GlobusXIOSystemDebugExit();
+    return NULL;
+}
+
+static
+int
+globus_l_xio_system_uring_setup(
+    globus_l_xio_system_uring_t *       ring,
+    unsigned                            entries)
+{
+    struct io_uring_params              params;
+    GlobusXIOName(globus_l_xio_system_uring_setup);
+
+    GlobusXIOSystemDebugEnter();
+
+    memset(&params, 0, sizeof(params));
+    ring->ring_fd = syscall(__NR_io_uring_setup, entries, &params);
+    if(ring->ring_fd < 0)
+    {
+        goto error_setup;
+    }
+    fcntl(ring->ring_fd, F_SETFD, FD_CLOEXEC);
+
+    ring->sq_ring_size =
+        params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_size =
+        params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if(params.features & IORING_FEAT_SINGLE_MMAP &&
+        ring->cq_ring_size > ring->sq_ring_size)
+    {
+        ring->sq_ring_size = ring->cq_ring_size;
+    }
+
+    ring->sq_ring = mmap(
+        NULL,
+        ring->sq_ring_size,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE,
+        ring->ring_fd,
+        IORING_OFF_SQ_RING);
+    if(ring->sq_ring == MAP_FAILED)
+    {
+        goto error_sq_ring;
+    }
+
+    if(params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        ring->cq_ring = ring->sq_ring;
+    }
+    else
+    {
+        ring->cq_ring = mmap(
+            NULL,
+            ring->cq_ring_size,
+            PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE,
+            ring->ring_fd,
+            IORING_OFF_CQ_RING);
+        if(ring->cq_ring == MAP_FAILED)
+        {
+            goto error_cq_ring;
+        }
+    }
+
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(
+        NULL,
+        ring->sqes_size,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE,
+        ring->ring_fd,
+        IORING_OFF_SQES);
+    if(ring->sqes == MAP_FAILED)
+    {
+        goto error_sqes;
+    }
+
+    ring->sq_tail = (unsigned *) ((char *) ring->sq_ring + params.sq_off.tail);
+    ring->sq_mask =
+        (unsigned *) ((char *) ring->sq_ring + params.sq_off.ring_mask);
+    ring->sq_array =
+        (unsigned *) ((char *) ring->sq_ring + params.sq_off.array);
+    ring->sq_entries = params.sq_entries;
+
+    ring->cq_head = (unsigned *) ((char *) ring->cq_ring + params.cq_off.head);
+    ring->cq_tail = (unsigned *) ((char *) ring->cq_ring + params.cq_off.tail);
+    ring->cq_mask =
+        (unsigned *) ((char *) ring->cq_ring + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)
+        ((char *) ring->cq_ring + params.cq_off.cqes);
+
+    GlobusXIOSystemDebugExit();
+    return GLOBUS_SUCCESS;
+
+error_sqes:
+    if(ring->cq_ring != ring->sq_ring)
+    {
+        munmap(ring->cq_ring, ring->cq_ring_size);
+    }
+error_cq_ring:
+    munmap(ring->sq_ring, ring->sq_ring_size);
+error_sq_ring:
+    close(ring->ring_fd);
+error_setup:
+    GlobusXIOSystemDebugExitWithError();
+    return GLOBUS_FAILURE;
+}
+
+static
+void
+globus_l_xio_system_uring_teardown(
+    globus_l_xio_system_uring_t *       ring)
+{
+    munmap(ring->sqes, ring->sqes_size);
+    if(ring->cq_ring != ring->sq_ring)
+    {
+        munmap(ring->cq_ring, ring->cq_ring_size);
+    }
+    munmap(ring->sq_ring, ring->sq_ring_size);
+    close(ring->ring_fd);
+}
+
+globus_bool_t
+globus_i_xio_system_uring_activate(
+    globus_i_xio_system_uring_callback_t callback)
+{
+    globus_l_xio_system_uring_t *       ring;
+    char *                              tmp_string;
+    int                                 entries;
+    GlobusXIOName(globus_i_xio_system_uring_activate);
+
+    GlobusXIOSystemDebugEnter();
+
+    ring = &globus_l_xio_system_uring;
+    globus_l_xio_system_uring_active = GLOBUS_FALSE;
+
+    if(globus_i_am_only_thread())
+    {
+        goto error_threads;
+    }
+
+    entries = GLOBUS_L_XIO_SYSTEM_URING_DEFAULT_ENTRIES;
+    tmp_string = globus_module_getenv("GLOBUS_XIO_SYSTEM_URING_ENTRIES");
+    if(tmp_string && atoi(tmp_string) > 0)
+    {
+        entries = atoi(tmp_string);
+    }
+
+    memset(ring, 0, sizeof(globus_l_xio_system_uring_t));
+    if(globus_l_xio_system_uring_setup(ring, entries) != GLOBUS_SUCCESS)
+    {
+        goto error_setup;
+    }
+
+    globus_mutex_init(&ring->lock, NULL);
+    globus_cond_init(&ring->cond, NULL);
+    ring->callback = callback;
+    ring->reaper_running = GLOBUS_TRUE;
+
+    if(globus_thread_create(
+        &ring->reaper, NULL, globus_l_xio_system_uring_reaper, ring) != 0)
+    {
+        goto error_thread;
+    }
+
+    globus_l_xio_system_uring_active = GLOBUS_TRUE;
+
+    GlobusXIOSystemDebugExit();
+    return GLOBUS_TRUE;
+
+error_thread:
+    globus_cond_destroy(&ring->cond);
+    globus_mutex_destroy(&ring->lock);
+    globus_l_xio_system_uring_teardown(ring);
+error_setup:
+error_threads:
+    GlobusXIOSystemDebugExitWithError();
+    return GLOBUS_FALSE;
+}
+
+void
+globus_i_xio_system_uring_deactivate(void)
+{
+    globus_l_xio_system_uring_t *       ring;
+    GlobusXIOName(globus_i_xio_system_uring_deactivate);
+
+    if(!globus_l_xio_system_uring_active)
+    {
+        return;
+    }
+
+    GlobusXIOSystemDebugEnter();
+
+    ring = &globus_l_xio_system_uring;
+    globus_mutex_lock(&ring->lock);
+    {
+        ring->shutdown = GLOBUS_TRUE;
+        globus_cond_broadcast(&ring->cond);
+
+        /* a nop with no user_arg tells the reaper to go away once
+         * everything in flight has been reaped
+         */
+        while(globus_l_xio_system_uring_queue(
+            ring, IORING_OP_NOP, -1, NULL, 0, 0, NULL) != 0)
+        {
+            globus_mutex_unlock(&ring->lock);
+            globus_thread_yield();
+            globus_mutex_lock(&ring->lock);
+        }
+        globus_l_xio_system_uring_flush(ring);
+
+        while(ring->reaper_running)
+        {
+            globus_cond_wait(&ring->cond, &ring->lock);
+        }
+    }
+    globus_mutex_unlock(&ring->lock);
+
+    globus_cond_destroy(&ring->cond);
+    globus_mutex_destroy(&ring->lock);
+    globus_l_xio_system_uring_teardown(ring);
+    globus_l_xio_system_uring_active = GLOBUS_FALSE;
+
+    GlobusXIOSystemDebugExit();
+}
+
+int
+globus_i_xio_system_uring_submit(
+    int                                 fd,
+    globus_bool_t                       is_write,
+    const globus_xio_iovec_t *          iov,
+    int                                 iovc,
+    globus_off_t                        offset,
+    void *                              user_arg)
+{
+    globus_l_xio_system_uring_t *       ring;
+    int                                 rc;
+    GlobusXIOName(globus_i_xio_system_uring_submit);
+
+    GlobusXIOSystemDebugEnterFD(fd);
+
+    ring = &globus_l_xio_system_uring;
+    globus_mutex_lock(&ring->lock);
+    {
+        /* a full ring is drained by the reaper, so it can't wait here
+         * itself.  it has just reaped one when it resubmits, so there is
+         * normally room; if not, the caller falls back to polling
+         */
+        do
+        {
+            if(ring->shutdown)
+            {
+                rc = -ESHUTDOWN;
+                break;
+            }
+
+            rc = globus_l_xio_system_uring_queue(
+                ring,
+                is_write ? IORING_OP_WRITEV : IORING_OP_READV,
+                fd,
+                iov,
+                iovc,
+                offset,
+                user_arg);
+            if(rc == -EBUSY &&
+                !globus_thread_equal(ring->reaper, globus_thread_self()))
+            {
+                ring->waiters++;
+                globus_cond_wait(&ring->cond, &ring->lock);
+                ring->waiters--;
+            }
+            else
+            {
+                break;
+            }
+        } while(rc == -EBUSY);
+
+        if(rc == 0)
+        {
+            globus_l_xio_system_uring_flush(ring);
+        }
+    }
+    globus_mutex_unlock(&ring->lock);
+
+    GlobusXIOSystemDebugExitFD(fd);
+    return rc;
+}
+
+#else
+
+globus_bool_t
+globus_i_xio_system_uring_activate(
+    globus_i_xio_system_uring_callback_t callback)
+{
+    return GLOBUS_FALSE;
+}
+
+void
+globus_i_xio_system_uring_deactivate(void)
+{
+}
+
+int
+globus_i_xio_system_uring_submit(
+    int                                 fd,
+    globus_bool_t                       is_write,
+    const globus_xio_iovec_t *          iov,
+    int                                 iovc,
+    globus_off_t                        offset,
+    void *                              user_arg)
+{
+    return -ENOSYS;
+}
+
+#endif
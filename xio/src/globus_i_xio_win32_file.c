@@ -1040,6 +1040,14 @@ error_setup:
     return result;
 }
 
+/* there is no io_uring path here */
+globus_size_t
+globus_xio_system_file_get_uring_ops(
+    globus_xio_system_file_handle_t     handle)
+{
+    return 0;
+}
+
 globus_off_t
 globus_xio_system_file_get_position(
     globus_xio_system_file_t            fd)
@@ -1193,6 +1193,41 @@ globus_xio_system_socket_register_write(
         user_arg);
 }
 
+/* no TransmitFile() support yet; callers fall back to buffered writes */
+globus_result_t
+globus_xio_system_socket_register_sendfile(
+    globus_xio_operation_t              op,
+    globus_xio_system_socket_handle_t   handle,
+    const globus_xio_iovec_t *          u_iov,
+    int                                 u_iovc,
+    globus_xio_system_file_t            file_fd,
+    globus_off_t                        file_offset,
+    globus_off_t                        file_length,
+    globus_xio_system_data_callback_t   callback,
+    void *                              user_arg)
+{
+    GlobusXIOName(globus_xio_system_socket_register_sendfile);
+
+    return GlobusXIOErrorSystemError("sendfile", ENOSYS);
+}
+
+/* callers fall back to buffered reads */
+globus_result_t
+globus_xio_system_socket_register_splice(
+    globus_xio_operation_t              op,
+    globus_xio_system_socket_handle_t   handle,
+    globus_xio_system_file_t            file_fd,
+    globus_off_t                        file_offset,
+    globus_off_t                        file_length,
+    globus_size_t                       waitforbytes,
+    globus_xio_system_data_callback_t   callback,
+    void *                              user_arg)
+{
+    GlobusXIOName(globus_xio_system_socket_register_splice);
+
+    return GlobusXIOErrorSystemError("splice", ENOSYS);
+}
+
 typedef struct
 {
     HANDLE                              event;
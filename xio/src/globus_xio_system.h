@@ -153,6 +153,13 @@ globus_xio_system_file_write(
     globus_size_t                       waitforbytes,
     globus_size_t *                     nbytes);
 
+/* number of reads and writes on handle completed by io_uring, 0 if it is
+ * using the poll path
+ */
+globus_size_t
+globus_xio_system_file_get_uring_ops(
+    globus_xio_system_file_handle_t     handle);
+
 /* syscall abstractions */
 globus_off_t
 globus_xio_system_file_get_position(
@@ -250,6 +257,37 @@ globus_xio_system_socket_register_write(
     globus_xio_system_data_callback_t   callback,
     void *                              user_arg);
 
+/* write iov and then file_length bytes of file_fd starting at file_offset,
+ * all of it, without copying the file through user space where the
+ * platform allows.  nbytes passed to the callback counts both parts
+ */
+globus_result_t
+globus_xio_system_socket_register_sendfile(
+    globus_xio_operation_t              op,
+    globus_xio_system_socket_handle_t   handle,
+    const globus_xio_iovec_t *          iov,
+    int                                 iovc,
+    globus_xio_system_file_t            file_fd,
+    globus_off_t                        file_offset,
+    globus_off_t                        file_length,
+    globus_xio_system_data_callback_t   callback,
+    void *                              user_arg);
+
+/* read up to file_length bytes into file_fd at file_offset, without copying
+ * them through user space where the platform allows.  completes once
+ * waitforbytes have been moved, with eof if the peer closes first
+ */
+globus_result_t
+globus_xio_system_socket_register_splice(
+    globus_xio_operation_t              op,
+    globus_xio_system_socket_handle_t   handle,
+    globus_xio_system_file_t            file_fd,
+    globus_off_t                        file_offset,
+    globus_off_t                        file_length,
+    globus_size_t                       waitforbytes,
+    globus_xio_system_data_callback_t   callback,
+    void *                              user_arg);
+
 /* if waitforbytes == 0, do a non-blocking read */
 globus_result_t
 globus_xio_system_socket_read(
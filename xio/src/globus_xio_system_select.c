@@ -14,6 +14,10 @@
  * limitations under the License.
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+/* cpu_set_t for pinning reactor threads */
+#define _GNU_SOURCE
+#endif
 
 #include "globus_i_xio_config.h"
 #include "globus_common.h"
@@ -23,6 +27,13 @@
 #include "globus_xio_driver.h"
 #include <stdio.h>
 #include <fcntl.h>
+#include <limits.h>
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+#ifdef HAVE_SCHED_SETAFFINITY
+#include <sched.h>
+#endif
 
 #ifdef HAVE_SYSCONF
 #define GLOBUS_L_OPEN_MAX sysconf(_SC_OPEN_MAX)
@@ -30,12 +41,75 @@
 #define GLOBUS_L_OPEN_MAX 256
 #endif
 
+/* max events collected from a single epoll_wait() */
+#define GLOBUS_L_XIO_SYSTEM_EPOLL_MAX_EVENTS 256
+#define GLOBUS_L_XIO_SYSTEM_MAX_REACTORS 64
+
+/*
+ * Event backend used by globus_l_xio_system_poll().  Chosen at activation
+ * time from the GLOBUS_XIO_SYSTEM_POLL environment variable ("select" or
+ * "epoll"); select is the default and the fallback if epoll is unavailable.
+ */
+typedef enum
+{
+    GLOBUS_L_XIO_SYSTEM_POLL_SELECT,
+    GLOBUS_L_XIO_SYSTEM_POLL_EPOLL
+} globus_l_xio_system_poll_method_t;
+
+/* per-fd state of an epoll registration */
+typedef enum
+{
+    /* fd is not in the epoll set (or we don't know that it is) */
+    GLOBUS_L_XIO_SYSTEM_EPOLL_NONE = 0,
+    /* fd is in the epoll set and armed for the registered interest */
+    GLOBUS_L_XIO_SYSTEM_EPOLL_ARMED,
+    /* fd is in the epoll set, but EPOLLONESHOT disarmed it on delivery */
+    GLOBUS_L_XIO_SYSTEM_EPOLL_FIRED,
+    /* epoll refused the fd (EPERM, eg regular files), it is always ready */
+    GLOBUS_L_XIO_SYSTEM_EPOLL_UNPOLLABLE
+} globus_l_xio_system_epoll_state_t;
+
+/*
+ * A reactor owns a set of fds and the thread that waits on them.  Reactor 0
+ * is driven by the callback library's poll (globus_l_xio_system_poll) and is
+ * the only one with the select backend.  With epoll, additional reactors
+ * can be requested with GLOBUS_XIO_SYSTEM_REACTORS; each gets its own
+ * epoll set, locks and thread, optionally pinned to a cpu.  Handles are
+ * bound to a reactor when they are created and all of their operations are
+ * waited on and performed there.
+ */
+typedef struct globus_l_xio_system_reactor_s
+{
+    int                                 index;
+    globus_mutex_t                      fdset_mutex;
+    globus_mutex_t                      cancel_mutex;
+    globus_bool_t                       select_active;
+    globus_bool_t                       wakeup_pending;
+    globus_list_t *                     canceled_reads;
+    globus_list_t *                     canceled_writes;
+    int                                 wakeup_pipe[2];
+#ifdef HAVE_SYS_EPOLL_H
+    int                                 epoll_fd;
+    struct epoll_event *                epoll_events;
+    globus_list_t *                     unpollable_reads;
+    globus_list_t *                     unpollable_writes;
+#endif
+    int                                 cpu;
+} globus_l_xio_system_reactor_t;
+
 typedef struct globus_l_xio_system_s
 {
     globus_xio_system_type_t            type;
     int                                 fd;
     globus_mutex_t                      lock; /* only used to protect below */
     globus_off_t                        file_position;
+    globus_l_xio_system_reactor_t *     reactor;
+    /* regular file, data ops go through the io_uring path */
+    globus_bool_t                       use_uring;
+    /* requests completed by io_uring, protected by lock */
+    globus_size_t                       uring_ops;
+    /* created by the first register_splice, -1 until then */
+    int                                 splice_pipe[2];
 } globus_l_xio_system_t;
 
 static
@@ -59,10 +133,6 @@ globus_module_descriptor_t              globus_i_xio_system_module =
 };
 
 static globus_cond_t                    globus_l_xio_system_cond;
-static globus_mutex_t                   globus_l_xio_system_fdset_mutex;
-static globus_mutex_t                   globus_l_xio_system_cancel_mutex;
-static globus_bool_t                    globus_l_xio_system_select_active;
-static globus_bool_t                    globus_l_xio_system_wakeup_pending;
 static globus_bool_t                    globus_l_xio_system_shutdown_called;
 static int                              globus_l_xio_system_highest_fd;
 static int                              globus_l_xio_system_max_fds;
@@ -71,12 +141,28 @@ static fd_set *                         globus_l_xio_system_read_fds;
 static fd_set *                         globus_l_xio_system_write_fds;
 static fd_set *                         globus_l_xio_system_ready_reads;
 static fd_set *                         globus_l_xio_system_ready_writes;
-static globus_list_t *                  globus_l_xio_system_canceled_reads;
-static globus_list_t *                  globus_l_xio_system_canceled_writes;
 static globus_i_xio_system_op_info_t ** globus_l_xio_system_read_operations;
 static globus_i_xio_system_op_info_t ** globus_l_xio_system_write_operations;
-static int                              globus_l_xio_system_wakeup_pipe[2];
 static globus_callback_handle_t         globus_l_xio_system_poll_handle;
+static globus_l_xio_system_poll_method_t globus_l_xio_system_poll_method;
+static globus_l_xio_system_reactor_t *  globus_l_xio_system_reactors;
+static int                              globus_l_xio_system_reactor_count;
+static int                              globus_l_xio_system_next_reactor;
+static int                              globus_l_xio_system_reactor_threads;
+static globus_bool_t                    globus_l_xio_system_use_uring;
+#ifdef HAVE_SYS_EPOLL_H
+static unsigned char *                  globus_l_xio_system_epoll_states;
+#endif
+
+/*
+ * the fd_set bitmaps are only maintained for the select backend (FD_SET on
+ * an fd >= FD_SETSIZE is not safe).  the operation arrays are kept in sync
+ * with them, so use those to see what is registered.
+ */
+#define GlobusLXIOSystemReadRegistered(fd)                                  \
+    (globus_l_xio_system_read_operations[(fd)] != GLOBUS_NULL)
+#define GlobusLXIOSystemWriteRegistered(fd)                                 \
+    (globus_l_xio_system_write_operations[(fd)] != GLOBUS_NULL)
 
 /* In the pre-activation of the thread module, we
  * are setting up some code to block the SIGPIPE
@@ -91,6 +177,12 @@ void
 globus_l_xio_system_poll(
     void *                              user_args);
 
+static
+void
+globus_l_xio_system_uring_cb(
+    globus_ssize_t                      res,
+    void *                              user_arg);
+
 static
 void
 globus_l_xio_system_kickout(
@@ -98,16 +190,19 @@ globus_l_xio_system_kickout(
 
 static
 void
-globus_l_xio_system_select_wakeup(void);
+globus_l_xio_system_select_wakeup(
+    globus_l_xio_system_reactor_t *     reactor);
 
 static
 void
 globus_l_xio_system_unregister_read(
+    globus_l_xio_system_reactor_t *     reactor,
     int                                 fd);
 
 static
 void
 globus_l_xio_system_unregister_write(
+    globus_l_xio_system_reactor_t *     reactor,
     int                                 fd);
 
 static
@@ -147,6 +242,283 @@ globus_result_t
 globus_l_xio_system_close(
     int                                 fd);
 
+#ifdef HAVE_SYS_EPOLL_H
+/*
+ * bring the epoll registration for fd in line with the read and write
+ * operations registered on it.  fds are added edge triggered and
+ * EPOLLONESHOT so that an fd reported by epoll_wait() stays quiet until the
+ * poll thread has dealt with it and re-arms it here.
+ *
+ * called locked (reactor's fdset mutex)
+ */
+static
+int
+globus_l_xio_system_epoll_update(
+    globus_l_xio_system_reactor_t *     reactor,
+    int                                 fd)
+{
+    struct epoll_event                  event;
+    int                                 rc = 0;
+    int                                 ctl;
+    GlobusXIOName(globus_l_xio_system_epoll_update);
+
+    GlobusXIOSystemDebugEnterFD(fd);
+
+    memset(&event, 0, sizeof(event));
+    if(GlobusLXIOSystemReadRegistered(fd))
+    {
+        event.events |= EPOLLIN;
+    }
+    if(GlobusLXIOSystemWriteRegistered(fd))
+    {
+        event.events |= EPOLLOUT;
+    }
+    event.data.fd = fd;
+
+    if(event.events &&
+        globus_l_xio_system_epoll_states[fd] ==
+            GLOBUS_L_XIO_SYSTEM_EPOLL_UNPOLLABLE)
+    {
+        /* hand it straight to the poll thread */
+        if(event.events & EPOLLIN)
+        {
+            globus_list_insert(
+                &reactor->unpollable_reads, (void *) (intptr_t) fd);
+        }
+        if(event.events & EPOLLOUT)
+        {
+            globus_list_insert(
+                &reactor->unpollable_writes, (void *) (intptr_t) fd);
+        }
+    }
+    else if(event.events)
+    {
+        event.events |= EPOLLET | EPOLLONESHOT;
+        ctl = globus_l_xio_system_epoll_states[fd] ==
+            GLOBUS_L_XIO_SYSTEM_EPOLL_NONE ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+
+        rc = epoll_ctl(reactor->epoll_fd, ctl, fd, &event);
+        /* fd may have been closed and reused since we last saw it, or
+         * added behind our back (states are only a hint)
+         */
+        if(rc < 0 && ctl == EPOLL_CTL_MOD && errno == ENOENT)
+        {
+            rc = epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, fd, &event);
+        }
+        else if(rc < 0 && ctl == EPOLL_CTL_ADD && errno == EEXIST)
+        {
+            rc = epoll_ctl(reactor->epoll_fd, EPOLL_CTL_MOD, fd, &event);
+        }
+
+        if(rc == 0)
+        {
+            globus_l_xio_system_epoll_states[fd] =
+                GLOBUS_L_XIO_SYSTEM_EPOLL_ARMED;
+        }
+        else if(errno == EPERM)
+        {
+            globus_l_xio_system_epoll_states[fd] =
+                GLOBUS_L_XIO_SYSTEM_EPOLL_UNPOLLABLE;
+            return globus_l_xio_system_epoll_update(reactor, fd);
+        }
+    }
+    else if(globus_l_xio_system_epoll_states[fd] ==
+        GLOBUS_L_XIO_SYSTEM_EPOLL_ARMED)
+    {
+        /* nothing registered, but still armed (canceled op).  drop it so
+         * it can't report on behalf of a later owner of this fd
+         */
+        epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, fd, &event);
+        globus_l_xio_system_epoll_states[fd] = GLOBUS_L_XIO_SYSTEM_EPOLL_NONE;
+    }
+
+    GlobusXIOSystemDebugExitFD(fd);
+    return rc;
+}
+
+static
+int
+globus_l_xio_system_epoll_init(
+    globus_l_xio_system_reactor_t *     reactor)
+{
+    struct epoll_event                  event;
+    GlobusXIOName(globus_l_xio_system_epoll_init);
+
+    GlobusXIOSystemDebugEnter();
+
+#ifdef HAVE_EPOLL_CREATE1
+    reactor->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+#else
+    reactor->epoll_fd = epoll_create(GLOBUS_L_XIO_SYSTEM_EPOLL_MAX_EVENTS);
+    if(reactor->epoll_fd >= 0)
+    {
+        fcntl(reactor->epoll_fd, F_SETFD, FD_CLOEXEC);
+    }
+#endif
+    if(reactor->epoll_fd < 0)
+    {
+        goto error_create;
+    }
+
+    reactor->epoll_events = (struct epoll_event *)
+        globus_calloc(
+            GLOBUS_L_XIO_SYSTEM_EPOLL_MAX_EVENTS, sizeof(struct epoll_event));
+    if(!reactor->epoll_events)
+    {
+        goto error_events;
+    }
+
+    reactor->unpollable_reads = GLOBUS_NULL;
+    reactor->unpollable_writes = GLOBUS_NULL;
+
+    /* the wakeup pipe is the only level triggered fd in the set */
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = reactor->wakeup_pipe[0];
+    if(epoll_ctl(
+        reactor->epoll_fd,
+        EPOLL_CTL_ADD,
+        reactor->wakeup_pipe[0],
+        &event) < 0)
+    {
+        goto error_wakeup;
+    }
+
+    GlobusXIOSystemDebugExit();
+    return GLOBUS_SUCCESS;
+
+error_wakeup:
+    globus_free(reactor->epoll_events);
+error_events:
+    globus_l_xio_system_close(reactor->epoll_fd);
+error_create:
+    GlobusXIOSystemDebugExitWithError();
+    return GLOBUS_FAILURE;
+}
+
+static
+void
+globus_l_xio_system_epoll_destroy(
+    globus_l_xio_system_reactor_t *     reactor)
+{
+    globus_l_xio_system_close(reactor->epoll_fd);
+    globus_free(reactor->epoll_events);
+    globus_list_free(reactor->unpollable_reads);
+    globus_list_free(reactor->unpollable_writes);
+}
+
+static
+globus_bool_t
+globus_l_xio_system_epoll_poll(
+    globus_l_xio_system_reactor_t *     reactor,
+    globus_reltime_t *                  time_left,
+    globus_bool_t                       time_left_is_infinity,
+    globus_bool_t *                     time_left_is_zero);
+
+static
+void *
+globus_l_xio_system_reactor_thread(
+    void *                              user_arg)
+{
+    globus_l_xio_system_reactor_t *     reactor;
+    globus_bool_t                       time_left_is_zero;
+    GlobusXIOName(globus_l_xio_system_reactor_thread);
+
+    GlobusXIOSystemDebugEnter();
+
+    reactor = (globus_l_xio_system_reactor_t *) user_arg;
+
+#ifdef HAVE_SCHED_SETAFFINITY
+    if(reactor->cpu >= 0)
+    {
+        cpu_set_t                       cpus;
+
+        /* best effort, stay unbound if the cpu isn't ours to use */
+        CPU_ZERO(&cpus);
+        CPU_SET(reactor->cpu, &cpus);
+        sched_setaffinity(0, sizeof(cpus), &cpus);
+    }
+#endif
+
+    while(!globus_l_xio_system_shutdown_called)
+    {
+        globus_l_xio_system_epoll_poll(
+            reactor, GLOBUS_NULL, GLOBUS_TRUE, &time_left_is_zero);
+    }
+
+    globus_mutex_lock(&globus_l_xio_system_reactors[0].fdset_mutex);
+    {
+        globus_l_xio_system_reactor_threads--;
+        globus_cond_signal(&globus_l_xio_system_cond);
+    }
+    globus_mutex_unlock(&globus_l_xio_system_reactors[0].fdset_mutex);
+
+    GlobusXIOSystemDebugExit();
+    return GLOBUS_NULL;
+}
+#endif
+
+static
+int
+globus_l_xio_system_reactor_init(
+    globus_l_xio_system_reactor_t *     reactor,
+    int                                 index)
+{
+    GlobusXIOName(globus_l_xio_system_reactor_init);
+
+    GlobusXIOSystemDebugEnter();
+
+    memset(reactor, 0, sizeof(globus_l_xio_system_reactor_t));
+    reactor->index = index;
+    reactor->cpu = -1;
+    reactor->select_active = GLOBUS_FALSE;
+    reactor->wakeup_pending = GLOBUS_FALSE;
+    reactor->canceled_reads  = GLOBUS_NULL;
+    reactor->canceled_writes = GLOBUS_NULL;
+
+    /*
+     * Create a pipe to myself, so that I can wake up the thread that is
+     * blocked on a select().
+     */
+    if(pipe(reactor->wakeup_pipe) != 0)
+    {
+        goto error_pipe;
+    }
+    fcntl(reactor->wakeup_pipe[0], F_SETFD, FD_CLOEXEC);
+    fcntl(reactor->wakeup_pipe[1], F_SETFD, FD_CLOEXEC);
+
+    globus_mutex_init(&reactor->fdset_mutex, GLOBUS_NULL);
+    globus_mutex_init(&reactor->cancel_mutex, GLOBUS_NULL);
+
+    GlobusXIOSystemDebugExit();
+    return GLOBUS_SUCCESS;
+
+error_pipe:
+    GlobusXIOSystemDebugExitWithError();
+    return GLOBUS_FAILURE;
+}
+
+static
+void
+globus_l_xio_system_reactor_destroy(
+    globus_l_xio_system_reactor_t *     reactor)
+{
+#ifdef HAVE_SYS_EPOLL_H
+    if(globus_l_xio_system_poll_method == GLOBUS_L_XIO_SYSTEM_POLL_EPOLL)
+    {
+        globus_l_xio_system_epoll_destroy(reactor);
+    }
+#endif
+    globus_l_xio_system_close(reactor->wakeup_pipe[0]);
+    globus_l_xio_system_close(reactor->wakeup_pipe[1]);
+
+    globus_list_free(reactor->canceled_reads);
+    globus_list_free(reactor->canceled_writes);
+
+    globus_mutex_destroy(&reactor->cancel_mutex);
+    globus_mutex_destroy(&reactor->fdset_mutex);
+}
+
 static
 void
 globus_l_xio_system_wakeup_handler(
@@ -158,13 +530,16 @@ globus_l_xio_system_wakeup_handler(
 
     GlobusXIOSystemDebugEnter();
     
+    /* only reactor 0 runs in the callback library's poll */
     if(!globus_l_xio_system_shutdown_called)
     {
         byte = 0;
         do
         {
             rc = write(
-                globus_l_xio_system_wakeup_pipe[1], &byte, sizeof(byte));
+                globus_l_xio_system_reactors[0].wakeup_pipe[1],
+                &byte,
+                sizeof(byte));
         } while(rc < 0 && errno == EINTR);
     }
     
@@ -177,6 +552,9 @@ globus_l_xio_system_activate(void)
 {
     int                                 i;
     char *                              block;
+    char *                              method;
+    char *                              tmp_string;
+    globus_l_xio_system_reactor_t *     reactor;
     globus_result_t                     result;
     globus_reltime_t                    period;
     GlobusXIOName(globus_l_xio_system_activate);
@@ -189,11 +567,6 @@ globus_l_xio_system_activate(void)
     GlobusXIOSystemDebugEnter();
 
     globus_cond_init(&globus_l_xio_system_cond, GLOBUS_NULL);
-    globus_mutex_init(&globus_l_xio_system_fdset_mutex, GLOBUS_NULL);
-    globus_mutex_init(&globus_l_xio_system_cancel_mutex, GLOBUS_NULL);
-
-    globus_l_xio_system_select_active = GLOBUS_FALSE;
-    globus_l_xio_system_wakeup_pending = GLOBUS_FALSE;
     globus_l_xio_system_shutdown_called = GLOBUS_FALSE;
 
     /*
@@ -221,9 +594,6 @@ globus_l_xio_system_activate(void)
     globus_l_xio_system_ready_reads     = (fd_set *) (block + i * 2);
     globus_l_xio_system_ready_writes    = (fd_set *) (block + i * 3);
 
-    globus_l_xio_system_canceled_reads  = GLOBUS_NULL;
-    globus_l_xio_system_canceled_writes = GLOBUS_NULL;
-
     globus_l_xio_system_read_operations = (globus_i_xio_system_op_info_t **)
         globus_calloc(
             globus_l_xio_system_max_fds * 2,
@@ -235,19 +605,89 @@ globus_l_xio_system_activate(void)
     globus_l_xio_system_write_operations =
         globus_l_xio_system_read_operations + globus_l_xio_system_max_fds;
 
-    /*
-     * Create a pipe to myself, so that I can wake up the thread that is
-     * blocked on a select().
-     */
-    if(pipe(globus_l_xio_system_wakeup_pipe) != 0)
+    globus_l_xio_system_poll_method = GLOBUS_L_XIO_SYSTEM_POLL_SELECT;
+    globus_l_xio_system_reactor_count = 1;
+    globus_l_xio_system_next_reactor = 0;
+    globus_l_xio_system_reactor_threads = 0;
+
+    method = globus_module_getenv("GLOBUS_XIO_SYSTEM_POLL");
+#ifdef HAVE_SYS_EPOLL_H
+    if(method && strcmp(method, "epoll") == 0)
     {
-        goto error_pipe;
+        globus_l_xio_system_epoll_states = (unsigned char *)
+            globus_calloc(globus_l_xio_system_max_fds, sizeof(unsigned char));
+        if(globus_l_xio_system_epoll_states)
+        {
+            globus_l_xio_system_poll_method = GLOBUS_L_XIO_SYSTEM_POLL_EPOLL;
+        }
+
+        tmp_string = globus_module_getenv("GLOBUS_XIO_SYSTEM_REACTORS");
+        if(tmp_string && !globus_i_am_only_thread())
+        {
+            globus_l_xio_system_reactor_count = atoi(tmp_string);
+            if(globus_l_xio_system_reactor_count < 1)
+            {
+                globus_l_xio_system_reactor_count = 1;
+            }
+            else if(globus_l_xio_system_reactor_count >
+                GLOBUS_L_XIO_SYSTEM_MAX_REACTORS)
+            {
+                globus_l_xio_system_reactor_count =
+                    GLOBUS_L_XIO_SYSTEM_MAX_REACTORS;
+            }
+        }
     }
-    fcntl(globus_l_xio_system_wakeup_pipe[0], F_SETFD, FD_CLOEXEC);
-    fcntl(globus_l_xio_system_wakeup_pipe[1], F_SETFD, FD_CLOEXEC);
-    
-    globus_l_xio_system_highest_fd = globus_l_xio_system_wakeup_pipe[0];
-    FD_SET(globus_l_xio_system_wakeup_pipe[0], globus_l_xio_system_read_fds);
+#endif
+
+    globus_l_xio_system_reactors = (globus_l_xio_system_reactor_t *)
+        globus_calloc(
+            globus_l_xio_system_reactor_count,
+            sizeof(globus_l_xio_system_reactor_t));
+    if(!globus_l_xio_system_reactors)
+    {
+        goto error_reactors;
+    }
+
+    for(i = 0; i < globus_l_xio_system_reactor_count; i++)
+    {
+        reactor = &globus_l_xio_system_reactors[i];
+        if(globus_l_xio_system_reactor_init(reactor, i) != GLOBUS_SUCCESS)
+        {
+            goto error_reactor_init;
+        }
+
+#ifdef HAVE_SYS_EPOLL_H
+        if(globus_l_xio_system_poll_method == GLOBUS_L_XIO_SYSTEM_POLL_EPOLL &&
+            globus_l_xio_system_epoll_init(reactor) != GLOBUS_SUCCESS)
+        {
+            if(i > 0)
+            {
+                /* make do with the reactors we have */
+                globus_l_xio_system_poll_method =
+                    GLOBUS_L_XIO_SYSTEM_POLL_SELECT;
+                globus_l_xio_system_reactor_destroy(reactor);
+                globus_l_xio_system_poll_method =
+                    GLOBUS_L_XIO_SYSTEM_POLL_EPOLL;
+                globus_l_xio_system_reactor_count = i;
+                break;
+            }
+            globus_free(globus_l_xio_system_epoll_states);
+            globus_l_xio_system_poll_method = GLOBUS_L_XIO_SYSTEM_POLL_SELECT;
+        }
+#endif
+    }
+
+    if(method && strcmp(method, "epoll") == 0 &&
+        globus_l_xio_system_poll_method != GLOBUS_L_XIO_SYSTEM_POLL_EPOLL)
+    {
+        GlobusXIOSystemDebugPrintf(
+            GLOBUS_I_XIO_SYSTEM_DEBUG_INFO,
+            (_XIOSL("[%s] epoll unavailable, using select\n"), _xio_name));
+    }
+
+    reactor = &globus_l_xio_system_reactors[0];
+    globus_l_xio_system_highest_fd = reactor->wakeup_pipe[0];
+    FD_SET(reactor->wakeup_pipe[0], globus_l_xio_system_read_fds);
 
     GlobusTimeReltimeSet(period, 0, 0);
     result = globus_callback_register_periodic(
@@ -266,22 +706,84 @@ globus_l_xio_system_activate(void)
     globus_callback_add_wakeup_handler(
         globus_l_xio_system_wakeup_handler, GLOBUS_NULL);
 
+    /* regular file reads and writes can be handed to io_uring instead of
+     * being done by whichever thread is polling
+     */
+    globus_l_xio_system_use_uring = GLOBUS_FALSE;
+    tmp_string = globus_module_getenv("GLOBUS_XIO_SYSTEM_FILE_IO");
+    if(tmp_string && strcmp(tmp_string, "uring") == 0)
+    {
+        globus_l_xio_system_use_uring = globus_i_xio_system_uring_activate(
+            globus_l_xio_system_uring_cb);
+        if(!globus_l_xio_system_use_uring)
+        {
+            GlobusXIOSystemDebugPrintf(
+                GLOBUS_I_XIO_SYSTEM_DEBUG_INFO,
+                (_XIOSL("[%s] io_uring unavailable, using poll\n"),
+                _xio_name));
+        }
+    }
+
+#ifdef HAVE_SYS_EPOLL_H
+    for(i = 1; i < globus_l_xio_system_reactor_count; i++)
+    {
+        globus_thread_t                 thread;
+        long                            ncpus = -1;
+
+#ifdef _SC_NPROCESSORS_ONLN
+        ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+        reactor = &globus_l_xio_system_reactors[i];
+        if(ncpus > 0)
+        {
+            reactor->cpu = i % ncpus;
+        }
+
+        if(globus_thread_create(
+            &thread,
+            GLOBUS_NULL,
+            globus_l_xio_system_reactor_thread,
+            reactor) != 0)
+        {
+            /* the reactors that are running will take the handles */
+            globus_l_xio_system_reactor_count = i;
+            break;
+        }
+
+        globus_mutex_lock(&globus_l_xio_system_reactors[0].fdset_mutex);
+        {
+            globus_l_xio_system_reactor_threads++;
+        }
+        globus_mutex_unlock(&globus_l_xio_system_reactors[0].fdset_mutex);
+    }
+#endif
+
     GlobusXIOSystemDebugExit();
     return GLOBUS_SUCCESS;
 
 error_register:
-    globus_l_xio_system_close(globus_l_xio_system_wakeup_pipe[0]);
-    globus_l_xio_system_close(globus_l_xio_system_wakeup_pipe[1]);
+    i = globus_l_xio_system_reactor_count;
 
-error_pipe:
+error_reactor_init:
+    while(--i >= 0)
+    {
+        globus_l_xio_system_reactor_destroy(&globus_l_xio_system_reactors[i]);
+    }
+    globus_free(globus_l_xio_system_reactors);
+#ifdef HAVE_SYS_EPOLL_H
+    if(globus_l_xio_system_poll_method == GLOBUS_L_XIO_SYSTEM_POLL_EPOLL)
+    {
+        globus_free(globus_l_xio_system_epoll_states);
+    }
+#endif
+
+error_reactors:
     globus_free(globus_l_xio_system_read_operations);
 
 error_operations:
     globus_free(globus_l_xio_system_read_fds);
 
 error_fdsets:
-    globus_mutex_destroy(&globus_l_xio_system_cancel_mutex);
-    globus_mutex_destroy(&globus_l_xio_system_fdset_mutex);
     globus_cond_destroy(&globus_l_xio_system_cond);
     
     GlobusXIOSystemDebugExitWithError();
@@ -296,17 +798,19 @@ globus_l_xio_system_unregister_periodic_cb(
     void *                              user_args)
 {
     globus_bool_t *                     signaled;
+    globus_l_xio_system_reactor_t *     reactor;
     GlobusXIOName(globus_l_xio_system_unregister_periodic_cb);
     
     GlobusXIOSystemDebugEnter();
     
+    reactor = &globus_l_xio_system_reactors[0];
     signaled = (globus_bool_t *) user_args;
-    globus_mutex_lock(&globus_l_xio_system_fdset_mutex);
+    globus_mutex_lock(&reactor->fdset_mutex);
     {
         *signaled = GLOBUS_TRUE;
         globus_cond_signal(&globus_l_xio_system_cond);
     }
-    globus_mutex_unlock(&globus_l_xio_system_fdset_mutex);
+    globus_mutex_unlock(&reactor->fdset_mutex);
 
     GlobusXIOSystemDebugExit();
 }
@@ -315,11 +819,14 @@ static
 int
 globus_l_xio_system_deactivate(void)
 {
+    globus_l_xio_system_reactor_t *     reactor;
+    int                                 i;
     GlobusXIOName(globus_l_xio_system_deactivate);
 
     GlobusXIOSystemDebugEnter();
 
-    globus_mutex_lock(&globus_l_xio_system_fdset_mutex);
+    reactor = &globus_l_xio_system_reactors[0];
+    globus_mutex_lock(&reactor->fdset_mutex);
     {
         globus_bool_t                   signaled;
         
@@ -330,27 +837,40 @@ globus_l_xio_system_deactivate(void)
             globus_l_xio_system_unregister_periodic_cb,
             &signaled,
             GLOBUS_NULL);
-        globus_l_xio_system_wakeup_pending = GLOBUS_TRUE;
-        globus_l_xio_system_select_wakeup();
+        for(i = 0; i < globus_l_xio_system_reactor_count; i++)
+        {
+            globus_l_xio_system_select_wakeup(
+                &globus_l_xio_system_reactors[i]);
+        }
+        reactor->wakeup_pending = GLOBUS_TRUE;
 
-        while(!signaled)
+        while(!signaled || globus_l_xio_system_reactor_threads > 0)
         {
             globus_cond_wait(
-                &globus_l_xio_system_cond, &globus_l_xio_system_fdset_mutex);
+                &globus_l_xio_system_cond, &reactor->fdset_mutex);
         }
     }
-    globus_mutex_unlock(&globus_l_xio_system_fdset_mutex);
+    globus_mutex_unlock(&reactor->fdset_mutex);
 
-    globus_l_xio_system_close(globus_l_xio_system_wakeup_pipe[0]);
-    globus_l_xio_system_close(globus_l_xio_system_wakeup_pipe[1]);
+    if(globus_l_xio_system_use_uring)
+    {
+        globus_i_xio_system_uring_deactivate();
+    }
 
-    globus_list_free(globus_l_xio_system_canceled_reads);
-    globus_list_free(globus_l_xio_system_canceled_writes);
+    for(i = 0; i < globus_l_xio_system_reactor_count; i++)
+    {
+        globus_l_xio_system_reactor_destroy(&globus_l_xio_system_reactors[i]);
+    }
+    globus_free(globus_l_xio_system_reactors);
+#ifdef HAVE_SYS_EPOLL_H
+    if(globus_l_xio_system_poll_method == GLOBUS_L_XIO_SYSTEM_POLL_EPOLL)
+    {
+        globus_free(globus_l_xio_system_epoll_states);
+    }
+#endif
     globus_free(globus_l_xio_system_read_operations);
     globus_free(globus_l_xio_system_read_fds);
 
-    globus_mutex_destroy(&globus_l_xio_system_cancel_mutex);
-    globus_mutex_destroy(&globus_l_xio_system_fdset_mutex);
     globus_cond_destroy(&globus_l_xio_system_cond);
 
     GlobusXIOSystemDebugExit();
@@ -384,8 +904,23 @@ globus_l_xio_system_handle_init(
     
     handle->type = type;
     handle->fd = fd;
+    handle->splice_pipe[0] = -1;
+    handle->splice_pipe[1] = -1;
     
     handle->file_position = globus_xio_system_file_get_position(fd);
+
+    handle->use_uring = GLOBUS_FALSE;
+    handle->uring_ops = 0;
+    if(globus_l_xio_system_use_uring && type == GLOBUS_XIO_SYSTEM_FILE)
+    {
+        struct stat                     stat_buf;
+
+        /* pipes, ttys and the like have no offset to read at */
+        if(fstat(fd, &stat_buf) == 0 && S_ISREG(stat_buf.st_mode))
+        {
+            handle->use_uring = GLOBUS_TRUE;
+        }
+    }
     
     rc = globus_l_xio_system_add_nonblocking(handle);
     if(rc < 0)
@@ -396,6 +931,36 @@ globus_l_xio_system_handle_init(
     
     globus_mutex_init(&handle->lock, NULL);
     
+    handle->reactor = &globus_l_xio_system_reactors[0];
+    if(globus_l_xio_system_reactor_count > 1)
+    {
+        int                             next;
+
+        globus_mutex_lock(&handle->reactor->fdset_mutex);
+        {
+            next = globus_l_xio_system_next_reactor;
+            globus_l_xio_system_next_reactor =
+                (next + 1) % globus_l_xio_system_reactor_count;
+        }
+        globus_mutex_unlock(&handle->reactor->fdset_mutex);
+
+        handle->reactor = &globus_l_xio_system_reactors[next];
+    }
+
+#ifdef HAVE_SYS_EPOLL_H
+    if(globus_l_xio_system_poll_method == GLOBUS_L_XIO_SYSTEM_POLL_EPOLL &&
+        fd >= 0 && fd < globus_l_xio_system_max_fds)
+    {
+        /* whatever we knew about this fd number belonged to another file */
+        globus_mutex_lock(&handle->reactor->fdset_mutex);
+        {
+            globus_l_xio_system_epoll_states[fd] =
+                GLOBUS_L_XIO_SYSTEM_EPOLL_NONE;
+        }
+        globus_mutex_unlock(&handle->reactor->fdset_mutex);
+    }
+#endif
+
     *u_handle = handle;
     GlobusXIOSystemDebugExitFD(fd);
     return GLOBUS_SUCCESS;
@@ -438,6 +1003,11 @@ globus_l_xio_system_handle_destroy(
     GlobusXIOSystemDebugEnterFD(fd);
 
     globus_l_xio_system_remove_nonblocking(handle);
+    if(handle->splice_pipe[0] >= 0)
+    {
+        close(handle->splice_pipe[0]);
+        close(handle->splice_pipe[1]);
+    }
     globus_free(handle);
     
     GlobusXIOSystemDebugExitFD(fd);
@@ -465,13 +1035,15 @@ globus_l_xio_system_cancel_cb(
     globus_xio_error_type_t             reason)
 {
     globus_i_xio_system_op_info_t *     op_info;
+    globus_l_xio_system_reactor_t *     reactor;
     GlobusXIOName(globus_l_xio_system_cancel_cb);
 
     GlobusXIOSystemDebugEnter();
 
     op_info = (globus_i_xio_system_op_info_t *) user_arg;
+    reactor = op_info->handle->reactor;
 
-    globus_mutex_lock(&globus_l_xio_system_cancel_mutex);
+    globus_mutex_lock(&reactor->cancel_mutex);
     {
         if(op_info->state != GLOBUS_I_XIO_SYSTEM_OP_COMPLETE && 
             op_info->state != GLOBUS_I_XIO_SYSTEM_OP_CANCELED)
@@ -480,7 +1052,7 @@ globus_l_xio_system_cancel_cb(
                 ? GlobusXIOErrorObjTimeout()
                 : GlobusXIOErrorObjCanceled();
                     
-            globus_mutex_lock(&globus_l_xio_system_fdset_mutex);
+            globus_mutex_lock(&reactor->fdset_mutex);
             {
                 globus_bool_t           pend;
                 
@@ -495,7 +1067,7 @@ globus_l_xio_system_cancel_cb(
                 }
                 else
                 {
-                    if(globus_l_xio_system_select_active)
+                    if(reactor->select_active)
                     {
                         op_info->state = GLOBUS_I_XIO_SYSTEM_OP_CANCELED;
                         
@@ -505,10 +1077,10 @@ globus_l_xio_system_cancel_cb(
                                 _xio_name, op_info->handle->fd));
                             
                         /* pend the cancel for after select wakes up */
-                        if(!globus_l_xio_system_wakeup_pending)
+                        if(!reactor->wakeup_pending)
                         {
-                            globus_l_xio_system_wakeup_pending = GLOBUS_TRUE;
-                            globus_l_xio_system_select_wakeup();
+                            reactor->wakeup_pending = GLOBUS_TRUE;
+                            globus_l_xio_system_select_wakeup(reactor);
                         }
 
                         pend = GLOBUS_TRUE;
@@ -554,12 +1126,13 @@ globus_l_xio_system_cancel_cb(
                         if(pend)
                         {
                             globus_list_insert(
-                                &globus_l_xio_system_canceled_reads,
+                                &reactor->canceled_reads,
                                 (void *) (intptr_t) op_info->handle->fd);
                         }
                         else
                         {
                             globus_l_xio_system_unregister_read(
+                                reactor,
                                 op_info->handle->fd);
                         }
                     }
@@ -568,21 +1141,22 @@ globus_l_xio_system_cancel_cb(
                         if(pend)
                         {
                             globus_list_insert(
-                                &globus_l_xio_system_canceled_writes,
+                                &reactor->canceled_writes,
                                 (void *) (intptr_t) op_info->handle->fd);
                         }
                         else
                         {
                             globus_l_xio_system_unregister_write(
+                                reactor,
                                 op_info->handle->fd);
                         }
                     }
                 }
             }
-            globus_mutex_unlock(&globus_l_xio_system_fdset_mutex);
+            globus_mutex_unlock(&reactor->fdset_mutex);
         }
     }
-    globus_mutex_unlock(&globus_l_xio_system_cancel_mutex);
+    globus_mutex_unlock(&reactor->cancel_mutex);
 
     GlobusXIOSystemDebugExit();
 }
@@ -595,10 +1169,13 @@ globus_l_xio_system_register_read_fd(
 {
     globus_result_t                     result;
     globus_bool_t                       do_wakeup = GLOBUS_FALSE;
+    globus_l_xio_system_reactor_t *     reactor;
     GlobusXIOName(globus_l_xio_system_register_read_fd);
 
     GlobusXIOSystemDebugEnterFD(fd);
 
+    reactor = read_info->handle->reactor;
+
     /* I have to do this outside the lock because of lock inversion issues */
     if(globus_xio_operation_enable_cancel(
         read_info->op, globus_l_xio_system_cancel_cb, read_info))
@@ -607,7 +1184,7 @@ globus_l_xio_system_register_read_fd(
         goto error_cancel_enable;
     }
 
-    globus_mutex_lock(&globus_l_xio_system_fdset_mutex);
+    globus_mutex_lock(&reactor->fdset_mutex);
     {
         /* this really shouldnt be possible, but to be thorough ... */
         if(read_info->state == GLOBUS_I_XIO_SYSTEM_OP_CANCELED)
@@ -628,30 +1205,44 @@ globus_l_xio_system_register_read_fd(
             goto error_too_many_fds;
         }
 
-        if(FD_ISSET(fd, globus_l_xio_system_read_fds))
+        if(GlobusLXIOSystemReadRegistered(fd))
         {
             result = GlobusXIOErrorAlreadyRegistered();
             goto error_already_registered;
         }
 
-        if(fd > globus_l_xio_system_highest_fd)
+        globus_l_xio_system_read_operations[fd] = read_info;
+#ifdef HAVE_SYS_EPOLL_H
+        if(globus_l_xio_system_poll_method == GLOBUS_L_XIO_SYSTEM_POLL_EPOLL)
         {
-            globus_l_xio_system_highest_fd = fd;
+            if(globus_l_xio_system_epoll_update(reactor, fd) < 0)
+            {
+                result = GlobusXIOErrorSystemError("epoll_ctl", errno);
+                globus_l_xio_system_read_operations[fd] = GLOBUS_NULL;
+                goto error_epoll;
+            }
         }
+        else
+#endif
+        {
+            if(fd > globus_l_xio_system_highest_fd)
+            {
+                globus_l_xio_system_highest_fd = fd;
+            }
 
-        FD_SET(fd, globus_l_xio_system_read_fds);
-        globus_l_xio_system_read_operations[fd] = read_info;
+            FD_SET(fd, globus_l_xio_system_read_fds);
+        }
 
-        if(globus_l_xio_system_select_active &&
-            !globus_l_xio_system_wakeup_pending)
+        if(reactor->select_active &&
+            !reactor->wakeup_pending)
         {
-            globus_l_xio_system_wakeup_pending = GLOBUS_TRUE;
+            reactor->wakeup_pending = GLOBUS_TRUE;
             do_wakeup = GLOBUS_TRUE;
         }
 
         read_info->state = GLOBUS_I_XIO_SYSTEM_OP_PENDING;
     }
-    globus_mutex_unlock(&globus_l_xio_system_fdset_mutex);
+    globus_mutex_unlock(&reactor->fdset_mutex);
 
     if(do_wakeup)
     {
@@ -659,18 +1250,21 @@ globus_l_xio_system_register_read_fd(
          * to wakeup immediately which would mean immediate contention for
          * that lock
          */
-        globus_l_xio_system_select_wakeup();
+        globus_l_xio_system_select_wakeup(reactor);
     }
     
     GlobusXIOSystemDebugExitFD(fd);
     return GLOBUS_SUCCESS;
 
+#ifdef HAVE_SYS_EPOLL_H
+error_epoll:
+#endif
 error_already_registered:
 error_too_many_fds:
 error_deactivated:
 error_canceled:
     read_info->state = GLOBUS_I_XIO_SYSTEM_OP_COMPLETE;
-    globus_mutex_unlock(&globus_l_xio_system_fdset_mutex);
+    globus_mutex_unlock(&reactor->fdset_mutex);
     globus_xio_operation_disable_cancel(read_info->op);
 
 error_cancel_enable:
@@ -686,10 +1280,13 @@ globus_l_xio_system_register_write_fd(
 {
     globus_result_t                     result;
     globus_bool_t                       do_wakeup = GLOBUS_FALSE;
+    globus_l_xio_system_reactor_t *     reactor;
     GlobusXIOName(globus_l_xio_system_register_write_fd);
 
     GlobusXIOSystemDebugEnterFD(fd);
 
+    reactor = write_info->handle->reactor;
+
     /* I have to do this outside the lock because of lock inversion issues */
     if(globus_xio_operation_enable_cancel(
         write_info->op, globus_l_xio_system_cancel_cb, write_info))
@@ -698,7 +1295,7 @@ globus_l_xio_system_register_write_fd(
         goto error_cancel_enable;
     }
 
-    globus_mutex_lock(&globus_l_xio_system_fdset_mutex);
+    globus_mutex_lock(&reactor->fdset_mutex);
     {
         /* this really shouldnt be possible, but to be thorough ... */
         if(write_info->state == GLOBUS_I_XIO_SYSTEM_OP_CANCELED)
@@ -719,30 +1316,44 @@ globus_l_xio_system_register_write_fd(
             goto error_too_many_fds;
         }
 
-        if(FD_ISSET(fd, globus_l_xio_system_write_fds))
+        if(GlobusLXIOSystemWriteRegistered(fd))
         {
             result = GlobusXIOErrorAlreadyRegistered();
             goto error_already_registered;
         }
 
-        if(fd > globus_l_xio_system_highest_fd)
+        globus_l_xio_system_write_operations[fd] = write_info;
+#ifdef HAVE_SYS_EPOLL_H
+        if(globus_l_xio_system_poll_method == GLOBUS_L_XIO_SYSTEM_POLL_EPOLL)
         {
-            globus_l_xio_system_highest_fd = fd;
+            if(globus_l_xio_system_epoll_update(reactor, fd) < 0)
+            {
+                result = GlobusXIOErrorSystemError("epoll_ctl", errno);
+                globus_l_xio_system_write_operations[fd] = GLOBUS_NULL;
+                goto error_epoll;
+            }
         }
+        else
+#endif
+        {
+            if(fd > globus_l_xio_system_highest_fd)
+            {
+                globus_l_xio_system_highest_fd = fd;
+            }
 
-        FD_SET(fd, globus_l_xio_system_write_fds);
-        globus_l_xio_system_write_operations[fd] = write_info;
+            FD_SET(fd, globus_l_xio_system_write_fds);
+        }
 
-        if(globus_l_xio_system_select_active &&
-            !globus_l_xio_system_wakeup_pending)
+        if(reactor->select_active &&
+            !reactor->wakeup_pending)
         {
-            globus_l_xio_system_wakeup_pending = GLOBUS_TRUE;
+            reactor->wakeup_pending = GLOBUS_TRUE;
             do_wakeup = GLOBUS_TRUE;
         }
 
         write_info->state = GLOBUS_I_XIO_SYSTEM_OP_PENDING;
     }
-    globus_mutex_unlock(&globus_l_xio_system_fdset_mutex);
+    globus_mutex_unlock(&reactor->fdset_mutex);
     
     if(do_wakeup)
     {
@@ -750,18 +1361,21 @@ globus_l_xio_system_register_write_fd(
          * to wakeup immediately which would mean immediate contention for
          * that lock
          */
-        globus_l_xio_system_select_wakeup();
+        globus_l_xio_system_select_wakeup(reactor);
     }
     
     GlobusXIOSystemDebugExitFD(fd);
     return GLOBUS_SUCCESS;
 
+#ifdef HAVE_SYS_EPOLL_H
+error_epoll:
+#endif
 error_already_registered:
 error_too_many_fds:
 error_deactivated:
 error_canceled:
     write_info->state = GLOBUS_I_XIO_SYSTEM_OP_COMPLETE;
-    globus_mutex_unlock(&globus_l_xio_system_fdset_mutex);
+    globus_mutex_unlock(&reactor->fdset_mutex);
     globus_xio_operation_disable_cancel(write_info->op);
 
 error_cancel_enable:
@@ -773,15 +1387,25 @@ error_cancel_enable:
 static
 void
 globus_l_xio_system_unregister_read(
+    globus_l_xio_system_reactor_t *     reactor,
     int                                 fd)
 {
     GlobusXIOName(globus_l_xio_system_unregister_read);
 
     GlobusXIOSystemDebugEnterFD(fd);
 
-    globus_assert(FD_ISSET(fd, globus_l_xio_system_read_fds));
-    FD_CLR(fd, globus_l_xio_system_read_fds);
+    globus_assert(GlobusLXIOSystemReadRegistered(fd));
     globus_l_xio_system_read_operations[fd] = GLOBUS_NULL;
+#ifdef HAVE_SYS_EPOLL_H
+    if(globus_l_xio_system_poll_method == GLOBUS_L_XIO_SYSTEM_POLL_EPOLL)
+    {
+        globus_l_xio_system_epoll_update(reactor, fd);
+    }
+    else
+#endif
+    {
+        FD_CLR(fd, globus_l_xio_system_read_fds);
+    }
 
     GlobusXIOSystemDebugExitFD(fd);
 }
@@ -790,15 +1414,25 @@ globus_l_xio_system_unregister_read(
 static
 void
 globus_l_xio_system_unregister_write(
+    globus_l_xio_system_reactor_t *     reactor,
     int                                 fd)
 {
     GlobusXIOName(globus_l_xio_system_unregister_write);
 
     GlobusXIOSystemDebugEnterFD(fd);
 
-    globus_assert(FD_ISSET(fd, globus_l_xio_system_write_fds));
-    FD_CLR(fd, globus_l_xio_system_write_fds);
+    globus_assert(GlobusLXIOSystemWriteRegistered(fd));
     globus_l_xio_system_write_operations[fd] = GLOBUS_NULL;
+#ifdef HAVE_SYS_EPOLL_H
+    if(globus_l_xio_system_poll_method == GLOBUS_L_XIO_SYSTEM_POLL_EPOLL)
+    {
+        globus_l_xio_system_epoll_update(reactor, fd);
+    }
+    else
+#endif
+    {
+        FD_CLR(fd, globus_l_xio_system_write_fds);
+    }
 
     GlobusXIOSystemDebugExitFD(fd);
 }
@@ -892,7 +1526,8 @@ globus_l_xio_system_kickout(
 
 static
 void
-globus_l_xio_system_select_wakeup(void)
+globus_l_xio_system_select_wakeup(
+    globus_l_xio_system_reactor_t *     reactor)
 {
     globus_ssize_t                      rc;
     char                                byte;
@@ -904,7 +1539,7 @@ globus_l_xio_system_select_wakeup(void)
 
     do
     {
-        rc = write(globus_l_xio_system_wakeup_pipe[1], &byte, sizeof(byte));
+        rc = write(reactor->wakeup_pipe[1], &byte, sizeof(byte));
     } while(rc < 0 && errno == EINTR);
 
     if(rc <= 0)
@@ -922,7 +1557,8 @@ globus_l_xio_system_select_wakeup(void)
 
 static
 void
-globus_l_xio_system_handle_wakeup(void)
+globus_l_xio_system_handle_wakeup(
+    globus_l_xio_system_reactor_t *     reactor)
 {
     char                                buf[64];
     globus_ssize_t                      done;
@@ -932,7 +1568,7 @@ globus_l_xio_system_handle_wakeup(void)
 
     do
     {
-        done = read(globus_l_xio_system_wakeup_pipe[0], buf, sizeof(buf));
+        done = read(reactor->wakeup_pipe[0], buf, sizeof(buf));
     } while(done < 0 && errno == EINTR);
 
     GlobusXIOSystemDebugExit();
@@ -945,6 +1581,7 @@ globus_l_xio_system_handle_read(
 {
     globus_bool_t                       handled_it;
     globus_i_xio_system_op_info_t *     read_info;
+    globus_l_xio_system_reactor_t *     reactor;
     globus_size_t                       nbytes;
     globus_result_t                     result;
     GlobusXIOName(globus_l_xio_system_handle_read);
@@ -1004,6 +1641,21 @@ globus_l_xio_system_handle_read(
         break;
 
       case GLOBUS_I_XIO_SYSTEM_OP_READ:
+        if(read_info->sop.data.file_length > 0)
+        {
+            result = globus_i_xio_system_try_splice(
+                fd,
+                read_info->handle->splice_pipe,
+                read_info->sop.data.file_fd,
+                read_info->sop.data.file_offset,
+                read_info->sop.data.file_length,
+                &nbytes);
+            read_info->nbytes += nbytes;
+            read_info->sop.data.file_offset += nbytes;
+            read_info->sop.data.file_length -= nbytes;
+            break;
+        }
+
         result = globus_l_xio_system_try_read(
             read_info->handle,
             read_info->offset,
@@ -1040,11 +1692,12 @@ error_canceled:
         handled_it = GLOBUS_TRUE;
         read_info->state = GLOBUS_I_XIO_SYSTEM_OP_COMPLETE;
 
-        globus_mutex_lock(&globus_l_xio_system_fdset_mutex);
+        reactor = read_info->handle->reactor;
+        globus_mutex_lock(&reactor->fdset_mutex);
         {
-            globus_l_xio_system_unregister_read(fd);
+            globus_l_xio_system_unregister_read(reactor, fd);
         }
-        globus_mutex_unlock(&globus_l_xio_system_fdset_mutex);
+        globus_mutex_unlock(&reactor->fdset_mutex);
 
         result = globus_callback_register_oneshot(
             GLOBUS_NULL, GLOBUS_NULL, globus_l_xio_system_kickout, read_info);
@@ -1064,6 +1717,65 @@ error_canceled:
     return handled_it;
 }
 
+/*
+ * push what is left of a sendfile op: the iov first, held back with
+ * MSG_MORE so it leaves with the payload, then the file range
+ */
+static
+globus_result_t
+globus_l_xio_system_try_sendfile(
+    globus_i_xio_system_op_info_t *     write_info,
+    globus_size_t *                     nbytes)
+{
+    globus_result_t                     result;
+    globus_size_t                       sent;
+    int                                 flags;
+    int                                 fd = write_info->handle->fd;
+
+    *nbytes = 0;
+    if(write_info->sop.data.iovc > 0)
+    {
+        flags = write_info->sop.data.flags;
+#ifdef MSG_MORE
+        flags |= MSG_MORE;
+#endif
+        result = globus_i_xio_system_socket_try_write(
+            fd,
+            write_info->sop.data.iov,
+            write_info->sop.data.iovc,
+            flags,
+            GLOBUS_NULL,
+            &sent);
+        if(result != GLOBUS_SUCCESS)
+        {
+            return result;
+        }
+
+        *nbytes = sent;
+        GlobusIXIOUtilAdjustIovec(
+            write_info->sop.data.iov, write_info->sop.data.iovc, sent);
+        if(write_info->sop.data.iovc > 0)
+        {
+            return GLOBUS_SUCCESS;
+        }
+    }
+
+    result = globus_i_xio_system_try_sendfile(
+        fd,
+        write_info->sop.data.file_fd,
+        write_info->sop.data.file_offset,
+        write_info->sop.data.file_length,
+        &sent);
+    if(result == GLOBUS_SUCCESS)
+    {
+        *nbytes += sent;
+        write_info->sop.data.file_offset += sent;
+        write_info->sop.data.file_length -= sent;
+    }
+
+    return result;
+}
+
 static
 globus_bool_t
 globus_l_xio_system_handle_write(
@@ -1071,6 +1783,7 @@ globus_l_xio_system_handle_write(
 {
     globus_bool_t                       handled_it;
     globus_i_xio_system_op_info_t *     write_info;
+    globus_l_xio_system_reactor_t *     reactor;
     globus_size_t                       nbytes;
     globus_result_t                     result;
     GlobusXIOName(globus_l_xio_system_handle_write);
@@ -1111,6 +1824,16 @@ globus_l_xio_system_handle_write(
         break;
 
       case GLOBUS_I_XIO_SYSTEM_OP_WRITE:
+        if(write_info->sop.data.file_length > 0)
+        {
+            result = globus_l_xio_system_try_sendfile(write_info, &nbytes);
+            if(result == GLOBUS_SUCCESS)
+            {
+                write_info->nbytes += nbytes;
+            }
+            break;
+        }
+
         result = globus_l_xio_system_try_write(
             write_info->handle,
             write_info->offset,
@@ -1147,11 +1870,12 @@ error_canceled:
         handled_it = GLOBUS_TRUE;
         write_info->state = GLOBUS_I_XIO_SYSTEM_OP_COMPLETE;
 
-        globus_mutex_lock(&globus_l_xio_system_fdset_mutex);
+        reactor = write_info->handle->reactor;
+        globus_mutex_lock(&reactor->fdset_mutex);
         {
-            globus_l_xio_system_unregister_write(fd);
+            globus_l_xio_system_unregister_write(reactor, fd);
         }
-        globus_mutex_unlock(&globus_l_xio_system_fdset_mutex);
+        globus_mutex_unlock(&reactor->fdset_mutex);
 
         result = globus_callback_register_oneshot(
             GLOBUS_NULL, GLOBUS_NULL, globus_l_xio_system_kickout, write_info);
@@ -1183,11 +1907,15 @@ globus_l_xio_system_bad_apple(void)
     int                                 fd;
     int                                 rc;
     struct stat                         stat_buf;
+    globus_l_xio_system_reactor_t *     reactor;
     GlobusXIOName(globus_l_xio_system_bad_apple);
 
     GlobusXIOSystemDebugEnter();
+
+    /* select is only ever driven by reactor 0 */
+    reactor = &globus_l_xio_system_reactors[0];
     
-    globus_mutex_lock(&globus_l_xio_system_fdset_mutex);
+    globus_mutex_lock(&reactor->fdset_mutex);
     {
         for(fd = 0; fd <= globus_l_xio_system_highest_fd; fd++)
         {
@@ -1208,40 +1936,250 @@ globus_l_xio_system_bad_apple(void)
                         op_info->state = GLOBUS_I_XIO_SYSTEM_OP_CANCELED;
                         op_info->error = GlobusXIOErrorObjParameter("handle");
                         globus_list_insert(
-                            &globus_l_xio_system_canceled_reads,
+                            &reactor->canceled_reads,
+                            (void *) (intptr_t) fd);
+                    }
+                }
+            }
+            
+            if(FD_ISSET(fd, globus_l_xio_system_write_fds))
+            {
+                rc = fstat(fd, &stat_buf);
+                GlobusXIOSystemUpdateErrno();
+                if(rc < 0 && errno == EBADF)
+                {
+                    GlobusXIOSystemDebugPrintf(
+                        GLOBUS_I_XIO_SYSTEM_DEBUG_INFO,
+                        (_XIOSL("[%s] fd=%d, Canceling write bad apple\n"),
+                        _xio_name, fd));
+                    
+                    op_info = globus_l_xio_system_write_operations[fd];
+                    if(op_info->state == GLOBUS_I_XIO_SYSTEM_OP_PENDING)
+                    {
+                        op_info->state = GLOBUS_I_XIO_SYSTEM_OP_CANCELED;
+                        op_info->error = GlobusXIOErrorObjParameter("handle");
+                        globus_list_insert(
+                            &reactor->canceled_writes,
                             (void *) (intptr_t) fd);
                     }
                 }
             }
-            
-            if(FD_ISSET(fd, globus_l_xio_system_write_fds))
+        }
+    }
+    globus_mutex_unlock(&reactor->fdset_mutex);
+    
+    GlobusXIOSystemDebugExit();
+}
+
+#ifdef HAVE_SYS_EPOLL_H
+/* called with cancel lock held */
+static
+globus_bool_t
+globus_l_xio_system_epoll_handle_list(
+    globus_l_xio_system_reactor_t *     reactor,
+    globus_list_t **                    list,
+    globus_bool_t                       reads)
+{
+    globus_bool_t                       handled_something = GLOBUS_FALSE;
+    int                                 fd;
+
+    while(!globus_list_empty(*list))
+    {
+        fd = (int) (intptr_t) globus_list_remove(list, *list);
+
+        if(reads ? GlobusLXIOSystemReadRegistered(fd)
+                 : GlobusLXIOSystemWriteRegistered(fd))
+        {
+            if(reads ? globus_l_xio_system_handle_read(fd)
+                     : globus_l_xio_system_handle_write(fd))
+            {
+                handled_something = GLOBUS_TRUE;
+            }
+        }
+
+        globus_mutex_lock(&reactor->fdset_mutex);
+        {
+            if(globus_l_xio_system_epoll_states[fd] !=
+                GLOBUS_L_XIO_SYSTEM_EPOLL_ARMED)
+            {
+                globus_l_xio_system_epoll_update(reactor, fd);
+            }
+        }
+        globus_mutex_unlock(&reactor->fdset_mutex);
+    }
+
+    return handled_something;
+}
+
+/*
+ * one pass of the poll loop using epoll.  unlike select, the cost of a
+ * wakeup here depends on the number of ready fds, not the number of fds
+ * registered.
+ */
+static
+globus_bool_t
+globus_l_xio_system_epoll_poll(
+    globus_l_xio_system_reactor_t *     reactor,
+    globus_reltime_t *                  time_left,
+    globus_bool_t                       time_left_is_infinity,
+    globus_bool_t *                     time_left_is_zero)
+{
+    globus_bool_t                       handled_something;
+    globus_list_t *                     ready_reads;
+    globus_list_t *                     ready_writes;
+    struct epoll_event *                events;
+    int                                 timeout;
+    int                                 nready;
+    int                                 fd;
+    int                                 i;
+    GlobusXIOName(globus_l_xio_system_epoll_poll);
+
+    GlobusXIOSystemDebugEnter();
+
+    handled_something = GLOBUS_FALSE;
+    events = reactor->epoll_events;
+
+    if(time_left_is_infinity)
+    {
+        timeout = -1;
+    }
+    else if(time_left->tv_sec >= INT_MAX / 1000 - 1)
+    {
+        timeout = INT_MAX;
+    }
+    else
+    {
+        /* round up, a 0 timeout would just spin until the deadline */
+        timeout = time_left->tv_sec * 1000 + (time_left->tv_usec + 999) / 1000;
+    }
+
+    globus_mutex_lock(&reactor->fdset_mutex);
+    {
+        if(!globus_list_empty(reactor->unpollable_reads) ||
+            !globus_list_empty(reactor->unpollable_writes))
+        {
+            timeout = 0;
+        }
+        reactor->select_active = GLOBUS_TRUE;
+    }
+    globus_mutex_unlock(&reactor->fdset_mutex);
+
+    GlobusXIOSystemDebugPrintf(
+        GLOBUS_I_XIO_SYSTEM_DEBUG_INFO,
+        (_XIOSL("[%s] Before epoll_wait\n"), _xio_name));
+
+    nready = epoll_wait(
+        reactor->epoll_fd,
+        events,
+        GLOBUS_L_XIO_SYSTEM_EPOLL_MAX_EVENTS,
+        timeout);
+
+    GlobusXIOSystemDebugPrintf(
+        GLOBUS_I_XIO_SYSTEM_DEBUG_INFO,
+        (_XIOSL("[%s] After epoll_wait\n"), _xio_name));
+
+    globus_mutex_lock(&reactor->cancel_mutex);
+    {
+        reactor->select_active = GLOBUS_FALSE;
+
+        if(nready == 0)
+        {
+            *time_left_is_zero = GLOBUS_TRUE;
+        }
+        else if(nready < 0)
+        {
+            /* can't really do anything about errors (likely EINTR) */
+            nready = 0;
+        }
+
+        globus_mutex_lock(&reactor->fdset_mutex);
+        {
+            for(i = 0; i < nready; i++)
+            {
+                fd = events[i].data.fd;
+                if(fd != reactor->wakeup_pipe[0])
+                {
+                    globus_l_xio_system_epoll_states[fd] =
+                        GLOBUS_L_XIO_SYSTEM_EPOLL_FIRED;
+                }
+            }
+
+            ready_reads = reactor->unpollable_reads;
+            ready_writes = reactor->unpollable_writes;
+            reactor->unpollable_reads = GLOBUS_NULL;
+            reactor->unpollable_writes = GLOBUS_NULL;
+        }
+        globus_mutex_unlock(&reactor->fdset_mutex);
+
+        for(i = 0; i < nready; i++)
+        {
+            fd = events[i].data.fd;
+            if(fd == reactor->wakeup_pipe[0])
+            {
+                globus_l_xio_system_handle_wakeup(reactor);
+                reactor->wakeup_pending = GLOBUS_FALSE;
+                continue;
+            }
+
+            if((events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) &&
+                GlobusLXIOSystemReadRegistered(fd))
+            {
+                if(globus_l_xio_system_handle_read(fd))
+                {
+                    handled_something = GLOBUS_TRUE;
+                }
+            }
+
+            if((events[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) &&
+                GlobusLXIOSystemWriteRegistered(fd))
             {
-                rc = fstat(fd, &stat_buf);
-                GlobusXIOSystemUpdateErrno();
-                if(rc < 0 && errno == EBADF)
+                if(globus_l_xio_system_handle_write(fd))
                 {
-                    GlobusXIOSystemDebugPrintf(
-                        GLOBUS_I_XIO_SYSTEM_DEBUG_INFO,
-                        (_XIOSL("[%s] fd=%d, Canceling write bad apple\n"),
-                        _xio_name, fd));
-                    
-                    op_info = globus_l_xio_system_write_operations[fd];
-                    if(op_info->state == GLOBUS_I_XIO_SYSTEM_OP_PENDING)
-                    {
-                        op_info->state = GLOBUS_I_XIO_SYSTEM_OP_CANCELED;
-                        op_info->error = GlobusXIOErrorObjParameter("handle");
-                        globus_list_insert(
-                            &globus_l_xio_system_canceled_writes,
-                            (void *) (intptr_t) fd);
-                    }
+                    handled_something = GLOBUS_TRUE;
+                }
+            }
+
+            /* re-arm for anything still (or newly) registered.  if someone
+             * else already did, leave it be
+             */
+            globus_mutex_lock(&reactor->fdset_mutex);
+            {
+                if(globus_l_xio_system_epoll_states[fd] ==
+                    GLOBUS_L_XIO_SYSTEM_EPOLL_FIRED)
+                {
+                    globus_l_xio_system_epoll_update(reactor, fd);
                 }
             }
+            globus_mutex_unlock(&reactor->fdset_mutex);
+        }
+
+        if(globus_l_xio_system_epoll_handle_list(
+            reactor, &reactor->canceled_reads, GLOBUS_TRUE))
+        {
+            handled_something = GLOBUS_TRUE;
+        }
+        if(globus_l_xio_system_epoll_handle_list(
+            reactor, &reactor->canceled_writes, GLOBUS_FALSE))
+        {
+            handled_something = GLOBUS_TRUE;
+        }
+        if(globus_l_xio_system_epoll_handle_list(
+            reactor, &ready_reads, GLOBUS_TRUE))
+        {
+            handled_something = GLOBUS_TRUE;
+        }
+        if(globus_l_xio_system_epoll_handle_list(
+            reactor, &ready_writes, GLOBUS_FALSE))
+        {
+            handled_something = GLOBUS_TRUE;
         }
     }
-    globus_mutex_unlock(&globus_l_xio_system_fdset_mutex);
-    
+    globus_mutex_unlock(&reactor->cancel_mutex);
+
     GlobusXIOSystemDebugExit();
+    return handled_something;
 }
+#endif
 
 static
 void
@@ -1250,10 +2188,12 @@ globus_l_xio_system_poll(
 {
     globus_bool_t                       time_left_is_zero;
     globus_bool_t                       handled_something;
+    globus_l_xio_system_reactor_t *     reactor;
     GlobusXIOName(globus_l_xio_system_poll);
 
     GlobusXIOSystemDebugEnter();
 
+    reactor = &globus_l_xio_system_reactors[0];
     handled_something = GLOBUS_FALSE;
 
     do
@@ -1279,7 +2219,20 @@ globus_l_xio_system_poll(
             time_left_is_infinity = GLOBUS_TRUE;
         }
 
-        globus_mutex_lock(&globus_l_xio_system_fdset_mutex);
+#ifdef HAVE_SYS_EPOLL_H
+        if(globus_l_xio_system_poll_method == GLOBUS_L_XIO_SYSTEM_POLL_EPOLL)
+        {
+            if(globus_l_xio_system_epoll_poll(
+                reactor,
+                &time_left, time_left_is_infinity, &time_left_is_zero))
+            {
+                handled_something = GLOBUS_TRUE;
+            }
+            continue;
+        }
+#endif
+
+        globus_mutex_lock(&reactor->fdset_mutex);
         {
             memcpy(
                 globus_l_xio_system_ready_reads,
@@ -1291,9 +2244,9 @@ globus_l_xio_system_poll(
                 globus_l_xio_system_fd_allocsize);
 
             num = globus_l_xio_system_highest_fd + 1;
-            globus_l_xio_system_select_active = GLOBUS_TRUE;
+            reactor->select_active = GLOBUS_TRUE;
         }
-        globus_mutex_unlock(&globus_l_xio_system_fdset_mutex);
+        globus_mutex_unlock(&reactor->fdset_mutex);
         
         GlobusXIOSystemDebugPrintf(
             GLOBUS_I_XIO_SYSTEM_DEBUG_INFO,
@@ -1313,17 +2266,17 @@ globus_l_xio_system_poll(
             GLOBUS_I_XIO_SYSTEM_DEBUG_INFO,
             (_XIOSL("[%s] After select\n"), _xio_name));
 
-        globus_mutex_lock(&globus_l_xio_system_cancel_mutex);
+        globus_mutex_lock(&reactor->cancel_mutex);
         {
-            globus_l_xio_system_select_active = GLOBUS_FALSE;
+            reactor->select_active = GLOBUS_FALSE;
 
             if(nready > 0)
             {
-                fd = globus_l_xio_system_wakeup_pipe[0];
+                fd = reactor->wakeup_pipe[0];
                 if(FD_ISSET(fd, globus_l_xio_system_ready_reads))
                 {
-                    globus_l_xio_system_handle_wakeup();
-                    globus_l_xio_system_wakeup_pending = GLOBUS_FALSE;
+                    globus_l_xio_system_handle_wakeup(reactor);
+                    reactor->wakeup_pending = GLOBUS_FALSE;
                     FD_CLR(fd, globus_l_xio_system_ready_reads);
                     nready--;
                 }
@@ -1356,11 +2309,11 @@ globus_l_xio_system_poll(
                     globus_l_xio_system_fd_allocsize);
             }
 
-            while(!globus_list_empty(globus_l_xio_system_canceled_reads))
+            while(!globus_list_empty(reactor->canceled_reads))
             {
                 fd = (int) (intptr_t) globus_list_remove(
-                    &globus_l_xio_system_canceled_reads,
-                    globus_l_xio_system_canceled_reads);
+                    &reactor->canceled_reads,
+                    reactor->canceled_reads);
                 
                 GlobusXIOSystemDebugPrintf(
                     GLOBUS_I_XIO_SYSTEM_DEBUG_INFO,
@@ -1373,11 +2326,11 @@ globus_l_xio_system_poll(
                 }
             }
 
-            while(!globus_list_empty(globus_l_xio_system_canceled_writes))
+            while(!globus_list_empty(reactor->canceled_writes))
             {
                 fd = (int) (intptr_t) globus_list_remove(
-                    &globus_l_xio_system_canceled_writes,
-                    globus_l_xio_system_canceled_writes);
+                    &reactor->canceled_writes,
+                    reactor->canceled_writes);
                 
                 GlobusXIOSystemDebugPrintf(
                     GLOBUS_I_XIO_SYSTEM_DEBUG_INFO,
@@ -1413,7 +2366,7 @@ globus_l_xio_system_poll(
                 }
             }
         }
-        globus_mutex_unlock(&globus_l_xio_system_cancel_mutex);
+        globus_mutex_unlock(&reactor->cancel_mutex);
 
     } while(!handled_something &&
         !time_left_is_zero &&
@@ -1552,6 +2505,114 @@ error_op_info:
     return result;
 }
 
+/*
+ * queue the remainder of a file read or write on the io_uring path.
+ * returns 0 or -errno, in which case the caller still owns op_info
+ */
+static
+int
+globus_l_xio_system_uring_submit(
+    globus_i_xio_system_op_info_t *     op_info)
+{
+    int                                 iovc;
+
+    iovc = op_info->sop.data.iovc;
+#ifdef IOV_MAX
+    if(iovc > IOV_MAX)
+    {
+        /* the rest goes when this completes */
+        iovc = IOV_MAX;
+    }
+#endif
+
+    return globus_i_xio_system_uring_submit(
+        op_info->handle->fd,
+        op_info->type == GLOBUS_I_XIO_SYSTEM_OP_WRITE,
+        op_info->sop.data.iov,
+        iovc,
+        op_info->offset,
+        op_info);
+}
+
+/* called from the io_uring reaper thread */
+static
+void
+globus_l_xio_system_uring_cb(
+    globus_ssize_t                      res,
+    void *                              user_arg)
+{
+    globus_i_xio_system_op_info_t *     op_info;
+    globus_result_t                     result;
+    globus_bool_t                       is_write;
+    int                                 fd;
+    GlobusXIOName(globus_l_xio_system_uring_cb);
+
+    op_info = (globus_i_xio_system_op_info_t *) user_arg;
+    fd = op_info->handle->fd;
+    is_write = op_info->type == GLOBUS_I_XIO_SYSTEM_OP_WRITE;
+
+    GlobusXIOSystemDebugEnterFD(fd);
+
+    if(res < 0)
+    {
+        result = GlobusXIOErrorSystemError(is_write ? "writev" : "readv", -res);
+        op_info->error = globus_error_get(result);
+    }
+    else if(res == 0 && !is_write)
+    {
+        op_info->error = globus_error_get(GlobusXIOErrorEOF());
+    }
+    else
+    {
+        op_info->nbytes += res;
+        op_info->offset += res;
+        GlobusIXIOUtilAdjustIovec(
+            op_info->sop.data.iov, op_info->sop.data.iovc, res);
+    }
+
+    globus_mutex_lock(&op_info->handle->lock);
+    {
+        op_info->handle->uring_ops++;
+    }
+    globus_mutex_unlock(&op_info->handle->lock);
+
+    if(!op_info->error && op_info->nbytes < op_info->waitforbytes)
+    {
+        if(globus_l_xio_system_uring_submit(op_info) == 0)
+        {
+            GlobusXIOSystemDebugExitFD(fd);
+            return;
+        }
+
+        /* ring is shutting down, finish it on the poll path */
+        result = is_write
+            ? globus_l_xio_system_register_write_fd(fd, op_info)
+            : globus_l_xio_system_register_read_fd(fd, op_info);
+        if(result == GLOBUS_SUCCESS)
+        {
+            GlobusXIOSystemDebugExitFD(fd);
+            return;
+        }
+        op_info->error = globus_error_get(result);
+    }
+
+    op_info->state = GLOBUS_I_XIO_SYSTEM_OP_COMPLETE;
+    result = globus_callback_register_oneshot(
+        GLOBUS_NULL, GLOBUS_NULL, globus_l_xio_system_kickout, op_info);
+    /* really cant do anything else */
+    if(result != GLOBUS_SUCCESS)
+    {
+        globus_panic(
+            GLOBUS_XIO_SYSTEM_MODULE,
+            result,
+            _XIOSL("[%s:%d] Couldn't register callback"),
+            _xio_name,
+            __LINE__);
+    }
+
+    GlobusXIOSystemDebugExitFD(fd);
+}
+
 static
 globus_result_t
 globus_l_xio_system_register_read(
@@ -1609,6 +2670,14 @@ globus_l_xio_system_register_read(
     op_info->waitforbytes = waitforbytes;
     op_info->offset = offset;
     
+    if(handle->use_uring && (u_iovc > 1 || u_iov->iov_len > 0) &&
+        globus_l_xio_system_uring_submit(op_info) == 0)
+    {
+        /* handle could be destroyed by time we get here - no touch! */
+        GlobusXIOSystemDebugExitFD(fd);
+        return GLOBUS_SUCCESS;
+    }
+
     result = globus_l_xio_system_register_read_fd(fd, op_info);
     if(result != GLOBUS_SUCCESS)
     {
@@ -1632,6 +2701,104 @@ error_op_info:
     return result;
 }
 
+globus_result_t
+globus_xio_system_socket_register_splice(
+    globus_xio_operation_t              op,
+    globus_xio_system_socket_handle_t   handle,
+    globus_xio_system_file_t            file_fd,
+    globus_off_t                        file_offset,
+    globus_off_t                        file_length,
+    globus_size_t                       waitforbytes,
+    globus_xio_system_data_callback_t   callback,
+    void *                              user_arg)
+{
+    globus_result_t                     result;
+    globus_i_xio_system_op_info_t *     op_info;
+    struct iovec *                      iov;
+    int                                 fd = handle->fd;
+    GlobusXIOName(globus_xio_system_socket_register_splice);
+
+    GlobusXIOSystemDebugEnterFD(fd);
+    GlobusXIOSystemDebugPrintf(
+        GLOBUS_I_XIO_SYSTEM_DEBUG_DATA,
+        (_XIOSL("[%s] Receiving %" GLOBUS_OFF_T_FORMAT " bytes into fd=%d\n"),
+            _xio_name, file_length, (int) file_fd));
+
+#ifdef HAVE_SPLICE
+    /* only one read is outstanding per handle, so one pipe will do */
+    if(handle->splice_pipe[0] < 0)
+    {
+        if(pipe(handle->splice_pipe) < 0)
+        {
+            result = GlobusXIOErrorSystemError("pipe", errno);
+            handle->splice_pipe[0] = -1;
+            goto error_pipe;
+        }
+#ifdef F_SETPIPE_SZ
+        fcntl(handle->splice_pipe[1], F_SETPIPE_SZ,
+            GLOBUS_I_XIO_SYSTEM_SPLICE_PIPE_SIZE);
+#endif
+    }
+#endif
+
+    GlobusIXIOSystemAllocOperation(op_info);
+    if(!op_info)
+    {
+        result = GlobusXIOErrorMemory("op_info");
+        goto error_op_info;
+    }
+
+    /* no user buffer, but the kickout frees one */
+    GlobusIXIOSystemAllocIovec(1, iov);
+    if(!iov)
+    {
+        result = GlobusXIOErrorMemory("iov");
+        goto error_iovec;
+    }
+
+    op_info->type = GLOBUS_I_XIO_SYSTEM_OP_READ;
+    op_info->sop.data.start_iov = iov;
+    op_info->sop.data.start_iovc = 1;
+    op_info->sop.data.iov = iov;
+    op_info->sop.data.iovc = 0;
+    op_info->sop.data.file_fd = file_fd;
+    op_info->sop.data.file_offset = file_offset;
+    op_info->sop.data.file_length = file_length;
+
+    op_info->state = GLOBUS_I_XIO_SYSTEM_OP_NEW;
+    op_info->op = op;
+    op_info->handle = handle;
+    op_info->user_arg = user_arg;
+    op_info->sop.data.callback = callback;
+    op_info->waitforbytes = waitforbytes;
+    op_info->offset = -1;
+
+    result = globus_l_xio_system_register_read_fd(fd, op_info);
+    if(result != GLOBUS_SUCCESS)
+    {
+        result = GlobusXIOErrorWrapFailed(
+            "globus_l_xio_system_register_read_fd", result);
+        goto error_register;
+    }
+
+    /* handle could be destroyed by time we get here - no touch! */
+    GlobusXIOSystemDebugExitFD(fd);
+    return GLOBUS_SUCCESS;
+
+error_register:
+    GlobusIXIOSystemFreeIovec(1, iov);
+
+error_iovec:
+    GlobusIXIOSystemFreeOperation(op_info);
+
+error_op_info:
+#ifdef HAVE_SPLICE
+error_pipe:
+#endif
+    GlobusXIOSystemDebugExitWithErrorFD(fd);
+    return result;
+}
+
 globus_result_t
 globus_xio_system_file_register_read(
     globus_xio_operation_t              op,
@@ -1738,6 +2905,14 @@ globus_l_xio_system_register_write(
     op_info->waitforbytes = waitforbytes;
     op_info->offset = offset;
     
+    if(handle->use_uring && (u_iovc > 1 || u_iov->iov_len > 0) &&
+        globus_l_xio_system_uring_submit(op_info) == 0)
+    {
+        /* handle could be destroyed by time we get here - no touch! */
+        GlobusXIOSystemDebugExitFD(fd);
+        return GLOBUS_SUCCESS;
+    }
+
     result = globus_l_xio_system_register_write_fd(fd, op_info);
     if(result != GLOBUS_SUCCESS)
     {
@@ -1810,6 +2985,89 @@ globus_xio_system_socket_register_write(
         user_arg);
 }
 
+globus_result_t
+globus_xio_system_socket_register_sendfile(
+    globus_xio_operation_t              op,
+    globus_xio_system_socket_handle_t   handle,
+    const globus_xio_iovec_t *          u_iov,
+    int                                 u_iovc,
+    globus_xio_system_file_t            file_fd,
+    globus_off_t                        file_offset,
+    globus_off_t                        file_length,
+    globus_xio_system_data_callback_t   callback,
+    void *                              user_arg)
+{
+    globus_result_t                     result;
+    globus_i_xio_system_op_info_t *     op_info;
+    struct iovec *                      iov;
+    globus_size_t                       iov_length;
+    int                                 fd = handle->fd;
+    GlobusXIOName(globus_xio_system_socket_register_sendfile);
+
+    GlobusXIOSystemDebugEnterFD(fd);
+    GlobusXIOSystemDebugPrintf(
+        GLOBUS_I_XIO_SYSTEM_DEBUG_DATA,
+        (_XIOSL("[%s] Sending %" GLOBUS_OFF_T_FORMAT " bytes from fd=%d\n"),
+            _xio_name, file_length, (int) file_fd));
+
+    GlobusIXIOSystemAllocOperation(op_info);
+    if(!op_info)
+    {
+        result = GlobusXIOErrorMemory("op_info");
+        goto error_op_info;
+    }
+
+    GlobusIXIOSystemAllocIovec(u_iovc, iov);
+    if(!iov)
+    {
+        result = GlobusXIOErrorMemory("iov");
+        goto error_iovec;
+    }
+
+    GlobusIXIOUtilTransferIovec(iov, u_iov, u_iovc);
+    GlobusXIOUtilIovTotalLength(iov_length, iov, u_iovc);
+
+    op_info->type = GLOBUS_I_XIO_SYSTEM_OP_WRITE;
+    op_info->sop.data.start_iov = iov;
+    op_info->sop.data.start_iovc = u_iovc;
+    op_info->sop.data.iov = iov;
+    /* an empty header goes straight to the file */
+    op_info->sop.data.iovc = iov_length > 0 ? u_iovc : 0;
+    op_info->sop.data.file_fd = file_fd;
+    op_info->sop.data.file_offset = file_offset;
+    op_info->sop.data.file_length = file_length;
+
+    op_info->state = GLOBUS_I_XIO_SYSTEM_OP_NEW;
+    op_info->op = op;
+    op_info->handle = handle;
+    op_info->user_arg = user_arg;
+    op_info->sop.data.callback = callback;
+    op_info->waitforbytes = iov_length + file_length;
+    op_info->offset = -1;
+
+    result = globus_l_xio_system_register_write_fd(fd, op_info);
+    if(result != GLOBUS_SUCCESS)
+    {
+        result = GlobusXIOErrorWrapFailed(
+            "globus_l_xio_system_register_write_fd", result);
+        goto error_register;
+    }
+
+    /* handle could be destroyed by time we get here - no touch! */
+    GlobusXIOSystemDebugExitFD(fd);
+    return GLOBUS_SUCCESS;
+
+error_register:
+    GlobusIXIOSystemFreeIovec(u_iovc, iov);
+
+error_iovec:
+    GlobusIXIOSystemFreeOperation(op_info);
+
+error_op_info:
+    GlobusXIOSystemDebugExitWithErrorFD(fd);
+    return result;
+}
+
 static
 globus_result_t
 globus_l_xio_system_try_read(
@@ -2133,6 +3391,21 @@ error_close:
     return result;
 }
 
+globus_size_t
+globus_xio_system_file_get_uring_ops(
+    globus_xio_system_file_handle_t     handle)
+{
+    globus_size_t                       ops;
+
+    globus_mutex_lock(&handle->lock);
+    {
+        ops = handle->uring_ops;
+    }
+    globus_mutex_unlock(&handle->lock);
+
+    return ops;
+}
+
 globus_off_t
 globus_xio_system_file_get_position(
     globus_xio_system_file_t            fd)
@@ -0,0 +1,384 @@
+/*
+ * Copyright 1999-2014 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "globus_common.h"
+#include "globus_xio.h"
+#include "globus_xio_file_driver.h"
+#include "globus_i_xio_config.h"
+#include <sys/wait.h>
+#ifdef HAVE_LINUX_IO_URING_H
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+
+/*
+ * This test program compares the file driver's data path with and without
+ * GLOBUS_XIO_SYSTEM_FILE_IO=uring.  For each mode, a child process:
+ *
+ * read test:
+ *     Reads a file of pseudo-random data with many reads outstanding at
+ *     once, each at its own offset on its own handle, and compares it with
+ *     the source.
+ * write test:
+ *     Writes the same data to a new file the same way and compares the
+ *     result with the source.
+ *
+ * backend test:
+ *     Checks which data path the handles used.  The poll mode must not use
+ *     io_uring, and the uring mode must if the kernel accepts
+ *     io_uring_setup().  Otherwise the uring mode exercises the fallback
+ *     path and must not claim to have used io_uring either.
+ *
+ * Finally the files written in both modes are compared with each other.
+ */
+#define FILE_URING_TEST_CHUNK   (64 * 1024 + 17)
+#define FILE_URING_TEST_CHUNKS  64
+#define FILE_URING_TEST_SIZE    (FILE_URING_TEST_CHUNK * FILE_URING_TEST_CHUNKS - 5)
+
+static globus_mutex_t                   file_uring_test_lock;
+static globus_cond_t                    file_uring_test_cond;
+static int                              file_uring_test_done;
+static globus_result_t                  file_uring_test_result;
+static globus_byte_t *                  file_uring_test_data;
+static globus_size_t                    file_uring_test_uring_ops;
+
+static
+globus_bool_t
+file_uring_test_kernel_has_uring(void)
+{
+#if defined(HAVE_LINUX_IO_URING_H) && defined(__NR_io_uring_setup)
+    struct io_uring_params              params;
+    int                                 fd;
+
+    memset(&params, 0, sizeof(params));
+    fd = syscall(__NR_io_uring_setup, 1, &params);
+    if(fd >= 0)
+    {
+        close(fd);
+        return GLOBUS_TRUE;
+    }
+#endif
+    return GLOBUS_FALSE;
+}
+
+static
+void
+file_uring_test_data_cb(
+    globus_xio_handle_t                 handle,
+    globus_result_t                     result,
+    globus_byte_t *                     buffer,
+    globus_size_t                       len,
+    globus_size_t                       nbytes,
+    globus_xio_data_descriptor_t        data_desc,
+    void *                              user_arg)
+{
+    globus_mutex_lock(&file_uring_test_lock);
+    {
+        if(result != GLOBUS_SUCCESS || nbytes != len)
+        {
+            file_uring_test_result = GLOBUS_FAILURE;
+        }
+        file_uring_test_done++;
+        globus_cond_signal(&file_uring_test_cond);
+    }
+    globus_mutex_unlock(&file_uring_test_lock);
+}
+
+static
+globus_result_t
+file_uring_test_transfer(
+    globus_xio_driver_t                 driver,
+    globus_xio_stack_t                  stack,
+    const char *                        filename,
+    globus_byte_t *                     buffer,
+    globus_bool_t                       do_write)
+{
+    globus_xio_handle_t                 handles[FILE_URING_TEST_CHUNKS];
+    globus_xio_attr_t                   attr;
+    globus_xio_data_descriptor_t        dd;
+    globus_result_t                     result = GLOBUS_SUCCESS;
+    globus_size_t                       len;
+    int                                 opened;
+    int                                 i;
+
+    /* the system layer allows one read and one write per fd at a time */
+    globus_xio_attr_init(&attr);
+    globus_xio_attr_cntl(
+        attr,
+        driver,
+        GLOBUS_XIO_FILE_SET_FLAGS,
+        do_write
+            ? GLOBUS_XIO_FILE_CREAT | GLOBUS_XIO_FILE_WRONLY
+            : GLOBUS_XIO_FILE_RDONLY);
+    for(opened = 0; opened < FILE_URING_TEST_CHUNKS; opened++)
+    {
+        result = globus_xio_handle_create(&handles[opened], stack);
+        if(result == GLOBUS_SUCCESS)
+        {
+            result = globus_xio_open(handles[opened], filename, attr);
+        }
+        if(result != GLOBUS_SUCCESS)
+        {
+            break;
+        }
+    }
+    globus_xio_attr_destroy(attr);
+
+    file_uring_test_done = 0;
+    file_uring_test_result = GLOBUS_SUCCESS;
+
+    /* every chunk in flight at once, last one first */
+    for(i = opened - 1; result == GLOBUS_SUCCESS && i >= 0; i--)
+    {
+        len = FILE_URING_TEST_CHUNK;
+        if(i == FILE_URING_TEST_CHUNKS - 1)
+        {
+            len = FILE_URING_TEST_SIZE - i * FILE_URING_TEST_CHUNK;
+        }
+
+        globus_xio_data_descriptor_init(&dd, handles[i]);
+        globus_xio_data_descriptor_cntl(
+            dd,
+            NULL,
+            GLOBUS_XIO_DD_SET_OFFSET,
+            (globus_off_t) i * FILE_URING_TEST_CHUNK);
+        if(do_write)
+        {
+            result = globus_xio_register_write(
+                handles[i], buffer + i * FILE_URING_TEST_CHUNK, len, len, dd,
+                file_uring_test_data_cb, NULL);
+        }
+        else
+        {
+            result = globus_xio_register_read(
+                handles[i], buffer + i * FILE_URING_TEST_CHUNK, len, len, dd,
+                file_uring_test_data_cb, NULL);
+        }
+        globus_xio_data_descriptor_destroy(dd);
+        if(result != GLOBUS_SUCCESS)
+        {
+            break;
+        }
+    }
+
+    globus_mutex_lock(&file_uring_test_lock);
+    {
+        while(file_uring_test_done < opened - 1 - i)
+        {
+            globus_cond_wait(&file_uring_test_cond, &file_uring_test_lock);
+        }
+        if(result == GLOBUS_SUCCESS)
+        {
+            result = file_uring_test_result;
+        }
+    }
+    globus_mutex_unlock(&file_uring_test_lock);
+
+    for(i = 0; i < opened; i++)
+    {
+        globus_size_t                   ops = 0;
+
+        globus_xio_handle_cntl(
+            handles[i], driver, GLOBUS_XIO_FILE_GET_URING_OPS, &ops);
+        file_uring_test_uring_ops += ops;
+        globus_xio_close(handles[i], NULL);
+    }
+
+    return result;
+}
+
+static
+int
+file_uring_test_compare(
+    const char *                        filename)
+{
+    globus_byte_t *                     buffer;
+    FILE *                              fp;
+    int                                 rc = 1;
+
+    buffer = malloc(FILE_URING_TEST_SIZE + 1);
+    fp = fopen(filename, "r");
+    if(fp && buffer &&
+        fread(buffer, 1, FILE_URING_TEST_SIZE + 1, fp) == FILE_URING_TEST_SIZE)
+    {
+        rc = memcmp(buffer, file_uring_test_data, FILE_URING_TEST_SIZE) != 0;
+    }
+    if(fp)
+    {
+        fclose(fp);
+    }
+    free(buffer);
+
+    return rc;
+}
+
+/* returns a bitmask of failed tests: 1 read, 2 write, 4 backend */
+static
+int
+file_uring_test_mode(
+    const char *                        mode,
+    const char *                        source,
+    const char *                        output)
+{
+    globus_xio_driver_t                 driver;
+    globus_xio_stack_t                  stack;
+    globus_byte_t *                     buffer;
+    int                                 failed = 0;
+
+    globus_thread_set_model("pthread");
+    globus_module_setenv("GLOBUS_XIO_SYSTEM_FILE_IO", mode);
+    if(globus_module_activate(GLOBUS_XIO_MODULE) != GLOBUS_SUCCESS)
+    {
+        return 7;
+    }
+    globus_mutex_init(&file_uring_test_lock, NULL);
+    globus_cond_init(&file_uring_test_cond, NULL);
+    globus_xio_driver_load("file", &driver);
+    globus_xio_stack_init(&stack, NULL);
+    globus_xio_stack_push_driver(stack, driver);
+
+    buffer = calloc(1, FILE_URING_TEST_SIZE);
+    if(file_uring_test_transfer(
+            driver, stack, source, buffer, GLOBUS_FALSE) != GLOBUS_SUCCESS ||
+        memcmp(buffer, file_uring_test_data, FILE_URING_TEST_SIZE) != 0)
+    {
+        failed |= 1;
+    }
+    free(buffer);
+
+    if(file_uring_test_transfer(
+            driver, stack, output, file_uring_test_data, GLOBUS_TRUE)
+                != GLOBUS_SUCCESS ||
+        file_uring_test_compare(output) != 0)
+    {
+        failed |= 2;
+    }
+
+    if((file_uring_test_uring_ops > 0) !=
+        (strcmp(mode, "uring") == 0 && file_uring_test_kernel_has_uring()))
+    {
+        printf("# %s mode: %lu requests completed by io_uring\n",
+            mode, (unsigned long) file_uring_test_uring_ops);
+        failed |= 4;
+    }
+
+    globus_xio_stack_destroy(stack);
+    globus_xio_driver_unload(driver);
+    globus_module_deactivate_all();
+
+    return failed;
+}
+
+int main()
+{
+    const char *                        modes[] = { "poll", "uring" };
+    char                                source[] = "file_uring_test.XXXXXX";
+    char                                outputs[2][64];
+    int                                 failed[2];
+    int                                 fd;
+    int                                 i;
+    int                                 xc = 0;
+    int                                 test = 1;
+    unsigned                            seed = 42;
+
+    printf("1..7\n");
+
+    file_uring_test_data = malloc(FILE_URING_TEST_SIZE);
+    for(i = 0; i < FILE_URING_TEST_SIZE; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        file_uring_test_data[i] = (globus_byte_t) (seed >> 16);
+    }
+
+    fd = mkstemp(source);
+    if(fd < 0 ||
+        write(fd, file_uring_test_data, FILE_URING_TEST_SIZE)
+            != FILE_URING_TEST_SIZE)
+    {
+        printf("Bail out! can't create %s\n", source);
+        return 99;
+    }
+    close(fd);
+
+    for(i = 0; i < 2; i++)
+    {
+        pid_t                           pid;
+        int                             status;
+
+        sprintf(outputs[i], "%s.%s", source, modes[i]);
+
+        /* the system layer picks its data path at activation */
+        fflush(stdout);
+        pid = fork();
+        if(pid == 0)
+        {
+            exit(file_uring_test_mode(modes[i], source, outputs[i]));
+        }
+        failed[i] = 7;
+        if(pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status))
+        {
+            failed[i] = WEXITSTATUS(status);
+        }
+
+        printf("%s %d - read_%s_test\n",
+            (failed[i] & 1) ? "not ok" : "ok", test++, modes[i]);
+        printf("%s %d - write_%s_test\n",
+            (failed[i] & 2) ? "not ok" : "ok", test++, modes[i]);
+        printf("%s %d - backend_%s_test\n",
+            (failed[i] & 4) ? "not ok" : "ok", test++, modes[i]);
+        xc += ((failed[i] & 1) != 0) + ((failed[i] & 2) != 0) +
+            ((failed[i] & 4) != 0);
+    }
+
+    /* the data path must not change a single byte */
+    free(file_uring_test_data);
+    file_uring_test_data = NULL;
+    {
+        FILE *                          fp[2];
+        int                             c[2];
+
+        fp[0] = fopen(outputs[0], "r");
+        fp[1] = fopen(outputs[1], "r");
+        failed[0] = !fp[0] || !fp[1];
+        while(!failed[0])
+        {
+            c[0] = getc(fp[0]);
+            c[1] = getc(fp[1]);
+            failed[0] = c[0] != c[1];
+            if(c[0] == EOF)
+            {
+                break;
+            }
+        }
+        if(fp[0])
+        {
+            fclose(fp[0]);
+        }
+        if(fp[1])
+        {
+            fclose(fp[1]);
+        }
+    }
+    printf("%s %d - uring_matches_poll_test\n",
+        failed[0] ? "not ok" : "ok", test++);
+    xc += failed[0];
+
+    remove(source);
+    remove(outputs[0]);
+    remove(outputs[1]);
+
+    return xc;
+}
@@ -0,0 +1,546 @@
+/*
+ * Copyright 1999-2014 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "globus_common.h"
+#include "globus_xio.h"
+#include "globus_xio_mode_e_driver.h"
+#include <sys/time.h>
+
+/*
+ * This test program sends data through the mode_e driver over loopback tcp
+ * and puts it back together on the receiving side by the offset each read
+ * reports.  For 1, 2 and 4 streams:
+ *
+ * small block test:
+ *     Writes blocks of 1 to 2000 bytes, so that many blocks arrive with each
+ *     read from the network, and reads them into 32 KB buffers.
+ * mixed block test:
+ *     Writes blocks of up to 256 KB mixed in with small ones, so that blocks
+ *     are read both straight into the reader's buffers and out of what came
+ *     in with the header, and reads them into 32 KB buffers.
+ *
+ * Each test checks that every byte arrives once, in the right place.  The
+ * time to send 4 KB blocks is then reported as a TAP comment; pass a size
+ * in MB to send more.
+ */
+#define MODE_E_TEST_SIZE                (4 * 1024 * 1024 + 13)
+#define MODE_E_TEST_READ_SIZE           (32 * 1024)
+#define MODE_E_TEST_BIG_BLOCK           (256 * 1024)
+#define MODE_E_TEST_WRITES              16
+#define MODE_E_TEST_BENCH_BLOCK         4096
+
+static globus_mutex_t                   mode_e_test_lock;
+static globus_cond_t                    mode_e_test_cond;
+static globus_xio_driver_t              mode_e_test_mode_e_driver;
+static globus_xio_driver_t              mode_e_test_tcp_driver;
+static globus_xio_stack_t               mode_e_test_stack;
+static globus_xio_stack_t               mode_e_test_tcp_stack;
+static unsigned                         mode_e_test_seed = 42;
+
+typedef struct
+{
+    globus_xio_handle_t                 handle;
+    globus_byte_t *                     data;
+    globus_size_t                       size;
+    globus_size_t                       max_block;
+    /* writer */
+    globus_size_t                       written;
+    int                                 writes;
+    /* reader */
+    globus_byte_t *                     received;
+    globus_size_t                       nbytes;
+    int                                 reads;
+    int                                 misplaced;
+    globus_bool_t                       eof;
+    globus_bool_t                       opened;
+    globus_result_t                     result;
+} mode_e_test_transfer_t;
+
+static
+globus_size_t
+mode_e_test_random(
+    globus_size_t                       limit)
+{
+    mode_e_test_seed = mode_e_test_seed * 1103515245 + 12345;
+    return (mode_e_test_seed >> 8) % limit;
+}
+
+static
+void
+mode_e_test_write_cb(
+    globus_xio_handle_t                 handle,
+    globus_result_t                     result,
+    globus_byte_t *                     buffer,
+    globus_size_t                       len,
+    globus_size_t                       nbytes,
+    globus_xio_data_descriptor_t        data_desc,
+    void *                              user_arg);
+
+/* called locked */
+static
+void
+mode_e_test_write_next(
+    mode_e_test_transfer_t *            transfer)
+{
+    globus_size_t                       len;
+    globus_result_t                     result;
+
+    while(transfer->result == GLOBUS_SUCCESS &&
+        transfer->writes < MODE_E_TEST_WRITES &&
+        transfer->written < transfer->size)
+    {
+        len = transfer->max_block;
+        if(len > MODE_E_TEST_BENCH_BLOCK)
+        {
+            /* a big block now and then among the small ones */
+            len = mode_e_test_random(4) == 0
+                ? 1 + mode_e_test_random(len)
+                : 1 + mode_e_test_random(2000);
+        }
+        else if(len < MODE_E_TEST_BENCH_BLOCK)
+        {
+            len = 1 + mode_e_test_random(len);
+        }
+        if(len > transfer->size - transfer->written)
+        {
+            len = transfer->size - transfer->written;
+        }
+
+        result = globus_xio_register_write(
+            transfer->handle,
+            transfer->data + transfer->written,
+            len,
+            len,
+            NULL,
+            mode_e_test_write_cb,
+            transfer);
+        if(result != GLOBUS_SUCCESS)
+        {
+            transfer->result = result;
+            break;
+        }
+        transfer->written += len;
+        transfer->writes++;
+    }
+}
+
+static
+void
+mode_e_test_write_cb(
+    globus_xio_handle_t                 handle,
+    globus_result_t                     result,
+    globus_byte_t *                     buffer,
+    globus_size_t                       len,
+    globus_size_t                       nbytes,
+    globus_xio_data_descriptor_t        data_desc,
+    void *                              user_arg)
+{
+    mode_e_test_transfer_t *            transfer;
+
+    transfer = (mode_e_test_transfer_t *) user_arg;
+    globus_mutex_lock(&mode_e_test_lock);
+    {
+        if(result != GLOBUS_SUCCESS || nbytes != len)
+        {
+            transfer->result = result ? result : GLOBUS_FAILURE;
+        }
+        transfer->writes--;
+        mode_e_test_write_next(transfer);
+        globus_cond_signal(&mode_e_test_cond);
+    }
+    globus_mutex_unlock(&mode_e_test_lock);
+}
+
+static
+void
+mode_e_test_read_cb(
+    globus_xio_handle_t                 handle,
+    globus_result_t                     result,
+    globus_byte_t *                     buffer,
+    globus_size_t                       len,
+    globus_size_t                       nbytes,
+    globus_xio_data_descriptor_t        data_desc,
+    void *                              user_arg);
+
+/* the offset of what was read comes back on the data descriptor */
+static
+globus_result_t
+mode_e_test_read(
+    mode_e_test_transfer_t *            transfer,
+    globus_byte_t *                     buffer)
+{
+    globus_xio_data_descriptor_t        dd;
+    globus_result_t                     result;
+
+    result = globus_xio_data_descriptor_init(&dd, transfer->handle);
+    if(result == GLOBUS_SUCCESS)
+    {
+        result = globus_xio_register_read(
+            transfer->handle,
+            buffer,
+            MODE_E_TEST_READ_SIZE,
+            1,
+            dd,
+            mode_e_test_read_cb,
+            transfer);
+        globus_xio_data_descriptor_destroy(dd);
+    }
+
+    return result;
+}
+
+static
+void
+mode_e_test_read_cb(
+    globus_xio_handle_t                 handle,
+    globus_result_t                     result,
+    globus_byte_t *                     buffer,
+    globus_size_t                       len,
+    globus_size_t                       nbytes,
+    globus_xio_data_descriptor_t        data_desc,
+    void *                              user_arg)
+{
+    mode_e_test_transfer_t *            transfer;
+    globus_off_t                        offset = -1;
+    globus_bool_t                       eof = GLOBUS_FALSE;
+
+    transfer = (mode_e_test_transfer_t *) user_arg;
+    if(result != GLOBUS_SUCCESS)
+    {
+        eof = globus_xio_error_is_eof(result);
+    }
+    globus_xio_data_descriptor_cntl(
+        data_desc, NULL, GLOBUS_XIO_DD_GET_OFFSET, &offset);
+
+    globus_mutex_lock(&mode_e_test_lock);
+    {
+        if(nbytes > 0)
+        {
+            if(offset < 0 || offset + nbytes > transfer->size)
+            {
+                transfer->misplaced++;
+            }
+            else
+            {
+                memcpy(transfer->received + offset, buffer, nbytes);
+                transfer->nbytes += nbytes;
+            }
+        }
+        if(eof)
+        {
+            transfer->eof = GLOBUS_TRUE;
+        }
+        else if(result != GLOBUS_SUCCESS)
+        {
+            transfer->result = result;
+        }
+
+        if(result == GLOBUS_SUCCESS)
+        {
+            result = mode_e_test_read(transfer, buffer);
+        }
+        if(result != GLOBUS_SUCCESS)
+        {
+            if(!eof)
+            {
+                transfer->result = result;
+            }
+            free(buffer);
+            transfer->reads--;
+            globus_cond_signal(&mode_e_test_cond);
+        }
+    }
+    globus_mutex_unlock(&mode_e_test_lock);
+}
+
+static
+void
+mode_e_test_accept_cb(
+    globus_xio_server_t                 server,
+    globus_xio_handle_t                 handle,
+    globus_result_t                     result,
+    void *                              user_arg)
+{
+    mode_e_test_transfer_t *            transfer;
+
+    transfer = (mode_e_test_transfer_t *) user_arg;
+    globus_mutex_lock(&mode_e_test_lock);
+    {
+        transfer->handle = handle;
+        transfer->result = result;
+        transfer->opened = GLOBUS_TRUE;
+        globus_cond_signal(&mode_e_test_cond);
+    }
+    globus_mutex_unlock(&mode_e_test_lock);
+}
+
+static
+void
+mode_e_test_open_cb(
+    globus_xio_handle_t                 handle,
+    globus_result_t                     result,
+    void *                              user_arg)
+{
+    mode_e_test_transfer_t *            transfer;
+
+    transfer = (mode_e_test_transfer_t *) user_arg;
+    globus_mutex_lock(&mode_e_test_lock);
+    {
+        transfer->result = result;
+        transfer->opened = GLOBUS_TRUE;
+        globus_cond_signal(&mode_e_test_cond);
+    }
+    globus_mutex_unlock(&mode_e_test_lock);
+}
+
+static
+globus_result_t
+mode_e_test_wait_open(
+    mode_e_test_transfer_t *            transfer)
+{
+    globus_result_t                     result;
+
+    globus_mutex_lock(&mode_e_test_lock);
+    {
+        while(!transfer->opened)
+        {
+            globus_cond_wait(&mode_e_test_cond, &mode_e_test_lock);
+        }
+        transfer->opened = GLOBUS_FALSE;
+        result = transfer->result;
+    }
+    globus_mutex_unlock(&mode_e_test_lock);
+
+    return result;
+}
+
+/* returns 0 if all of data made it across */
+static
+int
+mode_e_test_transfer(
+    globus_byte_t *                     data,
+    globus_size_t                       size,
+    globus_size_t                       max_block,
+    int                                 streams,
+    double *                            elapsed)
+{
+    mode_e_test_transfer_t              writer;
+    mode_e_test_transfer_t              reader;
+    globus_xio_server_t                 server;
+    globus_xio_attr_t                   attr;
+    globus_byte_t *                     buffer;
+    struct timeval                      start;
+    struct timeval                      end;
+    char *                              contact;
+    globus_result_t                     result;
+    int                                 i;
+    int                                 failed = 1;
+
+    memset(&writer, 0, sizeof(writer));
+    memset(&reader, 0, sizeof(reader));
+    writer.data = data;
+    writer.size = size;
+    writer.max_block = max_block;
+    reader.size = size;
+    reader.received = calloc(1, size);
+
+    globus_xio_attr_init(&attr);
+    globus_xio_attr_cntl(
+        attr,
+        mode_e_test_mode_e_driver,
+        GLOBUS_XIO_MODE_E_SET_STACK,
+        mode_e_test_tcp_stack);
+    globus_xio_attr_cntl(
+        attr,
+        mode_e_test_mode_e_driver,
+        GLOBUS_XIO_MODE_E_SET_NUM_STREAMS,
+        streams);
+
+    result = globus_xio_server_create(&server, attr, mode_e_test_stack);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error_server;
+    }
+    globus_xio_server_get_contact_string(server, &contact);
+    globus_xio_handle_create(&writer.handle, mode_e_test_stack);
+
+    result = globus_xio_server_register_accept(
+        server, mode_e_test_accept_cb, &reader);
+    if(result != GLOBUS_SUCCESS ||
+        globus_xio_register_open(
+            writer.handle, contact, attr, mode_e_test_open_cb, &writer) !=
+                GLOBUS_SUCCESS ||
+        mode_e_test_wait_open(&reader) != GLOBUS_SUCCESS ||
+        globus_xio_register_open(
+            reader.handle, NULL, attr, mode_e_test_open_cb, &reader) !=
+                GLOBUS_SUCCESS ||
+        mode_e_test_wait_open(&reader) != GLOBUS_SUCCESS ||
+        mode_e_test_wait_open(&writer) != GLOBUS_SUCCESS)
+    {
+        goto error_open;
+    }
+
+    gettimeofday(&start, NULL);
+    globus_mutex_lock(&mode_e_test_lock);
+    {
+        for(i = 0; i < streams; i++)
+        {
+            buffer = malloc(MODE_E_TEST_READ_SIZE);
+            if(mode_e_test_read(&reader, buffer) != GLOBUS_SUCCESS)
+            {
+                free(buffer);
+                reader.result = GLOBUS_FAILURE;
+                break;
+            }
+            reader.reads++;
+        }
+        mode_e_test_write_next(&writer);
+        while(writer.result == GLOBUS_SUCCESS &&
+            (writer.writes > 0 || writer.written < writer.size))
+        {
+            globus_cond_wait(&mode_e_test_cond, &mode_e_test_lock);
+        }
+    }
+    globus_mutex_unlock(&mode_e_test_lock);
+
+    /* closing the writer sends the eof */
+    globus_xio_close(writer.handle, NULL);
+
+    globus_mutex_lock(&mode_e_test_lock);
+    {
+        while(reader.reads > 0)
+        {
+            globus_cond_wait(&mode_e_test_cond, &mode_e_test_lock);
+        }
+    }
+    globus_mutex_unlock(&mode_e_test_lock);
+    gettimeofday(&end, NULL);
+    *elapsed = (end.tv_sec - start.tv_sec) +
+        (end.tv_usec - start.tv_usec) / 1000000.0;
+
+    globus_xio_close(reader.handle, NULL);
+
+    failed = writer.result != GLOBUS_SUCCESS ||
+        reader.result != GLOBUS_SUCCESS ||
+        !reader.eof ||
+        reader.misplaced != 0 ||
+        reader.nbytes != size ||
+        memcmp(reader.received, data, size) != 0;
+
+error_open:
+    globus_xio_server_close(server);
+    globus_free(contact);
+error_server:
+    globus_xio_attr_destroy(attr);
+    free(reader.received);
+
+    return failed;
+}
+
+int
+main(
+    int                                 argc,
+    char *                              argv[])
+{
+    globus_byte_t *                     data;
+    globus_size_t                       bench_size = 64 * 1024 * 1024;
+    double                              elapsed;
+    int                                 streams;
+    int                                 i;
+    int                                 xc = 0;
+    int                                 test = 1;
+
+    if(argc > 1)
+    {
+        bench_size = (globus_size_t) atoi(argv[1]) * 1024 * 1024;
+    }
+
+    printf("1..9\n");
+
+    globus_thread_set_model("pthread");
+    if(globus_module_activate(GLOBUS_XIO_MODULE) != GLOBUS_SUCCESS)
+    {
+        printf("Bail out! can't activate xio\n");
+        return 99;
+    }
+    globus_mutex_init(&mode_e_test_lock, NULL);
+    globus_cond_init(&mode_e_test_cond, NULL);
+    if(globus_xio_driver_load("mode_e", &mode_e_test_mode_e_driver) !=
+            GLOBUS_SUCCESS ||
+        globus_xio_driver_load("tcp", &mode_e_test_tcp_driver) !=
+            GLOBUS_SUCCESS)
+    {
+        printf("Bail out! can't load drivers\n");
+        return 99;
+    }
+    globus_xio_stack_init(&mode_e_test_stack, NULL);
+    globus_xio_stack_push_driver(mode_e_test_stack, mode_e_test_mode_e_driver);
+    globus_xio_stack_init(&mode_e_test_tcp_stack, NULL);
+    globus_xio_stack_push_driver(mode_e_test_tcp_stack, mode_e_test_tcp_driver);
+
+    if(bench_size < MODE_E_TEST_SIZE)
+    {
+        bench_size = MODE_E_TEST_SIZE;
+    }
+    data = malloc(bench_size);
+    for(i = 0; i < bench_size; i++)
+    {
+        data[i] = (globus_byte_t) mode_e_test_random(256);
+    }
+
+    for(streams = 1; streams <= 4; streams *= 2)
+    {
+        int                             failed;
+
+        failed = mode_e_test_transfer(
+            data, MODE_E_TEST_SIZE, 2000, streams, &elapsed);
+        printf("%s %d - small_blocks_%d_streams_test\n",
+            failed ? "not ok" : "ok", test++, streams);
+        xc += failed;
+
+        failed = mode_e_test_transfer(
+            data, MODE_E_TEST_SIZE, MODE_E_TEST_BIG_BLOCK, streams, &elapsed);
+        printf("%s %d - mixed_blocks_%d_streams_test\n",
+            failed ? "not ok" : "ok", test++, streams);
+        xc += failed;
+    }
+
+    for(streams = 1; streams <= 4; streams *= 2)
+    {
+        int                             failed;
+
+        failed = mode_e_test_transfer(
+            data, bench_size, MODE_E_TEST_BENCH_BLOCK, streams, &elapsed);
+        printf("# %d streams, %d byte blocks: %.1f MB/s\n",
+            streams,
+            MODE_E_TEST_BENCH_BLOCK,
+            bench_size / (elapsed > 0 ? elapsed : 1e-6) / (1024 * 1024));
+        printf("%s %d - bench_%d_streams_test\n",
+            failed ? "not ok" : "ok", test++, streams);
+        xc += failed;
+    }
+
+    free(data);
+    globus_xio_stack_destroy(mode_e_test_stack);
+    globus_xio_stack_destroy(mode_e_test_tcp_stack);
+    globus_xio_driver_unload(mode_e_test_mode_e_driver);
+    globus_xio_driver_unload(mode_e_test_tcp_driver);
+    globus_mutex_destroy(&mode_e_test_lock);
+    globus_cond_destroy(&mode_e_test_cond);
+    globus_module_deactivate_all();
+
+    return xc;
+}
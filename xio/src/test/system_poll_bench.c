@@ -0,0 +1,381 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file system_poll_bench.c
+ * @brief XIO System Poll Benchmark
+ *
+ * Compare the select and epoll backends of the XIO system layer.  For each
+ * fd count, a pipe is opened per fd and a 1 byte read is kept registered on
+ * the read end of every pipe through the file driver.  Most of the fds stay
+ * idle; a small active set is written to and the time and CPU it takes for
+ * the read callbacks to be delivered is measured.
+ *
+ * Parameters are
+ * - -n count[,count...]<br>
+ *   fd counts to test (default 1000,10000,50000)
+ * - -a active<br>
+ *   number of active fds (default 16)
+ * - -i iterations<br>
+ *   number of latency samples and bursts per fd count (default 1000)
+ * - -m method[,method...]<br>
+ *   backends to compare (default select,epoll)
+ *
+ * Each backend is run in its own process, since the backend is chosen when
+ * the system layer is activated.  Counts that the fd limit or FD_SETSIZE
+ * (select) can't accommodate are reported as skipped.  Set
+ * GLOBUS_XIO_SYSTEM_REACTORS (and GLOBUS_THREAD_MODEL) in the environment to
+ * spread the epoll runs over several reactor threads.
+ */
+
+#include "globus_xio.h"
+#include "globus_xio_file_driver.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/select.h>
+#include <sys/wait.h>
+
+typedef struct
+{
+    globus_xio_handle_t                 handle;
+    int                                 read_fd;
+    int                                 write_fd;
+    globus_byte_t                       byte;
+} poll_bench_fd_t;
+
+static globus_mutex_t                   poll_bench_lock;
+static globus_cond_t                    poll_bench_cond;
+static int                              poll_bench_events;
+static int                              poll_bench_closed;
+static globus_xio_driver_t              poll_bench_driver;
+static globus_xio_stack_t               poll_bench_stack;
+
+static
+double
+poll_bench_now(void)
+{
+    struct timeval                      tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+static
+double
+poll_bench_cpu(void)
+{
+    struct rusage                       usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec * 1e6 + usage.ru_utime.tv_usec +
+        usage.ru_stime.tv_sec * 1e6 + usage.ru_stime.tv_usec;
+}
+
+static
+void
+poll_bench_read_cb(
+    globus_xio_handle_t                 handle,
+    globus_result_t                     result,
+    globus_byte_t *                     buffer,
+    globus_size_t                       len,
+    globus_size_t                       nbytes,
+    globus_xio_data_descriptor_t        data_desc,
+    void *                              user_arg)
+{
+    poll_bench_fd_t *                   bench_fd = user_arg;
+
+    if(result == GLOBUS_SUCCESS)
+    {
+        result = globus_xio_register_read(
+            handle, &bench_fd->byte, 1, 1, NULL,
+            poll_bench_read_cb, bench_fd);
+    }
+
+    globus_mutex_lock(&poll_bench_lock);
+    {
+        if(result == GLOBUS_SUCCESS)
+        {
+            poll_bench_events++;
+        }
+        else
+        {
+            poll_bench_closed++;
+        }
+        globus_cond_signal(&poll_bench_cond);
+    }
+    globus_mutex_unlock(&poll_bench_lock);
+}
+
+static
+void
+poll_bench_wait(
+    int *                               counter,
+    int                                 count)
+{
+    globus_mutex_lock(&poll_bench_lock);
+    {
+        while(*counter < count)
+        {
+            globus_cond_wait(&poll_bench_cond, &poll_bench_lock);
+        }
+    }
+    globus_mutex_unlock(&poll_bench_lock);
+}
+
+static
+int
+poll_bench_run(
+    const char *                        method,
+    int                                 count,
+    int                                 active,
+    int                                 iterations)
+{
+    poll_bench_fd_t *                   fds;
+    globus_xio_attr_t                   attr;
+    globus_result_t                     result;
+    int                                 pipe_fds[2];
+    int                                 opened;
+    int                                 highest = 0;
+    int                                 i;
+    double                              start;
+    double                              latency;
+    double                              elapsed;
+    double                              cpu;
+    char                                byte = 0;
+
+    fds = calloc(count, sizeof(poll_bench_fd_t));
+    for(opened = 0; opened < count; opened++)
+    {
+        if(pipe(pipe_fds) != 0)
+        {
+            break;
+        }
+        fds[opened].read_fd = pipe_fds[0];
+        fds[opened].write_fd = pipe_fds[1];
+        if(pipe_fds[0] > highest)
+        {
+            highest = pipe_fds[0];
+        }
+    }
+
+    if(opened < count ||
+        (strcmp(method, "select") == 0 && highest >= FD_SETSIZE))
+    {
+        printf("%-8s %8d %8d   skipped (%s)\n", method, count, active,
+            opened < count ? "fd limit" : "FD_SETSIZE");
+        for(i = 0; i < opened; i++)
+        {
+            close(fds[i].read_fd);
+            close(fds[i].write_fd);
+        }
+        free(fds);
+        return 0;
+    }
+
+    for(i = 0; i < count; i++)
+    {
+        globus_xio_attr_init(&attr);
+        globus_xio_attr_cntl(
+            attr,
+            poll_bench_driver,
+            GLOBUS_XIO_FILE_SET_HANDLE,
+            fds[i].read_fd);
+        result = globus_xio_handle_create(&fds[i].handle, poll_bench_stack);
+        if(result == GLOBUS_SUCCESS)
+        {
+            result = globus_xio_open(fds[i].handle, NULL, attr);
+        }
+        if(result == GLOBUS_SUCCESS)
+        {
+            result = globus_xio_register_read(
+                fds[i].handle, &fds[i].byte, 1, 1, NULL,
+                poll_bench_read_cb, &fds[i]);
+        }
+        globus_xio_attr_destroy(attr);
+        if(result != GLOBUS_SUCCESS)
+        {
+            fprintf(stderr, "setup failed: %s\n",
+                globus_error_print_friendly(globus_error_peek(result)));
+            return 1;
+        }
+    }
+
+    poll_bench_events = 0;
+    poll_bench_closed = 0;
+
+    /* wakeup latency: one active fd at a time */
+    start = poll_bench_now();
+    for(i = 0; i < iterations; i++)
+    {
+        write(fds[i % active].write_fd, &byte, 1);
+        poll_bench_wait(&poll_bench_events, i + 1);
+    }
+    latency = (poll_bench_now() - start) / iterations;
+
+    /* bursts: every active fd at once */
+    poll_bench_events = 0;
+    cpu = poll_bench_cpu();
+    start = poll_bench_now();
+    for(i = 0; i < iterations; i++)
+    {
+        int                             j;
+
+        for(j = 0; j < active; j++)
+        {
+            write(fds[j].write_fd, &byte, 1);
+        }
+        poll_bench_wait(&poll_bench_events, (i + 1) * active);
+    }
+    elapsed = poll_bench_now() - start;
+    cpu = poll_bench_cpu() - cpu;
+
+    printf("%-8s %8d %8d %12.2f %12.0f %12.2f\n",
+        method, count, active, latency,
+        (double) iterations * active / (elapsed / 1e6),
+        cpu / ((double) iterations * active));
+    fflush(stdout);
+
+    /* EOF completes the outstanding reads */
+    for(i = 0; i < count; i++)
+    {
+        close(fds[i].write_fd);
+    }
+    poll_bench_wait(&poll_bench_closed, count);
+    for(i = 0; i < count; i++)
+    {
+        globus_xio_close(fds[i].handle, NULL);
+        close(fds[i].read_fd);
+    }
+    free(fds);
+
+    return 0;
+}
+
+static
+int
+poll_bench_method(
+    const char *                        method,
+    char *                              counts,
+    int                                 active,
+    int                                 iterations)
+{
+    struct rlimit                       limit;
+    char *                              count;
+    int                                 rc = 0;
+
+    /* the system layer sizes its tables from the limit at activation */
+    if(getrlimit(RLIMIT_NOFILE, &limit) == 0)
+    {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    globus_module_setenv("GLOBUS_XIO_SYSTEM_POLL", method);
+    globus_module_activate(GLOBUS_XIO_MODULE);
+    globus_mutex_init(&poll_bench_lock, NULL);
+    globus_cond_init(&poll_bench_cond, NULL);
+    globus_xio_driver_load("file", &poll_bench_driver);
+    globus_xio_stack_init(&poll_bench_stack, NULL);
+    globus_xio_stack_push_driver(poll_bench_stack, poll_bench_driver);
+
+    for(count = strtok(counts, ","); count && rc == 0;
+        count = strtok(NULL, ","))
+    {
+        int                             n = atoi(count);
+
+        rc = poll_bench_run(
+            method, n, active < n ? active : n, iterations);
+    }
+
+    globus_xio_stack_destroy(poll_bench_stack);
+    globus_xio_driver_unload(poll_bench_driver);
+    globus_module_deactivate_all();
+
+    return rc;
+}
+
+int
+main(
+    int                                 argc,
+    char **                             argv)
+{
+    char *                              counts = "1000,10000,50000";
+    char *                              methods = "select,epoll";
+    char *                              method;
+    int                                 active = 16;
+    int                                 iterations = 1000;
+    int                                 rc = 0;
+    int                                 c;
+
+    while((c = getopt(argc, argv, "n:a:i:m:h")) != -1)
+    {
+        switch(c)
+        {
+          case 'n':
+            counts = optarg;
+            break;
+          case 'a':
+            active = atoi(optarg);
+            break;
+          case 'i':
+            iterations = atoi(optarg);
+            break;
+          case 'm':
+            methods = optarg;
+            break;
+          default:
+            fprintf(stderr, "Usage: %s [-n count[,count...]] [-a active] "
+                "[-i iterations] [-m method[,method...]]\n", argv[0]);
+            return 1;
+        }
+    }
+    if(active < 1 || iterations < 1)
+    {
+        fprintf(stderr, "active and iterations must be positive\n");
+        return 1;
+    }
+
+    printf("%-8s %8s %8s %12s %12s %12s\n",
+        "method", "fds", "active", "latency(us)", "events/s", "cpu/event(us)");
+    fflush(stdout);
+
+    methods = strdup(methods);
+    for(method = strtok(methods, ","); method; method = strtok(NULL, ","))
+    {
+        pid_t                           pid;
+        int                             status;
+
+        pid = fork();
+        if(pid == 0)
+        {
+            exit(poll_bench_method(method, strdup(counts), active, iterations));
+        }
+        else if(pid < 0 || waitpid(pid, &status, 0) < 0 ||
+            !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            fprintf(stderr, "%s run failed\n", method);
+            rc = 1;
+        }
+    }
+    free(methods);
+
+    return rc;
+}
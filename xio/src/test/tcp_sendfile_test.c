@@ -0,0 +1,573 @@
+/*
+ * Copyright 1999-2014 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "globus_common.h"
+#include "globus_xio.h"
+#include "globus_xio_tcp_driver.h"
+#include <sys/time.h>
+
+/*
+ * This test program sends parts of a file over loopback tcp with
+ * GLOBUS_XIO_TCP_SET_SENDFILE and checks what arrives on the other side:
+ *
+ * header test:
+ *     Sends blocks of random size from random offsets, each behind a small
+ *     header naming its offset and length, the way mode E frames data.
+ * file only test:
+ *     Sends the whole file with an empty write buffer, large enough that the
+ *     socket fills up and the send has to wait for the reader.
+ * short file test:
+ *     Asks for a range that runs past the end of the file and expects the
+ *     write to fail.
+ *
+ * The time to send the file in 256 KB blocks with sendfile and with plain
+ * writes is then reported as a TAP comment; pass a size in MB to send more.
+ */
+#define TCP_SENDFILE_TEST_SIZE          (8 * 1024 * 1024 + 7)
+#define TCP_SENDFILE_TEST_MAX_BLOCK     (512 * 1024)
+#define TCP_SENDFILE_TEST_BLOCKS        64
+#define TCP_SENDFILE_TEST_BENCH_BLOCK   (256 * 1024)
+
+typedef struct
+{
+    globus_off_t                        offset;
+    globus_off_t                        length;
+} tcp_sendfile_test_block_t;
+
+typedef struct
+{
+    globus_xio_handle_t                 handle;
+    tcp_sendfile_test_block_t *         blocks;
+    int                                 block_count;
+    int                                 next;
+    globus_bool_t                       use_sendfile;
+    /* header of the block in flight */
+    globus_byte_t                       header[16];
+    globus_size_t                       header_len;
+    globus_byte_t *                     buffer;
+    globus_size_t                       nbytes;
+    globus_bool_t                       done;
+    globus_result_t                     result;
+} tcp_sendfile_test_sender_t;
+
+static globus_mutex_t                   tcp_sendfile_test_lock;
+static globus_cond_t                    tcp_sendfile_test_cond;
+static globus_xio_driver_t              tcp_sendfile_test_driver;
+static globus_xio_stack_t               tcp_sendfile_test_stack;
+static globus_byte_t *                  tcp_sendfile_test_data;
+static globus_size_t                    tcp_sendfile_test_size;
+static int                              tcp_sendfile_test_fd = -1;
+static unsigned                         tcp_sendfile_test_seed = 42;
+
+static
+globus_size_t
+tcp_sendfile_test_random(
+    globus_size_t                       limit)
+{
+    tcp_sendfile_test_seed = tcp_sendfile_test_seed * 1103515245 + 12345;
+    return (tcp_sendfile_test_seed >> 8) % limit;
+}
+
+static
+void
+tcp_sendfile_test_encode(
+    globus_byte_t *                     buf,
+    globus_off_t                        value)
+{
+    int                                 i;
+
+    for(i = 7; i >= 0; i--)
+    {
+        buf[i] = (globus_byte_t) value;
+        value >>= 8;
+    }
+}
+
+static
+globus_off_t
+tcp_sendfile_test_decode(
+    const globus_byte_t *               buf)
+{
+    globus_off_t                        value = 0;
+    int                                 i;
+
+    for(i = 0; i < 8; i++)
+    {
+        value = (value << 8) | buf[i];
+    }
+
+    return value;
+}
+
+static
+void
+tcp_sendfile_test_write_cb(
+    globus_xio_handle_t                 handle,
+    globus_result_t                     result,
+    globus_byte_t *                     buffer,
+    globus_size_t                       len,
+    globus_size_t                       nbytes,
+    globus_xio_data_descriptor_t        data_desc,
+    void *                              user_arg);
+
+/* called locked */
+static
+void
+tcp_sendfile_test_send_next(
+    tcp_sendfile_test_sender_t *        sender)
+{
+    tcp_sendfile_test_block_t *         block;
+    globus_xio_data_descriptor_t        dd = NULL;
+    globus_result_t                     result;
+    globus_byte_t *                     buf;
+    globus_size_t                       len;
+
+    if(sender->result != GLOBUS_SUCCESS ||
+        sender->next == sender->block_count)
+    {
+        sender->done = GLOBUS_TRUE;
+        globus_cond_signal(&tcp_sendfile_test_cond);
+        return;
+    }
+
+    block = &sender->blocks[sender->next++];
+    buf = sender->header;
+    len = sender->header_len;
+    if(len > 0)
+    {
+        tcp_sendfile_test_encode(sender->header, block->offset);
+        tcp_sendfile_test_encode(sender->header + 8, block->length);
+    }
+
+    if(sender->use_sendfile)
+    {
+        globus_xio_data_descriptor_init(&dd, sender->handle);
+        globus_xio_data_descriptor_cntl(
+            dd,
+            tcp_sendfile_test_driver,
+            GLOBUS_XIO_TCP_SET_SENDFILE,
+            tcp_sendfile_test_fd,
+            block->offset,
+            block->length);
+    }
+    else
+    {
+        /* what a buffered sender does: read the block, then write it */
+        len = block->length;
+        buf = sender->buffer;
+        if(pread(tcp_sendfile_test_fd, buf, len, block->offset) != len)
+        {
+            sender->result = GLOBUS_FAILURE;
+            sender->done = GLOBUS_TRUE;
+            globus_cond_signal(&tcp_sendfile_test_cond);
+            return;
+        }
+    }
+
+    result = globus_xio_register_write(
+        sender->handle,
+        buf,
+        len,
+        len,
+        dd,
+        tcp_sendfile_test_write_cb,
+        sender);
+    if(dd)
+    {
+        globus_xio_data_descriptor_destroy(dd);
+    }
+    if(result != GLOBUS_SUCCESS)
+    {
+        sender->result = result;
+        sender->done = GLOBUS_TRUE;
+        globus_cond_signal(&tcp_sendfile_test_cond);
+    }
+}
+
+static
+void
+tcp_sendfile_test_write_cb(
+    globus_xio_handle_t                 handle,
+    globus_result_t                     result,
+    globus_byte_t *                     buffer,
+    globus_size_t                       len,
+    globus_size_t                       nbytes,
+    globus_xio_data_descriptor_t        data_desc,
+    void *                              user_arg)
+{
+    tcp_sendfile_test_sender_t *        sender;
+    tcp_sendfile_test_block_t *         block;
+
+    sender = (tcp_sendfile_test_sender_t *) user_arg;
+
+    globus_mutex_lock(&tcp_sendfile_test_lock);
+    {
+        block = &sender->blocks[sender->next - 1];
+        if(result == GLOBUS_SUCCESS && sender->use_sendfile &&
+            nbytes != len + block->length)
+        {
+            result = GLOBUS_FAILURE;
+        }
+        if(result != GLOBUS_SUCCESS)
+        {
+            sender->result = result;
+        }
+        else
+        {
+            sender->nbytes += nbytes;
+        }
+        tcp_sendfile_test_send_next(sender);
+    }
+    globus_mutex_unlock(&tcp_sendfile_test_lock);
+}
+
+static
+globus_result_t
+tcp_sendfile_test_connect(
+    globus_xio_handle_t *               reader,
+    globus_xio_handle_t *               writer)
+{
+    globus_xio_server_t                 server;
+    globus_result_t                     result;
+    char *                              contact;
+
+    result = globus_xio_server_create(
+        &server, NULL, tcp_sendfile_test_stack);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error_server;
+    }
+    globus_xio_server_get_contact_string(server, &contact);
+
+    result = globus_xio_handle_create(writer, tcp_sendfile_test_stack);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error_handle;
+    }
+    result = globus_xio_open(*writer, contact, NULL);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error_open;
+    }
+    result = globus_xio_server_accept(reader, server);
+    if(result == GLOBUS_SUCCESS)
+    {
+        result = globus_xio_open(*reader, NULL, NULL);
+    }
+    if(result != GLOBUS_SUCCESS)
+    {
+        globus_xio_close(*writer, NULL);
+    }
+
+error_open:
+error_handle:
+    globus_free(contact);
+    globus_xio_server_close(server);
+error_server:
+    return result;
+}
+
+/*
+ * sends the blocks and reads them back.  returns 0 on success, and the
+ * time the reader took in *elapsed if it is not NULL
+ */
+static
+int
+tcp_sendfile_test_transfer(
+    tcp_sendfile_test_block_t *         blocks,
+    int                                 block_count,
+    globus_size_t                       header_len,
+    globus_bool_t                       use_sendfile,
+    double *                            elapsed)
+{
+    tcp_sendfile_test_sender_t          sender;
+    globus_xio_handle_t                 reader;
+    globus_byte_t                       header[16];
+    globus_byte_t *                     buffer;
+    globus_off_t                        offset;
+    globus_off_t                        length;
+    globus_size_t                       nbytes;
+    globus_result_t                     result;
+    struct timeval                      start;
+    struct timeval                      end;
+    int                                 errors = 0;
+    int                                 i;
+
+    memset(&sender, 0, sizeof(sender));
+    sender.blocks = blocks;
+    sender.block_count = block_count;
+    sender.header_len = header_len;
+    sender.use_sendfile = use_sendfile;
+    sender.buffer = malloc(TCP_SENDFILE_TEST_MAX_BLOCK);
+    buffer = malloc(TCP_SENDFILE_TEST_MAX_BLOCK);
+    if(!sender.buffer || !buffer ||
+        tcp_sendfile_test_connect(&reader, &sender.handle) != GLOBUS_SUCCESS)
+    {
+        free(sender.buffer);
+        free(buffer);
+        return 1;
+    }
+
+    gettimeofday(&start, NULL);
+    globus_mutex_lock(&tcp_sendfile_test_lock);
+    {
+        tcp_sendfile_test_send_next(&sender);
+    }
+    globus_mutex_unlock(&tcp_sendfile_test_lock);
+
+    for(i = 0; i < block_count && !errors; i++)
+    {
+        offset = blocks[i].offset;
+        length = blocks[i].length;
+        if(header_len > 0)
+        {
+            result = globus_xio_read(
+                reader, header, header_len, header_len, &nbytes, NULL);
+            if(result != GLOBUS_SUCCESS ||
+                tcp_sendfile_test_decode(header) != offset ||
+                tcp_sendfile_test_decode(header + 8) != length)
+            {
+                errors++;
+                break;
+            }
+        }
+
+        while(length > 0)
+        {
+            globus_size_t               len = TCP_SENDFILE_TEST_MAX_BLOCK;
+
+            if(len > length)
+            {
+                len = length;
+            }
+            result = globus_xio_read(reader, buffer, len, len, &nbytes, NULL);
+            if(result != GLOBUS_SUCCESS ||
+                memcmp(buffer, tcp_sendfile_test_data + offset, len) != 0)
+            {
+                errors++;
+                break;
+            }
+            offset += len;
+            length -= len;
+        }
+    }
+    gettimeofday(&end, NULL);
+    if(elapsed)
+    {
+        *elapsed = (end.tv_sec - start.tv_sec) +
+            (end.tv_usec - start.tv_usec) / 1000000.0;
+    }
+
+    globus_mutex_lock(&tcp_sendfile_test_lock);
+    {
+        while(!sender.done)
+        {
+            globus_cond_wait(&tcp_sendfile_test_cond, &tcp_sendfile_test_lock);
+        }
+    }
+    globus_mutex_unlock(&tcp_sendfile_test_lock);
+    errors += sender.result != GLOBUS_SUCCESS;
+
+    globus_xio_close(sender.handle, NULL);
+    globus_xio_close(reader, NULL);
+    free(sender.buffer);
+    free(buffer);
+
+    return errors;
+}
+
+static
+int
+tcp_sendfile_test_header(void)
+{
+    tcp_sendfile_test_block_t           blocks[TCP_SENDFILE_TEST_BLOCKS];
+    int                                 i;
+
+    for(i = 0; i < TCP_SENDFILE_TEST_BLOCKS; i++)
+    {
+        /* mostly small blocks, a big one now and then */
+        blocks[i].length = tcp_sendfile_test_random(4) == 0
+            ? 1 + tcp_sendfile_test_random(TCP_SENDFILE_TEST_MAX_BLOCK)
+            : 1 + tcp_sendfile_test_random(2000);
+        blocks[i].offset = tcp_sendfile_test_random(
+            tcp_sendfile_test_size - blocks[i].length);
+    }
+
+    return tcp_sendfile_test_transfer(
+        blocks, TCP_SENDFILE_TEST_BLOCKS, 16, GLOBUS_TRUE, NULL);
+}
+
+static
+int
+tcp_sendfile_test_file_only(void)
+{
+    tcp_sendfile_test_block_t           block;
+
+    block.offset = 0;
+    block.length = tcp_sendfile_test_size;
+
+    return tcp_sendfile_test_transfer(&block, 1, 0, GLOBUS_TRUE, NULL);
+}
+
+static
+int
+tcp_sendfile_test_short_file(void)
+{
+    tcp_sendfile_test_sender_t          sender;
+    tcp_sendfile_test_block_t           block;
+    globus_xio_handle_t                 reader;
+
+    block.offset = tcp_sendfile_test_size - 100;
+    block.length = 1000;
+
+    memset(&sender, 0, sizeof(sender));
+    sender.blocks = &block;
+    sender.block_count = 1;
+    sender.header_len = 16;
+    sender.use_sendfile = GLOBUS_TRUE;
+    if(tcp_sendfile_test_connect(&reader, &sender.handle) != GLOBUS_SUCCESS)
+    {
+        return 1;
+    }
+
+    globus_mutex_lock(&tcp_sendfile_test_lock);
+    {
+        tcp_sendfile_test_send_next(&sender);
+        while(!sender.done)
+        {
+            globus_cond_wait(&tcp_sendfile_test_cond, &tcp_sendfile_test_lock);
+        }
+    }
+    globus_mutex_unlock(&tcp_sendfile_test_lock);
+
+    globus_xio_close(sender.handle, NULL);
+    globus_xio_close(reader, NULL);
+
+    return sender.result == GLOBUS_SUCCESS;
+}
+
+static
+int
+tcp_sendfile_test_bench(void)
+{
+    tcp_sendfile_test_block_t *         blocks;
+    double                              elapsed[2];
+    int                                 count;
+    int                                 errors = 0;
+    int                                 i;
+
+    count = (tcp_sendfile_test_size + TCP_SENDFILE_TEST_BENCH_BLOCK - 1) /
+        TCP_SENDFILE_TEST_BENCH_BLOCK;
+    blocks = malloc(count * sizeof(tcp_sendfile_test_block_t));
+    if(!blocks)
+    {
+        return 1;
+    }
+    for(i = 0; i < count; i++)
+    {
+        blocks[i].offset = (globus_off_t) i * TCP_SENDFILE_TEST_BENCH_BLOCK;
+        blocks[i].length = TCP_SENDFILE_TEST_BENCH_BLOCK;
+        if(blocks[i].offset + blocks[i].length > tcp_sendfile_test_size)
+        {
+            blocks[i].length = tcp_sendfile_test_size - blocks[i].offset;
+        }
+    }
+
+    errors += tcp_sendfile_test_transfer(
+        blocks, count, 0, GLOBUS_TRUE, &elapsed[0]);
+    errors += tcp_sendfile_test_transfer(
+        blocks, count, 0, GLOBUS_FALSE, &elapsed[1]);
+    printf("# %lu bytes: sendfile %.1f MB/s, read and write %.1f MB/s\n",
+        (unsigned long) tcp_sendfile_test_size,
+        tcp_sendfile_test_size / elapsed[0] / (1024 * 1024),
+        tcp_sendfile_test_size / elapsed[1] / (1024 * 1024));
+    free(blocks);
+
+    return errors;
+}
+
+int
+main(
+    int                                 argc,
+    char *                              argv[])
+{
+    char                                filename[] = "tcp_sendfile_test.XXXXXX";
+    globus_size_t                       i;
+    int                                 test = 0;
+    int                                 rc = 0;
+
+    tcp_sendfile_test_size = TCP_SENDFILE_TEST_SIZE;
+    if(argc > 1)
+    {
+        tcp_sendfile_test_size = (globus_size_t) atoi(argv[1]) * 1024 * 1024;
+    }
+    printf("1..4\n");
+
+    tcp_sendfile_test_data = malloc(tcp_sendfile_test_size);
+    for(i = 0; tcp_sendfile_test_data && i < tcp_sendfile_test_size; i++)
+    {
+        tcp_sendfile_test_seed = tcp_sendfile_test_seed * 1103515245 + 12345;
+        tcp_sendfile_test_data[i] =
+            (globus_byte_t) (tcp_sendfile_test_seed >> 16);
+    }
+    tcp_sendfile_test_fd = mkstemp(filename);
+    if(!tcp_sendfile_test_data || tcp_sendfile_test_fd < 0 ||
+        write(tcp_sendfile_test_fd, tcp_sendfile_test_data,
+            tcp_sendfile_test_size) != tcp_sendfile_test_size)
+    {
+        printf("Bail out! can't create %s\n", filename);
+        return 99;
+    }
+
+    globus_thread_set_model("pthread");
+    if(globus_module_activate(GLOBUS_XIO_MODULE) != GLOBUS_SUCCESS)
+    {
+        printf("Bail out! can't activate xio\n");
+        remove(filename);
+        return 99;
+    }
+    globus_mutex_init(&tcp_sendfile_test_lock, NULL);
+    globus_cond_init(&tcp_sendfile_test_cond, NULL);
+    globus_xio_driver_load("tcp", &tcp_sendfile_test_driver);
+    globus_xio_stack_init(&tcp_sendfile_test_stack, NULL);
+    globus_xio_stack_push_driver(
+        tcp_sendfile_test_stack, tcp_sendfile_test_driver);
+
+#define tcp_sendfile_test_ok(failed, name)                                  \
+    do                                                                      \
+    {                                                                       \
+        int _failed = (failed) != 0;                                        \
+        printf("%s %d - %s\n", _failed ? "not ok" : "ok", ++test, name);    \
+        rc += _failed;                                                      \
+    } while(0)
+
+    tcp_sendfile_test_ok(tcp_sendfile_test_header(), "header_test");
+    tcp_sendfile_test_ok(tcp_sendfile_test_file_only(), "file_only_test");
+    tcp_sendfile_test_ok(tcp_sendfile_test_short_file(), "short_file_test");
+    tcp_sendfile_test_ok(tcp_sendfile_test_bench(), "bench");
+
+    globus_xio_stack_destroy(tcp_sendfile_test_stack);
+    globus_xio_driver_unload(tcp_sendfile_test_driver);
+    globus_mutex_destroy(&tcp_sendfile_test_lock);
+    globus_cond_destroy(&tcp_sendfile_test_cond);
+    globus_module_deactivate(GLOBUS_XIO_MODULE);
+
+    close(tcp_sendfile_test_fd);
+    remove(filename);
+    free(tcp_sendfile_test_data);
+
+    return rc;
+}
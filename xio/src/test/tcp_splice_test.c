@@ -0,0 +1,592 @@
+/*
+ * Copyright 1999-2014 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "globus_common.h"
+#include "globus_xio.h"
+#include "globus_xio_tcp_driver.h"
+#include <sys/time.h>
+
+/*
+ * This test program receives data over loopback tcp straight into a file
+ * with GLOBUS_XIO_TCP_SET_SPLICE and checks what ends up in the file:
+ *
+ * block test:
+ *     The file arrives as blocks in shuffled order, each behind a small
+ *     header naming its offset and length, the way mode E frames data.
+ *     Each block is spliced to its offset.
+ * stream test:
+ *     The file arrives unframed and is spliced in whatever pieces the
+ *     socket has until eof, the way stream mode reads.
+ * eof test:
+ *     The sender closes partway through a block and the read has to report
+ *     eof along with the bytes that did arrive.
+ *
+ * The time to receive the file in 256 KB blocks with splice and with reads
+ * and pwrites is then reported as a TAP comment; pass a size in MB to
+ * receive more.
+ */
+#define TCP_SPLICE_TEST_SIZE            (8 * 1024 * 1024 + 7)
+#define TCP_SPLICE_TEST_BLOCK           (256 * 1024)
+
+typedef struct
+{
+    globus_off_t                        offset;
+    globus_off_t                        length;
+} tcp_splice_test_block_t;
+
+static globus_mutex_t                   tcp_splice_test_lock;
+static globus_cond_t                    tcp_splice_test_cond;
+static globus_xio_driver_t              tcp_splice_test_driver;
+static globus_xio_stack_t               tcp_splice_test_stack;
+static globus_byte_t *                  tcp_splice_test_data;
+static globus_size_t                    tcp_splice_test_size;
+static int                              tcp_splice_test_fd = -1;
+static unsigned                         tcp_splice_test_seed = 42;
+static globus_bool_t                    tcp_splice_test_sent;
+static globus_result_t                  tcp_splice_test_send_result;
+
+static
+globus_size_t
+tcp_splice_test_random(
+    globus_size_t                       limit)
+{
+    tcp_splice_test_seed = tcp_splice_test_seed * 1103515245 + 12345;
+    return (tcp_splice_test_seed >> 8) % limit;
+}
+
+static
+void
+tcp_splice_test_encode(
+    globus_byte_t *                     buf,
+    globus_off_t                        value)
+{
+    int                                 i;
+
+    for(i = 7; i >= 0; i--)
+    {
+        buf[i] = (globus_byte_t) value;
+        value >>= 8;
+    }
+}
+
+static
+globus_off_t
+tcp_splice_test_decode(
+    const globus_byte_t *               buf)
+{
+    globus_off_t                        value = 0;
+    int                                 i;
+
+    for(i = 0; i < 8; i++)
+    {
+        value = (value << 8) | buf[i];
+    }
+
+    return value;
+}
+
+static
+void
+tcp_splice_test_close_cb(
+    globus_xio_handle_t                 handle,
+    globus_result_t                     result,
+    void *                              user_arg)
+{
+    globus_mutex_lock(&tcp_splice_test_lock);
+    {
+        tcp_splice_test_sent = GLOBUS_TRUE;
+        globus_cond_signal(&tcp_splice_test_cond);
+    }
+    globus_mutex_unlock(&tcp_splice_test_lock);
+}
+
+/* the reader sees eof once everything has been written */
+static
+void
+tcp_splice_test_write_cb(
+    globus_xio_handle_t                 handle,
+    globus_result_t                     result,
+    globus_byte_t *                     buffer,
+    globus_size_t                       len,
+    globus_size_t                       nbytes,
+    globus_xio_data_descriptor_t        data_desc,
+    void *                              user_arg)
+{
+    tcp_splice_test_send_result = result;
+    if(globus_xio_register_close(
+        handle, NULL, tcp_splice_test_close_cb, NULL) != GLOBUS_SUCCESS)
+    {
+        tcp_splice_test_close_cb(handle, GLOBUS_FAILURE, NULL);
+    }
+}
+
+/*
+ * connects a pair of handles and starts writing len bytes of buf on the
+ * writer, which is closed once that is done.  the caller waits for it with
+ * tcp_splice_test_finish()
+ */
+static
+globus_result_t
+tcp_splice_test_start(
+    globus_xio_handle_t *               reader,
+    globus_xio_handle_t *               writer,
+    globus_byte_t *                     buf,
+    globus_size_t                       len)
+{
+    globus_xio_server_t                 server;
+    globus_result_t                     result;
+    char *                              contact;
+
+    tcp_splice_test_sent = GLOBUS_FALSE;
+    tcp_splice_test_send_result = GLOBUS_SUCCESS;
+
+    result = globus_xio_server_create(&server, NULL, tcp_splice_test_stack);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error_server;
+    }
+    globus_xio_server_get_contact_string(server, &contact);
+
+    result = globus_xio_handle_create(writer, tcp_splice_test_stack);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error_handle;
+    }
+    result = globus_xio_open(*writer, contact, NULL);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error_open;
+    }
+    result = globus_xio_server_accept(reader, server);
+    if(result == GLOBUS_SUCCESS)
+    {
+        result = globus_xio_open(*reader, NULL, NULL);
+    }
+    if(result == GLOBUS_SUCCESS)
+    {
+        result = globus_xio_register_write(
+            *writer, buf, len, len, NULL, tcp_splice_test_write_cb, NULL);
+        if(result != GLOBUS_SUCCESS)
+        {
+            globus_xio_close(*reader, NULL);
+        }
+    }
+    if(result != GLOBUS_SUCCESS)
+    {
+        globus_xio_close(*writer, NULL);
+    }
+
+error_open:
+error_handle:
+    globus_free(contact);
+    globus_xio_server_close(server);
+error_server:
+    return result;
+}
+
+static
+int
+tcp_splice_test_finish(
+    globus_xio_handle_t                 reader)
+{
+    globus_mutex_lock(&tcp_splice_test_lock);
+    {
+        while(!tcp_splice_test_sent)
+        {
+            globus_cond_wait(&tcp_splice_test_cond, &tcp_splice_test_lock);
+        }
+    }
+    globus_mutex_unlock(&tcp_splice_test_lock);
+
+    globus_xio_close(reader, NULL);
+
+    return tcp_splice_test_send_result != GLOBUS_SUCCESS;
+}
+
+/* read up to length bytes from the socket into the file at offset */
+static
+globus_result_t
+tcp_splice_test_read(
+    globus_xio_handle_t                 reader,
+    globus_off_t                        offset,
+    globus_off_t                        length,
+    globus_size_t                       waitforbytes,
+    globus_size_t *                     nbytes)
+{
+    globus_xio_data_descriptor_t        dd;
+    globus_byte_t                       unused;
+    globus_result_t                     result;
+
+    result = globus_xio_data_descriptor_init(&dd, reader);
+    if(result != GLOBUS_SUCCESS)
+    {
+        return result;
+    }
+    result = globus_xio_data_descriptor_cntl(
+        dd,
+        tcp_splice_test_driver,
+        GLOBUS_XIO_TCP_SET_SPLICE,
+        tcp_splice_test_fd,
+        offset,
+        length);
+    if(result == GLOBUS_SUCCESS)
+    {
+        result = globus_xio_read(
+            reader, &unused, 1, waitforbytes, nbytes, dd);
+    }
+    globus_xio_data_descriptor_destroy(dd);
+
+    return result;
+}
+
+/* compare the first length bytes of the file with the data sent */
+static
+int
+tcp_splice_test_check(
+    globus_size_t                       length)
+{
+    globus_byte_t *                     buffer;
+    int                                 errors;
+
+    buffer = malloc(length + 1);
+    if(!buffer)
+    {
+        return 1;
+    }
+    errors = pread(tcp_splice_test_fd, buffer, length + 1, 0) != length ||
+        memcmp(buffer, tcp_splice_test_data, length) != 0;
+    free(buffer);
+
+    return errors;
+}
+
+/*
+ * frames blocks of the file, in the order given, behind 16 byte headers,
+ * sends them and splices each into place.  returns 0 on success, and the
+ * time the reader took in *elapsed if it is not NULL
+ */
+static
+int
+tcp_splice_test_blocks(
+    tcp_splice_test_block_t *           blocks,
+    int                                 block_count,
+    globus_bool_t                       use_splice,
+    double *                            elapsed)
+{
+    globus_xio_handle_t                 reader;
+    globus_xio_handle_t                 writer;
+    globus_byte_t *                     stream;
+    globus_byte_t *                     buffer = NULL;
+    globus_byte_t *                     p;
+    globus_byte_t                       header[16];
+    globus_off_t                        offset;
+    globus_off_t                        length;
+    globus_size_t                       nbytes;
+    globus_result_t                     result;
+    struct timeval                      start;
+    struct timeval                      end;
+    int                                 errors = 0;
+    int                                 i;
+
+    if(ftruncate(tcp_splice_test_fd, 0) != 0)
+    {
+        return 1;
+    }
+
+    stream = malloc(tcp_splice_test_size + 16 * block_count);
+    if(!use_splice)
+    {
+        buffer = malloc(TCP_SPLICE_TEST_BLOCK);
+    }
+    if(!stream || (!use_splice && !buffer))
+    {
+        free(stream);
+        free(buffer);
+        return 1;
+    }
+    for(p = stream, i = 0; i < block_count; i++)
+    {
+        tcp_splice_test_encode(p, blocks[i].offset);
+        tcp_splice_test_encode(p + 8, blocks[i].length);
+        memcpy(p + 16,
+            tcp_splice_test_data + blocks[i].offset, blocks[i].length);
+        p += 16 + blocks[i].length;
+    }
+
+    if(tcp_splice_test_start(
+        &reader, &writer, stream, p - stream) != GLOBUS_SUCCESS)
+    {
+        free(stream);
+        free(buffer);
+        return 1;
+    }
+
+    gettimeofday(&start, NULL);
+    for(i = 0; i < block_count && !errors; i++)
+    {
+        result = globus_xio_read(reader, header, 16, 16, &nbytes, NULL);
+        if(result != GLOBUS_SUCCESS)
+        {
+            errors++;
+            break;
+        }
+        offset = tcp_splice_test_decode(header);
+        length = tcp_splice_test_decode(header + 8);
+
+        if(use_splice)
+        {
+            result = tcp_splice_test_read(
+                reader, offset, length, length, &nbytes);
+            errors += result != GLOBUS_SUCCESS || nbytes != length;
+        }
+        else
+        {
+            /* what a buffered receiver does: read the block, then write it */
+            result = globus_xio_read(
+                reader, buffer, length, length, &nbytes, NULL);
+            errors += result != GLOBUS_SUCCESS ||
+                pwrite(tcp_splice_test_fd, buffer, length, offset) != length;
+        }
+    }
+    gettimeofday(&end, NULL);
+    if(elapsed)
+    {
+        *elapsed = (end.tv_sec - start.tv_sec) +
+            (end.tv_usec - start.tv_usec) / 1000000.0;
+    }
+
+    errors += tcp_splice_test_finish(reader);
+    errors += tcp_splice_test_check(tcp_splice_test_size);
+    free(stream);
+    free(buffer);
+
+    return errors;
+}
+
+static
+int
+tcp_splice_test_block(void)
+{
+    tcp_splice_test_block_t *           blocks;
+    tcp_splice_test_block_t             tmp;
+    globus_off_t                        offset;
+    int                                 count = 0;
+    int                                 errors;
+    int                                 i;
+    int                                 j;
+
+    /* cover the file with blocks of random size, then shuffle them */
+    blocks = malloc(
+        (tcp_splice_test_size / 100 + 1) * sizeof(tcp_splice_test_block_t));
+    if(!blocks)
+    {
+        return 1;
+    }
+    for(offset = 0; offset < tcp_splice_test_size; count++)
+    {
+        blocks[count].offset = offset;
+        blocks[count].length = tcp_splice_test_random(4) == 0
+            ? 100 + tcp_splice_test_random(2 * TCP_SPLICE_TEST_BLOCK)
+            : 100 + tcp_splice_test_random(2000);
+        if(offset + blocks[count].length > tcp_splice_test_size)
+        {
+            blocks[count].length = tcp_splice_test_size - offset;
+        }
+        offset += blocks[count].length;
+    }
+    for(i = count - 1; i > 0; i--)
+    {
+        j = tcp_splice_test_random(i + 1);
+        tmp = blocks[i];
+        blocks[i] = blocks[j];
+        blocks[j] = tmp;
+    }
+
+    errors = tcp_splice_test_blocks(blocks, count, GLOBUS_TRUE, NULL);
+    free(blocks);
+
+    return errors;
+}
+
+static
+int
+tcp_splice_test_stream(void)
+{
+    globus_xio_handle_t                 reader;
+    globus_xio_handle_t                 writer;
+    globus_off_t                        offset = 0;
+    globus_size_t                       nbytes;
+    globus_result_t                     result;
+    int                                 errors = 0;
+
+    if(ftruncate(tcp_splice_test_fd, 0) != 0 ||
+        tcp_splice_test_start(
+            &reader,
+            &writer,
+            tcp_splice_test_data,
+            tcp_splice_test_size) != GLOBUS_SUCCESS)
+    {
+        return 1;
+    }
+
+    do
+    {
+        result = tcp_splice_test_read(
+            reader, offset, TCP_SPLICE_TEST_BLOCK, 1, &nbytes);
+        offset += nbytes;
+    } while(result == GLOBUS_SUCCESS);
+
+    errors += !globus_xio_error_is_eof(result);
+    errors += offset != tcp_splice_test_size;
+    errors += tcp_splice_test_finish(reader);
+    errors += tcp_splice_test_check(tcp_splice_test_size);
+
+    return errors;
+}
+
+static
+int
+tcp_splice_test_eof(void)
+{
+    globus_xio_handle_t                 reader;
+    globus_xio_handle_t                 writer;
+    globus_size_t                       nbytes;
+    globus_result_t                     result;
+    int                                 errors = 0;
+
+    if(ftruncate(tcp_splice_test_fd, 0) != 0 ||
+        tcp_splice_test_start(
+            &reader, &writer, tcp_splice_test_data, 100) != GLOBUS_SUCCESS)
+    {
+        return 1;
+    }
+
+    result = tcp_splice_test_read(reader, 0, 1000, 1000, &nbytes);
+    errors += !globus_xio_error_is_eof(result);
+    errors += nbytes != 100;
+    errors += tcp_splice_test_finish(reader);
+    errors += tcp_splice_test_check(100);
+
+    return errors;
+}
+
+static
+int
+tcp_splice_test_bench(void)
+{
+    tcp_splice_test_block_t *           blocks;
+    double                              elapsed[2];
+    int                                 count;
+    int                                 errors = 0;
+    int                                 i;
+
+    count = (tcp_splice_test_size + TCP_SPLICE_TEST_BLOCK - 1) /
+        TCP_SPLICE_TEST_BLOCK;
+    blocks = malloc(count * sizeof(tcp_splice_test_block_t));
+    if(!blocks)
+    {
+        return 1;
+    }
+    for(i = 0; i < count; i++)
+    {
+        blocks[i].offset = (globus_off_t) i * TCP_SPLICE_TEST_BLOCK;
+        blocks[i].length = TCP_SPLICE_TEST_BLOCK;
+        if(blocks[i].offset + blocks[i].length > tcp_splice_test_size)
+        {
+            blocks[i].length = tcp_splice_test_size - blocks[i].offset;
+        }
+    }
+
+    errors += tcp_splice_test_blocks(blocks, count, GLOBUS_TRUE, &elapsed[0]);
+    errors += tcp_splice_test_blocks(blocks, count, GLOBUS_FALSE, &elapsed[1]);
+    printf("# %lu bytes: splice %.1f MB/s, read and pwrite %.1f MB/s\n",
+        (unsigned long) tcp_splice_test_size,
+        tcp_splice_test_size / elapsed[0] / (1024 * 1024),
+        tcp_splice_test_size / elapsed[1] / (1024 * 1024));
+    free(blocks);
+
+    return errors;
+}
+
+int
+main(
+    int                                 argc,
+    char *                              argv[])
+{
+    char                                filename[] = "tcp_splice_test.XXXXXX";
+    globus_size_t                       i;
+    int                                 test = 0;
+    int                                 rc = 0;
+
+    tcp_splice_test_size = TCP_SPLICE_TEST_SIZE;
+    if(argc > 1)
+    {
+        tcp_splice_test_size = (globus_size_t) atoi(argv[1]) * 1024 * 1024;
+    }
+    printf("1..4\n");
+
+    tcp_splice_test_data = malloc(tcp_splice_test_size);
+    for(i = 0; tcp_splice_test_data && i < tcp_splice_test_size; i++)
+    {
+        tcp_splice_test_seed = tcp_splice_test_seed * 1103515245 + 12345;
+        tcp_splice_test_data[i] = (globus_byte_t) (tcp_splice_test_seed >> 16);
+    }
+    tcp_splice_test_fd = mkstemp(filename);
+    if(!tcp_splice_test_data || tcp_splice_test_fd < 0)
+    {
+        printf("Bail out! can't create %s\n", filename);
+        return 99;
+    }
+
+    globus_thread_set_model("pthread");
+    if(globus_module_activate(GLOBUS_XIO_MODULE) != GLOBUS_SUCCESS)
+    {
+        printf("Bail out! can't activate xio\n");
+        remove(filename);
+        return 99;
+    }
+    globus_mutex_init(&tcp_splice_test_lock, NULL);
+    globus_cond_init(&tcp_splice_test_cond, NULL);
+    globus_xio_driver_load("tcp", &tcp_splice_test_driver);
+    globus_xio_stack_init(&tcp_splice_test_stack, NULL);
+    globus_xio_stack_push_driver(
+        tcp_splice_test_stack, tcp_splice_test_driver);
+
+#define tcp_splice_test_ok(failed, name)                                    \
+    do                                                                      \
+    {                                                                       \
+        int _failed = (failed) != 0;                                        \
+        printf("%s %d - %s\n", _failed ? "not ok" : "ok", ++test, name);    \
+        rc += _failed;                                                      \
+    } while(0)
+
+    tcp_splice_test_ok(tcp_splice_test_block(), "block_test");
+    tcp_splice_test_ok(tcp_splice_test_stream(), "stream_test");
+    tcp_splice_test_ok(tcp_splice_test_eof(), "eof_test");
+    tcp_splice_test_ok(tcp_splice_test_bench(), "bench");
+
+    globus_xio_stack_destroy(tcp_splice_test_stack);
+    globus_xio_driver_unload(tcp_splice_test_driver);
+    globus_mutex_destroy(&tcp_splice_test_lock);
+    globus_cond_destroy(&tcp_splice_test_cond);
+    globus_module_deactivate(GLOBUS_XIO_MODULE);
+
+    close(tcp_splice_test_fd);
+    remove(filename);
+    free(tcp_splice_test_data);
+
+    return rc;
+}